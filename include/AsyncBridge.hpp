@@ -34,6 +34,9 @@ uv_loop_t* scheduler_get_loop();
 // may run the function inline as a fallback.
 void scheduler_run_on_loop(const std::function<void()>& fn);
 
+// Schedule a function as a microtask on the scheduler loop thread (runs inline without a scheduler).
+void scheduler_enqueue_microtask(const std::function<void()>& fn);
+
 // Optional: register a tick callback invoked on the scheduler loop thread (implemented in Scheduler.cpp).
 void register_tick_callback(const std::function<void()>& cb);
 
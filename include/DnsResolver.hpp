@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "uv.h"
+
+// Name resolution shared by net.resolve, tcp connect, udp bind and the http
+// clients (DnsResolver.cpp).
+//
+// Answers are cached per (host, family) for `ttl_ms`, since getaddrinfo does
+// not report record TTLs, and "no such name" answers for `negative_ttl_ms`.
+// Concurrent lookups of one name on a loop share a single getaddrinfo, so a
+// burst of connects to one host costs one threadpool job instead of one each.
+//
+// A hosts file, when configured, answers before getaddrinfo is asked; with
+// `hosts_only` it is the only source and nothing leaves the machine, which
+// keeps tests offline.
+
+struct DnsOptions {
+    uint64_t ttl_ms = 30000;
+    uint64_t negative_ttl_ms = 5000;
+    size_t max_entries = 1024;
+    bool hosts_only = false;
+    std::string hosts_file;  // empty: none, or /etc/hosts with hosts_only
+};
+
+struct DnsStats {
+    uint64_t lookups = 0;    // getaddrinfo calls started
+    uint64_t hits = 0;       // answered from the cache or hosts file
+    uint64_t coalesced = 0;  // joined a lookup already in flight
+    size_t entries = 0;
+};
+
+// status is 0 or a libuv error (UV_EAI_NONAME, ...); addrs is empty on error.
+using DnsCallback = std::function<void(int status, const std::vector<sockaddr_storage>& addrs)>;
+
+// Resolve `host` on `loop`'s thread.  `family` is AF_UNSPEC, AF_INET or
+// AF_INET6.  IP literals, hosts-file names and cache hits call back before
+// dns_resolve returns; each cache hit rotates the order of a multi-address
+// answer.  Ports in the answer are 0.
+void dns_resolve(uv_loop_t* loop, const std::string& host, int family, DnsCallback cb);
+
+// For threads without a loop (fetch's curl workers): the cached or hosts-file
+// answer, never a lookup.  dns_remember caches an address resolved elsewhere.
+bool dns_lookup_cached(const std::string& host, int family, std::vector<sockaddr_storage>& out);
+void dns_remember(const std::string& host, const sockaddr_storage& addr);
+
+// dns_configure re-reads the hosts file; false (and nothing changed) when it
+// cannot be read.  Clearing drops cached answers but keeps the hosts file.
+bool dns_configure(const DnsOptions& options);
+DnsOptions dns_options();
+DnsStats dns_stats();
+void dns_clear();
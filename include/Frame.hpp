@@ -49,6 +49,7 @@ struct CallFrame {
         size_t iteration_count = 0;  // Track which iteration we're on
         size_t body_statement_index = 0;
         Value current_value;          // For for-in loops (current element/key)
+        Value iterable;               // For for-in loops (evaluated once, kept across resumes)
         size_t current_index = 0;     // For for-in loops (position in array/object)
         bool is_first_entry = false;  // Track if this is first time entering loop
 
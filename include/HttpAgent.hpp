@@ -0,0 +1,14 @@
+#pragma once
+
+#include "uv.h"
+
+// Keep-alive agent of the http client (http/http_client_modern.cc).
+//
+// Connections are pooled per scheme://host:port on the loop thread, TLS
+// sessions are resumed from the last handshake with the same origin and
+// name lookups are cached.  Idle connections are unref'd, so they never keep
+// a script alive.
+
+// Close every pooled connection of `loop` and free the cached TLS sessions.
+// Called by the Scheduler before it drains and closes its loop.
+void http_agent_shutdown(uv_loop_t* loop);
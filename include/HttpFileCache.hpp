@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "uv.h"
+
+// Open-file cache behind res.sendFile(path) and http.static (http/http_static.cc).
+//
+// One cache per loop thread.  An entry holds an open descriptor, the stat
+// data and the validators derived from it; files up to HTTP_FILE_INLINE_LIMIT
+// are read once and served from memory instead.  Each entry is watched with
+// a uv_fs_event (unref'd, so it never keeps the loop alive) and dropped as
+// soon as the file changes.  Responses hold the entry while they send it, so
+// an invalidated descriptor stays valid until the last of them is done.
+
+static constexpr uint64_t HTTP_FILE_INLINE_LIMIT = 64 * 1024;
+
+struct HttpFileEntry {
+    std::string path;
+    int fd = -1;  // -1 when `data` holds the whole file
+    uint64_t size = 0;
+    int64_t mtime = 0;  // seconds since the epoch
+    std::string etag;
+    std::string last_modified;
+    const char* content_type = "application/octet-stream";
+    std::shared_ptr<const std::string> data;
+
+    ~HttpFileEntry();
+};
+
+using HttpFilePtr = std::shared_ptr<const HttpFileEntry>;
+
+// The cached entry for `path`, opening it on a miss.  Returns null with a
+// negative uv error code in `err` when the path is missing, unreadable or not
+// a regular file (UV_EISDIR for a directory).
+HttpFilePtr http_file_cache_open(const std::string& path, int* err);
+
+// Drop every entry and close the watchers of `loop`.  Called by the
+// Scheduler before it drains and closes its loop.
+void http_file_cache_shutdown(uv_loop_t* loop);
+
+// Content-Type for a file name, by extension.
+const char* http_mime_type(std::string_view path);
+
+// IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") and back.  The parser also
+// takes the obsolete RFC 850 and asctime forms; it returns false otherwise.
+std::string http_format_date(int64_t epoch_sec);
+bool http_parse_date(std::string_view text, int64_t* epoch_sec);
+
+// Whether an If-None-Match value (a list of tags or "*") matches `etag`,
+// using weak comparison.
+bool http_etag_matches(std::string_view if_none_match, std::string_view etag);
+
+// Parse a Range header against a representation of `size` bytes.  Returns 1
+// with [*first, *last] for one satisfiable range, 0 to ignore the header
+// (malformed, not bytes, or several ranges) and -1 when it is unsatisfiable.
+int http_parse_range(std::string_view range, uint64_t size, uint64_t* first, uint64_t* last);
@@ -0,0 +1,59 @@
+/**
+ * http.Router — routes compiled into a radix tree (http/http_router.cc).
+ *
+ * Shared with http_server.cc so a server created with createServer(router)
+ * can match the parsed method and path directly, before any script runs.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "evaluator.hpp"
+
+class HttpRouter {
+   public:
+    enum class Result { Handled,
+        NotFound,
+        MethodNotAllowed };
+
+    struct Node;  // radix tree node, defined in http_router.cc
+
+    HttpRouter();
+    ~HttpRouter();
+
+    // Add handlers for `method` ("GET", ... or "*" for any) on `pattern`.
+    // Patterns are literal text plus ":name" segments (up to the next '/') and
+    // an optional trailing "*" or "*name" that takes the rest of the path.
+    // Throws std::invalid_argument for a malformed or conflicting pattern.
+    void add(const std::string& method, const std::string& pattern, std::vector<FunctionPtr> handlers);
+
+    // Middleware run before the handlers of every matched route under `prefix`
+    // (whole segments; "/" is everything), in the order they were added.
+    void use(const std::string& prefix, std::vector<FunctionPtr> fns);
+
+    // Match and run the chain for one request.  req.params is set to the
+    // captured parameters; each chain function is called as fn(req, res, next)
+    // and the last as fn(req, res).  Nothing is called unless a route matches.
+    // On MethodNotAllowed `allow` holds the methods the path does accept.
+    Result dispatch(std::string_view method, std::string_view path, const ObjectPtr& req,
+        const ObjectPtr& res, Evaluator* evaluator, EnvPtr env, std::string* allow = nullptr);
+
+    size_t route_count() const { return routes_; }
+
+   private:
+    struct Middleware {
+        std::string prefix;
+        FunctionPtr fn;
+    };
+
+    std::unique_ptr<Node> root_;
+    std::vector<Middleware> middleware_;
+    size_t routes_ = 0;
+};
+
+// The router behind a value created by http.Router(), or null.
+std::shared_ptr<HttpRouter> http_router_from_value(const Value& v);
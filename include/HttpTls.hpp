@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Server-side TLS for http.createServer (http/http_tls.cc).
+//
+// OpenSSL runs over a pair of memory BIOs.  Ciphertext read from the socket is
+// pushed in with read(); whatever OpenSSL has to send (handshake records,
+// session tickets, encrypted responses, alerts) is appended to an output
+// string that the connection hands to its ordinary libuv writes.  Nothing here
+// touches the socket, so a handshake advances one read callback at a time and
+// never blocks the loop.
+
+struct HttpTlsOptions {
+    std::string cert;        // PEM text, or the path of a PEM file; may hold the chain
+    std::string key;         // PEM text, or a path
+    std::string passphrase;  // for an encrypted key
+    uint32_t session_timeout_s = 300;
+    bool tickets = true;  // stateless resumption; the server-side session cache is always on
+};
+
+class HttpTlsContext;
+using HttpTlsContextPtr = std::shared_ptr<HttpTlsContext>;
+
+// One per server, immutable once built.  Cluster workers share it, and with it
+// the ticket keys and the session cache, so a client resumes on any worker.
+// Throws std::runtime_error with the OpenSSL reason when the certificate or
+// key cannot be used (or when built without OpenSSL).
+HttpTlsContextPtr http_tls_context_create(const HttpTlsOptions& opts);
+
+struct HttpTlsStats {
+    uint64_t handshakes = 0;  // completed, including resumptions
+    uint64_t resumed = 0;
+    uint64_t failed = 0;
+};
+HttpTlsStats http_tls_stats(const HttpTlsContextPtr& ctx);
+
+class HttpTlsSession {
+   public:
+    explicit HttpTlsSession(const HttpTlsContextPtr& ctx);
+    ~HttpTlsSession();
+    HttpTlsSession(const HttpTlsSession&) = delete;
+    HttpTlsSession& operator=(const HttpTlsSession&) = delete;
+
+    // Ciphertext from the peer.  Decrypted bytes are appended to `plain` and
+    // bytes to send back to `out`.  Returns false when the connection has to
+    // be dropped (failed handshake, bad record); `out` may then hold an alert.
+    bool read(const char* data, size_t len, std::string& plain, std::string& out);
+
+    // Encrypts `len` bytes into `out`.  False once the session is unusable.
+    bool write(const char* data, size_t len, std::string& out);
+
+    // Appends close_notify to `out`.
+    void shutdown(std::string& out);
+
+    bool established() const;
+    bool peer_closed() const;  // close_notify received
+    bool resumed() const;
+    std::string alpn() const;      // "" when the client did not ask
+    std::string protocol() const;  // "TLSv1.3"
+    std::string cipher() const;
+    const std::string& error() const;
+
+   private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
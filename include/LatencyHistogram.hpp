@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Latency histogram for http.bench (http/latency_histogram.cc).
+//
+// Log-linear buckets over microseconds: values below 64us are kept exactly,
+// above that every power-of-two range is split into 64 equal sub-buckets, so
+// a reported percentile is within ~1.6% of the true sample.  Recording is an
+// increment, and the memory is fixed (~30 KB) however many samples arrive,
+// which keeps the load generator cheap next to the server it is measuring.
+
+class LatencyHistogram {
+   public:
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+    // Smallest recorded value v such that a fraction `q` (0..1) of the samples
+    // is <= v, reported as the upper edge of its bucket and never above max().
+    uint64_t percentile(double q) const;
+
+    struct Bucket {
+        uint64_t upto;  // inclusive upper edge, in microseconds
+        uint64_t count;
+    };
+    // Non-empty buckets in ascending order.
+    std::vector<Bucket> buckets() const;
+
+   private:
+    static size_t index_of(uint64_t micros);
+    static uint64_t upper_edge(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
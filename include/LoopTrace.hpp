@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Event-loop instrumentation (LoopTrace.cpp).
+//
+// Stats are always on and cheap: the Scheduler records queue wait and run
+// time of every macrotask into the calling thread's LoopStats, and a sampling
+// timer (started by uv.loopStats()) records how late the loop wakes up.
+//
+// Tracing is opt-in (uv.trace.start() or SWAZI_TRACE=<file.json>): every task
+// additionally becomes a Chrome trace-event with its creation site, viewable in
+// chrome://tracing or Perfetto.
+
+// log2 histogram over microseconds: bucket i holds values in [2^(i-1), 2^i).
+struct LoopHistogram {
+    static constexpr int BUCKETS = 32;
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sum_us = 0;
+    uint64_t max_us = 0;
+
+    void record(uint64_t us);
+    // Upper bound (µs) of the bucket holding the p-th percentile, p in [0, 1].
+    uint64_t percentile(double p) const;
+    double mean() const { return total ? static_cast<double>(sum_us) / total : 0.0; }
+};
+
+struct LoopStats {
+    uint64_t tasks[4] = {};  // per TaskPriority lane
+    uint64_t microtasks = 0;
+    LoopHistogram wait;  // macrotask enqueue -> start
+    LoopHistogram run;   // macrotask run time
+    LoopHistogram lag;   // lag-sampler lateness
+};
+
+// Stats for the calling thread's scheduler.
+LoopStats& loop_stats();
+void loop_stats_reset();
+
+// Tracing (process-wide buffer; events carry their thread id).
+bool loop_trace_enabled();
+void loop_trace_start();
+void loop_trace_stop();
+std::string loop_trace_json();
+bool loop_trace_write(const std::string& path);
+
+// Record one completed task.  `site` is the creation site when known.
+void loop_trace_task(const char* name, const std::string& site, uint64_t start_ns, uint64_t dur_ns, uint64_t wait_ns);
+// Record a lag sample as a trace counter.
+void loop_trace_lag(uint64_t at_ns, uint64_t lag_us);
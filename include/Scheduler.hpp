@@ -3,17 +3,39 @@
 #ifndef SWAZI_SCHEDULER_HPP
 #define SWAZI_SCHEDULER_HPP
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <mutex>
+#include <string>
 
 #include "Frame.hpp"
 
 // libuv (use local header path)
 #include "uv.h"
 
+// Macrotask priority lanes, highest first.  run_one always takes from the
+// highest non-empty lane, except that a lane passed over SCHEDULER_AGING_LIMIT
+// times in a row gets one turn so nothing starves outright.
+//   IO         — completions from sockets, fs, workers, addons (the default),
+//                and event emits, so both keep the order they were queued in
+//   Timer      — setTimeout / setInterval / nap firings
+//   User       — scheduler.postTask, timers.queueMacrotask
+//   Background — scheduler.postTask(fn, { priority: "background" })
+enum class TaskPriority : uint8_t { IO = 0,
+    Timer,
+    User,
+    Background };
+constexpr size_t SCHEDULER_LANES = 4;
+constexpr int SCHEDULER_AGING_LIMIT = 64;
+
+// Default per-slice budget: once macrotasks have run this long back to back
+// the loop polls libuv (non-blocking) before taking the next one.
+constexpr double SCHEDULER_DEFAULT_BUDGET_MS = 10.0;
+
 // Simple scheduler that holds microtask and macrotask queues.
 // This Scheduler implementation now uses libuv under the hood.
 class Scheduler {
@@ -22,11 +44,24 @@ class Scheduler {
     ~Scheduler();
 
     void enqueue_microtask(const Continuation& task);
-    void enqueue_macrotask(const Continuation& task);
+    void enqueue_macrotask(const Continuation& task, TaskPriority lane = TaskPriority::IO);
 
     // Run one "tick": drain microtasks then run one macrotask if available.
     bool run_one();
 
+    // Slice budget in milliseconds; 0 disables slicing (drain queues before polling I/O).
+    void set_budget_ms(double ms);
+    double budget_ms() const { return budget_ns_.load() / 1e6; }
+
+    // Ask run_until_idle to poll libuv before the next macrotask (scheduler.yield()).
+    void request_poll() { poll_requested_.store(true); }
+
+    size_t pending_macrotasks(TaskPriority lane);
+
+    // Start the lag sampler (uv.loopStats): an unref'd repeating timer whose
+    // lateness is recorded into loop_stats().lag.  Idempotent.
+    void start_lag_monitor(uint64_t interval_ms);
+
     // Run until idle. If has_pending is non-null it will be consulted to know whether
     // external work sources (timers) still exist. The scheduler returns when:
     //   - no macrotasks are available AND (has_pending == nullptr || has_pending() == false)
@@ -44,8 +79,26 @@ class Scheduler {
     uv_loop_t* get_uv_loop() { return loop_; }
 
    private:
-    std::deque<Continuation> microtasks;
-    std::deque<Continuation> macrotasks;
+    // A queued task plus what LoopTrace needs: when it was queued and, while
+    // tracing, where it came from.
+    struct QueuedTask {
+        Continuation fn;
+        uint64_t enqueued_ns = 0;
+        std::string site;
+    };
+
+    // Pops the next macrotask by lane priority (with aging).  Caller holds macrotasks_mutex.
+    bool take_next_macrotask(QueuedTask& out, size_t& lane);
+
+    friend void enqueue_callback_global_on(void* boxed_payload, TaskPriority lane);
+    void enqueue_macrotask_at(Continuation task, TaskPriority lane, std::string site);
+
+    std::deque<QueuedTask> microtasks;
+    std::array<std::deque<QueuedTask>, SCHEDULER_LANES> macrotasks;
+    std::array<int, SCHEDULER_LANES> lane_skips_{};
+
+    std::atomic<uint64_t> budget_ns_{static_cast<uint64_t>(SCHEDULER_DEFAULT_BUDGET_MS * 1e6)};
+    std::atomic<bool> poll_requested_{false};
 
     // protect both queues (microtasks need protection too)
     std::mutex macrotasks_mutex;
@@ -57,11 +110,18 @@ class Scheduler {
     bool async_initialized = false;
 
     std::atomic<bool> should_stop{false};
+
+    uv_timer_t lag_timer_;
+    bool lag_timer_started_ = false;
+    uint64_t lag_interval_ns_ = 0;
+    uint64_t lag_last_ns_ = 0;
+    static void lag_timer_cb(uv_timer_t* handle);
 };
 
 // Bridge functions (type-erased) — unchanged.
 void register_scheduler_runner(Scheduler* s, std::function<void(void*)> runner);
-void enqueue_callback_global(void* boxed_payload);
+void enqueue_callback_global(void* boxed_payload);  // IO lane
+void enqueue_callback_global_on(void* boxed_payload, TaskPriority lane);
 
 // Helper to let other translation units access the global scheduler loop (returns nullptr if none)
 uv_loop_t* scheduler_get_loop();
@@ -75,6 +135,14 @@ void scheduler_run_on_loop(const std::function<void()>& fn);
 // The callback is invoked on the scheduler's loop thread.
 void register_tick_callback(const std::function<void()>& cb);
 
+// Enqueue a macrotask on a specific lane of the current thread's scheduler
+// (runs inline without a scheduler, like scheduler_run_on_loop).
+void scheduler_post_task(const std::function<void()>& fn, TaskPriority lane);
+
+// Current thread's scheduler: start the lag sampler / count queued macrotasks.
+void scheduler_start_lag_monitor(uint64_t interval_ms);
+size_t scheduler_pending_macrotasks(TaskPriority lane);
+
 void cleanup_uv_handles();
 void clear_uv_handles();
 
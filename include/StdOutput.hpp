@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "uv.h"
+
+// Buffered stdout / stderr shared by chapisha, print() and process.stdout /
+// process.stderr (StdOutput.cpp), so all of them come out in the order they
+// were written.
+//
+// Writes collect in a per-fd queue that leaves in one writev:
+//   full  when 64 KiB are waiting, at the end of the loop tick, and at exit
+//   line  as full, and also whenever a newline is written
+//   none  straight away, one write per call
+// "auto" is line for a terminal and full otherwise on stdout, none on stderr.
+// Small writes are joined into one block; large ones are queued as their own
+// iovec rather than copied.
+//
+// A pipe or socket fd is written by a thread of its own with blocking
+// writes, so a slow reader never stalls a loop and the fd's flags, which a
+// child process inherits, are left as they were.  Terminals and files are
+// written directly.
+
+enum class StdBuffering { Auto, None, Line, Full };
+
+// `fd` is 1 or 2; anything else is written through unbuffered.
+void std_output_write(int fd, const char* data, size_t len);
+void std_output_write(int fd, std::string&& data);
+
+// Write out everything `fd` holds (-1: both), blocking until the kernel has
+// taken it.  Only for the process exiting, forking or waiting for input.
+void std_output_flush(int fd = -1);
+
+// Start writing what `fd` holds without blocking.  `done` runs on this
+// thread's loop once it has all reached the kernel (from other threads than
+// the main one: once this thread has handed it on).
+void std_output_flush_async(int fd, std::function<void()> done = nullptr);
+
+// Finish writing and release the handle through which `loop` learns that
+// the writer has caught up.  Called by the Scheduler before it closes its loop.
+void std_output_loop_shutdown(uv_loop_t* loop);
+
+void std_output_set_buffering(int fd, StdBuffering mode);
+StdBuffering std_output_buffering(int fd);  // the effective mode, never Auto
+size_t std_output_buffered(int fd);  // queued bytes the kernel has not taken
+
+// "auto", "line", "full" or "none".
+bool std_output_parse_buffering(const std::string& name, StdBuffering& out);
+const char* std_output_buffering_name(StdBuffering mode);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include "uv.h"
+
+// Line splitting for stdin.lines() (modules_builtins/stdin_lines.cc).
+//
+// Blocks go in as they are read; complete lines collect in `ready` without
+// their "\n" or "\r\n", and an unterminated tail waits in `carry` for the
+// next block.  `buffered` is what `ready` holds, counting one byte per line
+// for its terminator so that a run of empty lines still fills the reader's
+// read-ahead limit.
+
+struct LineSplitter {
+    std::deque<std::string> ready;
+    std::string carry;
+    size_t buffered = 0;
+
+    void push(const char* p, size_t len);
+
+    // End of input: an unterminated last line is handed out as it is.
+    void finish();
+
+    // The oldest complete line; `ready` must not be empty.
+    std::string take();
+};
+
+// Release stdin.lines()'s poll handle on `loop` (stdin.cc).  Called by the
+// Scheduler before it closes its loop.
+void stdin_loop_shutdown(uv_loop_t* loop);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ZlibStream.hpp"
+
+// Native transform stages for streams.pipeline (streams/pipeline_stages.cc).
+//
+// A stage takes bytes in and appends whatever it produces to a caller's
+// buffer, so a pipeline moves a chunk through every stage without it ever
+// becoming a script value.  Stages keep their own state between calls (a
+// partial line, a zlib window, a half-filled cipher record) and flush it in
+// finish().
+
+// What the stages found on the way through, reported in the pipeline result.
+struct PipeStats {
+    bool counted_lines = false;
+    uint64_t lines = 0;
+    std::vector<std::string> digests;  // hex, one per hash stage in order
+};
+
+class PipeStage {
+   public:
+    virtual ~PipeStage() = default;
+
+    virtual const char* name() const = 0;
+
+    // Runs `len` bytes through the stage and appends its output to `out`.
+    // Returns false on bad input, with error() saying why.
+    virtual bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) = 0;
+
+    // End of input: appends anything still held back.
+    virtual bool finish(std::vector<uint8_t>& out) = 0;
+
+    virtual void report(PipeStats&) const {}
+
+    const std::string& error() const { return error_; }
+
+   protected:
+    std::string error_;
+};
+
+using PipeStagePtr = std::unique_ptr<PipeStage>;
+
+// gzip / deflate via ZlibStream; null when built without zlib.
+PipeStagePtr make_compress_stage(ZlibStream::Format format, int level);
+PipeStagePtr make_decompress_stage();
+
+// Pass-through digest: "sha256", "sha512" or "blake2b".  Null for anything else.
+PipeStagePtr make_hash_stage(const std::string& algorithm);
+
+// Re-chunks the stream so every chunk it passes on ends at a '\n' and counts
+// the lines.  A line longer than `max_line` is passed on in pieces rather than
+// held without bound.
+PipeStagePtr make_lines_stage(size_t max_line);
+
+// XChaCha20-Poly1305 secretstream with a 32-byte key.  The encrypted form is
+// the 24-byte header, then one record per `record_size` bytes of plaintext
+// (record_size + 17 bytes each), the last one tagged final.  Decryption must
+// be given the same record size; it fails on tampering or truncation.
+PipeStagePtr make_encrypt_stage(const std::vector<uint8_t>& key, size_t record_size);
+PipeStagePtr make_decrypt_stage(const std::vector<uint8_t>& key, size_t record_size);
+
+static constexpr size_t PIPE_CIPHER_RECORD_SIZE = 64 * 1024;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "uv.h"
+
+// Buffer plumbing shared by the socket modules (UvBuffers.cpp).
+//
+// Reads: read_pool_alloc is a uv_alloc_cb that hands out fixed-size slabs from
+// a per-thread free list; the read callback gives the slab back with
+// read_pool_release instead of free().  A busy connection reuses the same few
+// slabs instead of a malloc/free pair per read.
+//
+// Writes: stream_write_gather sends several buffers in one call without
+// joining them first.  uv_try_write goes first; only a remainder the kernel
+// did not take is queued with uv_write.
+//
+// Corking: loop_defer runs a callback in the next idle phase of the calling
+// thread's loop, i.e. after the current tick's work.  Writers use it to batch
+// small writes into one syscall.
+
+static constexpr size_t READ_POOL_SLAB_SIZE = 64 * 1024;
+
+void read_pool_alloc(uv_handle_t* handle, size_t suggested, uv_buf_t* buf);
+void read_pool_release(const uv_buf_t* buf);
+
+// Called with the uv_write status once queued bytes have been written.
+using StreamWriteDone = std::function<void(int status)>;
+
+// Write bufs[0..nbufs) to `stream` in order.  Returns true when everything was
+// written now; `done` is then never called.  Otherwise returns false and calls
+// `done` later with the uv_write status, which is negative if the stream
+// refused the write.
+//
+// `owner` keeps the memory behind `bufs` alive until the write finishes, so
+// the remainder is queued in place.  Without an owner the remainder is copied.
+bool stream_write_gather(uv_stream_t* stream, const uv_buf_t* bufs, unsigned int nbufs,
+    std::shared_ptr<void> owner, StreamWriteDone done);
+
+// Run `fn` once in the next idle phase of the calling thread's loop.
+void loop_defer(std::function<void()> fn);
+
+// A corked byte stream for message channels and sockets.  Writers append to
+// `pending` and call commit(); everything appended during a tick leaves in one
+// write at the next idle phase, or straight away once `limit` bytes are
+// waiting.  Whoever closes the stream calls detach() first; bytes still corked
+// are dropped.
+class StreamCork : public std::enable_shared_from_this<StreamCork> {
+   public:
+    explicit StreamCork(uv_stream_t* stream, size_t limit = 256 * 1024) : stream_(stream), limit_(limit) {}
+
+    std::vector<uint8_t> pending;
+
+    // Called once the bytes of a flush are written (or failed), possibly from
+    // inside flush() when the kernel took them all at once.
+    StreamWriteDone written;
+
+    // Bytes corked or queued in libuv, for high-water marks.
+    size_t buffered() const;
+
+    void commit();
+    void flush();
+    void detach();
+
+   private:
+    uv_stream_t* stream_;
+    size_t limit_;
+    bool scheduled_ = false;
+};
+
+// Close the deferral handle of `loop`, if this thread created one.  Called by
+// the Scheduler before it drains and closes its loop.
+void loop_defer_shutdown(uv_loop_t* loop);
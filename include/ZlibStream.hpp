@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Incremental gzip / deflate codec (modules_builtins/zlib_stream.cc), used
+// for the http content codings.  Input goes in a piece at a time and output is
+// appended to a caller's buffer, so a body never has to be held whole.
+//
+// Without zlib (HAVE_ZLIB unset) the factories return null and callers send
+// and accept identity bodies only.
+
+class ZlibStream {
+   public:
+    enum class Format { None, Gzip, Deflate };
+    enum class Flush { None, Sync, Finish };
+
+    // `level` is the zlib level, 0-9.
+    static std::unique_ptr<ZlibStream> encoder(Format format, int level = 6);
+
+    // Takes gzip and zlib streams alike, and headerless deflate (which some
+    // servers send as "deflate") when the data does not start like either.
+    static std::unique_ptr<ZlibStream> decoder();
+
+    static bool available();
+
+    ~ZlibStream();
+    ZlibStream(const ZlibStream&) = delete;
+    ZlibStream& operator=(const ZlibStream&) = delete;
+
+    // Runs `len` bytes through the stream and appends what comes out to
+    // `out`.  Flush::Sync pushes out everything written so far on a byte
+    // boundary; Flush::Finish ends an encoder's stream.  Returns false on
+    // corrupt input, with error() saying why; the stream is unusable after.
+    bool write(const void* data, size_t len, std::vector<uint8_t>& out, Flush flush = Flush::None);
+    bool finish(std::vector<uint8_t>& out) { return write(nullptr, 0, out, Flush::Finish); }
+
+    // A decoder has seen the end of the compressed stream.
+    bool done() const;
+    const std::string& error() const;
+    uint64_t total_in() const;
+    uint64_t total_out() const;
+
+   private:
+    struct Impl;
+    explicit ZlibStream(std::unique_ptr<Impl> impl);
+    std::unique_ptr<Impl> impl_;
+};
+
+// The coding named by a Content-Encoding value: gzip (or x-gzip), deflate,
+// or None for identity and anything else.
+ZlibStream::Format http_content_coding(std::string_view value);
+
+// The coding to answer an Accept-Encoding value with, honouring q-values and
+// "*"; gzip wins a tie.  None when neither is acceptable.
+ZlibStream::Format http_negotiate_coding(std::string_view accept_encoding);
+
+inline const char* http_coding_name(ZlibStream::Format format) {
+    switch (format) {
+        case ZlibStream::Format::Gzip:
+            return "gzip";
+        case ZlibStream::Format::Deflate:
+            return "deflate";
+        default:
+            return "identity";
+    }
+}
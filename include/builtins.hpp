@@ -14,10 +14,25 @@ std::shared_ptr<ObjectValue> make_path_exports(EnvPtr env);
 std::shared_ptr<ObjectValue> make_os_exports(EnvPtr env);
 std::shared_ptr<ObjectValue> make_process_exports(EnvPtr env, Evaluator* evaluator);
 std::shared_ptr<ObjectValue> make_timers_exports(EnvPtr env);
+// Registers the global `scheduler` object (yield / postTask / setBudget) — AsyncApi.cpp
+void init_scheduler_global(EnvPtr env, Evaluator* evaluator);
 
 // Fork implementation (defined in subprocess_fork.cc)
-Value native_fork(const std::vector<Value>& args, EnvPtr env, const Token& token);
+Value native_fork(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator = nullptr);
 std::shared_ptr<ObjectValue> make_subprocess_exports(EnvPtr env, Evaluator* evaluator);
+
+// A spawned child's pipes for native consumers such as streams.pipeline
+// (subprocess.cc); children are named by the `_childStdout` / `_childStdin`
+// id on their stdio objects.  child_stdout_tap takes the child's stdout away
+// from its "data"/"end" listeners: `data` gets every chunk, `end` gets 0 at
+// EOF or a libuv error.  child_stdout_flow pauses and resumes reading; false
+// once the child's stdout has ended.  child_stdin_stream is null once stdin
+// has been ended or the child is gone.
+bool child_stdout_tap(long long child_id, std::function<void(const char*, size_t)> data, std::function<void(int)> end);
+bool child_stdout_flow(long long child_id, bool flowing);
+uv_stream_t* child_stdin_stream(long long child_id);
+void child_stdin_end(long long child_id);
+
 Value process_send_ipc(const std::vector<Value>& args, EnvPtr env, const Token& token);
 Value process_on_message_ipc(const std::vector<Value>& args, EnvPtr env, const Token& token);
 
@@ -40,6 +55,12 @@ std::shared_ptr<ObjectValue> make_uv_exports(EnvPtr env);
 
 // Forward declaration: native createServer implementation (defined in HttpAPI.cpp)
 Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator);
+// http.Router() -> router object (http_router.cc)
+Value native_createRouter(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator);
+// http.static(root, opts?) -> handler(req, res, next?) (http_static.cc)
+Value native_httpStatic(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator);
+// http.bench(opts) -> Promise<result> (http_bench.cc)
+Value native_httpBench(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator);
 void native_http_exetended(const ObjectPtr& http_module, Evaluator* evaluator, EnvPtr env);
 
 // Network stream helpers (defined in streams.cc, used by HttpAPI.cpp)
@@ -967,14 +967,39 @@ struct PropertyDescriptor {
     Token token;
 };
 
+// Native backing for builtin objects that fill in their properties lazily
+// (http req/res).  get_object_property offers a key missing from `properties`
+// to resolve(), which may insert it; code that enumerates an object calls
+// ObjectValue::materialize() first so it sees every key.
+struct HostProps {
+    virtual ~HostProps() = default;
+    // Insert `key` into self.properties if this host provides it (at most once
+    // per key).  Returns whether it did.
+    virtual bool resolve(ObjectValue& self, const std::string& key) = 0;
+    // Insert every key not provided yet.
+    virtual void materialize(ObjectValue& self) = 0;
+};
+
 struct ObjectValue {
     std::unordered_map<std::string,
         PropertyDescriptor>
         properties;
     bool is_frozen = false;
 
+    // Lazily provided properties; null for ordinary objects.
+    std::shared_ptr<HostProps> host;
+
     ObjectValue() {
         MemoryTracking::g_object_count.fetch_add(1);
+        MemoryTracking::g_objects_allocated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Make `properties` complete before enumerating it.  Once everything is
+    // in place the host is no longer needed.
+    void materialize() {
+        if (!host) return;
+        std::shared_ptr<HostProps> h = std::move(host);
+        h->materialize(*this);
     }
 
     ~ObjectValue() {
@@ -1106,6 +1131,7 @@ struct FunctionValue : public std::enable_shared_from_this<FunctionValue> {
                             is_generator(b ? b->is_generator : false),
                             is_native(false) {
         MemoryTracking::g_function_count.fetch_add(1);
+        MemoryTracking::g_functions_allocated.fetch_add(1, std::memory_order_relaxed);
         parameters.reserve(params.size());
         for (const auto& p : params) {
             if (p) {
@@ -1131,6 +1157,7 @@ struct FunctionValue : public std::enable_shared_from_this<FunctionValue> {
                             is_generator(b ? b->is_generator : false),
                             is_native(false) {
         MemoryTracking::g_function_count.fetch_add(1);
+        MemoryTracking::g_functions_allocated.fetch_add(1, std::memory_order_relaxed);
     }
 
     FunctionValue(
@@ -1147,6 +1174,7 @@ struct FunctionValue : public std::enable_shared_from_this<FunctionValue> {
                             is_native(true),
                             native_impl(std::move(impl)) {
         MemoryTracking::g_function_count.fetch_add(1);
+        MemoryTracking::g_functions_allocated.fetch_add(1, std::memory_order_relaxed);
     }
 
     bool is_wrapped() const { return wrapped_original != nullptr; }
@@ -1284,6 +1312,9 @@ class Evaluator {
     Value evaluate_expression_public(ExpressionNode* expr, EnvPtr env) {
         return evaluate_expression(expr, env);
     }
+    ObjectPtr import_module_public(const std::string& module_spec, const Token& requesterTok, EnvPtr requesterEnv) {
+        return import_module(module_spec, requesterTok, requesterEnv);
+    }
 
     std::vector<CallFramePtr> get_call_stack_snapshot();
 
@@ -1308,6 +1339,7 @@ class Evaluator {
     void pop_frame();
     CallFramePtr current_frame();
     void execute_frame_until_await_or_return(CallFramePtr frame, PromisePtr promise);
+    [[noreturn]] void suspend_frame_on_promise(CallFramePtr frame, PromisePtr p, size_t aid);
     void execute_frame_until_return(CallFramePtr frame);
 
     void add_suspended_frame(CallFramePtr f);
@@ -19,6 +19,10 @@ extern std::atomic<size_t> g_datetime_count;
 extern std::atomic<size_t> g_range_count;
 extern std::atomic<size_t> g_map_count;
 
+// Running totals (never decremented): allocation rate rather than live size.
+extern std::atomic<size_t> g_objects_allocated;
+extern std::atomic<size_t> g_functions_allocated;
+
 // Buffer bytes (actual data size)
 extern std::atomic<size_t> g_buffer_bytes;
 
@@ -1,4 +1,30 @@
 #pragma once
+#include <cstdint>
+#include <vector>
+
 #include "evaluator.hpp"
 
-std::shared_ptr<ObjectValue> make_serialization_exports(EnvPtr env, Evaluator* evaluator);
\ No newline at end of file
+std::shared_ptr<ObjectValue> make_serialization_exports(EnvPtr env, Evaluator* evaluator);
+
+// Structured clone codec (serialization.cc) — compact binary format used for
+// Worker messages and "advanced" process IPC.  Preserves shared references and
+// cycles, and round-trips HashMap / Set / DateTime / Regex / Buffer / Range.
+//
+// When `evaluator` is given, Set and HashMap instances are re-linked to the
+// receiving interpreter's classes; without it they decode as plain objects
+// that still carry their private storage.
+std::vector<uint8_t> structured_clone_encode(const Value& v, const Token& tok = {});
+Value structured_clone_decode(const uint8_t* data, size_t len, Evaluator* evaluator, const Token& tok = {});
+
+// Length-prefixed framing for structured clone over byte streams (process
+// IPC): each frame is a u32 little-endian payload length followed by the
+// payload.  structured_clone_frame_append encodes a frame onto the end of
+// `out`, so a writer can collect a tick's messages in one buffer.
+// structured_clone_unframe decodes every complete message in `pending` + `data`;
+// a trailing partial frame stays in `pending`.  A frame that fails to decode
+// is skipped and the rest still delivered; a length prefix over 256 MiB means
+// the stream is out of step, so buffered and remaining input is dropped.  Each
+// such problem is appended to `errors` when given.
+std::vector<uint8_t> structured_clone_frame(const Value& v, const Token& tok = {});
+void structured_clone_frame_append(std::vector<uint8_t>& out, const Value& v, const Token& tok = {});
+std::vector<Value> structured_clone_unframe(std::vector<uint8_t>& pending, const uint8_t* data, size_t len, Evaluator* evaluator, std::vector<std::string>* errors = nullptr);
@@ -1,5 +1,6 @@
 #pragma once
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -14,7 +15,8 @@ class Scheduler;
 enum class WorkerMode {
     File,     // Worker("path.sl")          — load from filesystem
     Eval,     // Worker("code", {eval:true}) — source string, no file
-    Function  // Worker(fn)                 — AST body, no source at all
+    Function,  // Worker(fn)                 — AST body, no source at all
+    Native     // spawn_native_worker()      — C++ body drives the thread
 };
 
 // Worker limit = number of logical CPU cores.
@@ -22,8 +24,21 @@ enum class WorkerMode {
 // No artificial inflation (e.g. 8-cap) and no proximity math — keep it simple.
 static const int SWAZI_MAX_WORKERS = (int)uv_available_parallelism();
 
-// Safe cross-thread value copy — only transferable data types, throws otherwise.
-Value deep_clone_value(const Value& v, const Token& tok = {});
+// A message in flight between threads: a structured-clone payload (swazi.hpp).
+using WorkerMessage = std::vector<uint8_t>;
+
+// Data-parallel array ops backing arr.pmap / arr.pfilter / arr.preduce and the
+// parallel.* helpers.  args are the method arguments: (fn, opts?) for Map and
+// Filter, (fn, initial?, opts?) for Reduce.  Blocks until every chunk is done.
+enum class ParallelOp { Map,
+    Filter,
+    Reduce };
+Value parallel_array_op(ParallelOp op, const ArrayPtr& arr, const std::vector<Value>& args,
+    Evaluator* evaluator, EnvPtr callEnv, const Token& tok);
+
+// A wrapper sharing fn's body AST whose closure is `global_env` — how a
+// function is moved onto another interpreter thread (no closure bleed).
+FunctionPtr isolate_function(const FunctionPtr& fn, EnvPtr global_env);
 
 // Join all active workers — called at program exit from Evaluator::evaluate().
 void join_all_workers();
@@ -46,6 +61,12 @@ struct WorkerCtx {
     // used — the worker calls this body inside its own fresh global env.
     FunctionPtr worker_fn;
 
+    // Set only in Native mode: runs on the worker thread with its own
+    // evaluator and must drive the loop itself.  native_on_exit runs on the
+    // spawning thread's loop with the exit code, instead of w.on("exit").
+    std::function<void(WorkerCtx&, Evaluator&)> native_body;
+    std::function<void(int)> native_on_exit;
+
     // argv passed via unda Worker(spec, { argv: [...] }).
     // Injected into the worker's process.argv equivalent at startup.
     // The worker does NOT inherit the main thread's argv — isolation by design.
@@ -89,12 +110,20 @@ struct WorkerCtx {
 
     // Messages sent before worker_scheduler is published — drained at boot.
     std::mutex pending_mutex;
-    std::vector<Value> pending_messages;
+    std::vector<WorkerMessage> pending_messages;
 
     WorkerCtx* parent_ctx = nullptr;
 };
 
 using WorkerCtxPtr = std::shared_ptr<WorkerCtx>;
 
+// Start an interpreter thread for builtin modules (e.g. multi-core http).  It
+// is registered like any Worker: counts toward SWAZI_MAX_WORKERS (throws when
+// the cap is reached), keeps the spawning loop alive while it runs and is
+// joined at exit.  Must be called on the spawning thread's loop.
+WorkerCtxPtr spawn_native_worker(Evaluator* parent, const std::string& label,
+    std::function<void(WorkerCtx&, Evaluator&)> body,
+    std::function<void(int)> on_exit, const Token& tok = {});
+
 // Called once from init_globals to register the Worker constructor.
 void init_worker(EnvPtr env, Evaluator* evaluator);
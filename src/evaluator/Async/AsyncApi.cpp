@@ -10,6 +10,7 @@
 
 #include "AsyncBridge.hpp"  // -> defines CallbackPayload
 #include "Scheduler.hpp"
+#include "SwaziError.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "worker.hpp"
@@ -45,11 +46,12 @@ bool async_timers_exist();
 
 // Enqueue a language callback (used across this file)
 // Build a heap-allocated CallbackPayload and hand it to the scheduler bridge.
-static void enqueue_callback(FunctionPtr cb, const std::vector<Value>& args) {
+// Timer firings are the common caller, hence the default lane.
+static void enqueue_callback(FunctionPtr cb, const std::vector<Value>& args, TaskPriority lane = TaskPriority::Timer) {
     if (!cb) return;
     // allocate a payload copy that the evaluator will delete after use
     CallbackPayload* box = new CallbackPayload(cb, args);
-    enqueue_callback_global(static_cast<void*>(box));
+    enqueue_callback_global_on(static_cast<void*>(box), lane);
 }
 
 // Evaluator: schedule callback (exposed)
@@ -68,9 +70,10 @@ void Evaluator::schedule_callback(FunctionPtr cb, const std::vector<Value>& args
             } catch (...) {
                 std::cerr << "Unhandled async callback unknown exception" << std::endl;
             }
-        });
+        },
+            TaskPriority::User);
     } else {
-        enqueue_callback(cb, args);
+        enqueue_callback(cb, args, TaskPriority::User);
     }
 }
 
@@ -409,7 +412,7 @@ std::shared_ptr<ObjectValue> make_timers_exports(EnvPtr /*env*/) {
         FunctionPtr cb = std::get<FunctionPtr>(args[0]);
         std::vector<Value> cb_args;
         for (size_t i = 1; i < args.size(); ++i) cb_args.push_back(args[i]);
-        enqueue_callback(cb, cb_args);
+        enqueue_callback(cb, cb_args, TaskPriority::User);
         return std::monostate{};
     };
     Token tsub;
@@ -561,6 +564,106 @@ std::shared_ptr<ObjectValue> make_timers_exports(EnvPtr /*env*/) {
     return obj;
 }
 
+// Map a script priority name onto a scheduler lane.  Names follow the web
+// Prioritized Task Scheduling API; I/O completions keep the top lane to themselves.
+static TaskPriority parse_task_priority(const Value& v, const Token& token) {
+    if (std::holds_alternative<std::monostate>(v)) return TaskPriority::User;
+    if (!std::holds_alternative<std::string>(v)) {
+        throw SwaziError("TypeError", "scheduler priority must be a string", token.loc);
+    }
+    const std::string& p = std::get<std::string>(v);
+    if (p == "user-blocking") return TaskPriority::Timer;
+    if (p == "user-visible" || p == "user") return TaskPriority::User;
+    if (p == "background") return TaskPriority::Background;
+    throw SwaziError("RangeError", "Unknown scheduler priority '" + p + "' (expected user-blocking, user-visible or background)", token.loc);
+}
+
+static Value priority_option(const std::vector<Value>& args, size_t idx) {
+    if (args.size() <= idx) return std::monostate{};
+    if (std::holds_alternative<std::string>(args[idx])) return args[idx];
+    if (std::holds_alternative<ObjectPtr>(args[idx])) {
+        ObjectPtr o = std::get<ObjectPtr>(args[idx]);
+        auto it = o->properties.find("priority");
+        if (it != o->properties.end()) return it->second.value;
+    }
+    return std::monostate{};
+}
+
+// Global `scheduler` object:
+//   subiri scheduler.yield(priority?)     — resume after pending I/O and timers
+//   scheduler.postTask(fn, { priority })  — run fn as a macrotask, Promise of its result
+//   scheduler.setBudget(ms) / getBudget() — slice length before I/O is polled (0 = off)
+//   scheduler.pending()                   — queued macrotasks per lane
+void init_scheduler_global(EnvPtr env, Evaluator* evaluator) {
+    auto obj = std::make_shared<ObjectValue>();
+    Token tok;
+    tok.type = TokenType::IDENTIFIER;
+    tok.loc = TokenLocation("<scheduler>", 0, 0, 0);
+
+    auto add = [&](const std::string& name, auto impl) {
+        auto fn = std::make_shared<FunctionValue>("scheduler." + name, impl, nullptr, tok);
+        obj->properties[name] = PropertyDescriptor{fn, false, false, true, tok};
+    };
+
+    add("yield", [evaluator](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        TaskPriority lane = parse_task_priority(priority_option(args, 0), token);
+        auto promise = std::make_shared<PromiseValue>();
+        promise->state = PromiseValue::State::PENDING;
+        if (Scheduler* s = evaluator->scheduler()) s->request_poll();
+        scheduler_post_task([evaluator, promise]() { evaluator->fulfill_promise(promise, std::monostate{}); }, lane);
+        return Value{promise};
+    });
+
+    add("postTask", [evaluator](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0])) {
+            throw SwaziError("TypeError", "scheduler.postTask requires a function", token.loc);
+        }
+        FunctionPtr fn = std::get<FunctionPtr>(args[0]);
+        TaskPriority lane = parse_task_priority(priority_option(args, 1), token);
+        auto promise = std::make_shared<PromiseValue>();
+        promise->state = PromiseValue::State::PENDING;
+        scheduler_post_task([evaluator, promise, fn]() {
+            try {
+                Value r = evaluator->invoke_function(fn, {}, fn->closure, fn->token);
+                evaluator->fulfill_promise(promise, r);
+            } catch (const std::exception& e) {
+                evaluator->reject_promise(promise, Value{std::string(e.what())});
+            }
+        },
+            lane);
+        return Value{promise};
+    });
+
+    add("setBudget", [evaluator](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty() || !std::holds_alternative<double>(args[0])) {
+            throw SwaziError("TypeError", "scheduler.setBudget requires a number of milliseconds", token.loc);
+        }
+        if (Scheduler* s = evaluator->scheduler()) s->set_budget_ms(std::get<double>(args[0]));
+        return std::monostate{};
+    });
+
+    add("getBudget", [evaluator](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        Scheduler* s = evaluator->scheduler();
+        return Value{s ? s->budget_ms() : 0.0};
+    });
+
+    add("pending", [evaluator](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        auto out = std::make_shared<ObjectValue>();
+        Scheduler* s = evaluator->scheduler();
+        auto put = [&](const char* key, TaskPriority lane) {
+            double n = s ? static_cast<double>(s->pending_macrotasks(lane)) : 0.0;
+            out->properties[key] = PropertyDescriptor{Value{n}, false, false, false, Token()};
+        };
+        put("io", TaskPriority::IO);
+        put("timer", TaskPriority::Timer);
+        put("user", TaskPriority::User);
+        put("background", TaskPriority::Background);
+        return Value{out};
+    });
+
+    env->set("scheduler", {obj, true});
+}
+
 // Check whether there are any active timers (used by the scheduler exit predicate)
 bool async_timers_exist() {
     std::lock_guard<std::mutex> lk(g_timers_mutex);
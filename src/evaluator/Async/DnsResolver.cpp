@@ -0,0 +1,306 @@
+#include "DnsResolver.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+// ---------- state ----------
+
+struct DnsEntry {
+    std::vector<sockaddr_storage> addrs;
+    int status = 0;         // non-zero: a cached "no such name"
+    uint64_t expires = 0;   // now_ms() deadline
+    size_t next = 0;        // rotates through addrs
+};
+
+// The cache is shared by every loop and by fetch's worker threads.
+struct DnsState {
+    std::mutex mutex;
+    DnsOptions options;
+    std::unordered_map<std::string, std::vector<sockaddr_storage>> hosts;
+    std::unordered_map<std::string, DnsEntry> cache;
+    DnsStats stats;
+};
+
+static DnsState g_dns;
+
+// Lookups in flight on this thread's loop, by cache key, with everyone
+// waiting for them.
+static thread_local std::unordered_map<std::string, std::vector<DnsCallback>> t_inflight;
+
+static uint64_t now_ms() {
+    return uv_hrtime() / 1000000;
+}
+
+static std::string lower(const std::string& s) {
+    std::string out(s);
+    for (char& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+static std::string cache_key(const std::string& host, int family) {
+    return lower(host) + "/" + std::to_string(family);
+}
+
+static bool family_matches(const sockaddr_storage& addr, int family) {
+    return family == AF_UNSPEC || addr.ss_family == family;
+}
+
+// An IPv4 or IPv6 literal, brackets allowed ("[::1]").
+static bool parse_literal(const std::string& host, sockaddr_storage& out) {
+    std::string h = host;
+    if (h.size() > 2 && h.front() == '[' && h.back() == ']') h = h.substr(1, h.size() - 2);
+    memset(&out, 0, sizeof(out));
+    if (uv_ip4_addr(h.c_str(), 0, reinterpret_cast<sockaddr_in*>(&out)) == 0) return true;
+    if (uv_ip6_addr(h.c_str(), 0, reinterpret_cast<sockaddr_in6*>(&out)) == 0) return true;
+    return false;
+}
+
+static bool read_hosts(const std::string& path, std::unordered_map<std::string, std::vector<sockaddr_storage>>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        std::istringstream fields(line);
+        std::string address, name;
+        sockaddr_storage addr;
+        if (!(fields >> address) || !parse_literal(address, addr)) continue;
+        while (fields >> name) out[lower(name)].push_back(addr);
+    }
+    return true;
+}
+
+// ---------- cache (g_dns.mutex held) ----------
+
+static void rotated(DnsEntry& entry, std::vector<sockaddr_storage>& out) {
+    out = entry.addrs;
+    if (out.size() > 1) std::rotate(out.begin(), out.begin() + (entry.next++ % out.size()), out.end());
+}
+
+// True when the hosts file or the cache settles `host`; `status` says how.
+static bool answer_locked(const std::string& host, int family, std::vector<sockaddr_storage>& out, int& status) {
+    auto h = g_dns.hosts.find(lower(host));
+    if (h != g_dns.hosts.end()) {
+        out.clear();
+        for (const auto& addr : h->second)
+            if (family_matches(addr, family)) out.push_back(addr);
+        if (!out.empty()) {
+            g_dns.stats.hits++;
+            status = 0;
+            return true;
+        }
+    }
+    if (g_dns.options.hosts_only) {
+        out.clear();
+        status = UV_EAI_NONAME;
+        return true;
+    }
+
+    auto it = g_dns.cache.find(cache_key(host, family));
+    if (it == g_dns.cache.end()) return false;
+    if (now_ms() >= it->second.expires) {
+        g_dns.cache.erase(it);
+        return false;
+    }
+    g_dns.stats.hits++;
+    status = it->second.status;
+    if (status == 0)
+        rotated(it->second, out);
+    else
+        out.clear();
+    return true;
+}
+
+static void store_locked(const std::string& key, int status, const std::vector<sockaddr_storage>& addrs) {
+    uint64_t ttl = status == 0 ? g_dns.options.ttl_ms : g_dns.options.negative_ttl_ms;
+    if (ttl == 0 || g_dns.options.max_entries == 0) return;
+
+    if (g_dns.cache.size() >= g_dns.options.max_entries && !g_dns.cache.count(key)) {
+        uint64_t now = now_ms();
+        for (auto it = g_dns.cache.begin(); it != g_dns.cache.end();) {
+            if (now >= it->second.expires)
+                it = g_dns.cache.erase(it);
+            else
+                ++it;
+        }
+        if (g_dns.cache.size() >= g_dns.options.max_entries) {
+            auto oldest = std::min_element(g_dns.cache.begin(), g_dns.cache.end(),
+                [](const auto& a, const auto& b) { return a.second.expires < b.second.expires; });
+            g_dns.cache.erase(oldest);
+        }
+    }
+
+    DnsEntry& entry = g_dns.cache[key];
+    entry.addrs = addrs;
+    entry.status = status;
+    entry.expires = now_ms() + ttl;
+    entry.next = 0;
+}
+
+// Only a definite "no such name" is worth remembering; timeouts and the
+// like are retried on the next call.
+static bool is_negative_answer(int status) {
+    return status == UV_EAI_NONAME || status == UV_EAI_NODATA;
+}
+
+// ---------- lookups ----------
+
+struct DnsLookup {
+    uv_getaddrinfo_t req;
+    std::string key;
+};
+
+static void finish_lookup(const std::string& key, int status, const std::vector<sockaddr_storage>& addrs) {
+    auto it = t_inflight.find(key);
+    if (it == t_inflight.end()) return;
+    std::vector<DnsCallback> waiters = std::move(it->second);
+    t_inflight.erase(it);
+
+    if (status == 0 || is_negative_answer(status)) {
+        std::lock_guard<std::mutex> lk(g_dns.mutex);
+        store_locked(key, status, addrs);
+    }
+
+    // Waiters of one lookup start on different addresses, like cache hits.
+    std::vector<sockaddr_storage> order;
+    for (size_t i = 0; i < waiters.size(); ++i) {
+        order = addrs;
+        if (order.size() > 1) std::rotate(order.begin(), order.begin() + (i % order.size()), order.end());
+        waiters[i](status, order);
+    }
+}
+
+static void on_getaddrinfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
+    auto* lookup = static_cast<DnsLookup*>(req->data);
+    std::vector<sockaddr_storage> addrs;
+    if (status == 0) {
+        for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+            if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) continue;
+            sockaddr_storage addr;
+            memset(&addr, 0, sizeof(addr));
+            memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+            addrs.push_back(addr);
+        }
+        if (addrs.empty()) status = UV_EAI_NODATA;
+    }
+    if (res) uv_freeaddrinfo(res);
+
+    std::string key = std::move(lookup->key);
+    delete lookup;
+    finish_lookup(key, status, addrs);
+}
+
+void dns_resolve(uv_loop_t* loop, const std::string& host, int family, DnsCallback cb) {
+    sockaddr_storage literal;
+    if (parse_literal(host, literal)) {
+        if (family_matches(literal, family))
+            cb(0, {literal});
+        else
+            cb(UV_EAI_ADDRFAMILY, {});
+        return;
+    }
+
+    std::vector<sockaddr_storage> addrs;
+    int status = 0;
+    bool settled;
+    {
+        std::lock_guard<std::mutex> lk(g_dns.mutex);
+        settled = answer_locked(host, family, addrs, status);
+    }
+    if (settled) {
+        cb(status, addrs);
+        return;
+    }
+
+    std::string key = cache_key(host, family);
+    auto& waiters = t_inflight[key];
+    waiters.push_back(std::move(cb));
+    if (waiters.size() > 1) {
+        std::lock_guard<std::mutex> lk(g_dns.mutex);
+        g_dns.stats.coalesced++;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(g_dns.mutex);
+        g_dns.stats.lookups++;
+    }
+
+    auto* lookup = new DnsLookup{};
+    lookup->key = key;
+    lookup->req.data = lookup;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int r = uv_getaddrinfo(loop, &lookup->req, on_getaddrinfo, host.c_str(), nullptr, &hints);
+    if (r != 0) {
+        delete lookup;
+        finish_lookup(key, r, {});
+    }
+}
+
+bool dns_lookup_cached(const std::string& host, int family, std::vector<sockaddr_storage>& out) {
+    sockaddr_storage literal;
+    if (parse_literal(host, literal)) {
+        out.assign(1, literal);
+        return family_matches(literal, family);
+    }
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    int status = 0;
+    return answer_locked(host, family, out, status) && status == 0;
+}
+
+void dns_remember(const std::string& host, const sockaddr_storage& addr) {
+    if (addr.ss_family != AF_INET && addr.ss_family != AF_INET6) return;
+    sockaddr_storage literal;
+    if (parse_literal(host, literal)) return;
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    uint64_t now = now_ms();
+    for (int family : {AF_UNSPEC, static_cast<int>(addr.ss_family)}) {
+        std::string key = cache_key(host, family);
+        auto it = g_dns.cache.find(key);
+        if (it != g_dns.cache.end() && it->second.status == 0 && now < it->second.expires) continue;
+        store_locked(key, 0, {addr});
+    }
+}
+
+// ---------- configuration ----------
+
+bool dns_configure(const DnsOptions& options) {
+    std::string path = options.hosts_file;
+    if (path.empty() && options.hosts_only) path = "/etc/hosts";
+
+    std::unordered_map<std::string, std::vector<sockaddr_storage>> hosts;
+    if (!path.empty() && !read_hosts(path, hosts)) return false;
+
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    g_dns.options = options;
+    g_dns.hosts = std::move(hosts);
+    g_dns.cache.clear();
+    return true;
+}
+
+DnsOptions dns_options() {
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    return g_dns.options;
+}
+
+DnsStats dns_stats() {
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    DnsStats stats = g_dns.stats;
+    stats.entries = g_dns.cache.size();
+    return stats;
+}
+
+void dns_clear() {
+    std::lock_guard<std::mutex> lk(g_dns.mutex);
+    g_dns.cache.clear();
+}
@@ -0,0 +1,161 @@
+#include "LoopTrace.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "uv.h"
+
+// ---------- histogram ----------
+
+void LoopHistogram::record(uint64_t us) {
+    int b = 0;
+    while (b < BUCKETS - 1 && (1ULL << b) <= us) b++;
+    counts[b]++;
+    total++;
+    sum_us += us;
+    if (us > max_us) max_us = us;
+}
+
+uint64_t LoopHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    // Nearest-rank: the ceil(p * total)-th smallest sample (0-based index below).
+    double rank = std::ceil(p * static_cast<double>(total));
+    uint64_t want = rank <= 1.0 ? 0 : static_cast<uint64_t>(rank) - 1;
+    if (want >= total) want = total - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen > want) {
+            uint64_t upper = 1ULL << b;
+            return upper < max_us ? upper : max_us;
+        }
+    }
+    return max_us;
+}
+
+// ---------- stats ----------
+
+static thread_local LoopStats t_loop_stats;
+
+LoopStats& loop_stats() { return t_loop_stats; }
+
+void loop_stats_reset() { t_loop_stats = LoopStats{}; }
+
+// ---------- tracing ----------
+
+// Cap on buffered events so a forgotten trace cannot grow without bound.
+static constexpr size_t TRACE_MAX_EVENTS = 1000000;
+
+struct TraceEvent {
+    const char* name;
+    std::string site;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    uint64_t wait_ns;
+    uint64_t tid;
+    bool counter;  // lag sample ("C" phase); dur_ns holds lag in µs
+};
+
+static std::atomic<bool> g_trace_on{false};
+static std::mutex g_trace_mutex;
+static std::vector<TraceEvent> g_trace_events;
+static uint64_t g_trace_dropped = 0;
+
+static uint64_t trace_tid() {
+    static thread_local uint64_t tid = std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xffffff;
+    return tid;
+}
+
+static void trace_push(TraceEvent&& ev) {
+    std::lock_guard<std::mutex> lk(g_trace_mutex);
+    if (g_trace_events.size() >= TRACE_MAX_EVENTS) {
+        g_trace_dropped++;
+        return;
+    }
+    g_trace_events.push_back(std::move(ev));
+}
+
+bool loop_trace_enabled() { return g_trace_on.load(std::memory_order_relaxed); }
+
+void loop_trace_start() {
+    std::lock_guard<std::mutex> lk(g_trace_mutex);
+    g_trace_events.clear();
+    g_trace_dropped = 0;
+    g_trace_on.store(true);
+}
+
+void loop_trace_stop() { g_trace_on.store(false); }
+
+void loop_trace_task(const char* name, const std::string& site, uint64_t start_ns, uint64_t dur_ns, uint64_t wait_ns) {
+    if (!loop_trace_enabled()) return;
+    trace_push(TraceEvent{name, site, start_ns, dur_ns, wait_ns, trace_tid(), false});
+}
+
+void loop_trace_lag(uint64_t at_ns, uint64_t lag_us) {
+    if (!loop_trace_enabled()) return;
+    trace_push(TraceEvent{"loop lag", std::string(), at_ns, lag_us, 0, trace_tid(), true});
+}
+
+static void json_escape(std::ostringstream& out, const std::string& s) {
+    for (char c : s) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out << buf;
+                } else {
+                    out << c;
+                }
+        }
+    }
+}
+
+// Chrome trace-event format: complete ("X") events for tasks, counter ("C")
+// events for lag samples.  Timestamps are microseconds.
+std::string loop_trace_json() {
+    std::lock_guard<std::mutex> lk(g_trace_mutex);
+    std::ostringstream out;
+    const int pid = static_cast<int>(uv_os_getpid());
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& ev : g_trace_events) {
+        if (!first) out << ",";
+        first = false;
+        out << "{\"name\":\"" << ev.name << "\",\"pid\":" << pid << ",\"tid\":" << ev.tid
+            << ",\"ts\":" << ev.start_ns / 1000;
+        if (ev.counter) {
+            out << ",\"ph\":\"C\",\"args\":{\"lag_ms\":" << static_cast<double>(ev.dur_ns) / 1000.0 << "}}";
+            continue;
+        }
+        out << ",\"ph\":\"X\",\"cat\":\"loop\",\"dur\":" << ev.dur_ns / 1000
+            << ",\"args\":{\"wait_us\":" << ev.wait_ns / 1000;
+        if (!ev.site.empty()) {
+            out << ",\"site\":\"";
+            json_escape(out, ev.site);
+            out << "\"";
+        }
+        out << "}}";
+    }
+    out << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":" << g_trace_dropped << "}}";
+    return out.str();
+}
+
+bool loop_trace_write(const std::string& path) {
+    std::string json = loop_trace_json();
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f.is_open()) return false;
+    f.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return static_cast<bool>(f);
+}
@@ -1,7 +1,16 @@
 #include "Scheduler.hpp"
 
+#include <cstdlib>
 #include <iostream>
 
+#include "AsyncBridge.hpp"
+#include "HttpAgent.hpp"
+#include "HttpFileCache.hpp"
+#include "LoopTrace.hpp"
+#include "StdOutput.hpp"
+#include "StdinLines.hpp"
+#include "UvBuffers.hpp"
+
 // Use local header path for libuv
 #include "uv.h"
 
@@ -11,6 +20,13 @@ static thread_local std::function<void(void*)> g_scheduler_runner = nullptr;
 // Invoked on the scheduler/loop thread.
 static thread_local std::function<void()> g_tick_callback = nullptr;
 
+// SWAZI_TRACE=<file.json> traces the first scheduler created (the main
+// thread's) from construction and writes the trace when it is destroyed.
+static std::atomic<bool> g_trace_env_claimed{false};
+static thread_local const char* g_trace_env_path = nullptr;
+
+static const char* const LANE_NAMES[SCHEDULER_LANES] = {"io", "timer", "user", "background"};
+
 // libuv async callback used to wake the scheduler loop and make it process tasks.
 // This runs on the loop thread.
 //
@@ -33,11 +49,34 @@ Scheduler::Scheduler() {
 
     // register global pointer so other modules (AsyncApi.cpp) can get the loop
     g_scheduler_instance = this;
+
+    if (!g_trace_env_claimed.exchange(true)) {
+        const char* path = std::getenv("SWAZI_TRACE");
+        if (path && *path) {
+            g_trace_env_path = path;
+            loop_trace_start();
+            start_lag_monitor(10);
+        }
+    }
 }
 
 Scheduler::~Scheduler() {
     should_stop = true;
 
+    if (g_trace_env_path) {
+        loop_trace_stop();
+        if (!loop_trace_write(g_trace_env_path)) {
+            std::cerr << "swazi: could not write trace to " << g_trace_env_path << std::endl;
+        }
+        g_trace_env_path = nullptr;
+    }
+
+    if (lag_timer_started_) {
+        uv_timer_stop(&lag_timer_);
+        uv_close(reinterpret_cast<uv_handle_t*>(&lag_timer_), nullptr);
+        lag_timer_started_ = false;
+    }
+
     // Close async handle first
     if (async_initialized) {
         uv_close(reinterpret_cast<uv_handle_t*>(&async_handle_), nullptr);
@@ -46,6 +85,21 @@ Scheduler::~Scheduler() {
     }
 
     if (loop_) {
+        // Send corked writes and close the deferral handle (UvBuffers.cpp)
+        loop_defer_shutdown(loop_);
+
+        // Write out queued stdout/stderr and release their wake handles (StdOutput.cpp)
+        std_output_loop_shutdown(loop_);
+
+        // Close stdin.lines()'s poll handle (stdin.cc)
+        stdin_loop_shutdown(loop_);
+
+        // Close the http file cache's watchers (http_static.cc)
+        http_file_cache_shutdown(loop_);
+
+        // Close pooled http client connections (http_client_modern.cc)
+        http_agent_shutdown(loop_);
+
         // Close all uv module handles (defined in uv.cpp)
         cleanup_uv_handles();
 
@@ -69,52 +123,129 @@ void Scheduler::enqueue_microtask(const Continuation& task) {
     if (!task) return;
     {
         std::lock_guard<std::mutex> lk(microtasks_mutex);
-        microtasks.push_back(task);
+        microtasks.push_back(QueuedTask{task, loop_trace_enabled() ? uv_hrtime() : 0, std::string()});
     }
     // Wake loop so microtasks can be drained
     if (async_initialized) uv_async_send(&async_handle_);
 }
 
-void Scheduler::enqueue_macrotask(const Continuation& task) {
+void Scheduler::enqueue_macrotask(const Continuation& task, TaskPriority lane) {
     if (!task) return;
+    enqueue_macrotask_at(task, lane, std::string());
+}
+
+void Scheduler::enqueue_macrotask_at(Continuation task, TaskPriority lane, std::string site) {
     {
         std::lock_guard<std::mutex> lk(macrotasks_mutex);
-        macrotasks.push_back(task);
+        macrotasks[static_cast<size_t>(lane)].push_back(QueuedTask{std::move(task), uv_hrtime(), std::move(site)});
     }
     if (async_initialized) uv_async_send(&async_handle_);
 }
 
+void Scheduler::lag_timer_cb(uv_timer_t* handle) {
+    Scheduler* self = static_cast<Scheduler*>(handle->data);
+    uint64_t now = uv_hrtime();
+    uint64_t expected = self->lag_last_ns_ + self->lag_interval_ns_;
+    uint64_t lag_us = now > expected ? (now - expected) / 1000 : 0;
+    self->lag_last_ns_ = now;
+    loop_stats().lag.record(lag_us);
+    loop_trace_lag(now, lag_us);
+}
+
+void Scheduler::start_lag_monitor(uint64_t interval_ms) {
+    if (lag_timer_started_ || !loop_ || interval_ms == 0) return;
+    uv_timer_init(loop_, &lag_timer_);
+    lag_timer_.data = this;
+    lag_interval_ns_ = interval_ms * 1000000ULL;
+    lag_last_ns_ = uv_hrtime();
+    uv_timer_start(&lag_timer_, lag_timer_cb, interval_ms, interval_ms);
+    // Never keeps the process alive; also skipped by run_until_idle's handle count.
+    uv_unref(reinterpret_cast<uv_handle_t*>(&lag_timer_));
+    lag_timer_started_ = true;
+}
+
+void Scheduler::set_budget_ms(double ms) {
+    if (!(ms > 0)) ms = 0;
+    budget_ns_.store(static_cast<uint64_t>(ms * 1e6));
+}
+
+size_t Scheduler::pending_macrotasks(TaskPriority lane) {
+    std::lock_guard<std::mutex> lk(macrotasks_mutex);
+    return macrotasks[static_cast<size_t>(lane)].size();
+}
+
+bool Scheduler::take_next_macrotask(QueuedTask& out, size_t& lane) {
+    size_t pick = SCHEDULER_LANES;
+    for (size_t i = 0; i < SCHEDULER_LANES; ++i) {
+        if (!macrotasks[i].empty()) {
+            pick = i;
+            break;
+        }
+    }
+    if (pick == SCHEDULER_LANES) return false;
+
+    // Aging: a lower lane that has been passed over too often gets this turn.
+    for (size_t i = SCHEDULER_LANES; i-- > pick + 1;) {
+        if (!macrotasks[i].empty() && lane_skips_[i] >= SCHEDULER_AGING_LIMIT) {
+            pick = i;
+            break;
+        }
+    }
+    for (size_t i = 0; i < SCHEDULER_LANES; ++i) {
+        if (i == pick || macrotasks[i].empty())
+            lane_skips_[i] = 0;
+        else if (i > pick)
+            lane_skips_[i]++;
+    }
+
+    out = std::move(macrotasks[pick].front());
+    macrotasks[pick].pop_front();
+    lane = pick;
+    return true;
+}
+
 // Drain microtasks then run one macrotask (same semantics as before)
 bool Scheduler::run_one() {
+    LoopStats& stats = loop_stats();
+
     // Drain microtasks first (thread-safe snapshot drain)
     while (true) {
-        Continuation t;
+        QueuedTask t;
         {
             std::lock_guard<std::mutex> lk(microtasks_mutex);
             if (microtasks.empty()) break;
-            t = microtasks.front();
+            t = std::move(microtasks.front());
             microtasks.pop_front();
         }
+        stats.microtasks++;
+        uint64_t start = t.enqueued_ns ? uv_hrtime() : 0;
         try {
-            if (t) t();
+            if (t.fn) t.fn();
         } catch (...) {
             // swallow
         }
+        if (start) loop_trace_task("microtask", t.site, start, uv_hrtime() - start, start - t.enqueued_ns);
     }
 
-    Continuation mtask;
+    QueuedTask mtask;
+    size_t lane = 0;
+    bool have = false;
     {
         std::lock_guard<std::mutex> lk(macrotasks_mutex);
-        if (!macrotasks.empty()) {
-            mtask = macrotasks.front();
-            macrotasks.pop_front();
-        }
+        have = take_next_macrotask(mtask, lane);
     }
 
-    if (mtask) {
+    if (have) {
+        uint64_t start = uv_hrtime();
         try {
-            mtask();
+            if (mtask.fn) mtask.fn();
         } catch (...) {}
+        uint64_t end = uv_hrtime();
+
+        stats.tasks[lane]++;
+        stats.wait.record((start - mtask.enqueued_ns) / 1000);
+        stats.run.record((end - start) / 1000);
+        loop_trace_task(LANE_NAMES[lane], mtask.site, start, end - start, start - mtask.enqueued_ns);
 
         // Invoke tick callback after a macrotask finishes so the owner (Evaluator)
         // can perform unhandled-rejection checks or other housekeeping.
@@ -131,9 +262,10 @@ bool Scheduler::run_one() {
     return false;
 }
 
-// Helper used with uv_walk to count active handles excluding the scheduler's async handle.
+// Helper used with uv_walk to count active, referenced handles excluding the scheduler's async handle.
 struct WalkData {
     uv_handle_t* exclude_handle;
+    uv_handle_t* exclude_lag_timer;
     size_t active_count;
 };
 
@@ -141,25 +273,39 @@ static void walk_count_cb(uv_handle_t* handle, void* arg) {
     WalkData* wd = static_cast<WalkData*>(arg);
     if (!wd) return;
     if (handle == wd->exclude_handle) return;  // ignore the scheduler's async handle
-    // uv_is_active returns non-zero for active handles (e.g., timers, io, etc.)
-    if (uv_is_active(handle)) {
+    if (handle == wd->exclude_lag_timer) return;
+    // uv_is_active returns non-zero for active handles (e.g., timers, io, etc.);
+    // an unref'd handle (idle pooled socket, file watcher) does not keep the loop alive.
+    if (uv_is_active(handle) && uv_has_ref(handle)) {
         wd->active_count++;
     }
 }
 
 void Scheduler::run_until_idle(const std::function<bool()>& has_pending) {
-    // CHANGE THIS COMMENT AND USE THE PREDICATE:
+    uint64_t slice_start = uv_hrtime();
     while (!should_stop) {
+        // Time slicing: after budget_ns_ of back-to-back macrotasks (or on an
+        // explicit scheduler.yield()), poll libuv without blocking so I/O and
+        // timer completions land in their lanes ahead of queued user work.
+        uint64_t budget = budget_ns_.load();
+        if (poll_requested_.exchange(false) || (budget && uv_hrtime() - slice_start >= budget)) {
+            uv_run(loop_, UV_RUN_NOWAIT);
+            sweep_external_data();
+            slice_start = uv_hrtime();
+        }
+
         bool did_work = run_one();
         if (did_work) continue;
 
         {
             std::lock_guard<std::mutex> lk1(macrotasks_mutex);
             std::lock_guard<std::mutex> lk2(microtasks_mutex);
-            bool local_empty = macrotasks.empty() && microtasks.empty();
+            bool local_empty = microtasks.empty();
+            for (auto& lane : macrotasks) local_empty = local_empty && lane.empty();
             if (local_empty) {
                 WalkData wd;
                 wd.exclude_handle = reinterpret_cast<uv_handle_t*>(&async_handle_);
+                wd.exclude_lag_timer = lag_timer_started_ ? reinterpret_cast<uv_handle_t*>(&lag_timer_) : nullptr;
                 wd.active_count = 0;
                 uv_walk(loop_, walk_count_cb, &wd);
 
@@ -178,6 +324,7 @@ void Scheduler::run_until_idle(const std::function<bool()>& has_pending) {
 
         uv_run(loop_, UV_RUN_ONCE);
         sweep_external_data();  // call the cleaning of addon external data
+        slice_start = uv_hrtime();
     }
 }
 void Scheduler::stop() {
@@ -200,12 +347,23 @@ void register_scheduler_runner(Scheduler* s, std::function<void(void*)> runner)
 }
 
 void enqueue_callback_global(void* boxed_payload) {
+    enqueue_callback_global_on(boxed_payload, TaskPriority::IO);
+}
+
+void enqueue_callback_global_on(void* boxed_payload, TaskPriority lane) {
     if (!boxed_payload) return;
     if (!g_scheduler_instance) return;
 
+    // While tracing, tag the task with the callback's definition site.
+    std::string site;
+    if (loop_trace_enabled()) {
+        auto* payload = static_cast<CallbackPayload*>(boxed_payload);
+        if (payload->cb) site = payload->cb->name + " @ " + payload->cb->token.loc.to_string();
+    }
+
     // Use scheduler enqueue_macrotask to schedule the runner to be invoked on the loop thread.
     // The runner will be called with boxed_payload as its argument.
-    g_scheduler_instance->enqueue_macrotask([boxed_payload]() {
+    g_scheduler_instance->enqueue_macrotask_at([boxed_payload]() {
         if (g_scheduler_runner) {
             try {
                 g_scheduler_runner(boxed_payload);
@@ -213,8 +371,10 @@ void enqueue_callback_global(void* boxed_payload) {
                 // runner should handle errors
             }
         }
-    });
+    },
+        lane, std::move(site));
 }
+
 void enqueue_microtask_global(void* boxed_payload) {
     if (!boxed_payload) return;
     if (!g_scheduler_instance) return;
@@ -252,6 +412,39 @@ void scheduler_run_on_loop(const std::function<void()>& fn) {
     g_scheduler_instance->enqueue_macrotask(fn);
 }
 
+// Schedule a function as a microtask on the scheduler loop thread — used by
+// native modules to settle promises from libuv completion callbacks.
+// If the scheduler is not available this will run fn inline (fallback).
+void scheduler_enqueue_microtask(const std::function<void()>& fn) {
+    if (!fn) return;
+    if (!g_scheduler_instance) {
+        try {
+            fn();
+        } catch (...) {}
+        return;
+    }
+    g_scheduler_instance->enqueue_microtask(fn);
+}
+
+void scheduler_post_task(const std::function<void()>& fn, TaskPriority lane) {
+    if (!fn) return;
+    if (!g_scheduler_instance) {
+        try {
+            fn();
+        } catch (...) {}
+        return;
+    }
+    g_scheduler_instance->enqueue_macrotask(fn, lane);
+}
+
+void scheduler_start_lag_monitor(uint64_t interval_ms) {
+    if (g_scheduler_instance) g_scheduler_instance->start_lag_monitor(interval_ms);
+}
+
+size_t scheduler_pending_macrotasks(TaskPriority lane) {
+    return g_scheduler_instance ? g_scheduler_instance->pending_macrotasks(lane) : 0;
+}
+
 // NEW: register a per-tick callback invoked on the loop thread.
 void register_tick_callback(const std::function<void()>& cb) {
     g_tick_callback = cb;
@@ -0,0 +1,484 @@
+#include "StdOutput.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Scheduler.hpp"
+#include "UvBuffers.hpp"
+#include "uv.h"
+
+#ifndef _WIN32
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+// Flush once this much is waiting.
+static constexpr size_t STD_BLOCK_SIZE = 64 * 1024;
+// Writes at least this big get an iovec of their own instead of a copy.
+static constexpr size_t STD_OWN_CHUNK = 4096;
+
+#ifdef IOV_MAX
+static constexpr size_t STD_MAX_IOV = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+static constexpr size_t STD_MAX_IOV = 1024;
+#endif
+
+using StdWaiters = std::vector<std::function<void()>>;
+
+struct StdSink {
+    explicit StdSink(int fd_) : fd(fd_) {}
+
+    int fd;
+    StdBuffering mode = StdBuffering::Auto;
+    int tty = -1;       // uv_guess_handle, looked up once
+    int pollable = -1;  // a pipe or socket: written by its own thread
+
+    std::deque<std::string> chunks;
+    bool tail_open = false;  // chunks.back() takes appends
+    size_t bytes = 0;        // everything queued and not yet taken by the kernel
+    std::string spare;       // a written-out block kept for the next tail
+
+    // Pipes and sockets are written by a thread of their own with ordinary
+    // blocking writes, so a slow reader holds up that thread and not the
+    // loop.  The fd's flags are never touched: a child sharing it sees it
+    // exactly as swazi was given it.
+    bool writer = false;
+    bool writing = false;  // the writer holds chunks taken off the queue
+    std::condition_variable* has_work = nullptr;
+    std::condition_variable* idle = nullptr;
+
+    // The main loop's waiters, run once everything queued has been written.
+    uv_loop_t* loop = nullptr;
+    uv_async_t* wake = nullptr;  // the writer tells the main loop it is done
+    StdWaiters waiters;
+};
+
+// Workers print from their own threads, so the queues are shared under one
+// lock.  Never destroyed: writer threads may still be waiting at exit.
+static std::mutex& g_out_mutex = *new std::mutex;
+static StdSink g_sinks[2] = {StdSink(1), StdSink(2)};
+static bool g_atexit_installed = false;
+
+// Static initialisation runs on the main thread.
+static const std::thread::id g_main_thread = std::this_thread::get_id();
+
+// An end-of-tick flush is queued on this thread's loop.  Cleared by any
+// flush, so a loop that shut down with one pending cannot leave it stuck.
+static thread_local bool t_flush_scheduled[2] = {false, false};
+
+static StdSink* sink_for(int fd) {
+    if (fd == 1) return &g_sinks[0];
+    if (fd == 2) return &g_sinks[1];
+    return nullptr;
+}
+
+static bool on_main_thread() {
+    return std::this_thread::get_id() == g_main_thread;
+}
+
+static StdBuffering effective_mode(StdSink& s) {
+    if (s.mode != StdBuffering::Auto) return s.mode;
+    if (s.fd == 2) return StdBuffering::None;
+    if (s.tty < 0) s.tty = uv_guess_handle(s.fd) == UV_TTY ? 1 : 0;
+    return s.tty ? StdBuffering::Line : StdBuffering::Full;
+}
+
+// Waiters are script callbacks; they never run inside the write that
+// released them.
+static void run_waiters(StdWaiters& done) {
+    for (auto& fn : done) loop_defer(std::move(fn));
+    done.clear();
+}
+
+// ---------- writing ----------
+
+#ifndef _WIN32
+// Left non-blocking by whoever else shares the fd.
+static void wait_writable(int fd) {
+    struct pollfd pfd{fd, POLLOUT, 0};
+    poll(&pfd, 1, -1);
+}
+#endif
+
+static void write_raw(int fd, const char* data, size_t len) {
+    while (len > 0) {
+#ifndef _WIN32
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_writable(fd);
+                continue;
+            }
+            return;  // EPIPE, EBADF, ...: the output is gone
+        }
+#else
+        int n = _write(fd, data, static_cast<unsigned int>(len));
+        if (n < 0) return;
+#endif
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+// Write all of `chunks`, one writev per round, and empty it.  The first
+// written-out block is kept in `spare` if that has none.
+static void write_chunks(int fd, std::deque<std::string>& chunks, std::string& spare) {
+#ifndef _WIN32
+    std::vector<struct iovec> iov;
+    while (!chunks.empty()) {
+        iov.clear();
+        for (size_t i = 0; i < chunks.size() && iov.size() < STD_MAX_IOV; ++i) {
+            iov.push_back({const_cast<char*>(chunks[i].data()), chunks[i].size()});
+        }
+        ssize_t n = ::writev(fd, iov.data(), static_cast<int>(iov.size()));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_writable(fd);
+                continue;
+            }
+            break;
+        }
+        size_t done = static_cast<size_t>(n);
+        while (!chunks.empty() && done >= chunks.front().size()) {
+            done -= chunks.front().size();
+            if (chunks.front().capacity() >= STD_BLOCK_SIZE && spare.capacity() < STD_BLOCK_SIZE) {
+                spare = std::move(chunks.front());
+                spare.clear();
+            }
+            chunks.pop_front();
+        }
+        if (done > 0) chunks.front().erase(0, done);
+    }
+#else
+    (void)spare;
+    for (const std::string& c : chunks) write_raw(fd, c.data(), c.size());
+#endif
+    chunks.clear();
+}
+
+static void writer_main(StdSink* s) {
+    std::unique_lock<std::mutex> lk(g_out_mutex);
+    for (;;) {
+        s->has_work->wait(lk, [s] { return !s->chunks.empty(); });
+        std::deque<std::string> out;
+        out.swap(s->chunks);
+        s->tail_open = false;
+        size_t len = 0;
+        for (const std::string& c : out) len += c.size();
+        std::string spare;
+        s->writing = true;
+
+        lk.unlock();
+        write_chunks(s->fd, out, spare);
+        lk.lock();
+
+        s->writing = false;
+        s->bytes -= len;
+        if (s->spare.capacity() < spare.capacity()) s->spare = std::move(spare);
+        if (s->chunks.empty()) {
+            s->idle->notify_all();
+            if (s->wake && !s->waiters.empty()) uv_async_send(s->wake);
+        }
+    }
+}
+
+#ifndef _WIN32
+// A forked child has no writer threads; it writes for itself.
+static void std_output_atfork_prepare() { g_out_mutex.lock(); }
+static void std_output_atfork_parent() { g_out_mutex.unlock(); }
+static void std_output_atfork_child() {
+    for (StdSink& s : g_sinks) {
+        s.writer = false;
+        s.writing = false;
+    }
+    g_out_mutex.unlock();
+}
+#endif
+
+// Give a pipe or socket fd its writer thread.  Terminals and files keep
+// plain blocking writes on the caller's thread.
+static bool use_writer_locked(StdSink& s) {
+    if (s.writer) return true;
+    if (s.pollable < 0) {
+        uv_handle_type type = uv_guess_handle(s.fd);
+        s.pollable = type == UV_NAMED_PIPE || type == UV_TCP ? 1 : 0;
+    }
+    if (!s.pollable) return false;
+#ifndef _WIN32
+    static bool atfork_installed = false;
+    if (!atfork_installed) {
+        pthread_atfork(std_output_atfork_prepare, std_output_atfork_parent, std_output_atfork_child);
+        atfork_installed = true;
+    }
+#endif
+    if (!s.has_work) {
+        s.has_work = new std::condition_variable;
+        s.idle = new std::condition_variable;
+    }
+    std::thread(writer_main, &s).detach();
+    s.writer = true;
+    return true;
+}
+
+// Block until everything queued on `s` has reached the kernel.
+static void drain_locked(StdSink& s, std::unique_lock<std::mutex>& lk) {
+    if (s.writer) {
+        if (!s.chunks.empty()) s.has_work->notify_one();
+        s.idle->wait(lk, [&s] { return s.chunks.empty() && !s.writing; });
+        return;
+    }
+    write_chunks(s.fd, s.chunks, s.spare);
+    s.bytes = 0;
+    s.tail_open = false;
+}
+
+static bool busy_locked(const StdSink& s) {
+    return s.writing || !s.chunks.empty();
+}
+
+static void release_waiters_locked(StdSink& s, StdWaiters& done) {
+    for (auto& fn : s.waiters) done.push_back(std::move(fn));
+    s.waiters.clear();
+}
+
+static void on_std_wake(uv_async_t* handle) {
+    StdSink& s = *static_cast<StdSink*>(handle->data);
+    StdWaiters done;
+    {
+        std::lock_guard<std::mutex> lk(g_out_mutex);
+        if (!busy_locked(s)) release_waiters_locked(s, done);
+    }
+    run_waiters(done);
+}
+
+// Main thread only: a handle on the current loop through which the writer
+// reports that it has caught up.
+static bool attach_wake_locked(StdSink& s) {
+    if (s.wake) return true;
+    if (!on_main_thread()) return false;
+    uv_loop_t* loop = scheduler_get_loop();
+    if (!loop) return false;
+    auto* wake = new uv_async_t;
+    uv_async_init(loop, wake, on_std_wake);
+    wake->data = &s;
+    uv_unref(reinterpret_cast<uv_handle_t*>(wake));
+    s.loop = loop;
+    s.wake = wake;
+    return true;
+}
+
+// Flush without holding up a loop: pipes and sockets go to their writer,
+// terminals and files are written here.
+static void flush_soon_locked(StdSink& s, std::unique_lock<std::mutex>& lk, StdWaiters& done) {
+    if (use_writer_locked(s)) {
+        if (!s.chunks.empty()) s.has_work->notify_one();
+        if (!busy_locked(s)) release_waiters_locked(s, done);
+        return;
+    }
+    drain_locked(s, lk);
+    release_waiters_locked(s, done);
+}
+
+// Queue `len` bytes; `owned` may be moved from instead of copying `data`.
+// True when an end-of-tick flush should be scheduled.
+static bool append_locked(StdSink& s, std::unique_lock<std::mutex>& lk, const char* data, size_t len,
+    std::string* owned, StdWaiters& done) {
+    StdBuffering mode = effective_mode(s);
+    if (mode == StdBuffering::None && !use_writer_locked(s)) {
+        if (!s.chunks.empty()) drain_locked(s, lk);
+        write_raw(s.fd, data, len);
+        return false;
+    }
+
+    bool newline = mode == StdBuffering::Line && memchr(data, '\n', len) != nullptr;
+    if (len >= STD_OWN_CHUNK) {
+        if (owned)
+            s.chunks.push_back(std::move(*owned));
+        else
+            s.chunks.emplace_back(data, len);
+        s.tail_open = false;
+    } else {
+        if (!s.tail_open) {
+            s.chunks.push_back(std::move(s.spare));
+            s.spare = std::string();
+            s.chunks.back().reserve(STD_BLOCK_SIZE);
+            s.tail_open = true;
+        }
+        s.chunks.back().append(data, len);
+    }
+    s.bytes += len;
+
+    if (mode == StdBuffering::None || s.bytes >= STD_BLOCK_SIZE || newline) {
+        flush_soon_locked(s, lk, done);
+        return false;
+    }
+    return true;
+}
+
+static void flush_at_exit() {
+    // A thread still printing while the process exits keeps its lock; its
+    // output is lost rather than the exit hanging.
+    std::unique_lock<std::mutex> lk(g_out_mutex, std::try_to_lock);
+    if (!lk.owns_lock()) return;
+    for (StdSink& s : g_sinks) drain_locked(s, lk);
+}
+
+static void write_impl(int fd, const char* data, size_t len, std::string* owned) {
+    StdSink* s = sink_for(fd);
+    if (!s) {
+        write_raw(fd, data, len);
+        return;
+    }
+    bool schedule;
+    StdWaiters done;
+    {
+        std::unique_lock<std::mutex> lk(g_out_mutex);
+        if (!g_atexit_installed) {
+            std::atexit(flush_at_exit);
+            g_atexit_installed = true;
+        }
+        schedule = append_locked(*s, lk, data, len, owned, done);
+        if (!schedule) t_flush_scheduled[fd - 1] = false;
+    }
+    run_waiters(done);
+    if (!schedule || t_flush_scheduled[fd - 1]) return;
+
+    // Without a loop loop_defer runs the flush here and now.
+    t_flush_scheduled[fd - 1] = true;
+    loop_defer([fd]() {
+        t_flush_scheduled[fd - 1] = false;
+        StdWaiters ready;
+        {
+            std::unique_lock<std::mutex> lk(g_out_mutex);
+            flush_soon_locked(*sink_for(fd), lk, ready);
+        }
+        run_waiters(ready);
+    });
+}
+
+void std_output_write(int fd, const char* data, size_t len) {
+    if (len == 0) return;
+    write_impl(fd, data, len, nullptr);
+}
+
+void std_output_write(int fd, std::string&& data) {
+    if (data.empty()) return;
+    write_impl(fd, data.data(), data.size(), &data);
+}
+
+void std_output_flush(int fd) {
+    bool main = on_main_thread();
+    StdWaiters done;
+    {
+        std::unique_lock<std::mutex> lk(g_out_mutex);
+        for (int f : {1, 2}) {
+            if (fd != -1 && fd != f) continue;
+            StdSink& s = *sink_for(f);
+            drain_locked(s, lk);
+            t_flush_scheduled[f - 1] = false;
+            if (main) release_waiters_locked(s, done);
+        }
+    }
+    run_waiters(done);
+}
+
+void std_output_flush_async(int fd, std::function<void()> done) {
+    StdSink* s = sink_for(fd);
+    StdWaiters ready;
+    {
+        std::unique_lock<std::mutex> lk(g_out_mutex);
+        if (s) {
+            flush_soon_locked(*s, lk, ready);
+            t_flush_scheduled[fd - 1] = false;
+        }
+        if (done) {
+            if (s && busy_locked(*s) && attach_wake_locked(*s))
+                s->waiters.push_back(std::move(done));
+            else
+                ready.push_back(std::move(done));
+        }
+    }
+    run_waiters(ready);
+}
+
+void std_output_loop_shutdown(uv_loop_t* loop) {
+    std::unique_lock<std::mutex> lk(g_out_mutex);
+    for (StdSink& s : g_sinks) {
+        if (!s.wake || s.loop != loop) continue;
+        drain_locked(s, lk);
+        uv_close(reinterpret_cast<uv_handle_t*>(s.wake), [](uv_handle_t* h) { delete reinterpret_cast<uv_async_t*>(h); });
+        s.loop = nullptr;
+        s.wake = nullptr;
+        s.waiters.clear();  // their loop is going away
+    }
+}
+
+// ---------- modes ----------
+
+void std_output_set_buffering(int fd, StdBuffering mode) {
+    StdSink* s = sink_for(fd);
+    if (!s) return;
+    StdWaiters done;
+    {
+        std::unique_lock<std::mutex> lk(g_out_mutex);
+        flush_soon_locked(*s, lk, done);
+        s->mode = mode;
+    }
+    run_waiters(done);
+}
+
+StdBuffering std_output_buffering(int fd) {
+    StdSink* s = sink_for(fd);
+    if (!s) return StdBuffering::None;
+    std::lock_guard<std::mutex> lk(g_out_mutex);
+    return effective_mode(*s);
+}
+
+size_t std_output_buffered(int fd) {
+    StdSink* s = sink_for(fd);
+    if (!s) return 0;
+    std::lock_guard<std::mutex> lk(g_out_mutex);
+    return s->bytes;
+}
+
+bool std_output_parse_buffering(const std::string& name, StdBuffering& out) {
+    if (name == "auto")
+        out = StdBuffering::Auto;
+    else if (name == "line")
+        out = StdBuffering::Line;
+    else if (name == "full")
+        out = StdBuffering::Full;
+    else if (name == "none")
+        out = StdBuffering::None;
+    else
+        return false;
+    return true;
+}
+
+const char* std_output_buffering_name(StdBuffering mode) {
+    switch (mode) {
+        case StdBuffering::Auto:
+            return "auto";
+        case StdBuffering::None:
+            return "none";
+        case StdBuffering::Line:
+            return "line";
+        case StdBuffering::Full:
+            return "full";
+    }
+    return "auto";
+}
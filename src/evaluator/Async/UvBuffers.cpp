@@ -0,0 +1,204 @@
+#include "UvBuffers.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "AsyncBridge.hpp"
+
+// ---------- read pool ----------
+
+// Slabs kept for reuse per thread; more than this in flight at once are freed
+// on release.  Reads are handed back before the next read on the same stream,
+// so this only bounds memory after a burst across many sockets.
+static constexpr size_t READ_POOL_MAX_FREE = 32;
+
+struct ReadPool {
+    std::vector<char*> free_slabs;
+    ~ReadPool() {
+        for (char* p : free_slabs) delete[] p;
+    }
+};
+
+static thread_local ReadPool t_read_pool;
+
+void read_pool_alloc(uv_handle_t*, size_t, uv_buf_t* buf) {
+    char* slab;
+    if (!t_read_pool.free_slabs.empty()) {
+        slab = t_read_pool.free_slabs.back();
+        t_read_pool.free_slabs.pop_back();
+    } else {
+        slab = new char[READ_POOL_SLAB_SIZE];
+    }
+    *buf = uv_buf_init(slab, static_cast<unsigned int>(READ_POOL_SLAB_SIZE));
+}
+
+void read_pool_release(const uv_buf_t* buf) {
+    if (!buf || !buf->base) return;
+    if (t_read_pool.free_slabs.size() < READ_POOL_MAX_FREE) {
+        t_read_pool.free_slabs.push_back(buf->base);
+    } else {
+        delete[] buf->base;
+    }
+}
+
+// ---------- gather writes ----------
+
+struct GatherWrite {
+    uv_write_t req;
+    std::vector<uv_buf_t> bufs;
+    std::vector<char> copy;  // remainder when there is no owner
+    std::shared_ptr<void> owner;
+    StreamWriteDone done;
+};
+
+bool stream_write_gather(uv_stream_t* stream, const uv_buf_t* bufs, unsigned int nbufs,
+    std::shared_ptr<void> owner, StreamWriteDone done) {
+    if (!stream || nbufs == 0) return true;
+
+    size_t total = 0;
+    for (unsigned int i = 0; i < nbufs; ++i) total += bufs[i].len;
+    if (total == 0) return true;
+
+    // Fails with UV_EAGAIN while earlier writes are still queued, which keeps
+    // bytes in order.
+    int r = uv_try_write(stream, bufs, nbufs);
+    size_t sent = r > 0 ? static_cast<size_t>(r) : 0;
+    if (sent == total) return true;
+
+    auto* w = new GatherWrite;
+    w->req.data = w;
+    w->done = std::move(done);
+
+    // Skip what uv_try_write took.
+    unsigned int first = 0;
+    size_t skip = sent;
+    while (first < nbufs && skip >= bufs[first].len) {
+        skip -= bufs[first].len;
+        ++first;
+    }
+
+    if (owner) {
+        w->owner = std::move(owner);
+        for (unsigned int i = first; i < nbufs; ++i) {
+            size_t off = i == first ? skip : 0;
+            if (bufs[i].len > off) w->bufs.push_back(uv_buf_init(bufs[i].base + off, static_cast<unsigned int>(bufs[i].len - off)));
+        }
+    } else {
+        w->copy.reserve(total - sent);
+        for (unsigned int i = first; i < nbufs; ++i) {
+            size_t off = i == first ? skip : 0;
+            w->copy.insert(w->copy.end(), bufs[i].base + off, bufs[i].base + bufs[i].len);
+        }
+        w->bufs.push_back(uv_buf_init(w->copy.data(), static_cast<unsigned int>(w->copy.size())));
+    }
+
+    int rc = uv_write(&w->req, stream, w->bufs.data(), static_cast<unsigned int>(w->bufs.size()), [](uv_write_t* req, int status) {
+        auto* w = static_cast<GatherWrite*>(req->data);
+        StreamWriteDone done = std::move(w->done);
+        delete w;
+        if (done) done(status);
+    });
+    if (rc != 0) {
+        // Refused outright (closed or broken stream): report it like a failed
+        // write, from the loop so the caller has seen the return value first.
+        StreamWriteDone failed = std::move(w->done);
+        delete w;
+        if (failed) loop_defer([failed, rc]() { failed(rc); });
+    }
+    return false;
+}
+
+// ---------- deferral ----------
+
+struct LoopDefer {
+    uv_loop_t* loop = nullptr;
+    uv_idle_t* idle = nullptr;
+    std::vector<std::function<void()>> pending;
+};
+
+static thread_local LoopDefer t_defer;
+
+static void loop_defer_idle_cb(uv_idle_t* handle) {
+    uv_idle_stop(handle);
+    std::vector<std::function<void()>> fns;
+    fns.swap(t_defer.pending);
+    for (auto& fn : fns) {
+        if (fn) fn();
+    }
+}
+
+void loop_defer(std::function<void()> fn) {
+    if (!fn) return;
+    uv_loop_t* loop = scheduler_get_loop();
+    if (!loop) {
+        fn();
+        return;
+    }
+    if (t_defer.loop != loop) {
+        // First use on this thread (or the loop was replaced).
+        t_defer.loop = loop;
+        t_defer.idle = new uv_idle_t;
+        uv_idle_init(loop, t_defer.idle);
+    }
+    t_defer.pending.push_back(std::move(fn));
+    if (!uv_is_active(reinterpret_cast<uv_handle_t*>(t_defer.idle))) {
+        uv_idle_start(t_defer.idle, loop_defer_idle_cb);
+    }
+}
+
+// ---------- cork ----------
+
+void StreamCork::commit() {
+    if (pending.size() >= limit_) {
+        flush();
+        return;
+    }
+    if (scheduled_ || pending.empty()) return;
+    scheduled_ = true;
+    std::weak_ptr<StreamCork> weak = shared_from_this();
+    loop_defer([weak]() {
+        std::shared_ptr<StreamCork> self = weak.lock();
+        if (!self) return;
+        self->scheduled_ = false;
+        self->flush();
+    });
+}
+
+void StreamCork::flush() {
+    if (pending.empty()) return;
+    if (!stream_) {
+        pending.clear();
+        return;
+    }
+    auto out = std::make_shared<std::vector<uint8_t>>();
+    out->swap(pending);
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(out->data()), static_cast<unsigned int>(out->size()));
+    StreamWriteDone done;
+    if (written) {
+        std::weak_ptr<StreamCork> weak = shared_from_this();
+        done = [weak](int status) {
+            std::shared_ptr<StreamCork> self = weak.lock();
+            if (self && self->written) self->written(status);
+        };
+    }
+    if (stream_write_gather(stream_, &buf, 1, std::move(out), std::move(done)) && written) written(0);
+}
+
+size_t StreamCork::buffered() const {
+    return pending.size() + (stream_ ? uv_stream_get_write_queue_size(stream_) : 0);
+}
+
+void StreamCork::detach() {
+    stream_ = nullptr;
+    pending.clear();
+}
+
+void loop_defer_shutdown(uv_loop_t* loop) {
+    if (!t_defer.idle || t_defer.loop != loop) return;
+    // Flush what is still deferred; callbacks may defer again, which is dropped.
+    loop_defer_idle_cb(t_defer.idle);
+    t_defer.pending.clear();
+    uv_close(reinterpret_cast<uv_handle_t*>(t_defer.idle), [](uv_handle_t* h) { delete reinterpret_cast<uv_idle_t*>(h); });
+    t_defer.idle = nullptr;
+    t_defer.loop = nullptr;
+}
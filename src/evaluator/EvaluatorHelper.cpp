@@ -612,7 +612,12 @@ Value Evaluator::get_object_property(ObjectPtr op, const std::string& prop, EnvP
 
     // --- Existing object semantics ---
     auto it = op->properties.find(prop);
-    if (it == op->properties.end()) return std::monostate{};
+    if (it == op->properties.end()) {
+        // Host-backed objects fill in their properties on first access.
+        if (!op->host || !op->host->resolve(*op, prop)) return std::monostate{};
+        it = op->properties.find(prop);
+        if (it == op->properties.end()) return std::monostate{};
+    }
 
     const PropertyDescriptor& desc = it->second;
 
@@ -702,8 +707,12 @@ void Evaluator::set_object_property(ObjectPtr op, const std::string& prop, const
 
     // --- Normal object property semantics ---
 
-    // If property exists, enforce permission/lock/private rules
+    // If property exists, enforce permission/lock/private rules.  A host-backed
+    // member not provided yet is resolved first so its rules apply too.
     auto it = op->properties.find(prop);
+    if (it == op->properties.end() && op->host && op->host->resolve(*op, prop)) {
+        it = op->properties.find(prop);
+    }
     if (it != op->properties.end()) {
         PropertyDescriptor& desc = it->second;
         if (desc.is_private && !is_private_access_allowed(op, accessorEnv)) {
@@ -868,6 +877,7 @@ static std::optional<std::string> try_render_inline_object(ObjectPtr o,
     if (!o) return std::string("{}");
     const ObjectValue* p = o.get();
     if (visited.count(p)) return std::string("{/*cycle*/}");
+    o->materialize();
 
     // Count visible properties and ensure they're all simple values (no nested objects/arrays/functions).
     std::vector<std::pair<std::string,
@@ -1676,6 +1686,7 @@ std::string Evaluator::print_object(
     // Decide inline vs expanded:
     auto should_inline = [&](ObjectPtr o) -> bool {
         if (!o) return true;
+        o->materialize();
         int visible = 0;
         for (const auto& kv : o->properties) {
             if (kv.second.is_private) continue;
@@ -1693,6 +1704,7 @@ std::string Evaluator::print_object(
         const ObjectValue* p = o.get();
         if (visited.count(p)) return "{/*cycle*/}";
         visited.insert(p);
+        o->materialize();
 
         // Count visible props and collect them in stable order
         std::vector<std::pair<std::string,
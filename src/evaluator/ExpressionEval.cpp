@@ -15,6 +15,7 @@
 #include "SwaziError.hpp"
 #include "evaluator.hpp"
 #include "proxy_class.hpp"
+#include "worker.hpp"
 
 namespace {
 
@@ -178,6 +179,300 @@ inline int32_t to_int32(double d) {
     return result;
 }
 
+// Parks `frame` on `p` under key `aid`: once `p` settles the result (or the
+// rejection) is stamped into frame->awaited_results / awaited_exceptions and
+// the frame is resumed from a microtask.  Always throws SuspendExecution.
+void Evaluator::suspend_frame_on_promise(CallFramePtr frame, PromisePtr p, size_t aid) {
+    auto make_eptr_from_value = [this](const Value& reason) -> std::exception_ptr {
+        try {
+            // Prefer to preserve string messages and Error-like objects.
+            if (std::holds_alternative<std::string>(reason)) {
+                throw std::runtime_error(std::get<std::string>(reason));
+            } else if (std::holds_alternative<ObjectPtr>(reason)) {
+                ObjectPtr o = std::get<ObjectPtr>(reason);
+                if (o) {
+                    auto it = o->properties.find("message");
+                    if (it != o->properties.end() && std::holds_alternative<std::string>(it->second.value)) {
+                        throw std::runtime_error(std::get<std::string>(it->second.value));
+                    }
+                    // fallback: attempt to stringify object
+                }
+                throw std::runtime_error(this->to_string_value(reason));
+            } else {
+                // fallback for numbers/bool/null/others
+                throw std::runtime_error(this->to_string_value(reason));
+            }
+        } catch (...) {
+            return std::current_exception();
+        }
+    };
+
+    // If promise already settled -> stamp result/exception and schedule resume
+    if (p->state == PromiseValue::State::FULFILLED) {
+        frame->awaited_results[aid] = p->result;
+
+        PromisePtr callPromise = frame->pending_promise;
+        std::weak_ptr<CallFrame> wf = frame;
+
+        if (scheduler()) {
+            scheduler()->enqueue_microtask([this, wf, callPromise]() {
+                auto f = wf.lock();
+                if (!f) return;
+
+                // Transfer ownership out of suspended_frames_ into call_stack_.
+                // Remove from suspended_frames_ first (if present), then push onto call stack.
+                this->remove_suspended_frame(f);
+
+                // Ensure the frame is on the call_stack_ before resuming.
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) {
+                    this->push_frame(f);
+                }
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {
+                    // swallow resume errors
+                }
+            });
+
+        } else {
+            auto f = wf.lock();
+            if (f) {
+                // non-scheduler mode: resume inline (transfer ownership)
+                this->remove_suspended_frame(f);
+
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) this->push_frame(f);
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {}
+            }
+        }
+
+        // Keep a shared owner while suspended so caller popping won't destroy the frame.
+        frame->is_suspended = true;
+        this->add_suspended_frame(frame);
+        pop_frame();
+        throw SuspendExecution();
+    }
+
+    if (p->state == PromiseValue::State::REJECTED) {
+        // Stamp exception into frame->awaited_exceptions[aid]
+        frame->awaited_exceptions[aid] = make_eptr_from_value(p->result);
+
+        // Mark the original promise as handled because the awaiting frame is going to
+        // take responsibility for the rejection when it resumes (this prevents the
+        // global unhandled-rejection check from reporting the original promise).
+        this->mark_promise_and_ancestors_handled(p);
+
+        PromisePtr callPromise = frame->pending_promise;
+        std::weak_ptr<CallFrame> wf = frame;
+
+        if (scheduler()) {
+            scheduler()->enqueue_microtask([this, wf, callPromise]() {
+                auto f = wf.lock();
+                if (!f) return;
+
+                this->remove_suspended_frame(f);
+
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) {
+                    this->push_frame(f);
+                }
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {}
+            });
+        } else {
+            auto f = wf.lock();
+            if (f) {
+                this->remove_suspended_frame(f);
+
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) this->push_frame(f);
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {}
+            }
+        }
+
+        frame->is_suspended = true;
+        this->add_suspended_frame(frame);
+        pop_frame();
+        throw SuspendExecution();
+    }
+
+    // Pending -> register then/catch callbacks that stamp resolution into frame->awaited_*[aid]
+    {
+        PromisePtr pcopy = p;
+        size_t captured_aid = aid;
+
+        // Mark the awaited promise as handled now that we're attaching handlers
+        // which will deliver the resolution/rejection into the awaiting frame.
+        if (pcopy) this->mark_promise_and_ancestors_handled(pcopy);
+
+        pcopy->then_callbacks.push_back([this, wf = std::weak_ptr<CallFrame>(frame), captured_aid](Value res) {
+            auto f_locked = wf.lock();
+            if (!f_locked) return;
+
+            f_locked->awaited_results[captured_aid] = res;
+            PromisePtr callPromise = f_locked->pending_promise;
+
+            // Schedule microtask to resume: the microtask will transfer ownership back and resume.
+            if (scheduler()) {
+                scheduler()->enqueue_microtask([this, wf, callPromise]() {
+                    auto f = wf.lock();
+                    if (!f) return;
+
+                    this->remove_suspended_frame(f);
+
+                    bool present = false;
+                    for (auto& ff : this->call_stack_) {
+                        if (ff == f) {
+                            present = true;
+                            break;
+                        }
+                    }
+                    if (!present) this->push_frame(f);
+
+                    f->is_suspended = false;
+                    try {
+                        execute_frame_until_await_or_return(f, callPromise);
+                    } catch (...) {}
+                });
+            } else {
+                auto f = wf.lock();
+                if (!f) return;
+
+                this->remove_suspended_frame(f);
+
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) this->push_frame(f);
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {}
+            }
+        });
+
+        pcopy->catch_callbacks.push_back([this, wf = std::weak_ptr<CallFrame>(frame), captured_aid](Value reason) {
+            auto f_locked = wf.lock();
+            if (!f_locked) return;
+
+            // Stamp exception into f_locked->awaited_exceptions[captured_aid]
+            std::exception_ptr eptr;
+            try {
+                if (std::holds_alternative<std::string>(reason)) {
+                    throw std::runtime_error(std::get<std::string>(reason));
+                } else if (std::holds_alternative<ObjectPtr>(reason)) {
+                    ObjectPtr o = std::get<ObjectPtr>(reason);
+                    if (o) {
+                        auto it = o->properties.find("message");
+                        if (it != o->properties.end() && std::holds_alternative<std::string>(it->second.value)) {
+                            throw std::runtime_error(std::get<std::string>(it->second.value));
+                        }
+                    }
+                    throw std::runtime_error(this->to_string_value(reason));
+                } else {
+                    throw std::runtime_error(this->to_string_value(reason));
+                }
+            } catch (...) {
+                eptr = std::current_exception();
+            }
+            f_locked->awaited_exceptions[captured_aid] = eptr;
+
+            PromisePtr callPromise = f_locked->pending_promise;
+
+            if (scheduler()) {
+                scheduler()->enqueue_microtask([this, wf, callPromise]() {
+                    auto f = wf.lock();
+                    if (!f) return;
+
+                    this->remove_suspended_frame(f);
+
+                    bool present = false;
+                    for (auto& ff : this->call_stack_) {
+                        if (ff == f) {
+                            present = true;
+                            break;
+                        }
+                    }
+                    if (!present) this->push_frame(f);
+
+                    f->is_suspended = false;
+                    try {
+                        execute_frame_until_await_or_return(f, callPromise);
+                    } catch (...) {}
+                });
+            } else {
+                auto f = wf.lock();
+                if (!f) return;
+
+                this->remove_suspended_frame(f);
+
+                bool present = false;
+                for (auto& ff : this->call_stack_) {
+                    if (ff == f) {
+                        present = true;
+                        break;
+                    }
+                }
+                if (!present) this->push_frame(f);
+
+                f->is_suspended = false;
+                try {
+                    execute_frame_until_await_or_return(f, callPromise);
+                } catch (...) {}
+            }
+        });
+
+        // Suspend current frame: store it in suspended_frames_ and pop it from the active call stack.
+        frame->is_suspended = true;
+        this->add_suspended_frame(frame);
+        pop_frame();
+        throw SuspendExecution();
+    }
+}
+
 Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
     if (!expr) return std::monostate{};
 
@@ -277,29 +572,6 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
             }
             return nullptr;
         };
-        auto make_eptr_from_value = [this](const Value& reason) -> std::exception_ptr {
-            try {
-                // Prefer to preserve string messages and Error-like objects.
-                if (std::holds_alternative<std::string>(reason)) {
-                    throw std::runtime_error(std::get<std::string>(reason));
-                } else if (std::holds_alternative<ObjectPtr>(reason)) {
-                    ObjectPtr o = std::get<ObjectPtr>(reason);
-                    if (o) {
-                        auto it = o->properties.find("message");
-                        if (it != o->properties.end() && std::holds_alternative<std::string>(it->second.value)) {
-                            throw std::runtime_error(std::get<std::string>(it->second.value));
-                        }
-                        // fallback: attempt to stringify object
-                    }
-                    throw std::runtime_error(this->to_string_value(reason));
-                } else {
-                    // fallback for numbers/bool/null/others
-                    throw std::runtime_error(this->to_string_value(reason));
-                }
-            } catch (...) {
-                return std::current_exception();
-            }
-        };
 
         PromisePtr p = extract_promise_from_value_local(operand);
 
@@ -322,270 +594,7 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
         // store promise reference by numeric id
         frame->awaited_promises[aid] = p;
 
-        // If promise already settled -> stamp result/exception and schedule resume
-        if (p->state == PromiseValue::State::FULFILLED) {
-            frame->awaited_results[aid] = p->result;
-
-            PromisePtr callPromise = frame->pending_promise;
-            std::weak_ptr<CallFrame> wf = frame;
-
-            if (scheduler()) {
-                scheduler()->enqueue_microtask([this, wf, callPromise]() {
-                    auto f = wf.lock();
-                    if (!f) return;
-
-                    // Transfer ownership out of suspended_frames_ into call_stack_.
-                    // Remove from suspended_frames_ first (if present), then push onto call stack.
-                    this->remove_suspended_frame(f);
-
-                    // Ensure the frame is on the call_stack_ before resuming.
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) {
-                        this->push_frame(f);
-                    }
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {
-                        // swallow resume errors
-                    }
-                });
-
-            } else {
-                auto f = wf.lock();
-                if (f) {
-                    // non-scheduler mode: resume inline (transfer ownership)
-                    this->remove_suspended_frame(f);
-
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) this->push_frame(f);
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {}
-                }
-            }
-
-            // Keep a shared owner while suspended so caller popping won't destroy the frame.
-            frame->is_suspended = true;
-            this->add_suspended_frame(frame);
-            pop_frame();
-            throw SuspendExecution();
-        }
-
-        if (p->state == PromiseValue::State::REJECTED) {
-            // Stamp exception into frame->awaited_exceptions[aid]
-            frame->awaited_exceptions[aid] = make_eptr_from_value(p->result);
-
-            // Mark the original promise as handled because the awaiting frame is going to
-            // take responsibility for the rejection when it resumes (this prevents the
-            // global unhandled-rejection check from reporting the original promise).
-            this->mark_promise_and_ancestors_handled(p);
-
-            PromisePtr callPromise = frame->pending_promise;
-            std::weak_ptr<CallFrame> wf = frame;
-
-            if (scheduler()) {
-                scheduler()->enqueue_microtask([this, wf, callPromise]() {
-                    auto f = wf.lock();
-                    if (!f) return;
-
-                    this->remove_suspended_frame(f);
-
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) {
-                        this->push_frame(f);
-                    }
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {}
-                });
-            } else {
-                auto f = wf.lock();
-                if (f) {
-                    this->remove_suspended_frame(f);
-
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) this->push_frame(f);
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {}
-                }
-            }
-
-            frame->is_suspended = true;
-            this->add_suspended_frame(frame);
-            pop_frame();
-            throw SuspendExecution();
-        }
-
-        // Pending -> register then/catch callbacks that stamp resolution into frame->awaited_*[aid]
-        {
-            PromisePtr pcopy = p;
-            size_t captured_aid = aid;
-
-            // Mark the awaited promise as handled now that we're attaching handlers
-            // which will deliver the resolution/rejection into the awaiting frame.
-            if (pcopy) this->mark_promise_and_ancestors_handled(pcopy);
-
-            pcopy->then_callbacks.push_back([this, wf = std::weak_ptr<CallFrame>(frame), captured_aid](Value res) {
-                auto f_locked = wf.lock();
-                if (!f_locked) return;
-
-                f_locked->awaited_results[captured_aid] = res;
-                PromisePtr callPromise = f_locked->pending_promise;
-
-                // Schedule microtask to resume: the microtask will transfer ownership back and resume.
-                if (scheduler()) {
-                    scheduler()->enqueue_microtask([this, wf, callPromise]() {
-                        auto f = wf.lock();
-                        if (!f) return;
-
-                        this->remove_suspended_frame(f);
-
-                        bool present = false;
-                        for (auto& ff : this->call_stack_) {
-                            if (ff == f) {
-                                present = true;
-                                break;
-                            }
-                        }
-                        if (!present) this->push_frame(f);
-
-                        f->is_suspended = false;
-                        try {
-                            execute_frame_until_await_or_return(f, callPromise);
-                        } catch (...) {}
-                    });
-                } else {
-                    auto f = wf.lock();
-                    if (!f) return;
-
-                    this->remove_suspended_frame(f);
-
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) this->push_frame(f);
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {}
-                }
-            });
-
-            pcopy->catch_callbacks.push_back([this, wf = std::weak_ptr<CallFrame>(frame), captured_aid](Value reason) {
-                auto f_locked = wf.lock();
-                if (!f_locked) return;
-
-                // Stamp exception into f_locked->awaited_exceptions[captured_aid]
-                std::exception_ptr eptr;
-                try {
-                    if (std::holds_alternative<std::string>(reason)) {
-                        throw std::runtime_error(std::get<std::string>(reason));
-                    } else if (std::holds_alternative<ObjectPtr>(reason)) {
-                        ObjectPtr o = std::get<ObjectPtr>(reason);
-                        if (o) {
-                            auto it = o->properties.find("message");
-                            if (it != o->properties.end() && std::holds_alternative<std::string>(it->second.value)) {
-                                throw std::runtime_error(std::get<std::string>(it->second.value));
-                            }
-                        }
-                        throw std::runtime_error(this->to_string_value(reason));
-                    } else {
-                        throw std::runtime_error(this->to_string_value(reason));
-                    }
-                } catch (...) {
-                    eptr = std::current_exception();
-                }
-                f_locked->awaited_exceptions[captured_aid] = eptr;
-
-                PromisePtr callPromise = f_locked->pending_promise;
-
-                if (scheduler()) {
-                    scheduler()->enqueue_microtask([this, wf, callPromise]() {
-                        auto f = wf.lock();
-                        if (!f) return;
-
-                        this->remove_suspended_frame(f);
-
-                        bool present = false;
-                        for (auto& ff : this->call_stack_) {
-                            if (ff == f) {
-                                present = true;
-                                break;
-                            }
-                        }
-                        if (!present) this->push_frame(f);
-
-                        f->is_suspended = false;
-                        try {
-                            execute_frame_until_await_or_return(f, callPromise);
-                        } catch (...) {}
-                    });
-                } else {
-                    auto f = wf.lock();
-                    if (!f) return;
-
-                    this->remove_suspended_frame(f);
-
-                    bool present = false;
-                    for (auto& ff : this->call_stack_) {
-                        if (ff == f) {
-                            present = true;
-                            break;
-                        }
-                    }
-                    if (!present) this->push_frame(f);
-
-                    f->is_suspended = false;
-                    try {
-                        execute_frame_until_await_or_return(f, callPromise);
-                    } catch (...) {}
-                }
-            });
-
-            // Suspend current frame: store it in suspended_frames_ and pop it from the active call stack.
-            frame->is_suspended = true;
-            this->add_suspended_frame(frame);
-            pop_frame();
-            throw SuspendExecution();
-        }
+        suspend_frame_on_promise(frame, p, aid);
     }
 
     if (auto y = dynamic_cast<YieldExpressionNode*>(expr)) {
@@ -755,6 +764,7 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
                 ObjectPtr src = std::get<ObjectPtr>(val);
                 if (!src) continue;
 
+                src->materialize();
                 for (const auto& kv : src->properties) {
                     obj->properties[kv.first] = kv.second;  // copy descriptor
                 }
@@ -4636,7 +4646,8 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
                 prop == "ongezaMwanzo" || prop == "ingiza" || prop == "slesi" || prop == "clear" ||
                 prop == "badili" || prop == "tafuta" || prop == "find" || prop == "kuna" || prop == "panga" ||
                 prop == "geuza" || prop == "chambua" || prop == "punguza" ||
-                prop == "unganisha" || prop == "ondoaZote" || prop == "pachika" || prop == "kwaKila" || prop == "forEach" || prop == "fill" || prop == "every" || prop == "some" || prop == "baadhi") {
+                prop == "unganisha" || prop == "ondoaZote" || prop == "pachika" || prop == "kwaKila" || prop == "forEach" || prop == "fill" || prop == "every" || prop == "some" || prop == "baadhi" ||
+                prop == "pmap" || prop == "pfilter" || prop == "preduce") {
                 auto native_impl = [this, arr, prop](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
                     if (!arr) return std::monostate{};
 
@@ -4917,6 +4928,11 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
                         return Value{out};
                     }
 
+                    // pmap / pfilter / preduce — chunked across worker threads (worker.cc)
+                    if (prop == "pmap") return parallel_array_op(ParallelOp::Map, arr, args, this, callEnv, token);
+                    if (prop == "pfilter") return parallel_array_op(ParallelOp::Filter, arr, args, this, callEnv, token);
+                    if (prop == "preduce") return parallel_array_op(ParallelOp::Reduce, arr, args, this, callEnv, token);
+
                     // forEach : kwaKila(fn)
                     if (prop == "kwaKila" || prop == "forEach") {
                         if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0])) {
@@ -5110,6 +5126,7 @@ Value Evaluator::evaluate_expression(ExpressionNode* expr, EnvPtr env) {
             const std::string& prop = mem->property;
 
             if (prop == "__proto__") {
+                if (op) op->materialize();
                 auto obj = std::make_shared<ObjectValue>();
                 obj->properties["object_size"] = {Value(static_cast<double>(op ? op->properties.size() : 0)), false, false, true, Token()};
                 {
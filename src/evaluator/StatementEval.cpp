@@ -7,6 +7,7 @@
 
 #include "ClassRuntime.hpp"
 #include "Frame.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
 #include "evaluator.hpp"
 
@@ -378,10 +379,8 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
             out += to_string_value(evaluate_expression(ps->expressions[i].get(), env));
             if (i + 1 < ps->expressions.size()) out += " ";
         }
-        if (ps->newline)
-            std::cout << out << std::endl;
-        else
-            std::cout << out << std::flush;
+        if (ps->newline) out += '\n';
+        std_output_write(1, std::move(out));
         return;
     }
 
@@ -846,8 +845,6 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
 
     // --- ForInStatementNode (kwa kila) ---
     if (auto fin = dynamic_cast<ForInStatementNode*>(stmt)) {
-        Value iterableVal = evaluate_expression(fin->iterable.get(), env);
-
         // loop control owner
         LoopControl local_lc;
         LoopControl* loopCtrl = lc ? lc : &local_lc;
@@ -862,7 +859,13 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
         if (frame && frame->has_loop_state(loop_id)) {
             resuming = true;
             state = &frame->loop_states[loop_id];
-        } else if (frame) {
+        }
+
+        // The iterable is evaluated once per loop; a frame resuming mid-loop
+        // reuses it rather than running the expression again.
+        Value iterableVal = resuming ? state->iterable : evaluate_expression(fin->iterable.get(), env);
+
+        if (frame && !resuming) {
             // First entry - initialize state
             state = &frame->loop_states[loop_id];
             state->is_first_entry = true;
@@ -870,6 +873,7 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
             state->current_index = 0;
             state->range_position = 0;
             state->loop_env = std::make_shared<Environment>(env);
+            state->iterable = iterableVal;
         }
 
         // loopEnv holds iteration variables (valueVar/indexVar) and persists
@@ -1270,6 +1274,94 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
                 return;
             }
 
+            // Async iterator (a stream): `__async_iterator__` is a function
+            // returning the next item, a Promise of it, or null at the end.
+            // Items that are ready come back without suspending the frame.
+            auto ait_it = obj->properties.find("__async_iterator__");
+            if (ait_it != obj->properties.end() &&
+                std::holds_alternative<FunctionPtr>(ait_it->second.value)) {
+                FunctionPtr next_fn = std::get<FunctionPtr>(ait_it->second.value);
+                bool inAsync = frame && (frame->is_async || (frame->function && frame->function->is_async));
+                if (!inAsync || !state) {
+                    throw SwaziError("RuntimeError",
+                        "'kwa kila' over a stream must run inside an async function (kazi async).",
+                        fin->token.loc);
+                }
+                // Key for the pending pull in frame->awaited_*; parser-assigned
+                // await ids are small integers, so a node address cannot collide.
+                size_t aid = reinterpret_cast<size_t>(fin);
+
+                while (true) {
+                    if (!(resuming && state->body_env)) {
+                        Value item;
+                        auto res_it = frame->awaited_results.find(aid);
+                        auto ex_it = frame->awaited_exceptions.find(aid);
+                        if (res_it != frame->awaited_results.end()) {
+                            item = res_it->second;
+                            frame->awaited_results.erase(res_it);
+                            frame->awaited_promises.erase(aid);
+                        } else if (ex_it != frame->awaited_exceptions.end()) {
+                            std::exception_ptr ep = ex_it->second;
+                            frame->awaited_exceptions.erase(ex_it);
+                            frame->awaited_promises.erase(aid);
+                            frame->loop_states.erase(loop_id);
+                            std::rethrow_exception(ep);
+                        } else {
+                            item = call_function(next_fn, {}, env, fin->token);
+                            if (std::holds_alternative<PromisePtr>(item)) {
+                                PromisePtr p = std::get<PromisePtr>(item);
+                                frame->awaited_promises[aid] = p;
+                                suspend_frame_on_promise(frame, p, aid);
+                            }
+                        }
+                        if (std::holds_alternative<std::monostate>(item)) break;
+
+                        if (fin->valueVar) {
+                            loopEnv->values[fin->valueVar->name] = {item, false};
+                        }
+                        if (fin->indexVar) {
+                            loopEnv->values[fin->indexVar->name] = {static_cast<double>(state->current_index), false};
+                        }
+                        EnvPtr bodyEnv = std::make_shared<Environment>(loopEnv);
+                        if (fin->valueVar) bodyEnv->values[fin->valueVar->name] = {item, false};
+                        if (fin->indexVar) {
+                            bodyEnv->values[fin->indexVar->name] = {static_cast<double>(state->current_index), false};
+                        }
+                        state->body_env = bodyEnv;
+                        state->body_statement_index = 0;
+                        resuming = false;
+                    }
+
+                    EnvPtr bodyEnv = state->body_env;
+                    for (size_t j = 0; j < fin->body.size(); ++j) {
+                        if (resuming && j < state->body_statement_index) continue;
+
+                        evaluate_statement(fin->body[j].get(), bodyEnv, return_value, did_return, loopCtrl);
+                        state->body_statement_index = j + 1;
+
+                        if (did_return && *did_return) {
+                            frame->loop_states.erase(loop_id);
+                            return;
+                        }
+                        if (loopCtrl->did_break || loopCtrl->did_continue) break;
+                    }
+
+                    state->body_statement_index = 0;
+                    state->body_env = nullptr;
+                    state->current_index++;
+                    resuming = false;
+
+                    if (loopCtrl->did_break) {
+                        loopCtrl->did_break = false;
+                        break;
+                    }
+                    loopCtrl->did_continue = false;
+                }
+
+                frame->loop_states.erase(loop_id);
+                return;
+            }
+
             // Check if this is a generator object (has __generator__ property)
             auto gen_it = obj->properties.find("__generator__");
             if (gen_it != obj->properties.end() &&
@@ -1350,6 +1442,8 @@ void Evaluator::evaluate_statement(StatementNode* stmt, EnvPtr env, Value* retur
                 return;
             }
 
+            obj->materialize();
+
             // Snapshot keys on first entry
             if (!resuming && state) {
                 state->keys_snapshot.clear();
@@ -13,7 +13,9 @@
 #include "ClassRuntime.hpp"
 #include "Frame.hpp"
 #include "Scheduler.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
+#include "builtins.hpp"
 #include "evaluator.hpp"
 #include "globals.hpp"
 #include "muda_class.hpp"
@@ -138,7 +140,8 @@ static Value builtin_bool(const std::vector<Value>& args, EnvPtr env, const Toke
 
 static Value builtin_soma(const std::vector<Value>& args, EnvPtr env, const Token& tok) {
     std::string prompt = args.empty() ? "" : value_to_string(args[0]);
-    if (!prompt.empty()) std::cout << prompt;
+    std_output_write(1, std::move(prompt));
+    std_output_flush(1);
     std::string input;
     std::getline(std::cin, input);
     return input;  // return as string
@@ -238,6 +241,7 @@ static Value builtin_object_keys(const std::vector<Value>& args, EnvPtr env, con
     }
 
     // fallback: enumerate object properties map
+    obj->materialize();
     for (auto& pair : obj->properties) {
         arr->elements.push_back(pair.first);  // push key as string
     }
@@ -259,6 +263,7 @@ static Value builtin_object_values(const std::vector<Value>& args, EnvPtr env, c
         return arr;
     }
 
+    obj->materialize();
     for (auto& pair : obj->properties) {
         arr->elements.push_back(pair.second.value);
     }
@@ -283,6 +288,7 @@ static Value builtin_object_entries(const std::vector<Value>& args, EnvPtr env,
         return arr;
     }
 
+    obj->materialize();
     for (auto& pair : obj->properties) {
         auto entry = std::make_shared<ArrayValue>();
         entry->elements.push_back(pair.first);         // key
@@ -601,11 +607,13 @@ static Value builtin_cerr(const std::vector<Value>& args, EnvPtr env, const Toke
     return Value();
 }
 static Value builtin_print(const std::vector<Value>& args, EnvPtr env, const Token& tok) {
+    std::string out;
     for (int i = 0; i < args.size(); ++i) {
-        std::string msg = value_to_string(args[i]);
-        std::cout << msg << " ";
+        out += value_to_string(args[i]);
+        out += " ";
     }
-    std::cout << "\n";
+    out += "\n";
+    std_output_write(1, std::move(out));
     return Value();
 }
 static Value builtin_sleep(const std::vector<Value>& args, EnvPtr, const Token& tok) {
@@ -1848,4 +1856,5 @@ void init_globals(EnvPtr env, Evaluator* evaluator) {
     // End Promise runtime
     // -----------------------
     init_worker(env, evaluator);
+    init_scheduler_global(env, evaluator);
 }
\ No newline at end of file
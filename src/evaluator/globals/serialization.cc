@@ -1,10 +1,14 @@
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <unordered_map>
 #include <vector>
 
+#include "ClassRuntime.hpp"
 #include "SwaziError.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
+#include "swazi.hpp"
 
 #if defined(HAVE_LIBSODIUM)
 #include <sodium.h>
@@ -27,7 +31,13 @@ enum class SerializeType : uint8_t {
     RANGE = 0x09,
     HOLE = 0x0A,
     REFERENCE = 0x0B,  // For circular references
-    REGEX = 0x0C
+    REGEX = 0x0C,
+
+    // Structured clone only (see structured_clone_encode below)
+    MAP = 0x0D,      // bare MapStorage: count, then key/value pairs
+    SET = 0x0E,      // Set instance: count, then items
+    HASHMAP = 0x0F,  // collections.HashMap instance: count, then key/value pairs
+    INTEGER = 0x10   // integral number as zigzag varint
 };
 
 // Helper to write bytes
@@ -72,6 +82,20 @@ class ByteWriter {
         write_u32(static_cast<uint32_t>(bytes.size()));
         data.insert(data.end(), bytes.begin(), bytes.end());
     }
+
+    // LEB128 unsigned varint
+    void write_varint(uint64_t val) {
+        while (val >= 0x80) {
+            data.push_back(static_cast<uint8_t>(val | 0x80));
+            val >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(val));
+    }
+
+    void write_raw(const void* src, size_t n) {
+        const uint8_t* p = static_cast<const uint8_t*>(src);
+        data.insert(data.end(), p, p + n);
+    }
 };
 
 // Helper to read bytes
@@ -145,6 +169,16 @@ class ByteReader {
         pos += len;
         return bytes;
     }
+
+    uint64_t read_varint(const Token& token) {
+        uint64_t val = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = read_u8(token);
+            val |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return val;
+        }
+        throw SwaziError("DeserializeError", "Malformed varint", token.loc);
+    }
 };
 
 // Serialization context for tracking references
@@ -367,6 +401,7 @@ static void serialize_value(const Value& val, ByteWriter& writer, SerializeConte
         }
 
         const void* ptr = obj.get();
+        obj->materialize();
 
         // Check for circular reference
         if (ctx.has_object_ref(ptr)) {
@@ -608,6 +643,562 @@ static Value deserialize_value(ByteReader& reader, DeserializeContext& ctx,
     }
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Structured clone
+//
+// Compact binary codec shared by Worker messages and "advanced" process IPC.
+// It reuses the tag space above but differs from swazi.serialize:
+//   - lengths, counts and back-reference ids are varints;
+//   - every reference value (Array, Object, Buffer, DateTime, Regex, Map, Set,
+//     HashMap) receives an implicit id in encounter order, so shared subgraphs
+//     and cycles are written once and then as REFERENCE <id>;
+//   - no replacer/reviver and no integrity hash — this is a transport format.
+// ─────────────────────────────────────────────────────────────────────────────
+static const uint8_t SWAZI_CLONE_VERSION = 0xC1;
+
+struct CloneEncodeContext {
+    std::unordered_map<const void*, uint32_t> ids;
+    uint32_t next_id = 0;
+
+    // Writes a REFERENCE and returns true when ptr was already emitted;
+    // otherwise assigns the next id and returns false.
+    bool backref(const void* ptr, ByteWriter& writer) {
+        auto it = ids.find(ptr);
+        if (it != ids.end()) {
+            writer.write_u8(static_cast<uint8_t>(SerializeType::REFERENCE));
+            writer.write_varint(it->second);
+            return true;
+        }
+        ids.emplace(ptr, next_id++);
+        return false;
+    }
+};
+
+struct CloneDecodeContext {
+    std::vector<Value> refs;
+    Evaluator* evaluator = nullptr;
+};
+
+static bool clone_skips_property(const Value& v) {
+    return std::holds_alternative<FunctionPtr>(v) ||
+        std::holds_alternative<ClassPtr>(v) ||
+        std::holds_alternative<PromisePtr>(v) ||
+        std::holds_alternative<GeneratorPtr>(v) ||
+        std::holds_alternative<FilePtr>(v) ||
+        std::holds_alternative<ProxyPtr>(v);
+}
+
+static std::string clone_class_name(const ObjectPtr& obj) {
+    auto it = obj->properties.find("__class__");
+    if (it == obj->properties.end()) return std::string();
+    auto* cls = std::get_if<ClassPtr>(&it->second.value);
+    return (cls && *cls) ? (*cls)->name : std::string();
+}
+
+template <typename T>
+static T* clone_private_slot(const ObjectPtr& obj, const char* name) {
+    auto it = obj->properties.find(name);
+    if (it == obj->properties.end()) return nullptr;
+    return std::get_if<T>(&it->second.value);
+}
+
+static void clone_write_string(ByteWriter& writer, const std::string& str) {
+    writer.write_varint(str.size());
+    writer.write_raw(str.data(), str.size());
+}
+
+static std::string clone_read_string(ByteReader& reader, const Token& token) {
+    uint64_t len = reader.read_varint(token);
+    reader.check_available(len, token);
+    std::string str(reinterpret_cast<const char*>(reader.data + reader.pos), len);
+    reader.pos += len;
+    return str;
+}
+
+static void clone_encode_value(const Value& val, ByteWriter& writer, CloneEncodeContext& ctx, const Token& token);
+
+static void clone_encode_entries(const MapStorage& storage, ByteWriter& writer, CloneEncodeContext& ctx, const Token& token) {
+    writer.write_varint(storage.data.size());
+    for (const auto& kv : storage.data) {
+        clone_encode_value(kv.first, writer, ctx, token);
+        clone_encode_value(kv.second, writer, ctx, token);
+    }
+}
+
+static void clone_encode_value(const Value& val, ByteWriter& writer, CloneEncodeContext& ctx, const Token& token) {
+    if (std::holds_alternative<std::monostate>(val)) {
+        writer.write_u8(static_cast<uint8_t>(SerializeType::NULL_TYPE));
+        return;
+    }
+    if (auto* b = std::get_if<bool>(&val)) {
+        writer.write_u8(static_cast<uint8_t>(*b ? SerializeType::BOOL_TRUE : SerializeType::BOOL_FALSE));
+        return;
+    }
+    if (auto* d = std::get_if<double>(&val)) {
+        // Small integers (the common case for ids, counters, indices) go out as
+        // zigzag varints; everything else, including -0, keeps the raw double.
+        double n = *d;
+        if (n >= -2147483648.0 && n <= 2147483647.0 && n == static_cast<double>(static_cast<int64_t>(n)) &&
+            !(n == 0.0 && std::signbit(n))) {
+            int64_t i = static_cast<int64_t>(n);
+            writer.write_u8(static_cast<uint8_t>(SerializeType::INTEGER));
+            writer.write_varint((static_cast<uint64_t>(i) << 1) ^ static_cast<uint64_t>(i >> 63));
+        } else {
+            writer.write_u8(static_cast<uint8_t>(SerializeType::NUMBER));
+            writer.write_double(n);
+        }
+        return;
+    }
+    if (auto* s = std::get_if<std::string>(&val)) {
+        writer.write_u8(static_cast<uint8_t>(SerializeType::STRING));
+        clone_write_string(writer, *s);
+        return;
+    }
+    if (std::holds_alternative<HoleValue>(val)) {
+        writer.write_u8(static_cast<uint8_t>(SerializeType::HOLE));
+        return;
+    }
+    if (auto* r = std::get_if<RangePtr>(&val)) {
+        if (!*r) throw SwaziError("TypeError", "structured clone: null Range", token.loc);
+        writer.write_u8(static_cast<uint8_t>(SerializeType::RANGE));
+        writer.write_u32(static_cast<uint32_t>((*r)->start));
+        writer.write_u32(static_cast<uint32_t>((*r)->end));
+        writer.write_varint((*r)->step);
+        writer.write_u32(static_cast<uint32_t>((*r)->cur));
+        writer.write_u8(static_cast<uint8_t>(((*r)->inclusive ? 1 : 0) | ((*r)->increasing ? 2 : 0)));
+        return;
+    }
+    if (auto* b = std::get_if<BufferPtr>(&val)) {
+        if (!*b) throw SwaziError("TypeError", "structured clone: null Buffer", token.loc);
+        if (ctx.backref(b->get(), writer)) return;
+        writer.write_u8(static_cast<uint8_t>(SerializeType::BUFFER));
+        clone_write_string(writer, (*b)->encoding);
+        writer.write_varint((*b)->data.size());
+        writer.write_raw((*b)->data.data(), (*b)->data.size());
+        return;
+    }
+    if (auto* dtp = std::get_if<DateTimePtr>(&val)) {
+        if (!*dtp) throw SwaziError("TypeError", "structured clone: null DateTime", token.loc);
+        if (ctx.backref(dtp->get(), writer)) return;
+        const DateTimeValue& dt = **dtp;
+        writer.write_u8(static_cast<uint8_t>(SerializeType::DATETIME));
+        writer.write_u64(dt.epochNanoseconds);
+        writer.write_u32(static_cast<uint32_t>(dt.year));
+        writer.write_u8(static_cast<uint8_t>(dt.month));
+        writer.write_u8(static_cast<uint8_t>(dt.day));
+        writer.write_u8(static_cast<uint8_t>(dt.hour));
+        writer.write_u8(static_cast<uint8_t>(dt.minute));
+        writer.write_u8(static_cast<uint8_t>(dt.second));
+        writer.write_u32(dt.fractionalNanoseconds);
+        writer.write_u8(static_cast<uint8_t>(dt.precision));
+        writer.write_u32(static_cast<uint32_t>(dt.tzOffsetSeconds));
+        writer.write_u8(dt.isUTC ? 1 : 0);
+        clone_write_string(writer, dt.literalText);
+        return;
+    }
+    if (auto* rx = std::get_if<RegexPtr>(&val)) {
+        if (!*rx) throw SwaziError("TypeError", "structured clone: null Regex", token.loc);
+        if (ctx.backref(rx->get(), writer)) return;
+        writer.write_u8(static_cast<uint8_t>(SerializeType::REGEX));
+        clone_write_string(writer, (*rx)->pattern);
+        clone_write_string(writer, (*rx)->flags);
+        writer.write_varint((*rx)->lastIndex);
+        return;
+    }
+    if (auto* m = std::get_if<MapStoragePtr>(&val)) {
+        if (!*m) throw SwaziError("TypeError", "structured clone: null Map", token.loc);
+        if (ctx.backref(m->get(), writer)) return;
+        writer.write_u8(static_cast<uint8_t>(SerializeType::MAP));
+        clone_encode_entries(**m, writer, ctx, token);
+        return;
+    }
+    if (auto* a = std::get_if<ArrayPtr>(&val)) {
+        if (!*a) throw SwaziError("TypeError", "structured clone: null Array", token.loc);
+        if (ctx.backref(a->get(), writer)) return;
+        writer.write_u8(static_cast<uint8_t>(SerializeType::ARRAY));
+        writer.write_varint((*a)->elements.size());
+        for (const auto& el : (*a)->elements) {
+            // Functions inside arrays become null (same as swazi.serialize's replacer removal)
+            if (clone_skips_property(el)) {
+                writer.write_u8(static_cast<uint8_t>(SerializeType::NULL_TYPE));
+                continue;
+            }
+            clone_encode_value(el, writer, ctx, token);
+        }
+        return;
+    }
+    if (auto* o = std::get_if<ObjectPtr>(&val)) {
+        const ObjectPtr& obj = *o;
+        if (!obj) throw SwaziError("TypeError", "structured clone: null Object", token.loc);
+        if (obj->is_env_proxy)
+            throw SwaziError("TypeError", "structured clone: environment proxy objects are not transferable", token.loc);
+        if (ctx.backref(obj.get(), writer)) return;
+        obj->materialize();
+
+        // Builtin collections travel by content; the receiver re-links the class.
+        std::string cls = clone_class_name(obj);
+        if (cls == "Set") {
+            if (auto* items = clone_private_slot<ArrayPtr>(obj, "__items__"); items && *items) {
+                writer.write_u8(static_cast<uint8_t>(SerializeType::SET));
+                writer.write_varint((*items)->elements.size());
+                for (const auto& el : (*items)->elements) clone_encode_value(el, writer, ctx, token);
+                return;
+            }
+        } else if (cls == "HashMap") {
+            if (auto* storage = clone_private_slot<MapStoragePtr>(obj, "__map__"); storage && *storage) {
+                writer.write_u8(static_cast<uint8_t>(SerializeType::HASHMAP));
+                clone_encode_entries(**storage, writer, ctx, token);
+                return;
+            }
+        }
+
+        writer.write_u8(static_cast<uint8_t>(SerializeType::OBJECT));
+        writer.write_u8(obj->is_frozen ? 1 : 0);
+        size_t count = 0;
+        for (const auto& kv : obj->properties)
+            if (!clone_skips_property(kv.second.value)) ++count;
+        writer.write_varint(count);
+        for (const auto& kv : obj->properties) {
+            const PropertyDescriptor& pd = kv.second;
+            if (clone_skips_property(pd.value)) continue;
+            clone_write_string(writer, kv.first);
+            writer.write_u8(static_cast<uint8_t>((pd.is_private ? 1 : 0) | (pd.is_readonly ? 2 : 0) | (pd.is_locked ? 4 : 0)));
+            clone_encode_value(pd.value, writer, ctx, token);
+        }
+        return;
+    }
+
+    throw SwaziError("TypeError",
+        "structured clone: value type '" + _type_name(val) + "' is not transferable.", token.loc);
+}
+
+// Builds an empty instance of a builtin collection class in the receiving
+// interpreter by evaluating `unda <class>()` against it.  Falls back to a plain
+// object when there is no evaluator or the class cannot be resolved.
+static ObjectPtr clone_make_instance(Evaluator* evaluator, const std::string& class_name, const Token& token) {
+    if (!evaluator) return std::make_shared<ObjectValue>();
+
+    EnvPtr genv = evaluator->get_global_env();
+    ClassPtr cls;
+    try {
+        if (class_name == "Set") {
+            if (genv->has("Set")) {
+                if (auto* c = std::get_if<ClassPtr>(&genv->get("Set").value)) cls = *c;
+            }
+        } else {
+            ObjectPtr mod = evaluator->import_module_public("collections", token, genv);
+            if (mod) {
+                auto it = mod->properties.find(class_name);
+                if (it != mod->properties.end()) {
+                    if (auto* c = std::get_if<ClassPtr>(&it->second.value)) cls = *c;
+                }
+            }
+        }
+        if (!cls) return std::make_shared<ObjectValue>();
+
+        auto scope = std::make_shared<Environment>(genv);
+        scope->set("__clone_class__", Environment::Variable{cls, true});
+        NewExpressionNode ne;
+        ne.token = token;
+        auto callee = std::make_unique<IdentifierNode>();
+        callee->name = "__clone_class__";
+        callee->token = token;
+        ne.callee = std::move(callee);
+        Value inst = evaluator->evaluate_expression_public(&ne, scope);
+        if (auto* o = std::get_if<ObjectPtr>(&inst)) return *o;
+    } catch (const std::exception&) {
+        // unresolvable class — keep the data, drop the methods
+    }
+    return std::make_shared<ObjectValue>();
+}
+
+static Value clone_decode_value(ByteReader& reader, CloneDecodeContext& ctx, const Token& token);
+
+static void clone_decode_entries(ByteReader& reader, CloneDecodeContext& ctx, MapStorage& storage, const Token& token) {
+    uint64_t count = reader.read_varint(token);
+    for (uint64_t i = 0; i < count; ++i) {
+        Value k = clone_decode_value(reader, ctx, token);
+        Value v = clone_decode_value(reader, ctx, token);
+        storage.data[std::move(k)] = std::move(v);
+    }
+}
+
+static Value clone_decode_value(ByteReader& reader, CloneDecodeContext& ctx, const Token& token) {
+    uint8_t type_tag = reader.read_u8(token);
+
+    switch (static_cast<SerializeType>(type_tag)) {
+        case SerializeType::NULL_TYPE:
+            return std::monostate{};
+        case SerializeType::BOOL_TRUE:
+            return true;
+        case SerializeType::BOOL_FALSE:
+            return false;
+        case SerializeType::NUMBER:
+            return reader.read_double(token);
+        case SerializeType::INTEGER: {
+            uint64_t z = reader.read_varint(token);
+            int64_t i = static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+            return static_cast<double>(i);
+        }
+        case SerializeType::STRING:
+            return clone_read_string(reader, token);
+        case SerializeType::HOLE:
+            return HoleValue{};
+
+        case SerializeType::RANGE: {
+            auto range = std::make_shared<RangeValue>(0, 0);
+            range->start = static_cast<int>(reader.read_u32(token));
+            range->end = static_cast<int>(reader.read_u32(token));
+            range->step = static_cast<size_t>(reader.read_varint(token));
+            range->cur = static_cast<int>(reader.read_u32(token));
+            uint8_t flags = reader.read_u8(token);
+            range->inclusive = (flags & 1) != 0;
+            range->increasing = (flags & 2) != 0;
+            return Value{range};
+        }
+
+        case SerializeType::BUFFER: {
+            auto buf = std::make_shared<BufferValue>();
+            ctx.refs.push_back(Value{buf});
+            buf->encoding = clone_read_string(reader, token);
+            uint64_t len = reader.read_varint(token);
+            reader.check_available(len, token);
+            buf->data.assign(reader.data + reader.pos, reader.data + reader.pos + len);
+            reader.pos += len;
+            return Value{buf};
+        }
+
+        case SerializeType::DATETIME: {
+            auto dt = std::make_shared<DateTimeValue>();
+            ctx.refs.push_back(Value{dt});
+            dt->epochNanoseconds = reader.read_u64(token);
+            dt->year = static_cast<int>(reader.read_u32(token));
+            dt->month = static_cast<int>(reader.read_u8(token));
+            dt->day = static_cast<int>(reader.read_u8(token));
+            dt->hour = static_cast<int>(reader.read_u8(token));
+            dt->minute = static_cast<int>(reader.read_u8(token));
+            dt->second = static_cast<int>(reader.read_u8(token));
+            dt->fractionalNanoseconds = reader.read_u32(token);
+            dt->precision = static_cast<DateTimePrecision>(reader.read_u8(token));
+            dt->tzOffsetSeconds = static_cast<int32_t>(reader.read_u32(token));
+            dt->isUTC = reader.read_u8(token) != 0;
+            dt->literalText = clone_read_string(reader, token);
+            return Value{dt};
+        }
+
+        case SerializeType::REGEX: {
+            // id is reserved before the payload so ids stay in encounter order
+            size_t slot = ctx.refs.size();
+            ctx.refs.emplace_back();
+            std::string pattern = clone_read_string(reader, token);
+            std::string flags = clone_read_string(reader, token);
+            auto regex = std::make_shared<RegexValue>(pattern, flags);
+            regex->lastIndex = static_cast<size_t>(reader.read_varint(token));
+            ctx.refs[slot] = Value{regex};
+            return Value{regex};
+        }
+
+        case SerializeType::MAP: {
+            auto storage = std::make_shared<MapStorage>();
+            ctx.refs.push_back(Value{storage});
+            clone_decode_entries(reader, ctx, *storage, token);
+            return Value{storage};
+        }
+
+        case SerializeType::HASHMAP: {
+            ObjectPtr obj = clone_make_instance(ctx.evaluator, "HashMap", token);
+            ctx.refs.push_back(Value{obj});
+            auto storage = std::make_shared<MapStorage>();
+            clone_decode_entries(reader, ctx, *storage, token);
+            obj->properties["__map__"] = PropertyDescriptor{storage, true, false, false, Token{}};
+            return Value{obj};
+        }
+
+        case SerializeType::SET: {
+            ObjectPtr obj = clone_make_instance(ctx.evaluator, "Set", token);
+            ctx.refs.push_back(Value{obj});
+            auto items = std::make_shared<ArrayValue>();
+            uint64_t count = reader.read_varint(token);
+            items->elements.reserve(std::min<uint64_t>(count, reader.size - reader.pos));
+            for (uint64_t i = 0; i < count; ++i)
+                items->elements.push_back(clone_decode_value(reader, ctx, token));
+            obj->properties["__items__"] = PropertyDescriptor{items, true, false, false, Token{}};
+            return Value{obj};
+        }
+
+        case SerializeType::ARRAY: {
+            auto arr = std::make_shared<ArrayValue>();
+            ctx.refs.push_back(Value{arr});
+            uint64_t length = reader.read_varint(token);
+            // every element takes at least one byte — bound the reserve by what is left
+            arr->elements.reserve(std::min<uint64_t>(length, reader.size - reader.pos));
+            for (uint64_t i = 0; i < length; ++i)
+                arr->elements.push_back(clone_decode_value(reader, ctx, token));
+            return Value{arr};
+        }
+
+        case SerializeType::OBJECT: {
+            auto obj = std::make_shared<ObjectValue>();
+            ctx.refs.push_back(Value{obj});
+            bool frozen = reader.read_u8(token) != 0;
+            uint64_t count = reader.read_varint(token);
+            obj->properties.reserve(std::min<uint64_t>(count, reader.size - reader.pos));
+            for (uint64_t i = 0; i < count; ++i) {
+                std::string key = clone_read_string(reader, token);
+                uint8_t flags = reader.read_u8(token);
+                PropertyDescriptor pd;
+                pd.value = clone_decode_value(reader, ctx, token);
+                pd.is_private = (flags & 1) != 0;
+                pd.is_readonly = (flags & 2) != 0;
+                pd.is_locked = (flags & 4) != 0;
+                obj->properties[std::move(key)] = std::move(pd);
+            }
+            obj->is_frozen = frozen;
+            return Value{obj};
+        }
+
+        case SerializeType::REFERENCE: {
+            uint64_t id = reader.read_varint(token);
+            if (id >= ctx.refs.size() || std::holds_alternative<std::monostate>(ctx.refs[id])) {
+                throw SwaziError("DeserializeError", "Invalid reference ID: " + std::to_string(id), token.loc);
+            }
+            return ctx.refs[id];
+        }
+
+        default:
+            throw SwaziError("DeserializeError",
+                "Unknown type tag: " + std::to_string(type_tag), token.loc);
+    }
+}
+
+std::vector<uint8_t> structured_clone_encode(const Value& v, const Token& tok) {
+    ByteWriter writer;
+    CloneEncodeContext ctx;
+    writer.write_u8(SWAZI_CLONE_VERSION);
+    clone_encode_value(v, writer, ctx, tok);
+    return std::move(writer.data);
+}
+
+Value structured_clone_decode(const uint8_t* data, size_t len, Evaluator* evaluator, const Token& tok) {
+    ByteReader reader(data, len);
+    uint8_t version = reader.read_u8(tok);
+    if (version != SWAZI_CLONE_VERSION) {
+        throw SwaziError("DeserializeError",
+            "Unsupported structured clone version: " + std::to_string(version), tok.loc);
+    }
+    CloneDecodeContext ctx;
+    ctx.evaluator = evaluator;
+    Value result = clone_decode_value(reader, ctx, tok);
+    if (reader.pos != reader.size) {
+        throw SwaziError("DeserializeError",
+            "Unexpected data at end of structured clone (pos=" + std::to_string(reader.pos) +
+                ", size=" + std::to_string(reader.size) + ")",
+            tok.loc);
+    }
+    return result;
+}
+
+void structured_clone_frame_append(std::vector<uint8_t>& out, const Value& v, const Token& tok) {
+    // Encode in place at the end of `out`; a failed encode leaves it as it was.
+    ByteWriter writer;
+    writer.data.swap(out);
+    size_t start = writer.data.size();
+    try {
+        writer.write_u32(0);  // length placeholder
+        writer.write_u8(SWAZI_CLONE_VERSION);
+        CloneEncodeContext ctx;
+        clone_encode_value(v, writer, ctx, tok);
+        if (writer.data.size() - start - 4 > UINT32_MAX) {
+            throw SwaziError("RangeError", "structured clone: message too large for IPC frame", tok.loc);
+        }
+    } catch (...) {
+        writer.data.resize(start);
+        out.swap(writer.data);
+        throw;
+    }
+    uint32_t len = static_cast<uint32_t>(writer.data.size() - start - 4);
+    for (int i = 0; i < 4; ++i) writer.data[start + i] = static_cast<uint8_t>(len >> (8 * i));
+    out.swap(writer.data);
+}
+
+std::vector<uint8_t> structured_clone_frame(const Value& v, const Token& tok) {
+    std::vector<uint8_t> out;
+    structured_clone_frame_append(out, v, tok);
+    return out;
+}
+
+static uint32_t clone_frame_length(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Partial-frame storage above this is released once the frame completes, so
+// one large message does not pin its size for the life of the channel.
+static constexpr size_t CLONE_PENDING_KEEP = 1024 * 1024;
+// A length prefix above this is taken as a corrupt stream rather than a frame
+// to wait for.
+static constexpr uint32_t CLONE_MAX_FRAME = 256u * 1024 * 1024;
+
+static void clone_decode_frame(std::vector<Value>& out, const uint8_t* data, size_t len, Evaluator* evaluator, std::vector<std::string>* errors) {
+    try {
+        out.push_back(structured_clone_decode(data, len, evaluator));
+    } catch (const std::exception& e) {
+        if (errors) errors->push_back(e.what());
+    }
+}
+
+static bool clone_frame_too_large(uint32_t frame_len, std::vector<std::string>* errors) {
+    if (frame_len <= CLONE_MAX_FRAME) return false;
+    if (errors) errors->push_back("frame length " + std::to_string(frame_len) + " exceeds the limit; discarding buffered input");
+    return true;
+}
+
+std::vector<Value> structured_clone_unframe(std::vector<uint8_t>& pending, const uint8_t* data, size_t len, Evaluator* evaluator, std::vector<std::string>* errors) {
+    std::vector<Value> out;
+
+    // Finish the frame carried over from the last read, taking only the bytes
+    // it still needs.
+    if (!pending.empty()) {
+        if (pending.size() < 4) {
+            size_t take = std::min(len, 4 - pending.size());
+            pending.insert(pending.end(), data, data + take);
+            data += take;
+            len -= take;
+            if (pending.size() < 4) return out;
+        }
+        uint32_t frame_len = clone_frame_length(pending.data());
+        if (clone_frame_too_large(frame_len, errors)) {
+            std::vector<uint8_t>().swap(pending);
+            return out;
+        }
+        size_t need = 4 + static_cast<size_t>(frame_len) - pending.size();
+        size_t take = std::min(len, need);
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        len -= take;
+        if (take < need) return out;
+        clone_decode_frame(out, pending.data() + 4, pending.size() - 4, evaluator, errors);
+        if (pending.capacity() > CLONE_PENDING_KEEP) {
+            std::vector<uint8_t>().swap(pending);
+        } else {
+            pending.clear();
+        }
+    }
+
+    // Whole frames decode straight from the read buffer.  A frame that fails
+    // to decode is skipped; its length prefix still says where the next starts.
+    while (len >= 4) {
+        uint32_t frame_len = clone_frame_length(data);
+        if (clone_frame_too_large(frame_len, errors)) return out;
+        if (len - 4 < frame_len) break;
+        clone_decode_frame(out, data + 4, frame_len, evaluator, errors);
+        data += 4 + static_cast<size_t>(frame_len);
+        len -= 4 + static_cast<size_t>(frame_len);
+    }
+    pending.insert(pending.end(), data, data + len);
+    return out;
+}
+
 // Main serialize function
 std::shared_ptr<ObjectValue> make_serialization_exports(EnvPtr env, Evaluator* evaluator) {
     auto obj = std::make_shared<ObjectValue>();
@@ -833,5 +1424,61 @@ std::shared_ptr<ObjectValue> make_serialization_exports(EnvPtr env, Evaluator* e
         obj->properties["equals"] = PropertyDescriptor{fn_value, false, false, false, tok};
     }
 
+    // swazi.structuredClone(value) -> deep copy via the structured clone codec.
+    // Unlike clone(), shared references and cycles are preserved and Set /
+    // HashMap instances come back as working instances.
+    {
+        auto fn = [evaluator](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty()) {
+                throw SwaziError("TypeError", "swazi.structuredClone requires a value argument", token.loc);
+            }
+            std::vector<uint8_t> bytes = structured_clone_encode(args[0], token);
+            return structured_clone_decode(bytes.data(), bytes.size(), evaluator, token);
+        };
+
+        Token tok;
+        tok.type = TokenType::IDENTIFIER;
+        tok.loc = TokenLocation("<serialization>", 0, 0, 0);
+        auto fn_value = std::make_shared<FunctionValue>("swazi.structuredClone", fn, env, tok);
+        obj->properties["structuredClone"] = PropertyDescriptor{fn_value, false, false, false, tok};
+    }
+
+    // swazi.structuredEncode(value) -> Buffer
+    {
+        auto fn = [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty()) {
+                throw SwaziError("TypeError", "swazi.structuredEncode requires a value argument", token.loc);
+            }
+            auto buffer = std::make_shared<BufferValue>();
+            std::vector<uint8_t> bytes = structured_clone_encode(args[0], token);
+            buffer->data.assign(bytes.begin(), bytes.end());
+            buffer->encoding = "binary";
+            return buffer;
+        };
+
+        Token tok;
+        tok.type = TokenType::IDENTIFIER;
+        tok.loc = TokenLocation("<serialization>", 0, 0, 0);
+        auto fn_value = std::make_shared<FunctionValue>("swazi.structuredEncode", fn, env, tok);
+        obj->properties["structuredEncode"] = PropertyDescriptor{fn_value, false, false, false, tok};
+    }
+
+    // swazi.structuredDecode(buffer) -> value
+    {
+        auto fn = [evaluator](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty() || !std::holds_alternative<BufferPtr>(args[0])) {
+                throw SwaziError("TypeError", "swazi.structuredDecode requires a Buffer argument", token.loc);
+            }
+            BufferPtr buf = std::get<BufferPtr>(args[0]);
+            return structured_clone_decode(buf->data.data(), buf->data.size(), evaluator, token);
+        };
+
+        Token tok;
+        tok.type = TokenType::IDENTIFIER;
+        tok.loc = TokenLocation("<serialization>", 0, 0, 0);
+        auto fn_value = std::make_shared<FunctionValue>("swazi.structuredDecode", fn, env, tok);
+        obj->properties["structuredDecode"] = PropertyDescriptor{fn_value, false, false, false, tok};
+    }
+
     return obj;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "SwaziError.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "swazi.hpp"
 
 namespace fs = std::filesystem;
 
@@ -40,49 +41,17 @@ bool worker_threads_exist() {
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// deep_clone_value
+// Message encoding
+// Messages cross threads as structured-clone bytes (see swazi.hpp): encoded on
+// the sending thread, decoded on the receiving one with its own evaluator so
+// Set / HashMap instances re-link to that interpreter's classes.
 // ─────────────────────────────────────────────────────────────────────────────
-Value deep_clone_value(const Value& v, const Token& tok) {
-    if (std::holds_alternative<std::monostate>(v)) return v;
-    if (std::holds_alternative<double>(v)) return v;
-    if (std::holds_alternative<std::string>(v)) return v;
-    if (std::holds_alternative<bool>(v)) return v;
-
-    if (auto* b = std::get_if<BufferPtr>(&v)) {
-        auto nb = std::make_shared<BufferValue>();
-        nb->data = (*b)->data;
-        nb->encoding = (*b)->encoding;
-        return nb;
-    }
-    if (auto* r = std::get_if<RangePtr>(&v)) {
-        auto nr = std::make_shared<RangeValue>(
-            (*r)->start, (*r)->end, (*r)->step, (*r)->inclusive);
-        nr->cur = (*r)->cur;
-        return nr;
-    }
-    if (auto* dt = std::get_if<DateTimePtr>(&v))
-        return std::make_shared<DateTimeValue>(**dt);
-    if (auto* rx = std::get_if<RegexPtr>(&v))
-        return std::make_shared<RegexValue>((*rx)->pattern, (*rx)->flags);
-    if (auto* a = std::get_if<ArrayPtr>(&v)) {
-        auto na = std::make_shared<ArrayValue>();
-        na->elements.reserve((*a)->elements.size());
-        for (auto& el : (*a)->elements)
-            na->elements.push_back(deep_clone_value(el, tok));
-        return na;
-    }
-    if (auto* o = std::get_if<ObjectPtr>(&v)) {
-        auto no = std::make_shared<ObjectValue>();
-        for (auto& [k, pd] : (*o)->properties) {
-            PropertyDescriptor npd = pd;
-            npd.value = deep_clone_value(pd.value, tok);
-            no->properties[k] = npd;
-        }
-        return no;
-    }
-    throw SwaziError("TypeError",
-        "Worker: value type '" + _type_name(v) + "' is not transferable across threads.",
-        tok.loc);
+static WorkerMessage encode_message(const Value& v, const Token& tok) {
+    return structured_clone_encode(v, tok);
+}
+
+static Value decode_message(const WorkerMessage& msg, Evaluator* evaluator) {
+    return structured_clone_decode(msg.data(), msg.size(), evaluator);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -101,7 +70,7 @@ static void close_keep_alive(WorkerCtxPtr ctx) {
 // ─────────────────────────────────────────────────────────────────────────────
 
 // main → worker  (retries on next main tick if worker hasn't booted yet)
-static void deliver_to_worker(WorkerCtxPtr ctx, Value msg) {
+static void deliver_to_worker(WorkerCtxPtr ctx, WorkerMessage msg) {
     Scheduler* ws = ctx->worker_scheduler.load();
     if (!ws) {
         // Worker hasn't booted yet — buffer locally.
@@ -118,7 +87,7 @@ static void deliver_to_worker(WorkerCtxPtr ctx, Value msg) {
         auto* fp = std::get_if<FunctionPtr>(&it->second.value);
         if (!fp || !*fp) return;
         try {
-            we->invoke_function(*fp, {msg}, (*fp)->closure, Token{});
+            we->invoke_function(*fp, {decode_message(msg, we)}, (*fp)->closure, Token{});
         } catch (const std::exception& e) {
             std::cerr << "[Worker:" << ctx->label
                       << "] onmessage error: " << e.what() << "\n";
@@ -128,7 +97,7 @@ static void deliver_to_worker(WorkerCtxPtr ctx, Value msg) {
 }
 
 // worker → main
-static void deliver_to_main(WorkerCtxPtr ctx, Value msg) {
+static void deliver_to_main(WorkerCtxPtr ctx, WorkerMessage msg) {
     if (!ctx->main_scheduler) return;
     ctx->main_scheduler->enqueue_macrotask([ctx, msg = std::move(msg)]() {
         if (!ctx->main_evaluator) return;
@@ -138,7 +107,7 @@ static void deliver_to_main(WorkerCtxPtr ctx, Value msg) {
         if (!fp || !*fp) return;
         try {
             ctx->main_evaluator->invoke_function(
-                *fp, {msg}, (*fp)->closure, Token{});
+                *fp, {decode_message(msg, ctx->main_evaluator)}, (*fp)->closure, Token{});
         } catch (const std::exception& e) {
             std::cerr << "[Worker:" << ctx->label
                       << "] w.onmessage error: " << e.what() << "\n";
@@ -148,7 +117,7 @@ static void deliver_to_main(WorkerCtxPtr ctx, Value msg) {
 }
 
 // worker → main  explicit error channel
-static void deliver_error_to_main(WorkerCtxPtr ctx, Value err) {
+static void deliver_error_to_main(WorkerCtxPtr ctx, WorkerMessage err) {
     if (!ctx->main_scheduler) return;
     ctx->main_scheduler->enqueue_macrotask([ctx, err = std::move(err)]() {
         if (!ctx->main_evaluator) return;
@@ -158,7 +127,7 @@ static void deliver_error_to_main(WorkerCtxPtr ctx, Value err) {
         if (!fp || !*fp) return;
         try {
             ctx->main_evaluator->invoke_function(
-                *fp, {err}, (*fp)->closure, Token{});
+                *fp, {decode_message(err, ctx->main_evaluator)}, (*fp)->closure, Token{});
         } catch (const std::exception& e) {
             std::cerr << "[Worker:" << ctx->label
                       << "] w.on(\"error\") handler threw: " << e.what() << "\n";
@@ -184,6 +153,13 @@ static void fire_exit_on_main(WorkerCtxPtr ctx) {
 
     int code = ctx->exit_code.load();
     ctx->main_scheduler->enqueue_macrotask([ctx, code]() {
+        if (ctx->native_on_exit) {
+            // Moved out so captures that point back at ctx are released.
+            auto on_exit = std::move(ctx->native_on_exit);
+            ctx->native_on_exit = nullptr;
+            on_exit(code);
+            return;
+        }
         if (!ctx->main_evaluator) return;
         auto it = ctx->main_worker_obj->properties.find("onexit");
         if (it == ctx->main_worker_obj->properties.end()) return;
@@ -202,6 +178,23 @@ static void fire_exit_on_main(WorkerCtxPtr ctx) {
     ctx->main_scheduler->notify();
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// isolate_function
+// Builds a thin wrapper that shares fn's body AST but whose closure is the
+// given (worker-owned) global env, not the main thread's env.
+// ─────────────────────────────────────────────────────────────────────────────
+FunctionPtr isolate_function(const FunctionPtr& fn, EnvPtr global_env) {
+    auto isolated = std::make_shared<FunctionValue>(
+        fn->name.empty() ? "<worker>" : fn->name,
+        fn->parameters,
+        fn->body,
+        global_env,  // ← worker's env, not fn->closure
+        fn->token);
+    isolated->is_async = fn->is_async;
+    isolated->is_generator = fn->is_generator;
+    return isolated;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Worker thread entry
 // ─────────────────────────────────────────────────────────────────────────────
@@ -225,7 +218,7 @@ static void worker_thread_fn(void* arg) {
 
         // Drain messages buffered before scheduler was published.
         {
-            std::vector<Value> pending;
+            std::vector<WorkerMessage> pending;
             {
                 std::lock_guard<std::mutex> lk(ctx->pending_mutex);
                 pending = std::move(ctx->pending_messages);
@@ -250,23 +243,19 @@ static void worker_thread_fn(void* arg) {
             }
         } keep_alive_guard{ctx};
 
-        if (ctx->mode == WorkerMode::Function) {
+        if (ctx->mode == WorkerMode::Native) {
+            // ── Native mode ──────────────────────────────────────────────────
+            auto body = std::move(ctx->native_body);
+            ctx->native_body = nullptr;
+            body(*ctx, evaluator);
+
+        } else if (ctx->mode == WorkerMode::Function) {
             // ── Function mode ────────────────────────────────────────────────
             // Take the body AST from the captured FunctionPtr but run it
             // inside the worker's own fresh global env — no closure bleed.
             // parentThread is passed as the first (and only) argument.
             FunctionPtr fn = ctx->worker_fn;
-
-            // Build a thin wrapper that shares the same body but whose
-            // closure is the worker's global env, not the main thread's env.
-            auto isolated = std::make_shared<FunctionValue>(
-                fn->name.empty() ? "<worker>" : fn->name,
-                fn->parameters,
-                fn->body,
-                evaluator.get_global_env(),  // ← worker's env, not fn->closure
-                fn->token);
-            isolated->is_async = fn->is_async;
-            isolated->is_generator = fn->is_generator;
+            FunctionPtr isolated = isolate_function(fn, evaluator.get_global_env());
 
             // parentThread is already in global env; also pass it as arg
             // so the function signature (parentThread) => { ... } works.
@@ -299,6 +288,56 @@ static void worker_thread_fn(void* arg) {
     g_current_worker_ctx = nullptr;
     fire_exit_on_main(ctx);
 }
+// ─────────────────────────────────────────────────────────────────────────────
+// Spawning
+// ─────────────────────────────────────────────────────────────────────────────
+static void check_worker_cap(const Token& tok) {
+    std::lock_guard<std::mutex> lk(g_workers_mutex);
+    int alive = 0;
+    for (auto& w : g_active_workers)
+        if (w->running.load()) alive++;
+    if (alive >= SWAZI_MAX_WORKERS)
+        throw SwaziError("RuntimeError",
+            "Worker: cannot spawn more than " +
+                std::to_string(SWAZI_MAX_WORKERS) +
+                " concurrent workers (= logical CPU cores).",
+            tok.loc);
+}
+
+static void start_worker_thread(const WorkerCtxPtr& ctx) {
+    ctx->parent_ctx = g_current_worker_ctx;
+    ctx->running.store(true);
+    {
+        std::lock_guard<std::mutex> lk(g_workers_mutex);
+        // Evict terminated workers to keep the registry lean.
+        g_active_workers.erase(
+            std::remove_if(g_active_workers.begin(), g_active_workers.end(),
+                [](const WorkerCtxPtr& w) { return w->terminated.load(); }),
+            g_active_workers.end());
+        g_active_workers.push_back(ctx);
+    }
+    uv_thread_create(&ctx->thread, worker_thread_fn, new WorkerCtxPtr(ctx));
+}
+
+WorkerCtxPtr spawn_native_worker(Evaluator* parent, const std::string& label,
+    std::function<void(WorkerCtx&, Evaluator&)> body,
+    std::function<void(int)> on_exit, const Token& tok) {
+    check_worker_cap(tok);
+
+    auto ctx = std::make_shared<WorkerCtx>();
+    ctx->label = label;
+    ctx->mode = WorkerMode::Native;
+    ctx->native_body = std::move(body);
+    ctx->native_on_exit = std::move(on_exit);
+    ctx->main_scheduler = parent ? parent->scheduler() : nullptr;
+    ctx->main_evaluator = parent;
+    ctx->main_worker_obj = std::make_shared<ObjectValue>();
+    ctx->worker_port_obj = std::make_shared<ObjectValue>();
+
+    start_worker_thread(ctx);
+    return ctx;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // join_all_workers — called after main event loop exits
 // ─────────────────────────────────────────────────────────────────────────────
@@ -322,6 +361,234 @@ void join_all_workers() {
     }
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Data-parallel array ops — arr.pmap / arr.pfilter / arr.preduce and parallel.*
+//
+// The array is cut into chunks, each chunk is structured-cloned into one of N
+// short-lived interpreter threads, and the callback body runs there the same
+// way a Function-mode Worker does: fresh global env, no closure.  Callbacks
+// must therefore be pure — they see their arguments and the builtins, nothing
+// captured from the calling scope.  Results are merged back in input order.
+//
+// preduce folds each chunk locally and then folds the partials in one more
+// isolated pass, so the reducer must be associative.  In that pass the index
+// argument is the index of the first element the partial covers.
+// ─────────────────────────────────────────────────────────────────────────────
+struct ParallelJob {
+    ParallelOp op;
+    FunctionPtr fn;
+    std::vector<WorkerMessage> inputs;  // one encoded sub-array per chunk
+    std::vector<size_t> offsets;        // index of each chunk's first element
+    std::vector<size_t> fold_index;     // folding partials: the index each stands for
+    std::vector<WorkerMessage> outputs;
+    std::vector<std::string> errors;  // per chunk, each written by one thread
+    std::mutex thread_error_mutex;    // a thread that failed outside any chunk
+    std::string thread_error;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+};
+
+// Async callbacks return promises — drive the thread's loop until settled.
+static Value settle_parallel_result(Value v, Evaluator& evaluator, const Token& tok) {
+    auto* p = std::get_if<PromisePtr>(&v);
+    if (!p || !*p) return v;
+    if ((*p)->state == PromiseValue::State::PENDING) evaluator.run_loop();
+    if ((*p)->state == PromiseValue::State::FULFILLED) return (*p)->result;
+    if ((*p)->state == PromiseValue::State::REJECTED)
+        throw SwaziError("RuntimeError",
+            "parallel callback rejected: " + evaluator.to_string_value_public((*p)->result), tok.loc);
+    throw SwaziError("RuntimeError", "parallel callback returned a promise that never settled.", tok.loc);
+}
+
+static void parallel_thread_fn(void* arg) {
+    ParallelJob* job = static_cast<ParallelJob*>(arg);
+
+    // A private ctx keeps this thread's run_loop from waiting on workers that
+    // belong to the calling thread (see worker_threads_exist).
+    WorkerCtx self;
+    g_current_worker_ctx = &self;
+
+    try {
+        Evaluator evaluator;
+        FunctionPtr fn = isolate_function(job->fn, evaluator.get_global_env());
+        const Token& tok = job->fn->token;
+        EnvPtr genv = evaluator.get_global_env();
+
+        for (;;) {
+            size_t c = job->next_chunk.fetch_add(1);
+            if (c >= job->inputs.size() || job->failed.load()) break;
+            try {
+                Value in = decode_message(job->inputs[c], &evaluator);
+                ArrayPtr items = std::get<ArrayPtr>(in);
+                auto out = std::make_shared<ArrayValue>();
+                size_t base = job->offsets[c];
+
+                if (job->op == ParallelOp::Reduce) {
+                    Value acc = items->elements[0];
+                    for (size_t i = 1; i < items->elements.size(); ++i) {
+                        double index = job->fold_index.empty() ? (double)(base + i) : (double)job->fold_index[i];
+                        acc = settle_parallel_result(
+                            evaluator.invoke_function(fn, {acc, items->elements[i], index}, genv, tok),
+                            evaluator, tok);
+                    }
+                    out->elements.push_back(acc);
+                } else {
+                    out->elements.reserve(items->elements.size());
+                    for (size_t i = 0; i < items->elements.size(); ++i) {
+                        Value r = settle_parallel_result(
+                            evaluator.invoke_function(fn, {items->elements[i], (double)(base + i)}, genv, tok),
+                            evaluator, tok);
+                        if (job->op == ParallelOp::Filter)
+                            out->elements.push_back(evaluator.to_bool_public(r));
+                        else
+                            out->elements.push_back(std::move(r));
+                    }
+                }
+                job->outputs[c] = encode_message(out, tok);
+            } catch (const std::exception& e) {
+                job->errors[c] = e.what();
+                job->failed.store(true);
+            }
+        }
+        evaluator.run_loop();
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lk(job->thread_error_mutex);
+        if (job->thread_error.empty()) job->thread_error = e.what();
+        job->failed.store(true);
+    }
+
+    g_current_worker_ctx = nullptr;
+}
+
+// Run `job` on up to `workers` threads and wait for them; the first error
+// any of them hit is thrown here.
+static void run_parallel_job(ParallelJob& job, size_t workers, const char* name, const Token& tok) {
+    job.outputs.resize(job.inputs.size());
+    job.errors.resize(job.inputs.size());
+
+    size_t nthreads = std::min(workers, job.inputs.size());
+    std::vector<uv_thread_t> threads(nthreads);
+    size_t started = 0;
+    for (; started < nthreads; ++started) {
+        if (uv_thread_create(&threads[started], parallel_thread_fn, &job) != 0) break;
+    }
+    if (started == 0)
+        throw SwaziError("RuntimeError", std::string(name) + "(): could not start worker threads.", tok.loc);
+    for (size_t i = 0; i < started; ++i) uv_thread_join(&threads[i]);
+
+    for (auto& err : job.errors) {
+        if (!err.empty()) throw SwaziError("RuntimeError", std::string(name) + "() worker failed: " + err, tok.loc);
+    }
+    if (!job.thread_error.empty())
+        throw SwaziError("RuntimeError", std::string(name) + "() worker failed: " + job.thread_error, tok.loc);
+}
+
+Value parallel_array_op(ParallelOp op, const ArrayPtr& arr, const std::vector<Value>& args,
+    Evaluator* evaluator, EnvPtr, const Token& tok) {
+    const char* name = op == ParallelOp::Map ? "pmap" : op == ParallelOp::Filter ? "pfilter"
+                                                                                 : "preduce";
+    if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0]))
+        throw SwaziError("TypeError", std::string(name) + "() requires a function as the first argument.", tok.loc);
+    FunctionPtr fn = std::get<FunctionPtr>(args[0]);
+    if (!fn || fn->is_native || !fn->body)
+        throw SwaziError("TypeError",
+            std::string(name) + "(): the callback must be a script function (native functions cannot be moved to a worker).",
+            tok.loc);
+    if (fn->is_generator)
+        throw SwaziError("TypeError", std::string(name) + "(): generator functions are not supported.", tok.loc);
+
+    // preduce(fn, initial?, opts?) — map/filter take (fn, opts?)
+    size_t opts_index = 1;
+    bool has_initial = false;
+    Value initial;
+    if (op == ParallelOp::Reduce && args.size() >= 2) {
+        has_initial = true;
+        initial = args[1];
+        opts_index = 2;
+    }
+
+    size_t n = arr ? arr->elements.size() : 0;
+    size_t workers = static_cast<size_t>(std::max(1, SWAZI_MAX_WORKERS));
+    size_t chunk = 0;
+    if (args.size() > opts_index) {
+        auto* opts = std::get_if<ObjectPtr>(&args[opts_index]);
+        if (!opts || !*opts)
+            throw SwaziError("TypeError", std::string(name) + "(): options must be an object.", tok.loc);
+        auto read_count = [&](const char* key, size_t& dst) {
+            auto it = (*opts)->properties.find(key);
+            if (it == (*opts)->properties.end()) return;
+            auto* d = std::get_if<double>(&it->second.value);
+            if (!d || *d < 1)
+                throw SwaziError("RangeError",
+                    std::string(name) + "(): options." + key + " must be a positive number.", tok.loc);
+            dst = static_cast<size_t>(*d);
+        };
+        read_count("chunk", chunk);
+        read_count("workers", workers);
+        workers = std::min(workers, static_cast<size_t>(std::max(1, SWAZI_MAX_WORKERS)));
+    }
+
+    if (n == 0) {
+        if (op != ParallelOp::Reduce) return std::make_shared<ArrayValue>();
+        if (has_initial) return initial;
+        throw SwaziError("TypeError", "preduce() called on empty array without initial value.", tok.loc);
+    }
+
+    // Default: a few chunks per worker so an uneven chunk does not stall the batch.
+    if (chunk == 0) chunk = std::max<size_t>(1, (n + workers * 4 - 1) / (workers * 4));
+
+    ParallelJob job;
+    job.op = op;
+    job.fn = fn;
+    for (size_t off = 0; off < n; off += chunk) {
+        auto slice = std::make_shared<ArrayValue>();
+        size_t end = std::min(n, off + chunk);
+        slice->elements.assign(arr->elements.begin() + off, arr->elements.begin() + end);
+        job.inputs.push_back(encode_message(slice, tok));
+        job.offsets.push_back(off);
+    }
+    run_parallel_job(job, workers, name, tok);
+
+    auto result = std::make_shared<ArrayValue>();
+    if (op == ParallelOp::Map) result->elements.reserve(n);
+
+    for (size_t c = 0; c < job.outputs.size(); ++c) {
+        Value part = decode_message(job.outputs[c], evaluator);
+        ArrayPtr items = std::get<ArrayPtr>(part);
+        if (op == ParallelOp::Filter) {
+            // keep the caller's own elements, not the worker's copies
+            for (size_t i = 0; i < items->elements.size(); ++i) {
+                if (std::get<bool>(items->elements[i]))
+                    result->elements.push_back(arr->elements[job.offsets[c] + i]);
+            }
+        } else {
+            for (auto& v : items->elements) result->elements.push_back(std::move(v));
+        }
+    }
+
+    if (op != ParallelOp::Reduce) return result;
+
+    // Fold the per-chunk partials in an isolated interpreter too, so the
+    // reducer sees the same scope there as it did for the chunks.
+    if (!has_initial && result->elements.size() == 1) return result->elements[0];
+    ParallelJob fold;
+    fold.op = ParallelOp::Reduce;
+    fold.fn = fn;
+    auto parts = std::make_shared<ArrayValue>();
+    if (has_initial) {
+        parts->elements.push_back(initial);
+        fold.fold_index.push_back(0);
+    }
+    for (size_t c = 0; c < result->elements.size(); ++c) {
+        parts->elements.push_back(std::move(result->elements[c]));
+        fold.fold_index.push_back(job.offsets[c]);
+    }
+    fold.inputs.push_back(encode_message(parts, tok));
+    fold.offsets.push_back(0);
+    run_parallel_job(fold, 1, name, tok);
+    return std::get<ArrayPtr>(decode_message(fold.outputs[0], evaluator))->elements[0];
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // init_worker — registers the Worker constructor in the global environment
 //
@@ -407,18 +674,7 @@ void init_worker(EnvPtr env, Evaluator* evaluator) {
             }
 
             // ── Worker cap ──────────────────────────────────────────────────────
-            {
-                std::lock_guard<std::mutex> lk(g_workers_mutex);
-                int alive = 0;
-                for (auto& w : g_active_workers)
-                    if (w->running.load()) alive++;
-                if (alive >= SWAZI_MAX_WORKERS)
-                    throw SwaziError("RuntimeError",
-                        "Worker: cannot spawn more than " +
-                            std::to_string(SWAZI_MAX_WORKERS) +
-                            " concurrent workers (= logical CPU cores).",
-                        tok.loc);
-            }
+            check_worker_cap(tok);
 
             // ── Parse options object ─────────────────────────────────────────────────────
             std::vector<std::string> worker_argv;
@@ -524,7 +780,7 @@ void init_worker(EnvPtr env, Evaluator* evaluator) {
                         if (a.empty())
                             throw SwaziError("TypeError",
                                 "parentThread.send() requires one argument.", t.loc);
-                        deliver_to_main(ctx, deep_clone_value(a[0], t));
+                        deliver_to_main(ctx, encode_message(a[0], t));
                         return std::monostate{};
                     },
                     nullptr, Token{}),
@@ -540,7 +796,7 @@ void init_worker(EnvPtr env, Evaluator* evaluator) {
                         if (a.empty())
                             throw SwaziError("TypeError",
                                 "parentThread.error() requires one argument.", t.loc);
-                        deliver_error_to_main(ctx, deep_clone_value(a[0], t));
+                        deliver_error_to_main(ctx, encode_message(a[0], t));
                         return std::monostate{};
                     },
                     nullptr, Token{}),
@@ -632,7 +888,7 @@ void init_worker(EnvPtr env, Evaluator* evaluator) {
                         if (ctx->terminated.load())
                             throw SwaziError("RuntimeError",
                                 "w.send(): worker '" + ctx->label + "' has already terminated.", t.loc);
-                        deliver_to_worker(ctx, deep_clone_value(a[0], t));
+                        deliver_to_worker(ctx, encode_message(a[0], t));
                         return std::monostate{};
                     },
                     nullptr, Token{}),
@@ -710,19 +966,31 @@ void init_worker(EnvPtr env, Evaluator* evaluator) {
                 Value{ctx->label}, false, true, true, Token{}};
 
             // ── Spawn ────────────────────────────────────────────────────────────
-            ctx->parent_ctx = g_current_worker_ctx;
-            ctx->running.store(true);
-            {
-                std::lock_guard<std::mutex> lk(g_workers_mutex);
-                // Evict terminated workers to keep the registry lean.
-                g_active_workers.erase(
-                    std::remove_if(g_active_workers.begin(), g_active_workers.end(),
-                        [](const WorkerCtxPtr& w) { return w->terminated.load(); }),
-                    g_active_workers.end());
-                g_active_workers.push_back(ctx);
-            }
-            uv_thread_create(&ctx->thread, worker_thread_fn, new WorkerCtxPtr(ctx));
+            start_worker_thread(ctx);
 
             return Value{worker_obj};
         });
+
+    // ── parallel.map / filter / reduce (arr, fn, ...) ───────────────────────
+    // Same as arr.pmap / arr.pfilter / arr.preduce, for callers that prefer a
+    // free-function form.
+    auto parallel_obj = std::make_shared<ObjectValue>();
+    auto add_parallel = [&](const std::string& name, ParallelOp op) {
+        parallel_obj->properties[name] = PropertyDescriptor{
+            std::make_shared<FunctionValue>(
+                "native:parallel." + name,
+                [evaluator, op, name](const std::vector<Value>& a, EnvPtr callEnv, const Token& t) -> Value {
+                    if (a.empty() || !std::holds_alternative<ArrayPtr>(a[0]))
+                        throw SwaziError("TypeError",
+                            "parallel." + name + "(arr, fn, ...): first argument must be an array.", t.loc);
+                    std::vector<Value> rest(a.begin() + 1, a.end());
+                    return parallel_array_op(op, std::get<ArrayPtr>(a[0]), rest, evaluator, callEnv, t);
+                },
+                nullptr, Token{}),
+            false, false, true, Token{}};
+    };
+    add_parallel("map", ParallelOp::Map);
+    add_parallel("filter", ParallelOp::Filter);
+    add_parallel("reduce", ParallelOp::Reduce);
+    env->set("parallel", {parallel_obj, true});
 }
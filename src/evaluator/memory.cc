@@ -15,6 +15,9 @@ std::atomic<size_t> g_datetime_count{0};
 std::atomic<size_t> g_range_count{0};
 std::atomic<size_t> g_map_count{0};
 
+std::atomic<size_t> g_objects_allocated{0};
+std::atomic<size_t> g_functions_allocated{0};
+
 std::atomic<size_t> g_buffer_bytes{0};
 std::atomic<size_t> g_string_bytes{0};
 }  // namespace MemoryTracking
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <thread>
 
 #include "AsyncBridge.hpp"
+#include "DnsResolver.hpp"
 #include "Scheduler.hpp"
 #include "SwaziError.hpp"
 #include "evaluator.hpp"
@@ -105,17 +106,21 @@ struct CurlAsyncContext {
     CurlWriteCtx header_ctx;
     std::shared_ptr<PromiseValue> promise;
     struct curl_slist* headers_list;
+    struct curl_slist* resolve_list;
     std::string url;
     Evaluator* evaluator;
     ReadContext* read_ctx;
     std::vector<uint8_t> body_data_copy;
 
-    CurlAsyncContext() : easy_handle(nullptr), headers_list(nullptr), evaluator(nullptr), read_ctx(nullptr) {}
+    CurlAsyncContext() : easy_handle(nullptr), headers_list(nullptr), resolve_list(nullptr), evaluator(nullptr), read_ctx(nullptr) {}
 
     ~CurlAsyncContext() {
         if (headers_list) {
             curl_slist_free_all(headers_list);
         }
+        if (resolve_list) {
+            curl_slist_free_all(resolve_list);
+        }
         if (easy_handle) {
             curl_easy_cleanup(easy_handle);
         }
@@ -125,6 +130,70 @@ struct CurlAsyncContext {
     }
 };
 
+// curl resolves names itself, away from the loop's resolver.  The curl
+// requests still share the resolver's cache (DnsResolver.hpp): a cached name
+// is handed to curl with CURLOPT_RESOLVE, and the address curl found goes
+// back in.
+static bool curl_url_host(const std::string& url, std::string& host, long& port) {
+    CURLU* u = curl_url();
+    if (!u) return false;
+    char* h = nullptr;
+    char* p = nullptr;
+    bool ok = curl_url_set(u, CURLUPART_URL, url.c_str(), 0) == CURLUE_OK &&
+        curl_url_get(u, CURLUPART_HOST, &h, 0) == CURLUE_OK &&
+        curl_url_get(u, CURLUPART_PORT, &p, CURLU_DEFAULT_PORT) == CURLUE_OK;
+    if (ok) {
+        host = h;
+        port = std::strtol(p, nullptr, 10);
+    }
+    curl_free(h);
+    curl_free(p);
+    curl_url_cleanup(u);
+    return ok && !host.empty() && host[0] != '[';
+}
+
+// False when the resolver runs from the hosts file alone and has no answer.
+// `list` must outlive the transfer.
+static bool curl_use_cached_dns(CURL* c, const std::string& url, struct curl_slist*& list) {
+    std::string host;
+    long port = 0;
+    if (!curl_url_host(url, host, port)) return true;
+
+    std::vector<sockaddr_storage> addrs;
+    if (!dns_lookup_cached(host, AF_UNSPEC, addrs)) return !dns_options().hosts_only;
+
+    std::string entry = host + ":" + std::to_string(port) + ":";
+    for (size_t i = 0; i < addrs.size(); ++i) {
+        char ip[INET6_ADDRSTRLEN] = {0};
+        if (addrs[i].ss_family == AF_INET6) {
+            uv_ip6_name(reinterpret_cast<const sockaddr_in6*>(&addrs[i]), ip, sizeof(ip));
+            entry += std::string(i ? "," : "") + "[" + ip + "]";
+        } else {
+            uv_ip4_name(reinterpret_cast<const sockaddr_in*>(&addrs[i]), ip, sizeof(ip));
+            entry += std::string(i ? "," : "") + ip;
+        }
+    }
+    list = curl_slist_append(list, entry.c_str());
+    curl_easy_setopt(c, CURLOPT_RESOLVE, list);
+    return true;
+}
+
+static void curl_remember_dns(CURL* c) {
+    char* ip = nullptr;
+    char* effective = nullptr;
+    if (curl_easy_getinfo(c, CURLINFO_PRIMARY_IP, &ip) != CURLE_OK || !ip || !*ip) return;
+    if (curl_easy_getinfo(c, CURLINFO_EFFECTIVE_URL, &effective) != CURLE_OK || !effective) return;
+
+    std::string host;
+    long port = 0;
+    if (!curl_url_host(effective, host, port)) return;
+    sockaddr_storage addr;
+    memset(&addr, 0, sizeof(addr));
+    if (uv_ip4_addr(ip, 0, reinterpret_cast<sockaddr_in*>(&addr)) == 0 ||
+        uv_ip6_addr(ip, 0, reinterpret_cast<sockaddr_in6*>(&addr)) == 0)
+        dns_remember(host, addr);
+}
+
 static size_t curl_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
     size_t total = size * nmemb;
     CurlWriteCtx* ctx = static_cast<CurlWriteCtx*>(userdata);
@@ -321,8 +390,14 @@ std::shared_ptr<ObjectValue> make_http_exports(EnvPtr env, Evaluator* evaluator)
                 if (headers) curl_easy_setopt(c, CURLOPT_HTTPHEADER, headers);
             }
 
-            CURLcode res = curl_easy_perform(c);
+            struct curl_slist* resolve = nullptr;
+            CURLcode res = CURLE_COULDNT_RESOLVE_HOST;
+            if (curl_use_cached_dns(c, url, resolve)) {
+                res = curl_easy_perform(c);
+                curl_remember_dns(c);
+            }
             if (headers) curl_slist_free_all(headers);
+            if (resolve) curl_slist_free_all(resolve);
             curl_easy_cleanup(c);
             
             if (res != CURLE_OK) {
@@ -370,8 +445,14 @@ std::shared_ptr<ObjectValue> make_http_exports(EnvPtr env, Evaluator* evaluator)
             }
             if (headers) curl_easy_setopt(c, CURLOPT_HTTPHEADER, headers);
 
-            CURLcode res = curl_easy_perform(c);
+            struct curl_slist* resolve = nullptr;
+            CURLcode res = CURLE_COULDNT_RESOLVE_HOST;
+            if (curl_use_cached_dns(c, url, resolve)) {
+                res = curl_easy_perform(c);
+                curl_remember_dns(c);
+            }
             if (headers) curl_slist_free_all(headers);
+            if (resolve) curl_slist_free_all(resolve);
             curl_easy_cleanup(c);
             
             if (res != CURLE_OK) {
@@ -390,7 +471,7 @@ std::shared_ptr<ObjectValue> make_http_exports(EnvPtr env, Evaluator* evaluator)
 #endif
 
 #if defined(HAVE_LIBUV)
-    // http.createServer(handler) -> server object (uses libuv)
+    // http.createServer(handler, opts?) -> server object (uses libuv)
     {
         Token tok;
         tok.type = TokenType::IDENTIFIER;
@@ -403,6 +484,30 @@ std::shared_ptr<ObjectValue> make_http_exports(EnvPtr env, Evaluator* evaluator)
         auto fn = std::make_shared<FunctionValue>("http.createServer", create_server_fn, env, tok);
         obj->properties["createServer"] = PropertyDescriptor{Value{fn}, false, false, false, tok};
     }
+
+    // http.Router() -> router object; routes are matched natively (http_router.cc)
+    {
+        auto fn = make_native_fn("http.Router", [evaluator](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
+            return native_createRouter(args, callEnv, token, evaluator);
+        }, env);
+        obj->properties["Router"] = PropertyDescriptor{fn, false, false, false, Token()};
+    }
+
+    // http.static(root, opts?) -> handler serving files under root (http_static.cc)
+    {
+        auto fn = make_native_fn("http.static", [evaluator](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
+            return native_httpStatic(args, callEnv, token, evaluator);
+        }, env);
+        obj->properties["static"] = PropertyDescriptor{fn, false, false, false, Token()};
+    }
+
+    // http.bench(opts) -> Promise<result>; native load generator (http_bench.cc)
+    {
+        auto fn = make_native_fn("http.bench", [evaluator](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
+            return native_httpBench(args, callEnv, token, evaluator);
+        }, env);
+        obj->properties["bench"] = PropertyDescriptor{fn, false, false, false, Token()};
+    }
 #else
     // stub: clear error if libuv is not present
     {
@@ -657,7 +762,11 @@ std::shared_ptr<ObjectValue> make_http_exports(EnvPtr env, Evaluator* evaluator)
                 }
                 
                 // BLOCKING CALL - but on worker thread
-                CURLcode result = curl_easy_perform(ctx->easy_handle);
+                CURLcode result = CURLE_COULDNT_RESOLVE_HOST;
+                if (curl_use_cached_dns(ctx->easy_handle, ctx->url, ctx->resolve_list)) {
+                    result = curl_easy_perform(ctx->easy_handle);
+                    curl_remember_dns(ctx->easy_handle);
+                }
                 
                 g_active_http_fetches.fetch_sub(1);
                 
@@ -1092,6 +1201,7 @@ static std::string json_stringify_value_enhanced(
         if (objvisited.count(p)) {
             throw SwaziError("JsonError", "Converting circular structure to JSON", token.loc);
         }
+        o->materialize();
         objvisited.insert(p);
 
         std::ostringstream ss;
@@ -1579,9 +1689,11 @@ Value process_send_ipc(const std::vector<Value>& args, EnvPtr env, const Token&
 Value process_on_message_ipc(const std::vector<Value>& args, EnvPtr env, const Token& token);
 Value process_off_impl(const std::vector<Value>& args, EnvPtr env, const Token& token);
 Value process_listeners_impl(const std::vector<Value>& args, EnvPtr env, const Token& token);
+void process_ipc_bind_evaluator(Evaluator* evaluator);
 
 std::shared_ptr<ObjectValue> make_process_exports(EnvPtr env, Evaluator* evaluator) {
     auto obj = std::make_shared<ObjectValue>();
+    process_ipc_bind_evaluator(evaluator);
 
     // process.getEnv(name) -> string|null
     {
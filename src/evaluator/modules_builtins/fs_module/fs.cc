@@ -523,6 +523,418 @@ static Value build_stat_object(const std::string& path, bool use_lstat, const To
     }
 }
 
+// ============= FS.PROMISES THREADPOOL HELPERS =============
+
+// In-flight fs.promises requests on this thread's loop.  libuv work requests
+// are not handles, so run_until_idle needs this to stay alive until they land.
+static thread_local int g_active_fs_requests = 0;
+
+// Thrown from a threadpool job to reject with `message` verbatim (no label).
+struct FsPromiseReject {
+    std::string message;
+};
+
+struct FsPromiseJob {
+    uv_work_t req;
+    PromisePtr promise;
+    std::function<Value()> work;
+    std::string label;
+    Value result;
+    std::string error;
+    bool failed = false;
+};
+
+static void fs_promise_run_job(FsPromiseJob* job) {
+    try {
+        job->result = job->work();
+    } catch (const FsPromiseReject& r) {
+        job->failed = true;
+        job->error = r.message;
+    } catch (const std::exception& e) {
+        job->failed = true;
+        job->error = job->label + e.what();
+    } catch (...) {
+        job->failed = true;
+        job->error = job->label + "unknown error";
+    }
+}
+
+static void fs_promise_settle(FsPromiseJob* job) {
+    PromisePtr promise = job->promise;
+    if (job->failed) {
+        promise->state = PromiseValue::State::REJECTED;
+        promise->result = Value{job->error};
+    } else {
+        promise->state = PromiseValue::State::FULFILLED;
+        promise->result = std::move(job->result);
+    }
+    // Callbacks run as a microtask so completions interleave with other
+    // promise reactions instead of firing inside the libuv callback.
+    scheduler_enqueue_microtask([promise]() {
+        if (promise->state == PromiseValue::State::FULFILLED) {
+            auto cbs = promise->then_callbacks;
+            for (auto& cb : cbs) {
+                try { cb(promise->result); } catch (...) {}
+            }
+        } else {
+            auto cbs = promise->catch_callbacks;
+            for (auto& cb : cbs) {
+                try { cb(promise->result); } catch (...) {}
+            }
+        }
+    });
+}
+
+static void fs_promise_work_cb(uv_work_t* req) {
+    fs_promise_run_job(static_cast<FsPromiseJob*>(req->data));
+}
+
+static void fs_promise_after_cb(uv_work_t* req, int status) {
+    auto* job = static_cast<FsPromiseJob*>(req->data);
+    g_active_fs_requests--;
+    if (status == UV_ECANCELED && !job->failed) {
+        job->failed = true;
+        job->error = job->label + "operation cancelled";
+    }
+    fs_promise_settle(job);
+    delete job;
+}
+
+// Runs `work` on the libuv threadpool and settles the returned promise on the
+// loop thread.  `work` must only touch data it owns: arguments are parsed by
+// the caller, and the Value it returns is fresh until handed to the promise.
+// Exceptions reject with `label` + what(); FsPromiseReject rejects verbatim.
+static Value fs_promise_task(const std::string& label, std::function<Value()> work) {
+    auto promise = std::make_shared<PromiseValue>();
+    promise->state = PromiseValue::State::PENDING;
+
+    auto* job = new FsPromiseJob();
+    job->req.data = job;
+    job->promise = promise;
+    job->work = std::move(work);
+    job->label = label;
+
+    uv_loop_t* loop = scheduler_get_loop();
+    if (!loop || uv_queue_work(loop, &job->req, fs_promise_work_cb, fs_promise_after_cb) != 0) {
+        // No loop (or queueing failed): run synchronously, still settle async.
+        fs_promise_run_job(job);
+        fs_promise_settle(job);
+        delete job;
+        return Value{promise};
+    }
+
+    g_active_fs_requests++;
+    return Value{promise};
+}
+
+// Options for fs.glob / fs.promises.glob.  Parsed on the calling thread so the
+// directory walk itself can run on the threadpool without touching Values.
+struct GlobOptions {
+    std::string pattern;
+    std::string cwd = ".";
+    bool absolute = false;
+    bool onlyFiles = false;
+    bool onlyDirectories = false;
+    bool dot = false;
+    bool followSymlinks = false;
+    int maxDepth = std::numeric_limits<int>::max();
+    std::vector<std::string> ignore_patterns;
+};
+
+static GlobOptions parse_glob_options(const std::vector<Value>& args) {
+    GlobOptions o;
+    o.pattern = value_to_string_simple(args[0]);
+    std::string& cwd = o.cwd;
+    bool& absolute = o.absolute;
+    bool& onlyFiles = o.onlyFiles;
+    bool& onlyDirectories = o.onlyDirectories;
+    bool& dot = o.dot;
+    bool& followSymlinks = o.followSymlinks;
+    int& maxDepth = o.maxDepth;
+    std::vector<std::string>& ignore_patterns = o.ignore_patterns;
+    
+    // Parse options
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        ObjectPtr opts = std::get<ObjectPtr>(args[1]);
+        
+        auto cwd_it = opts->properties.find("cwd");
+        if (cwd_it != opts->properties.end() && std::holds_alternative<std::string>(cwd_it->second.value)) {
+            cwd = std::get<std::string>(cwd_it->second.value);
+        }
+        
+        auto abs_it = opts->properties.find("absolute");
+        if (abs_it != opts->properties.end() && std::holds_alternative<bool>(abs_it->second.value)) {
+            absolute = std::get<bool>(abs_it->second.value);
+        }
+        
+        auto files_it = opts->properties.find("onlyFiles");
+        if (files_it != opts->properties.end() && std::holds_alternative<bool>(files_it->second.value)) {
+            onlyFiles = std::get<bool>(files_it->second.value);
+        }
+        
+        auto dirs_it = opts->properties.find("onlyDirectories");
+        if (dirs_it != opts->properties.end() && std::holds_alternative<bool>(dirs_it->second.value)) {
+            onlyDirectories = std::get<bool>(dirs_it->second.value);
+        }
+        
+        auto dot_it = opts->properties.find("dot");
+        if (dot_it != opts->properties.end() && std::holds_alternative<bool>(dot_it->second.value)) {
+            dot = std::get<bool>(dot_it->second.value);
+        }
+        
+        auto symlink_it = opts->properties.find("followSymlinks");
+        if (symlink_it != opts->properties.end() && std::holds_alternative<bool>(symlink_it->second.value)) {
+            followSymlinks = std::get<bool>(symlink_it->second.value);
+        }
+        
+        auto depth_it = opts->properties.find("depth");
+        if (depth_it != opts->properties.end() && std::holds_alternative<double>(depth_it->second.value)) {
+            maxDepth = static_cast<int>(std::get<double>(depth_it->second.value));
+        }
+        
+        // Parse ignore patterns
+        auto ignore_it = opts->properties.find("ignore");
+        if (ignore_it != opts->properties.end()) {
+            if (std::holds_alternative<std::string>(ignore_it->second.value)) {
+                ignore_patterns.push_back(std::get<std::string>(ignore_it->second.value));
+            } else if (std::holds_alternative<ArrayPtr>(ignore_it->second.value)) {
+                ArrayPtr arr = std::get<ArrayPtr>(ignore_it->second.value);
+                for (const auto& elem : arr->elements) {
+                    if (std::holds_alternative<std::string>(elem)) {
+                        ignore_patterns.push_back(std::get<std::string>(elem));
+                    }
+                }
+            }
+        }
+    }
+    return o;
+}
+
+static std::vector<std::string> glob_collect(const GlobOptions& o, const Token& token) {
+    const std::string& pattern = o.pattern;
+    const std::string& cwd = o.cwd;
+    const bool absolute = o.absolute;
+    const bool onlyFiles = o.onlyFiles;
+    const bool onlyDirectories = o.onlyDirectories;
+    const bool dot = o.dot;
+    const bool followSymlinks = o.followSymlinks;
+    const int maxDepth = o.maxDepth;
+    const std::vector<std::string>& ignore_patterns = o.ignore_patterns;
+
+    std::vector<std::string> result;
+    
+    try {
+        // Validate cwd exists
+        if (!fs::exists(cwd)) {
+            throw SwaziError("IOError", "fs.glob: cwd does not exist: " + cwd, token.loc);
+        }
+        
+        if (!fs::is_directory(cwd)) {
+            throw SwaziError("IOError", "fs.glob: cwd is not a directory: " + cwd, token.loc);
+        }
+        
+        // Helper: check if path should be ignored
+        auto should_ignore = [&](const std::string& relative_path) -> bool {
+            for (const auto& ignore_pattern : ignore_patterns) {
+                if (matches_pattern(relative_path, ignore_pattern)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        
+        // Helper: check if any path component is a dotfile
+        auto has_dotfile_component = [](const std::string& path) -> bool {
+            size_t pos = 0;
+            while (pos < path.length()) {
+                size_t next_sep = path.find_first_of("/\\", pos);
+                size_t component_start = pos;
+                size_t component_end = (next_sep == std::string::npos) ? path.length() : next_sep;
+                
+                if (component_end > component_start && path[component_start] == '.') {
+                    return true;
+                }
+                
+                if (next_sep == std::string::npos) break;
+                pos = next_sep + 1;
+            }
+            return false;
+        };
+        
+        // Helper: enhanced pattern matching for glob
+        auto glob_matches = [](const std::string& path, const std::string& pattern) -> bool {
+            // Special case: pattern ends with /** (matches everything recursively after prefix)
+            if (pattern.length() >= 3 && pattern.substr(pattern.length() - 3) == "/**") {
+                std::string prefix = pattern.substr(0, pattern.length() - 3);
+                if (prefix.empty()) {
+                    return true; // "**" matches everything
+                }
+                // Check if path starts with prefix and has content after it
+                if (path.find(prefix) == 0) {
+                    // Path must either equal prefix or have / after prefix
+                    if (path.length() == prefix.length()) {
+                        return false; // "src/**" doesn't match "src" itself
+                    }
+                    if (path.length() > prefix.length() && path[prefix.length()] == '/') {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            
+            // Otherwise use standard pattern matching
+            return matches_pattern(path, pattern);
+        };
+        
+        // Check if pattern has ** (globstar - recursive wildcard)
+        bool has_globstar = (pattern.find("**") != std::string::npos);
+        
+        if (!has_globstar) {
+            // ============= NON-RECURSIVE GLOB =============
+            fs::path pattern_path(pattern);
+            fs::path search_base = fs::path(cwd);
+            
+            // Split pattern into parts
+            std::vector<std::string> parts;
+            for (const auto& part : pattern_path) {
+                parts.push_back(part.string());
+            }
+            
+            // Recursive function to match each level
+            std::function<void(const fs::path&, size_t)> match_level;
+            match_level = [&](const fs::path& current_dir, size_t part_idx) {
+                if (part_idx >= parts.size()) return;
+                
+                std::string current_pattern = parts[part_idx];
+                bool is_last = (part_idx == parts.size() - 1);
+                
+                try {
+                    for (auto& entry : fs::directory_iterator(current_dir)) {
+                        // Handle symlinks
+                        if (fs::is_symlink(entry) && !followSymlinks) {
+                            continue;
+                        }
+                        
+                        std::string name = entry.path().filename().string();
+                        std::string relative_path = fs::relative(entry.path(), cwd).string();
+                        std::replace(relative_path.begin(), relative_path.end(), '\\', '/');
+                        
+                        // Check ignore patterns first
+                        if (should_ignore(relative_path) || should_ignore(name)) {
+                            continue;
+                        }
+                        
+                        // Match pattern
+                        if (matches_pattern(name, current_pattern)) {
+                            if (is_last) {
+                                // Check dotfile AFTER pattern match
+                                if (!dot && has_dotfile_component(relative_path)) {
+                                    continue;
+                                }
+                                
+                                // Last part - this is a potential match
+                                bool is_file = entry.is_regular_file();
+                                bool is_dir = entry.is_directory();
+                                
+                                // Apply type filters
+                                if (onlyFiles && !is_file) continue;
+                                if (onlyDirectories && !is_dir) continue;
+                                
+                                std::string path_to_add = absolute ? 
+                                    fs::absolute(entry.path()).string() : 
+                                    relative_path;
+                                
+                                result.push_back(path_to_add);
+                            } else {
+                                // Not last part - continue if directory
+                                if (entry.is_directory()) {
+                                    match_level(entry.path(), part_idx + 1);
+                                }
+                            }
+                        }
+                    }
+                } catch (const fs::filesystem_error&) {
+                    // Skip directories we can't read
+                }
+            };
+            
+            match_level(search_base, 0);
+            
+        } else {
+            // ============= RECURSIVE GLOB (with **) =============
+            
+            std::function<void(const fs::path&, int)> walk;
+            walk = [&](const fs::path& dir, int depth) {
+                if (depth > maxDepth) return;
+                
+                try {
+                    for (auto& entry : fs::directory_iterator(dir)) {
+                        // Handle symlinks
+                        if (fs::is_symlink(entry) && !followSymlinks) {
+                            continue;
+                        }
+                        
+                        std::string name = entry.path().filename().string();
+                        std::string relative_path = fs::relative(entry.path(), cwd).string();
+                        // Normalize path separators
+                        std::replace(relative_path.begin(), relative_path.end(), '\\', '/');
+                        
+                        // Check ignore patterns first
+                        if (should_ignore(relative_path) || should_ignore(name)) {
+                            continue;
+                        }
+                        
+                        // Check if matches pattern using enhanced matching
+                        if (glob_matches(relative_path, pattern)) {
+                            // Check dotfile AFTER pattern match
+                            if (!dot && has_dotfile_component(relative_path)) {
+                                continue;
+                            }
+                            
+                            bool is_file = entry.is_regular_file();
+                            bool is_dir = entry.is_directory();
+                            
+                            // Apply type filters to output
+                            bool should_add = true;
+                            if (onlyFiles && !is_file) should_add = false;
+                            if (onlyDirectories && !is_dir) should_add = false;
+                            
+                            if (should_add) {
+                                std::string path_to_add = absolute ? 
+                                    fs::absolute(entry.path()).string() : 
+                                    relative_path;
+                                
+                                result.push_back(path_to_add);
+                            }
+                        }
+                        
+                        // ALWAYS recurse into directories (regardless of filters)
+                        if (entry.is_directory()) {
+                            walk(entry.path(), depth + 1);
+                        }
+                    }
+                } catch (const fs::filesystem_error&) {
+                    // Skip directories we can't read
+                }
+            };
+            
+            walk(fs::path(cwd), 0);
+        }
+        
+    } catch (const fs::filesystem_error& e) {
+        throw SwaziError("FilesystemError", std::string("fs.glob failed: ") + e.what(), token.loc);
+    }
+
+    return result;
+}
+
+static Value glob_results_to_array(const std::vector<std::string>& paths) {
+    auto arr = std::make_shared<ArrayValue>();
+    arr->elements.reserve(paths.size());
+    for (const auto& p : paths) arr->elements.push_back(Value{p});
+    return Value{arr};
+}
+
 // ============= MAIN EXPORTS FUNCTION =============
 // declare for fs.open(...) so it can use what file.cc expose
 std::shared_ptr<ObjectValue> make_file_exports(EnvPtr env);
@@ -1385,6 +1797,9 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
     }
 
     // ============= fs.promises API =============
+    // Every operation parses its arguments on the calling thread, then runs the
+    // blocking filesystem work on the libuv threadpool via fs_promise_task so
+    // the event loop keeps servicing timers and sockets meanwhile.
     {
         // Create promises sub-object for async versions
         auto promises_obj = std::make_shared<ObjectValue>();
@@ -1415,53 +1830,35 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                     }
                 }
 
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
+                return fs_promise_task("Read error: ", [path, encoding]() -> Value {
+                    std::ifstream in(path, std::ios::binary | std::ios::ate);
+                    if (!in.is_open()) {
+                        throw FsPromiseReject{"Failed to open file: " + path};
+                    }
 
-                // Schedule async read on loop thread
-                scheduler_run_on_loop([promise, path, encoding]() {
-                    try {
-                        std::ifstream in(path, std::ios::binary);
-                        if (!in.is_open()) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Failed to open file: ") + path};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        // Read all bytes
-                        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
-                                                 std::istreambuf_iterator<char>());
-                        
-                        // Return based on encoding
-                        Value result;
-                        if (encoding == "binary" || encoding == "null") {
-                            auto buf = std::make_shared<BufferValue>();
-                            buf->data = std::move(data);
-                            buf->encoding = "binary";
-                            result = Value{buf};
-                        } else {
-                            result = Value{std::string(data.begin(), data.end())};
-                        }
-                        
-                        // Fulfill promise
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = result;
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("Read error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
+                    // Size the buffer up front and read in one call; fall back
+                    // to streaming for files whose size is not known (pipes).
+                    std::vector<uint8_t> data;
+                    std::streamoff size = in.tellg();
+                    if (size > 0) {
+                        data.resize(static_cast<size_t>(size));
+                        in.seekg(0, std::ios::beg);
+                        in.read(reinterpret_cast<char*>(data.data()), size);
+                        data.resize(static_cast<size_t>(in.gcount()));
+                    } else {
+                        in.clear();
+                        in.seekg(0, std::ios::beg);
+                        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
                     }
-                });
 
-                return Value{promise}; }, env);
+                    if (encoding == "binary" || encoding == "null") {
+                        auto buf = std::make_shared<BufferValue>();
+                        buf->data = std::move(data);
+                        buf->encoding = "binary";
+                        return Value{buf};
+                    }
+                    return Value{std::string(data.begin(), data.end())};
+                }); }, env);
             promises_obj->properties["readFile"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1473,75 +1870,43 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                 }
                 std::string path = value_to_string_simple(args[0]);
                 
-                // Capture content (could be string or buffer)
-                Value content = args[1];
-                bool is_buffer = std::holds_alternative<BufferPtr>(content);
+                // Buffers are written from their own storage (like Node, the
+                // caller must not mutate them until the promise settles);
+                // everything else is stringified here on the calling thread.
+                BufferPtr buffer = std::holds_alternative<BufferPtr>(args[1]) ? std::get<BufferPtr>(args[1]) : nullptr;
+                std::string text = buffer ? std::string() : value_to_string_simple(args[1]);
                 
-                std::string encoding = "utf8";
                 std::string flag = "w";
                 
                 // Parse options
-                if (args.size() >= 3) {
-                    if (std::holds_alternative<std::string>(args[2])) {
-                        encoding = std::get<std::string>(args[2]);
-                    } else if (std::holds_alternative<ObjectPtr>(args[2])) {
-                        ObjectPtr opts = std::get<ObjectPtr>(args[2]);
-                        auto enc_it = opts->properties.find("encoding");
-                        if (enc_it != opts->properties.end() && std::holds_alternative<std::string>(enc_it->second.value)) {
-                            encoding = std::get<std::string>(enc_it->second.value);
-                        }
-                        auto flag_it = opts->properties.find("flag");
-                        if (flag_it != opts->properties.end() && std::holds_alternative<std::string>(flag_it->second.value)) {
-                            flag = std::get<std::string>(flag_it->second.value);
-                        }
+                if (args.size() >= 3 && std::holds_alternative<ObjectPtr>(args[2])) {
+                    ObjectPtr opts = std::get<ObjectPtr>(args[2]);
+                    auto flag_it = opts->properties.find("flag");
+                    if (flag_it != opts->properties.end() && std::holds_alternative<std::string>(flag_it->second.value)) {
+                        flag = std::get<std::string>(flag_it->second.value);
                     }
                 }
 
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
-
-                scheduler_run_on_loop([promise, path, content, is_buffer, flag]() {
-                    try {
-                        std::ios_base::openmode mode = std::ios::binary;
-                        if (flag == "a" || flag == "a+") {
-                            mode |= std::ios::app;
-                        } else if (flag == "r+") {
-                            mode |= std::ios::in | std::ios::out;
-                        }
-                        
-                        std::ofstream out(path, mode);
-                        if (!out.is_open()) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Failed to open file for writing: ") + path};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        if (is_buffer) {
-                            BufferPtr buf = std::get<BufferPtr>(content);
-                            out.write(reinterpret_cast<const char*>(buf->data.data()), buf->data.size());
-                        } else {
-                            std::string str = value_to_string_simple(content);
-                            out.write(str.data(), str.size());
-                        }
-                        
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{true};
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("Write error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
+                return fs_promise_task("Write error: ", [path, buffer, text = std::move(text), flag]() -> Value {
+                    std::ios_base::openmode mode = std::ios::binary;
+                    if (flag == "a" || flag == "a+") {
+                        mode |= std::ios::app;
+                    } else if (flag == "r+") {
+                        mode |= std::ios::in | std::ios::out;
                     }
-                });
-
-                return Value{promise}; }, env);
+                    
+                    std::ofstream out(path, mode);
+                    if (!out.is_open()) {
+                        throw FsPromiseReject{"Failed to open file for writing: " + path};
+                    }
+                    
+                    if (buffer) {
+                        out.write(reinterpret_cast<const char*>(buffer->data.data()), buffer->data.size());
+                    } else {
+                        out.write(text.data(), text.size());
+                    }
+                    return Value{true};
+                }); }, env);
             promises_obj->properties["writeFile"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1553,19 +1918,10 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             }
             std::string path = value_to_string_simple(args[0]);
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, path]() {
-                bool exists = std::filesystem::exists(path);
-                promise->state = PromiseValue::State::FULFILLED;
-                promise->result = Value{exists};
-                for (auto& cb : promise->then_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            });
-
-            return Value{promise}; }, env);
+            return fs_promise_task("Exists error: ", [path]() -> Value {
+                std::error_code ec;
+                return Value{std::filesystem::exists(path, ec)};
+            }); }, env);
             promises_obj->properties["exists"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1574,30 +1930,13 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             auto fn = make_native_fn("fs.promises.listDir", [](const std::vector<Value>& args, EnvPtr /*callEnv*/, const Token& token) -> Value {
             std::string path = args.empty() ? "." : value_to_string_simple(args[0]);
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, path]() {
-                try {
-                    auto arr = std::make_shared<ArrayValue>();
-                    for (auto& p : std::filesystem::directory_iterator(path)) {
-                        arr->elements.push_back(Value{p.path().filename().string()});
-                    }
-                    promise->state = PromiseValue::State::FULFILLED;
-                    promise->result = Value{arr};
-                    for (auto& cb : promise->then_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
-                } catch (const std::exception& e) {
-                    promise->state = PromiseValue::State::REJECTED;
-                    promise->result = Value{std::string("List dir error: ") + e.what()};
-                    for (auto& cb : promise->catch_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
+            return fs_promise_task("List dir error: ", [path]() -> Value {
+                auto arr = std::make_shared<ArrayValue>();
+                for (auto& p : std::filesystem::directory_iterator(path)) {
+                    arr->elements.push_back(Value{p.path().filename().string()});
                 }
-            });
-
-            return Value{promise}; }, env);
+                return Value{arr};
+            }); }, env);
             promises_obj->properties["listDir"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1611,30 +1950,12 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             std::string dest = value_to_string_simple(args[1]);
             bool overwrite = args.size() >= 3 && std::holds_alternative<bool>(args[2]) ? std::get<bool>(args[2]) : false;
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, src, dest, overwrite]() {
-                try {
-                    std::filesystem::copy_options opts = std::filesystem::copy_options::none;
-                    if (overwrite) opts = static_cast<std::filesystem::copy_options>(opts | std::filesystem::copy_options::overwrite_existing);
-                    std::filesystem::copy(src, dest, opts);
-                    
-                    promise->state = PromiseValue::State::FULFILLED;
-                    promise->result = Value{true};
-                    for (auto& cb : promise->then_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
-                } catch (const std::filesystem::filesystem_error& e) {
-                    promise->state = PromiseValue::State::REJECTED;
-                    promise->result = Value{std::string("Copy error: ") + e.what()};
-                    for (auto& cb : promise->catch_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
-                }
-            });
-
-            return Value{promise}; }, env);
+            return fs_promise_task("Copy error: ", [src, dest, overwrite]() -> Value {
+                std::filesystem::copy_options opts = std::filesystem::copy_options::none;
+                if (overwrite) opts = static_cast<std::filesystem::copy_options>(opts | std::filesystem::copy_options::overwrite_existing);
+                std::filesystem::copy(src, dest, opts);
+                return Value{true};
+            }); }, env);
             promises_obj->properties["copy"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1648,50 +1969,22 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             std::string dest = value_to_string_simple(args[1]);
             bool overwrite = args.size() >= 3 && std::holds_alternative<bool>(args[2]) ? std::get<bool>(args[2]) : false;
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, src, dest, overwrite]() {
+            return fs_promise_task("Move error: ", [src, dest, overwrite]() -> Value {
                 try {
                     if (std::filesystem::exists(dest)) {
                         if (!overwrite) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Destination exists and overwrite is false")};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
+                            throw FsPromiseReject{"Destination exists and overwrite is false"};
                         }
                         std::filesystem::remove_all(dest);
                     }
                     std::filesystem::rename(src, dest);
-                    
-                    promise->state = PromiseValue::State::FULFILLED;
-                    promise->result = Value{true};
-                    for (auto& cb : promise->then_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
                 } catch (const std::filesystem::filesystem_error&) {
                     // Fallback: copy + remove for cross-device moves
-                    try {
-                        std::filesystem::copy(src, dest, std::filesystem::copy_options::recursive);
-                        std::filesystem::remove_all(src);
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{true};
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("Move error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    }
+                    std::filesystem::copy(src, dest, std::filesystem::copy_options::recursive);
+                    std::filesystem::remove_all(src);
                 }
-            });
-
-            return Value{promise}; }, env);
+                return Value{true};
+            }); }, env);
             promises_obj->properties["move"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1703,35 +1996,13 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             }
             std::string path = value_to_string_simple(args[0]);
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, path]() {
-                try {
-                    if (!std::filesystem::exists(path)) {
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{false};
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                        return;
-                    }
-                    std::uintmax_t removed = std::filesystem::remove_all(path);
-                    promise->state = PromiseValue::State::FULFILLED;
-                    promise->result = Value{removed > 0};
-                    for (auto& cb : promise->then_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
-                } catch (const std::filesystem::filesystem_error& e) {
-                    promise->state = PromiseValue::State::REJECTED;
-                    promise->result = Value{std::string("Remove error: ") + e.what()};
-                    for (auto& cb : promise->catch_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
+            return fs_promise_task("Remove error: ", [path]() -> Value {
+                if (!std::filesystem::exists(path)) {
+                    return Value{false};
                 }
-            });
-
-            return Value{promise}; }, env);
+                std::uintmax_t removed = std::filesystem::remove_all(path);
+                return Value{removed > 0};
+            }); }, env);
             promises_obj->properties["remove"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1744,36 +2015,13 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             std::string path = value_to_string_simple(args[0]);
             bool recursive = args.size() >= 2 && std::holds_alternative<bool>(args[1]) ? std::get<bool>(args[1]) : true;
 
-            auto promise = std::make_shared<PromiseValue>();
-            promise->state = PromiseValue::State::PENDING;
-
-            scheduler_run_on_loop([promise, path, recursive]() {
-                try {
-                    if (std::filesystem::exists(path)) {
-                        bool is_dir = std::filesystem::is_directory(path);
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{is_dir};
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                        return;
-                    }
-                    bool ok = recursive ? std::filesystem::create_directories(path) : std::filesystem::create_directory(path);
-                    promise->state = PromiseValue::State::FULFILLED;
-                    promise->result = Value{ok};
-                    for (auto& cb : promise->then_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
-                } catch (const std::filesystem::filesystem_error& e) {
-                    promise->state = PromiseValue::State::REJECTED;
-                    promise->result = Value{std::string("MakeDir error: ") + e.what()};
-                    for (auto& cb : promise->catch_callbacks) {
-                        try { cb(promise->result); } catch(...) {}
-                    }
+            return fs_promise_task("MakeDir error: ", [path, recursive]() -> Value {
+                if (std::filesystem::exists(path)) {
+                    return Value{std::filesystem::is_directory(path)};
                 }
-            });
-
-            return Value{promise}; }, env);
+                bool ok = recursive ? std::filesystem::create_directories(path) : std::filesystem::create_directory(path);
+                return Value{ok};
+            }); }, env);
             promises_obj->properties["makeDir"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1785,27 +2033,9 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                 }
                 std::string path = value_to_string_simple(args[0]);
         
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
-        
-                scheduler_run_on_loop([promise, path, token]() {
-                    try {
-                        Value result = build_stat_object(path, false, token);
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = result;
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("Stat error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    }
-                });
-        
-                return Value{promise}; }, env);
+                return fs_promise_task("Stat error: ", [path, token]() -> Value {
+                    return build_stat_object(path, false, token);
+                }); }, env);
             promises_obj->properties["stat"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1817,27 +2047,9 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                 }
                 std::string path = value_to_string_simple(args[0]);
         
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
-        
-                scheduler_run_on_loop([promise, path, token]() {
-                    try {
-                        Value result = build_stat_object(path, true, token);
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = result;
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("Stat error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    }
-                });
-        
-                return Value{promise}; }, env);
+                return fs_promise_task("Stat error: ", [path, token]() -> Value {
+                    return build_stat_object(path, true, token);
+                }); }, env);
             promises_obj->properties["lstat"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1854,27 +2066,10 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
         
         uint32_t mode = static_cast<uint32_t>(std::get<double>(args[1]));
         
-        auto promise = std::make_shared<PromiseValue>();
-        promise->state = PromiseValue::State::PENDING;
-
-        scheduler_run_on_loop([promise, path, mode]() {
-            try {
-                fs::permissions(path, static_cast<fs::perms>(mode));
-                promise->state = PromiseValue::State::FULFILLED;
-                promise->result = Value{true};
-                for (auto& cb : promise->then_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            } catch (const fs::filesystem_error& e) {
-                promise->state = PromiseValue::State::REJECTED;
-                promise->result = Value{std::string("Chmod error: ") + e.what()};
-                for (auto& cb : promise->catch_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            }
-        });
-
-        return Value{promise}; }, env);
+        return fs_promise_task("Chmod error: ", [path, mode]() -> Value {
+            fs::permissions(path, static_cast<fs::perms>(mode));
+            return Value{true};
+        }); }, env);
             promises_obj->properties["chmod"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1887,31 +2082,14 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
         std::string target = value_to_string_simple(args[0]);
         std::string linkPath = value_to_string_simple(args[1]);
         
-        auto promise = std::make_shared<PromiseValue>();
-        promise->state = PromiseValue::State::PENDING;
-
-        scheduler_run_on_loop([promise, target, linkPath]() {
-            try {
-                if (fs::is_directory(target)) {
-                    fs::create_directory_symlink(target, linkPath);
-                } else {
-                    fs::create_symlink(target, linkPath);
-                }
-                promise->state = PromiseValue::State::FULFILLED;
-                promise->result = Value{true};
-                for (auto& cb : promise->then_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            } catch (const fs::filesystem_error& e) {
-                promise->state = PromiseValue::State::REJECTED;
-                promise->result = Value{std::string("Symlink error: ") + e.what()};
-                for (auto& cb : promise->catch_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
+        return fs_promise_task("Symlink error: ", [target, linkPath]() -> Value {
+            if (fs::is_directory(target)) {
+                fs::create_directory_symlink(target, linkPath);
+            } else {
+                fs::create_symlink(target, linkPath);
             }
-        });
-
-        return Value{promise}; }, env);
+            return Value{true};
+        }); }, env);
             promises_obj->properties["symlink"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1922,27 +2100,9 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
         
         std::string path = value_to_string_simple(args[0]);
         
-        auto promise = std::make_shared<PromiseValue>();
-        promise->state = PromiseValue::State::PENDING;
-
-        scheduler_run_on_loop([promise, path]() {
-            try {
-                std::string target = fs::read_symlink(path).string();
-                promise->state = PromiseValue::State::FULFILLED;
-                promise->result = Value{target};
-                for (auto& cb : promise->then_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            } catch (const fs::filesystem_error& e) {
-                promise->state = PromiseValue::State::REJECTED;
-                promise->result = Value{std::string("Readlink error: ") + e.what()};
-                for (auto& cb : promise->catch_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            }
-        });
-
-        return Value{promise}; }, env);
+        return fs_promise_task("Readlink error: ", [path]() -> Value {
+            return Value{fs::read_symlink(path).string()};
+        }); }, env);
             promises_obj->properties["readlink"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1955,34 +2115,16 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
         int uid = static_cast<int>(std::get<double>(args[1]));
         int gid = static_cast<int>(std::get<double>(args[2]));
 
-        auto promise = std::make_shared<PromiseValue>();
-        promise->state = PromiseValue::State::PENDING;
-
-        scheduler_run_on_loop([promise, path, uid, gid]() {
+        return fs_promise_task("Chown failed: ", [path, uid, gid]() -> Value {
 #ifndef _WIN32
             if (chown(path.c_str(), uid, gid) != 0) {
-                promise->state = PromiseValue::State::REJECTED;
-                promise->result = Value{std::string("Chown failed: ") + strerror(errno)};
-                for (auto& cb : promise->catch_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-                return;
-            }
-            promise->state = PromiseValue::State::FULFILLED;
-            promise->result = Value{true};
-            for (auto& cb : promise->then_callbacks) {
-                try { cb(promise->result); } catch(...) {}
+                throw FsPromiseReject{std::string("Chown failed: ") + strerror(errno)};
             }
+            return Value{true};
 #else
-            promise->state = PromiseValue::State::REJECTED;
-            promise->result = Value{std::string("fs.promises.chown is not supported on Windows")};
-            for (auto& cb : promise->catch_callbacks) {
-                try { cb(promise->result); } catch(...) {}
-            }
+            throw FsPromiseReject{"fs.promises.chown is not supported on Windows"};
 #endif
-        });
-
-        return Value{promise}; }, env);
+        }); }, env);
             promises_obj->properties["chown"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -1999,36 +2141,16 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             mode = static_cast<int>(std::get<double>(args[1]));
         }
         
-        auto promise = std::make_shared<PromiseValue>();
-        promise->state = PromiseValue::State::PENDING;
-
-        scheduler_run_on_loop([promise, path, mode]() {
+        return fs_promise_task("Access error: ", [path, mode]() -> Value {
 #ifndef _WIN32
-            bool accessible = ::access(path.c_str(), mode) == 0;
-            promise->state = PromiseValue::State::FULFILLED;
-            promise->result = Value{accessible};
-            for (auto& cb : promise->then_callbacks) {
-                try { cb(promise->result); } catch(...) {}
-            }
+            return Value{::access(path.c_str(), mode) == 0};
 #else
             if (mode == 0) {
-                bool exists = fs::exists(path);
-                promise->state = PromiseValue::State::FULFILLED;
-                promise->result = Value{exists};
-                for (auto& cb : promise->then_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
-            } else {
-                promise->state = PromiseValue::State::REJECTED;
-                promise->result = Value{std::string("Access mode checking not fully supported on Windows")};
-                for (auto& cb : promise->catch_callbacks) {
-                    try { cb(promise->result); } catch(...) {}
-                }
+                return Value{fs::exists(path)};
             }
+            throw FsPromiseReject{"Access mode checking not fully supported on Windows"};
 #endif
-        });
-
-        return Value{promise}; }, env);
+        }); }, env);
             promises_obj->properties["access"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -2045,34 +2167,16 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                   mode = static_cast<mode_t>(std::get<double>(args[1]));
               }
               
-              auto promise = std::make_shared<PromiseValue>();
-              promise->state = PromiseValue::State::PENDING;
-      
-              scheduler_run_on_loop([promise, path, mode]() {
+              return fs_promise_task("mkfifo error: ", [path, mode]() -> Value {
 #ifndef _WIN32
-                  if (mkfifo(path.c_str(), mode) == 0) {
-                      promise->state = PromiseValue::State::FULFILLED;
-                      promise->result = Value{true};
-                      for (auto& cb : promise->then_callbacks) {
-                          try { cb(promise->result); } catch(...) {}
-                      }
-                  } else {
-                      promise->state = PromiseValue::State::REJECTED;
-                      promise->result = Value{std::string("mkfifo error: ") + std::strerror(errno)};
-                      for (auto& cb : promise->catch_callbacks) {
-                          try { cb(promise->result); } catch(...) {}
-                      }
+                  if (mkfifo(path.c_str(), mode) != 0) {
+                      throw FsPromiseReject{std::string("mkfifo error: ") + std::strerror(errno)};
                   }
+                  return Value{true};
 #else
-                  promise->state = PromiseValue::State::REJECTED;
-                  promise->result = Value{std::string("mkfifo not supported on Windows")};
-                  for (auto& cb : promise->catch_callbacks) {
-                      try { cb(promise->result); } catch(...) {}
-                  }
+                  throw FsPromiseReject{"mkfifo not supported on Windows"};
 #endif
-              });
-      
-              return Value{promise}; }, env);
+              }); }, env);
             promises_obj->properties["mkfifo"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -2086,154 +2190,118 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                 }
                 
                 std::string path = value_to_string_simple(args[0]);
-                Value atime_val = args[1];
-                Value mtime_val = args[2];
                 
-                // Helper to convert Value to time_t
-                auto value_to_time_t = [](const Value& v) -> std::time_t {
+                // Resolve times here: DateTime values must not be read off-thread.
+                // `valid` stays false for unsupported types so the job can
+                // reject with the same message as before.
+                struct TimeArg {
+                    bool set = false;
+                    bool valid = true;
+                    std::time_t value = 0;
+                };
+                auto to_time_arg = [](const Value& v) -> TimeArg {
+                    TimeArg t;
+                    if (std::holds_alternative<std::monostate>(v)) return t;
+                    t.set = true;
                     if (std::holds_alternative<double>(v)) {
                         double millis = std::get<double>(v);
-                        return static_cast<std::time_t>(millis / 1000.0);
+                        t.value = static_cast<std::time_t>(millis / 1000.0);
                     } else if (std::holds_alternative<DateTimePtr>(v)) {
                         DateTimePtr dt = std::get<DateTimePtr>(v);
-                        return static_cast<std::time_t>(dt->epochNanoseconds / 1'000'000'000ULL);
+                        t.value = static_cast<std::time_t>(dt->epochNanoseconds / 1'000'000'000ULL);
                     } else {
-                        throw std::runtime_error("Invalid time type");
+                        t.valid = false;
                     }
+                    return t;
                 };
+                TimeArg at = to_time_arg(args[1]);
+                TimeArg mt = to_time_arg(args[2]);
                 
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
-                
-                scheduler_run_on_loop([promise, path, atime_val, mtime_val, value_to_time_t]() {
-                    try {
-                        if (!fs::exists(path)) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("File does not exist: ") + path};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        bool set_atime = !std::holds_alternative<std::monostate>(atime_val);
-                        bool set_mtime = !std::holds_alternative<std::monostate>(mtime_val);
-                        
-                        if (!set_atime && !set_mtime) {
-                            promise->state = PromiseValue::State::FULFILLED;
-                            promise->result = Value{true};
-                            for (auto& cb : promise->then_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        std::time_t atime = 0;
-                        std::time_t mtime = 0;
-                        
-                        if (set_atime) atime = value_to_time_t(atime_val);
-                        if (set_mtime) mtime = value_to_time_t(mtime_val);
+                return fs_promise_task("setTimes error: ", [path, at, mt]() -> Value {
+                    if (!fs::exists(path)) {
+                        throw FsPromiseReject{"File does not exist: " + path};
+                    }
+                    
+                    bool set_atime = at.set;
+                    bool set_mtime = mt.set;
+                    
+                    if (!set_atime && !set_mtime) {
+                        return Value{true};
+                    }
+                    if (!at.valid || !mt.valid) {
+                        throw std::runtime_error("Invalid time type");
+                    }
+                    
+                    std::time_t atime = at.value;
+                    std::time_t mtime = mt.value;
 
 #ifndef _WIN32
-                        // If only one is set, read current values
-                        if (!set_atime || !set_mtime) {
-                            struct stat st;
-                            if (stat(path.c_str(), &st) != 0) {
-                                promise->state = PromiseValue::State::REJECTED;
-                                promise->result = Value{std::string("Failed to read current timestamps: ") + std::strerror(errno)};
-                                for (auto& cb : promise->catch_callbacks) {
-                                    try { cb(promise->result); } catch(...) {}
-                                }
-                                return;
-                            }
-                            if (!set_atime) atime = st.st_atime;
-                            if (!set_mtime) mtime = st.st_mtime;
-                        }
-                        
-                        struct timeval times[2];
-                        times[0].tv_sec = atime;
-                        times[0].tv_usec = 0;
-                        times[1].tv_sec = mtime;
-                        times[1].tv_usec = 0;
-                        
-                        if (utimes(path.c_str(), times) != 0) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("utimes failed: ") + std::strerror(errno)};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
+                    // If only one is set, read current values
+                    if (!set_atime || !set_mtime) {
+                        struct stat st;
+                        if (stat(path.c_str(), &st) != 0) {
+                            throw FsPromiseReject{std::string("Failed to read current timestamps: ") + std::strerror(errno)};
                         }
+                        if (!set_atime) atime = st.st_atime;
+                        if (!set_mtime) mtime = st.st_mtime;
+                    }
+                    
+                    struct timeval times[2];
+                    times[0].tv_sec = atime;
+                    times[0].tv_usec = 0;
+                    times[1].tv_sec = mtime;
+                    times[1].tv_usec = 0;
+                    
+                    if (utimes(path.c_str(), times) != 0) {
+                        throw FsPromiseReject{std::string("utimes failed: ") + std::strerror(errno)};
+                    }
 #else
-                        // Windows implementation
-                        HANDLE hFile = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES,
-                            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
-                            FILE_FLAG_BACKUP_SEMANTICS, NULL);
-                        
-                        if (hFile == INVALID_HANDLE_VALUE) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Failed to open file")};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        if (!set_atime || !set_mtime) {
-                            FILETIME ftCreate, ftAccess, ftWrite;
-                            if (!GetFileTime(hFile, &ftCreate, &ftAccess, &ftWrite)) {
-                                CloseHandle(hFile);
-                                promise->state = PromiseValue::State::REJECTED;
-                                promise->result = Value{std::string("Failed to read current timestamps")};
-                                for (auto& cb : promise->catch_callbacks) {
-                                    try { cb(promise->result); } catch(...) {}
-                                }
-                                return;
-                            }
-                            
-                            auto filetime_to_unix = [](const FILETIME& ft) -> std::time_t {
-                                ULARGE_INTEGER uli;
-                                uli.LowPart = ft.dwLowDateTime;
-                                uli.HighPart = ft.dwHighDateTime;
-                                const uint64_t EPOCH_DIFF = 116444736000000000ULL;
-                                uint64_t timestamp = (uli.QuadPart - EPOCH_DIFF) / 10000000ULL;
-                                return static_cast<std::time_t>(timestamp);
-                            };
-                            
-                            if (!set_atime) atime = filetime_to_unix(ftAccess);
-                            if (!set_mtime) mtime = filetime_to_unix(ftWrite);
+                    // Windows implementation
+                    HANDLE hFile = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                        FILE_FLAG_BACKUP_SEMANTICS, NULL);
+                    
+                    if (hFile == INVALID_HANDLE_VALUE) {
+                        throw FsPromiseReject{"Failed to open file"};
+                    }
+                    
+                    if (!set_atime || !set_mtime) {
+                        FILETIME ftCreate, ftAccess, ftWrite;
+                        if (!GetFileTime(hFile, &ftCreate, &ftAccess, &ftWrite)) {
+                            CloseHandle(hFile);
+                            throw FsPromiseReject{"Failed to read current timestamps"};
                         }
                         
-                        auto unix_to_filetime = [](std::time_t t) -> FILETIME {
+                        auto filetime_to_unix = [](const FILETIME& ft) -> std::time_t {
+                            ULARGE_INTEGER uli;
+                            uli.LowPart = ft.dwLowDateTime;
+                            uli.HighPart = ft.dwHighDateTime;
                             const uint64_t EPOCH_DIFF = 116444736000000000ULL;
-                            uint64_t temp = (static_cast<uint64_t>(t) * 10000000ULL) + EPOCH_DIFF;
-                            FILETIME ft;
-                            ft.dwLowDateTime = static_cast<DWORD>(temp);
-                            ft.dwHighDateTime = static_cast<DWORD>(temp >> 32);
-                            return ft;
+                            uint64_t timestamp = (uli.QuadPart - EPOCH_DIFF) / 10000000ULL;
+                            return static_cast<std::time_t>(timestamp);
                         };
                         
-                        FILETIME ft_atime = unix_to_filetime(atime);
-                        FILETIME ft_mtime = unix_to_filetime(mtime);
-                        SetFileTime(hFile, NULL, &ft_atime, &ft_mtime);
-                        CloseHandle(hFile);
-#endif
-                        
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{true};
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("setTimes error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
+                        if (!set_atime) atime = filetime_to_unix(ftAccess);
+                        if (!set_mtime) mtime = filetime_to_unix(ftWrite);
                     }
-                });
-                
-                return Value{promise}; }, env);
+                    
+                    auto unix_to_filetime = [](std::time_t t) -> FILETIME {
+                        const uint64_t EPOCH_DIFF = 116444736000000000ULL;
+                        uint64_t temp = (static_cast<uint64_t>(t) * 10000000ULL) + EPOCH_DIFF;
+                        FILETIME ft;
+                        ft.dwLowDateTime = static_cast<DWORD>(temp);
+                        ft.dwHighDateTime = static_cast<DWORD>(temp >> 32);
+                        return ft;
+                    };
+                    
+                    FILETIME ft_atime = unix_to_filetime(atime);
+                    FILETIME ft_mtime = unix_to_filetime(mtime);
+                    SetFileTime(hFile, NULL, &ft_atime, &ft_mtime);
+                    CloseHandle(hFile);
+#endif
+                    
+                    return Value{true};
+                }); }, env);
             promises_obj->properties["setTimes"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
@@ -2253,94 +2321,64 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
                     mode = static_cast<uint32_t>(std::get<double>(args[1]));
                 }
                 
-                auto promise = std::make_shared<PromiseValue>();
-                promise->state = PromiseValue::State::PENDING;
-                
-                scheduler_run_on_loop([promise, path, mode]() {
-                    try {
-                        if (fs::exists(path)) {
-                            auto status = fs::status(path);
-                            
-                            if (fs::is_directory(status)) {
-                                promise->state = PromiseValue::State::REJECTED;
-                                promise->result = Value{std::string("Path is a directory: ") + path};
-                                for (auto& cb : promise->catch_callbacks) {
-                                    try { cb(promise->result); } catch(...) {}
-                                }
-                                return;
-                            }
-                            
-                            if (fs::is_symlink(path)) {
-                                promise->state = PromiseValue::State::REJECTED;
-                                promise->result = Value{std::string("Path is a symlink: ") + path};
-                                for (auto& cb : promise->catch_callbacks) {
-                                    try { cb(promise->result); } catch(...) {}
-                                }
-                                return;
-                            }
-                            
-                            if (!fs::is_regular_file(status)) {
-                                promise->state = PromiseValue::State::REJECTED;
-                                promise->result = Value{std::string("Path is not a regular file: ") + path};
-                                for (auto& cb : promise->catch_callbacks) {
-                                    try { cb(promise->result); } catch(...) {}
-                                }
-                                return;
-                            }
-                            
-                            promise->state = PromiseValue::State::FULFILLED;
-                            promise->result = Value{false};  // Already existed
-                            for (auto& cb : promise->then_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
-                        }
-                        
-                        fs::path file_path(path);
-                        fs::path parent = file_path.parent_path();
+                return fs_promise_task("ensureFile error: ", [path, mode]() -> Value {
+                    if (fs::exists(path)) {
+                        auto status = fs::status(path);
                         
-                        if (!parent.empty() && !fs::exists(parent)) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Parent directory does not exist: ") + parent.string()};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
+                        if (fs::is_directory(status)) {
+                            throw FsPromiseReject{"Path is a directory: " + path};
                         }
-                        
-                        std::ofstream file(path, std::ios::binary);
-                        if (!file.is_open()) {
-                            promise->state = PromiseValue::State::REJECTED;
-                            promise->result = Value{std::string("Failed to create file: ") + path};
-                            for (auto& cb : promise->catch_callbacks) {
-                                try { cb(promise->result); } catch(...) {}
-                            }
-                            return;
+                        if (fs::is_symlink(path)) {
+                            throw FsPromiseReject{"Path is a symlink: " + path};
+                        }
+                        if (!fs::is_regular_file(status)) {
+                            throw FsPromiseReject{"Path is not a regular file: " + path};
                         }
-                        file.close();
+                        return Value{false};  // Already existed
+                    }
+                    
+                    fs::path file_path(path);
+                    fs::path parent = file_path.parent_path();
+                    
+                    if (!parent.empty() && !fs::exists(parent)) {
+                        throw FsPromiseReject{"Parent directory does not exist: " + parent.string()};
+                    }
+                    
+                    std::ofstream file(path, std::ios::binary);
+                    if (!file.is_open()) {
+                        throw FsPromiseReject{"Failed to create file: " + path};
+                    }
+                    file.close();
 
 #ifndef _WIN32
-                        chmod(path.c_str(), mode);
+                    chmod(path.c_str(), mode);
 #endif
-                        
-                        promise->state = PromiseValue::State::FULFILLED;
-                        promise->result = Value{true};  // Created
-                        for (auto& cb : promise->then_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    } catch (const std::exception& e) {
-                        promise->state = PromiseValue::State::REJECTED;
-                        promise->result = Value{std::string("ensureFile error: ") + e.what()};
-                        for (auto& cb : promise->catch_callbacks) {
-                            try { cb(promise->result); } catch(...) {}
-                        }
-                    }
-                });
-                
-                return Value{promise}; }, env);
+                    
+                    return Value{true};  // Created
+                }); }, env);
             promises_obj->properties["ensureFile"] = PropertyDescriptor{fn, false, false, false, Token()};
         }
 
+        // promises.glob(pattern, options?) -> Promise<array>  (same options as fs.glob)
+        {
+            auto fn = make_native_fn("fs.promises.glob", [](const std::vector<Value>& args, EnvPtr /*callEnv*/, const Token& token) -> Value {
+                if (args.empty()) {
+                    throw SwaziError("RuntimeError", "fs.promises.glob requires a pattern argument. Usage: glob(pattern, options?) -> Promise<[matches]>", token.loc);
+                }
+                GlobOptions opts = parse_glob_options(args);
+
+                // The walk collects plain strings; the result array is built
+                // on the worker too since nothing else can see it yet.
+                return fs_promise_task("Glob error: ", [opts, token]() -> Value {
+                    try {
+                        return glob_results_to_array(glob_collect(opts, token));
+                    } catch (const SwaziError& e) {
+                        throw FsPromiseReject{e.what()};
+                    }
+                }); }, env);
+            promises_obj->properties["glob"] = PropertyDescriptor{fn, false, false, false, Token()};
+        }
+
         // Attach promises sub-object to main fs object
         auto fn = make_native_fn("fs.promises", [promises_obj](const std::vector<Value>& /*args*/, EnvPtr /*callEnv*/, const Token& token) -> Value { return Value{promises_obj}; }, env);
         obj->properties["promises"] = PropertyDescriptor{fn, false, true, true, Token()};
@@ -2407,276 +2445,7 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
             throw SwaziError("RuntimeError", "fs.glob requires a pattern argument. Usage: glob(pattern, options?) -> [matches]", token.loc);
         }
         
-        std::string pattern = value_to_string_simple(args[0]);
-        std::string cwd = ".";
-        bool absolute = false;
-        bool onlyFiles = false;
-        bool onlyDirectories = false;
-        bool dot = false;
-        bool followSymlinks = false;
-        int maxDepth = std::numeric_limits<int>::max();
-        std::vector<std::string> ignore_patterns;
-        
-        // Parse options
-        if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
-            ObjectPtr opts = std::get<ObjectPtr>(args[1]);
-            
-            auto cwd_it = opts->properties.find("cwd");
-            if (cwd_it != opts->properties.end() && std::holds_alternative<std::string>(cwd_it->second.value)) {
-                cwd = std::get<std::string>(cwd_it->second.value);
-            }
-            
-            auto abs_it = opts->properties.find("absolute");
-            if (abs_it != opts->properties.end() && std::holds_alternative<bool>(abs_it->second.value)) {
-                absolute = std::get<bool>(abs_it->second.value);
-            }
-            
-            auto files_it = opts->properties.find("onlyFiles");
-            if (files_it != opts->properties.end() && std::holds_alternative<bool>(files_it->second.value)) {
-                onlyFiles = std::get<bool>(files_it->second.value);
-            }
-            
-            auto dirs_it = opts->properties.find("onlyDirectories");
-            if (dirs_it != opts->properties.end() && std::holds_alternative<bool>(dirs_it->second.value)) {
-                onlyDirectories = std::get<bool>(dirs_it->second.value);
-            }
-            
-            auto dot_it = opts->properties.find("dot");
-            if (dot_it != opts->properties.end() && std::holds_alternative<bool>(dot_it->second.value)) {
-                dot = std::get<bool>(dot_it->second.value);
-            }
-            
-            auto symlink_it = opts->properties.find("followSymlinks");
-            if (symlink_it != opts->properties.end() && std::holds_alternative<bool>(symlink_it->second.value)) {
-                followSymlinks = std::get<bool>(symlink_it->second.value);
-            }
-            
-            auto depth_it = opts->properties.find("depth");
-            if (depth_it != opts->properties.end() && std::holds_alternative<double>(depth_it->second.value)) {
-                maxDepth = static_cast<int>(std::get<double>(depth_it->second.value));
-            }
-            
-            // Parse ignore patterns
-            auto ignore_it = opts->properties.find("ignore");
-            if (ignore_it != opts->properties.end()) {
-                if (std::holds_alternative<std::string>(ignore_it->second.value)) {
-                    ignore_patterns.push_back(std::get<std::string>(ignore_it->second.value));
-                } else if (std::holds_alternative<ArrayPtr>(ignore_it->second.value)) {
-                    ArrayPtr arr = std::get<ArrayPtr>(ignore_it->second.value);
-                    for (const auto& elem : arr->elements) {
-                        if (std::holds_alternative<std::string>(elem)) {
-                            ignore_patterns.push_back(std::get<std::string>(elem));
-                        }
-                    }
-                }
-            }
-        }
-        
-        auto result = std::make_shared<ArrayValue>();
-        
-        try {
-            // Validate cwd exists
-            if (!fs::exists(cwd)) {
-                throw SwaziError("IOError", "fs.glob: cwd does not exist: " + cwd, token.loc);
-            }
-            
-            if (!fs::is_directory(cwd)) {
-                throw SwaziError("IOError", "fs.glob: cwd is not a directory: " + cwd, token.loc);
-            }
-            
-            // Helper: check if path should be ignored
-            auto should_ignore = [&](const std::string& relative_path) -> bool {
-                for (const auto& ignore_pattern : ignore_patterns) {
-                    if (matches_pattern(relative_path, ignore_pattern)) {
-                        return true;
-                    }
-                }
-                return false;
-            };
-            
-            // Helper: check if any path component is a dotfile
-            auto has_dotfile_component = [](const std::string& path) -> bool {
-                size_t pos = 0;
-                while (pos < path.length()) {
-                    size_t next_sep = path.find_first_of("/\\", pos);
-                    size_t component_start = pos;
-                    size_t component_end = (next_sep == std::string::npos) ? path.length() : next_sep;
-                    
-                    if (component_end > component_start && path[component_start] == '.') {
-                        return true;
-                    }
-                    
-                    if (next_sep == std::string::npos) break;
-                    pos = next_sep + 1;
-                }
-                return false;
-            };
-            
-            // Helper: enhanced pattern matching for glob
-            auto glob_matches = [](const std::string& path, const std::string& pattern) -> bool {
-                // Special case: pattern ends with /** (matches everything recursively after prefix)
-                if (pattern.length() >= 3 && pattern.substr(pattern.length() - 3) == "/**") {
-                    std::string prefix = pattern.substr(0, pattern.length() - 3);
-                    if (prefix.empty()) {
-                        return true; // "**" matches everything
-                    }
-                    // Check if path starts with prefix and has content after it
-                    if (path.find(prefix) == 0) {
-                        // Path must either equal prefix or have / after prefix
-                        if (path.length() == prefix.length()) {
-                            return false; // "src/**" doesn't match "src" itself
-                        }
-                        if (path.length() > prefix.length() && path[prefix.length()] == '/') {
-                            return true;
-                        }
-                    }
-                    return false;
-                }
-                
-                // Otherwise use standard pattern matching
-                return matches_pattern(path, pattern);
-            };
-            
-            // Check if pattern has ** (globstar - recursive wildcard)
-            bool has_globstar = (pattern.find("**") != std::string::npos);
-            
-            if (!has_globstar) {
-                // ============= NON-RECURSIVE GLOB =============
-                fs::path pattern_path(pattern);
-                fs::path search_base = fs::path(cwd);
-                
-                // Split pattern into parts
-                std::vector<std::string> parts;
-                for (const auto& part : pattern_path) {
-                    parts.push_back(part.string());
-                }
-                
-                // Recursive function to match each level
-                std::function<void(const fs::path&, size_t)> match_level;
-                match_level = [&](const fs::path& current_dir, size_t part_idx) {
-                    if (part_idx >= parts.size()) return;
-                    
-                    std::string current_pattern = parts[part_idx];
-                    bool is_last = (part_idx == parts.size() - 1);
-                    
-                    try {
-                        for (auto& entry : fs::directory_iterator(current_dir)) {
-                            // Handle symlinks
-                            if (fs::is_symlink(entry) && !followSymlinks) {
-                                continue;
-                            }
-                            
-                            std::string name = entry.path().filename().string();
-                            std::string relative_path = fs::relative(entry.path(), cwd).string();
-                            std::replace(relative_path.begin(), relative_path.end(), '\\', '/');
-                            
-                            // Check ignore patterns first
-                            if (should_ignore(relative_path) || should_ignore(name)) {
-                                continue;
-                            }
-                            
-                            // Match pattern
-                            if (matches_pattern(name, current_pattern)) {
-                                if (is_last) {
-                                    // Check dotfile AFTER pattern match
-                                    if (!dot && has_dotfile_component(relative_path)) {
-                                        continue;
-                                    }
-                                    
-                                    // Last part - this is a potential match
-                                    bool is_file = entry.is_regular_file();
-                                    bool is_dir = entry.is_directory();
-                                    
-                                    // Apply type filters
-                                    if (onlyFiles && !is_file) continue;
-                                    if (onlyDirectories && !is_dir) continue;
-                                    
-                                    std::string path_to_add = absolute ? 
-                                        fs::absolute(entry.path()).string() : 
-                                        relative_path;
-                                    
-                                    result->elements.push_back(Value{path_to_add});
-                                } else {
-                                    // Not last part - continue if directory
-                                    if (entry.is_directory()) {
-                                        match_level(entry.path(), part_idx + 1);
-                                    }
-                                }
-                            }
-                        }
-                    } catch (const fs::filesystem_error&) {
-                        // Skip directories we can't read
-                    }
-                };
-                
-                match_level(search_base, 0);
-                
-            } else {
-                // ============= RECURSIVE GLOB (with **) =============
-                
-                std::function<void(const fs::path&, int)> walk;
-                walk = [&](const fs::path& dir, int depth) {
-                    if (depth > maxDepth) return;
-                    
-                    try {
-                        for (auto& entry : fs::directory_iterator(dir)) {
-                            // Handle symlinks
-                            if (fs::is_symlink(entry) && !followSymlinks) {
-                                continue;
-                            }
-                            
-                            std::string name = entry.path().filename().string();
-                            std::string relative_path = fs::relative(entry.path(), cwd).string();
-                            // Normalize path separators
-                            std::replace(relative_path.begin(), relative_path.end(), '\\', '/');
-                            
-                            // Check ignore patterns first
-                            if (should_ignore(relative_path) || should_ignore(name)) {
-                                continue;
-                            }
-                            
-                            // Check if matches pattern using enhanced matching
-                            if (glob_matches(relative_path, pattern)) {
-                                // Check dotfile AFTER pattern match
-                                if (!dot && has_dotfile_component(relative_path)) {
-                                    continue;
-                                }
-                                
-                                bool is_file = entry.is_regular_file();
-                                bool is_dir = entry.is_directory();
-                                
-                                // Apply type filters to output
-                                bool should_add = true;
-                                if (onlyFiles && !is_file) should_add = false;
-                                if (onlyDirectories && !is_dir) should_add = false;
-                                
-                                if (should_add) {
-                                    std::string path_to_add = absolute ? 
-                                        fs::absolute(entry.path()).string() : 
-                                        relative_path;
-                                    
-                                    result->elements.push_back(Value{path_to_add});
-                                }
-                            }
-                            
-                            // ALWAYS recurse into directories (regardless of filters)
-                            if (entry.is_directory()) {
-                                walk(entry.path(), depth + 1);
-                            }
-                        }
-                    } catch (const fs::filesystem_error&) {
-                        // Skip directories we can't read
-                    }
-                };
-                
-                walk(fs::path(cwd), 0);
-            }
-            
-        } catch (const fs::filesystem_error& e) {
-            throw SwaziError("FilesystemError", std::string("fs.glob failed: ") + e.what(), token.loc);
-        }
-        
-        return Value{result}; }, env);
+        return glob_results_to_array(glob_collect(parse_glob_options(args), token)); }, env);
         obj->properties["glob"] = PropertyDescriptor{fn, false, false, true, Token()};
     }
 
@@ -2684,5 +2453,5 @@ std::shared_ptr<ObjectValue> make_fs_exports(EnvPtr env) {
 }
 
 bool fs_has_active_work() {
-    return g_active_fs_watchers.load() > 0;
+    return g_active_fs_watchers.load() > 0 || g_active_fs_requests > 0;
 }
\ No newline at end of file
@@ -0,0 +1,544 @@
+// http_bench.cc - http.bench: a native load generator for local servers
+//
+// http.bench(opts) -> Promise<result>
+//
+// Drives an http server (usually one created by the same script) over
+// loopback from the calling thread's loop.  Everything on the client side is
+// native: the request is built once and shared by every write, responses are
+// parsed with llhttp, and latencies go into a LatencyHistogram, so the script
+// values allocated during a run are the server's.  Nothing is resolved through
+// DNS and nothing leaves the machine, which makes it usable as a release gate.
+#include <llhttp.h>
+#include <uv.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "AsyncBridge.hpp"
+#include "LatencyHistogram.hpp"
+#include "SwaziError.hpp"
+#include "UvBuffers.hpp"
+#include "builtins.hpp"
+#include "evaluator.hpp"
+#include "memory_tracking.hpp"
+
+// ============================================================================
+// OPTIONS
+// ============================================================================
+
+struct BenchOptions {
+    std::string host = "127.0.0.1";
+    int port = 0;
+    std::string path = "/";
+    std::string method = "GET";
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    int connections = 8;
+    int pipelining = 1;     // requests in flight per connection
+    bool keep_alive = true;  // false: a new connection for every request
+    uint64_t requests = 0;   // measured requests; 0 = run for duration_ms
+    uint64_t duration_ms = 0;
+    uint64_t warmup = 0;  // requests completed before measuring starts
+    uint64_t timeout_ms = 10000;  // no response for this long ends the run
+};
+
+// "http://host:port/path" into host, port and path.  https is not supported:
+// the point is the server's cost, not OpenSSL's.
+static void parse_bench_url(const std::string& url, BenchOptions& o, const Token& token) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        throw SwaziError("ValueError", "http.bench: url must start with http://", token.loc);
+    }
+    size_t host_start = scheme.size();
+    size_t path_start = url.find('/', host_start);
+    std::string authority = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+    o.path = path_start == std::string::npos ? "/" : url.substr(path_start);
+
+    std::string port;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) throw SwaziError("ValueError", "http.bench: bad IPv6 address in url", token.loc);
+        o.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') port = authority.substr(close + 2);
+    } else {
+        size_t colon = authority.rfind(':');
+        o.host = authority.substr(0, colon);
+        if (colon != std::string::npos) port = authority.substr(colon + 1);
+    }
+    o.port = port.empty() ? 80 : std::atoi(port.c_str());
+    if (o.port <= 0 || o.port > 65535) throw SwaziError("ValueError", "http.bench: bad port in url", token.loc);
+}
+
+static BenchOptions parse_bench_options(const ObjectPtr& opts, const Token& token) {
+    BenchOptions o;
+    auto get = [&](const char* key) -> const Value* {
+        auto it = opts->properties.find(key);
+        return it == opts->properties.end() ? nullptr : &it->second.value;
+    };
+    auto count = [&](const char* key, double min) -> std::optional<double> {
+        const Value* v = get(key);
+        if (!v || std::holds_alternative<std::monostate>(*v)) return std::nullopt;
+        if (!std::holds_alternative<double>(*v) || std::get<double>(*v) < min) {
+            throw SwaziError("RangeError", std::string("http.bench: ") + key + " must be a number >= " + std::to_string(static_cast<int>(min)), token.loc);
+        }
+        return std::get<double>(*v);
+    };
+
+    if (const Value* v = get("url"); v && std::holds_alternative<std::string>(*v)) {
+        parse_bench_url(std::get<std::string>(*v), o, token);
+    } else if (auto port = count("port", 1)) {
+        o.port = static_cast<int>(*port);
+        if (const Value* h = get("host"); h && std::holds_alternative<std::string>(*h)) o.host = std::get<std::string>(*h);
+        if (const Value* p = get("path"); p && std::holds_alternative<std::string>(*p)) o.path = std::get<std::string>(*p);
+    } else {
+        throw SwaziError("TypeError", "http.bench requires url or port", token.loc);
+    }
+    if (o.host == "localhost") o.host = "127.0.0.1";
+
+    if (const Value* v = get("method"); v && std::holds_alternative<std::string>(*v)) {
+        o.method = std::get<std::string>(*v);
+        for (auto& c : o.method) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (const Value* v = get("headers"); v && std::holds_alternative<ObjectPtr>(*v)) {
+        for (const auto& kv : std::get<ObjectPtr>(*v)->properties) {
+            if (std::holds_alternative<std::string>(kv.second.value)) {
+                o.headers.emplace_back(kv.first, std::get<std::string>(kv.second.value));
+            } else if (std::holds_alternative<double>(kv.second.value)) {
+                o.headers.emplace_back(kv.first, std::to_string(static_cast<long long>(std::get<double>(kv.second.value))));
+            }
+        }
+    }
+    if (const Value* v = get("body")) {
+        if (std::holds_alternative<std::string>(*v)) {
+            o.body = std::get<std::string>(*v);
+        } else if (std::holds_alternative<BufferPtr>(*v)) {
+            const auto& data = std::get<BufferPtr>(*v)->data;
+            o.body.assign(data.begin(), data.end());
+        }
+    }
+    if (auto n = count("bodySize", 0)) o.body.assign(static_cast<size_t>(*n), 'x');
+
+    if (auto n = count("connections", 1)) o.connections = static_cast<int>(std::min(*n, 10000.0));
+    if (auto n = count("pipelining", 1)) o.pipelining = static_cast<int>(std::min(*n, 1024.0));
+    if (const Value* v = get("keepAlive"); v && std::holds_alternative<bool>(*v)) o.keep_alive = std::get<bool>(*v);
+    if (auto n = count("requests", 1)) o.requests = static_cast<uint64_t>(*n);
+    if (auto n = count("duration", 1)) o.duration_ms = static_cast<uint64_t>(*n);
+    if (auto n = count("warmup", 0)) o.warmup = static_cast<uint64_t>(*n);
+    if (auto n = count("timeout", 1)) o.timeout_ms = static_cast<uint64_t>(*n);
+
+    if (o.requests == 0 && o.duration_ms == 0) o.duration_ms = 5000;
+    if (!o.keep_alive) o.pipelining = 1;  // one request per connection
+    return o;
+}
+
+// The request every connection sends, built once.
+static std::shared_ptr<std::string> build_bench_request(const BenchOptions& o) {
+    std::string r;
+    r.reserve(256 + o.body.size());
+    r += o.method + " " + o.path + " HTTP/1.1\r\n";
+    r += "Host: " + o.host + ":" + std::to_string(o.port) + "\r\n";
+    if (!o.keep_alive) r += "Connection: close\r\n";
+    for (const auto& h : o.headers) r += h.first + ": " + h.second + "\r\n";
+    if (!o.body.empty() || o.method == "POST" || o.method == "PUT" || o.method == "PATCH") {
+        r += "Content-Length: " + std::to_string(o.body.size()) + "\r\n";
+    }
+    r += "\r\n";
+    r += o.body;
+    return std::make_shared<std::string>(std::move(r));
+}
+
+// ============================================================================
+// RUN
+// ============================================================================
+
+struct BenchRun;
+
+// One client socket.  Requests go out back to back up to the pipelining depth;
+// their send times queue in sent_at and responses, which arrive in order, pop
+// them off.
+struct BenchConn {
+    std::shared_ptr<BenchRun> run;
+    uv_tcp_t tcp;
+    uv_connect_t connect_req;
+    llhttp_t parser;
+    std::deque<uint64_t> sent_at;  // uv_hrtime() of each request in flight
+    bool connected = false;
+    bool closing = false;
+    bool close_after = false;  // the server or keepAlive: false ends it after this response
+};
+
+struct BenchRun : public std::enable_shared_from_this<BenchRun> {
+    BenchOptions opts;
+    std::shared_ptr<std::string> request;  // shared by every write; never modified
+    PromisePtr promise;
+    uv_loop_t* loop = nullptr;
+    llhttp_settings_t settings;
+    uv_timer_t* timer = nullptr;
+    std::shared_ptr<BenchRun> self;  // held from start() to finish() for the timer
+
+    std::vector<BenchConn*> conns;
+    bool running = true;
+    bool settled = false;
+
+    uint64_t issued = 0;
+    uint64_t completed = 0;  // including warmup
+    uint64_t errors = 0;
+    uint64_t timeouts = 0;
+    uint64_t connects = 0;
+    uint64_t bytes_read = 0;
+    uint64_t deadline = 0;         // uv_hrtime(), duration runs
+    uint64_t last_progress = 0;    // uv_hrtime() of the last response
+    std::string first_error;
+
+    // Measured window, starting once warmup is done.
+    uint64_t measure_start = 0;
+    uint64_t measure_bytes = 0;
+    size_t objects_base = 0;
+    size_t functions_base = 0;
+    LatencyHistogram latency;
+    std::map<int, uint64_t> status_counts;
+
+    uint64_t total() const { return opts.warmup + opts.requests; }
+
+    bool may_issue(uint64_t now) const {
+        if (!running) return false;
+        if (opts.requests) return issued < total();
+        return measure_start == 0 || now < deadline;  // the clock starts after warmup
+    }
+
+    void begin_measuring(uint64_t now) {
+        measure_start = now;
+        measure_bytes = 0;
+        objects_base = MemoryTracking::g_objects_allocated.load();
+        functions_base = MemoryTracking::g_functions_allocated.load();
+        if (opts.duration_ms) deadline = now + opts.duration_ms * 1000000ull;
+    }
+
+    void start();
+    void open_conn();
+    void fill(BenchConn* c);
+    void close_conn(BenchConn* c);
+    void on_response(BenchConn* c, int status);
+    void connection_failed(BenchConn* c, const std::string& why);
+    void check_done();
+    void tick();
+    void finish();
+    Value result_value();
+};
+
+static void bench_alloc(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+    read_pool_alloc(handle, suggested, buf);
+}
+
+static int bench_on_message_complete(llhttp_t* parser) {
+    auto* c = static_cast<BenchConn*>(parser->data);
+    if (!llhttp_should_keep_alive(parser)) c->close_after = true;
+    c->run->on_response(c, parser->status_code);
+    return 0;
+}
+
+static void bench_on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    auto* c = static_cast<BenchConn*>(stream->data);
+    BenchRun* run = c->run.get();
+
+    if (nread > 0) {
+        run->bytes_read += static_cast<uint64_t>(nread);
+        run->measure_bytes += static_cast<uint64_t>(nread);
+        llhttp_errno_t err = llhttp_execute(&c->parser, buf->base, static_cast<size_t>(nread));
+        read_pool_release(buf);
+        if (err != HPE_OK) {
+            run->connection_failed(c, std::string("bad response: ") + llhttp_errno_name(err));
+            return;
+        }
+        if (c->close_after) {
+            run->close_conn(c);
+            if (run->running) run->open_conn();
+            run->check_done();
+            return;
+        }
+        run->fill(c);
+        return;
+    }
+
+    read_pool_release(buf);
+    if (nread == 0) return;
+    if (nread == UV_EOF) llhttp_finish(&c->parser);  // a body delimited by the close
+    if (!c->sent_at.empty()) {
+        run->connection_failed(c, nread == UV_EOF ? "connection closed with requests in flight" : uv_strerror(static_cast<int>(nread)));
+        return;
+    }
+    run->close_conn(c);
+    if (run->running) run->open_conn();
+    run->check_done();
+}
+
+void BenchRun::start() {
+    llhttp_settings_init(&settings);
+    settings.on_message_complete = bench_on_message_complete;
+
+    uint64_t now = uv_hrtime();
+    last_progress = now;
+    if (opts.warmup == 0) begin_measuring(now);
+
+    self = shared_from_this();
+    timer = new uv_timer_t;
+    uv_timer_init(loop, timer);
+    timer->data = this;
+    uv_timer_start(timer, [](uv_timer_t* t) { static_cast<BenchRun*>(t->data)->tick(); }, 50, 50);
+
+    for (int i = 0; i < opts.connections; i++) open_conn();
+}
+
+void BenchRun::open_conn() {
+    if (!running) return;
+    // Enough sockets for the requests that are left.
+    if (opts.requests && (issued >= total() || (!conns.empty() && issued + conns.size() >= total()))) return;
+
+    auto* c = new BenchConn();
+    c->run = shared_from_this();
+    uv_tcp_init(loop, &c->tcp);
+    c->tcp.data = c;
+    c->connect_req.data = c;
+    llhttp_init(&c->parser, HTTP_RESPONSE, &settings);
+    c->parser.data = c;
+    conns.push_back(c);
+    connects++;
+
+    struct sockaddr_storage addr;
+    int r = opts.host.find(':') != std::string::npos
+        ? uv_ip6_addr(opts.host.c_str(), opts.port, reinterpret_cast<sockaddr_in6*>(&addr))
+        : uv_ip4_addr(opts.host.c_str(), opts.port, reinterpret_cast<sockaddr_in*>(&addr));
+    if (r == 0) {
+        r = uv_tcp_connect(&c->connect_req, &c->tcp, reinterpret_cast<const sockaddr*>(&addr), [](uv_connect_t* req, int status) {
+            auto* c = static_cast<BenchConn*>(req->data);
+            BenchRun* run = c->run.get();
+            if (c->closing) return;
+            if (status < 0) {
+                run->connection_failed(c, std::string("connect failed: ") + uv_strerror(status));
+                return;
+            }
+            c->connected = true;
+            uv_tcp_nodelay(&c->tcp, 1);
+            uv_read_start(reinterpret_cast<uv_stream_t*>(&c->tcp), bench_alloc, bench_on_read);
+            run->fill(c);
+        });
+    }
+    if (r != 0) connection_failed(c, std::string("connect failed: ") + uv_strerror(r));
+}
+
+// Top the connection up to the pipelining depth, all in one gathered write.
+void BenchRun::fill(BenchConn* c) {
+    if (!c->connected || c->closing) return;
+    uint64_t now = uv_hrtime();
+    uv_buf_t bufs[64];
+    unsigned int n = 0;
+    while (c->sent_at.size() < static_cast<size_t>(opts.pipelining) && may_issue(now)) {
+        c->sent_at.push_back(now);
+        issued++;
+        bufs[n++] = uv_buf_init(const_cast<char*>(request->data()), static_cast<unsigned int>(request->size()));
+        if (n == 64) {
+            stream_write_gather(reinterpret_cast<uv_stream_t*>(&c->tcp), bufs, n, request, nullptr);
+            n = 0;
+        }
+    }
+    if (n > 0) stream_write_gather(reinterpret_cast<uv_stream_t*>(&c->tcp), bufs, n, request, nullptr);
+    if (c->sent_at.empty() && !running) check_done();
+}
+
+void BenchRun::on_response(BenchConn* c, int status) {
+    uint64_t now = uv_hrtime();
+    last_progress = now;
+    if (c->sent_at.empty()) return;  // a response nobody asked for
+    uint64_t sent = c->sent_at.front();
+    c->sent_at.pop_front();
+    completed++;
+
+    if (completed <= opts.warmup) {
+        if (completed == opts.warmup) begin_measuring(now);
+        return;
+    }
+    latency.record((now - sent) / 1000);
+    status_counts[status]++;
+}
+
+void BenchRun::close_conn(BenchConn* c) {
+    if (c->closing) return;
+    c->closing = true;
+    conns.erase(std::remove(conns.begin(), conns.end(), c), conns.end());
+    uv_close(reinterpret_cast<uv_handle_t*>(&c->tcp), [](uv_handle_t* h) {
+        delete static_cast<BenchConn*>(h->data);
+    });
+}
+
+// Requests in flight on a broken connection count as errors.  The run goes on
+// with a fresh connection unless the server was never reachable at all.
+void BenchRun::connection_failed(BenchConn* c, const std::string& why) {
+    if (first_error.empty()) first_error = why;
+    errors += std::max<uint64_t>(c->sent_at.size(), 1);
+    close_conn(c);
+    if (completed == 0 && !c->connected) {
+        running = false;
+        finish();
+        return;
+    }
+    if (running) open_conn();
+    check_done();
+}
+
+void BenchRun::check_done() {
+    if (settled) return;
+    uint64_t now = uv_hrtime();
+    if (running && !may_issue(now)) running = false;
+    if (running) return;
+    for (BenchConn* c : conns) {
+        if (!c->sent_at.empty()) return;
+    }
+    finish();
+}
+
+// Every 50ms: stop issuing at the deadline and give up on a stalled server.
+void BenchRun::tick() {
+    uint64_t now = uv_hrtime();
+    bool in_flight = false;
+    for (BenchConn* c : conns) in_flight = in_flight || !c->sent_at.empty();
+    if (in_flight && now - last_progress > opts.timeout_ms * 1000000ull) {
+        for (BenchConn* c : conns) timeouts += c->sent_at.size();
+        if (first_error.empty()) first_error = "timed out waiting for responses";
+        running = false;
+        finish();
+        return;
+    }
+    check_done();
+}
+
+void BenchRun::finish() {
+    if (settled) return;
+    settled = true;
+    running = false;
+
+    std::vector<BenchConn*> open(conns.begin(), conns.end());
+    for (BenchConn* c : open) close_conn(c);
+    if (timer) {
+        uv_timer_stop(timer);
+        uv_close(reinterpret_cast<uv_handle_t*>(timer), [](uv_handle_t* h) { delete reinterpret_cast<uv_timer_t*>(h); });
+        timer = nullptr;
+    }
+    std::shared_ptr<BenchRun> hold = std::move(self);  // released on return
+
+    if (latency.count() == 0 && !first_error.empty()) {
+        promise->state = PromiseValue::State::REJECTED;
+        promise->result = Value{"http.bench: " + first_error};
+    } else {
+        promise->state = PromiseValue::State::FULFILLED;
+        promise->result = result_value();
+    }
+    PromisePtr p = promise;
+    scheduler_enqueue_microtask([p]() {
+        auto cbs = p->state == PromiseValue::State::FULFILLED ? p->then_callbacks : p->catch_callbacks;
+        for (auto& cb : cbs) {
+            try {
+                cb(p->result);
+            } catch (...) {}
+        }
+    });
+}
+
+static void set_field(const ObjectPtr& o, const std::string& key, Value v) {
+    o->properties[key] = {std::move(v), false, false, true, Token{}};
+}
+
+static double micros_to_ms(uint64_t us) { return static_cast<double>(us) / 1000.0; }
+
+Value BenchRun::result_value() {
+    // Read first: the result itself is made of script values.
+    size_t objects = MemoryTracking::g_objects_allocated.load() - objects_base;
+    size_t functions = MemoryTracking::g_functions_allocated.load() - functions_base;
+    uint64_t now = uv_hrtime();
+    double elapsed_s = measure_start ? static_cast<double>(now - measure_start) / 1e9 : 0.0;
+    uint64_t measured = latency.count();
+
+    auto o = std::make_shared<ObjectValue>();
+    set_field(o, "requests", Value{static_cast<double>(measured)});
+    set_field(o, "errors", Value{static_cast<double>(errors)});
+    set_field(o, "timeouts", Value{static_cast<double>(timeouts)});
+    set_field(o, "connections", Value{static_cast<double>(connects)});
+    set_field(o, "durationMs", Value{elapsed_s * 1000.0});
+    set_field(o, "requestsPerSec", Value{elapsed_s > 0 ? static_cast<double>(measured) / elapsed_s : 0.0});
+    set_field(o, "bytesRead", Value{static_cast<double>(measure_bytes)});
+    set_field(o, "bytesPerSec", Value{elapsed_s > 0 ? static_cast<double>(measure_bytes) / elapsed_s : 0.0});
+    if (!first_error.empty()) set_field(o, "firstError", Value{first_error});
+
+    // Milliseconds, like every other duration the runtime reports.
+    auto lat = std::make_shared<ObjectValue>();
+    set_field(lat, "min", Value{micros_to_ms(latency.min())});
+    set_field(lat, "mean", Value{latency.mean() / 1000.0});
+    set_field(lat, "p50", Value{micros_to_ms(latency.percentile(0.50))});
+    set_field(lat, "p90", Value{micros_to_ms(latency.percentile(0.90))});
+    set_field(lat, "p99", Value{micros_to_ms(latency.percentile(0.99))});
+    set_field(lat, "p999", Value{micros_to_ms(latency.percentile(0.999))});
+    set_field(lat, "max", Value{micros_to_ms(latency.max())});
+    set_field(o, "latency", Value{lat});
+
+    auto hist = std::make_shared<ArrayValue>();
+    for (const auto& b : latency.buckets()) {
+        auto row = std::make_shared<ObjectValue>();
+        set_field(row, "upto", Value{micros_to_ms(b.upto)});
+        set_field(row, "count", Value{static_cast<double>(b.count)});
+        hist->elements.push_back(Value{row});
+    }
+    set_field(o, "histogram", Value{hist});
+
+    auto status = std::make_shared<ObjectValue>();
+    for (const auto& kv : status_counts) set_field(status, std::to_string(kv.first), Value{static_cast<double>(kv.second)});
+    set_field(o, "status", Value{status});
+
+    // Script values created anywhere in the process while measuring: with the
+    // server in this process, that is what its handler path allocates.
+    auto allocs = std::make_shared<ObjectValue>();
+    set_field(allocs, "objects", Value{static_cast<double>(objects)});
+    set_field(allocs, "functions", Value{static_cast<double>(functions)});
+    set_field(allocs, "perRequest", Value{measured ? static_cast<double>(objects + functions) / static_cast<double>(measured) : 0.0});
+    set_field(o, "allocations", Value{allocs});
+
+    return Value{o};
+}
+
+// ============================================================================
+// EXPORT
+// ============================================================================
+
+// http.bench({ url | port/host/path, method, headers, body | bodySize,
+//              connections, pipelining, keepAlive, requests | duration,
+//              warmup, timeout }) -> Promise<result>
+Value native_httpBench(const std::vector<Value>& args, EnvPtr, const Token& token, Evaluator*) {
+    if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0])) {
+        throw SwaziError("TypeError", "http.bench requires an options object", token.loc);
+    }
+    BenchOptions opts = parse_bench_options(std::get<ObjectPtr>(args[0]), token);
+
+    auto run = std::make_shared<BenchRun>();
+    run->opts = std::move(opts);
+    run->request = build_bench_request(run->opts);
+    run->promise = std::make_shared<PromiseValue>();
+    run->promise->state = PromiseValue::State::PENDING;
+    PromisePtr promise = run->promise;
+
+    uv_loop_t* loop = scheduler_get_loop();
+    if (!loop) {
+        promise->state = PromiseValue::State::REJECTED;
+        promise->result = Value{std::string("http.bench: no event loop available")};
+        return Value{promise};
+    }
+    run->loop = loop;
+    // The connections and the timer hold the run; the loop keeps them alive.
+    scheduler_run_on_loop([run]() { run->start(); });
+    return Value{promise};
+}
@@ -5,19 +5,27 @@
 #include <llhttp.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <regex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../streams/streams.h"
 #include "AsyncBridge.hpp"
+#include "DnsResolver.hpp"
+#include "HttpAgent.hpp"
 #include "Scheduler.hpp"
 #include "SwaziError.hpp"
+#include "ZlibStream.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -145,10 +153,53 @@ struct WriteRequest {
     size_t body_bytes = 0;
 };
 
-struct HttpClientRequest {
+struct HttpClientRequest;
+struct HttpOriginPool;
+
+// One TCP (optionally TLS) connection.  `req` is the request that owns it;
+// idle pooled connections have none and keep reading only to notice the
+// server closing them.
+struct HttpClientConn {
     uv_tcp_t socket;
     uv_connect_t connect_req;
 
+    HttpOriginPool* pool = nullptr;
+    HttpClientRequest* req = nullptr;
+    bool pooled = false;       // counted by the pool and returned to it
+    bool closing = false;
+    bool resolving = false;    // a DNS lookup still refers to this connection
+    bool handle_closed = false;
+    uint64_t idle_since = 0;   // uv_now() when it went idle
+    uint64_t generation = 0;   // bumped whenever `req` changes hands
+
+#ifdef HAVE_OPENSSL
+    SSL* ssl = nullptr;
+    BIO* bio_read = nullptr;
+    BIO* bio_write = nullptr;
+#endif
+};
+
+// Connections to one scheme://host:port.  At most max_sockets are busy;
+// further requests wait in `waiting` for one to be released.
+struct HttpOriginPool {
+    std::string key;
+    std::string host;
+    int port = 0;
+    bool use_ssl = false;
+
+    size_t busy = 0;
+    std::vector<HttpClientConn*> idle;  // most recently used last
+    std::deque<HttpClientRequest*> waiting;
+
+#ifdef HAVE_OPENSSL
+    SSL_SESSION* session = nullptr;  // resumed by the next handshake
+#endif
+};
+
+struct HttpClientRequest {
+    HttpClientConn* conn = nullptr;
+    HttpOriginPool* pool = nullptr;
+
     llhttp_t parser;
     llhttp_settings_t settings;
 
@@ -195,14 +246,21 @@ struct HttpClientRequest {
     uint64_t file_bytes_sent = 0;
     std::vector<uint8_t> file_read_buffer;
 
-    // HTTPS support
     bool use_ssl = false;
-#ifdef HAVE_OPENSSL
-    SSL* ssl = nullptr;
-    SSL_CTX* ssl_ctx = nullptr;
-    BIO* bio_read = nullptr;
-    BIO* bio_write = nullptr;
-#endif
+
+    // Keep-alive
+    bool use_agent = true;         // false for {agent: false}
+    bool reused = false;           // running on a pooled connection
+    bool retried = false;
+    bool bytes_written = false;    // some of the request reached the socket
+    bool connect_emitted = false;
+    bool response_started = false;
+    bool keep_conn = false;        // release the connection instead of closing it
+
+    // Content-Encoding: gzip / deflate responses are decoded before "data"
+    // ({decompress: false} turns this off).  Progress counts wire bytes.
+    bool decompress = true;
+    std::unique_ptr<ZlibStream> decoder;
 };
 
 // ============================================================================
@@ -220,7 +278,15 @@ static void stream_next_file_chunk(HttpClientRequest* req);
 
 static void close_connection(HttpClientRequest* req, bool emit_close_event);
 
-static void cleanup_ssl(HttpClientRequest* req);
+static void close_conn(HttpClientConn* conn);
+
+static void agent_acquire(HttpClientRequest* req, bool fresh_only = false);
+
+static void send_request_head(HttpClientRequest* req);
+
+static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
+
+static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
 
 // ============================================================================
 // GLOBAL STATE
@@ -247,6 +313,8 @@ static std::string value_to_string_simple_http(const Value& v) {
     return std::string();
 }
 
+static void agent_release(HttpClientConn* conn);
+
 static void close_connection_internal(HttpClientRequest* req, bool emit_close_event) {
     // This MUST be called on the event loop thread
 
@@ -266,24 +334,23 @@ static void close_connection_internal(HttpClientRequest* req, bool emit_close_ev
         emit_event(handlers, "close");
     }
 
-#ifdef HAVE_OPENSSL
-    if (req->use_ssl) {
-        cleanup_ssl(req);
+    // Hand the connection back to its pool after a clean keep-alive
+    // exchange; close it otherwise.  Still waiting for one: leave the queue.
+    HttpClientConn* conn = req->conn;
+    req->conn = nullptr;
+    if (conn) {
+        if (req->keep_conn && conn->pooled && !conn->closing) {
+            agent_release(conn);
+        } else {
+            close_conn(conn);
+        }
+    } else if (req->pool) {
+        auto& waiting = req->pool->waiting;
+        waiting.erase(std::remove(waiting.begin(), waiting.end(), req), waiting.end());
     }
-#endif
 
-    // Close the socket handle
-    // The deletion happens in the uv_close callback
-    if (!uv_is_closing((uv_handle_t*)&req->socket)) {
-        uv_close((uv_handle_t*)&req->socket, [](uv_handle_t* handle) {
-            auto* req = static_cast<HttpClientRequest*>(handle->data);
-            delete req;
-        });
-    } else {
-        // Socket is already closing, just delete
-        // This shouldn't normally happen with proper coordination
-        // delete req;
-    }
+    // Deferred so tasks already queued for this request still see it
+    scheduler_run_on_loop([req]() { delete req; });
 }
 
 // ============================================================================
@@ -333,78 +400,416 @@ static void emit_event(std::shared_ptr<StreamEventHandlers> handlers,
     });
 }
 
+// ============================================================================
+// SOCKET WRITES
+// ============================================================================
+
+// One uv_write on a connection.  `generation` ties it to the request that
+// owned the connection when it was issued, so a completion arriving after
+// the connection was handed to the next request is only freed.
+struct ConnWrite {
+    uv_write_t req;
+    char* data;
+    HttpClientConn* conn;
+    uint64_t generation;
+};
+
+// Write `len` malloc'd bytes to the connection, taking ownership of them.
+static int conn_write(HttpClientConn* conn, char* data, size_t len, uv_write_cb cb) {
+    auto* w = new ConnWrite{};
+    w->req.data = w;
+    w->data = data;
+    w->conn = conn;
+    w->generation = conn->generation;
+
+    uv_buf_t buf = uv_buf_init(data, (unsigned int)len);
+    int r = uv_write(&w->req, (uv_stream_t*)&conn->socket, &buf, 1, cb);
+    if (r < 0) {
+        free(data);
+        delete w;
+    }
+    return r;
+}
+
 // ============================================================================
 // SSL/TLS SUPPORT
 // ============================================================================
 
 #ifdef HAVE_OPENSSL
-static void init_openssl() {
-    static bool initialized = false;
-    if (!initialized) {
+static int on_new_session(SSL* ssl, SSL_SESSION* session) {
+    // Keep the newest session per origin; returning 1 takes ownership.
+    auto* conn = static_cast<HttpClientConn*>(SSL_get_app_data(ssl));
+    if (!conn || !conn->pool) return 0;
+    if (conn->pool->session) SSL_SESSION_free(conn->pool->session);
+    conn->pool->session = session;
+    return 1;
+}
+
+// One client context for the whole process.  Sessions are stored per
+// origin through on_new_session rather than in OpenSSL's internal cache,
+// which clients never look up by themselves.
+static SSL_CTX* client_ssl_ctx() {
+    static SSL_CTX* ctx = [] {
         SSL_library_init();
         SSL_load_error_strings();
         OpenSSL_add_all_algorithms();
-        initialized = true;
-    }
+
+        SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+        if (!c) return c;
+        SSL_CTX_set_verify(c, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_options(c, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+        SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(c, on_new_session);
+        return c;
+    }();
+    return ctx;
 }
 
-static bool setup_ssl(HttpClientRequest* req) {
-    init_openssl();
+static bool setup_ssl(HttpClientConn* conn, const std::string& host) {
+    SSL_CTX* ctx = client_ssl_ctx();
+    if (!ctx) return false;
 
-    req->ssl_ctx = SSL_CTX_new(TLS_client_method());
-    if (!req->ssl_ctx) {
-        return false;
-    }
+    conn->ssl = SSL_new(ctx);
+    if (!conn->ssl) return false;
 
-    SSL_CTX_set_verify(req->ssl_ctx, SSL_VERIFY_NONE, nullptr);
-    SSL_CTX_set_options(req->ssl_ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+    conn->bio_read = BIO_new(BIO_s_mem());
+    conn->bio_write = BIO_new(BIO_s_mem());
 
-    req->ssl = SSL_new(req->ssl_ctx);
-    if (!req->ssl) {
-        SSL_CTX_free(req->ssl_ctx);
-        return false;
+    SSL_set_bio(conn->ssl, conn->bio_read, conn->bio_write);
+    SSL_set_app_data(conn->ssl, conn);
+    SSL_set_connect_state(conn->ssl);
+    SSL_set_tlsext_host_name(conn->ssl, host.c_str());
+    if (conn->pool && conn->pool->session) {
+        SSL_set_session(conn->ssl, conn->pool->session);
     }
 
-    req->bio_read = BIO_new(BIO_s_mem());
-    req->bio_write = BIO_new(BIO_s_mem());
-
-    SSL_set_bio(req->ssl, req->bio_read, req->bio_write);
-    SSL_set_connect_state(req->ssl);
-    SSL_set_tlsext_host_name(req->ssl, req->host.c_str());
-
     return true;
 }
 
-static void cleanup_ssl(HttpClientRequest* req) {
-    if (req->ssl) {
-        SSL_free(req->ssl);
-        req->ssl = nullptr;
-    }
-    if (req->ssl_ctx) {
-        SSL_CTX_free(req->ssl_ctx);
-        req->ssl_ctx = nullptr;
+static void cleanup_ssl(HttpClientConn* conn) {
+    if (conn->ssl) {
+        SSL_free(conn->ssl);  // also frees both BIOs
+        conn->ssl = nullptr;
     }
 }
 
-static int do_ssl_handshake(HttpClientRequest* req) {
-    int ret = SSL_do_handshake(req->ssl);
+static int do_ssl_handshake(HttpClientConn* conn) {
+    int ret = SSL_do_handshake(conn->ssl);
     if (ret == 1) {
         return 1;  // Success
     }
 
-    int err = SSL_get_error(req->ssl, ret);
+    int err = SSL_get_error(conn->ssl, ret);
     if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
         return 0;  // Need more data
     }
 
     return -1;  // Error
 }
+
+// Send everything OpenSSL has queued in the write BIO as one uv_write.
+static bool flush_tls(HttpClientConn* conn, uv_write_cb cb) {
+    int pending = BIO_pending(conn->bio_write);
+    if (pending <= 0) return false;
+
+    char* send_buf = (char*)malloc(pending);
+    int read = BIO_read(conn->bio_write, send_buf, pending);
+    if (read <= 0) {
+        free(send_buf);
+        return false;
+    }
+
+    return conn_write(conn, send_buf, read, cb) == 0;
+}
+#endif
+
+using ResolveCallback = std::function<void(int status, const sockaddr_in* addr)>;
+
+// ============================================================================
+// KEEP-ALIVE AGENT
+// ============================================================================
+
+struct HttpAgentOptions {
+    bool keep_alive = true;
+    size_t max_sockets = 64;        // busy connections per origin
+    size_t max_free_sockets = 16;   // idle connections kept per origin
+    uint64_t keep_alive_ms = 4000;  // idle longer than this: not reused
+};
+
+struct HttpAgent {
+    uv_loop_t* loop = nullptr;
+    HttpAgentOptions opts;
+    std::map<std::string, std::unique_ptr<HttpOriginPool>> pools;
+    std::unordered_set<HttpClientConn*> conns;
+    bool shutting_down = false;
+
+    uint64_t connections = 0;  // opened
+    uint64_t reuses = 0;
+    uint64_t tls_resumed = 0;
+};
+
+static thread_local HttpAgent t_agent;
+
+// Resolve `host` to an IPv4 address with the shared resolver, which caches
+// answers and rotates through a name's addresses (DnsResolver.hpp).
+static void resolve_host(uv_loop_t* loop, const std::string& host, ResolveCallback cb) {
+    dns_resolve(loop, host, AF_INET, [cb = std::move(cb)](int status, const std::vector<sockaddr_storage>& addrs) {
+        if (status != 0 || addrs.empty()) {
+            cb(status != 0 ? status : UV_EAI_NODATA, nullptr);
+            return;
+        }
+        sockaddr_in addr;
+        memcpy(&addr, &addrs[0], sizeof(addr));
+        cb(0, &addr);
+    });
+}
+
+static HttpOriginPool* pool_for(HttpClientRequest* req) {
+    std::string key = std::string(req->use_ssl ? "https://" : "http://") + req->host + ":" + std::to_string(req->port);
+    auto& slot = t_agent.pools[key];
+    if (!slot) {
+        slot = std::make_unique<HttpOriginPool>();
+        slot->key = key;
+        slot->host = req->host;
+        slot->port = req->port;
+        slot->use_ssl = req->use_ssl;
+    }
+    return slot.get();
+}
+
+// Hand `conn` to `req` and start the exchange on it.
+static void lease_conn(HttpClientConn* conn, HttpClientRequest* req) {
+    conn->generation++;
+    conn->req = req;
+    req->conn = conn;
+    req->reused = true;
+    conn->pool->busy++;
+    t_agent.reuses++;
+    uv_ref((uv_handle_t*)&conn->socket);
+    if (req->paused.load()) uv_read_stop((uv_stream_t*)&conn->socket);
+    send_request_head(req);
+}
+
+static void on_connect(uv_connect_t* connect_req, int status);
+
+// Open a new connection for `req`: resolve, connect, then (TLS) handshake.
+static void open_conn(HttpClientRequest* req) {
+    auto* conn = new HttpClientConn();
+    conn->pool = req->pool;
+    conn->pooled = req->use_agent;
+    conn->req = req;
+    req->conn = conn;
+    req->reused = false;
+    if (conn->pooled) conn->pool->busy++;
+
+    uv_tcp_init(t_agent.loop, &conn->socket);
+    uv_tcp_nodelay(&conn->socket, 1);
+    conn->socket.data = conn;
+    conn->connect_req.data = conn;
+    t_agent.conns.insert(conn);
+    t_agent.connections++;
+
+#ifdef HAVE_OPENSSL
+    if (req->use_ssl && !setup_ssl(conn, req->host)) {
+        emit_event(req->handlers, "error", Value{std::string("Failed to initialize SSL")});
+        close_connection(req, true);
+        return;
+    }
+#endif
+
+    conn->resolving = true;
+    int port = req->port;
+    resolve_host(t_agent.loop, req->host, [conn, port](int status, const sockaddr_in* addr) {
+        conn->resolving = false;
+        if (conn->closing) {
+            if (conn->handle_closed) delete conn;
+            return;
+        }
+
+        HttpClientRequest* req = conn->req;
+        if (status != 0) {
+            std::string error = std::string("DNS lookup failed: ") + uv_strerror(status);
+            emit_event(req->handlers, "error", Value{error});
+            close_connection(req, true);
+            return;
+        }
+
+        sockaddr_in target = *addr;
+        target.sin_port = htons(port);
+        int r = uv_tcp_connect(&conn->connect_req, &conn->socket, (const struct sockaddr*)&target, on_connect);
+        if (r != 0) {
+            std::string error = std::string("Connection failed: ") + uv_strerror(r);
+            emit_event(req->handlers, "error", Value{error});
+            close_connection(req, true);
+        }
+    });
+}
+
+// Give `req` a connection: an idle pooled one if there is a fresh one, a new
+// one while the origin is under max_sockets, otherwise a place in the queue.
+static void agent_acquire(HttpClientRequest* req, bool fresh_only) {
+    req->pool = pool_for(req);
+    HttpOriginPool* pool = req->pool;
+
+    if (!req->use_agent) {
+        open_conn(req);
+        return;
+    }
+
+    uint64_t now = uv_now(t_agent.loop);
+    while (!fresh_only && !pool->idle.empty()) {
+        HttpClientConn* conn = pool->idle.back();
+        pool->idle.pop_back();
+        if (now - conn->idle_since > t_agent.opts.keep_alive_ms) {
+            close_conn(conn);
+            continue;
+        }
+        lease_conn(conn, req);
+        return;
+    }
+
+    if (pool->busy >= t_agent.opts.max_sockets) {
+        pool->waiting.push_back(req);
+        return;
+    }
+    open_conn(req);
+}
+
+// Start waiting requests while the origin has room.
+static void agent_pump(HttpOriginPool* pool) {
+    while (!t_agent.shutting_down && !pool->waiting.empty() && pool->busy < t_agent.opts.max_sockets) {
+        HttpClientRequest* req = pool->waiting.front();
+        pool->waiting.pop_front();
+        agent_acquire(req);
+    }
+}
+
+static void agent_release(HttpClientConn* conn) {
+    HttpOriginPool* pool = conn->pool;
+    conn->req = nullptr;
+    pool->busy--;
+
+    if (!t_agent.opts.keep_alive || t_agent.shutting_down) {
+        close_conn(conn);
+        return;
+    }
+
+    if (!pool->waiting.empty()) {
+        HttpClientRequest* next = pool->waiting.front();
+        pool->waiting.pop_front();
+        lease_conn(conn, next);
+        return;
+    }
+
+    // Idle: keep reading to see a server-side close, but do not hold the
+    // loop open for it.
+    conn->idle_since = uv_now(t_agent.loop);
+    uv_read_start((uv_stream_t*)&conn->socket, alloc_buffer, on_read);
+    uv_unref((uv_handle_t*)&conn->socket);
+    pool->idle.push_back(conn);
+    if (pool->idle.size() > t_agent.opts.max_free_sockets) {
+        HttpClientConn* oldest = pool->idle.front();
+        pool->idle.erase(pool->idle.begin());
+        close_conn(oldest);
+    }
+}
+
+static void close_conn(HttpClientConn* conn) {
+    if (conn->closing) return;
+    conn->closing = true;
+    t_agent.conns.erase(conn);
+
+    HttpOriginPool* pool = conn->pool;
+    if (conn->req) {
+        if (conn->pooled) pool->busy--;
+        conn->req = nullptr;
+    } else if (pool) {
+        auto& idle = pool->idle;
+        idle.erase(std::remove(idle.begin(), idle.end(), conn), idle.end());
+    }
+
+    uv_close((uv_handle_t*)&conn->socket, [](uv_handle_t* handle) {
+        auto* conn = static_cast<HttpClientConn*>(handle->data);
+#ifdef HAVE_OPENSSL
+        cleanup_ssl(conn);
+#endif
+        conn->handle_closed = true;
+        if (!conn->resolving) delete conn;
+    });
+
+    if (conn->pooled && pool) agent_pump(pool);
+}
+
+// Methods a server may see twice with the same effect (RFC 9110 9.2.2).
+static bool method_is_idempotent(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "OPTIONS" || method == "TRACE" ||
+        method == "PUT" || method == "DELETE";
+}
+
+// A reused connection the server had already closed: replay the request
+// once on a new one, if its body can be sent again.  A POST or PATCH the
+// server may already have read is not sent twice.
+static bool agent_retry(HttpClientRequest* req) {
+    if (!req->reused || req->retried || req->response_started || req->is_chunked || req->file_source) {
+        return false;
+    }
+    if (req->bytes_written && !method_is_idempotent(req->method)) return false;
+    req->retried = true;
+
+    HttpClientConn* conn = req->conn;
+    req->conn = nullptr;
+    if (conn) {
+        // The dead connection no longer counts against the origin.
+        conn->req = nullptr;
+        if (conn->pooled) conn->pool->busy--;
+        conn->pooled = false;
+        close_conn(conn);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(req->write_mutex);
+        req->write_queue.clear();
+        req->writing.store(false);
+    }
+    req->total_bytes_sent = 0;
+    req->body_bytes_sent = 0;
+    req->bytes_written = false;
+    llhttp_init(&req->parser, HTTP_RESPONSE, &req->settings);
+    req->parser.data = req;
+
+    agent_acquire(req, true);
+    return true;
+}
+
+void http_agent_shutdown(uv_loop_t* loop) {
+    if (!loop || t_agent.loop != loop) return;
+    t_agent.shutting_down = true;
+
+    std::vector<HttpClientConn*> conns(t_agent.conns.begin(), t_agent.conns.end());
+    for (HttpClientConn* conn : conns) close_conn(conn);
+
+#ifdef HAVE_OPENSSL
+    for (auto& [key, pool] : t_agent.pools) {
+        if (pool->session) SSL_SESSION_free(pool->session);
+        pool->session = nullptr;
+    }
 #endif
+    t_agent.pools.clear();
+    t_agent.loop = nullptr;
+    t_agent.shutting_down = false;
+}
 
 // ============================================================================
 // LLHTTP CALLBACKS
 // ============================================================================
 
+static std::string parse_error_message(llhttp_t* parser, llhttp_errno_t err) {
+    // Raised from our own callbacks, which set the reason.
+    const char* reason = llhttp_get_error_reason(parser);
+    if (err == HPE_USER && reason) return reason;
+    return std::string("HTTP parse error: ") + llhttp_errno_name(err);
+}
+
 static int on_status(llhttp_t* parser, const char* at, size_t length) {
     auto* req = static_cast<HttpClientRequest*>(parser->data);
     req->status_code = parser->status_code;
@@ -462,7 +867,15 @@ static int on_headers_complete(llhttp_t* parser) {
 
     emit_event(req->handlers, "response", Value{meta});
 
-    return 0;
+    if (req->decompress && req->status_code != 204 && req->status_code != 304) {
+        auto encoding = req->response_headers->get("content-encoding");
+        if (encoding && http_content_coding(*encoding) != ZlibStream::Format::None) {
+            req->decoder = ZlibStream::decoder();
+        }
+    }
+
+    // A response to HEAD has no body, whatever its Content-Length says
+    return req->method == "HEAD" ? 1 : 0;
 }
 
 static int on_body(llhttp_t* parser, const char* at, size_t length) {
@@ -472,10 +885,19 @@ static int on_body(llhttp_t* parser, const char* at, size_t length) {
 
     // Emit data chunk
     auto chunk = std::make_shared<BufferValue>();
-    chunk->data.assign(at, at + length);
+    if (req->decoder) {
+        std::vector<uint8_t> plain;
+        if (!req->decoder->write(at, length, plain)) {
+            llhttp_set_error_reason(parser, "Decompression error: invalid compressed body");
+            return HPE_USER;
+        }
+        chunk->data.assign(plain.begin(), plain.end());
+    } else {
+        chunk->data.assign(at, at + length);
+    }
     chunk->encoding = "binary";
 
-    emit_event(req->handlers, "data", Value{chunk});
+    if (!chunk->data.empty()) emit_event(req->handlers, "data", Value{chunk});
 
     // Emit progress if we know content length
     if (req->content_length > 0) {
@@ -501,6 +923,14 @@ static int on_message_complete(llhttp_t* parser) {
         return 0;
     }
 
+    // The connection can serve another request if both sides agreed to keep
+    // it and all of ours has been handed to the socket.
+    {
+        std::lock_guard<std::mutex> lock(req->write_mutex);
+        req->keep_conn = req->use_agent && llhttp_should_keep_alive(parser) &&
+            req->request_complete.load() && req->write_queue.empty();
+    }
+
     auto handlers = req->handlers;
     emit_event(handlers, "end");
 
@@ -516,21 +946,25 @@ static int on_message_complete(llhttp_t* parser) {
 static void process_write_queue(HttpClientRequest* req);
 
 static void on_write_complete(uv_write_t* write_req, int status) {
-    auto* req = static_cast<HttpClientRequest*>(write_req->data);
+    auto* w = static_cast<ConnWrite*>(write_req->data);
+    HttpClientConn* conn = w->conn;
+    bool current = w->generation == conn->generation;
+    free(w->data);
+    delete w;
+
+    // The request that issued it has finished with this connection
+    HttpClientRequest* req = current ? conn->req : nullptr;
+    if (!req || req->closed.load()) return;
     auto handlers = req->handlers;
 
-    if (write_req->bufs) {
-        if (write_req->bufs->base) free(write_req->bufs->base);
-        delete write_req->bufs;
-    }
-    delete write_req;
-
     if (status < 0) {
+        if (agent_retry(req)) return;
         std::string error = std::string("Write error: ") + uv_strerror(status);
         emit_event(handlers, "error", Value{error});
         close_connection(req, true);
         return;
     }
+    req->bytes_written = true;
 
     bool should_emit_drain = false;
 
@@ -553,6 +987,16 @@ static void on_write_complete(uv_write_t* write_req, int status) {
         });
     }
 }
+
+#ifdef HAVE_OPENSSL
+// Handshake records are written outside the request's write queue.
+static void on_raw_write_complete(uv_write_t* write_req, int) {
+    auto* w = static_cast<ConnWrite*>(write_req->data);
+    free(w->data);
+    delete w;
+}
+#endif
+
 static void process_write_queue(HttpClientRequest* req) {
     WriteRequest wr;
     bool got_work = false;
@@ -561,7 +1005,7 @@ static void process_write_queue(HttpClientRequest* req) {
         std::lock_guard<std::mutex> lock(req->write_mutex);
 
         // ✅ All checks inside lock
-        if (req->closed.load() || req->writing.load()) {
+        if (req->closed.load() || req->writing.load() || !req->conn) {
             return;
         }
 
@@ -577,6 +1021,8 @@ static void process_write_queue(HttpClientRequest* req) {
 
     if (!got_work) return;
 
+    HttpClientConn* conn = req->conn;
+
     // Wire bytes (diagnostic)
     req->total_bytes_sent += wr.data.size();
 
@@ -605,28 +1051,9 @@ static void process_write_queue(HttpClientRequest* req) {
     }
 
 #ifdef HAVE_OPENSSL
-    if (req->use_ssl && req->ssl) {
-        int written = SSL_write(req->ssl, wr.data.data(), wr.data.size());
-
-        char buf[16384];
-        int pending = BIO_pending(req->bio_write);
-        if (pending > 0) {
-            int read = BIO_read(req->bio_write, buf, std::min(pending, (int)sizeof(buf)));
-            if (read > 0) {
-                char* send_buf = (char*)malloc(read);
-                memcpy(send_buf, buf, read);
-
-                uv_write_t* write_req = new uv_write_t;
-                write_req->data = req;
-
-                uv_buf_t* uvbuf = new uv_buf_t;
-                *uvbuf = uv_buf_init(send_buf, read);
-                write_req->bufs = uvbuf;
-
-                uv_write(write_req, (uv_stream_t*)&req->socket, uvbuf, 1, on_write_complete);
-                return;
-            }
-        }
+    if (req->use_ssl && conn->ssl) {
+        SSL_write(conn->ssl, wr.data.data(), wr.data.size());
+        if (flush_tls(conn, on_write_complete)) return;
 
         // ✅ If SSL write didn't trigger UV write, reset writing flag
         {
@@ -644,25 +1071,15 @@ static void process_write_queue(HttpClientRequest* req) {
     char* send_buf = (char*)malloc(wr.data.size());
     memcpy(send_buf, wr.data.data(), wr.data.size());
 
-    uv_write_t* write_req = new uv_write_t;
-    write_req->data = req;
-
-    uv_buf_t* uvbuf = new uv_buf_t;
-    *uvbuf = uv_buf_init(send_buf, (unsigned int)wr.data.size());
-    write_req->bufs = uvbuf;
-
-    int result = uv_write(write_req, (uv_stream_t*)&req->socket, uvbuf, 1, on_write_complete);
+    int result = conn_write(conn, send_buf, wr.data.size(), on_write_complete);
 
     if (result < 0) {
-        free(send_buf);
-        delete uvbuf;
-        delete write_req;
-
         {
             std::lock_guard<std::mutex> lock(req->write_mutex);
             req->writing.store(false);
         }
 
+        if (agent_retry(req)) return;
         std::string error = std::string("Write failed: ") + uv_strerror(result);
         emit_event(req->handlers, "error", Value{error});
     }
@@ -706,7 +1123,17 @@ static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* b
 }
 
 static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
-    auto* req = static_cast<HttpClientRequest*>(stream->data);
+    auto* conn = static_cast<HttpClientConn*>(stream->data);
+    HttpClientRequest* req = conn->req;
+
+    // An idle pooled connection has nothing to read: EOF, an error or stray
+    // bytes all mean it cannot be reused.
+    if (!req) {
+        if (buf->base) free(buf->base);
+        if (nread != 0) close_conn(conn);
+        return;
+    }
+
     auto handlers = req->handlers;
 
     // Early exit if already closed
@@ -716,12 +1143,13 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
     }
 
     if (nread > 0) {
+        req->response_started = true;
 #ifdef HAVE_OPENSSL
-        if (req->use_ssl && req->ssl) {
-            BIO_write(req->bio_read, buf->base, nread);
+        if (req->use_ssl && conn->ssl) {
+            BIO_write(conn->bio_read, buf->base, nread);
 
-            if (!SSL_is_init_finished(req->ssl)) {
-                int hs_result = do_ssl_handshake(req);
+            if (!SSL_is_init_finished(conn->ssl)) {
+                int hs_result = do_ssl_handshake(conn);
 
                 if (hs_result < 0) {
                     emit_event(handlers, "error", Value{std::string("SSL handshake failed")});
@@ -730,43 +1158,13 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
                     return;
                 }
 
-                char out_buf[16384];
-                int pending = BIO_pending(req->bio_write);
-                if (pending > 0) {
-                    int read = BIO_read(req->bio_write, out_buf, std::min(pending, (int)sizeof(out_buf)));
-                    if (read > 0) {
-                        char* send_buf = (char*)malloc(read);
-                        memcpy(send_buf, out_buf, read);
-
-                        uv_write_t* write_req = new uv_write_t;
-                        write_req->data = req;
-
-                        uv_buf_t* uvbuf = new uv_buf_t;
-                        *uvbuf = uv_buf_init(send_buf, read);
-                        write_req->bufs = uvbuf;
-
-                        uv_write(write_req, (uv_stream_t*)&req->socket, uvbuf, 1, on_write_complete);
-                    }
-                }
+                flush_tls(conn, on_raw_write_complete);
 
                 if (hs_result == 1) {
-                    std::ostringstream request_stream;
-                    request_stream << req->method << " " << req->path << " HTTP/1.1\r\n";
-                    request_stream << "Host: " << req->host << "\r\n";
-
-                    for (auto it = req->request_headers.begin(); it != req->request_headers.end(); ++it) {
-                        auto kv = *it;
-                        request_stream << kv.first << ": " << kv.second << "\r\n";
-                    }
-
-                    request_stream << "\r\n";
-
-                    std::string req_str = request_stream.str();
-                    std::vector<uint8_t> req_data(req_str.begin(), req_str.end());
-                    queue_write(req, req_data);
-                    req->headers_sent.store(true);
-
-                    emit_event(handlers, "connect");
+                    if (SSL_session_reused(conn->ssl)) t_agent.tls_resumed++;
+                    // Nothing of the response has arrived yet
+                    req->response_started = false;
+                    send_request_head(req);
                 }
 
                 if (buf->base) free(buf->base);
@@ -776,11 +1174,11 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
             char decrypt_buf[16384];
             int bytes_read;
 
-            while ((bytes_read = SSL_read(req->ssl, decrypt_buf, sizeof(decrypt_buf))) > 0) {
+            while ((bytes_read = SSL_read(conn->ssl, decrypt_buf, sizeof(decrypt_buf))) > 0) {
                 llhttp_errno_t err = llhttp_execute(&req->parser, decrypt_buf, bytes_read);
 
                 if (err != HPE_OK) {
-                    std::string error = std::string("HTTP parse error: ") + llhttp_errno_name(err);
+                    std::string error = parse_error_message(&req->parser, err);
                     emit_event(handlers, "error", Value{error});
                     if (buf->base) free(buf->base);
                     close_connection(req, true);
@@ -797,7 +1195,7 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
         llhttp_errno_t err = llhttp_execute(&req->parser, buf->base, nread);
 
         if (err != HPE_OK) {
-            std::string error = std::string("HTTP parse error: ") + llhttp_errno_name(err);
+            std::string error = parse_error_message(&req->parser, err);
             emit_event(handlers, "error", Value{error});
             if (buf->base) free(buf->base);
             close_connection(req, true);
@@ -805,13 +1203,22 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
         }
 
     } else if (nread < 0) {
+        if (buf->base) free(buf->base);
+
+        // A pooled connection the server closed before answering
+        if (agent_retry(req)) return;
+
         // Connection closed or error
         if (nread != UV_EOF) {
             std::string error = std::string("Read error: ") + uv_strerror(nread);
             emit_event(handlers, "error", Value{error});
+        } else if (!req->response_started) {
+            emit_event(handlers, "error", Value{std::string("Connection closed before a response was received")});
+        } else {
+            // Completes a response whose body runs until the connection closes
+            llhttp_finish(&req->parser);
         }
 
-        if (buf->base) free(buf->base);
         close_connection(req, true);
         return;
     }
@@ -823,48 +1230,33 @@ static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
 // CONNECTION
 // ============================================================================
 
-static void send_initial_request(HttpClientRequest* req) {
-    if (req->use_ssl) {
-#ifdef HAVE_OPENSSL
-        // Kick off the TLS handshake so OpenSSL can produce ClientHello
-        int hs = do_ssl_handshake(req);
-        if (hs < 0) {
-            emit_event(req->handlers, "error", Value{std::string("SSL handshake init failed")});
-            close_connection(req, true);
-            return;
-        }
-
-        // Flush any pending TLS records produced by OpenSSL (ClientHello etc.)
-        char out_buf[16384];
-        int pending = BIO_pending(req->bio_write);
-        while (pending > 0) {
-            int to_read = std::min(pending, (int)sizeof(out_buf));
-            int read_bytes = BIO_read(req->bio_write, out_buf, to_read);
-            if (read_bytes > 0) {
-                // Write raw TLS bytes directly to the socket (bypass SSL_write)
-                char* send_buf = (char*)malloc(read_bytes);
-                memcpy(send_buf, out_buf, read_bytes);
-
-                uv_write_t* write_req = new uv_write_t;
-                write_req->data = req;
-
-                uv_buf_t* uvbuf = new uv_buf_t;
-                *uvbuf = uv_buf_init(send_buf, read_bytes);
-                write_req->bufs = uvbuf;
+static void pause_reading(HttpClientRequest* req) {
+    if (req->closed.load()) return;
+    if (!req->paused.exchange(true) && req->conn) {
+        uv_read_stop((uv_stream_t*)&req->conn->socket);
+    }
+}
 
-                // This runs on the loop (send_initial_request is called on the loop).
-                uv_write(write_req, (uv_stream_t*)&req->socket, uvbuf, 1, on_write_complete);
-            }
-            pending = BIO_pending(req->bio_write);
-        }
-#endif
-        return;
+static void resume_reading(HttpClientRequest* req) {
+    if (req->closed.load()) return;
+    if (req->paused.exchange(false) && req->conn) {
+        uv_read_start((uv_stream_t*)&req->conn->socket, alloc_buffer, on_read);
     }
+}
 
+// Write the request line and headers, then the body if it was given up
+// front.  Runs once the connection is usable: after connect, after the TLS
+// handshake, or straight away on a reused connection.
+static void send_request_head(HttpClientRequest* req) {
     std::ostringstream request_stream;
     request_stream << req->method << " " << req->path << " HTTP/1.1\r\n";
     request_stream << "Host: " << req->host << "\r\n";
-    request_stream << "Connection: close\r\n";  // Always close connection
+    if (!req->use_agent || !t_agent.opts.keep_alive) {
+        request_stream << "Connection: close\r\n";
+    }
+    if (req->decompress && ZlibStream::available() && !req->request_headers.has("Accept-Encoding")) {
+        request_stream << "Accept-Encoding: gzip, deflate\r\n";
+    }
 
     for (auto it = req->request_headers.begin(); it != req->request_headers.end(); ++it) {
         auto kv = *it;
@@ -879,7 +1271,10 @@ static void send_initial_request(HttpClientRequest* req) {
     // Send Headers
     queue_write(req, req_data, nullptr, 0);
     req->headers_sent.store(true);
-    emit_event(req->handlers, "connect");
+    if (!req->connect_emitted) {
+        req->connect_emitted = true;
+        emit_event(req->handlers, "connect");
+    }
 
     // ROUTE BASED ON STRATEGY
     if (req->has_fixed_body) {
@@ -895,11 +1290,16 @@ static void send_initial_request(HttpClientRequest* req) {
             }
             req->request_complete.store(true);
         }
+    } else if (!req->is_chunked && !req->request_headers.has("Content-Length")) {
+        // No body to wait for
+        req->request_complete.store(true);
     }
 }
 
 static void on_connect(uv_connect_t* connect_req, int status) {
-    auto* req = static_cast<HttpClientRequest*>(connect_req->data);
+    auto* conn = static_cast<HttpClientConn*>(connect_req->data);
+    HttpClientRequest* req = conn->req;
+    if (!req || conn->closing) return;
     auto handlers = req->handlers;
 
     if (status < 0) {
@@ -910,8 +1310,24 @@ static void on_connect(uv_connect_t* connect_req, int status) {
     }
 
     req->connected.store(true);
-    uv_read_start((uv_stream_t*)&req->socket, alloc_buffer, on_read);
-    send_initial_request(req);
+    if (!req->paused.load()) {
+        uv_read_start((uv_stream_t*)&conn->socket, alloc_buffer, on_read);
+    }
+
+#ifdef HAVE_OPENSSL
+    if (req->use_ssl) {
+        // Kick off the TLS handshake so OpenSSL can produce ClientHello
+        if (do_ssl_handshake(conn) < 0) {
+            emit_event(handlers, "error", Value{std::string("SSL handshake init failed")});
+            close_connection(req, true);
+            return;
+        }
+        flush_tls(conn, on_raw_write_complete);
+        return;
+    }
+#endif
+
+    send_request_head(req);
 }
 
 static void stream_next_file_chunk(HttpClientRequest* req) {
@@ -1030,6 +1446,18 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
             method = req->method;
         }
 
+        // agent: false opens a dedicated connection and closes it afterwards
+        auto agent_it = opts->properties.find("agent");
+        if (agent_it != opts->properties.end() && std::holds_alternative<bool>(agent_it->second.value)) {
+            req->use_agent = std::get<bool>(agent_it->second.value);
+        }
+
+        // decompress: false hands gzip / deflate bodies over as received
+        auto decompress_it = opts->properties.find("decompress");
+        if (decompress_it != opts->properties.end() && std::holds_alternative<bool>(decompress_it->second.value)) {
+            req->decompress = std::get<bool>(decompress_it->second.value);
+        }
+
         auto headers_it = opts->properties.find("headers");
         if (headers_it != opts->properties.end() &&  // ✅ Compare to opts->properties.end()
             std::holds_alternative<ObjectPtr>(headers_it->second.value)) {
@@ -1108,15 +1536,6 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
         }
     }
 
-#ifdef HAVE_OPENSSL
-    if (use_ssl) {
-        if (!setup_ssl(req)) {
-            delete req;
-            throw SwaziError("SSLError", "Failed to initialize SSL", token.loc);
-        }
-    }
-#endif
-
     // Build RequestStream object
     auto stream_obj = std::make_shared<ObjectValue>();
     Token tok{};
@@ -1286,11 +1705,7 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
 
     // pause()
     auto pause_impl = [req](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        scheduler_run_on_loop([req]() {
-            if (!req->paused.exchange(true)) {
-                uv_read_stop((uv_stream_t*)&req->socket);
-            }
-        });
+        scheduler_run_on_loop([req]() { pause_reading(req); });
         return std::monostate{};
     };
     stream_obj->properties["pause"] = {
@@ -1299,11 +1714,7 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
 
     // resume()
     auto resume_impl = [req](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        scheduler_run_on_loop([req]() {
-            if (req->paused.exchange(false)) {
-                uv_read_start((uv_stream_t*)&req->socket, alloc_buffer, on_read);
-            }
-        });
+        scheduler_run_on_loop([req]() { resume_reading(req); });
         return std::monostate{};
     };
     stream_obj->properties["resume"] = {
@@ -1398,6 +1809,7 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
         }
 
         ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+        dest_obj->materialize();
 
         // Extract destination stream ID
         auto id_it = dest_obj->properties.find("_id");
@@ -1448,11 +1860,7 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
 
                     // Handle backpressure - pause reading if write returns false
                     if (std::holds_alternative<bool>(result) && !std::get<bool>(result)) {
-                        scheduler_run_on_loop([req]() {
-                            if (!req->paused.exchange(true)) {
-                                uv_read_stop((uv_stream_t*)&req->socket);
-                            }
-                        });
+                        scheduler_run_on_loop([req]() { pause_reading(req); });
                     }
 
                     return result;
@@ -1474,11 +1882,7 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
 
         // DRAIN HANDLER - Resume reading when destination is ready
         auto drain_handler = [req](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-            scheduler_run_on_loop([req]() {
-                if (req->paused.exchange(false)) {
-                    uv_read_start((uv_stream_t*)&req->socket, alloc_buffer, on_read);
-                }
-            });
+            scheduler_run_on_loop([req]() { resume_reading(req); });
             return std::monostate{};
         };
 
@@ -1586,59 +1990,9 @@ Value native_http_open(const std::vector<Value>& args, EnvPtr callEnv, const Tok
 
     g_active_http_requests.fetch_add(1);
 
-    scheduler_run_on_loop([req, loop, host, port]() {
-        uv_tcp_init(loop, &req->socket);
-        req->socket.data = req;
-        req->connect_req.data = req;
-
-        uv_getaddrinfo_t* addrinfo_req = new uv_getaddrinfo_t;
-        addrinfo_req->data = req;
-
-        struct addrinfo hints;
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = AF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-
-        int r = uv_getaddrinfo(
-            loop,
-            addrinfo_req,
-            [](uv_getaddrinfo_t* addrinfo_req, int status, struct addrinfo* res) {
-                HttpClientRequest* req = static_cast<HttpClientRequest*>(addrinfo_req->data);
-
-                if (status != 0 || !res) {
-                    std::string error = std::string("DNS lookup failed: ") + uv_strerror(status);
-                    emit_event(req->handlers, "error", Value{error});
-
-                    if (res) uv_freeaddrinfo(res);
-                    delete addrinfo_req;
-
-                    close_connection(req, true);
-                    return;
-                }
-
-                struct sockaddr_in addr;
-                memcpy(&addr, res->ai_addr, sizeof(addr));
-                addr.sin_port = htons(req->port);
-
-                uv_tcp_connect(&req->connect_req, &req->socket,
-                    (const struct sockaddr*)&addr, on_connect);
-
-                uv_freeaddrinfo(res);
-                delete addrinfo_req;
-            },
-            host.c_str(),
-            nullptr,
-            &hints);
-
-        if (r != 0) {
-            // uv_getaddrinfo couldn't be started; centralize cleanup
-            std::string error = std::string("Failed to start DNS lookup: ") + uv_strerror(r);
-            emit_event(req->handlers, "error", Value{error});
-
-            // Use centralized close (will decrement active count and delete on loop)
-            close_connection(req, true);
-            delete addrinfo_req;
-        }
+    scheduler_run_on_loop([req, loop]() {
+        if (t_agent.loop != loop) t_agent.loop = loop;
+        agent_acquire(req);
     });
 
     return Value{stream_obj};
@@ -1763,4 +2117,90 @@ void native_http_exetended(const ObjectPtr& http_module, Evaluator* evaluator, E
     http_module->properties["post"] = {
         Value{std::make_shared<FunctionValue>("http.post", post_fn, env, tok)},
         false, false, false, tok};
+
+    // http.agent: the keep-alive pool shared by open/get/post
+    auto agent_obj = std::make_shared<ObjectValue>();
+
+    // http.agent.configure({keepAlive, maxSockets, maxFreeSockets, keepAliveMsecs, dnsTtl})
+    auto configure_fn = [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0])) {
+            throw SwaziError("TypeError", "http.agent.configure(options) requires an options object", token.loc);
+        }
+        ObjectPtr opts = std::get<ObjectPtr>(args[0]);
+        HttpAgentOptions& o = t_agent.opts;
+
+        auto count = [&](const char* name, uint64_t min) -> std::optional<uint64_t> {
+            auto it = opts->properties.find(name);
+            if (it == opts->properties.end()) return std::nullopt;
+            if (!std::holds_alternative<double>(it->second.value) || std::get<double>(it->second.value) < (double)min) {
+                throw SwaziError("TypeError", std::string("http.agent option '") + name + "' must be a number >= " + std::to_string(min), token.loc);
+            }
+            return static_cast<uint64_t>(std::get<double>(it->second.value));
+        };
+
+        auto ka = opts->properties.find("keepAlive");
+        if (ka != opts->properties.end()) {
+            if (!std::holds_alternative<bool>(ka->second.value)) {
+                throw SwaziError("TypeError", "http.agent option 'keepAlive' must be a boolean", token.loc);
+            }
+            o.keep_alive = std::get<bool>(ka->second.value);
+        }
+        if (auto v = count("maxSockets", 1)) o.max_sockets = *v;
+        if (auto v = count("maxFreeSockets", 0)) o.max_free_sockets = *v;
+        if (auto v = count("keepAliveMsecs", 0)) o.keep_alive_ms = *v;
+        if (auto v = count("dnsTtl", 0)) {
+            DnsOptions dns = dns_options();
+            dns.ttl_ms = *v;
+            dns_configure(dns);
+        }
+
+        // New limits apply to queued requests straight away
+        for (auto& [key, pool] : t_agent.pools) agent_pump(pool.get());
+        return std::monostate{};
+    };
+    agent_obj->properties["configure"] = {
+        Value{std::make_shared<FunctionValue>("http.agent.configure", configure_fn, env, tok)},
+        false, false, false, tok};
+
+    // http.agent.stats() -> counters since start plus current pool sizes
+    auto stats_fn = [](const std::vector<Value>&, EnvPtr, const Token& token) -> Value {
+        size_t busy = 0, idle = 0, waiting = 0;
+        for (auto& [key, pool] : t_agent.pools) {
+            busy += pool->busy;
+            idle += pool->idle.size();
+            waiting += pool->waiting.size();
+        }
+        auto out = std::make_shared<ObjectValue>();
+        auto put = [&](const char* name, double v) {
+            out->properties[name] = PropertyDescriptor{Value{v}, false, false, true, token};
+        };
+        put("connections", (double)t_agent.connections);
+        put("reuses", (double)t_agent.reuses);
+        put("tlsResumed", (double)t_agent.tls_resumed);
+        // name lookups are shared with net and tcp, so these count theirs too
+        DnsStats dns = dns_stats();
+        put("dnsLookups", (double)dns.lookups);
+        put("dnsHits", (double)dns.hits);
+        put("busy", (double)busy);
+        put("idle", (double)idle);
+        put("waiting", (double)waiting);
+        return Value{out};
+    };
+    agent_obj->properties["stats"] = {
+        Value{std::make_shared<FunctionValue>("http.agent.stats", stats_fn, env, tok)},
+        false, false, false, tok};
+
+    // http.agent.closeIdle() closes every pooled connection not in use
+    auto close_idle_fn = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        for (auto& [key, pool] : t_agent.pools) {
+            auto idle = pool->idle;
+            for (HttpClientConn* conn : idle) close_conn(conn);
+        }
+        return std::monostate{};
+    };
+    agent_obj->properties["closeIdle"] = {
+        Value{std::make_shared<FunctionValue>("http.agent.closeIdle", close_idle_fn, env, tok)},
+        false, false, false, tok};
+
+    http_module->properties["agent"] = {Value{agent_obj}, false, false, true, tok};
 }
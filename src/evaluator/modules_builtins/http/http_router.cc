@@ -0,0 +1,464 @@
+// http_router.cc
+#include "HttpRouter.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "SwaziError.hpp"
+#include "builtins.hpp"
+
+// ============================================================================
+// RADIX TREE
+// ============================================================================
+//
+// Each node consumes a run of literal bytes (`prefix`); literal children start
+// with distinct bytes, so a lookup picks at most one per level.  A ":name"
+// segment is a separate child that takes bytes up to the next '/', and a
+// trailing "*" a leaf that takes the rest.  Matching walks the path once,
+// preferring literal over param over wildcard and backing up only when a
+// more specific branch dead-ends.
+
+struct HttpRoute {
+    std::string method;  // "GET", ... or "*"
+    std::vector<FunctionPtr> chain;
+};
+
+struct HttpRouter::Node {
+    std::string prefix;
+    std::vector<std::unique_ptr<Node>> statics;
+
+    std::unique_ptr<Node> param;
+    std::string param_name;
+
+    std::unique_ptr<Node> wildcard;
+    std::string wildcard_name;
+
+    std::vector<HttpRoute> routes;
+};
+
+using RouteParams = std::vector<std::pair<const std::string*, std::string_view>>;
+
+HttpRouter::HttpRouter() : root_(std::make_unique<Node>()) {}
+HttpRouter::~HttpRouter() = default;
+
+// Walk (and extend) the literal path `lit` below `n`, splitting nodes where
+// `lit` diverges from an existing prefix.
+static HttpRouter::Node* insert_literal(HttpRouter::Node* n, std::string_view lit) {
+    while (!lit.empty()) {
+        HttpRouter::Node* next = nullptr;
+        for (auto& child : n->statics) {
+            if (child->prefix[0] != lit[0]) continue;
+
+            size_t k = 0;
+            size_t limit = std::min(child->prefix.size(), lit.size());
+            while (k < limit && child->prefix[k] == lit[k]) ++k;
+
+            if (k < child->prefix.size()) {
+                auto mid = std::make_unique<HttpRouter::Node>();
+                mid->prefix = child->prefix.substr(0, k);
+                child->prefix.erase(0, k);
+                mid->statics.push_back(std::move(child));
+                child = std::move(mid);
+            }
+            next = child.get();
+            lit.remove_prefix(k);
+            break;
+        }
+        if (!next) {
+            auto leaf = std::make_unique<HttpRouter::Node>();
+            leaf->prefix = std::string(lit);
+            next = leaf.get();
+            n->statics.push_back(std::move(leaf));
+            lit = {};
+        }
+        n = next;
+    }
+    return n;
+}
+
+// The route at `n` for `method`: an exact method first, then HEAD answered by
+// GET, then "*".
+static const HttpRoute* pick_route(const HttpRouter::Node* n, std::string_view method) {
+    const HttpRoute* any = nullptr;
+    const HttpRoute* get = nullptr;
+    for (const auto& r : n->routes) {
+        if (r.method == method) return &r;
+        if (r.method == "*") any = &r;
+        if (r.method == "GET") get = &r;
+    }
+    if (method == "HEAD" && get) return get;
+    return any;
+}
+
+struct RouteSearch {
+    std::string_view method;
+    RouteParams params;
+    const HttpRoute* found = nullptr;
+    const HttpRouter::Node* path_only = nullptr;  // first node matching the path but not the method
+};
+
+static bool match_at_end(const HttpRouter::Node* n, RouteSearch& s) {
+    if (n->routes.empty()) return false;
+    if (const HttpRoute* r = pick_route(n, s.method)) {
+        s.found = r;
+        return true;
+    }
+    if (!s.path_only) s.path_only = n;
+    return false;
+}
+
+// `rest` is the path left after n->prefix.
+static bool match_node(const HttpRouter::Node* n, std::string_view rest, RouteSearch& s) {
+    if (rest.empty() && match_at_end(n, s)) return true;
+
+    if (!rest.empty()) {
+        for (const auto& child : n->statics) {
+            const std::string& p = child->prefix;
+            if (p[0] != rest[0]) continue;
+            if (rest.size() >= p.size() && rest.compare(0, p.size(), p) == 0) {
+                if (match_node(child.get(), rest.substr(p.size()), s)) return true;
+            }
+            break;
+        }
+
+        if (n->param) {
+            size_t end = rest.find('/');
+            if (end == std::string_view::npos) end = rest.size();
+            if (end > 0) {
+                s.params.emplace_back(&n->param_name, rest.substr(0, end));
+                if (match_node(n->param.get(), rest.substr(end), s)) return true;
+                s.params.pop_back();
+            }
+        }
+    }
+
+    if (n->wildcard) {
+        s.params.emplace_back(&n->wildcard_name, rest);
+        if (match_at_end(n->wildcard.get(), s)) return true;
+        s.params.pop_back();
+    }
+    return false;
+}
+
+void HttpRouter::add(const std::string& method, const std::string& pattern, std::vector<FunctionPtr> handlers) {
+    if (pattern.empty() || pattern[0] != '/') {
+        throw std::invalid_argument("route pattern must start with '/': " + pattern);
+    }
+
+    Node* n = root_.get();
+    size_t i = 0;
+    while (i < pattern.size()) {
+        size_t special = pattern.find_first_of(":*", i);
+        if (special == std::string::npos) special = pattern.size();
+        n = insert_literal(n, std::string_view(pattern).substr(i, special - i));
+        i = special;
+        if (i == pattern.size()) break;
+
+        if (pattern[i - 1] != '/') {
+            throw std::invalid_argument("':' and '*' must start a path segment: " + pattern);
+        }
+
+        if (pattern[i] == ':') {
+            size_t end = pattern.find('/', i);
+            if (end == std::string::npos) end = pattern.size();
+            std::string name = pattern.substr(i + 1, end - i - 1);
+            if (name.empty()) throw std::invalid_argument("empty parameter name in " + pattern);
+            if (!n->param) {
+                n->param = std::make_unique<Node>();
+                n->param_name = name;
+            } else if (n->param_name != name) {
+                throw std::invalid_argument("':" + name + "' conflicts with ':" + n->param_name + "' at the same position in " + pattern);
+            }
+            n = n->param.get();
+            i = end;
+            continue;
+        }
+
+        // '*'
+        std::string name = pattern.substr(i + 1);
+        if (name.find('/') != std::string::npos) {
+            throw std::invalid_argument("'*' must be the last segment: " + pattern);
+        }
+        if (name.empty()) name = "*";
+        if (!n->wildcard) {
+            n->wildcard = std::make_unique<Node>();
+            n->wildcard_name = name;
+        } else if (n->wildcard_name != name) {
+            throw std::invalid_argument("'*" + name + "' conflicts with '*" + n->wildcard_name + "' in " + pattern);
+        }
+        n = n->wildcard.get();
+        break;
+    }
+
+    for (auto& r : n->routes) {
+        if (r.method == method) {
+            r.chain = std::move(handlers);
+            return;
+        }
+    }
+    n->routes.push_back(HttpRoute{method, std::move(handlers)});
+    ++routes_;
+}
+
+void HttpRouter::use(const std::string& prefix, std::vector<FunctionPtr> fns) {
+    std::string p = prefix;
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    for (auto& fn : fns) middleware_.push_back(Middleware{p, std::move(fn)});
+}
+
+// A matched chain that outlives one call: fn(req, res, next) may call next()
+// later from a callback.  next() only advances once.
+struct HttpRouteRun : std::enable_shared_from_this<HttpRouteRun> {
+    std::vector<FunctionPtr> fns;
+    ObjectPtr req;
+    ObjectPtr res;
+    Evaluator* evaluator = nullptr;
+    EnvPtr env;
+    size_t pos = 0;
+
+    void run(size_t i) {
+        if (i >= fns.size()) return;
+        pos = i + 1;
+        FunctionPtr fn = fns[i];
+        if (i + 1 == fns.size()) {
+            evaluator->invoke_function(fn, {Value{req}, Value{res}}, env, Token{});
+            return;
+        }
+        auto self = shared_from_this();
+        size_t at = i + 1;
+        auto next = std::make_shared<FunctionValue>(
+            "next",
+            [self, at](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+                if (self->pos == at) self->run(at);
+                return std::monostate{};
+            },
+            nullptr, Token{});
+        evaluator->invoke_function(fn, {Value{req}, Value{res}, Value{next}}, env, Token{});
+    }
+};
+
+static bool prefix_covers(const std::string& prefix, std::string_view path) {
+    if (prefix == "/") return true;
+    if (path.size() < prefix.size() || path.compare(0, prefix.size(), prefix) != 0) return false;
+    return path.size() == prefix.size() || path[prefix.size()] == '/';
+}
+
+HttpRouter::Result HttpRouter::dispatch(std::string_view method, std::string_view path, const ObjectPtr& req,
+    const ObjectPtr& res, Evaluator* evaluator, EnvPtr env, std::string* allow) {
+    RouteSearch s;
+    s.method = method;
+    if (!match_node(root_.get(), path, s)) {
+        if (!s.path_only) return Result::NotFound;
+        if (allow) {
+            allow->clear();
+            for (const auto& r : s.path_only->routes) {
+                if (!allow->empty()) *allow += ", ";
+                *allow += r.method == "*" ? std::string("*") : r.method;
+            }
+        }
+        return Result::MethodNotAllowed;
+    }
+
+    auto params = std::make_shared<ObjectValue>();
+    for (const auto& [name, value] : s.params) {
+        params->properties[*name] = {Value{std::string(value)}, false, false, false, Token{}};
+    }
+    req->properties["params"] = {Value{params}, false, false, false, Token{}};
+
+    bool any_middleware = false;
+    for (const auto& m : middleware_) {
+        if (prefix_covers(m.prefix, path)) {
+            any_middleware = true;
+            break;
+        }
+    }
+
+    if (!any_middleware && s.found->chain.size() == 1) {
+        FunctionPtr fn = s.found->chain[0];
+        evaluator->invoke_function(fn, {Value{req}, Value{res}}, env, Token{});
+        return Result::Handled;
+    }
+
+    auto run = std::make_shared<HttpRouteRun>();
+    for (const auto& m : middleware_) {
+        if (prefix_covers(m.prefix, path)) run->fns.push_back(m.fn);
+    }
+    run->fns.insert(run->fns.end(), s.found->chain.begin(), s.found->chain.end());
+    run->req = req;
+    run->res = res;
+    run->evaluator = evaluator;
+    run->env = std::move(env);
+    run->run(0);
+    return Result::Handled;
+}
+
+// ============================================================================
+// SCRIPT API
+// ============================================================================
+
+// Routers are found again from their object by `_id`, like sockets and streams.
+static std::mutex g_routers_mutex;
+static std::unordered_map<long long, std::weak_ptr<HttpRouter>> g_routers;
+static std::atomic<long long> g_next_router_id{1};
+
+std::shared_ptr<HttpRouter> http_router_from_value(const Value& v) {
+    if (!std::holds_alternative<ObjectPtr>(v)) return nullptr;
+    const ObjectPtr& obj = std::get<ObjectPtr>(v);
+    if (!obj) return nullptr;
+    auto it = obj->properties.find("_routerId");
+    if (it == obj->properties.end() || !std::holds_alternative<double>(it->second.value)) return nullptr;
+    long long id = static_cast<long long>(std::get<double>(it->second.value));
+    std::lock_guard<std::mutex> lk(g_routers_mutex);
+    auto found = g_routers.find(id);
+    return found == g_routers.end() ? nullptr : found->second.lock();
+}
+
+// Read a field of req/res, letting a lazily built object provide it.
+static Value object_field(const ObjectPtr& obj, const std::string& key) {
+    auto it = obj->properties.find(key);
+    if (it == obj->properties.end() && obj->host && obj->host->resolve(*obj, key)) {
+        it = obj->properties.find(key);
+    }
+    return it == obj->properties.end() ? Value{} : it->second.value;
+}
+
+static void call_member(const ObjectPtr& obj, const std::string& key, const std::vector<Value>& args,
+    Evaluator* evaluator, EnvPtr env, const Token& token) {
+    Value fn = object_field(obj, key);
+    if (std::holds_alternative<FunctionPtr>(fn)) {
+        evaluator->invoke_function(std::get<FunctionPtr>(fn), args, env, token);
+    }
+}
+
+static std::vector<FunctionPtr> collect_handlers(const std::vector<Value>& args, size_t from,
+    const std::string& what, const Token& token) {
+    std::vector<FunctionPtr> fns;
+    for (size_t i = from; i < args.size(); ++i) {
+        if (!std::holds_alternative<FunctionPtr>(args[i]) || !std::get<FunctionPtr>(args[i])) {
+            throw SwaziError("TypeError", what + " expects handler functions", token.loc);
+        }
+        fns.push_back(std::get<FunctionPtr>(args[i]));
+    }
+    if (fns.empty()) throw SwaziError("TypeError", what + " requires at least one handler", token.loc);
+    return fns;
+}
+
+Value native_createRouter(const std::vector<Value>& /*args*/, EnvPtr env, const Token& /*token*/, Evaluator* evaluator) {
+    long long id = g_next_router_id.fetch_add(1);
+    std::shared_ptr<HttpRouter> router(new HttpRouter(), [id](HttpRouter* r) {
+        {
+            std::lock_guard<std::mutex> lk(g_routers_mutex);
+            g_routers.erase(id);
+        }
+        delete r;
+    });
+    {
+        std::lock_guard<std::mutex> lk(g_routers_mutex);
+        g_routers[id] = router;
+    }
+
+    auto obj = std::make_shared<ObjectValue>();
+    std::weak_ptr<ObjectValue> weak_obj = obj;
+    Token tok;
+    tok.loc = TokenLocation("<http>", 0, 0, 0);
+
+    obj->properties["_routerId"] = {Value{static_cast<double>(id)}, false, false, true, tok};
+
+    // router.get(path, ...handlers) etc. -> router
+    auto add_method = [&](const char* name, const std::string& method) {
+        std::string what = std::string("router.") + name;
+        auto fn = [router, weak_obj, method, what](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty() || !std::holds_alternative<std::string>(args[0])) {
+                throw SwaziError("TypeError", what + "(path, ...handlers) requires a path string", token.loc);
+            }
+            std::vector<FunctionPtr> handlers = collect_handlers(args, 1, what, token);
+            try {
+                router->add(method, std::get<std::string>(args[0]), std::move(handlers));
+            } catch (const std::invalid_argument& e) {
+                throw SwaziError("ValueError", what + ": " + e.what(), token.loc);
+            }
+            if (auto self = weak_obj.lock()) return Value{self};
+            return std::monostate{};
+        };
+        obj->properties[name] = {Value{std::make_shared<FunctionValue>(what, fn, env, tok)}, false, false, true, tok};
+    };
+    add_method("get", "GET");
+    add_method("post", "POST");
+    add_method("put", "PUT");
+    add_method("delete", "DELETE");
+    add_method("patch", "PATCH");
+    add_method("head", "HEAD");
+    add_method("options", "OPTIONS");
+    add_method("all", "*");
+
+    // router.use([prefix], ...fns) -> router
+    {
+        auto fn = [router, weak_obj](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            std::string prefix = "/";
+            size_t from = 0;
+            if (!args.empty() && std::holds_alternative<std::string>(args[0])) {
+                prefix = std::get<std::string>(args[0]);
+                if (prefix.empty() || prefix[0] != '/') {
+                    throw SwaziError("ValueError", "router.use: prefix must start with '/'", token.loc);
+                }
+                from = 1;
+            }
+            router->use(prefix, collect_handlers(args, from, "router.use", token));
+            if (auto self = weak_obj.lock()) return Value{self};
+            return std::monostate{};
+        };
+        obj->properties["use"] = {Value{std::make_shared<FunctionValue>("router.use", fn, env, tok)}, false, false, true, tok};
+    }
+
+    // router.handle(req, res, next?) — dispatch from a script handler.  With
+    // no matching route next() is called if given, otherwise 404 / 405.
+    {
+        auto fn = [router, evaluator](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
+            if (args.size() < 2 || !std::holds_alternative<ObjectPtr>(args[0]) || !std::holds_alternative<ObjectPtr>(args[1])) {
+                throw SwaziError("TypeError", "router.handle(req, res, next?) requires req and res", token.loc);
+            }
+            ObjectPtr req = std::get<ObjectPtr>(args[0]);
+            ObjectPtr res = std::get<ObjectPtr>(args[1]);
+            Value method = object_field(req, "method");
+            Value path = object_field(req, "path");
+            if (!std::holds_alternative<std::string>(method) || !std::holds_alternative<std::string>(path)) {
+                throw SwaziError("TypeError", "router.handle: req has no method/path", token.loc);
+            }
+
+            std::string allow;
+            HttpRouter::Result r = router->dispatch(std::get<std::string>(method), std::get<std::string>(path),
+                req, res, evaluator, callEnv, &allow);
+            if (r == HttpRouter::Result::Handled) return Value{true};
+
+            if (args.size() >= 3 && std::holds_alternative<FunctionPtr>(args[2])) {
+                evaluator->invoke_function(std::get<FunctionPtr>(args[2]), {}, callEnv, token);
+                return Value{false};
+            }
+            auto headers = std::make_shared<ObjectValue>();
+            headers->properties["Content-Type"] = {Value{std::string("text/plain")}, false, false, false, Token{}};
+            if (r == HttpRouter::Result::MethodNotAllowed) {
+                headers->properties["Allow"] = {Value{allow}, false, false, false, Token{}};
+                call_member(res, "writeHead", {Value{405.0}, Value{headers}}, evaluator, callEnv, token);
+                call_member(res, "end", {Value{std::string("Method Not Allowed\n")}}, evaluator, callEnv, token);
+            } else {
+                call_member(res, "writeHead", {Value{404.0}, Value{headers}}, evaluator, callEnv, token);
+                call_member(res, "end", {Value{std::string("Not Found\n")}}, evaluator, callEnv, token);
+            }
+            return Value{false};
+        };
+        obj->properties["handle"] = {Value{std::make_shared<FunctionValue>("router.handle", fn, env, tok)}, false, false, true, tok};
+    }
+
+    // router.size -> number of routes
+    {
+        auto fn = [router](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            return Value{static_cast<double>(router->route_count())};
+        };
+        obj->properties["size"] = {Value{std::make_shared<FunctionValue>("router.size", fn, env, tok)}, false, true, true, tok};
+    }
+
+    return Value{obj};
+}
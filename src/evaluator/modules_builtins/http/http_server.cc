@@ -1,28 +1,43 @@
 // http_server.cc
 #include <llhttp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <uv.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <cstring>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <iostream>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "AsyncBridge.hpp"
+#include "HttpFileCache.hpp"
+#include "HttpRouter.hpp"
+#include "HttpTls.hpp"
+#include "Scheduler.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
+#include "ZlibStream.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
+#include "worker.hpp"
 
 // Forward declarations to allow proper close callback implementations
-struct HttpRequestState;
+struct HttpConnection;
 static void close_client_and_state(uv_handle_t* h);
 
 // ============================================================================
@@ -147,6 +162,72 @@ static std::string value_to_string_simple_local(const Value& v) {
     return std::string();
 }
 
+// Orderly close of a client socket: uv_shutdown flushes whatever is already
+// queued, then uv_close hands the handle to close_client_and_state.
+static void shutdown_and_close_client(uv_stream_t* client) {
+    if (!client || uv_is_closing((uv_handle_t*)client)) return;
+
+    uv_shutdown_t* sreq = new uv_shutdown_t;
+    int r = uv_shutdown(sreq, client, [](uv_shutdown_t* req, int /*status*/) {
+        uv_stream_t* stream = req->handle;
+        if (!uv_is_closing((uv_handle_t*)stream)) {
+            uv_close((uv_handle_t*)stream, [](uv_handle_t* h) {
+                close_client_and_state(h);
+            });
+        }
+        delete req;
+    });
+    if (r != 0) {
+        // Already shut down or the peer is gone; close directly.
+        delete sreq;
+        uv_close((uv_handle_t*)client, [](uv_handle_t* h) {
+            close_client_and_state(h);
+        });
+    }
+}
+
+// Queue ciphertext produced by an HttpTlsSession.  It goes out in the order
+// it was produced, behind anything already queued on the socket.
+static void send_tls_output(uv_stream_t* client, std::string&& bytes) {
+    if (bytes.empty() || !client || uv_is_closing((uv_handle_t*)client)) return;
+    auto owner = std::make_shared<std::string>(std::move(bytes));
+    uv_buf_t buf = uv_buf_init(owner->data(), static_cast<unsigned int>(owner->size()));
+    stream_write_gather(client, &buf, 1, owner, nullptr);
+}
+
+// ============================================================================
+// RESPONSE COMPRESSION
+// ============================================================================
+
+static std::string lowercase(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// createServer(handler, { compression }).  Shared, read-only, by every
+// response of the server (and its cluster workers).
+struct HttpCompression {
+    size_t threshold = 1024;  // bodies known to be smaller go out as they are
+    int level = 6;
+    // Media types, exact or "type/*".
+    std::vector<std::string> types = {
+        "text/*", "application/json", "application/javascript", "application/xml",
+        "application/xhtml+xml", "application/manifest+json", "image/svg+xml"};
+
+    bool allows(std::string_view content_type) const {
+        std::string media = lowercase(std::string(content_type.substr(0, content_type.find(';'))));
+        while (!media.empty() && media.back() == ' ') media.pop_back();
+        for (const auto& t : types) {
+            if (t.size() >= 2 && t.compare(t.size() - 2, 2, "/*") == 0) {
+                if (media.compare(0, t.size() - 1, t, 0, t.size() - 1) == 0) return true;
+            } else if (media == t) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
 // ============================================================================
 // HTTP RESPONSE
 // ============================================================================
@@ -156,11 +237,21 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
     std::string reason;
     HeaderMap headers;
     uv_stream_t* client = nullptr;
+    // Set on https connections: every byte goes through it on the way out.
+    std::shared_ptr<HttpTlsSession> tls;
     bool chunked_mode = false;
     bool finished = false;
 
+    // A file body in progress (send_file / serve_file): bytes [file_offset,
+    // file_end) of file_fd.  file_source / file_entry keep the fd open.
     bool sendfile_active = false;
     FunctionPtr sendfile_callback = nullptr;
+    FilePtr file_source = nullptr;
+    HttpFilePtr file_entry = nullptr;
+    int file_fd = -1;
+    uint64_t file_offset = 0;
+    uint64_t file_end = 0;
+    bool file_use_sendfile = true;
 
     std::atomic<int> pending_writes{0};
     static const int MAX_PENDING_WRITES = 16;  // Configurable limit
@@ -177,6 +268,26 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
     // and only perform the TCP shutdown/close once outstanding writes & queue are drained.
     std::atomic<bool> close_requested{false};
 
+    // Keep-alive bookkeeping, filled in by the connection for each request.
+    bool keep_alive = false;
+    bool http10 = false;
+    bool head_request = false;
+    uint64_t keep_alive_timeout_ms = 0;
+
+    // Set once the response has ended and all of it has been handed to libuv;
+    // on_complete then lets the connection move on to the next request.
+    bool completed = false;
+    std::function<void()> on_complete;
+
+    // Content coding.  `coding` is what the request's Accept-Encoding allows.
+    // A body whose size is known at end() is compressed in one go; a streamed
+    // one runs through `encoder`, which is sync-flushed with the cork so that
+    // every write still reaches the client in the tick it was made.
+    std::shared_ptr<const HttpCompression> compression;
+    ZlibStream::Format coding = ZlibStream::Format::None;
+    std::unique_ptr<ZlibStream> encoder;
+    bool encoder_dirty = false;
+
     static std::string reason_for_code(int code) {
         switch (code) {
             case 200:
@@ -189,6 +300,8 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
                 return "Moved Permanently";
             case 302:
                 return "Found";
+            case 206:
+                return "Partial Content";
             case 304:
                 return "Not Modified";
             case 400:
@@ -199,6 +312,10 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
                 return "Forbidden";
             case 404:
                 return "Not Found";
+            case 405:
+                return "Method Not Allowed";
+            case 416:
+                return "Range Not Satisfiable";
             case 500:
                 return "Internal Server Error";
             default:
@@ -220,130 +337,227 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
         }
     }
 
-    // Process queued writes when capacity becomes available.
-    void process_queued_writes() {
-        while (!write_queue.empty() && pending_writes.load() < MAX_PENDING_WRITES && client && !finished) {
-            auto data = std::move(write_queue.front());
-            write_queue.pop_front();
-
-            if (!headers_flushed) {
-                if (!headers.has("Content-Length")) {
-                    chunked_mode = true;
-                    headers.set("Transfer-Encoding", "chunked");
-                }
-                flush_headers();
-            }
-
-            if (data.empty()) {
-                continue;
-            }
-
-            if (!chunked_mode) {
-                // Send raw data without chunk framing
-                char* buf = static_cast<char*>(malloc(data.size()));
-                memcpy(buf, data.data(), data.size());
-                uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(data.size()));
-                uv_write_t* req = new uv_write_t;
+    // ---- output ----
+    //
+    // Everything for the socket goes through send().  Pieces that fit are
+    // corked and leave together at the end of the loop tick (loop_defer), when
+    // the response completes, or ahead of a large write; a large write goes out
+    // as one gather write of [corked bytes, framing, body] without joining them.
+
+    static const size_t CORK_LIMIT = 16 * 1024;
+    std::string cork;
+    bool cork_flush_scheduled = false;
+    bool terminator_sent = false;
+
+    struct Outgoing {
+        std::string corked;
+        std::string head;
+        std::vector<uint8_t> body;
+    };
 
-                struct WriteContext {
-                    char* buffer;
-                    std::shared_ptr<HttpResponse> response;
-                };
+    // `tail` must be a literal (it is written in place).
+    void send(std::string_view head, std::vector<uint8_t>&& body = {}, std::string_view tail = {}) {
+        if (!client) return;
+        size_t len = head.size() + body.size() + tail.size();
+        if (len == 0) return;
+
+        if (cork.size() + len <= CORK_LIMIT) {
+            cork.append(head);
+            cork.append(reinterpret_cast<const char*>(body.data()), body.size());
+            cork.append(tail);
+            schedule_cork_flush();
+            return;
+        }
 
-                std::shared_ptr<HttpResponse> self = shared_from_this();
-                auto* ctx = new WriteContext{buf, self};
-                req->data = ctx;
+        auto out = std::make_shared<Outgoing>();
+        out->corked.swap(cork);
+        out->head.assign(head);
+        out->body = std::move(body);
 
-                pending_writes.fetch_add(1);
+        uv_buf_t bufs[4];
+        unsigned int n = 0;
+        if (!out->corked.empty()) bufs[n++] = uv_buf_init(out->corked.data(), static_cast<unsigned int>(out->corked.size()));
+        if (!out->head.empty()) bufs[n++] = uv_buf_init(out->head.data(), static_cast<unsigned int>(out->head.size()));
+        if (!out->body.empty()) bufs[n++] = uv_buf_init(reinterpret_cast<char*>(out->body.data()), static_cast<unsigned int>(out->body.size()));
+        if (!tail.empty()) bufs[n++] = uv_buf_init(const_cast<char*>(tail.data()), static_cast<unsigned int>(tail.size()));
+        submit(bufs, n, out);
+    }
 
-                uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-                    auto* ctx = static_cast<WriteContext*>(req->data);
-                    std::shared_ptr<HttpResponse> resp = ctx->response;
+    // A slice of bytes owned elsewhere (a cached file), written in place.
+    void send_shared(std::shared_ptr<const std::string> data, size_t off, size_t len) {
+        if (!client || len == 0) return;
+        if (cork.size() + len <= CORK_LIMIT) {
+            cork.append(*data, off, len);
+            schedule_cork_flush();
+            return;
+        }
+        auto out = std::make_shared<std::pair<std::string, std::shared_ptr<const std::string>>>();
+        out->first.swap(cork);
+        out->second = std::move(data);
 
-                    resp->pending_writes.fetch_sub(1);
+        uv_buf_t bufs[2];
+        unsigned int n = 0;
+        if (!out->first.empty()) bufs[n++] = uv_buf_init(out->first.data(), static_cast<unsigned int>(out->first.size()));
+        bufs[n++] = uv_buf_init(const_cast<char*>(out->second->data() + off), static_cast<unsigned int>(len));
+        submit(bufs, n, out);
+    }
 
-                    if (ctx->buffer) free(ctx->buffer);
-                    delete ctx;
-                    delete req;
+    // Body bytes, compressed when the body is, with chunk framing when chunked.
+    void send_body(std::vector<uint8_t>&& data) {
+        if (encoder) data = encode(data);
+        if (data.empty()) return;
+        if (!chunked_mode) {
+            send({}, std::move(data));
+            return;
+        }
+        char head[24];
+        int n = snprintf(head, sizeof(head), "%zx\r\n", data.size());
+        send(std::string_view(head, static_cast<size_t>(n)), std::move(data), "\r\n");
+    }
 
-                    resp->process_queued_writes();
+    std::vector<uint8_t> encode(const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> packed;
+        if (data.empty()) return packed;
+        encoder->write(data.data(), data.size(), packed);
+        if (!encoder_dirty) {
+            encoder_dirty = true;
+            schedule_cork_flush();
+        }
+        return packed;
+    }
 
-                    if (resp->write_queue_backpressure && resp->write_queue.empty() && resp->pending_writes.load() < HttpResponse::MAX_PENDING_WRITES) {
-                        resp->write_queue_backpressure = false;
-                        resp->emit_drain();
-                    }
+    // Push out what the encoder is holding: a sync flush at the end of a
+    // tick, the end of the stream when the response completes.
+    void flush_encoder(ZlibStream::Flush mode) {
+        if (!encoder || (mode == ZlibStream::Flush::Sync && !encoder_dirty)) return;
+        encoder_dirty = false;
+        std::vector<uint8_t> packed;
+        encoder->write(nullptr, 0, packed, mode);
+        if (mode == ZlibStream::Flush::Finish) encoder.reset();
+        send_body(std::move(packed));
+    }
 
-                    if (resp->close_requested.load() && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                        resp->perform_close();
-                    }
-                });
-            } else {
-                // Chunked mode: apply chunk framing
-                std::ostringstream chunk_header;
-                chunk_header << std::hex << data.size() << "\r\n";
-                std::string hdr = chunk_header.str();
+    void flush_cork() {
+        if (cork.empty() || !client) return;
+        auto out = std::make_shared<std::string>();
+        out->swap(cork);
+        uv_buf_t buf = uv_buf_init(out->data(), static_cast<unsigned int>(out->size()));
+        submit(&buf, 1, out);
+    }
 
-                size_t total_size = hdr.size() + data.size() + 2;
-                char* buf = static_cast<char*>(malloc(total_size));
+    void schedule_cork_flush() {
+        if (cork_flush_scheduled) return;
+        cork_flush_scheduled = true;
+        std::weak_ptr<HttpResponse> weak = shared_from_this();
+        loop_defer([weak]() {
+            std::shared_ptr<HttpResponse> self = weak.lock();
+            if (!self) return;
+            self->flush_encoder(ZlibStream::Flush::Sync);
+            self->cork_flush_scheduled = false;
+            self->flush_cork();
+        });
+    }
 
-                memcpy(buf, hdr.data(), hdr.size());
-                memcpy(buf + hdr.size(), data.data(), data.size());
-                buf[total_size - 2] = '\r';
-                buf[total_size - 1] = '\n';
+    // Write via uv_try_write, falling back to a queued write that
+    // pending_writes tracks until its callback.
+    void submit(const uv_buf_t* bufs, unsigned int nbufs, std::shared_ptr<void> owner) {
+        std::shared_ptr<HttpResponse> self = shared_from_this();
+        uv_buf_t sealed_buf;
+        if (tls) {
+            // The plaintext is encrypted now; the ciphertext is what stays in flight.
+            auto sealed = std::make_shared<std::string>();
+            if (!seal(bufs, nbufs, *sealed)) {
+                perform_close();
+                return;
+            }
+            sealed_buf = uv_buf_init(sealed->data(), static_cast<unsigned int>(sealed->size()));
+            bufs = &sealed_buf;
+            nbufs = 1;
+            owner = std::move(sealed);
+        }
+        bool done_now = stream_write_gather(client, bufs, nbufs, std::move(owner), [self](int) {
+            self->pending_writes.fetch_sub(1);
+            self->after_write();
+        });
+        if (!done_now) pending_writes.fetch_add(1);
+    }
 
-                uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(total_size));
-                uv_write_t* req = new uv_write_t;
+    // Encrypt bufs[0..nbufs) into `out`.  Small pieces (a head and a short
+    // body) are joined first so they travel in one TLS record.
+    bool seal(const uv_buf_t* bufs, unsigned int nbufs, std::string& out) {
+        size_t total = 0;
+        for (unsigned int i = 0; i < nbufs; i++) total += bufs[i].len;
+        if (nbufs > 1 && total <= 16 * 1024) {
+            std::string joined;
+            joined.reserve(total);
+            for (unsigned int i = 0; i < nbufs; i++) joined.append(bufs[i].base, bufs[i].len);
+            return tls->write(joined.data(), joined.size(), out);
+        }
+        for (unsigned int i = 0; i < nbufs; i++) {
+            if (!tls->write(bufs[i].base, bufs[i].len, out)) return false;
+        }
+        return true;
+    }
 
-                struct WriteContext {
-                    char* buffer;
-                    std::shared_ptr<HttpResponse> response;
-                };
+    void after_write() {
+        if (sendfile_active) {
+            pump_file();
+            return;
+        }
 
-                std::shared_ptr<HttpResponse> self = shared_from_this();
-                auto* ctx = new WriteContext{buf, self};
-                req->data = ctx;
+        process_queued_writes();
 
-                pending_writes.fetch_add(1);
+        if (write_queue_backpressure && write_queue.empty() &&
+            pending_writes.load() < MAX_PENDING_WRITES) {
+            write_queue_backpressure = false;
+            emit_drain();
+        }
 
-                uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-                    auto* ctx = static_cast<WriteContext*>(req->data);
-                    std::shared_ptr<HttpResponse> resp = ctx->response;
+        maybe_complete();
 
-                    resp->pending_writes.fetch_sub(1);
+        if (close_requested.load() && write_queue.empty() && pending_writes.load() == 0) {
+            perform_close();
+        }
+    }
 
-                    if (ctx->buffer) free(ctx->buffer);
-                    delete ctx;
-                    delete req;
+    // Called whenever the response may have drained.  Once it has ended and
+    // every byte (including the chunked terminator) is written, notifies the
+    // connection.  Runs at most once.
+    void maybe_complete() {
+        if (!finished || completed || sendfile_active) return;
+        if (!write_queue.empty()) return;
 
-                    resp->process_queued_writes();
+        if (chunked_mode && !head_request && !terminator_sent) {
+            flush_encoder(ZlibStream::Flush::Finish);
+            terminator_sent = true;
+            send("0\r\n\r\n");
+        }
+        flush_cork();
+        if (pending_writes.load() > 0) return;
+        completed = true;
 
-                    if (resp->write_queue_backpressure && resp->write_queue.empty() && resp->pending_writes.load() < HttpResponse::MAX_PENDING_WRITES) {
-                        resp->write_queue_backpressure = false;
-                        resp->emit_drain();
-                    }
+        if (on_complete) {
+            // Copy: the connection may clear on_complete from inside the call.
+            std::function<void()> cb = on_complete;
+            cb();
+        }
+    }
 
-                    if (resp->finished && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                        if (resp->chunked_mode) {
-                            const char* terminator = "0\r\n\r\n";
-                            char* term_buf = static_cast<char*>(malloc(5));
-                            memcpy(term_buf, terminator, 5);
-                            uv_buf_t term_uvbuf = uv_buf_init(term_buf, 5);
-
-                            uv_write_t* term_req = new uv_write_t;
-                            term_req->data = term_buf;
-
-                            uv_write(term_req, resp->client, &term_uvbuf, 1, [](uv_write_t* req, int) {
-                                if (req->data) free(req->data);
-                                delete req;
-                            });
-                        }
-                    }
+    // Process queued writes when capacity becomes available.
+    void process_queued_writes() {
+        while (!write_queue.empty() && pending_writes.load() < MAX_PENDING_WRITES && client) {
+            auto data = std::move(write_queue.front());
+            write_queue.pop_front();
 
-                    if (resp->close_requested.load() && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                        resp->perform_close();
-                    }
-                });
+            if (!headers_flushed) {
+                if (!headers.has("Content-Length")) {
+                    chunked_mode = true;
+                    headers.set("Transfer-Encoding", "chunked");
+                }
+                flush_headers();
             }
+
+            send_body(std::move(data));
         }
 
         if (write_queue_backpressure && write_queue.empty() && pending_writes.load() < MAX_PENDING_WRITES) {
@@ -351,13 +565,62 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
             emit_drain();
         }
     }
-    bool write_chunk(const std::vector<uint8_t>& data) {
+
+    // 1xx, 204 and 304 responses never carry a body.
+    bool bodiless() const {
+        return status_code == 204 || status_code == 304 || (status_code >= 100 && status_code < 200);
+    }
+
+    // Whether this response's body may be compressed, given its size
+    // (SIZE_MAX while unknown).  Bodies the handler encoded itself, ranges
+    // and no-transform responses are left alone.
+    bool compressible(size_t size) const {
+        if (!compression || head_request || bodiless() || status_code == 206) return false;
+        if (size < compression->threshold) return false;
+        if (headers.has("Content-Encoding") || headers.has("Content-Range")) return false;
+        auto cache_control = headers.get("Cache-Control");
+        if (cache_control && lowercase(*cache_control).find("no-transform") != std::string::npos) return false;
+        auto type = headers.get("Content-Type");
+        return compression->allows(type ? *type : "text/plain");
+    }
+
+    // The representation now depends on Accept-Encoding, whether or not this
+    // client gets it compressed.
+    void add_vary() {
+        auto vary = headers.get("Vary");
+        if (!vary) {
+            headers.set("Vary", "Accept-Encoding");
+        } else if (*vary != "*" && lowercase(*vary).find("accept-encoding") == std::string::npos) {
+            headers.set("Vary", *vary + ", Accept-Encoding");
+        }
+    }
+
+    // end() with headers still unsent: compress the whole body if it is
+    // worth it and let Content-Length describe the result.
+    void compress_whole(std::vector<uint8_t>& data) {
+        add_vary();
+        if (coding == ZlibStream::Format::None) return;
+        auto enc = ZlibStream::encoder(coding, compression->level);
+        std::vector<uint8_t> packed;
+        if (!enc || !enc->write(data.data(), data.size(), packed, ZlibStream::Flush::Finish)) return;
+        if (packed.size() >= data.size()) return;
+        data.swap(packed);
+        headers.set("Content-Encoding", http_coding_name(coding));
+    }
+
+    bool write_chunk(std::vector<uint8_t> data) {
         if (!client || finished) return false;
 
         if (sendfile_active) return false;
 
+        if (head_request || bodiless()) {
+            // HEAD: headers go out, the body is dropped.
+            flush_headers();
+            return true;
+        }
+
         if (pending_writes.load() >= MAX_PENDING_WRITES) {
-            write_queue.emplace_back(data);
+            write_queue.emplace_back(std::move(data));
             write_queue_backpressure = true;
             return false;
         }
@@ -370,218 +633,50 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
             flush_headers();
         }
 
-        if (data.empty()) return true;
-
-        if (!chunked_mode) {
-            // Send raw data without chunk framing
-            char* buf = static_cast<char*>(malloc(data.size()));
-            memcpy(buf, data.data(), data.size());
-
-            uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(data.size()));
-            uv_write_t* req = new uv_write_t;
-
-            struct WriteContext {
-                char* buffer;
-                std::shared_ptr<HttpResponse> response;
-            };
-
-            std::shared_ptr<HttpResponse> self = shared_from_this();
-            auto* ctx = new WriteContext{buf, self};
-            req->data = ctx;
-
-            pending_writes.fetch_add(1);
-
-            uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-                auto* ctx = static_cast<WriteContext*>(req->data);
-                std::shared_ptr<HttpResponse> resp = ctx->response;
-
-                resp->pending_writes.fetch_sub(1);
-
-                if (ctx->buffer) free(ctx->buffer);
-                delete ctx;
-                delete req;
-
-                resp->process_queued_writes();
-
-                if (resp->write_queue_backpressure && resp->write_queue.empty() &&
-                    resp->pending_writes.load() < HttpResponse::MAX_PENDING_WRITES) {
-                    resp->write_queue_backpressure = false;
-                    resp->emit_drain();
-                }
-
-                if (resp->close_requested.load() && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                    resp->perform_close();
-                }
-            });
-
-            return true;
-        }
-
-        // Chunked mode: apply chunk framing
-        std::ostringstream chunk_header;
-        chunk_header << std::hex << data.size() << "\r\n";
-        std::string hdr = chunk_header.str();
-
-        size_t total_size = hdr.size() + data.size() + 2;
-        char* buf = static_cast<char*>(malloc(total_size));
-
-        memcpy(buf, hdr.data(), hdr.size());
-        memcpy(buf + hdr.size(), data.data(), data.size());
-        buf[total_size - 2] = '\r';
-        buf[total_size - 1] = '\n';
-
-        uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(total_size));
-        uv_write_t* req = new uv_write_t;
-
-        struct WriteContext {
-            char* buffer;
-            std::shared_ptr<HttpResponse> response;
-        };
-
-        std::shared_ptr<HttpResponse> self = shared_from_this();
-        auto* ctx = new WriteContext{buf, self};
-        req->data = ctx;
-
-        pending_writes.fetch_add(1);
-
-        uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-            auto* ctx = static_cast<WriteContext*>(req->data);
-            std::shared_ptr<HttpResponse> resp = ctx->response;
-
-            resp->pending_writes.fetch_sub(1);
-
-            if (ctx->buffer) free(ctx->buffer);
-            delete ctx;
-            delete req;
-
-            resp->process_queued_writes();
-
-            if (resp->write_queue_backpressure && resp->write_queue.empty() &&
-                resp->pending_writes.load() < HttpResponse::MAX_PENDING_WRITES) {
-                resp->write_queue_backpressure = false;
-                resp->emit_drain();
-            }
-
-            if (resp->finished && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                if (resp->chunked_mode) {
-                    const char* terminator = "0\r\n\r\n";
-                    char* term_buf = static_cast<char*>(malloc(5));
-                    memcpy(term_buf, terminator, 5);
-                    uv_buf_t term_uvbuf = uv_buf_init(term_buf, 5);
-
-                    uv_write_t* term_req = new uv_write_t;
-                    term_req->data = term_buf;
-
-                    uv_write(term_req, resp->client, &term_uvbuf, 1, [](uv_write_t* req, int) {
-                        if (req->data) free(req->data);
-                        delete req;
-                    });
-                }
-            }
-
-            if (resp->close_requested.load() && resp->write_queue.empty() && resp->pending_writes.load() == 0) {
-                resp->perform_close();
-            }
-        });
-
+        send_body(std::move(data));
         return true;
     }
 
-    void end_response(const std::vector<uint8_t>& final_data = {}) {
+    void end_response(std::vector<uint8_t> final_data = {}) {
         if (finished) return;
 
         if (sendfile_active) return;
 
         finished = true;
 
-        headers.set("Connection", "close");
+        // Connection already gone (client hung up while the handler was busy).
+        if (!client) return;
 
         if (!headers_flushed) {
-            if (!final_data.empty()) {
-                headers.set("Content-Length", std::to_string(final_data.size()));
-                chunked_mode = false;
-            } else {
-                headers.set("Content-Length", "0");
-                chunked_mode = false;
-            }
+            if (write_queue.empty() && compressible(final_data.size())) compress_whole(final_data);
+            if (!bodiless()) headers.set("Content-Length", std::to_string(final_data.size()));
+            chunked_mode = false;
             flush_headers();
         }
 
-        if (chunked_mode) {
-            if (!write_queue.empty() || pending_writes.load() > 0) {
-                if (!final_data.empty()) {
-                    write_queue.emplace_back(final_data);
-                }
-                write_queue_backpressure = write_queue_backpressure || (pending_writes.load() >= MAX_PENDING_WRITES);
-                return;
-            }
+        if (head_request || bodiless()) {
+            maybe_complete();
+            return;
+        }
 
+        if (!write_queue.empty()) {
+            // Drained by the write callbacks, which then complete the response.
             if (!final_data.empty()) {
-                std::ostringstream chunk_header;
-                chunk_header << std::hex << final_data.size() << "\r\n";
-                std::string hdr = chunk_header.str();
-
-                size_t total_size = hdr.size() + final_data.size() + 2;
-                char* buf = static_cast<char*>(malloc(total_size));
-
-                memcpy(buf, hdr.data(), hdr.size());
-                memcpy(buf + hdr.size(), final_data.data(), final_data.size());
-                buf[total_size - 2] = '\r';
-                buf[total_size - 1] = '\n';
-
-                uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(total_size));
-                uv_write_t* req = new uv_write_t;
-                req->data = buf;
-
-                uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-                    if (req->data) free(req->data);
-                    delete req;
-                });
-            }
-
-            const char* terminator = "0\r\n\r\n";
-            char* term_buf = static_cast<char*>(malloc(5));
-            memcpy(term_buf, terminator, 5);
-            uv_buf_t term_uvbuf = uv_buf_init(term_buf, 5);
-
-            uv_write_t* term_req = new uv_write_t;
-            term_req->data = term_buf;
-
-            uv_write(term_req, client, &term_uvbuf, 1, [](uv_write_t* req, int) {
-                if (req->data) free(req->data);
-                delete req;
-            });
-        } else {
-            if (!write_queue.empty() || pending_writes.load() > 0) {
-                if (!final_data.empty()) {
-                    write_queue.emplace_back(final_data);
-                }
-                return;
+                write_queue.emplace_back(std::move(final_data));
             }
-
-            if (!final_data.empty()) {
-                char* buf = static_cast<char*>(malloc(final_data.size()));
-                memcpy(buf, final_data.data(), final_data.size());
-                uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(final_data.size()));
-
-                uv_write_t* req = new uv_write_t;
-                req->data = buf;
-
-                uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-                    if (req->data) free(req->data);
-                    delete req;
-                });
+            if (chunked_mode) {
+                write_queue_backpressure = write_queue_backpressure || (pending_writes.load() >= MAX_PENDING_WRITES);
             }
+            return;
         }
 
+        send_body(std::move(final_data));
+        maybe_complete();
+
         if (close_requested.load() && write_queue.empty() && pending_writes.load() == 0) {
             perform_close();
         }
     }
-    FilePtr file_source = nullptr;
-    uint64_t file_bytes_sent = 0;
-    uint64_t file_total_size = 0;
-
     bool headers_flushed = false;
 
     void flush_headers() {
@@ -595,17 +690,40 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
         if (!rp.empty()) response << " " << rp;
         response << "\r\n";
 
-        if (!headers.has("Content-Type")) {
+        if (!headers.has("Content-Type") && !bodiless()) {
             headers.set("Content-Type", "text/plain");
         }
 
-        if (headers.has("Content-Length")) {
+        if (bodiless()) {
+            chunked_mode = false;
+            headers.remove("Transfer-Encoding");
+        } else if (headers.has("Content-Length")) {
             chunked_mode = false;
         } else {
             if (!headers.has("Transfer-Encoding")) {
                 headers.set("Transfer-Encoding", "chunked");
             }
             chunked_mode = true;
+            if (!encoder && compressible(SIZE_MAX)) {
+                add_vary();
+                encoder = ZlibStream::encoder(coding, compression->level);
+                if (encoder) headers.set("Content-Encoding", http_coding_name(coding));
+            }
+        }
+
+        // HTTP/1.0 peers cannot frame a chunked body, so end it by closing.
+        if (chunked_mode && http10) keep_alive = false;
+
+        auto connection = headers.get("Connection");
+        if (connection.has_value()) {
+            std::string v = connection.value();
+            for (auto& c : v) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            if (v.find("close") != std::string::npos) keep_alive = false;
+        } else {
+            headers.set("Connection", keep_alive ? "keep-alive" : "close");
+        }
+        if (keep_alive && keep_alive_timeout_ms > 0 && !headers.has("Keep-Alive")) {
+            headers.set("Keep-Alive", "timeout=" + std::to_string(keep_alive_timeout_ms / 1000));
         }
 
         for (auto it = headers.begin(); it != headers.end(); ++it) {
@@ -614,99 +732,95 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
         }
         response << "\r\n";
 
-        std::string out = response.str();
-        char* buf = static_cast<char*>(malloc(out.size()));
-        memcpy(buf, out.data(), out.size());
-        uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(out.size()));
-
-        uv_write_t* req = new uv_write_t;
-        req->data = buf;
-
-        uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int) {
-            if (req->data) free(req->data);
-            delete req;
-        });
+        send(response.str());
     }
 
-    struct FileStreamContext {
-        char* buffer;
-        std::shared_ptr<HttpResponse> response;
-    };
-
-    void stream_file_chunk() {
-        if (!file_source || !client || finished) {
-            if (sendfile_callback) {
-                std::string error = finished ? "" : "Stream interrupted";
-                call_sendfile_callback(error);
+    // Sends file_fd from file_offset to file_end.  While libuv has nothing
+    // queued for the socket the kernel copies straight from the file
+    // (uv_fs_sendfile, run synchronously: the socket is non-blocking).  When
+    // the socket is full, or sendfile is unavailable or the body is chunked,
+    // one chunk is read and queued instead; its write callback (after_write)
+    // resumes here once the socket drains.
+    void pump_file() {
+        // Headers may still be corked; they must go ahead of the file.
+        flush_cork();
+
+        while (sendfile_active) {
+            if (!client || finished) {
+                call_sendfile_callback(finished ? "" : "Stream interrupted");
+                finish_sendfile();
+                return;
             }
-            return;
-        }
-
-        const size_t CHUNK_SIZE = 64 * 1024;
-        std::vector<uint8_t> buffer(CHUNK_SIZE);
-        size_t bytes_read = 0;
+            if (file_offset >= file_end) {
+                call_sendfile_callback("");  // Empty string = no error
+                finish_sendfile();
+                return;
+            }
+            // Anything queued must reach the socket first.
+            if (pending_writes.load() > 0 || client->write_queue_size > 0) return;
+
+            uint64_t remaining = file_end - file_offset;
+
+#ifndef _WIN32
+            if (file_use_sendfile && !chunked_mode) {
+                uv_os_fd_t sock;
+                if (uv_fileno(reinterpret_cast<uv_handle_t*>(client), &sock) == 0) {
+                    uv_fs_t req;
+                    size_t len = static_cast<size_t>(std::min<uint64_t>(remaining, 1024 * 1024));
+                    int n = uv_fs_sendfile(client->loop, &req, sock, file_fd, static_cast<int64_t>(file_offset), len, nullptr);
+                    uv_fs_req_cleanup(&req);
+                    if (n > 0) {
+                        file_offset += static_cast<uint64_t>(n);
+                        continue;
+                    }
+                    if (n == 0) {
+                        call_sendfile_callback("File read error");  // truncated underneath us
+                        finish_sendfile();
+                        return;
+                    }
+                    if (n != UV_EAGAIN) file_use_sendfile = false;
+                } else {
+                    file_use_sendfile = false;
+                }
+            }
+#endif
 
+            const size_t CHUNK_SIZE = 64 * 1024;
+            auto out = std::make_shared<Outgoing>();
+            out->body.resize(static_cast<size_t>(std::min<uint64_t>(remaining, CHUNK_SIZE)));
+            ssize_t r;
 #ifdef _WIN32
-        DWORD read_bytes;
-        if (ReadFile((HANDLE)file_source->handle, buffer.data(), CHUNK_SIZE, &read_bytes, NULL)) {
-            bytes_read = read_bytes;
-        }
+            DWORD read_bytes = 0;
+            r = ReadFile((HANDLE)_get_osfhandle(file_fd), out->body.data(), (DWORD)out->body.size(), &read_bytes, NULL) ? (ssize_t)read_bytes : -1;
 #else
-        ssize_t r = read(file_source->fd, buffer.data(), CHUNK_SIZE);
-        if (r > 0) bytes_read = r;
+            do {
+                r = pread(file_fd, out->body.data(), out->body.size(), static_cast<off_t>(file_offset));
+            } while (r < 0 && errno == EINTR);
 #endif
+            if (r <= 0) {
+                call_sendfile_callback("File read error");
+                finish_sendfile();
+                return;
+            }
+            out->body.resize(static_cast<size_t>(r));
+            file_offset += static_cast<uint64_t>(r);
+            if (encoder) {
+                // A file sent after res.write() joins the compressed stream.
+                out->body = encode(out->body);
+                if (out->body.empty()) continue;
+            }
 
-        if (bytes_read > 0) {
-            buffer.resize(bytes_read);
-            file_bytes_sent += bytes_read;
-
-            std::ostringstream chunk_header;
-            chunk_header << std::hex << bytes_read << "\r\n";
-            std::string hdr = chunk_header.str();
-
-            size_t total_size = hdr.size() + bytes_read + 2;
-            char* buf = static_cast<char*>(malloc(total_size));
-
-            memcpy(buf, hdr.data(), hdr.size());
-            memcpy(buf + hdr.size(), buffer.data(), bytes_read);
-            buf[total_size - 2] = '\r';
-            buf[total_size - 1] = '\n';
-
-            uv_buf_t uvbuf = uv_buf_init(buf, static_cast<unsigned int>(total_size));
-            uv_write_t* req = new uv_write_t;
-
-            std::shared_ptr<HttpResponse> self = shared_from_this();
-            auto* ctx = new FileStreamContext{buf, self};
-            req->data = ctx;
-
-            uv_write(req, client, &uvbuf, 1, [](uv_write_t* req, int status) {
-                auto* ctx = static_cast<FileStreamContext*>(req->data);
-                std::shared_ptr<HttpResponse> response = ctx->response;
-
-                if (ctx->buffer) free(ctx->buffer);
-                delete ctx;
-                delete req;
-
-                if (status != 0) {
-                    response->call_sendfile_callback("Write error");
-                    response->finish_sendfile();
-                    return;
-                }
-
-                // Continue streaming or finish
-                if (!response->finished &&
-                    response->file_bytes_sent < response->file_total_size) {
-                    response->stream_file_chunk();
-                } else {
-                    // File completely sent - success!
-                    response->call_sendfile_callback("");  // Empty string = no error
-                    response->finish_sendfile();
-                }
-            });
-        } else {
-            // Read error
-            call_sendfile_callback("File read error");
-            finish_sendfile();
+            uv_buf_t bufs[3];
+            unsigned int n = 0;
+            if (chunked_mode) {
+                char hex[24];
+                int hn = snprintf(hex, sizeof(hex), "%zx\r\n", out->body.size());
+                out->head.assign(hex, static_cast<size_t>(hn));
+                bufs[n++] = uv_buf_init(out->head.data(), static_cast<unsigned int>(out->head.size()));
+            }
+            bufs[n++] = uv_buf_init(reinterpret_cast<char*>(out->body.data()), static_cast<unsigned int>(out->body.size()));
+            if (chunked_mode) bufs[n++] = uv_buf_init(const_cast<char*>("\r\n"), 2);
+            submit(bufs, n, out);  // if queued, after_write() calls back in
         }
     }
 
@@ -728,27 +842,14 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
     void finish_sendfile() {
         sendfile_active = false;
         file_source = nullptr;
+        file_entry = nullptr;
+        file_fd = -1;
 
         finished = true;
 
-        // If we have outstanding writes/queued writes, defer terminator to write completion path
-        if (!write_queue.empty() || pending_writes.load() > 0) {
-            return;
-        }
-
-        // Send chunked terminator
-        const char* terminator = "0\r\n\r\n";
-        char* term_buf = static_cast<char*>(malloc(5));
-        memcpy(term_buf, terminator, 5);
-        uv_buf_t term_uvbuf = uv_buf_init(term_buf, 5);
-
-        uv_write_t* term_req = new uv_write_t;
-        term_req->data = term_buf;
-
-        uv_write(term_req, client, &term_uvbuf, 1, [](uv_write_t* req, int) {
-            if (req->data) free(req->data);
-            delete req;
-        });
+        // Writes terminator and completes now, or from the write callbacks if
+        // anything is still queued.
+        maybe_complete();
 
         // If a close was requested, perform it now
         if (close_requested.load()) {
@@ -756,6 +857,28 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
         }
     }
 
+    // Start sending [offset, offset + length) of an open descriptor as the
+    // rest of the body.  Sets Content-Length unless headers already went out.
+    void start_file_body(int fd, uint64_t offset, uint64_t length, FunctionPtr callback) {
+        sendfile_callback = callback;
+        if (!headers_flushed) {
+            headers.set("Content-Length", std::to_string(length));
+            chunked_mode = false;
+            flush_headers();
+        }
+        if (head_request || bodiless() || length == 0) {
+            call_sendfile_callback("");
+            end_response();
+            return;
+        }
+        sendfile_active = true;
+        file_fd = fd;
+        file_offset = offset;
+        file_end = offset + length;
+        file_use_sendfile = !tls;  // the kernel cannot encrypt for us
+        pump_file();
+    }
+
     void send_file(FilePtr file, FunctionPtr callback = nullptr) {
         if (!file || !file->is_open) {
             if (callback) {
@@ -771,46 +894,65 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
             return;
         }
 
-        sendfile_active = true;
-        sendfile_callback = callback;
-        file_source = file;
-
-        // Get file size
+        uint64_t size = 0;
+        int fd = -1;
 #ifdef _WIN32
         LARGE_INTEGER filesize_li;
-        if (GetFileSizeEx((HANDLE)file->handle, &filesize_li)) {
-            file_total_size = static_cast<uint64_t>(filesize_li.QuadPart);
+        fd = _open_osfhandle((intptr_t)file->handle, 0);
+        if (fd >= 0 && GetFileSizeEx((HANDLE)file->handle, &filesize_li)) {
+            size = static_cast<uint64_t>(filesize_li.QuadPart);
         } else {
-            call_sendfile_callback("Cannot get file size");
-            finish_sendfile();
-            return;
+            fd = -1;
         }
 #else
         struct stat st;
         if (fstat(file->fd, &st) == 0) {
-            file_total_size = static_cast<uint64_t>(st.st_size);
-        } else {
-            call_sendfile_callback("Cannot get file size");
-            finish_sendfile();
-            return;
+            size = static_cast<uint64_t>(st.st_size);
+            fd = file->fd;
         }
 #endif
+        if (fd < 0) {
+            sendfile_callback = callback;
+            call_sendfile_callback("Cannot get file size");
+            end_response();
+            return;
+        }
 
-        file_bytes_sent = 0;
+        file_source = file;
+        start_file_body(fd, 0, size, callback);
+    }
 
-        // Start streaming
-        chunked_mode = true;
+    // Send a cached file (or part of it) as the body.  Small files are written
+    // from the cache's copy; larger ones go through pump_file.
+    void serve_file(HttpFilePtr entry, uint64_t offset, uint64_t length, FunctionPtr callback) {
+        if (!entry->data) {
+            file_entry = entry;
+            start_file_body(entry->fd, offset, length, callback);
+            return;
+        }
         if (!headers_flushed) {
-            headers.set("Transfer-Encoding", "chunked");
+            headers.set("Content-Length", std::to_string(length));
+            chunked_mode = false;
             flush_headers();
         }
-        stream_file_chunk();
+        if (!head_request && !bodiless()) {
+            if (chunked_mode) {
+                std::vector<uint8_t> body(entry->data->begin() + offset, entry->data->begin() + offset + length);
+                send_body(std::move(body));
+            } else {
+                send_shared(entry->data, static_cast<size_t>(offset), static_cast<size_t>(length));
+            }
+        }
+        sendfile_callback = callback;
+        call_sendfile_callback("");
+        end_response();
     }
 
     // Request the response / connection to be closed when safe.
     // This marks close_requested and attempts to perform close immediately if drained.
     void request_close() {
         close_requested.store(true);
+        flush_cork();
         if (pending_writes.load() == 0 && write_queue.empty()) {
             perform_close();
         }
@@ -819,20 +961,12 @@ struct HttpResponse : public std::enable_shared_from_this<HttpResponse> {
     // Perform shutdown -> close now. This schedules uv_shutdown and in its callback
     // arranges for uv_close which will invoke close_client_and_state to delete state & handle.
     void perform_close() {
-        if (!client) return;
-        if (uv_is_closing((uv_handle_t*)client)) return;
-
-        // Allocate a shutdown request; it will be deleted in the shutdown callback.
-        uv_shutdown_t* sreq = new uv_shutdown_t;
-        // sreq->data isn't used here.
-        uv_shutdown(sreq, client, [](uv_shutdown_t* req, int /*status*/) {
-            uv_stream_t* stream = req->handle;
-            // Close the handle; close_client_and_state will delete the request state (if present)
-            uv_close((uv_handle_t*)stream, [](uv_handle_t* h) {
-                close_client_and_state(h);
-            });
-            delete req;
-        });
+        if (tls && client) {
+            std::string notify;
+            tls->shutdown(notify);
+            send_tls_output(client, std::move(notify));
+        }
+        shutdown_and_close_client(client);
     }
 };
 
@@ -844,16 +978,40 @@ struct BodyChunk {
     std::vector<uint8_t> data;
 };
 
+// One request on a connection.  Shared with the req/res closures, so it may
+// outlive both its response and the socket; detach() cuts it loose.
 struct HttpRequestState {
-    llhttp_t parser;
-    llhttp_settings_t settings;
-
-    std::string method;
-    std::string url;
-    std::string path;
-    std::string query;
-    HeaderMap headers;
-    std::string current_header_field;
+    // The request head as parsed: URL bytes, then each header's lowercased name
+    // and value.  req fields are sliced out of it on first access.
+    struct HeaderSpan {
+        uint32_t name_off, name_len, value_off, value_len;
+    };
+    std::string head;
+    size_t url_len = 0;
+    std::vector<HeaderSpan> header_spans;
+    bool in_header_value = false;
+    int method = -1;  // llhttp_method_t
+    long long response_id = 0;
+
+    std::string_view url() const { return std::string_view(head.data(), url_len); }
+    std::string_view path() const { return url().substr(0, url().find('?')); }
+    std::string_view query() const {
+        size_t q = url().find('?');
+        return q == std::string_view::npos ? std::string_view() : url().substr(q + 1);
+    }
+    std::string_view header_name(size_t i) const {
+        return std::string_view(head.data() + header_spans[i].name_off, header_spans[i].name_len);
+    }
+    std::string_view header_value(size_t i) const {
+        return std::string_view(head.data() + header_spans[i].value_off, header_spans[i].value_len);
+    }
+    // Index of the last header named `lower_name`, or -1.
+    int find_header(std::string_view lower_name) const {
+        for (size_t i = header_spans.size(); i-- > 0;) {
+            if (header_name(i) == lower_name) return static_cast<int>(i);
+        }
+        return -1;
+    }
 
     bool headers_complete = false;
     bool message_complete = false;
@@ -870,18 +1028,41 @@ struct HttpRequestState {
     uv_stream_t* client;
     std::shared_ptr<HttpResponse> response;
     FunctionPtr request_handler;
+    std::shared_ptr<HttpRouter> router;  // createServer(router): matched natively
     EnvPtr env;
     Evaluator* evaluator;
 
     ObjectPtr req_stream_obj;
     ObjectPtr res_obj;
+    std::weak_ptr<ObjectValue> res_self;  // what res.status() returns, after detach() too
 
     size_t max_buffer_size = 16 * 1024 * 1024;  // 16MB max buffer
     size_t current_buffer_size = 0;
     bool backpressure_active = false;
 
+    // Content-Encoding: gzip / deflate request bodies reach the script
+    // decompressed; the buffer limit applies to the decompressed size.
+    std::unique_ptr<ZlibStream> decoder;
+
     bool closing = false;  // whether close was requested for this state
 
+    // Called when the connection moves past this request or goes away.  The
+    // script may still hold req/res; from here on they no longer touch the
+    // socket, and dropping our refs to the script objects breaks the
+    // state -> req/res -> closure -> state cycle.
+    void detach() {
+        client = nullptr;
+        if (response) {
+            response->client = nullptr;
+            response->on_complete = nullptr;
+        }
+        req_stream_obj.reset();
+        res_obj.reset();
+        data_listeners.clear();
+        end_listeners.clear();
+        error_listeners.clear();
+    }
+
     void check_backpressure() {
         if (!backpressure_active && current_buffer_size > max_buffer_size) {
             // Stop reading from socket
@@ -908,12 +1089,15 @@ struct HttpRequestState {
         if (draining_buffer) return;
         draining_buffer = true;
 
+        // Listeners may end the response, which can detach() this state and
+        // clear the listener vectors, so iterate over copies.
+        std::vector<FunctionPtr> data_cbs = data_listeners;
         for (const auto& chunk : buffered_chunks) {
             auto buf = std::make_shared<BufferValue>();
             buf->data = chunk.data;
             buf->encoding = "binary";
 
-            for (const auto& listener : data_listeners) {
+            for (const auto& listener : data_cbs) {
                 if (listener && evaluator) {
                     try {
                         evaluator->invoke_function(listener, {Value{buf}}, env, Token{});
@@ -931,7 +1115,8 @@ struct HttpRequestState {
         release_backpressure();
 
         if (message_complete) {
-            for (const auto& listener : end_listeners) {
+            std::vector<FunctionPtr> end_cbs = end_listeners;
+            for (const auto& listener : end_cbs) {
                 if (listener && evaluator) {
                     try {
                         evaluator->invoke_function(listener, {}, env, Token{});
@@ -943,536 +1128,1080 @@ struct HttpRequestState {
 };
 
 // ============================================================================
-// LLHTTP CALLBACKS
+// CONNECTION
 // ============================================================================
 
-static int on_url(llhttp_t* parser, const char* at, size_t length) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
-    state->url.append(at, length);
-    return 0;
-}
+struct HttpConnection;
 
-static int on_header_field(llhttp_t* parser, const char* at, size_t length) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
-    state->current_header_field.assign(at, length);
-    for (auto& c : state->current_header_field) c = std::tolower(static_cast<unsigned char>(c));
-    return 0;
-}
+struct ServerInstance : public std::enable_shared_from_this<ServerInstance> {
+    uv_tcp_t* server_handle = nullptr;
+    FunctionPtr request_handler;
+    std::shared_ptr<HttpRouter> router;
+    std::atomic<bool> closed{false};
+    EnvPtr env;
+    Evaluator* evaluator;
 
-static int on_header_value(llhttp_t* parser, const char* at, size_t length) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
-    std::string value(at, length);
-    state->headers.set(state->current_header_field, value);  // ✅ Case-insensitive
-    return 0;
-}
-static int on_headers_complete(llhttp_t* parser) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
-    state->headers_complete = true;
+    // createServer(handler, { keepAlive, keepAliveTimeout, maxRequestsPerSocket })
+    bool keep_alive = true;
+    uint64_t keep_alive_timeout_ms = 5000;  // idle socket lifetime; 0 = no limit
+    uint64_t max_requests_per_socket = 0;   // 0 = unlimited
 
-    // Extract method
-    switch (parser->method) {
-        case HTTP_GET:
-            state->method = "GET";
-            break;
-        case HTTP_POST:
-            state->method = "POST";
-            break;
-        case HTTP_PUT:
-            state->method = "PUT";
-            break;
-        case HTTP_DELETE:
-            state->method = "DELETE";
-            break;
-        case HTTP_PATCH:
-            state->method = "PATCH";
-            break;
-        case HTTP_HEAD:
-            state->method = "HEAD";
-            break;
-        case HTTP_OPTIONS:
-            state->method = "OPTIONS";
-            break;
-        default:
-            state->method = "UNKNOWN";
-            break;
-    }
+    // createServer(handler, { compression }); null when turned off.
+    std::shared_ptr<const HttpCompression> compression =
+        ZlibStream::available() ? std::make_shared<HttpCompression>() : nullptr;
 
-    // Parse URL
-    size_t qpos = state->url.find('?');
-    if (qpos != std::string::npos) {
-        state->path = state->url.substr(0, qpos);
-        state->query = state->url.substr(qpos + 1);
-    } else {
-        state->path = state->url;
+    // createServer({ cert, key }, handler); null for plain http.
+    HttpTlsContextPtr tls;
+
+    std::unordered_set<HttpConnection*> connections;  // loop thread only
+};
+
+// One accepted socket.  The uv handle, the llhttp parser and its settings live
+// for the whole connection and are reused across requests (llhttp_reset at each
+// message boundary); every request gets a fresh HttpRequestState because the
+// script may keep req/res around after the response is done.
+//
+// Pipelining: on_message_complete pauses the parser, so the next request is not
+// parsed until the current response has been handed to libuv.  Bytes that
+// arrive meanwhile wait in pending_input and reading stops, which keeps
+// responses in request order and pushes back on clients that pipeline faster
+// than the handler answers.
+struct HttpConnection {
+    uv_stream_t* client = nullptr;
+    std::shared_ptr<ServerInstance> server;
+
+    llhttp_t parser;
+    llhttp_settings_t settings;
+
+    std::shared_ptr<HttpRequestState> current;
+    std::string pending_input;
+    uint64_t requests_started = 0;
+
+    // https: socket bytes are decrypted here before they reach the parser.
+    std::shared_ptr<HttpTlsSession> tls;
+
+    uv_timer_t* idle_timer = nullptr;
+    bool in_execute = false;
+    bool read_stopped = false;
+    bool eof = false;
+    bool closing = false;
+
+    ~HttpConnection() {
+        if (current) {
+            current->detach();
+            current.reset();
+        }
+        if (idle_timer) {
+            uv_timer_stop(idle_timer);
+            idle_timer->data = nullptr;
+            uv_close((uv_handle_t*)idle_timer, [](uv_handle_t* h) { delete (uv_timer_t*)h; });
+            idle_timer = nullptr;
+        }
+        if (server) server->connections.erase(this);
     }
 
-    // Build request object
-    auto req_obj = std::make_shared<ObjectValue>();
-    req_obj->properties["method"] = {Value{state->method}, false, false, true, Token{}};
-    req_obj->properties["path"] = {Value{state->path}, false, false, true, Token{}};
-    req_obj->properties["query"] = {Value{state->query}, false, false, true, Token{}};
-    req_obj->properties["url"] = {Value{state->url}, false, false, true, Token{}};
+    void begin_request() {
+        stop_idle_timer();
+        requests_started++;
 
-    auto headers_obj = std::make_shared<ObjectValue>();
-    for (auto it = state->headers.begin(); it != state->headers.end(); ++it) {
-        auto kv = *it;
-        headers_obj->properties[kv.first] = {Value{kv.second}, false, false, true, Token{}};
+        auto state = std::make_shared<HttpRequestState>();
+        state->client = client;
+        state->request_handler = server->request_handler;
+        state->router = server->router;
+        state->env = server->env;
+        state->evaluator = server->evaluator;
+        state->response = std::make_shared<HttpResponse>();
+        state->response->client = client;
+        state->response->env = state->env;
+        state->response->evaluator = state->evaluator;
+        state->response->keep_alive_timeout_ms = server->keep_alive_timeout_ms;
+        state->response->compression = server->compression;
+        state->response->tls = tls;
+        state->response->on_complete = [this]() { advance(); };
+        current = std::move(state);
     }
-    req_obj->properties["headers"] = {Value{headers_obj}, false, false, true, Token{}};
 
-    // req.on(event, callback)
-    auto req_on_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.size() < 2 || !std::holds_alternative<std::string>(args[0]) ||
-            !std::holds_alternative<FunctionPtr>(args[1])) {
-            throw SwaziError("TypeError", "req.on(event, callback) requires event and function", token.loc);
-        }
+    // Whether the request whose headers were just parsed may be followed by another.
+    bool wants_keep_alive() const {
+        if (!server->keep_alive || server->closed.load()) return false;
+        if (server->max_requests_per_socket > 0 && requests_started >= server->max_requests_per_socket) return false;
+        return llhttp_should_keep_alive(&parser) != 0;
+    }
 
-        std::string event = std::get<std::string>(args[0]);
-        FunctionPtr callback = std::get<FunctionPtr>(args[1]);
+    // Run bytes through the parser.  Returns false if the connection is being
+    // closed because of a parse error.
+    bool feed(const char* data, size_t len) {
+        in_execute = true;
+        llhttp_errno_t err = llhttp_execute(&parser, data, len);
+        in_execute = false;
+
+        if (err == HPE_PAUSED) {
+            // Stopped at a message boundary; keep the rest for later.
+            const char* pos = llhttp_get_error_pos(&parser);
+            if (pos && pos < data + len) pending_input.append(pos, static_cast<size_t>(data + len - pos));
+            return true;
+        }
+        if (err == HPE_OK) return true;
 
-        if (event == "data") {
-            state->data_listeners.push_back(callback);
-            if (!state->buffered_chunks.empty() && !state->draining_buffer) {
-                state->drain_buffered_chunks();
-            }
-        } else if (event == "end") {
-            state->end_listeners.push_back(callback);
-            if (state->message_complete && state->buffered_chunks.empty()) {
-                try {
-                    state->evaluator->invoke_function(callback, {}, state->env, Token{});
-                } catch (...) {
-                    // Listener error - continue
+        std::string error = std::string("HTTP parse error: ") + llhttp_errno_name(err);
+        if (current) {
+            for (const auto& listener : current->error_listeners) {
+                if (listener && current->evaluator) {
+                    scheduler_run_on_loop([listener, error]() {
+                        try {
+                            CallbackPayload* payload = new CallbackPayload(listener, {Value{error}});
+                            enqueue_callback_global(static_cast<void*>(payload));
+                        } catch (...) {}
+                    });
                 }
             }
-        } else if (event == "error") {
-            state->error_listeners.push_back(callback);
+            current->closing = true;
         }
+        close();
+        return false;
+    }
 
-        return std::monostate{};
-    };
-    req_obj->properties["on"] = {
-        Value{std::make_shared<FunctionValue>("req.on", req_on_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    // Request bytes off the socket (decrypted, on https).
+    void receive(const char* data, size_t len) {
+        if (llhttp_get_errno(&parser) == HPE_PAUSED) {
+            // Still answering an earlier request (reading was resumed by
+            // req.resume()); queue the bytes behind it.
+            pending_input.append(data, len);
+            if (!read_stopped) {
+                uv_read_stop(client);
+                read_stopped = true;
+            }
+        } else if (feed(data, len)) {
+            advance();
+        }
+    }
 
-    // req.pause()
-    auto req_pause_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        if (!state->reading_paused && state->client) {
-            uv_read_stop(state->client);
-            state->reading_paused = true;
+    // The peer is done sending: a TCP FIN, or close_notify on https.
+    void end_of_input() {
+        uv_read_stop(client);
+        if (current && current->message_complete) {
+            // Half-close after a complete request: still answer it (and
+            // anything pipelined behind it), then close.
+            eof = true;
+            read_stopped = true;
+            return;
         }
-        return std::monostate{};
-    };
-    req_obj->properties["pause"] = {
-        Value{std::make_shared<FunctionValue>("req.pause", req_pause_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+        close();
+    }
 
-    // req.resume()
-    auto req_resume_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        if (state->reading_paused && state->client) {
-            uv_read_start(state->client, alloc_buffer, on_read);
-            state->reading_paused = false;
+    // Move on once the current request is fully read and its response fully
+    // written: reset the parser and parse whatever was pipelined behind it,
+    // otherwise go back to reading (or idle) or close.
+    void advance() {
+        if (in_execute || closing) return;
+
+        while (current && current->message_complete && current->response->completed) {
+            bool keep = current->response->keep_alive && !server->closed.load();
+            current->detach();
+            current.reset();
+            if (!keep) {
+                close();
+                return;
+            }
+
+            llhttp_reset(&parser);
+            if (pending_input.empty()) break;
+
+            std::string input;
+            input.swap(pending_input);
+            if (!feed(input.data(), input.size())) return;
         }
-        return std::monostate{};
-    };
-    req_obj->properties["resume"] = {
-        Value{std::make_shared<FunctionValue>("req.resume", req_resume_impl, nullptr, Token{})},
-        false, false, false, Token{}};
 
-    // req.pipe(writable)
-    auto pipe_impl = [state](const std::vector<Value>& args, EnvPtr env, const Token& tok) -> Value {
-        if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0])) {
-            throw SwaziError("TypeError", "req.pipe() requires writable stream", tok.loc);
+        if (llhttp_get_errno(&parser) == HPE_PAUSED) {
+            // A complete request is waiting on its response.
+            if (!read_stopped && !eof) {
+                uv_read_stop(client);
+                read_stopped = true;
+            }
+            return;
         }
 
-        ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+        if (eof) {
+            // Nothing more will arrive; a half-read request can never finish.
+            close();
+            return;
+        }
 
-        // Parse options for end behavior
-        bool end_on_finish = true;
-        if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
-            ObjectPtr opts = std::get<ObjectPtr>(args[1]);
-            auto end_it = opts->properties.find("end");
-            if (end_it != opts->properties.end() && std::holds_alternative<bool>(end_it->second.value)) {
-                end_on_finish = std::get<bool>(end_it->second.value);
-            }
+        if (read_stopped) {
+            read_stopped = false;
+            uv_read_start(client, alloc_buffer, on_read);
         }
+        if (!current) arm_idle_timer();
+    }
 
-        Token evt_tok{};
-        evt_tok.loc = TokenLocation("<req-pipe>", 0, 0, 0);
+    void arm_idle_timer() {
+        if (server->keep_alive_timeout_ms == 0) return;
+        if (!idle_timer) {
+            idle_timer = new uv_timer_t;
+            uv_timer_init(client->loop, idle_timer);
+            idle_timer->data = this;
+        }
+        uv_timer_start(idle_timer, [](uv_timer_t* t) {
+            auto* conn = static_cast<HttpConnection*>(t->data);
+            if (conn) conn->close();
+        },
+            server->keep_alive_timeout_ms, 0);
+    }
 
-        // ✅ DATA HANDLER - with backpressure support
-        auto data_handler = [dest_obj, state](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
-            if (args.empty()) return std::monostate{};
+    void stop_idle_timer() {
+        if (idle_timer) uv_timer_stop(idle_timer);
+    }
 
-            auto write_it = dest_obj->properties.find("write");
-            if (write_it == dest_obj->properties.end()) return std::monostate{};
+    void close() {
+        if (closing) return;
+        closing = true;
+        stop_idle_timer();
+        if (current && current->response) {
+            // Let queued response bytes drain first.
+            current->response->request_close();
+        } else {
+            if (tls) {
+                std::string notify;
+                tls->shutdown(notify);
+                send_tls_output(client, std::move(notify));
+            }
+            shutdown_and_close_client(client);
+        }
+    }
+};
 
-            if (!std::holds_alternative<FunctionPtr>(write_it->second.value)) return std::monostate{};
+// ============================================================================
+// REQUEST / RESPONSE OBJECTS
+// ============================================================================
+//
+// req and res are HostProps-backed ObjectValues (see evaluator.hpp): building
+// them allocates nothing else.  Each member is described once in a static
+// table shared by every server; a field is sliced out of the request head and
+// a method is bound to this request only when the handler first touches it.
+// A handler that reads req.path and calls res.end() costs two objects and one
+// function instead of a closure per method and a copy of every header.
+
+using HttpStatePtr = std::shared_ptr<HttpRequestState>;
+using HttpMemberFn = Value (*)(const HttpStatePtr&, const std::vector<Value>&, EnvPtr, const Token&);
+
+struct HttpMember {
+    enum Kind { Field,
+        Method,
+        Getter };
+    const char* name;
+    Kind kind;
+    HttpMemberFn fn;
+};
 
-            FunctionPtr write_fn = std::get<FunctionPtr>(write_it->second.value);
+class HttpMemberProps : public HostProps {
+   public:
+    HttpMemberProps(HttpStatePtr state, const char* prefix, const HttpMember* table, size_t count)
+        : state_(std::move(state)), prefix_(prefix), table_(table), count_(count) {}
+
+    bool resolve(ObjectValue& self, const std::string& key) override {
+        for (size_t i = 0; i < count_; ++i) {
+            if (key != table_[i].name) continue;
+            if (provided_ & (1u << i)) return false;  // deleted by the script
+            provide(self, i);
+            return true;
+        }
+        return false;
+    }
 
-            if (write_fn->is_native && write_fn->native_impl) {
-                try {
-                    Value result = write_fn->native_impl({args[0]}, env, token);
-
-                    // ✅ BACKPRESSURE - if write returns false, pause req
-                    if (std::holds_alternative<bool>(result) && !std::get<bool>(result)) {
-                        // Pause reading from socket
-                        if (!state->reading_paused && state->client) {
-                            uv_read_stop(state->client);
-                            state->reading_paused = true;
-                        }
-                    }
+    void materialize(ObjectValue& self) override {
+        for (size_t i = 0; i < count_; ++i) {
+            if (!(provided_ & (1u << i))) provide(self, i);
+        }
+    }
 
-                    return result;
-                } catch (...) {
-                    return Value{false};
-                }
-            }
+   private:
+    void provide(ObjectValue& self, size_t i) {
+        provided_ |= 1u << i;
+        const HttpMember& m = table_[i];
+        // A key the script set itself keeps the script's value.
+        if (self.properties.count(m.name)) return;
+        if (m.kind == HttpMember::Field) {
+            self.properties.try_emplace(m.name, PropertyDescriptor{m.fn(state_, {}, nullptr, Token{}), false, false, true, Token{}});
+            return;
+        }
+        HttpStatePtr state = state_;
+        HttpMemberFn fn = m.fn;
+        auto bound = std::make_shared<FunctionValue>(
+            std::string(prefix_) + m.name,
+            [state, fn](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+                return fn(state, args, env, token);
+            },
+            nullptr, Token{});
+        bool getter = m.kind == HttpMember::Getter;
+        self.properties.try_emplace(m.name, PropertyDescriptor{Value{bound}, false, getter, getter, Token{}});
+    }
 
-            return Value{false};
-        };
+    HttpStatePtr state_;
+    const char* prefix_;
+    const HttpMember* table_;
+    size_t count_;
+    uint32_t provided_ = 0;
+};
 
-        auto data_fn = std::make_shared<FunctionValue>("req-pipe.data", data_handler, nullptr, evt_tok);
-        state->data_listeners.push_back(data_fn);
+// req.headers: a view over the parsed header spans.  Names are lowercase; for
+// a repeated header the last value wins.
+class HttpHeaderProps : public HostProps {
+   public:
+    explicit HttpHeaderProps(HttpStatePtr state) : state_(std::move(state)), given_(state_->header_spans.size(), false) {}
 
-        // ✅ DRAIN HANDLER - resume req when writable drains
-        auto drain_handler = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-            // Resume reading from socket
-            if (state->reading_paused && state->client) {
-                uv_read_start(state->client, alloc_buffer, on_read);
-                state->reading_paused = false;
-            }
-            return std::monostate{};
-        };
+    bool resolve(ObjectValue& self, const std::string& key) override {
+        int idx = state_->find_header(key);
+        if (idx < 0 || given_[idx]) return false;
+        give(self, idx);
+        return true;
+    }
 
-        auto drain_fn = std::make_shared<FunctionValue>("req-pipe.drain", drain_handler, nullptr, evt_tok);
+    void materialize(ObjectValue& self) override {
+        for (size_t i = 0; i < given_.size(); ++i) {
+            if (given_[i]) continue;
+            int idx = state_->find_header(state_->header_name(i));
+            if (idx >= 0) give(self, idx);
+        }
+    }
 
-        // Attach drain listener to destination
-        auto on_it = dest_obj->properties.find("on");
-        if (on_it != dest_obj->properties.end() && std::holds_alternative<FunctionPtr>(on_it->second.value)) {
-            FunctionPtr on_fn = std::get<FunctionPtr>(on_it->second.value);
-            if (on_fn->is_native && on_fn->native_impl) {
-                try {
-                    on_fn->native_impl({Value{std::string("drain")}, Value{drain_fn}}, env, evt_tok);
-                } catch (...) {}
-            }
+   private:
+    void give(ObjectValue& self, int idx) {
+        std::string_view name = state_->header_name(idx);
+        for (size_t i = 0; i < given_.size(); ++i) {
+            if (state_->header_name(i) == name) given_[i] = true;
         }
+        self.properties.try_emplace(std::string(name),
+            PropertyDescriptor{Value{std::string(state_->header_value(idx))}, false, false, true, Token{}});
+    }
 
-        // ✅ END HANDLER - call end() on writable when req ends
-        if (end_on_finish) {
-            auto end_handler = [dest_obj](const std::vector<Value>&, EnvPtr env, const Token& token) -> Value {
-                auto end_it = dest_obj->properties.find("end");
-                if (end_it == dest_obj->properties.end()) return std::monostate{};
+    HttpStatePtr state_;
+    std::vector<bool> given_;
+};
 
-                if (!std::holds_alternative<FunctionPtr>(end_it->second.value)) return std::monostate{};
+static const char* http_method_name(int method) {
+    switch (method) {
+        case HTTP_GET:
+            return "GET";
+        case HTTP_POST:
+            return "POST";
+        case HTTP_PUT:
+            return "PUT";
+        case HTTP_DELETE:
+            return "DELETE";
+        case HTTP_PATCH:
+            return "PATCH";
+        case HTTP_HEAD:
+            return "HEAD";
+        case HTTP_OPTIONS:
+            return "OPTIONS";
+        default:
+            return "UNKNOWN";
+    }
+}
 
-                FunctionPtr end_fn = std::get<FunctionPtr>(end_it->second.value);
+static Value req_method(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{std::string(http_method_name(state->method))};
+}
 
-                if (end_fn->is_native && end_fn->native_impl) {
-                    try {
-                        return end_fn->native_impl({}, env, token);
-                    } catch (...) {
-                        return std::monostate{};
-                    }
-                }
+static Value req_path(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{std::string(state->path())};
+}
 
-                return std::monostate{};
-            };
+static Value req_query(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{std::string(state->query())};
+}
 
-            auto end_fn = std::make_shared<FunctionValue>("req-pipe.end", end_handler, nullptr, evt_tok);
-            state->end_listeners.push_back(end_fn);
-        }
+static Value req_url(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{std::string(state->url())};
+}
 
-        // Return destination for chaining
-        return Value{dest_obj};
-    };
-    req_obj->properties["pipe"] = {
-        Value{std::make_shared<FunctionValue>("req.pipe", pipe_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+// req.tls: { protocol, cipher, alpn, resumed } on https, null otherwise.
+static Value req_tls(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    const std::shared_ptr<HttpTlsSession>& tls = state->response->tls;
+    if (!tls) return std::monostate{};
+    auto o = std::make_shared<ObjectValue>();
+    o->properties["protocol"] = {Value{tls->protocol()}, false, false, true, Token{}};
+    o->properties["cipher"] = {Value{tls->cipher()}, false, false, true, Token{}};
+    o->properties["alpn"] = {Value{tls->alpn()}, false, false, true, Token{}};
+    o->properties["resumed"] = {Value{tls->resumed()}, false, false, true, Token{}};
+    return Value{o};
+}
 
-    state->req_stream_obj = req_obj;
+static Value req_headers(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    auto headers_obj = std::make_shared<ObjectValue>();
+    headers_obj->host = std::make_shared<HttpHeaderProps>(state);
+    return Value{headers_obj};
+}
 
-    // Build response object
-    auto res_obj = std::make_shared<ObjectValue>();
+// req.on(event, callback)
+static Value req_on(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.size() < 2 || !std::holds_alternative<std::string>(args[0]) ||
+        !std::holds_alternative<FunctionPtr>(args[1])) {
+        throw SwaziError("TypeError", "req.on(event, callback) requires event and function", token.loc);
+    }
 
-    static std::atomic<long long> g_next_http_response_id{1000000};  // Start high to avoid collision
-    res_obj->properties["_id"] = {
-        Value{static_cast<double>(g_next_http_response_id.fetch_add(1))},
-        false, false, true, Token{}};
+    std::string event = std::get<std::string>(args[0]);
+    FunctionPtr callback = std::get<FunctionPtr>(args[1]);
 
-    // res.writeHead(statusCode, headers?)
-    auto writeHead_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (state->response->headers_flushed) {
-            throw SwaziError("Error", "Cannot write head after headers sent", token.loc);
+    if (event == "data") {
+        state->data_listeners.push_back(callback);
+        if (!state->buffered_chunks.empty() && !state->draining_buffer) {
+            state->drain_buffered_chunks();
         }
-        if (args.empty()) {
-            throw SwaziError("TypeError", "writeHead requires status code", token.loc);
+    } else if (event == "end") {
+        state->end_listeners.push_back(callback);
+        if (state->message_complete && state->buffered_chunks.empty()) {
+            try {
+                state->evaluator->invoke_function(callback, {}, state->env, Token{});
+            } catch (...) {
+                // Listener error - continue
+            }
         }
+    } else if (event == "error") {
+        state->error_listeners.push_back(callback);
+    }
 
-        int code = static_cast<int>(std::get<double>(args[0]));
-        state->response->status_code = code;
+    return std::monostate{};
+}
 
-        // Optional reason phrase
-        if (args.size() >= 2 && std::holds_alternative<std::string>(args[1])) {
-            state->response->reason = std::get<std::string>(args[1]);
-        } else {
-            state->response->reason = HttpResponse::reason_for_code(code);
-        }
+// req.pause()
+static Value req_pause(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    if (!state->reading_paused && state->client) {
+        uv_read_stop(state->client);
+        state->reading_paused = true;
+    }
+    return std::monostate{};
+}
 
-        // Optional headers object
-        size_t headers_idx = (args.size() >= 2 && std::holds_alternative<std::string>(args[1])) ? 2 : 1;
-        if (args.size() > headers_idx && std::holds_alternative<ObjectPtr>(args[headers_idx])) {
-            ObjectPtr hdrs = std::get<ObjectPtr>(args[headers_idx]);
-            for (const auto& kv : hdrs->properties) {
-                state->response->headers.set(kv.first, value_to_string_simple_local(kv.second.value));
-            }
-        }
+// req.resume()
+static Value req_resume(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    if (state->reading_paused && state->client) {
+        uv_read_start(state->client, alloc_buffer, on_read);
+        state->reading_paused = false;
+    }
+    return std::monostate{};
+}
 
-        return std::monostate{};
-    };
-    res_obj->properties["writeHead"] = {
-        Value{std::make_shared<FunctionValue>("res.writeHead", writeHead_impl, nullptr, Token{})},
-        false, false, false, Token{}};
-
-    // res.setHeader(name, value)
-    auto setHeader_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.size() < 2) {
-            throw SwaziError("TypeError", "setHeader requires name and value", token.loc);
-        }
-        std::string name = value_to_string_simple_local(args[0]);
-        std::string value = value_to_string_simple_local(args[1]);
-        state->response->headers.set(name, value);  // ✅ Case-insensitive
-        return std::monostate{};
-    };
-    res_obj->properties["setHeader"] = {
-        Value{std::make_shared<FunctionValue>("res.setHeader", setHeader_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+// req.pipe(writable)
+static Value req_pipe(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr env, const Token& tok) {
+    if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0])) {
+        throw SwaziError("TypeError", "req.pipe() requires writable stream", tok.loc);
+    }
 
-    // res.removeHeader(name)
-    auto removeHeader_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (state->response->headers_flushed) {
-            throw SwaziError("Error", "Cannot remove headers after they are sent", token.loc);
-        }
-        if (args.empty()) {
-            throw SwaziError("TypeError", "removeHeader requires name", token.loc);
-        }
-        std::string name = value_to_string_simple_local(args[0]);
-        state->response->headers.remove(name);  // ✅ Case-insensitive
-        return std::monostate{};
-    };
-    res_obj->properties["removeHeader"] = {
-        Value{std::make_shared<FunctionValue>("res.removeHeader", removeHeader_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+    dest_obj->materialize();
 
-    // res.hasHeader(name)
-    auto hasHeader_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty()) {
-            throw SwaziError("TypeError", "hasHeader requires name", token.loc);
-        }
-        std::string name = value_to_string_simple_local(args[0]);
-        return Value{state->response->headers.has(name)};  // ✅ Case-insensitive
-    };
-    res_obj->properties["hasHeader"] = {
-        Value{std::make_shared<FunctionValue>("res.hasHeader", hasHeader_impl, nullptr, Token{})},
-        false, false, false, Token{}};
-
-    // res.getHeaders()
-    auto getHeaders_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        auto headers_obj = std::make_shared<ObjectValue>();
-        for (auto it = state->response->headers.begin(); it != state->response->headers.end(); ++it) {
-            auto kv = *it;
-            headers_obj->properties[kv.first] = {Value{kv.second}, false, false, true, Token{}};
+    // Parse options for end behavior
+    bool end_on_finish = true;
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        ObjectPtr opts = std::get<ObjectPtr>(args[1]);
+        auto end_it = opts->properties.find("end");
+        if (end_it != opts->properties.end() && std::holds_alternative<bool>(end_it->second.value)) {
+            end_on_finish = std::get<bool>(end_it->second.value);
         }
-        return Value{headers_obj};
-    };
-    res_obj->properties["getHeaders"] = {
-        Value{std::make_shared<FunctionValue>("res.getHeaders", getHeaders_impl, nullptr, Token{})},
-        false, false, false, Token{}};
-
-    // res.flushHeaders()
-    auto flushHeaders_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        state->response->flush_headers();
-        return std::monostate{};
-    };
-    res_obj->properties["flushHeaders"] = {
-        Value{std::make_shared<FunctionValue>("res.flushHeaders", flushHeaders_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    }
 
-    // res.headersSent (property)
-    auto headersSent_getter = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        return Value{state->response->headers_flushed};
-    };
-    res_obj->properties["headersSent"] = {
-        Value{std::make_shared<FunctionValue>("get_headersSent", headersSent_getter, nullptr, Token{})},
-        false, true /* second true means a getter */, true, Token{}};
+    Token evt_tok{};
+    evt_tok.loc = TokenLocation("<req-pipe>", 0, 0, 0);
 
-    // res.getHeader(name)
-    auto getHeader_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty()) {
-            throw SwaziError("TypeError", "getHeader requires name", token.loc);
-        }
-        std::string name = value_to_string_simple_local(args[0]);
-        auto val = state->response->headers.get(name);
-        if (!val.has_value()) return Value{std::monostate{}};
-        return Value{val.value()};
-    };
-    res_obj->properties["getHeader"] = {
-        Value{std::make_shared<FunctionValue>("res.getHeader", getHeader_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    // ✅ DATA HANDLER - with backpressure support
+    auto data_handler = [dest_obj, state](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+        if (args.empty()) return std::monostate{};
 
-    // res.write(chunk)
-    auto write_impl = [state](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
-        if (args.empty()) return Value{true};
+        auto write_it = dest_obj->properties.find("write");
+        if (write_it == dest_obj->properties.end()) return std::monostate{};
 
-        std::vector<uint8_t> data;
-        if (std::holds_alternative<BufferPtr>(args[0])) {
-            data = std::get<BufferPtr>(args[0])->data;
-        } else if (std::holds_alternative<std::string>(args[0])) {
-            std::string str = std::get<std::string>(args[0]);
-            data.assign(str.begin(), str.end());
-        } else {
-            std::string str = value_to_string_simple_local(args[0]);
-            data.assign(str.begin(), str.end());
-        }
+        if (!std::holds_alternative<FunctionPtr>(write_it->second.value)) return std::monostate{};
 
-        bool success = state->response->write_chunk(data);
-        return Value{success};  // ✅ Return backpressure status
-    };
-    res_obj->properties["write"] = {
-        Value{std::make_shared<FunctionValue>("res.write", write_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+        FunctionPtr write_fn = std::get<FunctionPtr>(write_it->second.value);
 
-    // res.end(data?)
-    auto end_impl = [state](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
-        if (state->response->sendfile_active) {
-            return std::monostate{};
-        }
+        if (write_fn->is_native && write_fn->native_impl) {
+            try {
+                Value result = write_fn->native_impl({args[0]}, env, token);
+
+                // ✅ BACKPRESSURE - if write returns false, pause req
+                if (std::holds_alternative<bool>(result) && !std::get<bool>(result)) {
+                    // Pause reading from socket
+                    if (!state->reading_paused && state->client) {
+                        uv_read_stop(state->client);
+                        state->reading_paused = true;
+                    }
+                }
 
-        std::vector<uint8_t> data;
-        if (!args.empty()) {
-            if (std::holds_alternative<BufferPtr>(args[0])) {
-                data = std::get<BufferPtr>(args[0])->data;
-            } else if (std::holds_alternative<std::string>(args[0])) {
-                std::string str = std::get<std::string>(args[0]);
-                data.assign(str.begin(), str.end());
-            } else {
-                std::string str = value_to_string_simple_local(args[0]);
-                data.assign(str.begin(), str.end());
+                return result;
+            } catch (...) {
+                return Value{false};
             }
         }
-        state->response->end_response(data);
-        return std::monostate{};
-    };
-    res_obj->properties["end"] = {
-        Value{std::make_shared<FunctionValue>("res.end", end_impl, nullptr, Token{})},
-        false, false, false, Token{}};
-
-    // res.on(event, callback)
-    auto res_on_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.size() < 2 || !std::holds_alternative<std::string>(args[0]) ||
-            !std::holds_alternative<FunctionPtr>(args[1])) {
-            throw SwaziError("TypeError", "res.on(event, callback) requires event and function", token.loc);
-        }
-
-        std::string event = std::get<std::string>(args[0]);
-        FunctionPtr callback = std::get<FunctionPtr>(args[1]);
-
-        if (event == "drain") {
-            // Store on the response object so write completion can fire it
-            state->response->drain_listeners.push_back(callback);
-        } else if (event == "finish") {
-            // Optional: map to end/finish semantics if you want
-        } else if (event == "error") {
-            // Optional: store error listeners if desired
-        } else {
-            // Unknown event: ignore or throw depending on your policy
-        }
 
-        return std::monostate{};
+        return Value{false};
     };
-    res_obj->properties["on"] = {
-        Value{std::make_shared<FunctionValue>("res.on", res_on_impl, nullptr, Token{})},
-        false, false, false, Token{}};
 
-    // res.status(code)
-    auto status_impl = [state, res_obj](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
-        if (!args.empty()) {
-            state->response->status_code = static_cast<int>(std::get<double>(args[0]));
-            state->response->reason = HttpResponse::reason_for_code(state->response->status_code);
-        }
-        return Value{res_obj};
-    };
-    res_obj->properties["status"] = {
-        Value{std::make_shared<FunctionValue>("res.status", status_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    auto data_fn = std::make_shared<FunctionValue>("req-pipe.data", data_handler, nullptr, evt_tok);
+    state->data_listeners.push_back(data_fn);
 
-    // res.sendFile(FileValue)
-    auto sendFile_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty() || !std::holds_alternative<FilePtr>(args[0])) {
-            throw SwaziError("TypeError", "sendFile requires a File object", token.loc);
+    // ✅ DRAIN HANDLER - resume req when writable drains
+    auto drain_handler = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        // Resume reading from socket
+        if (state->reading_paused && state->client) {
+            uv_read_start(state->client, alloc_buffer, on_read);
+            state->reading_paused = false;
         }
+        return std::monostate{};
+    };
 
-        FilePtr file = std::get<FilePtr>(args[0]);
+    auto drain_fn = std::make_shared<FunctionValue>("req-pipe.drain", drain_handler, nullptr, evt_tok);
 
-        FunctionPtr callback = nullptr;
-        if (args.size() >= 2 && std::holds_alternative<FunctionPtr>(args[1])) {
-            callback = std::get<FunctionPtr>(args[1]);
+    // Attach drain listener to destination
+    auto on_it = dest_obj->properties.find("on");
+    if (on_it != dest_obj->properties.end() && std::holds_alternative<FunctionPtr>(on_it->second.value)) {
+        FunctionPtr on_fn = std::get<FunctionPtr>(on_it->second.value);
+        if (on_fn->is_native && on_fn->native_impl) {
+            try {
+                on_fn->native_impl({Value{std::string("drain")}, Value{drain_fn}}, env, evt_tok);
+            } catch (...) {}
         }
+    }
 
-        state->response->send_file(file, callback);
-        return std::monostate{};
-    };
-    res_obj->properties["sendFile"] = {
-        Value{std::make_shared<FunctionValue>("res.sendFile", sendFile_impl, nullptr, Token{})},
-        false, false, false, Token{}};
+    // ✅ END HANDLER - call end() on writable when req ends
+    if (end_on_finish) {
+        auto end_handler = [dest_obj](const std::vector<Value>&, EnvPtr env, const Token& token) -> Value {
+            auto end_it = dest_obj->properties.find("end");
+            if (end_it == dest_obj->properties.end()) return std::monostate{};
 
-    // res.redirect(url, statusCode?)
-    auto redirect_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty() || !std::holds_alternative<std::string>(args[0])) {
-            throw SwaziError("TypeError", "redirect requires URL", token.loc);
-        }
+            if (!std::holds_alternative<FunctionPtr>(end_it->second.value)) return std::monostate{};
 
-        std::string location = std::get<std::string>(args[0]);
-        int status = 302;
+            FunctionPtr end_fn = std::get<FunctionPtr>(end_it->second.value);
 
-        if (args.size() >= 2 && std::holds_alternative<double>(args[1])) {
-            status = static_cast<int>(std::get<double>(args[1]));
-        }
+            if (end_fn->is_native && end_fn->native_impl) {
+                try {
+                    return end_fn->native_impl({}, env, token);
+                } catch (...) {
+                    return std::monostate{};
+                }
+            }
+
+            return std::monostate{};
+        };
+
+        auto end_fn = std::make_shared<FunctionValue>("req-pipe.end", end_handler, nullptr, evt_tok);
+        state->end_listeners.push_back(end_fn);
+    }
+
+    // Return destination for chaining
+    return Value{dest_obj};
+}
+
+static const HttpMember REQUEST_MEMBERS[] = {
+    {"method", HttpMember::Field, req_method},
+    {"path", HttpMember::Field, req_path},
+    {"query", HttpMember::Field, req_query},
+    {"url", HttpMember::Field, req_url},
+    {"headers", HttpMember::Field, req_headers},
+    {"tls", HttpMember::Field, req_tls},
+    {"on", HttpMember::Method, req_on},
+    {"pause", HttpMember::Method, req_pause},
+    {"resume", HttpMember::Method, req_resume},
+    {"pipe", HttpMember::Method, req_pipe},
+};
 
-        if (status != 301 && status != 302 && status != 303 &&
-            status != 307 && status != 308) {
-            status = 302;
+static Value res_id(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{static_cast<double>(state->response_id)};
+}
+
+// res.writeHead(statusCode, headers?)
+static Value res_writeHead(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (state->response->headers_flushed) {
+        throw SwaziError("Error", "Cannot write head after headers sent", token.loc);
+    }
+    if (args.empty()) {
+        throw SwaziError("TypeError", "writeHead requires status code", token.loc);
+    }
+
+    int code = static_cast<int>(std::get<double>(args[0]));
+    state->response->status_code = code;
+
+    // Optional reason phrase
+    if (args.size() >= 2 && std::holds_alternative<std::string>(args[1])) {
+        state->response->reason = std::get<std::string>(args[1]);
+    } else {
+        state->response->reason = HttpResponse::reason_for_code(code);
+    }
+
+    // Optional headers object
+    size_t headers_idx = (args.size() >= 2 && std::holds_alternative<std::string>(args[1])) ? 2 : 1;
+    if (args.size() > headers_idx && std::holds_alternative<ObjectPtr>(args[headers_idx])) {
+        ObjectPtr hdrs = std::get<ObjectPtr>(args[headers_idx]);
+        for (const auto& kv : hdrs->properties) {
+            state->response->headers.set(kv.first, value_to_string_simple_local(kv.second.value));
         }
+    }
 
-        state->response->status_code = status;
-        state->response->headers.set("Location", location);  // ✅ Case-insensitive
-        state->response->end_response();
+    return std::monostate{};
+}
+
+// res.setHeader(name, value)
+static Value res_setHeader(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.size() < 2) {
+        throw SwaziError("TypeError", "setHeader requires name and value", token.loc);
+    }
+    std::string name = value_to_string_simple_local(args[0]);
+    std::string value = value_to_string_simple_local(args[1]);
+    state->response->headers.set(name, value);  // ✅ Case-insensitive
+    return std::monostate{};
+}
+
+// res.removeHeader(name)
+static Value res_removeHeader(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (state->response->headers_flushed) {
+        throw SwaziError("Error", "Cannot remove headers after they are sent", token.loc);
+    }
+    if (args.empty()) {
+        throw SwaziError("TypeError", "removeHeader requires name", token.loc);
+    }
+    std::string name = value_to_string_simple_local(args[0]);
+    state->response->headers.remove(name);  // ✅ Case-insensitive
+    return std::monostate{};
+}
+
+// res.hasHeader(name)
+static Value res_hasHeader(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.empty()) {
+        throw SwaziError("TypeError", "hasHeader requires name", token.loc);
+    }
+    std::string name = value_to_string_simple_local(args[0]);
+    return Value{state->response->headers.has(name)};  // ✅ Case-insensitive
+}
+
+// res.getHeaders()
+static Value res_getHeaders(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    auto headers_obj = std::make_shared<ObjectValue>();
+    for (auto it = state->response->headers.begin(); it != state->response->headers.end(); ++it) {
+        auto kv = *it;
+        headers_obj->properties[kv.first] = {Value{kv.second}, false, false, true, Token{}};
+    }
+    return Value{headers_obj};
+}
+
+// res.flushHeaders()
+static Value res_flushHeaders(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    state->response->flush_headers();
+    return std::monostate{};
+}
+
+// res.headersSent (property)
+static Value res_headersSent(const HttpStatePtr& state, const std::vector<Value>&, EnvPtr, const Token&) {
+    return Value{state->response->headers_flushed};
+}
+
+// res.getHeader(name)
+static Value res_getHeader(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.empty()) {
+        throw SwaziError("TypeError", "getHeader requires name", token.loc);
+    }
+    std::string name = value_to_string_simple_local(args[0]);
+    auto val = state->response->headers.get(name);
+    if (!val.has_value()) return Value{std::monostate{}};
+    return Value{val.value()};
+}
+
+// res.write(chunk)
+static Value res_write(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token&) {
+    if (args.empty()) return Value{true};
+
+    std::vector<uint8_t> data;
+    if (std::holds_alternative<BufferPtr>(args[0])) {
+        data = std::get<BufferPtr>(args[0])->data;
+    } else if (std::holds_alternative<std::string>(args[0])) {
+        const std::string& str = std::get<std::string>(args[0]);
+        data.assign(str.begin(), str.end());
+    } else {
+        std::string str = value_to_string_simple_local(args[0]);
+        data.assign(str.begin(), str.end());
+    }
+
+    bool success = state->response->write_chunk(std::move(data));
+    return Value{success};  // ✅ Return backpressure status
+}
 
+// res.end(data?)
+static Value res_end(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token&) {
+    if (state->response->sendfile_active) {
         return std::monostate{};
+    }
+
+    std::vector<uint8_t> data;
+    if (!args.empty()) {
+        if (std::holds_alternative<BufferPtr>(args[0])) {
+            data = std::get<BufferPtr>(args[0])->data;
+        } else if (std::holds_alternative<std::string>(args[0])) {
+            const std::string& str = std::get<std::string>(args[0]);
+            data.assign(str.begin(), str.end());
+        } else {
+            std::string str = value_to_string_simple_local(args[0]);
+            data.assign(str.begin(), str.end());
+        }
+    }
+    state->response->end_response(std::move(data));
+    return std::monostate{};
+}
+
+// res.on(event, callback)
+static Value res_on(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.size() < 2 || !std::holds_alternative<std::string>(args[0]) ||
+        !std::holds_alternative<FunctionPtr>(args[1])) {
+        throw SwaziError("TypeError", "res.on(event, callback) requires event and function", token.loc);
+    }
+
+    std::string event = std::get<std::string>(args[0]);
+    FunctionPtr callback = std::get<FunctionPtr>(args[1]);
+
+    if (event == "drain") {
+        // Store on the response object so write completion can fire it
+        state->response->drain_listeners.push_back(callback);
+    } else if (event == "finish") {
+        // Optional: map to end/finish semantics if you want
+    } else if (event == "error") {
+        // Optional: store error listeners if desired
+    } else {
+        // Unknown event: ignore or throw depending on your policy
+    }
+
+    return std::monostate{};
+}
+
+// res.status(code)
+static Value res_status(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token&) {
+    if (!args.empty()) {
+        state->response->status_code = static_cast<int>(std::get<double>(args[0]));
+        state->response->reason = HttpResponse::reason_for_code(state->response->status_code);
+    }
+    if (ObjectPtr self = state->res_self.lock()) return Value{self};
+    return std::monostate{};
+}
+
+// res.sendFile(path, opts?, callback?) / res.sendFile(file, callback?)
+//   opts: root, maxAge (seconds), headers, etag, lastModified, acceptRanges
+//
+// A path is served from the open-file cache (HttpFileCache.hpp) with
+// ETag / Last-Modified validators, 304 for a matching conditional GET and a
+// single byte range (206 / 416).  The bytes never enter interpreter memory.
+static Value send_path(const HttpStatePtr& state, const std::string& path, const ObjectPtr& opts,
+    FunctionPtr callback, const Token& token) {
+    HttpResponse& res = *state->response;
+    if (res.finished || res.sendfile_active) return std::monostate{};
+
+    auto opt = [&](const char* key) -> const Value* {
+        if (!opts) return nullptr;
+        auto it = opts->properties.find(key);
+        return it == opts->properties.end() ? nullptr : &it->second.value;
+    };
+    auto opt_bool = [&](const char* key, bool def) {
+        const Value* v = opt(key);
+        return v && std::holds_alternative<bool>(*v) ? std::get<bool>(*v) : def;
     };
-    res_obj->properties["redirect"] = {
-        Value{std::make_shared<FunctionValue>("res.redirect", redirect_impl, nullptr, Token{})},
-        false, false, false, Token{}};
 
+    std::string full = path;
+    if (const Value* root = opt("root")) {
+        if (!std::holds_alternative<std::string>(*root)) {
+            throw SwaziError("TypeError", "sendFile: root must be a string", token.loc);
+        }
+        // Relative to root, and never above it.
+        for (size_t pos = 0; pos <= path.size();) {
+            size_t end = path.find('/', pos);
+            if (end == std::string::npos) end = path.size();
+            if (path.compare(pos, end - pos, "..") == 0) {
+                throw SwaziError("ValueError", "sendFile: path escapes root: " + path, token.loc);
+            }
+            pos = end + 1;
+        }
+        full = std::get<std::string>(*root);
+        while (!full.empty() && full.back() == '/') full.pop_back();
+        full += '/';
+        size_t start = path.find_first_not_of('/');
+        if (start != std::string::npos) full.append(path, start, std::string::npos);
+    }
+
+    int err = 0;
+    HttpFilePtr file = http_file_cache_open(full, &err);
+    if (!file) {
+        std::string msg = std::string("sendFile: ") + uv_strerror(err) + ": " + full;
+        res.sendfile_callback = callback;
+        if (callback) {
+            res.call_sendfile_callback(msg);
+            return std::monostate{};
+        }
+        bool missing = err == UV_ENOENT || err == UV_ENOTDIR || err == UV_EISDIR;
+        res.status_code = missing ? 404 : (err == UV_EACCES ? 403 : 500);
+        res.headers.set("Content-Type", "text/plain");
+        std::string body = HttpResponse::reason_for_code(res.status_code) + "\n";
+        res.end_response(std::vector<uint8_t>(body.begin(), body.end()));
+        return std::monostate{};
+    }
+
+    bool use_etag = opt_bool("etag", true);
+    bool use_last_modified = opt_bool("lastModified", true);
+    bool use_ranges = opt_bool("acceptRanges", true);
+
+    if (!res.headers_flushed) {
+        if (const Value* extra = opt("headers")) {
+            if (std::holds_alternative<ObjectPtr>(*extra)) {
+                for (const auto& [name, desc] : std::get<ObjectPtr>(*extra)->properties) {
+                    res.headers.set(name, value_to_string_simple_local(desc.value));
+                }
+            }
+        }
+        if (!res.headers.has("Content-Type")) res.headers.set("Content-Type", file->content_type);
+        if (use_etag && !res.headers.has("ETag")) res.headers.set("ETag", file->etag);
+        if (use_last_modified && !res.headers.has("Last-Modified")) res.headers.set("Last-Modified", file->last_modified);
+        if (use_ranges) res.headers.set("Accept-Ranges", "bytes");
+        const Value* max_age = opt("maxAge");
+        if (max_age && std::holds_alternative<double>(*max_age) && !res.headers.has("Cache-Control")) {
+            long long secs = static_cast<long long>(std::max(0.0, std::get<double>(*max_age)));
+            res.headers.set("Cache-Control", "public, max-age=" + std::to_string(secs));
+        }
+    }
+
+    uint64_t first = 0;
+    uint64_t length = file->size;
+
+    bool conditional = !res.headers_flushed && res.status_code == 200 &&
+        (state->method == HTTP_GET || state->method == HTTP_HEAD);
+    if (conditional) {
+        bool not_modified = false;
+        int inm = state->find_header("if-none-match");
+        if (inm >= 0) {
+            not_modified = use_etag && http_etag_matches(state->header_value(inm), file->etag);
+        } else if (use_last_modified) {
+            int ims = state->find_header("if-modified-since");
+            int64_t since = 0;
+            if (ims >= 0 && http_parse_date(state->header_value(ims), &since)) not_modified = file->mtime <= since;
+        }
+        if (not_modified) {
+            res.status_code = 304;
+            res.headers.remove("Content-Type");
+            res.sendfile_callback = callback;
+            res.call_sendfile_callback("");
+            res.end_response();
+            return std::monostate{};
+        }
+
+        int range = use_ranges ? state->find_header("range") : -1;
+        if (range >= 0) {
+            // Our tags are weak, so only a date can validate If-Range.
+            int if_range = state->find_header("if-range");
+            if (if_range < 0 || state->header_value(if_range) == file->last_modified) {
+                uint64_t lo = 0, hi = 0;
+                int r = http_parse_range(state->header_value(range), file->size, &lo, &hi);
+                if (r < 0) {
+                    res.status_code = 416;
+                    res.headers.set("Content-Range", "bytes */" + std::to_string(file->size));
+                    res.headers.set("Content-Type", "text/plain");
+                    res.sendfile_callback = callback;
+                    res.call_sendfile_callback("");
+                    res.end_response();
+                    return std::monostate{};
+                }
+                if (r > 0) {
+                    res.status_code = 206;
+                    res.headers.set("Content-Range",
+                        "bytes " + std::to_string(lo) + "-" + std::to_string(hi) + "/" + std::to_string(file->size));
+                    first = lo;
+                    length = hi - lo + 1;
+                }
+            }
+        }
+    }
+
+    res.serve_file(file, first, length, callback);
+    return std::monostate{};
+}
+
+static Value res_sendFile(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.empty() || (!std::holds_alternative<FilePtr>(args[0]) && !std::holds_alternative<std::string>(args[0]))) {
+        throw SwaziError("TypeError", "sendFile requires a path or a File object", token.loc);
+    }
+
+    FunctionPtr callback = nullptr;
+    ObjectPtr opts = nullptr;
+    for (size_t i = 1; i < args.size() && i < 3; ++i) {
+        if (std::holds_alternative<FunctionPtr>(args[i])) callback = std::get<FunctionPtr>(args[i]);
+        if (std::holds_alternative<ObjectPtr>(args[i])) opts = std::get<ObjectPtr>(args[i]);
+    }
+
+    if (std::holds_alternative<std::string>(args[0])) {
+        return send_path(state, std::get<std::string>(args[0]), opts, callback, token);
+    }
+
+    state->response->send_file(std::get<FilePtr>(args[0]), callback);
+    return std::monostate{};
+}
+
+// res.redirect(url, statusCode?)
+static Value res_redirect(const HttpStatePtr& state, const std::vector<Value>& args, EnvPtr, const Token& token) {
+    if (args.empty() || !std::holds_alternative<std::string>(args[0])) {
+        throw SwaziError("TypeError", "redirect requires URL", token.loc);
+    }
+
+    std::string location = std::get<std::string>(args[0]);
+    int status = 302;
+
+    if (args.size() >= 2 && std::holds_alternative<double>(args[1])) {
+        status = static_cast<int>(std::get<double>(args[1]));
+    }
+
+    if (status != 301 && status != 302 && status != 303 &&
+        status != 307 && status != 308) {
+        status = 302;
+    }
+
+    state->response->status_code = status;
+    state->response->headers.set("Location", location);  // ✅ Case-insensitive
+    state->response->end_response();
+
+    return std::monostate{};
+}
+
+static const HttpMember RESPONSE_MEMBERS[] = {
+    {"_id", HttpMember::Field, res_id},
+    {"writeHead", HttpMember::Method, res_writeHead},
+    {"setHeader", HttpMember::Method, res_setHeader},
+    {"removeHeader", HttpMember::Method, res_removeHeader},
+    {"hasHeader", HttpMember::Method, res_hasHeader},
+    {"getHeaders", HttpMember::Method, res_getHeaders},
+    {"flushHeaders", HttpMember::Method, res_flushHeaders},
+    {"headersSent", HttpMember::Getter, res_headersSent},
+    {"getHeader", HttpMember::Method, res_getHeader},
+    {"write", HttpMember::Method, res_write},
+    {"end", HttpMember::Method, res_end},
+    {"on", HttpMember::Method, res_on},
+    {"status", HttpMember::Method, res_status},
+    {"sendFile", HttpMember::Method, res_sendFile},
+    {"redirect", HttpMember::Method, res_redirect},
+};
+
+// ============================================================================
+// LLHTTP CALLBACKS
+// ============================================================================
+
+static int on_message_begin(llhttp_t* parser) {
+    auto* conn = static_cast<HttpConnection*>(parser->data);
+    conn->begin_request();
+    return 0;
+}
+
+static int on_url(llhttp_t* parser, const char* at, size_t length) {
+    auto* state = static_cast<HttpConnection*>(parser->data)->current.get();
+    state->head.append(at, length);
+    state->url_len += length;
+    return 0;
+}
+
+// Field and value callbacks can each fire more than once for one header when it
+// straddles reads; a field after a value starts the next header.
+static int on_header_field(llhttp_t* parser, const char* at, size_t length) {
+    auto* state = static_cast<HttpConnection*>(parser->data)->current.get();
+    if (state->header_spans.empty() || state->in_header_value) {
+        state->header_spans.push_back({static_cast<uint32_t>(state->head.size()), 0, 0, 0});
+        state->in_header_value = false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        state->head.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(at[i]))));
+    }
+    state->header_spans.back().name_len += static_cast<uint32_t>(length);
+    return 0;
+}
+
+static int on_header_value(llhttp_t* parser, const char* at, size_t length) {
+    auto* state = static_cast<HttpConnection*>(parser->data)->current.get();
+    if (state->header_spans.empty()) return 0;
+    if (!state->in_header_value) {
+        state->header_spans.back().value_off = static_cast<uint32_t>(state->head.size());
+        state->in_header_value = true;
+    }
+    state->head.append(at, length);
+    state->header_spans.back().value_len += static_cast<uint32_t>(length);
+    return 0;
+}
+
+// Match the parsed method and path against the server's router.  Requests
+// that match no route are answered here without running any script.
+static void dispatch_to_router(const std::shared_ptr<HttpRequestState>& state) {
+    std::string allow;
+    HttpRouter::Result r = state->router->dispatch(http_method_name(state->method), state->path(),
+        state->req_stream_obj, state->res_obj, state->evaluator, state->env, &allow);
+    if (r == HttpRouter::Result::Handled) return;
+
+    HttpResponse& response = *state->response;
+    if (response.headers_flushed || response.finished) return;
+    std::string body;
+    if (r == HttpRouter::Result::MethodNotAllowed) {
+        response.status_code = 405;
+        response.headers.set("Allow", allow);
+        body = "Method Not Allowed\n";
+    } else {
+        response.status_code = 404;
+        body = "Not Found\n";
+    }
+    response.headers.set("Content-Type", "text/plain");
+    response.end_response(std::vector<uint8_t>(body.begin(), body.end()));
+}
+
+static int on_headers_complete(llhttp_t* parser) {
+    auto* conn = static_cast<HttpConnection*>(parser->data);
+    std::shared_ptr<HttpRequestState> state = conn->current;
+    state->headers_complete = true;
+    state->method = parser->method;
+
+    state->response->keep_alive = conn->wants_keep_alive();
+    state->response->http10 = parser->http_major == 1 && parser->http_minor == 0;
+    state->response->head_request = parser->method == HTTP_HEAD;
+
+    if (state->response->compression) {
+        int accept = state->find_header("accept-encoding");
+        if (accept >= 0) state->response->coding = http_negotiate_coding(state->header_value(accept));
+        int encoding = state->find_header("content-encoding");
+        if (encoding >= 0 && http_content_coding(state->header_value(encoding)) != ZlibStream::Format::None) {
+            state->decoder = ZlibStream::decoder();
+        }
+    }
+
+    // Start at a high id so res._id cannot collide with other stream ids.
+    static std::atomic<long long> g_next_http_response_id{1000000};
+    state->response_id = g_next_http_response_id.fetch_add(1);
+
+    auto req_obj = std::make_shared<ObjectValue>();
+    req_obj->host = std::make_shared<HttpMemberProps>(
+        state, "req.", REQUEST_MEMBERS, sizeof(REQUEST_MEMBERS) / sizeof(REQUEST_MEMBERS[0]));
+    state->req_stream_obj = req_obj;
+
+    auto res_obj = std::make_shared<ObjectValue>();
+    res_obj->host = std::make_shared<HttpMemberProps>(
+        state, "res.", RESPONSE_MEMBERS, sizeof(RESPONSE_MEMBERS) / sizeof(RESPONSE_MEMBERS[0]));
+    state->res_self = res_obj;
     state->res_obj = res_obj;
 
     // Call handler synchronously
-    if (state->request_handler && state->evaluator && !state->handler_called) {
+    if ((state->request_handler || state->router) && state->evaluator && !state->handler_called) {
         state->handler_called = true;
 
         try {
-            state->evaluator->invoke_function(
-                state->request_handler,
-                {Value{state->req_stream_obj}, Value{state->res_obj}},
-                state->env,
-                Token{});
+            if (state->router) {
+                dispatch_to_router(state);
+            } else {
+                state->evaluator->invoke_function(
+                    state->request_handler,
+                    {Value{state->req_stream_obj}, Value{state->res_obj}},
+                    state->env,
+                    Token{});
+            }
         } catch (const std::exception& e) {
             if (!state->response->headers_flushed && !state->response->finished) {
                 state->response->status_code = 500;
                 state->response->headers.set("Content-Type", "text/plain");  // ✅
                 std::string error_msg = "Internal Server Error\n";
                 std::vector<uint8_t> data(error_msg.begin(), error_msg.end());
-                state->response->end_response(data);
+                state->response->end_response(std::move(data));
             }
             // Handler threw - emit error to error listeners
             for (const auto& listener : state->error_listeners) {
@@ -1492,7 +2221,7 @@ static int on_headers_complete(llhttp_t* parser) {
                 state->response->headers.set("Content-Type", "text/plain");  // ✅
                 std::string error_msg = "Internal Server Error\n";
                 std::vector<uint8_t> data(error_msg.begin(), error_msg.end());
-                state->response->end_response(data);
+                state->response->end_response(std::move(data));
             }
             // Unknown error
             for (const auto& listener : state->error_listeners) {
@@ -1512,7 +2241,15 @@ static int on_headers_complete(llhttp_t* parser) {
 }
 
 static int on_body(llhttp_t* parser, const char* at, size_t length) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
+    std::shared_ptr<HttpRequestState> state = static_cast<HttpConnection*>(parser->data)->current;
+
+    std::vector<uint8_t> inflated;
+    if (state->decoder) {
+        if (!state->decoder->write(at, length, inflated)) return -1;  // corrupt body: parse error
+        if (inflated.empty()) return 0;
+        at = reinterpret_cast<const char*>(inflated.data());
+        length = inflated.size();
+    }
 
     if (state->data_listeners.empty()) {
         // Buffer but enforce limits
@@ -1532,7 +2269,8 @@ static int on_body(llhttp_t* parser, const char* at, size_t length) {
         buf->data.assign(at, at + length);
         buf->encoding = "binary";
 
-        for (const auto& listener : state->data_listeners) {
+        std::vector<FunctionPtr> data_cbs = state->data_listeners;
+        for (const auto& listener : data_cbs) {
             if (listener && state->evaluator) {
                 try {
                     state->evaluator->invoke_function(listener, {Value{buf}}, state->env, Token{});
@@ -1547,11 +2285,12 @@ static int on_body(llhttp_t* parser, const char* at, size_t length) {
 }
 
 static int on_message_complete(llhttp_t* parser) {
-    auto* state = static_cast<HttpRequestState*>(parser->data);
+    std::shared_ptr<HttpRequestState> state = static_cast<HttpConnection*>(parser->data)->current;
     state->message_complete = true;
 
     // Emit end event
-    for (const auto& listener : state->end_listeners) {
+    std::vector<FunctionPtr> end_cbs = state->end_listeners;
+    for (const auto& listener : end_cbs) {
         if (listener && state->evaluator) {
             try {
                 state->evaluator->invoke_function(listener, {}, state->env, Token{});
@@ -1559,8 +2298,9 @@ static int on_message_complete(llhttp_t* parser) {
         }
     }
 
-    // Connection will close after response is sent (no keep-alive)
-    return 0;
+    // Hold the parser at the message boundary; HttpConnection::advance resumes
+    // it once this response is out, so pipelined responses stay in order.
+    return HPE_PAUSED;
 }
 
 // ============================================================================
@@ -1568,82 +2308,69 @@ static int on_message_complete(llhttp_t* parser) {
 // ============================================================================
 
 static void on_read(uv_stream_t* client, ssize_t nread, const uv_buf_t* buf) {
+    auto* conn = static_cast<HttpConnection*>(client->data);
+
     if (nread > 0) {
-        auto* state = static_cast<HttpRequestState*>(client->data);
-        if (!state) {
-            if (buf->base) free(buf->base);
+        if (!conn || conn->closing) {
+            read_pool_release(buf);
             return;
         }
 
-        llhttp_errno_t err = llhttp_execute(&state->parser, buf->base, nread);
+        conn->stop_idle_timer();
 
-        if (err != HPE_OK) {
-            std::string error = std::string("HTTP parse error: ") + llhttp_errno_name(err);
-
-            for (const auto& listener : state->error_listeners) {
-                if (listener && state->evaluator) {
-                    scheduler_run_on_loop([listener, error]() {
-                        try {
-                            CallbackPayload* payload = new CallbackPayload(listener, {Value{error}});
-                            enqueue_callback_global(static_cast<void*>(payload));
-                        } catch (...) {}
-                    });
-                }
+        if (conn->tls) {
+            // Handshake records and decrypted requests come out of the same
+            // call; the handshake just takes as many reads as it needs.
+            std::string plain, out;
+            bool ok = conn->tls->read(buf->base, static_cast<size_t>(nread), plain, out);
+            read_pool_release(buf);
+            send_tls_output(client, std::move(out));
+            if (!ok) {
+                conn->close();
+                return;
             }
-
-            // Request an orderly close rather than deleting state here.
-            if (state->response) {
-                state->closing = true;
-                state->response->request_close();
-            } else {
-                // No response object; fallback: just close the handle if not already closing.
-                if (!uv_is_closing((uv_handle_t*)client)) {
-                    uv_close((uv_handle_t*)client, [](uv_handle_t* h) {
-                        // If a state pointer was attached, close_client_and_state would handle it.
-                        // Here we simply free the client.
-                        delete (uv_tcp_t*)h;
-                    });
-                }
+            if (!plain.empty()) conn->receive(plain.data(), plain.size());
+            if (conn->tls->peer_closed()) {
+                if (!conn->closing && !conn->eof) conn->end_of_input();
+            } else if (!conn->tls->established()) {
+                conn->arm_idle_timer();  // a stalled handshake is idle too
             }
+            return;
         }
+        conn->receive(buf->base, static_cast<size_t>(nread));
     } else if (nread < 0) {
         // Client closed connection (normal or error)
-        if (buf->base) free(buf->base);
+        read_pool_release(buf);
 
-        auto* state = static_cast<HttpRequestState*>(client->data);
-        if (state && state->response) {
-            state->closing = true;
-            state->response->request_close();
-        } else {
-            // No state/response; just close client handle
+        if (!conn) {
+            // No connection state; just close client handle
             if (!uv_is_closing((uv_handle_t*)client)) {
                 uv_close((uv_handle_t*)client, [](uv_handle_t* h) {
                     delete (uv_tcp_t*)h;
                 });
             }
+            return;
+        }
+
+        if (nread == UV_EOF) {
+            conn->end_of_input();
+        } else {
+            uv_read_stop(client);
+            conn->close();
         }
-        return;  // Return early, don't try to free buf->base again
+        return;  // Return early, don't release buf again
     }
 
-    if (buf->base) free(buf->base);
+    read_pool_release(buf);
 }
-static void alloc_buffer(uv_handle_t*, size_t suggested_size, uv_buf_t* buf) {
-    buf->base = (char*)malloc(suggested_size);
-    buf->len = static_cast<unsigned int>(suggested_size);
+static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    read_pool_alloc(handle, suggested_size, buf);
 }
 
 // ============================================================================
 // SERVER
 // ============================================================================
 
-struct ServerInstance {
-    uv_tcp_t* server_handle = nullptr;
-    FunctionPtr request_handler;
-    std::atomic<bool> closed{false};
-    EnvPtr env;
-    Evaluator* evaluator;
-};
-
 static std::mutex g_servers_mutex;
 static std::unordered_map<long long, std::shared_ptr<ServerInstance>> g_servers;
 static std::atomic<long long> g_next_server_id{1};
@@ -1658,49 +2385,714 @@ static void on_connection(uv_stream_t* server, int status) {
     uv_tcp_init(server->loop, client);
 
     if (uv_accept(server, (uv_stream_t*)client) == 0) {
-        auto* state = new HttpRequestState();
-        state->client = (uv_stream_t*)client;
-        state->request_handler = srv->request_handler;
-        state->env = srv->env;
-        state->evaluator = srv->evaluator;
-        state->response = std::make_shared<HttpResponse>();
-        state->response->client = (uv_stream_t*)client;
-        state->response->env = state->env;
-        state->response->evaluator = state->evaluator;
+        uv_tcp_nodelay(client, 1);
+
+        auto* conn = new HttpConnection();
+        conn->client = (uv_stream_t*)client;
+        conn->server = srv->shared_from_this();
+        if (srv->tls) conn->tls = std::make_shared<HttpTlsSession>(srv->tls);
 
-        llhttp_settings_init(&state->settings);
-        state->settings.on_url = on_url;
-        state->settings.on_header_field = on_header_field;
-        state->settings.on_header_value = on_header_value;
-        state->settings.on_headers_complete = on_headers_complete;
-        state->settings.on_body = on_body;
-        state->settings.on_message_complete = on_message_complete;
+        llhttp_settings_init(&conn->settings);
+        conn->settings.on_message_begin = on_message_begin;
+        conn->settings.on_url = on_url;
+        conn->settings.on_header_field = on_header_field;
+        conn->settings.on_header_value = on_header_value;
+        conn->settings.on_headers_complete = on_headers_complete;
+        conn->settings.on_body = on_body;
+        conn->settings.on_message_complete = on_message_complete;
 
-        llhttp_init(&state->parser, HTTP_REQUEST, &state->settings);
-        state->parser.data = state;
+        llhttp_init(&conn->parser, HTTP_REQUEST, &conn->settings);
+        conn->parser.data = conn;
 
-        client->data = state;
+        client->data = conn;
+        srv->connections.insert(conn);
 
         uv_read_start((uv_stream_t*)client, alloc_buffer, on_read);
+        // A client that connects and never sends anything is idle too.
+        conn->arm_idle_timer();
     } else {
         uv_close((uv_handle_t*)client, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
     }
 }
 
+static const int HTTP_LISTEN_BACKLOG = 128;
+
+// Bind and listen on `loop`.  flags are uv_tcp_bind flags (UV_TCP_REUSEPORT for
+// cluster workers).  On failure the handle is closed again, `stage` names the
+// step that failed and the uv error is returned.
+static int server_listen(const std::shared_ptr<ServerInstance>& inst, uv_loop_t* loop, int port,
+    unsigned int flags, const char** stage = nullptr) {
+    inst->server_handle = new uv_tcp_t;
+    inst->server_handle->data = inst.get();
+    uv_tcp_init(loop, inst->server_handle);
+
+    struct sockaddr_in addr;
+    uv_ip4_addr("0.0.0.0", port, &addr);
+
+    int r = uv_tcp_bind(inst->server_handle, (const struct sockaddr*)&addr, flags);
+    if (stage) *stage = "bind";
+    if (r == 0) {
+        r = uv_listen((uv_stream_t*)inst->server_handle, HTTP_LISTEN_BACKLOG, on_connection);
+        if (stage) *stage = "listen on";
+    }
+    if (r != 0) {
+        uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+        inst->server_handle = nullptr;
+    }
+    return r;
+}
+
+#ifndef _WIN32
+// Listen on a dup of a socket that is already bound and listening (see
+// open_shared_listen_socket); every loop doing this accepts from one queue.
+static int server_listen_fd(const std::shared_ptr<ServerInstance>& inst, uv_loop_t* loop, int fd) {
+    int dupfd = dup(fd);
+    if (dupfd < 0) return uv_translate_sys_error(errno);
+
+    inst->server_handle = new uv_tcp_t;
+    inst->server_handle->data = inst.get();
+    uv_tcp_init(loop, inst->server_handle);
+
+    int r = uv_tcp_open(inst->server_handle, dupfd);
+    if (r != 0) ::close(dupfd);
+    if (r == 0) r = uv_listen((uv_stream_t*)inst->server_handle, HTTP_LISTEN_BACKLOG, on_connection);
+    if (r != 0) {
+        uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+        inst->server_handle = nullptr;
+    }
+    return r;
+}
+
+static int open_shared_listen_socket(int port, int* out_fd) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return uv_translate_sys_error(errno);
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    uv_ip4_addr("0.0.0.0", port, &addr);
+    if (bind(fd, (const struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, HTTP_LISTEN_BACKLOG) != 0) {
+        int err = errno;
+        ::close(fd);
+        return uv_translate_sys_error(err);
+    }
+    *out_fd = fd;
+    return 0;
+}
+#endif
+
+// Stop accepting.  Idle keep-alive sockets close now, busy ones after their
+// current response (HttpConnection::advance sees `closed`).  Loop thread only;
+// safe to call more than once.
+static void server_instance_close(const std::shared_ptr<ServerInstance>& inst) {
+    inst->closed.store(true);
+    if (inst->server_handle) {
+        uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) {
+            delete (uv_tcp_t*)h;
+        });
+        inst->server_handle = nullptr;
+    }
+    std::vector<HttpConnection*> conns(inst->connections.begin(), inst->connections.end());
+    for (HttpConnection* conn : conns) {
+        if (!conn->current) conn->close();
+    }
+}
+
+// compression: false | true | { threshold, level, types }
+static void parse_compression_option(const Value& v, ServerInstance& inst, const Token& token) {
+    if (std::holds_alternative<bool>(v)) {
+        inst.compression = std::get<bool>(v) && ZlibStream::available() ? std::make_shared<HttpCompression>() : nullptr;
+        return;
+    }
+    if (!std::holds_alternative<ObjectPtr>(v)) {
+        throw SwaziError("TypeError", "compression must be a boolean or an object", token.loc);
+    }
+    ObjectPtr o = std::get<ObjectPtr>(v);
+    auto cfg = std::make_shared<HttpCompression>();
+
+    auto th_it = o->properties.find("threshold");
+    if (th_it != o->properties.end() && std::holds_alternative<double>(th_it->second.value)) {
+        double n = std::get<double>(th_it->second.value);
+        if (n < 0) throw SwaziError("RangeError", "compression.threshold must be >= 0", token.loc);
+        cfg->threshold = static_cast<size_t>(n);
+    }
+
+    auto lv_it = o->properties.find("level");
+    if (lv_it != o->properties.end() && std::holds_alternative<double>(lv_it->second.value)) {
+        double n = std::get<double>(lv_it->second.value);
+        if (n < 0 || n > 9) throw SwaziError("RangeError", "compression.level must be between 0 and 9", token.loc);
+        cfg->level = static_cast<int>(n);
+    }
+
+    auto ty_it = o->properties.find("types");
+    if (ty_it != o->properties.end() && std::holds_alternative<ArrayPtr>(ty_it->second.value)) {
+        cfg->types.clear();
+        for (const auto& el : std::get<ArrayPtr>(ty_it->second.value)->elements) {
+            if (!std::holds_alternative<std::string>(el)) {
+                throw SwaziError("TypeError", "compression.types must be an array of strings", token.loc);
+            }
+            cfg->types.push_back(lowercase(std::get<std::string>(el)));
+        }
+    }
+
+    inst.compression = ZlibStream::available() ? std::move(cfg) : nullptr;
+}
+
+// cert / key / passphrase / sessionTimeout / sessionTickets.  cert and key are
+// PEM text or file paths; the context is built (and the pair checked) here so
+// a bad certificate fails createServer rather than the first handshake.
+static void parse_tls_options(const ObjectPtr& opts, ServerInstance& inst, const Token& token) {
+    auto cert_it = opts->properties.find("cert");
+    auto key_it = opts->properties.find("key");
+    if (cert_it == opts->properties.end() && key_it == opts->properties.end()) return;
+    if (cert_it == opts->properties.end() || key_it == opts->properties.end() ||
+        !std::holds_alternative<std::string>(cert_it->second.value) ||
+        !std::holds_alternative<std::string>(key_it->second.value)) {
+        throw SwaziError("TypeError", "https needs both cert and key as strings (PEM text or file paths)", token.loc);
+    }
+
+    HttpTlsOptions tls;
+    tls.cert = std::get<std::string>(cert_it->second.value);
+    tls.key = std::get<std::string>(key_it->second.value);
+
+    auto pass_it = opts->properties.find("passphrase");
+    if (pass_it != opts->properties.end() && std::holds_alternative<std::string>(pass_it->second.value)) {
+        tls.passphrase = std::get<std::string>(pass_it->second.value);
+    }
+
+    auto st_it = opts->properties.find("sessionTimeout");
+    if (st_it != opts->properties.end() && std::holds_alternative<double>(st_it->second.value)) {
+        double secs = std::get<double>(st_it->second.value);
+        if (secs < 0) throw SwaziError("RangeError", "sessionTimeout must be >= 0", token.loc);
+        tls.session_timeout_s = static_cast<uint32_t>(secs);
+    }
+
+    auto tk_it = opts->properties.find("sessionTickets");
+    if (tk_it != opts->properties.end() && std::holds_alternative<bool>(tk_it->second.value)) {
+        tls.tickets = std::get<bool>(tk_it->second.value);
+    }
+
+    try {
+        inst.tls = http_tls_context_create(tls);
+    } catch (const std::exception& e) {
+        throw SwaziError("Error", e.what(), token.loc);
+    }
+}
+
+// keepAlive / keepAliveTimeout / maxRequestsPerSocket / compression / TLS
+// from createServer options.
+static void parse_server_options(const ObjectPtr& opts, ServerInstance& inst, const Token& token) {
+    auto ka_it = opts->properties.find("keepAlive");
+    if (ka_it != opts->properties.end() && std::holds_alternative<bool>(ka_it->second.value)) {
+        inst.keep_alive = std::get<bool>(ka_it->second.value);
+    }
+
+    auto kat_it = opts->properties.find("keepAliveTimeout");
+    if (kat_it != opts->properties.end() && std::holds_alternative<double>(kat_it->second.value)) {
+        double ms = std::get<double>(kat_it->second.value);
+        if (ms < 0) throw SwaziError("RangeError", "keepAliveTimeout must be >= 0", token.loc);
+        inst.keep_alive_timeout_ms = static_cast<uint64_t>(ms);
+    }
+
+    auto max_it = opts->properties.find("maxRequestsPerSocket");
+    if (max_it != opts->properties.end() && std::holds_alternative<double>(max_it->second.value)) {
+        double n = std::get<double>(max_it->second.value);
+        if (n < 0) throw SwaziError("RangeError", "maxRequestsPerSocket must be >= 0", token.loc);
+        inst.max_requests_per_socket = static_cast<uint64_t>(n);
+    }
+
+    auto comp_it = opts->properties.find("compression");
+    if (comp_it != opts->properties.end()) parse_compression_option(comp_it->second.value, inst, token);
+
+    parse_tls_options(opts, inst, token);
+}
+
+// { handshakes, resumed, failed } for server.tlsStats(); null without TLS.
+static Value tls_stats_value(const HttpTlsContextPtr& ctx) {
+    if (!ctx) return std::monostate{};
+    HttpTlsStats st = http_tls_stats(ctx);
+    auto o = std::make_shared<ObjectValue>();
+    o->properties["handshakes"] = {Value{static_cast<double>(st.handshakes)}, false, false, true, Token{}};
+    o->properties["resumed"] = {Value{static_cast<double>(st.resumed)}, false, false, true, Token{}};
+    o->properties["failed"] = {Value{static_cast<double>(st.failed)}, false, false, true, Token{}};
+    return Value{o};
+}
+
+static void post_callback(const FunctionPtr& cb, std::vector<Value> args) {
+    if (!cb) return;
+    CallbackPayload* payload = new CallbackPayload(cb, std::move(args));
+    enqueue_callback_global(static_cast<void*>(payload));
+}
+
+// ============================================================================
+// MULTI-CORE SERVING
+// ============================================================================
+//
+// createServer(handler, { workers: N }) serves from N interpreter threads
+// (spawn_native_worker), each with its own loop and listener.  Where the OS
+// balances SO_REUSEPORT sockets (Linux, the BSDs) every worker binds the port
+// itself; elsewhere, and for port 0, the main thread opens one listening
+// socket and each worker accepts from a dup of it.
+//
+// The handler runs like a Worker(fn) body: same AST, but in the worker's fresh
+// global env without the closure it was written in, so it must import what it
+// uses.  ClusterServer state lives on the main loop; each worker owns its
+// ServerInstance and is reached through its scheduler.
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__DragonFly__)
+#define SWAZI_HTTP_REUSEPORT 1
+#endif
+
+struct ClusterMember {
+    WorkerCtxPtr ctx;
+    std::shared_ptr<ServerInstance> inst;  // worker thread only
+    std::atomic<bool> drain_requested{false};
+
+    // Main loop only.
+    bool listening = false;
+    bool retiring = false;               // drained on purpose, not respawned
+    std::function<void(int)> on_listen;  // uv status of the worker's listen
+    std::function<void()> on_exit;
+};
+using ClusterMemberPtr = std::shared_ptr<ClusterMember>;
+
+struct ClusterServer : public std::enable_shared_from_this<ClusterServer> {
+    FunctionPtr handler;
+    ServerInstance config;  // keep-alive and compression options copied into every worker
+    int workers = 1;
+    uint64_t drain_timeout_ms = 30000;
+    Evaluator* evaluator = nullptr;
+    Token token;
+
+    int port = -1;
+    int shared_fd = -1;
+    bool closing = false;
+    bool restarting = false;
+    int next_id = 0;
+    std::vector<ClusterMemberPtr> members;
+    std::vector<FunctionPtr> close_callbacks;
+    uv_timer_t* drain_timer = nullptr;
+
+    ClusterMemberPtr spawn_member();
+    void drain_member(const ClusterMemberPtr& m);
+    void member_exited(const ClusterMemberPtr& m, int code);
+    void close(FunctionPtr cb);
+    void finish_close();
+    void restart_next(std::vector<ClusterMemberPtr> queue, FunctionPtr cb);
+    void restart_failed(const FunctionPtr& cb, const std::string& error);
+};
+
+// Worker thread body.  `cl` outlives the thread: the member's exit callback,
+// which runs on the main loop after this returns, holds a reference.
+static void cluster_worker_main(ClusterServer* cl, ClusterMemberPtr m, WorkerCtx& ctx, Evaluator& ev) {
+    auto inst = std::make_shared<ServerInstance>();
+    inst->request_handler = isolate_function(cl->handler, ev.get_global_env());
+    inst->env = ev.get_global_env();
+    inst->evaluator = &ev;
+    inst->keep_alive = cl->config.keep_alive;
+    inst->keep_alive_timeout_ms = cl->config.keep_alive_timeout_ms;
+    inst->max_requests_per_socket = cl->config.max_requests_per_socket;
+    inst->compression = cl->config.compression;
+    inst->tls = cl->config.tls;  // one context, so sessions resume on any worker
+    m->inst = inst;
+
+    uv_loop_t* loop = ev.scheduler()->get_uv_loop();
+    int r;
+#ifndef _WIN32
+    if (cl->shared_fd >= 0) {
+        r = server_listen_fd(inst, loop, cl->shared_fd);
+    } else
+#endif
+    {
+        r = server_listen(inst, loop, cl->port, UV_TCP_REUSEPORT);
+    }
+
+    if (Scheduler* main = ctx.main_scheduler) {
+        main->enqueue_macrotask([m, r]() {
+            m->listening = (r == 0);
+            if (m->on_listen) {
+                auto cb = std::move(m->on_listen);
+                m->on_listen = nullptr;
+                cb(r);
+            }
+        });
+        main->notify();
+    }
+
+    if (r == 0 && m->drain_requested.load()) server_instance_close(inst);
+
+    // Serves until drained: returns once the listener and every connection
+    // are closed.
+    ev.run_loop();
+    m->inst.reset();
+}
+
+ClusterMemberPtr ClusterServer::spawn_member() {
+    auto m = std::make_shared<ClusterMember>();
+    auto self = shared_from_this();
+    ClusterServer* raw = this;
+    m->ctx = spawn_native_worker(
+        evaluator, "http:" + std::to_string(next_id++),
+        [raw, m](WorkerCtx& ctx, Evaluator& ev) { cluster_worker_main(raw, m, ctx, ev); },
+        [self, m](int code) { self->member_exited(m, code); },
+        token);
+    members.push_back(m);
+    return m;
+}
+
+void ClusterServer::drain_member(const ClusterMemberPtr& m) {
+    m->retiring = true;
+    if (m->drain_requested.exchange(true)) return;
+    // Not booted yet: cluster_worker_main checks drain_requested after listening.
+    Scheduler* ws = m->ctx ? m->ctx->worker_scheduler.load() : nullptr;
+    if (!ws) return;
+    ws->enqueue_macrotask([m]() {
+        if (m->inst) server_instance_close(m->inst);
+    });
+    ws->notify();
+}
+
+void ClusterServer::member_exited(const ClusterMemberPtr& m, int code) {
+    members.erase(std::remove(members.begin(), members.end(), m), members.end());
+    bool was_listening = m->listening;
+    m->listening = false;
+
+    if (m->on_listen) {
+        // Died before it could report (fatal error while booting).
+        auto cb = std::move(m->on_listen);
+        m->on_listen = nullptr;
+        cb(UV_ECANCELED);
+    }
+    if (m->on_exit) {
+        auto hook = std::move(m->on_exit);
+        m->on_exit = nullptr;
+        hook();
+    }
+
+    if (!m->retiring && !closing && was_listening) {
+        // Crashed while serving: replace it so capacity stays at `workers`.
+        std::cerr << "[http] worker " << (m->ctx ? m->ctx->label : std::string("?"))
+                  << " exited with code " << code << "; restarting\n";
+        try {
+            spawn_member();
+        } catch (const std::exception& e) {
+            std::cerr << "[http] could not restart worker: " << e.what() << "\n";
+        }
+    }
+
+    if (closing && members.empty()) finish_close();
+}
+
+void ClusterServer::close(FunctionPtr cb) {
+    if (cb) close_callbacks.push_back(cb);
+    if (closing) return;
+    closing = true;
+
+    if (members.empty()) {
+        finish_close();
+        return;
+    }
+
+    std::vector<ClusterMemberPtr> snapshot = members;
+    for (auto& m : snapshot) drain_member(m);
+
+    if (drain_timeout_ms > 0) {
+        // Workers still busy after the timeout (stuck handler, timers left
+        // running) are stopped outright.
+        drain_timer = new uv_timer_t;
+        uv_timer_init(evaluator->scheduler()->get_uv_loop(), drain_timer);
+        drain_timer->data = this;
+        uv_timer_start(drain_timer, [](uv_timer_t* t) {
+            auto* cl = static_cast<ClusterServer*>(t->data);
+            if (!cl) return;
+            for (auto& m : cl->members) {
+                Scheduler* ws = m->ctx ? m->ctx->worker_scheduler.load() : nullptr;
+                if (ws) ws->stop();
+            }
+        },
+            drain_timeout_ms, 0);
+    }
+}
+
+void ClusterServer::finish_close() {
+    if (drain_timer) {
+        uv_timer_stop(drain_timer);
+        drain_timer->data = nullptr;
+        uv_close((uv_handle_t*)drain_timer, [](uv_handle_t* h) { delete (uv_timer_t*)h; });
+        drain_timer = nullptr;
+    }
+#ifndef _WIN32
+    if (shared_fd >= 0) {
+        ::close(shared_fd);
+        shared_fd = -1;
+    }
+#endif
+    std::vector<FunctionPtr> cbs;
+    cbs.swap(close_callbacks);
+    for (auto& cb : cbs) post_callback(cb, {});
+}
+
+void ClusterServer::restart_failed(const FunctionPtr& cb, const std::string& error) {
+    restarting = false;
+    post_callback(cb, {Value{error}});
+}
+
+// Rolling restart, one worker at a time.  The replacement is brought up before
+// the old worker drains so the port never goes unserved; at the worker cap the
+// old one drains first instead.
+void ClusterServer::restart_next(std::vector<ClusterMemberPtr> queue, FunctionPtr cb) {
+    if (closing) {
+        restart_failed(cb, "server closed during restart");
+        return;
+    }
+    if (queue.empty()) {
+        restarting = false;
+        post_callback(cb, {Value{std::monostate{}}});
+        return;
+    }
+
+    ClusterMemberPtr old = queue.front();
+    queue.erase(queue.begin());
+    if (old->retiring || std::find(members.begin(), members.end(), old) == members.end()) {
+        restart_next(std::move(queue), cb);
+        return;
+    }
+
+    auto self = shared_from_this();
+    ClusterMemberPtr fresh;
+    try {
+        fresh = spawn_member();
+    } catch (const std::exception&) {
+        fresh = nullptr;
+    }
+
+    if (fresh) {
+        fresh->on_listen = [self, old, queue, cb](int r) {
+            if (r != 0) {
+                self->restart_failed(cb, uv_strerror(r));
+                return;
+            }
+            old->on_exit = [self, queue, cb]() { self->restart_next(queue, cb); };
+            self->drain_member(old);
+        };
+        return;
+    }
+
+    old->on_exit = [self, queue, cb]() {
+        ClusterMemberPtr replacement;
+        try {
+            replacement = self->spawn_member();
+        } catch (const std::exception& e) {
+            self->restart_failed(cb, e.what());
+            return;
+        }
+        replacement->on_listen = [self, queue, cb](int r) {
+            if (r != 0) {
+                self->restart_failed(cb, uv_strerror(r));
+                return;
+            }
+            self->restart_next(queue, cb);
+        };
+    };
+    drain_member(old);
+}
+
+static Value make_cluster_server(const FunctionPtr& handler, const ObjectPtr& opts, const Token& token, Evaluator* evaluator) {
+    if (!handler || handler->is_native || !handler->body) {
+        throw SwaziError("TypeError",
+            "createServer(handler, { workers }): the handler must be a script function (native functions cannot be moved to a worker)",
+            token.loc);
+    }
+
+    auto cl = std::make_shared<ClusterServer>();
+    cl->handler = handler;
+    cl->evaluator = evaluator;
+    cl->token = token;
+    parse_server_options(opts, cl->config, token);
+
+    const Value& wv = opts->properties["workers"].value;
+    if (std::holds_alternative<std::string>(wv) && std::get<std::string>(wv) == "auto") {
+        cl->workers = SWAZI_MAX_WORKERS;
+    } else if (std::holds_alternative<double>(wv) && std::get<double>(wv) >= 1) {
+        cl->workers = std::min(static_cast<int>(std::get<double>(wv)), SWAZI_MAX_WORKERS);
+    } else {
+        throw SwaziError("RangeError", "workers must be a number >= 1 or \"auto\"", token.loc);
+    }
+
+    auto dt_it = opts->properties.find("drainTimeout");
+    if (dt_it != opts->properties.end() && std::holds_alternative<double>(dt_it->second.value)) {
+        double ms = std::get<double>(dt_it->second.value);
+        if (ms < 0) throw SwaziError("RangeError", "drainTimeout must be >= 0", token.loc);
+        cl->drain_timeout_ms = static_cast<uint64_t>(ms);
+    }
+
+    auto server_obj = std::make_shared<ObjectValue>();
+
+    // server.listen(port, cb?) — cb(err) once every worker is listening.
+    auto listen_impl = [cl](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty() || !std::holds_alternative<double>(args[0])) {
+            throw SwaziError("TypeError", "listen requires port number", token.loc);
+        }
+        if (cl->port >= 0) {
+            throw SwaziError("Error", "server is already listening", token.loc);
+        }
+        int port = static_cast<int>(std::get<double>(args[0]));
+        FunctionPtr cb = (args.size() >= 2 && std::holds_alternative<FunctionPtr>(args[1]))
+            ? std::get<FunctionPtr>(args[1])
+            : nullptr;
+
+        auto report_error = [cb, port](const std::string& msg) {
+            if (cb) {
+                post_callback(cb, {Value{msg}});
+            } else {
+                std::cerr << ("Server failed to listen on port " + std::to_string(port) + ": " + msg) << "\n";
+            }
+        };
+
+        cl->port = port;
+#ifdef _WIN32
+        throw SwaziError("NotImplementedError", "createServer { workers } is not supported on Windows", token.loc);
+#else
+#ifdef SWAZI_HTTP_REUSEPORT
+        bool shared = port == 0;  // each REUSEPORT bind would get its own ephemeral port
+#else
+        bool shared = true;
+#endif
+        if (shared) {
+            int r = open_shared_listen_socket(port, &cl->shared_fd);
+            if (r != 0) {
+                report_error(uv_strerror(r));
+                return std::monostate{};
+            }
+        }
+#endif
+
+        auto remaining = std::make_shared<int>(cl->workers);
+        auto failed = std::make_shared<bool>(false);
+        try {
+            for (int i = 0; i < cl->workers; ++i) {
+                ClusterMemberPtr m = cl->spawn_member();
+                m->on_listen = [cl, cb, remaining, failed, report_error](int r) {
+                    if (*failed) return;
+                    if (r != 0) {
+                        *failed = true;
+                        cl->close(nullptr);
+                        report_error(uv_strerror(r));
+                        return;
+                    }
+                    if (--*remaining == 0) post_callback(cb, {Value{std::monostate{}}});
+                };
+            }
+        } catch (...) {
+            *failed = true;
+            cl->close(nullptr);
+            throw;
+        }
+        return std::monostate{};
+    };
+    server_obj->properties["listen"] = {
+        Value{std::make_shared<FunctionValue>("server.listen", listen_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
+    // server.close(cb?) — graceful drain of every worker; cb() when all exited.
+    auto close_impl = [cl](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        FunctionPtr cb = (!args.empty() && std::holds_alternative<FunctionPtr>(args[0]))
+            ? std::get<FunctionPtr>(args[0])
+            : nullptr;
+        cl->close(cb);
+        return std::monostate{};
+    };
+    server_obj->properties["close"] = {
+        Value{std::make_shared<FunctionValue>("server.close", close_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
+    // server.restart(cb?) — rolling restart without dropping the port; cb(err).
+    auto restart_impl = [cl](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        FunctionPtr cb = (!args.empty() && std::holds_alternative<FunctionPtr>(args[0]))
+            ? std::get<FunctionPtr>(args[0])
+            : nullptr;
+        if (cl->port < 0) throw SwaziError("Error", "server is not listening", token.loc);
+        if (cl->closing) throw SwaziError("Error", "server is closed", token.loc);
+        if (cl->restarting) throw SwaziError("Error", "a restart is already in progress", token.loc);
+        cl->restarting = true;
+        cl->restart_next(cl->members, cb);
+        return std::monostate{};
+    };
+    server_obj->properties["restart"] = {
+        Value{std::make_shared<FunctionValue>("server.restart", restart_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
+    // server.tlsStats() — counted across all workers, which share one TLS context
+    auto tls_stats_impl = [cl](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        return tls_stats_value(cl->config.tls);
+    };
+    server_obj->properties["tlsStats"] = {
+        Value{std::make_shared<FunctionValue>("server.tlsStats", tls_stats_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
+    // server.workers() — [{ id, listening }]
+    auto workers_impl = [cl](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        auto arr = std::make_shared<ArrayValue>();
+        for (auto& m : cl->members) {
+            auto obj = std::make_shared<ObjectValue>();
+            obj->properties["id"] = {Value{m->ctx ? m->ctx->label : std::string()}, false, false, true, Token{}};
+            obj->properties["listening"] = {Value{m->listening}, false, false, true, Token{}};
+            obj->properties["draining"] = {Value{m->retiring}, false, false, true, Token{}};
+            arr->elements.push_back(Value{obj});
+        }
+        return Value{arr};
+    };
+    server_obj->properties["workers"] = {
+        Value{std::make_shared<FunctionValue>("server.workers", workers_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
+    return Value{server_obj};
+}
+
 // ============================================================================
 // EXPORTS
 // ============================================================================
 
-Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator) {
-    if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0])) {
-        throw SwaziError("TypeError", "createServer requires a request handler function", token.loc);
+Value native_createServer(const std::vector<Value>& call_args, EnvPtr env, const Token& token, Evaluator* evaluator) {
+    // createServer(handler, opts) or, as https servers are usually written,
+    // createServer(opts, handler).
+    std::vector<Value> args = call_args;
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[0]) && !http_router_from_value(args[0]) &&
+        (std::holds_alternative<FunctionPtr>(args[1]) || http_router_from_value(args[1]))) {
+        std::swap(args[0], args[1]);
+    }
+
+    std::shared_ptr<HttpRouter> router = args.empty() ? nullptr : http_router_from_value(args[0]);
+    if (!router && (args.empty() || !std::holds_alternative<FunctionPtr>(args[0]))) {
+        throw SwaziError("TypeError", "createServer requires a request handler function or an http.Router", token.loc);
+    }
+
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        ObjectPtr opts = std::get<ObjectPtr>(args[1]);
+        if (opts->properties.count("workers")) {
+            if (router) {
+                throw SwaziError("TypeError",
+                    "createServer(router, { workers }) is not supported: build the router inside a handler function instead",
+                    token.loc);
+            }
+            return make_cluster_server(std::get<FunctionPtr>(args[0]), opts, token, evaluator);
+        }
     }
 
     auto inst = std::make_shared<ServerInstance>();
-    inst->request_handler = std::get<FunctionPtr>(args[0]);
+    if (router) {
+        inst->router = router;
+    } else {
+        inst->request_handler = std::get<FunctionPtr>(args[0]);
+    }
     inst->env = env;
     inst->evaluator = evaluator;
 
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        parse_server_options(std::get<ObjectPtr>(args[1]), *inst, token);
+    }
+
     long long id = g_next_server_id.fetch_add(1);
     {
         std::lock_guard<std::mutex> lk(g_servers_mutex);
@@ -1725,41 +3117,20 @@ Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Toke
         }
 
         scheduler_run_on_loop([inst, port, cb, loop, token]() {
-            inst->server_handle = new uv_tcp_t;
-            inst->server_handle->data = inst.get();
-            uv_tcp_init(loop, inst->server_handle);
-
-            struct sockaddr_in addr;
-            uv_ip4_addr("0.0.0.0", port, &addr);
-
-            int s = uv_tcp_bind(inst->server_handle, (const struct sockaddr*)&addr, 0);
-            if (s != 0) {
-                if (cb) {
-                    // pass error as first argument like Node.js: cb(error)
-                    CallbackPayload* payload = new CallbackPayload(cb, {Value{std::string(uv_strerror(s))}});
-                    enqueue_callback_global(static_cast<void*>(payload));
-                } else {
-                    std::cerr << ("Server failed to bind port " + std::to_string(port) + ": " + uv_strerror(s)) << "\n";
-                }
-                return;  // stop, don't try to listen
-            }
-
-            int r = uv_listen((uv_stream_t*)inst->server_handle, 128, on_connection);
+            const char* stage = "listen on";
+            int r = server_listen(inst, loop, port, 0, &stage);
             if (r != 0) {
                 if (cb) {
-                    CallbackPayload* payload = new CallbackPayload(cb, {Value{std::string(uv_strerror(r))}});
-                    enqueue_callback_global(static_cast<void*>(payload));
+                    // pass error as first argument like Node.js: cb(error)
+                    post_callback(cb, {Value{std::string(uv_strerror(r))}});
                 } else {
-                    std::cerr << ("Server failed to listen on port " + std::to_string(port) + ": " + uv_strerror(r)) << "\n";
+                    std::cerr << ("Server failed to " + std::string(stage) + " port " + std::to_string(port) + ": " + uv_strerror(r)) << "\n";
                 }
                 return;
             }
 
             // success, call callback with no error
-            if (cb) {
-                CallbackPayload* payload = new CallbackPayload(cb, {Value{}});  // no error
-                enqueue_callback_global(static_cast<void*>(payload));
-            }
+            post_callback(cb, {Value{}});
         });
         return std::monostate{};
     };
@@ -1775,16 +3146,8 @@ Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Toke
         inst->closed.store(true);
 
         scheduler_run_on_loop([inst, cb]() {
-            if (inst->server_handle) {
-                uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) {
-                    delete (uv_tcp_t*)h;
-                });
-                inst->server_handle = nullptr;
-            }
-            if (cb) {
-                CallbackPayload* payload = new CallbackPayload(cb, {});
-                enqueue_callback_global(static_cast<void*>(payload));
-            }
+            server_instance_close(inst);
+            post_callback(cb, {});
         });
 
         {
@@ -1797,6 +3160,14 @@ Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Toke
         Value{std::make_shared<FunctionValue>("server.close", close_impl, nullptr, Token{})},
         false, false, true, Token{}};
 
+    // server.tlsStats() -> { handshakes, resumed, failed }, or null over plain http
+    auto tls_stats_impl = [inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        return tls_stats_value(inst->tls);
+    };
+    server_obj->properties["tlsStats"] = {
+        Value{std::make_shared<FunctionValue>("server.tlsStats", tls_stats_impl, nullptr, Token{})},
+        false, false, true, Token{}};
+
     return Value{server_obj};
 }
 
@@ -1806,12 +3177,12 @@ Value native_createServer(const std::vector<Value>& args, EnvPtr env, const Toke
 
 static void close_client_and_state(uv_handle_t* h) {
     if (!h) return;
-    // Try to delete associated HttpRequestState if present in handle->data.
-    auto* state = static_cast<HttpRequestState*>(h->data);
-    if (state) {
+    // Delete the associated HttpConnection (and detach its request) if present.
+    auto* conn = static_cast<HttpConnection*>(h->data);
+    if (conn) {
         // Clear data so we don't double-delete later.
         h->data = nullptr;
-        delete state;
+        delete conn;
     }
 
     // Finally free the uv handle memory (we always allocated as uv_tcp_t)
@@ -0,0 +1,562 @@
+// http_static.cc
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncBridge.hpp"
+#include "HttpFileCache.hpp"
+#include "SwaziError.hpp"
+#include "builtins.hpp"
+#include "evaluator.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#define open _open
+#define close _close
+#define read _read
+#define fstat _fstat64
+#define stat _stat64
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+// ============================================================================
+// FILE CACHE
+// ============================================================================
+
+static constexpr size_t HTTP_FILE_CACHE_MAX_ENTRIES = 256;
+
+HttpFileEntry::~HttpFileEntry() {
+    if (fd >= 0) ::close(fd);
+}
+
+struct FileWatch {
+    uv_fs_event_t handle;
+    std::string path;
+};
+
+struct FileCacheSlot {
+    std::shared_ptr<HttpFileEntry> entry;
+    FileWatch* watch = nullptr;  // null if the file could not be watched
+    std::list<std::string>::iterator lru;
+};
+
+struct FileCache {
+    uv_loop_t* loop = nullptr;
+    std::unordered_map<std::string, FileCacheSlot> slots;
+    std::list<std::string> lru;  // most recently used first
+};
+
+static thread_local FileCache t_file_cache;
+
+static void close_watch(FileWatch* w) {
+    if (!w) return;
+    uv_fs_event_stop(&w->handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(&w->handle), [](uv_handle_t* h) {
+        delete static_cast<FileWatch*>(h->data);
+    });
+}
+
+static void file_cache_drop(const std::string& path) {
+    auto it = t_file_cache.slots.find(path);
+    if (it == t_file_cache.slots.end()) return;
+    close_watch(it->second.watch);
+    t_file_cache.lru.erase(it->second.lru);
+    t_file_cache.slots.erase(it);
+}
+
+static void on_file_changed(uv_fs_event_t* handle, const char*, int, int) {
+    // Copy: dropping the slot closes this watch.
+    std::string path = static_cast<FileWatch*>(handle->data)->path;
+    file_cache_drop(path);
+}
+
+static FileWatch* watch_file(uv_loop_t* loop, const std::string& path) {
+    auto* w = new FileWatch;
+    w->path = path;
+    w->handle.data = w;
+    if (uv_fs_event_init(loop, &w->handle) != 0) {
+        delete w;
+        return nullptr;
+    }
+    if (uv_fs_event_start(&w->handle, on_file_changed, path.c_str(), 0) != 0) {
+        uv_close(reinterpret_cast<uv_handle_t*>(&w->handle), [](uv_handle_t* h) {
+            delete static_cast<FileWatch*>(h->data);
+        });
+        return nullptr;
+    }
+    uv_unref(reinterpret_cast<uv_handle_t*>(&w->handle));
+    return w;
+}
+
+static std::shared_ptr<HttpFileEntry> open_entry(const std::string& path, int* err) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_BINARY);
+    if (fd < 0) {
+        *err = uv_translate_sys_error(errno);
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        *err = uv_translate_sys_error(errno);
+        ::close(fd);
+        return nullptr;
+    }
+    if ((st.st_mode & S_IFMT) == S_IFDIR) {
+        *err = UV_EISDIR;
+        ::close(fd);
+        return nullptr;
+    }
+    if ((st.st_mode & S_IFMT) != S_IFREG) {
+        *err = UV_EINVAL;
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<HttpFileEntry>();
+    entry->path = path;
+    entry->fd = fd;
+    entry->size = static_cast<uint64_t>(st.st_size);
+    entry->mtime = static_cast<int64_t>(st.st_mtime);
+    char tag[48];
+    snprintf(tag, sizeof(tag), "W/\"%llx-%llx\"",
+        static_cast<unsigned long long>(entry->size), static_cast<unsigned long long>(entry->mtime));
+    entry->etag = tag;
+    entry->last_modified = http_format_date(entry->mtime);
+    entry->content_type = http_mime_type(path);
+
+    if (entry->size <= HTTP_FILE_INLINE_LIMIT) {
+        auto data = std::make_shared<std::string>();
+        data->resize(static_cast<size_t>(entry->size));
+        size_t got = 0;
+        while (got < data->size()) {
+            auto n = ::read(fd, data->data() + got, static_cast<unsigned int>(data->size() - got));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            got += static_cast<size_t>(n);
+        }
+        if (got != data->size()) {
+            // Changed while we read it; serve it from the descriptor instead.
+            return entry;
+        }
+        entry->data = std::move(data);
+        ::close(entry->fd);
+        entry->fd = -1;
+    }
+    return entry;
+}
+
+// An unwatched entry is still good if a fresh stat agrees with it.
+static bool entry_still_valid(const HttpFileEntry& e) {
+    struct stat st;
+    if (::stat(e.path.c_str(), &st) != 0) return false;
+    return static_cast<uint64_t>(st.st_size) == e.size && static_cast<int64_t>(st.st_mtime) == e.mtime;
+}
+
+HttpFilePtr http_file_cache_open(const std::string& path, int* err) {
+    int local_err = 0;
+    if (!err) err = &local_err;
+    *err = 0;
+
+    uv_loop_t* loop = scheduler_get_loop();
+    if (loop && t_file_cache.loop != loop) {
+        http_file_cache_shutdown(t_file_cache.loop);
+        t_file_cache.loop = loop;
+    }
+
+    auto it = t_file_cache.slots.find(path);
+    if (it != t_file_cache.slots.end()) {
+        if (it->second.watch || entry_still_valid(*it->second.entry)) {
+            t_file_cache.lru.splice(t_file_cache.lru.begin(), t_file_cache.lru, it->second.lru);
+            return it->second.entry;
+        }
+        file_cache_drop(path);
+    }
+
+    std::shared_ptr<HttpFileEntry> entry = open_entry(path, err);
+    if (!entry || !loop) return entry;
+
+    if (t_file_cache.slots.size() >= HTTP_FILE_CACHE_MAX_ENTRIES) {
+        file_cache_drop(t_file_cache.lru.back());
+    }
+    t_file_cache.lru.push_front(path);
+    FileCacheSlot& slot = t_file_cache.slots[path];
+    slot.entry = entry;
+    slot.watch = watch_file(loop, path);
+    slot.lru = t_file_cache.lru.begin();
+    return entry;
+}
+
+void http_file_cache_shutdown(uv_loop_t* loop) {
+    if (!loop || t_file_cache.loop != loop) return;
+    for (auto& [path, slot] : t_file_cache.slots) close_watch(slot.watch);
+    t_file_cache.slots.clear();
+    t_file_cache.lru.clear();
+    t_file_cache.loop = nullptr;
+}
+
+// ============================================================================
+// HEADERS
+// ============================================================================
+
+const char* http_mime_type(std::string_view path) {
+    static const struct {
+        const char* ext;
+        const char* type;
+    } TYPES[] = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"js", "text/javascript; charset=utf-8"},
+        {"mjs", "text/javascript; charset=utf-8"},
+        {"json", "application/json"},
+        {"map", "application/json"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"md", "text/markdown; charset=utf-8"},
+        {"sl", "text/plain; charset=utf-8"},
+        {"csv", "text/csv; charset=utf-8"},
+        {"xml", "application/xml"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"avif", "image/avif"},
+        {"ico", "image/x-icon"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"otf", "font/otf"},
+        {"wasm", "application/wasm"},
+        {"pdf", "application/pdf"},
+        {"zip", "application/zip"},
+        {"gz", "application/gzip"},
+        {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"},
+        {"wav", "audio/wav"},
+        {"mp4", "video/mp4"},
+        {"webm", "video/webm"},
+    };
+
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) {
+        return "application/octet-stream";
+    }
+    std::string ext(path.substr(dot + 1));
+    for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    for (const auto& t : TYPES) {
+        if (ext == t.ext) return t.type;
+    }
+    return "application/octet-stream";
+}
+
+static const char* const WEEKDAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// Days since 1970-01-01 for a proleptic Gregorian date (month 1-12).
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+std::string http_format_date(int64_t epoch_sec) {
+    time_t t = static_cast<time_t>(epoch_sec);
+    struct tm tm_utc;
+#ifdef _WIN32
+    gmtime_s(&tm_utc, &t);
+#else
+    gmtime_r(&t, &tm_utc);
+#endif
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+        WEEKDAYS[tm_utc.tm_wday], tm_utc.tm_mday, MONTHS[tm_utc.tm_mon], tm_utc.tm_year + 1900,
+        tm_utc.tm_hour, tm_utc.tm_min, tm_utc.tm_sec);
+    return buf;
+}
+
+bool http_parse_date(std::string_view text, int64_t* epoch_sec) {
+    std::string s(text);
+    char month[4] = {0};
+    int day = 0, year = 0, hh = 0, mm = 0, ss = 0;
+
+    // IMF-fixdate, RFC 850, asctime
+    if (sscanf(s.c_str(), "%*3s, %2d %3s %4d %2d:%2d:%2d GMT", &day, month, &year, &hh, &mm, &ss) != 6 &&
+        sscanf(s.c_str(), "%*[a-zA-Z], %2d-%3s-%2d %2d:%2d:%2d GMT", &day, month, &year, &hh, &mm, &ss) != 6 &&
+        sscanf(s.c_str(), "%*3s %3s %2d %2d:%2d:%2d %4d", month, &day, &hh, &mm, &ss, &year) != 6) {
+        return false;
+    }
+    if (year < 100) year += year < 70 ? 2000 : 1900;
+
+    int mon = -1;
+    for (int i = 0; i < 12; ++i) {
+        if (std::string_view(month) == MONTHS[i]) mon = i;
+    }
+    if (mon < 0 || day < 1 || day > 31 || hh > 23 || mm > 59 || ss > 60) return false;
+
+    *epoch_sec = days_from_civil(year, static_cast<unsigned>(mon + 1), static_cast<unsigned>(day)) * 86400 +
+        hh * 3600 + mm * 60 + ss;
+    return true;
+}
+
+static std::string_view trim(std::string_view v) {
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    return v;
+}
+
+static std::string_view opaque_tag(std::string_view tag) {
+    if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/') tag.remove_prefix(2);
+    return tag;
+}
+
+bool http_etag_matches(std::string_view if_none_match, std::string_view etag) {
+    std::string_view want = opaque_tag(etag);
+    while (!if_none_match.empty()) {
+        size_t comma = if_none_match.find(',');
+        std::string_view tag = trim(if_none_match.substr(0, comma));
+        if (tag == "*" || opaque_tag(tag) == want) return true;
+        if (comma == std::string_view::npos) break;
+        if_none_match.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+static bool parse_u64(std::string_view s, uint64_t* out) {
+    if (s.empty() || s.size() > 19) return false;
+    uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *out = v;
+    return true;
+}
+
+int http_parse_range(std::string_view range, uint64_t size, uint64_t* first, uint64_t* last) {
+    range = trim(range);
+    if (range.size() < 6 || range.substr(0, 6) != "bytes=") return 0;
+    range.remove_prefix(6);
+    if (range.find(',') != std::string_view::npos) return 0;
+
+    size_t dash = range.find('-');
+    if (dash == std::string_view::npos) return 0;
+    std::string_view a = trim(range.substr(0, dash));
+    std::string_view b = trim(range.substr(dash + 1));
+
+    uint64_t lo = 0, hi = 0;
+    if (a.empty()) {
+        // bytes=-N: the last N bytes
+        if (!parse_u64(b, &hi)) return 0;
+        if (hi == 0 || size == 0) return -1;
+        *first = hi >= size ? 0 : size - hi;
+        *last = size - 1;
+        return 1;
+    }
+    if (!parse_u64(a, &lo)) return 0;
+    if (b.empty()) {
+        hi = UINT64_MAX;
+    } else if (!parse_u64(b, &hi) || hi < lo) {
+        return 0;
+    }
+    if (lo >= size) return -1;
+    *first = lo;
+    *last = hi >= size ? size - 1 : hi;
+    return 1;
+}
+
+// ============================================================================
+// http.static
+// ============================================================================
+
+// Read a field of req/res, letting a lazily built object provide it.
+static Value object_field(const ObjectPtr& obj, const std::string& key) {
+    auto it = obj->properties.find(key);
+    if (it == obj->properties.end() && obj->host && obj->host->resolve(*obj, key)) {
+        it = obj->properties.find(key);
+    }
+    return it == obj->properties.end() ? Value{} : it->second.value;
+}
+
+static void call_member(const ObjectPtr& obj, const std::string& key, const std::vector<Value>& args,
+    Evaluator* evaluator, EnvPtr env, const Token& token) {
+    Value fn = object_field(obj, key);
+    if (!std::holds_alternative<FunctionPtr>(fn)) {
+        throw SwaziError("TypeError", "http.static: res." + key + " is not a function", token.loc);
+    }
+    evaluator->invoke_function(std::get<FunctionPtr>(fn), args, env, token);
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Percent-decode a URL path.  Fails on a bad escape or an encoded NUL.
+static bool decode_path(const std::string& in, std::string* out) {
+    out->clear();
+    out->reserve(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i] != '%') {
+            out->push_back(in[i]);
+            continue;
+        }
+        if (i + 2 >= in.size()) return false;
+        int hi = hex_value(in[i + 1]), lo = hex_value(in[i + 2]);
+        if (hi < 0 || lo < 0 || (hi == 0 && lo == 0)) return false;
+        out->push_back(static_cast<char>(hi * 16 + lo));
+        i += 2;
+    }
+    return true;
+}
+
+struct StaticOptions {
+    std::string root;
+    std::string index = "index.html";  // empty: no directory index
+    std::string dotfiles = "ignore";   // "ignore" (not found), "deny" (403), "allow"
+    double max_age = -1;               // seconds; < 0 leaves Cache-Control alone
+    bool fallthrough = true;           // call next() on a miss when given
+};
+
+static void respond_plain(const ObjectPtr& res, int status, const std::string& body, const std::string& allow,
+    Evaluator* evaluator, EnvPtr env, const Token& token) {
+    auto headers = std::make_shared<ObjectValue>();
+    headers->properties["Content-Type"] = {Value{std::string("text/plain")}, false, false, false, Token{}};
+    if (!allow.empty()) headers->properties["Allow"] = {Value{allow}, false, false, false, Token{}};
+    call_member(res, "writeHead", {Value{static_cast<double>(status)}, Value{headers}}, evaluator, env, token);
+    call_member(res, "end", {Value{body}}, evaluator, env, token);
+}
+
+static Value serve_static(const StaticOptions& o, const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator) {
+    if (args.size() < 2 || !std::holds_alternative<ObjectPtr>(args[0]) || !std::holds_alternative<ObjectPtr>(args[1])) {
+        throw SwaziError("TypeError", "http.static handler expects (req, res, next?)", token.loc);
+    }
+    ObjectPtr req = std::get<ObjectPtr>(args[0]);
+    ObjectPtr res = std::get<ObjectPtr>(args[1]);
+    FunctionPtr next = args.size() >= 3 && std::holds_alternative<FunctionPtr>(args[2]) ? std::get<FunctionPtr>(args[2]) : nullptr;
+
+    auto miss = [&](int status, const std::string& body) -> Value {
+        if (next && o.fallthrough) {
+            evaluator->invoke_function(next, {}, env, token);
+        } else {
+            respond_plain(res, status, body, status == 405 ? "GET, HEAD" : "", evaluator, env, token);
+        }
+        return std::monostate{};
+    };
+
+    Value method = object_field(req, "method");
+    if (!std::holds_alternative<std::string>(method) ||
+        (std::get<std::string>(method) != "GET" && std::get<std::string>(method) != "HEAD")) {
+        return miss(405, "Method Not Allowed\n");
+    }
+
+    Value raw = object_field(req, "path");
+    std::string path;
+    if (!std::holds_alternative<std::string>(raw) || !decode_path(std::get<std::string>(raw), &path) ||
+        path.empty() || path[0] != '/') {
+        return miss(400, "Bad Request\n");
+    }
+
+    // Refuse to leave the root; apply the dotfile policy to every segment.
+    size_t pos = 1;
+    while (pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string::npos) end = path.size();
+        std::string_view seg(path.data() + pos, end - pos);
+        if (seg == ".." || seg.find('\\') != std::string_view::npos) {
+            return miss(403, "Forbidden\n");
+        }
+        if (!seg.empty() && seg[0] == '.' && o.dotfiles != "allow") {
+            if (o.dotfiles == "deny") return miss(403, "Forbidden\n");
+            return miss(404, "Not Found\n");
+        }
+        pos = end + 1;
+    }
+
+    std::string full = o.root + path;
+    int err = 0;
+    HttpFilePtr file = http_file_cache_open(full, &err);
+    if (!file && err == UV_EISDIR && !o.index.empty()) {
+        if (full.back() != '/') full += '/';
+        full += o.index;
+        file = http_file_cache_open(full, &err);
+    }
+    if (!file) return miss(404, "Not Found\n");
+
+    auto opts = std::make_shared<ObjectValue>();
+    if (o.max_age >= 0) {
+        opts->properties["maxAge"] = {Value{o.max_age}, false, false, false, Token{}};
+    }
+    call_member(res, "sendFile", {Value{full}, Value{opts}}, evaluator, env, token);
+    return std::monostate{};
+}
+
+// http.static(root, { index, dotfiles, maxAge, fallthrough }) -> handler(req, res, next?)
+Value native_httpStatic(const std::vector<Value>& args, EnvPtr env, const Token& token, Evaluator* evaluator) {
+    if (args.empty() || !std::holds_alternative<std::string>(args[0]) || std::get<std::string>(args[0]).empty()) {
+        throw SwaziError("TypeError", "http.static requires a root directory", token.loc);
+    }
+
+    auto o = std::make_shared<StaticOptions>();
+    o->root = std::get<std::string>(args[0]);
+    while (o->root.size() > 1 && o->root.back() == '/') o->root.pop_back();
+
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        ObjectPtr opts = std::get<ObjectPtr>(args[1]);
+        auto get = [&](const char* key) -> const Value* {
+            auto it = opts->properties.find(key);
+            return it == opts->properties.end() ? nullptr : &it->second.value;
+        };
+        if (const Value* v = get("index")) {
+            if (std::holds_alternative<std::string>(*v)) {
+                o->index = std::get<std::string>(*v);
+            } else if (std::holds_alternative<bool>(*v) && !std::get<bool>(*v)) {
+                o->index.clear();
+            }
+        }
+        if (const Value* v = get("dotfiles")) {
+            if (!std::holds_alternative<std::string>(*v)) {
+                throw SwaziError("TypeError", "http.static: dotfiles must be \"ignore\", \"deny\" or \"allow\"", token.loc);
+            }
+            o->dotfiles = std::get<std::string>(*v);
+            if (o->dotfiles != "ignore" && o->dotfiles != "deny" && o->dotfiles != "allow") {
+                throw SwaziError("ValueError", "http.static: dotfiles must be \"ignore\", \"deny\" or \"allow\"", token.loc);
+            }
+        }
+        if (const Value* v = get("maxAge")) {
+            if (std::holds_alternative<double>(*v)) o->max_age = std::get<double>(*v);
+        }
+        if (const Value* v = get("fallthrough")) {
+            if (std::holds_alternative<bool>(*v)) o->fallthrough = std::get<bool>(*v);
+        }
+    }
+
+    auto fn = [o, evaluator](const std::vector<Value>& args, EnvPtr callEnv, const Token& token) -> Value {
+        return serve_static(*o, args, callEnv, token, evaluator);
+    };
+    Token tok;
+    tok.loc = TokenLocation("<http>", 0, 0, 0);
+    return Value{std::make_shared<FunctionValue>("http.static", fn, env, tok)};
+}
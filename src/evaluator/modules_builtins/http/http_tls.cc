@@ -0,0 +1,289 @@
+// http_tls.cc - memory-BIO TLS sessions for the http server (HttpTls.hpp)
+#include "HttpTls.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef HAVE_OPENSSL
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+#ifdef HAVE_OPENSSL
+
+class HttpTlsContext {
+   public:
+    SSL_CTX* ctx = nullptr;
+    std::atomic<uint64_t> handshakes{0};
+    std::atomic<uint64_t> resumed{0};
+    std::atomic<uint64_t> failed{0};
+
+    ~HttpTlsContext() {
+        if (ctx) SSL_CTX_free(ctx);
+    }
+};
+
+// The reason for the last OpenSSL failure on this thread, or `fallback`.
+static std::string openssl_error(const char* fallback) {
+    unsigned long e = ERR_get_error();
+    ERR_clear_error();
+    if (e == 0) return fallback;
+    char buf[256];
+    ERR_error_string_n(e, buf, sizeof(buf));
+    return buf;
+}
+
+// `text` itself when it is PEM, else the contents of the file it names.
+static std::string pem_source(const std::string& text, const char* what) {
+    if (text.find("-----BEGIN") != std::string::npos) return text;
+    std::ifstream in(text, std::ios::binary);
+    if (!in) throw std::runtime_error(std::string("cannot read TLS ") + what + " file '" + text + "'");
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void load_cert_chain(SSL_CTX* ctx, const std::string& pem) {
+    BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+    X509* leaf = PEM_read_bio_X509_AUX(bio, nullptr, nullptr, nullptr);
+    if (!leaf || SSL_CTX_use_certificate(ctx, leaf) != 1) {
+        if (leaf) X509_free(leaf);
+        BIO_free(bio);
+        throw std::runtime_error("invalid TLS certificate: " + openssl_error("no certificate found"));
+    }
+    X509_free(leaf);
+    SSL_CTX_clear_chain_certs(ctx);
+    while (X509* ca = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+        SSL_CTX_add0_chain_cert(ctx, ca);  // takes ownership
+    }
+    ERR_clear_error();  // the loop ends on a "no start line" error
+    BIO_free(bio);
+}
+
+static void load_key(SSL_CTX* ctx, const std::string& pem, const std::string& passphrase) {
+    BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+    void* pass = passphrase.empty() ? nullptr : const_cast<char*>(passphrase.c_str());
+    EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, pass);
+    BIO_free(bio);
+    if (!pkey || SSL_CTX_use_PrivateKey(ctx, pkey) != 1) {
+        if (pkey) EVP_PKEY_free(pkey);
+        throw std::runtime_error("invalid TLS key: " + openssl_error("no private key found"));
+    }
+    EVP_PKEY_free(pkey);
+    if (SSL_CTX_check_private_key(ctx) != 1) {
+        throw std::runtime_error("TLS key does not match the certificate: " + openssl_error("key mismatch"));
+    }
+}
+
+// http/1.1 is the only protocol the server speaks.  A client that offers only
+// others (h2) gets no ALPN answer and may carry on or give up.
+static int select_alpn(SSL*, const unsigned char** out, unsigned char* outlen,
+    const unsigned char* in, unsigned int inlen, void*) {
+    static const unsigned char server_protos[] = "\x08http/1.1";
+    unsigned char* selected = nullptr;
+    if (SSL_select_next_proto(&selected, outlen, server_protos, sizeof(server_protos) - 1, in, inlen) != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+HttpTlsContextPtr http_tls_context_create(const HttpTlsOptions& opts) {
+    if (opts.cert.empty() || opts.key.empty()) throw std::runtime_error("TLS needs both cert and key");
+
+    auto c = std::make_shared<HttpTlsContext>();
+    c->ctx = SSL_CTX_new(TLS_server_method());
+    if (!c->ctx) throw std::runtime_error("cannot create TLS context: " + openssl_error("SSL_CTX_new failed"));
+    SSL_CTX* ctx = c->ctx;
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE |
+            (opts.tickets ? 0 : SSL_OP_NO_TICKET));
+    // Idle keep-alive connections give their record buffers back.
+    SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+
+    static const unsigned char sid_ctx[] = "swazi-http";
+    SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, 20480);
+    SSL_CTX_set_timeout(ctx, opts.session_timeout_s);
+
+    SSL_CTX_set_alpn_select_cb(ctx, select_alpn, nullptr);
+
+    load_cert_chain(ctx, pem_source(opts.cert, "cert"));
+    load_key(ctx, pem_source(opts.key, "key"), opts.passphrase);
+    return c;
+}
+
+HttpTlsStats http_tls_stats(const HttpTlsContextPtr& ctx) {
+    HttpTlsStats s;
+    if (!ctx) return s;
+    s.handshakes = ctx->handshakes.load();
+    s.resumed = ctx->resumed.load();
+    s.failed = ctx->failed.load();
+    return s;
+}
+
+struct HttpTlsSession::Impl {
+    HttpTlsContextPtr ctx;
+    SSL* ssl = nullptr;
+    BIO* rbio = nullptr;  // ciphertext in
+    BIO* wbio = nullptr;  // ciphertext out
+    bool established = false;
+    bool peer_closed = false;
+    bool failed = false;
+    std::string error;
+
+    void drain(std::string& out) {
+        size_t n = BIO_ctrl_pending(wbio);
+        if (n == 0) return;
+        size_t old = out.size();
+        out.resize(old + n);
+        int r = BIO_read(wbio, &out[old], static_cast<int>(n));
+        out.resize(old + (r > 0 ? static_cast<size_t>(r) : 0));
+    }
+
+    bool fail(const char* why) {
+        if (!established) ctx->failed.fetch_add(1);
+        failed = true;
+        error = openssl_error(why);
+        return false;
+    }
+};
+
+HttpTlsSession::HttpTlsSession(const HttpTlsContextPtr& ctx) : impl_(std::make_unique<Impl>()) {
+    impl_->ctx = ctx;
+    impl_->ssl = SSL_new(ctx->ctx);
+    impl_->rbio = BIO_new(BIO_s_mem());
+    impl_->wbio = BIO_new(BIO_s_mem());
+    // An empty read BIO means "wait for more", not end of file.
+    BIO_set_mem_eof_return(impl_->rbio, -1);
+    SSL_set_bio(impl_->ssl, impl_->rbio, impl_->wbio);
+    SSL_set_accept_state(impl_->ssl);
+}
+
+HttpTlsSession::~HttpTlsSession() {
+    if (impl_->ssl) SSL_free(impl_->ssl);  // frees both BIOs
+}
+
+bool HttpTlsSession::read(const char* data, size_t len, std::string& plain, std::string& out) {
+    Impl& s = *impl_;
+    if (s.failed) return false;
+    if (len > 0) BIO_write(s.rbio, data, static_cast<int>(len));
+
+    ERR_clear_error();
+    if (!s.established) {
+        int r = SSL_do_handshake(s.ssl);
+        s.drain(out);
+        if (r != 1) {
+            int e = SSL_get_error(s.ssl, r);
+            if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) return true;
+            return s.fail("TLS handshake failed");
+        }
+        s.established = true;
+        s.ctx->handshakes.fetch_add(1);
+        if (SSL_session_reused(s.ssl)) s.ctx->resumed.fetch_add(1);
+    }
+
+    // Records may already be waiting behind the handshake.
+    for (;;) {
+        size_t old = plain.size();
+        plain.resize(old + 16 * 1024);
+        int r = SSL_read(s.ssl, &plain[old], 16 * 1024);
+        plain.resize(old + (r > 0 ? static_cast<size_t>(r) : 0));
+        if (r > 0) continue;
+
+        int e = SSL_get_error(s.ssl, r);
+        if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) break;
+        if (e == SSL_ERROR_ZERO_RETURN) {
+            s.peer_closed = true;
+            break;
+        }
+        s.drain(out);
+        return s.fail("TLS read failed");
+    }
+    // Post-handshake messages (TLS 1.3 session tickets, key updates).
+    s.drain(out);
+    return true;
+}
+
+bool HttpTlsSession::write(const char* data, size_t len, std::string& out) {
+    Impl& s = *impl_;
+    if (s.failed || !s.established) return false;
+    ERR_clear_error();
+    while (len > 0) {
+        // The write BIO grows as needed, so this only fails on a broken session.
+        int r = SSL_write(s.ssl, data, static_cast<int>(std::min<size_t>(len, 1 << 30)));
+        if (r <= 0) {
+            s.drain(out);
+            return s.fail("TLS write failed");
+        }
+        data += r;
+        len -= static_cast<size_t>(r);
+    }
+    s.drain(out);
+    return true;
+}
+
+void HttpTlsSession::shutdown(std::string& out) {
+    Impl& s = *impl_;
+    if (s.failed || !s.established) return;
+    ERR_clear_error();
+    SSL_shutdown(s.ssl);
+    s.drain(out);
+}
+
+bool HttpTlsSession::established() const { return impl_->established; }
+bool HttpTlsSession::peer_closed() const { return impl_->peer_closed; }
+bool HttpTlsSession::resumed() const { return impl_->established && SSL_session_reused(impl_->ssl); }
+
+std::string HttpTlsSession::alpn() const {
+    const unsigned char* p = nullptr;
+    unsigned int n = 0;
+    SSL_get0_alpn_selected(impl_->ssl, &p, &n);
+    return p ? std::string(reinterpret_cast<const char*>(p), n) : std::string();
+}
+
+std::string HttpTlsSession::protocol() const { return SSL_get_version(impl_->ssl); }
+
+std::string HttpTlsSession::cipher() const {
+    const char* name = SSL_get_cipher_name(impl_->ssl);
+    return name ? name : "";
+}
+
+const std::string& HttpTlsSession::error() const { return impl_->error; }
+
+#else  // !HAVE_OPENSSL
+
+class HttpTlsContext {};
+
+HttpTlsContextPtr http_tls_context_create(const HttpTlsOptions&) {
+    throw std::runtime_error("TLS is not available: built without OpenSSL");
+}
+
+HttpTlsStats http_tls_stats(const HttpTlsContextPtr&) { return {}; }
+
+struct HttpTlsSession::Impl {
+    std::string error = "TLS is not available";
+};
+
+HttpTlsSession::HttpTlsSession(const HttpTlsContextPtr&) : impl_(std::make_unique<Impl>()) {}
+HttpTlsSession::~HttpTlsSession() = default;
+bool HttpTlsSession::read(const char*, size_t, std::string&, std::string&) { return false; }
+bool HttpTlsSession::write(const char*, size_t, std::string&) { return false; }
+void HttpTlsSession::shutdown(std::string&) {}
+bool HttpTlsSession::established() const { return false; }
+bool HttpTlsSession::peer_closed() const { return false; }
+bool HttpTlsSession::resumed() const { return false; }
+std::string HttpTlsSession::alpn() const { return ""; }
+std::string HttpTlsSession::protocol() const { return ""; }
+std::string HttpTlsSession::cipher() const { return ""; }
+const std::string& HttpTlsSession::error() const { return impl_->error; }
+
+#endif
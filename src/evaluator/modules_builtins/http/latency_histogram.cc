@@ -0,0 +1,73 @@
+// latency_histogram.cc - log-linear latency buckets (LatencyHistogram.hpp)
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr unsigned SUB_BITS = 6;
+static constexpr uint64_t SUB_COUNT = 1u << SUB_BITS;  // 64 sub-buckets per power of two
+static constexpr size_t BUCKET_COUNT = SUB_COUNT + (64 - SUB_BITS) * SUB_COUNT;
+
+LatencyHistogram::LatencyHistogram() : counts_(BUCKET_COUNT, 0) {}
+
+size_t LatencyHistogram::index_of(uint64_t v) {
+    if (v < SUB_COUNT) return static_cast<size_t>(v);
+    unsigned e = 63 - static_cast<unsigned>(__builtin_clzll(v));  // floor(log2 v), >= SUB_BITS
+    uint64_t sub = (v >> (e - SUB_BITS)) - SUB_COUNT;
+    return static_cast<size_t>(SUB_COUNT + (e - SUB_BITS) * SUB_COUNT + sub);
+}
+
+uint64_t LatencyHistogram::upper_edge(size_t index) {
+    if (index < SUB_COUNT) return index;
+    unsigned shift = static_cast<unsigned>((index - SUB_COUNT) / SUB_COUNT);
+    uint64_t sub = (index - SUB_COUNT) % SUB_COUNT;
+    uint64_t lower = (SUB_COUNT + sub) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    counts_[index_of(micros)]++;
+    count_++;
+    sum_ += micros;
+    min_ = std::min(min_, micros);
+    max_ = std::max(max_, micros);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); i++) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    // Rank of the sample we want, 1-based: the ceil(q * n)-th smallest.
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+    rank = std::clamp<uint64_t>(rank, 1, count_);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+        seen += counts_[i];
+        if (seen >= rank) return std::min(upper_edge(i), max_);
+    }
+    return max_;
+}
+
+std::vector<LatencyHistogram::Bucket> LatencyHistogram::buckets() const {
+    std::vector<Bucket> out;
+    for (size_t i = 0; i < counts_.size(); i++) {
+        if (counts_[i]) out.push_back({std::min(upper_edge(i), max_), counts_[i]});
+    }
+    return out;
+}
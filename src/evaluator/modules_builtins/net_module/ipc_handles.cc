@@ -0,0 +1,90 @@
+// ipc_handles.cc - passing tcp sockets and servers over fork IPC pipes
+//
+// A message sent with a handle travels as an envelope frame,
+// { __swazi_handle__: kind, message }, written with uv_write2 so the
+// descriptor rides along with the frame's bytes.  The receiving side accepts
+// descriptors as reads bring them in and pairs them with envelopes in order.
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "./net.hpp"
+
+static const char* IPC_HANDLE_KEY = "__swazi_handle__";
+
+struct IpcHandleWrite {
+    uv_write_t req;
+    std::vector<uint8_t> frame;
+    Value handle;
+};
+
+void ipc_send_handle(uv_pipe_t* pipe, StreamCork* cork, const Value& message, const Value& handle, const Token& token) {
+    std::string kind;
+    uv_tcp_t* tcp = tcp_ipc_handle(handle, kind);
+    if (!tcp) throw SwaziError("TypeError", "send: handle must be an open tcp socket or server", token.loc);
+
+    auto envelope = std::make_shared<ObjectValue>();
+    envelope->properties[IPC_HANDLE_KEY] = PropertyDescriptor{Value{kind}, false, false, true, token};
+    envelope->properties["message"] = PropertyDescriptor{message, false, false, true, token};
+
+    auto* w = new IpcHandleWrite;
+    w->req.data = w;
+    w->handle = handle;
+    try {
+        structured_clone_frame_append(w->frame, Value{envelope}, token);
+    } catch (...) {
+        delete w;
+        throw;
+    }
+
+    // Messages corked before this one have to reach the pipe first.
+    if (cork) cork->flush();
+
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(w->frame.data()), static_cast<unsigned int>(w->frame.size()));
+    int r = uv_write2(&w->req, (uv_stream_t*)pipe, &buf, 1, (uv_stream_t*)tcp, [](uv_write_t* req, int status) {
+        auto* w = static_cast<IpcHandleWrite*>(req->data);
+        if (status == 0) tcp_ipc_handle_sent(w->handle);
+        delete w;
+    });
+    if (r != 0) {
+        delete w;
+        throw SwaziError("IOError", std::string("send: cannot pass handle: ") + uv_strerror(r), token.loc);
+    }
+}
+
+void ipc_accept_handles(uv_pipe_t* pipe, std::deque<uv_tcp_t*>& received) {
+    while (uv_pipe_pending_count(pipe) > 0) {
+        uv_handle_type type = uv_pipe_pending_type(pipe);
+        uv_tcp_t* tcp = new uv_tcp_t;
+        uv_tcp_init(pipe->loop, tcp);
+        // Anything but tcp is not ours to receive; it is accepted to take it
+        // off the queue, then closed.
+        if (uv_accept((uv_stream_t*)pipe, (uv_stream_t*)tcp) != 0 || type != UV_TCP) {
+            uv_close((uv_handle_t*)tcp, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+            continue;
+        }
+        received.push_back(tcp);
+    }
+}
+
+std::vector<Value> ipc_message_args(const Value& msg, std::deque<uv_tcp_t*>& received) {
+    if (!std::holds_alternative<ObjectPtr>(msg)) return {msg};
+    const ObjectPtr& envelope = std::get<ObjectPtr>(msg);
+    auto kind_it = envelope->properties.find(IPC_HANDLE_KEY);
+    if (kind_it == envelope->properties.end() || !std::holds_alternative<std::string>(kind_it->second.value)) return {msg};
+
+    auto msg_it = envelope->properties.find("message");
+    Value message = msg_it != envelope->properties.end() ? msg_it->second.value : Value{std::monostate{}};
+    if (received.empty()) return {message};
+
+    uv_tcp_t* tcp = received.front();
+    received.pop_front();
+    return {message, tcp_adopt_handle(tcp, std::get<std::string>(kind_it->second.value))};
+}
+
+void ipc_close_handles(std::deque<uv_tcp_t*>& received) {
+    for (uv_tcp_t* tcp : received) {
+        uv_close((uv_handle_t*)tcp, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+    }
+    received.clear();
+}
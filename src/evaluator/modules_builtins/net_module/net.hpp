@@ -5,12 +5,15 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "AsyncBridge.hpp"
+#include "DnsResolver.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -20,6 +23,33 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator);
 std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator);
 std::shared_ptr<ObjectValue> make_unix_socket_exports(EnvPtr env, Evaluator* evaluator);
 
+// The libuv stream behind a tcp socket object's `_socketId`, for native
+// writers such as streams.pipeline.  Null once the socket is closed or while
+// it is still connecting.
+uv_stream_t* tcp_socket_stream(long long socket_id);
+
+// Handle passing over fork IPC (tcp.cc).  tcp_ipc_handle returns the libuv
+// handle behind a tcp socket or server object and sets `kind` to "socket" or
+// "server"; null for anything else.  tcp_ipc_handle_sent closes the sender's
+// copy of a socket once it has gone; servers stay open on both sides.
+// tcp_adopt_handle wraps a received handle in the object connect() or
+// createServer() would have returned.
+uv_tcp_t* tcp_ipc_handle(const Value& v, std::string& kind);
+void tcp_ipc_handle_sent(const Value& v);
+Value tcp_adopt_handle(uv_tcp_t* handle, const std::string& kind);
+
+// The IPC pipe side of handle passing (ipc_handles.cc), shared by
+// child.send and process.send.  Both ends' pipes must be opened with ipc=1.
+//
+// ipc_send_handle writes `message` and `handle` as one frame after whatever
+// `cork` (may be null) holds.  ipc_accept_handles takes the descriptors the
+// last read brought in; ipc_message_args turns a decoded frame into message
+// listener arguments, (message) or (message, socketOrServer).
+void ipc_send_handle(uv_pipe_t* pipe, StreamCork* cork, const Value& message, const Value& handle, const Token& token);
+void ipc_accept_handles(uv_pipe_t* pipe, std::deque<uv_tcp_t*>& received);
+std::vector<Value> ipc_message_args(const Value& msg, std::deque<uv_tcp_t*>& received);
+void ipc_close_handles(std::deque<uv_tcp_t*>& received);
+
 // Helper functions for network operations
 namespace NetHelpers {
 // Convert Value to string (similar to builtins)
@@ -115,7 +115,9 @@ std::shared_ptr<ObjectValue> make_net_exports(EnvPtr env, Evaluator* evaluator)
             false, false, true, tok};
     }
 
-    // net.resolve(host) -> Promise<array of addresses>
+    // net.resolve(host, family?) -> Promise<array of addresses>
+    // family 4 or 6 asks for one family only.  Answers come from the shared
+    // resolver (see net.dns), so repeated names cost no lookup.
     {
         auto fn_resolve = make_native_fn("net.resolve", [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
             if (args.empty()) {
@@ -123,12 +125,19 @@ std::shared_ptr<ObjectValue> make_net_exports(EnvPtr env, Evaluator* evaluator)
             }
             
             std::string host = NetHelpers::value_to_string(args[0]);
+            int family = AF_UNSPEC;
+            if (args.size() >= 2 && !std::holds_alternative<std::monostate>(args[1])) {
+                double f = NetHelpers::value_to_number(args[1]);
+                if (f == 4)
+                    family = AF_INET;
+                else if (f == 6)
+                    family = AF_INET6;
+                else if (f != 0)
+                    throw SwaziError("TypeError", "resolve family must be 4 or 6", token.loc);
+            }
             auto promise = std::make_shared<PromiseValue>();
             promise->state = PromiseValue::State::PENDING;
             
-            g_active_net_work.fetch_add(1); 
-            
-            // Use libuv's getaddrinfo
             uv_loop_t* loop = scheduler_get_loop();
             if (!loop) {
                 promise->state = PromiseValue::State::REJECTED;
@@ -136,90 +145,107 @@ std::shared_ptr<ObjectValue> make_net_exports(EnvPtr env, Evaluator* evaluator)
                 return Value{promise};
             }
             
-            // Create getaddrinfo request
-            struct GetAddrInfoData {
-                std::shared_ptr<PromiseValue> promise;
-                std::string host;
-            };
-            
-            auto* data = new GetAddrInfoData{promise, host};
+            g_active_net_work.fetch_add(1); 
             
-            scheduler_run_on_loop([loop, data]() {
-                uv_getaddrinfo_t* req = new uv_getaddrinfo_t;
-                req->data = data;
-                
-                struct addrinfo hints;
-                memset(&hints, 0, sizeof(hints));
-                hints.ai_family = AF_UNSPEC;  // Allow IPv4 or IPv6
-                hints.ai_socktype = SOCK_STREAM;
-                
-                int r = uv_getaddrinfo(loop, req, 
-                    [](uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
-                        GetAddrInfoData* data = static_cast<GetAddrInfoData*>(req->data);
+            scheduler_run_on_loop([loop, host, family, promise]() {
+                dns_resolve(loop, host, family, [promise](int status, const std::vector<sockaddr_storage>& addrs) {
+                    g_active_net_work.fetch_sub(1);
+                    
+                    if (status == 0) {
+                        auto arr = std::make_shared<ArrayValue>();
+                        for (const auto& addr : addrs) {
+                            char ip[INET6_ADDRSTRLEN];
+                            if (addr.ss_family == AF_INET)
+                                uv_ip4_name(reinterpret_cast<const sockaddr_in*>(&addr), ip, sizeof(ip));
+                            else
+                                uv_ip6_name(reinterpret_cast<const sockaddr_in6*>(&addr), ip, sizeof(ip));
+                            arr->elements.push_back(Value{std::string(ip)});
+                        }
                         
-                        g_active_net_work.fetch_sub(1);
+                        promise->state = PromiseValue::State::FULFILLED;
+                        promise->result = Value{arr};
                         
-                        if (status == 0 && res) {
-                            auto arr = std::make_shared<ArrayValue>();
-                            
-                            for (struct addrinfo* p = res; p != nullptr; p = p->ai_next) {
-                                char ip[INET6_ADDRSTRLEN];
-                                
-                                if (p->ai_family == AF_INET) {
-                                    struct sockaddr_in* addr = (struct sockaddr_in*)p->ai_addr;
-                                    inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof(ip));
-                                    arr->elements.push_back(Value{std::string(ip)});
-                                } else if (p->ai_family == AF_INET6) {
-                                    struct sockaddr_in6* addr = (struct sockaddr_in6*)p->ai_addr;
-                                    inet_ntop(AF_INET6, &addr->sin6_addr, ip, sizeof(ip));
-                                    arr->elements.push_back(Value{std::string(ip)});
-                                }
-                            }
-                            
-                            uv_freeaddrinfo(res);
-                            
-                            data->promise->state = PromiseValue::State::FULFILLED;
-                            data->promise->result = Value{arr};
-                            
-                            for (auto& cb : data->promise->then_callbacks) {
-                                try { cb(data->promise->result); } catch(...) {}
-                            }
-                        } else {
-                            std::string err_msg = "DNS resolution failed";
-                            if (status != 0) {
-                                err_msg += ": " + std::string(uv_strerror(status));
-                            }
-                            
-                            data->promise->state = PromiseValue::State::REJECTED;
-                            data->promise->result = Value{err_msg};
-                            
-                            for (auto& cb : data->promise->catch_callbacks) {
-                                try { cb(data->promise->result); } catch(...) {}
-                            }
+                        for (auto& cb : promise->then_callbacks) {
+                            try { cb(promise->result); } catch(...) {}
                         }
+                    } else {
+                        promise->state = PromiseValue::State::REJECTED;
+                        promise->result = Value{std::string("DNS resolution failed: ") + uv_strerror(status)};
                         
-                        delete data;
-                        delete req;
-                    },
-                    data->host.c_str(), nullptr, &hints);
-                
-                if (r != 0) {
-                    data->promise->state = PromiseValue::State::REJECTED;
-                    data->promise->result = Value{std::string("Failed to start DNS resolution: ") + uv_strerror(r)};
-                    
-                    for (auto& cb : data->promise->catch_callbacks) {
-                        try { cb(data->promise->result); } catch(...) {}
+                        for (auto& cb : promise->catch_callbacks) {
+                            try { cb(promise->result); } catch(...) {}
+                        }
                     }
-                    
-                    delete data;
-                    delete req;
-                }
+                });
             });
             
             return Value{promise}; }, env);
         obj->properties["resolve"] = PropertyDescriptor{fn_resolve, false, false, true, tok};
     }
 
+    // net.dns -> the resolver behind net.resolve, tcp.connect, udp bind and
+    // the http clients.
+    {
+        auto dns_obj = std::make_shared<ObjectValue>();
+
+        // net.dns.configure({ttl, negativeTtl, maxEntries, hostsFile, hostsOnly})
+        // ttl / negativeTtl in ms, 0 disables that half of the cache.
+        // hostsFile is read now and answers first; hostsOnly answers from it
+        // alone (default /etc/hosts) and never queries the network.
+        auto fn_configure = make_native_fn("net.dns.configure", [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0]))
+                throw SwaziError("TypeError", "net.dns.configure(options) requires an options object", token.loc);
+            ObjectPtr opts = std::get<ObjectPtr>(args[0]);
+            DnsOptions o = dns_options();
+
+            auto count = [&](const char* name, uint64_t& out) {
+                auto it = opts->properties.find(name);
+                if (it == opts->properties.end()) return;
+                if (!std::holds_alternative<double>(it->second.value) || std::get<double>(it->second.value) < 0)
+                    throw SwaziError("TypeError", std::string("net.dns option '") + name + "' must be a number >= 0", token.loc);
+                out = static_cast<uint64_t>(std::get<double>(it->second.value));
+            };
+            uint64_t max_entries = o.max_entries;
+            count("ttl", o.ttl_ms);
+            count("negativeTtl", o.negative_ttl_ms);
+            count("maxEntries", max_entries);
+            o.max_entries = static_cast<size_t>(max_entries);
+
+            auto hosts_only = opts->properties.find("hostsOnly");
+            if (hosts_only != opts->properties.end()) {
+                if (!std::holds_alternative<bool>(hosts_only->second.value))
+                    throw SwaziError("TypeError", "net.dns option 'hostsOnly' must be a boolean", token.loc);
+                o.hosts_only = std::get<bool>(hosts_only->second.value);
+            }
+            auto hosts_file = opts->properties.find("hostsFile");
+            if (hosts_file != opts->properties.end())
+                o.hosts_file = NetHelpers::value_to_string(hosts_file->second.value);
+
+            if (!dns_configure(o))
+                throw SwaziError("IOError", "net.dns: cannot read hosts file '" + (o.hosts_file.empty() ? std::string("/etc/hosts") : o.hosts_file) + "'", token.loc);
+            return std::monostate{}; }, env);
+        dns_obj->properties["configure"] = PropertyDescriptor{fn_configure, false, false, true, tok};
+
+        // net.dns.stats() -> {lookups, hits, coalesced, entries}
+        auto fn_stats = make_native_fn("net.dns.stats", [](const std::vector<Value>&, EnvPtr, const Token& token) -> Value {
+            DnsStats st = dns_stats();
+            auto out = std::make_shared<ObjectValue>();
+            out->properties["lookups"] = PropertyDescriptor{Value{(double)st.lookups}, false, false, true, token};
+            out->properties["hits"] = PropertyDescriptor{Value{(double)st.hits}, false, false, true, token};
+            out->properties["coalesced"] = PropertyDescriptor{Value{(double)st.coalesced}, false, false, true, token};
+            out->properties["entries"] = PropertyDescriptor{Value{(double)st.entries}, false, false, true, token};
+            return Value{out}; }, env);
+        dns_obj->properties["stats"] = PropertyDescriptor{fn_stats, false, false, true, tok};
+
+        // net.dns.clear() drops every cached answer
+        auto fn_clear = make_native_fn("net.dns.clear", [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            dns_clear();
+            return std::monostate{}; }, env);
+        dns_obj->properties["clear"] = PropertyDescriptor{fn_clear, false, false, true, tok};
+
+        obj->properties["dns"] = PropertyDescriptor{Value{dns_obj}, false, false, true, tok};
+    }
+
     // net.isIPv4(str) -> bool
     {
         auto fn_isIPv4 = make_native_fn("net.isIPv4", [](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
@@ -1,5 +1,9 @@
 // tcp.cc - TCP client and server implementation using libuv
+#include <netinet/tcp.h>
+
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -54,14 +58,38 @@ static Evaluator* g_evaluator = nullptr;
 
 // ── Structs ──────────────────────────────────────────────────────────────────
 
-struct TcpServerInstance {
+// Per-socket tuning, from createServer's options (for every accepted socket)
+// or connect's.  Zero sizes leave the kernel defaults alone.
+struct TcpSocketOptions {
+    bool no_delay = false;
+    bool keep_alive = false;
+    unsigned int keep_alive_delay_ms = 0;  // 0: the kernel's idle time
+    int recv_buffer_size = 0;
+    int send_buffer_size = 0;
+    size_t write_high_water_mark = 16 * 1024;
+    bool coalesce_writes = true;
+};
+
+struct TcpServerInstance : public std::enable_shared_from_this<TcpServerInstance> {
     uv_tcp_t* server_handle = nullptr;
     FunctionPtr connection_handler;
+    FunctionPtr connections_handler;  // batched: one array of sockets per loop tick
     std::atomic<bool> closed{false};
+    bool listening = false;
     int port = 0;
     std::string host;
+
+    int backlog = 128;
+    bool simultaneous_accepts = true;
+    TcpSocketOptions socket_options;
+
+    // Sockets accepted for on("connections") since the last flush.
+    std::shared_ptr<ArrayValue> pending_batch;
 };
 
+// Writes larger than this leave at once instead of waiting for the tick's end.
+static constexpr size_t TCP_CORK_LIMIT = 64 * 1024;
+
 struct TcpSocketInstance {
     uv_tcp_t* socket_handle = nullptr;
     std::atomic<bool> closed{false};
@@ -76,10 +104,14 @@ struct TcpSocketInstance {
 
     std::vector<FunctionPtr> drain_callbacks;
     std::mutex drain_mutex;
-    static constexpr size_t WRITE_HIGH_WATERMARK = 16 * 1024;
     Evaluator* evaluator = nullptr;
 
     std::atomic<bool> paused{false};
+
+    TcpSocketOptions options;
+    // Writes made during one tick, sent together; created on first write and
+    // dropped with the handle it writes to.
+    std::shared_ptr<StreamCork> cork;
 };
 
 // ResolveConnectData at file scope so try_next_address and on_address_connect
@@ -89,8 +121,8 @@ struct ResolveConnectData {
     std::shared_ptr<ObjectValue> socket_obj;
     int port;
     uv_loop_t* loop;
-    struct addrinfo* addrlist;
-    struct addrinfo* current;
+    std::vector<sockaddr_storage> addrs;
+    size_t current = 0;
 };
 
 static std::mutex g_tcp_servers_mutex;
@@ -101,6 +133,185 @@ static std::mutex g_tcp_sockets_mutex;
 static std::unordered_map<long long, std::shared_ptr<TcpSocketInstance>> g_tcp_sockets;
 static std::atomic<long long> g_next_tcp_socket_id{1};
 
+// ── Socket options and writes ─────────────────────────────────────────────────
+
+static double option_number(const ObjectPtr& opts, const char* key, double fallback) {
+    auto it = opts->properties.find(key);
+    if (it == opts->properties.end() || std::holds_alternative<std::monostate>(it->second.value)) return fallback;
+    return NetHelpers::value_to_number(it->second.value);
+}
+
+static bool option_bool(const ObjectPtr& opts, const char* key, bool fallback) {
+    auto it = opts->properties.find(key);
+    if (it == opts->properties.end() || std::holds_alternative<std::monostate>(it->second.value)) return fallback;
+    const Value& v = it->second.value;
+    if (std::holds_alternative<bool>(v)) return std::get<bool>(v);
+    return NetHelpers::value_to_number(v) != 0;
+}
+
+static int option_buffer_size(const ObjectPtr& opts, const char* key, const Token& token) {
+    double n = option_number(opts, key, 0);
+    if (!std::isfinite(n) || n < 0 || n > 0x7fffffff)
+        throw SwaziError("RangeError", std::string(key) + " must be a byte count", token.loc);
+    return static_cast<int>(n);
+}
+
+// noDelay, keepAlive, keepAliveInitialDelay (ms), recvBufferSize,
+// sendBufferSize, writeHighWaterMark and coalesceWrites, on top of `base`.
+static TcpSocketOptions parse_socket_options(const ObjectPtr& opts, TcpSocketOptions base, const Token& token) {
+    base.no_delay = option_bool(opts, "noDelay", base.no_delay);
+    base.keep_alive = option_bool(opts, "keepAlive", base.keep_alive);
+    double delay = option_number(opts, "keepAliveInitialDelay", base.keep_alive_delay_ms);
+    if (!std::isfinite(delay) || delay < 0)
+        throw SwaziError("RangeError", "keepAliveInitialDelay must be a non-negative number of milliseconds", token.loc);
+    base.keep_alive_delay_ms = static_cast<unsigned int>(std::min(delay, 4294967295.0));
+    base.recv_buffer_size = option_buffer_size(opts, "recvBufferSize", token);
+    base.send_buffer_size = option_buffer_size(opts, "sendBufferSize", token);
+    double hwm = option_number(opts, "writeHighWaterMark", static_cast<double>(base.write_high_water_mark));
+    if (!std::isfinite(hwm) || hwm < 1)
+        throw SwaziError("RangeError", "writeHighWaterMark must be at least 1 byte", token.loc);
+    base.write_high_water_mark = static_cast<size_t>(hwm);
+    base.coalesce_writes = option_bool(opts, "coalesceWrites", base.coalesce_writes);
+    return base;
+}
+
+static void set_keep_alive(uv_tcp_t* handle, bool enable, unsigned int delay_ms) {
+    if (enable && delay_ms == 0) {
+        // Keep the kernel's idle time; uv_tcp_keepalive always sets one.
+        uv_os_fd_t fd;
+        if (uv_fileno((uv_handle_t*)handle, &fd) == 0) {
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        }
+        return;
+    }
+    uv_tcp_keepalive(handle, enable ? 1 : 0, std::max(1u, delay_ms / 1000));
+}
+
+static void apply_socket_options(uv_tcp_t* handle, const TcpSocketOptions& o) {
+    if (o.no_delay) uv_tcp_nodelay(handle, 1);
+    if (o.keep_alive) set_keep_alive(handle, true, o.keep_alive_delay_ms);
+}
+
+// A server sets these on its listening socket, before listen(): accepted
+// sockets inherit them, and the receive window is negotiated from them.
+static void apply_buffer_sizes(uv_tcp_t* handle, const TcpSocketOptions& o) {
+    if (o.recv_buffer_size > 0) {
+        int size = o.recv_buffer_size;
+        uv_recv_buffer_size((uv_handle_t*)handle, &size);
+    }
+    if (o.send_buffer_size > 0) {
+        int size = o.send_buffer_size;
+        uv_send_buffer_size((uv_handle_t*)handle, &size);
+    }
+}
+
+static void emit_drain(TcpSocketInstance* inst) {
+    std::vector<FunctionPtr> cbs;
+    {
+        std::lock_guard<std::mutex> lk(inst->drain_mutex);
+        std::swap(cbs, inst->drain_callbacks);
+    }
+    for (auto& cb : cbs)
+        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {})));
+}
+
+static StreamCork* socket_cork(const std::shared_ptr<TcpSocketInstance>& inst) {
+    if (inst->cork) return inst->cork.get();
+    inst->cork = std::make_shared<StreamCork>((uv_stream_t*)inst->socket_handle, TCP_CORK_LIMIT);
+    std::weak_ptr<TcpSocketInstance> weak = inst;
+    inst->cork->written = [weak](int status) {
+        auto inst = weak.lock();
+        if (!inst || inst->closed.load()) return;
+        if (status < 0) {
+            if (status != UV_ECANCELED && inst->on_error_handler) {
+                auto err = std::string("Write failed: ") + uv_strerror(status);
+                enqueue_callback_global(static_cast<void*>(new CallbackPayload(inst->on_error_handler, {Value{err}})));
+            }
+            return;
+        }
+        if (inst->cork && inst->cork->buffered() == 0) emit_drain(inst.get());
+    };
+    return inst->cork.get();
+}
+
+// Sends whatever is corked before the handle changes hands or closes.
+static void flush_cork(TcpSocketInstance* inst) {
+    if (inst->cork) inst->cork->flush();
+}
+
+static void drop_cork(TcpSocketInstance* inst) {
+    if (!inst->cork) return;
+    inst->cork->detach();
+    inst->cork.reset();
+}
+
+static size_t socket_buffered(const TcpSocketInstance* inst) {
+    if (inst->cork) return inst->cork->buffered();
+    return inst->socket_handle ? inst->socket_handle->write_queue_size : 0;
+}
+
+// write, writableNeedsDrain, setNoDelay and setKeepAlive, shared by accepted
+// and connected sockets.  Writes made in one tick go out as one write at the
+// tick's end (coalesceWrites: false sends each at once); write() returns
+// false once the socket holds writeHighWaterMark bytes, and "drain" fires
+// when they have all gone.
+static void add_socket_write_methods(const std::shared_ptr<ObjectValue>& socket_obj, const std::shared_ptr<TcpSocketInstance>& sock_inst, const Token& tok) {
+    auto write_impl = [sock_inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty()) return Value{false};
+        if (sock_inst->closed.load() || !sock_inst->socket_handle)
+            throw SwaziError("IOError", "Socket is closed", token.loc);
+
+        StreamCork* cork = socket_cork(sock_inst);
+        size_t before = cork->pending.size();
+        if (std::holds_alternative<BufferPtr>(args[0])) {
+            const auto& data = std::get<BufferPtr>(args[0])->data;
+            cork->pending.insert(cork->pending.end(), data.begin(), data.end());
+        } else if (std::holds_alternative<std::string>(args[0])) {
+            const std::string& data = std::get<std::string>(args[0]);
+            cork->pending.insert(cork->pending.end(), data.begin(), data.end());
+        }
+        if (cork->pending.size() == before) return Value{false};
+
+        if (sock_inst->options.coalesce_writes)
+            cork->commit();
+        else
+            cork->flush();
+        return Value{socket_buffered(sock_inst.get()) < sock_inst->options.write_high_water_mark};
+    };
+    socket_obj->properties["write"] = {Value{std::make_shared<FunctionValue>("socket.write", write_impl, nullptr, tok)}, false, false, true, tok};
+
+    auto needs_drain_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        if (sock_inst->closed.load() || !sock_inst->socket_handle) return Value{false};
+        return Value{socket_buffered(sock_inst.get()) >= sock_inst->options.write_high_water_mark};
+    };
+    socket_obj->properties["writableNeedsDrain"] = {Value{std::make_shared<FunctionValue>("socket.writableNeedsDrain", needs_drain_impl, nullptr, tok)}, false, false, true, tok};
+
+    // setNoDelay(enable = true)
+    auto no_delay_impl = [sock_inst](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        bool enable = args.empty() || !std::holds_alternative<bool>(args[0]) || std::get<bool>(args[0]);
+        sock_inst->options.no_delay = enable;
+        if (!sock_inst->closed.load() && sock_inst->socket_handle)
+            uv_tcp_nodelay(sock_inst->socket_handle, enable ? 1 : 0);
+        return std::monostate{};
+    };
+    socket_obj->properties["setNoDelay"] = {Value{std::make_shared<FunctionValue>("socket.setNoDelay", no_delay_impl, nullptr, tok)}, false, false, true, tok};
+
+    // setKeepAlive(enable = false, initialDelayMs = 0)
+    auto keep_alive_impl = [sock_inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        bool enable = !args.empty() && std::holds_alternative<bool>(args[0]) && std::get<bool>(args[0]);
+        double delay = args.size() >= 2 ? NetHelpers::value_to_number(args[1]) : 0;
+        if (!std::isfinite(delay) || delay < 0)
+            throw SwaziError("RangeError", "setKeepAlive delay must be a non-negative number of milliseconds", token.loc);
+        sock_inst->options.keep_alive = enable;
+        sock_inst->options.keep_alive_delay_ms = static_cast<unsigned int>(std::min(delay, 4294967295.0));
+        if (!sock_inst->closed.load() && sock_inst->socket_handle)
+            set_keep_alive(sock_inst->socket_handle, enable, sock_inst->options.keep_alive_delay_ms);
+        return std::monostate{};
+    };
+    socket_obj->properties["setKeepAlive"] = {Value{std::make_shared<FunctionValue>("socket.setKeepAlive", keep_alive_impl, nullptr, tok)}, false, false, true, tok};
+}
+
 // ── start_reading_if_needed ───────────────────────────────────────────────────
 
 static void start_reading_if_needed(TcpSocketInstance* inst) {
@@ -110,10 +321,7 @@ static void start_reading_if_needed(TcpSocketInstance* inst) {
         return;
 
     uv_read_start((uv_stream_t*)inst->socket_handle,
-        [](uv_handle_t*, size_t suggested, uv_buf_t* buf) {
-            buf->base = new char[suggested];
-            buf->len = (unsigned int)suggested;
-        },
+        read_pool_alloc,
         [](uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
             TcpSocketInstance* inst = static_cast<TcpSocketInstance*>(stream->data);
 
@@ -126,10 +334,11 @@ static void start_reading_if_needed(TcpSocketInstance* inst) {
                 enqueue_callback_global(static_cast<void*>(payload));
             }
 
-            if (buf->base) delete[] buf->base;
+            read_pool_release(buf);
 
             if (nread < 0) {
                 inst->reading.store(false);
+                drop_cork(inst);
                 {
                     std::lock_guard<std::mutex> lk(inst->drain_mutex);
                     inst->drain_callbacks.clear();
@@ -164,11 +373,15 @@ static void on_address_connect(uv_connect_t* conn_req, int status) {
 
     if (status == 0) {
         // success
-        uv_freeaddrinfo(rdata->addrlist);
         auto inst = rdata->sock_inst;
         auto socket_obj = rdata->socket_obj;
         delete rdata;
 
+        if (inst->socket_handle) {
+            apply_socket_options(inst->socket_handle, inst->options);
+            apply_buffer_sizes(inst->socket_handle, inst->options);
+        }
+
         // reading starts only after user registers on("data")
         if (inst->on_connect_handler) {
             CallbackPayload* payload = new CallbackPayload(
@@ -179,6 +392,7 @@ static void on_address_connect(uv_connect_t* conn_req, int status) {
     }
 
     // this address failed — close handle and try next
+    drop_cork(rdata->sock_inst.get());
     if (rdata->sock_inst->socket_handle) {
         uv_close((uv_handle_t*)rdata->sock_inst->socket_handle, [](uv_handle_t* h) {
             delete (uv_tcp_t*)h;
@@ -187,21 +401,13 @@ static void on_address_connect(uv_connect_t* conn_req, int status) {
         rdata->sock_inst->closed.store(false);
     }
 
-    rdata->current = rdata->current->ai_next;
+    rdata->current++;
     try_next_address(rdata);
 }
 
 static void try_next_address(ResolveConnectData* rdata) {
-    // skip non-IP families
-    while (rdata->current &&
-        rdata->current->ai_family != AF_INET &&
-        rdata->current->ai_family != AF_INET6) {
-        rdata->current = rdata->current->ai_next;
-    }
-
-    if (!rdata->current) {
+    if (rdata->current >= rdata->addrs.size()) {
         // exhausted every address
-        uv_freeaddrinfo(rdata->addrlist);
         auto inst = rdata->sock_inst;
         delete rdata;
         g_active_tcp_work.fetch_sub(1);
@@ -219,9 +425,8 @@ static void try_next_address(ResolveConnectData* rdata) {
     }
 
     // copy sockaddr and stamp port
-    struct sockaddr_storage sa{};
-    memcpy(&sa, rdata->current->ai_addr, rdata->current->ai_addrlen);
-    if (rdata->current->ai_family == AF_INET)
+    struct sockaddr_storage sa = rdata->addrs[rdata->current];
+    if (sa.ss_family == AF_INET)
         reinterpret_cast<struct sockaddr_in*>(&sa)->sin_port = htons(rdata->port);
     else
         reinterpret_cast<struct sockaddr_in6*>(&sa)->sin6_port = htons(rdata->port);
@@ -243,43 +448,28 @@ static void try_next_address(ResolveConnectData* rdata) {
 
     if (cr != 0) {
         // synchronous failure — close handle and advance
+        drop_cork(inst.get());
         uv_close((uv_handle_t*)inst->socket_handle, [](uv_handle_t* h) {
             delete (uv_tcp_t*)h;
         });
         inst->socket_handle = nullptr;
         inst->closed.store(false);
         delete conn_req;
-        rdata->current = rdata->current->ai_next;
+        rdata->current++;
         try_next_address(rdata);
     }
 }
 
-// ── Server accept callback ────────────────────────────────────────────────────
-
-static void on_tcp_connection(uv_stream_t* server, int status) {
-    if (status < 0) return;
-    TcpServerInstance* srv = static_cast<TcpServerInstance*>(server->data);
-    if (!srv || srv->closed.load()) return;
-
-    uv_tcp_t* client = new uv_tcp_t;
-    uv_tcp_init(server->loop, client);
-
-    uv_os_fd_t fd;
-    if (uv_fileno((uv_handle_t*)client, &fd) == 0) {
-        int on = 1;
-        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
-        signal(SIGPIPE, SIG_IGN);
-    }
-
-    if (uv_accept(server, (uv_stream_t*)client) != 0) {
-        uv_close((uv_handle_t*)client, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
-        return;
-    }
+// ── Accepted socket object ────────────────────────────────────────────────────
 
+// Wraps a connected handle (from uv_accept on a server or on an IPC pipe) in
+// a socket object.
+static std::shared_ptr<ObjectValue> make_accepted_socket(uv_tcp_t* client, const TcpSocketOptions& options = TcpSocketOptions{}) {
     auto sock_inst = std::make_shared<TcpSocketInstance>();
     sock_inst->socket_handle = client;
     sock_inst->closed = false;
     sock_inst->evaluator = g_evaluator;
+    sock_inst->options = options;
 
     long long sock_id = g_next_tcp_socket_id.fetch_add(1);
     sock_inst->socket_id = sock_id;
@@ -323,71 +513,13 @@ static void on_tcp_connection(uv_stream_t* server, int status) {
     Token tok;
     tok.loc = TokenLocation("<tcp>", 0, 0, 0);
 
-    // write
-    auto write_impl = [sock_inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty()) return Value{false};
-        if (sock_inst->closed.load() || !sock_inst->socket_handle)
-            throw SwaziError("IOError", "Socket is closed", token.loc);
-
-        std::vector<uint8_t> data = NetHelpers::get_buffer_data(args[0]);
-        if (data.empty()) return Value{false};
-
-        struct WriteCtx {
-            char* buf;
-            std::shared_ptr<TcpSocketInstance> inst;
-        };
-        char* buf = static_cast<char*>(malloc(data.size()));
-        memcpy(buf, data.data(), data.size());
-
-        uv_buf_t uvbuf = uv_buf_init(buf, (unsigned int)data.size());
-        uv_write_t* req = new uv_write_t;
-        req->data = new WriteCtx{buf, sock_inst};
-
-        int r = uv_write(req, (uv_stream_t*)sock_inst->socket_handle, &uvbuf, 1,
-            [](uv_write_t* req, int status) {
-                auto* ctx = static_cast<WriteCtx*>(req->data);
-                free(ctx->buf);
-                auto inst = ctx->inst;
-                delete ctx;
-                delete req;
-                if (status != 0) return;
-                if (inst->socket_handle && inst->socket_handle->write_queue_size == 0) {
-                    std::vector<FunctionPtr> cbs;
-                    {
-                        std::lock_guard<std::mutex> lk(inst->drain_mutex);
-                        std::swap(cbs, inst->drain_callbacks);
-                    }
-                    if (!cbs.empty() && inst->evaluator) {
-                        Token dtok;
-                        dtok.loc = TokenLocation("<tcp>", 0, 0, 0);
-                        for (auto& cb : cbs) {
-                            try {
-                                inst->evaluator->invoke_function(cb, {}, nullptr, dtok);
-                            } catch (const SwaziError& e) { std::cerr << e.what() << std::endl; } catch (...) {
-                            }
-                        }
-                    }
-                }
-            });
-
-        if (r != 0) {
-            auto* ctx = static_cast<WriteCtx*>(req->data);
-            free(ctx->buf);
-            delete ctx;
-            delete req;
-            if (sock_inst->on_error_handler) {
-                auto err = std::string("Write failed: ") + uv_strerror(r);
-                CallbackPayload* payload = new CallbackPayload(sock_inst->on_error_handler, {Value{err}});
-                enqueue_callback_global(static_cast<void*>(payload));
-            }
-        }
-        return Value{r == 0};
-    };
-    socket_obj->properties["write"] = {Value{std::make_shared<FunctionValue>("socket.write", write_impl, nullptr, tok)}, false, false, true, tok};
+    add_socket_write_methods(socket_obj, sock_inst, tok);
 
     // close
     auto close_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
         if (!sock_inst->closed.exchange(true) && sock_inst->socket_handle) {
+            flush_cork(sock_inst.get());
+            drop_cork(sock_inst.get());
             uv_close((uv_handle_t*)sock_inst->socket_handle, [](uv_handle_t* h) {
                 TcpSocketInstance* inst = static_cast<TcpSocketInstance*>(h->data);
                 if (inst) {
@@ -408,13 +540,6 @@ static void on_tcp_connection(uv_stream_t* server, int status) {
     };
     socket_obj->properties["isOpen"] = {Value{std::make_shared<FunctionValue>("socket.isOpen", is_open_impl, nullptr, tok)}, false, false, true, tok};
 
-    // writableNeedsDrain
-    auto needs_drain_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        if (sock_inst->closed.load() || !sock_inst->socket_handle) return Value{false};
-        return Value{sock_inst->socket_handle->write_queue_size >= TcpSocketInstance::WRITE_HIGH_WATERMARK};
-    };
-    socket_obj->properties["writableNeedsDrain"] = {Value{std::make_shared<FunctionValue>("socket.writableNeedsDrain", needs_drain_impl, nullptr, tok)}, false, false, true, tok};
-
     // pause
     auto pause_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
         if (!sock_inst->closed.load() && sock_inst->socket_handle && !sock_inst->paused.exchange(true))
@@ -463,11 +588,291 @@ static void on_tcp_connection(uv_stream_t* server, int status) {
 
     socket_obj->properties["remoteAddress"] = {Value{sock_inst->remote_address}, false, false, true, tok};
     socket_obj->properties["remotePort"] = {Value{static_cast<double>(sock_inst->remote_port)}, false, false, true, tok};
+    socket_obj->properties["_socketId"] = {Value{static_cast<double>(sock_id)}, false, false, true, tok};
+
+    return socket_obj;
+}
+
+// ── Server accept callback ────────────────────────────────────────────────────
+
+// Hands the sockets accepted this tick to on("connections") in one callback.
+static void tcp_flush_accepted(const std::shared_ptr<TcpServerInstance>& srv) {
+    if (!srv->pending_batch || srv->pending_batch->elements.empty()) return;
+    auto batch = std::move(srv->pending_batch);
+    if (srv->connections_handler && !srv->closed.load())
+        enqueue_callback_global(static_cast<void*>(new CallbackPayload(srv->connections_handler, {Value{batch}})));
+}
+
+// libuv keeps accepting until the listen queue is empty, calling this once
+// per connection.
+static void on_tcp_connection(uv_stream_t* server, int status) {
+    if (status < 0) return;
+    TcpServerInstance* srv = static_cast<TcpServerInstance*>(server->data);
+    if (!srv || srv->closed.load()) return;
+
+    uv_tcp_t* client = new uv_tcp_t;
+    uv_tcp_init(server->loop, client);
+
+    if (uv_accept(server, (uv_stream_t*)client) != 0 || (!srv->connection_handler && !srv->connections_handler)) {
+        uv_close((uv_handle_t*)client, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+        return;
+    }
 
-    if (srv->connection_handler) {
-        CallbackPayload* payload = new CallbackPayload(srv->connection_handler, {Value{socket_obj}});
-        enqueue_callback_global(static_cast<void*>(payload));
+    apply_socket_options(client, srv->socket_options);
+    auto socket_obj = make_accepted_socket(client, srv->socket_options);
+
+    if (srv->connections_handler) {
+        if (!srv->pending_batch) {
+            srv->pending_batch = std::make_shared<ArrayValue>();
+            std::weak_ptr<TcpServerInstance> weak = srv->weak_from_this();
+            loop_defer([weak]() {
+                if (auto self = weak.lock()) tcp_flush_accepted(self);
+            });
+        }
+        srv->pending_batch->elements.push_back(Value{socket_obj});
+        return;
     }
+
+    CallbackPayload* payload = new CallbackPayload(srv->connection_handler, {Value{socket_obj}});
+    enqueue_callback_global(static_cast<void*>(payload));
+}
+
+// ── Native writers ────────────────────────────────────────────────────────────
+
+uv_stream_t* tcp_socket_stream(long long socket_id) {
+    std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
+    auto it = g_tcp_sockets.find(socket_id);
+    if (it == g_tcp_sockets.end() || it->second->closed.load() || !it->second->socket_handle) return nullptr;
+    flush_cork(it->second.get());  // corked writes go ahead of the native writer's
+    return reinterpret_cast<uv_stream_t*>(it->second->socket_handle);
+}
+
+// ── Server object ─────────────────────────────────────────────────────────────
+
+static std::shared_ptr<ObjectValue> make_server_object(std::shared_ptr<TcpServerInstance> inst, long long id) {
+    auto server_obj = std::make_shared<ObjectValue>();
+    Token stok;
+    stok.loc = TokenLocation("<tcp>", 0, 0, 0);
+
+    // listen
+    auto listen_impl = [inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.empty()) throw SwaziError("TypeError", "listen requires port", token.loc);
+
+        int port = static_cast<int>(NetHelpers::value_to_number(args[0]));
+        std::string host = "0.0.0.0";
+        FunctionPtr cb = nullptr;
+
+        if (port < 0 || port > 65535)
+            throw SwaziError("TypeError", "Invalid port number", token.loc);
+
+        if (args.size() >= 2 && std::holds_alternative<std::string>(args[1]))
+            host = std::get<std::string>(args[1]);
+        if (args.size() >= 3 && std::holds_alternative<FunctionPtr>(args[2]))
+            cb = std::get<FunctionPtr>(args[2]);
+        else if (args.size() >= 2 && std::holds_alternative<FunctionPtr>(args[1]))
+            cb = std::get<FunctionPtr>(args[1]);
+
+        inst->port = port;
+        inst->host = host;
+
+        uv_loop_t* loop = scheduler_get_loop();
+        if (!loop) throw SwaziError("RuntimeError", "No event loop available", token.loc);
+
+        scheduler_run_on_loop([inst, port, host, cb, loop]() {
+            inst->server_handle = new uv_tcp_t;
+            inst->server_handle->data = inst.get();
+            uv_tcp_init(loop, inst->server_handle);
+
+            struct sockaddr_storage addr{};
+            int bind_r;
+            struct sockaddr_in a4{};
+            struct sockaddr_in6 a6{};
+
+            if (uv_ip4_addr(host.c_str(), port, &a4) == 0) {
+                memcpy(&addr, &a4, sizeof(a4));
+                bind_r = 0;
+            } else if (uv_ip6_addr(host.c_str(), port, &a6) == 0) {
+                memcpy(&addr, &a6, sizeof(a6));
+                bind_r = 0;
+            } else {
+                bind_r = UV_EINVAL;
+            }
+
+            if (bind_r != 0) {
+                if (cb) {
+                    auto err = std::string("Invalid address: ") + uv_strerror(bind_r);
+                    enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
+                }
+                uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+                inst->server_handle = nullptr;
+                return;
+            }
+
+            int bind_r2 = uv_tcp_bind(inst->server_handle, (const struct sockaddr*)&addr, 0);
+            if (bind_r2 != 0) {
+                if (cb) {
+                    auto err = std::string("Bind failed: ") + uv_strerror(bind_r2);
+                    enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
+                }
+                uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+                inst->server_handle = nullptr;
+                return;
+            }
+
+            apply_buffer_sizes(inst->server_handle, inst->socket_options);
+            uv_tcp_simultaneous_accepts(inst->server_handle, inst->simultaneous_accepts ? 1 : 0);
+            int r = uv_listen((uv_stream_t*)inst->server_handle, inst->backlog, on_tcp_connection);
+            inst->listening = r == 0;
+            if (cb) {
+                if (r == 0) {
+                    struct sockaddr_storage bound{};
+                    int len = sizeof(bound);
+                    uv_tcp_getsockname(inst->server_handle, (struct sockaddr*)&bound, &len);
+                    int actual_port = (bound.ss_family == AF_INET)
+                        ? ntohs(reinterpret_cast<struct sockaddr_in*>(&bound)->sin_port)
+                        : ntohs(reinterpret_cast<struct sockaddr_in6*>(&bound)->sin6_port);
+                    inst->port = actual_port;  // update so it's accurate from this point on
+
+                    auto info = std::make_shared<ObjectValue>();
+                    info->properties["port"] = {Value{(double)inst->port}, false, false, false, Token()};
+                    info->properties["address"] = {Value{inst->host}, false, false, false, Token()};
+                    enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {std::monostate{}, info})));
+                } else {
+                    auto err = std::string("Listen failed: ") + uv_strerror(r);
+                    enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
+                }
+            }
+        });
+        return std::monostate{};
+    };
+    server_obj->properties["listen"] = {Value{std::make_shared<FunctionValue>("server.listen", listen_impl, nullptr, stok)}, false, false, true, stok};
+
+    // server close
+    auto close_impl = [inst, id](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        FunctionPtr cb = (!args.empty() && std::holds_alternative<FunctionPtr>(args[0]))
+            ? std::get<FunctionPtr>(args[0])
+            : nullptr;
+        inst->closed.store(true);
+        scheduler_run_on_loop([inst, cb, id]() {
+            if (inst->server_handle) {
+                uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
+                inst->server_handle = nullptr;
+            }
+            {
+                std::lock_guard<std::mutex> lk(g_tcp_servers_mutex);
+                g_tcp_servers.erase(id);
+            }
+            if (cb) enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {})));
+        });
+        return std::monostate{};
+    };
+    server_obj->properties["close"] = {Value{std::make_shared<FunctionValue>("server.close", close_impl, nullptr, stok)}, false, false, true, stok};
+
+    // on("connection", handler) — replaces the handler given to createServer.
+    // on("connections", handler) takes an array of the sockets accepted in
+    // one loop tick instead, and wins over "connection" while set.  A server
+    // received over IPC starts accepting once it has either.
+    auto on_impl = [inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.size() < 2 || !std::holds_alternative<FunctionPtr>(args[1]))
+            throw SwaziError("TypeError", "on() requires event name and handler", token.loc);
+        std::string event = NetHelpers::value_to_string(args[0]);
+        if (event == "connection")
+            inst->connection_handler = std::get<FunctionPtr>(args[1]);
+        else if (event == "connections")
+            inst->connections_handler = std::get<FunctionPtr>(args[1]);
+        else
+            throw SwaziError("TypeError", "Unknown event: " + event, token.loc);
+        scheduler_run_on_loop([inst]() {
+            if (inst->listening || inst->closed.load() || !inst->server_handle) return;
+            inst->listening = uv_listen((uv_stream_t*)inst->server_handle, inst->backlog, on_tcp_connection) == 0;
+        });
+        return std::monostate{};
+    };
+    server_obj->properties["on"] = {Value{std::make_shared<FunctionValue>("server.on", on_impl, nullptr, stok)}, false, false, true, stok};
+    server_obj->properties["_serverId"] = {Value{static_cast<double>(id)}, false, false, true, stok};
+
+    return server_obj;
+}
+
+// ── IPC handle passing ────────────────────────────────────────────────────────
+
+static long long object_id(const Value& v, const char* key) {
+    if (!std::holds_alternative<ObjectPtr>(v)) return 0;
+    const ObjectPtr& o = std::get<ObjectPtr>(v);
+    auto it = o->properties.find(key);
+    if (it == o->properties.end() || !std::holds_alternative<double>(it->second.value)) return 0;
+    return static_cast<long long>(std::get<double>(it->second.value));
+}
+
+uv_tcp_t* tcp_ipc_handle(const Value& v, std::string& kind) {
+    if (long long sid = object_id(v, "_socketId")) {
+        std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
+        auto it = g_tcp_sockets.find(sid);
+        if (it == g_tcp_sockets.end() || it->second->closed.load()) return nullptr;
+        kind = "socket";
+        return it->second->socket_handle;
+    }
+    if (long long id = object_id(v, "_serverId")) {
+        std::lock_guard<std::mutex> lk(g_tcp_servers_mutex);
+        auto it = g_tcp_servers.find(id);
+        if (it == g_tcp_servers.end() || it->second->closed.load()) return nullptr;
+        kind = "server";
+        return it->second->server_handle;
+    }
+    return nullptr;
+}
+
+void tcp_ipc_handle_sent(const Value& v) {
+    // The receiver holds its own descriptor now; a socket lives on there only.
+    long long sid = object_id(v, "_socketId");
+    if (!sid) return;
+    std::shared_ptr<TcpSocketInstance> inst;
+    {
+        std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
+        auto it = g_tcp_sockets.find(sid);
+        if (it == g_tcp_sockets.end()) return;
+        inst = it->second;
+    }
+    if (inst->closed.exchange(true) || !inst->socket_handle) return;
+    drop_cork(inst.get());
+    uv_close((uv_handle_t*)inst->socket_handle, [](uv_handle_t* h) {
+        TcpSocketInstance* inst = static_cast<TcpSocketInstance*>(h->data);
+        if (inst) {
+            std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
+            g_tcp_sockets.erase(inst->socket_id);
+        }
+        delete (uv_tcp_t*)h;
+    });
+    inst->socket_handle = nullptr;
+}
+
+Value tcp_adopt_handle(uv_tcp_t* handle, const std::string& kind) {
+    if (kind == "socket") return Value{make_accepted_socket(handle)};
+
+    auto inst = std::make_shared<TcpServerInstance>();
+    inst->server_handle = handle;
+    handle->data = inst.get();
+
+    struct sockaddr_storage bound{};
+    int len = sizeof(bound);
+    if (uv_tcp_getsockname(handle, (struct sockaddr*)&bound, &len) == 0) {
+        char ip[INET6_ADDRSTRLEN] = {0};
+        if (bound.ss_family == AF_INET) {
+            uv_ip4_name(reinterpret_cast<struct sockaddr_in*>(&bound), ip, sizeof(ip));
+            inst->port = ntohs(reinterpret_cast<struct sockaddr_in*>(&bound)->sin_port);
+        } else if (bound.ss_family == AF_INET6) {
+            uv_ip6_name(reinterpret_cast<struct sockaddr_in6*>(&bound), ip, sizeof(ip));
+            inst->port = ntohs(reinterpret_cast<struct sockaddr_in6*>(&bound)->sin6_port);
+        }
+        inst->host = ip;
+    }
+
+    long long id = g_next_tcp_server_id.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lk(g_tcp_servers_mutex);
+        g_tcp_servers[id] = inst;
+    }
+    return Value{make_server_object(inst, id)};
 }
 
 // ── Exports ───────────────────────────────────────────────────────────────────
@@ -486,12 +891,35 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
     g_evaluator = evaluator;
 
     // ── createServer ──────────────────────────────────────────────────────────
+    // createServer(handler, options?) or createServer(options, handler?).
+    // Options: backlog (listen queue, default 128), simultaneousAccepts
+    // (Windows only), and the socket options every accepted socket gets —
+    // noDelay, keepAlive (default true), keepAliveInitialDelay (ms),
+    // recvBufferSize / sendBufferSize, writeHighWaterMark (default 16 KiB)
+    // and coalesceWrites (default true).
     auto createServer_impl = [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-        if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0]))
+        FunctionPtr handler = nullptr;
+        ObjectPtr opts = nullptr;
+        for (size_t i = 0; i < args.size() && i < 2; ++i) {
+            if (std::holds_alternative<FunctionPtr>(args[i]) && !handler)
+                handler = std::get<FunctionPtr>(args[i]);
+            else if (std::holds_alternative<ObjectPtr>(args[i]) && !opts)
+                opts = std::get<ObjectPtr>(args[i]);
+        }
+        if (!handler && !opts)
             throw SwaziError("TypeError", "createServer requires a connection handler", token.loc);
 
         auto inst = std::make_shared<TcpServerInstance>();
-        inst->connection_handler = std::get<FunctionPtr>(args[0]);
+        inst->connection_handler = handler;
+        inst->socket_options.keep_alive = true;
+        if (opts) {
+            double backlog = option_number(opts, "backlog", inst->backlog);
+            if (!std::isfinite(backlog) || backlog < 1 || backlog > 65535)
+                throw SwaziError("RangeError", "backlog must be between 1 and 65535", token.loc);
+            inst->backlog = static_cast<int>(backlog);
+            inst->simultaneous_accepts = option_bool(opts, "simultaneousAccepts", inst->simultaneous_accepts);
+            inst->socket_options = parse_socket_options(opts, inst->socket_options, token);
+        }
 
         long long id = g_next_tcp_server_id.fetch_add(1);
         {
@@ -499,122 +927,7 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
             g_tcp_servers[id] = inst;
         }
 
-        auto server_obj = std::make_shared<ObjectValue>();
-        Token stok;
-        stok.loc = TokenLocation("<tcp>", 0, 0, 0);
-
-        // listen
-        auto listen_impl = [inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-            if (args.empty()) throw SwaziError("TypeError", "listen requires port", token.loc);
-
-            int port = static_cast<int>(NetHelpers::value_to_number(args[0]));
-            std::string host = "0.0.0.0";
-            FunctionPtr cb = nullptr;
-
-            if (port < 0 || port > 65535)
-                throw SwaziError("TypeError", "Invalid port number", token.loc);
-
-            if (args.size() >= 2 && std::holds_alternative<std::string>(args[1]))
-                host = std::get<std::string>(args[1]);
-            if (args.size() >= 3 && std::holds_alternative<FunctionPtr>(args[2]))
-                cb = std::get<FunctionPtr>(args[2]);
-            else if (args.size() >= 2 && std::holds_alternative<FunctionPtr>(args[1]))
-                cb = std::get<FunctionPtr>(args[1]);
-
-            inst->port = port;
-            inst->host = host;
-
-            uv_loop_t* loop = scheduler_get_loop();
-            if (!loop) throw SwaziError("RuntimeError", "No event loop available", token.loc);
-
-            scheduler_run_on_loop([inst, port, host, cb, loop]() {
-                inst->server_handle = new uv_tcp_t;
-                inst->server_handle->data = inst.get();
-                uv_tcp_init(loop, inst->server_handle);
-
-                struct sockaddr_storage addr{};
-                int bind_r;
-                struct sockaddr_in a4{};
-                struct sockaddr_in6 a6{};
-
-                if (uv_ip4_addr(host.c_str(), port, &a4) == 0) {
-                    memcpy(&addr, &a4, sizeof(a4));
-                    bind_r = 0;
-                } else if (uv_ip6_addr(host.c_str(), port, &a6) == 0) {
-                    memcpy(&addr, &a6, sizeof(a6));
-                    bind_r = 0;
-                } else {
-                    bind_r = UV_EINVAL;
-                }
-
-                if (bind_r != 0) {
-                    if (cb) {
-                        auto err = std::string("Invalid address: ") + uv_strerror(bind_r);
-                        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
-                    }
-                    uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
-                    inst->server_handle = nullptr;
-                    return;
-                }
-
-                int bind_r2 = uv_tcp_bind(inst->server_handle, (const struct sockaddr*)&addr, 0);
-                if (bind_r2 != 0) {
-                    if (cb) {
-                        auto err = std::string("Bind failed: ") + uv_strerror(bind_r2);
-                        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
-                    }
-                    uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
-                    inst->server_handle = nullptr;
-                    return;
-                }
-
-                int r = uv_listen((uv_stream_t*)inst->server_handle, 128, on_tcp_connection);
-                if (cb) {
-                    if (r == 0) {
-                        struct sockaddr_storage bound{};
-                        int len = sizeof(bound);
-                        uv_tcp_getsockname(inst->server_handle, (struct sockaddr*)&bound, &len);
-                        int actual_port = (bound.ss_family == AF_INET)
-                            ? ntohs(reinterpret_cast<struct sockaddr_in*>(&bound)->sin_port)
-                            : ntohs(reinterpret_cast<struct sockaddr_in6*>(&bound)->sin6_port);
-                        inst->port = actual_port;  // update so it's accurate from this point on
-
-                        auto info = std::make_shared<ObjectValue>();
-                        info->properties["port"] = {Value{(double)inst->port}, false, false, false, Token()};
-                        info->properties["address"] = {Value{inst->host}, false, false, false, Token()};
-                        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {std::monostate{}, info})));
-                    } else {
-                        auto err = std::string("Listen failed: ") + uv_strerror(r);
-                        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {Value{err}})));
-                    }
-                }
-            });
-            return std::monostate{};
-        };
-        server_obj->properties["listen"] = {Value{std::make_shared<FunctionValue>("server.listen", listen_impl, nullptr, stok)}, false, false, true, stok};
-
-        // server close
-        auto close_impl = [inst, id](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
-            FunctionPtr cb = (!args.empty() && std::holds_alternative<FunctionPtr>(args[0]))
-                ? std::get<FunctionPtr>(args[0])
-                : nullptr;
-            inst->closed.store(true);
-            scheduler_run_on_loop([inst, cb, id]() {
-                if (inst->server_handle) {
-                    uv_close((uv_handle_t*)inst->server_handle, [](uv_handle_t* h) { delete (uv_tcp_t*)h; });
-                    inst->server_handle = nullptr;
-                }
-                {
-                    std::lock_guard<std::mutex> lk(g_tcp_servers_mutex);
-                    g_tcp_servers.erase(id);
-                }
-                if (cb) enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {})));
-            });
-            return std::monostate{};
-        };
-        server_obj->properties["close"] = {Value{std::make_shared<FunctionValue>("server.close", close_impl, nullptr, stok)}, false, false, true, stok};
-
-        return Value{server_obj};
+        return Value{make_server_object(inst, id)};
     };
     obj->properties["createServer"] = {Value{std::make_shared<FunctionValue>("tcp.createServer", createServer_impl, env, tok)}, false, false, true, tok};
 
@@ -626,9 +939,12 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
         int port = 0;
         std::string host = "127.0.0.1";
         FunctionPtr cb = nullptr;
+        TcpSocketOptions options;
 
         if (std::holds_alternative<ObjectPtr>(args[0])) {
+            // {port, host} plus the socket options createServer takes
             ObjectPtr opts = std::get<ObjectPtr>(args[0]);
+            options = parse_socket_options(opts, options, token);
             auto pit = opts->properties.find("port");
             if (pit != opts->properties.end())
                 port = static_cast<int>(NetHelpers::value_to_number(pit->second.value));
@@ -655,6 +971,7 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
         auto sock_inst = std::make_shared<TcpSocketInstance>();
         sock_inst->on_connect_handler = cb;
         sock_inst->evaluator = g_evaluator;
+        sock_inst->options = options;
 
         long long sock_id = g_next_tcp_socket_id.fetch_add(1);
         sock_inst->socket_id = sock_id;
@@ -673,70 +990,13 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
         Token stok;
         stok.loc = TokenLocation("<tcp>", 0, 0, 0);
 
-        // write
-        auto write_impl = [sock_inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
-            if (args.empty()) return Value{false};
-            if (sock_inst->closed.load() || !sock_inst->socket_handle)
-                throw SwaziError("IOError", "Socket is closed", token.loc);
-
-            std::vector<uint8_t> data = NetHelpers::get_buffer_data(args[0]);
-            if (data.empty()) return Value{false};
-
-            struct WriteCtx {
-                char* buf;
-                std::shared_ptr<TcpSocketInstance> inst;
-            };
-            char* buf = static_cast<char*>(malloc(data.size()));
-            memcpy(buf, data.data(), data.size());
-
-            uv_buf_t uvbuf = uv_buf_init(buf, (unsigned int)data.size());
-            uv_write_t* req = new uv_write_t;
-            req->data = new WriteCtx{buf, sock_inst};
-
-            int r = uv_write(req, (uv_stream_t*)sock_inst->socket_handle, &uvbuf, 1,
-                [](uv_write_t* req, int status) {
-                    auto* ctx = static_cast<WriteCtx*>(req->data);
-                    free(ctx->buf);
-                    auto inst = ctx->inst;
-                    delete ctx;
-                    delete req;
-                    if (status != 0) return;
-                    if (inst->socket_handle && inst->socket_handle->write_queue_size == 0) {
-                        std::vector<FunctionPtr> cbs;
-                        {
-                            std::lock_guard<std::mutex> lk(inst->drain_mutex);
-                            std::swap(cbs, inst->drain_callbacks);
-                        }
-                        if (!cbs.empty() && inst->evaluator) {
-                            Token dtok;
-                            dtok.loc = TokenLocation("<tcp>", 0, 0, 0);
-                            for (auto& cb : cbs) {
-                                try {
-                                    inst->evaluator->invoke_function(cb, {}, nullptr, dtok);
-                                } catch (const SwaziError& e) { std::cerr << e.what() << std::endl; } catch (...) {
-                                }
-                            }
-                        }
-                    }
-                });
-
-            if (r != 0) {
-                auto* ctx = static_cast<WriteCtx*>(req->data);
-                free(ctx->buf);
-                delete ctx;
-                delete req;
-                if (sock_inst->on_error_handler) {
-                    auto err = std::string("Write failed: ") + uv_strerror(r);
-                    enqueue_callback_global(static_cast<void*>(new CallbackPayload(sock_inst->on_error_handler, {Value{err}})));
-                }
-            }
-            return Value{r == 0};
-        };
-        socket_obj->properties["write"] = {Value{std::make_shared<FunctionValue>("socket.write", write_impl, nullptr, stok)}, false, false, true, stok};
+        add_socket_write_methods(socket_obj, sock_inst, stok);
 
         // close
         auto close_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
             if (!sock_inst->closed.exchange(true) && sock_inst->socket_handle) {
+                flush_cork(sock_inst.get());
+                drop_cork(sock_inst.get());
                 uv_close((uv_handle_t*)sock_inst->socket_handle, [](uv_handle_t* h) {
                     TcpSocketInstance* inst = static_cast<TcpSocketInstance*>(h->data);
                     if (inst) {
@@ -758,13 +1018,6 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
         };
         socket_obj->properties["isOpen"] = {Value{std::make_shared<FunctionValue>("socket.isOpen", is_open_impl, nullptr, stok)}, false, false, true, stok};
 
-        // writableNeedsDrain
-        auto needs_drain_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-            if (sock_inst->closed.load() || !sock_inst->socket_handle) return Value{false};
-            return Value{sock_inst->socket_handle->write_queue_size >= TcpSocketInstance::WRITE_HIGH_WATERMARK};
-        };
-        socket_obj->properties["writableNeedsDrain"] = {Value{std::make_shared<FunctionValue>("socket.writableNeedsDrain", needs_drain_impl, nullptr, stok)}, false, false, true, stok};
-
         // pause
         auto pause_impl = [sock_inst](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
             if (!sock_inst->closed.load() && sock_inst->socket_handle && !sock_inst->paused.exchange(true))
@@ -812,28 +1065,20 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
             return Value{socket_obj};
         };
         socket_obj->properties["on"] = {Value{std::make_shared<FunctionValue>("socket.on", on_impl, nullptr, stok)}, false, false, true, stok};
+        socket_obj->properties["_socketId"] = {Value{static_cast<double>(sock_id)}, false, false, true, stok};
 
         // ── DNS + connect ─────────────────────────────────────────────────────
 
-        uv_getaddrinfo_t* resolve_req = new uv_getaddrinfo_t;
-        resolve_req->data = new ResolveConnectData{sock_inst, socket_obj, port, loop, nullptr, nullptr};
-
-        struct addrinfo hints{};
-        hints.ai_family = AF_UNSPEC;
-        hints.ai_socktype = SOCK_STREAM;
-        hints.ai_flags = 0;
-
-        int r = uv_getaddrinfo(
-            loop,
-            resolve_req,
-            [](uv_getaddrinfo_t* resolve_req, int status, struct addrinfo* res) {
-                ResolveConnectData* rdata = static_cast<ResolveConnectData*>(resolve_req->data);
-                delete resolve_req;
-
-                if (status < 0 || !res) {
+        // Cached answers (and IP literals) come back before dns_resolve
+        // returns; the connect itself still completes on a later tick, and a
+        // failure waits for the tick's end so on("error") can be attached.
+        auto* rdata = new ResolveConnectData{sock_inst, socket_obj, port, loop, {}, 0};
+        dns_resolve(loop, host, AF_UNSPEC, [rdata](int status, const std::vector<sockaddr_storage>& addrs) {
+            if (status != 0) {
+                auto inst = rdata->sock_inst;
+                delete rdata;
+                loop_defer([inst, status]() {
                     g_active_tcp_work.fetch_sub(1);
-                    auto inst = rdata->sock_inst;
-                    delete rdata;
                     {
                         std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
                         g_tcp_sockets.erase(inst->socket_id);
@@ -842,31 +1087,12 @@ std::shared_ptr<ObjectValue> make_tcp_exports(EnvPtr env, Evaluator* evaluator)
                         auto err = std::string("DNS resolution failed: ") + uv_strerror(status);
                         enqueue_callback_global(static_cast<void*>(new CallbackPayload(inst->on_error_handler, {Value{err}})));
                     }
-                    if (res) uv_freeaddrinfo(res);
-                    return;
-                }
-
-                rdata->addrlist = res;
-                rdata->current = res;
-                try_next_address(rdata);
-            },
-            host.c_str(),
-            nullptr,
-            &hints);
-
-        if (r != 0) {
-            delete static_cast<ResolveConnectData*>(resolve_req->data);
-            delete resolve_req;
-            g_active_tcp_work.fetch_sub(1);
-            {
-                std::lock_guard<std::mutex> lk(g_tcp_sockets_mutex);
-                g_tcp_sockets.erase(sock_id);  // missing
-            }
-            if (sock_inst->on_error_handler) {
-                auto err = std::string("DNS resolve initiation failed: ") + uv_strerror(r);
-                enqueue_callback_global(static_cast<void*>(new CallbackPayload(sock_inst->on_error_handler, {Value{err}})));
+                });
+                return;
             }
-        }
+            rdata->addrs = addrs;
+            try_next_address(rdata);
+        });
 
         return Value{socket_obj};
     };
@@ -65,10 +65,7 @@ static void start_reading_if_needed(UnixSocketInstance* inst) {
     }
 
     uv_read_start((uv_stream_t*)inst->pipe_handle,
-        [](uv_handle_t*, size_t suggested, uv_buf_t* buf) {
-            buf->base = new char[suggested];
-            buf->len = (unsigned int)suggested;
-        },
+        read_pool_alloc,
         [](uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
             UnixSocketInstance* inst = static_cast<UnixSocketInstance*>(stream->data);
 
@@ -82,9 +79,7 @@ static void start_reading_if_needed(UnixSocketInstance* inst) {
                 enqueue_callback_global(static_cast<void*>(payload));
             }
 
-            if (buf->base) {
-                delete[] buf->base;
-            }
+            read_pool_release(buf);
 
             if (nread < 0) {
                 inst->reading.store(false);
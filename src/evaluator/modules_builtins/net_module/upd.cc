@@ -1,8 +1,10 @@
 // udp.cc - UDP socket implementation using libuv
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "./net.hpp"
 
@@ -14,18 +16,34 @@ bool udp_has_active_work() {
     return g_active_udp_work.load() > 0;
 }
 
+// libuv hands each datagram of a recvmmsg batch its own 64 KiB slot of the
+// receive buffer (UV__UDP_DGRAM_MAXSIZE), and reads at most 20 per call.
+static constexpr size_t UDP_DGRAM_SLOT = 64 * 1024;
+static constexpr size_t UDP_MAX_RECV_BATCH = 20;
+
 // UDP Socket instance
-struct UdpSocketInstance {
+struct UdpSocketInstance : public std::enable_shared_from_this<UdpSocketInstance> {
     uv_udp_t* udp_handle = nullptr;
     std::atomic<bool> closed{false};
     std::atomic<bool> work_counted{false};  // Track if work counter was incremented
     FunctionPtr on_message_handler;
+    FunctionPtr on_messages_handler;  // batched: one array of packets per loop tick
     FunctionPtr on_error_handler;
     FunctionPtr on_close_handler;
     std::string bound_address;
     int bound_port = 0;
     std::string socket_type;  // "udp4" or "udp6"
 
+    // Receive buffer, allocated once and reused for every read.  With
+    // recv_batch > 1 the socket uses recvmmsg and one read fills up to
+    // recv_batch slots.
+    size_t recv_batch = 16;
+    std::vector<char> recv_pool;
+    bool recv_pool_busy = false;
+
+    // Packets gathered for on("messages") since the last flush.
+    std::shared_ptr<ArrayValue> pending_batch;
+
     ~UdpSocketInstance() {
         // Safety: ensure work counter is decremented on destruction
         if (work_counted.exchange(false)) {
@@ -38,12 +56,65 @@ static std::mutex g_udp_sockets_mutex;
 static std::unordered_map<long long, std::shared_ptr<UdpSocketInstance>> g_udp_sockets;
 static std::atomic<long long> g_next_udp_socket_id{1};
 
-// Allocation callback for UDP receives
+// Allocation callback for UDP receives: the socket's pooled buffer, or a
+// one-off allocation if a read is somehow still holding it.
 static void udp_alloc_cb(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+    UdpSocketInstance* inst = static_cast<UdpSocketInstance*>(handle->data);
+    if (inst && !inst->recv_pool_busy) {
+        size_t want = std::max<size_t>(inst->recv_batch, 1) * UDP_DGRAM_SLOT;
+        if (inst->recv_pool.size() != want) inst->recv_pool.resize(want);
+        inst->recv_pool_busy = true;
+        buf->base = inst->recv_pool.data();
+        buf->len = (unsigned int)want;
+        return;
+    }
     buf->base = new char[suggested];
     buf->len = (unsigned int)suggested;
 }
 
+static void udp_release_buf(UdpSocketInstance* inst, const uv_buf_t* buf) {
+    if (inst && buf->base == inst->recv_pool.data()) {
+        inst->recv_pool_busy = false;
+    } else {
+        delete[] buf->base;
+    }
+}
+
+static void udp_sender_info(const struct sockaddr* addr, std::string& sender_addr, int& sender_port) {
+    if (addr->sa_family == AF_INET) {
+        struct sockaddr_in* addr_in = (struct sockaddr_in*)addr;
+        char ip[INET_ADDRSTRLEN];
+        uv_ip4_name(addr_in, ip, sizeof(ip));
+        sender_addr = ip;
+        sender_port = ntohs(addr_in->sin_port);
+    } else if (addr->sa_family == AF_INET6) {
+        struct sockaddr_in6* addr_in6 = (struct sockaddr_in6*)addr;
+        if (IN6_IS_ADDR_V4MAPPED(&addr_in6->sin6_addr)) {
+            struct sockaddr_in mapped{};
+            mapped.sin_family = AF_INET;
+            memcpy(&mapped.sin_addr, addr_in6->sin6_addr.s6_addr + 12, 4);
+            char ip[INET_ADDRSTRLEN];
+            uv_ip4_name(&mapped, ip, sizeof(ip));
+            sender_addr = ip;
+            sender_port = ntohs(addr_in6->sin6_port);
+        } else {
+            char ip[INET6_ADDRSTRLEN];
+            uv_ip6_name(addr_in6, ip, sizeof(ip));
+            sender_addr = ip;
+            sender_port = ntohs(addr_in6->sin6_port);
+        }
+    }
+}
+
+// Hands the packets gathered this tick to on("messages") in one callback.
+static void udp_flush_batch(const std::shared_ptr<UdpSocketInstance>& inst) {
+    if (!inst->pending_batch || inst->pending_batch->elements.empty()) return;
+    auto batch = std::move(inst->pending_batch);
+    if (inst->on_messages_handler && !inst->closed.load()) {
+        enqueue_callback_global(static_cast<void*>(new CallbackPayload(inst->on_messages_handler, {Value{batch}})));
+    }
+}
+
 // UDP receive callback
 static void udp_recv_cb(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf,
     const struct sockaddr* addr, unsigned flags) {
@@ -69,49 +140,52 @@ static void udp_recv_cb(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf,
             enqueue_callback_global(static_cast<void*>(payload));
         }
 
-        delete[] buf->base;
+        if (!(flags & UV_UDP_MMSG_CHUNK)) udp_release_buf(inst, buf);
         return;  // don't fall through to the generic nread < 0 handler below
     }
 
-    if (nread > 0 && inst && inst->on_message_handler && addr) {
+    // recvmmsg calls back once per datagram with a slot of the pooled buffer
+    // (UV_UDP_MMSG_CHUNK), then once more to give the whole buffer back.
+    bool chunk = (flags & UV_UDP_MMSG_CHUNK) != 0;
+
+    if (nread > 0 && inst && addr && (inst->on_message_handler || inst->on_messages_handler)) {
         // Extract sender info
         std::string sender_addr;
         int sender_port = 0;
-
-        if (addr->sa_family == AF_INET) {
-            struct sockaddr_in* addr_in = (struct sockaddr_in*)addr;
-            char ip[INET_ADDRSTRLEN];
-            uv_ip4_name(addr_in, ip, sizeof(ip));
-            sender_addr = ip;
-            sender_port = ntohs(addr_in->sin_port);
-        } else if (addr->sa_family == AF_INET6) {
-            struct sockaddr_in6* addr_in6 = (struct sockaddr_in6*)addr;
-            if (IN6_IS_ADDR_V4MAPPED(&addr_in6->sin6_addr)) {
-                struct sockaddr_in mapped{};
-                mapped.sin_family = AF_INET;
-                memcpy(&mapped.sin_addr, addr_in6->sin6_addr.s6_addr + 12, 4);
-                char ip[INET_ADDRSTRLEN];
-                uv_ip4_name(&mapped, ip, sizeof(ip));
-                sender_addr = ip;
-                sender_port = ntohs(addr_in6->sin6_port);
-            } else {
-                char ip[INET6_ADDRSTRLEN];
-                uv_ip6_name(addr_in6, ip, sizeof(ip));
-                sender_addr = ip;
-                sender_port = ntohs(addr_in6->sin6_port);
-            }
-        }
+        udp_sender_info(addr, sender_addr, sender_port);
 
         // Create buffer with received data
         auto buffer = std::make_shared<BufferValue>();
         buffer->data.assign(buf->base, buf->base + nread);
         buffer->encoding = "binary";
 
-        // Create rinfo object
-        auto rinfo = std::make_shared<ObjectValue>();
         Token tok;
         tok.loc = TokenLocation("<udp>", 0, 0, 0);
 
+        if (inst->on_messages_handler) {
+            auto packet = std::make_shared<ObjectValue>();
+            packet->properties["msg"] = {Value{buffer}, false, false, true, tok};
+            packet->properties["address"] = {Value{sender_addr}, false, false, true, tok};
+            packet->properties["port"] = {Value{static_cast<double>(sender_port)}, false, false, true, tok};
+
+            if (!inst->pending_batch) {
+                inst->pending_batch = std::make_shared<ArrayValue>();
+                std::weak_ptr<UdpSocketInstance> weak = inst->weak_from_this();
+                loop_defer([weak]() {
+                    if (auto self = weak.lock()) udp_flush_batch(self);
+                });
+            }
+            inst->pending_batch->elements.push_back(Value{packet});
+        }
+
+        if (!inst->on_message_handler) {
+            if (!chunk) udp_release_buf(inst, buf);
+            return;
+        }
+
+        // Create rinfo object
+        auto rinfo = std::make_shared<ObjectValue>();
+
         rinfo->properties["address"] = {Value{sender_addr}, false, false, true, tok};
         rinfo->properties["port"] = {Value{static_cast<double>(sender_port)}, false, false, true, tok};
         rinfo->properties["family"] = {
@@ -125,7 +199,119 @@ static void udp_recv_cb(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf,
         enqueue_callback_global(static_cast<void*>(payload));
     }
 
-    delete[] buf->base;
+    if (!chunk) udp_release_buf(inst, buf);
+}
+
+// Destination address for send: an IP literal, mapped to IPv6 on a udp6 socket.
+static bool udp_dest_addr(const std::string& socket_type, const std::string& address, int port,
+    struct sockaddr_storage& out, std::string& err) {
+    struct sockaddr_in a4{};
+    struct sockaddr_in6 a6{};
+    memset(&out, 0, sizeof(out));
+    if (uv_ip4_addr(address.c_str(), port, &a4) == 0) {
+        if (socket_type == "udp6") {
+            a6.sin6_family = AF_INET6;
+            a6.sin6_port = htons(port);
+            a6.sin6_addr.s6_addr[10] = 0xff;
+            a6.sin6_addr.s6_addr[11] = 0xff;
+            memcpy(&a6.sin6_addr.s6_addr[12], &a4.sin_addr, 4);
+            memcpy(&out, &a6, sizeof(a6));
+        } else {
+            memcpy(&out, &a4, sizeof(a4));
+        }
+        return true;
+    }
+    if (uv_ip6_addr(address.c_str(), port, &a6) == 0) {
+        if (socket_type == "udp4") {
+            err = "Cannot send to IPv6 address on udp4 socket";
+            return false;
+        }
+        memcpy(&out, &a6, sizeof(a6));
+        return true;
+    }
+    err = "send() requires an IP address, not a hostname";
+    return false;
+}
+
+// A batch for socket.sendBatch.  Everything the kernel takes at once goes out
+// through uv_udp_try_send2 (sendmmsg); the rest is queued with uv_udp_send.
+struct UdpSendBatch {
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<struct sockaddr_storage> addrs;
+    std::vector<uv_buf_t> bufs;
+    FunctionPtr callback;
+    FunctionPtr error_handler;
+    size_t queued = 0;
+    std::string error;
+
+    void finish() {
+        if (!error.empty() && error_handler) {
+            enqueue_callback_global(static_cast<void*>(new CallbackPayload(error_handler, {Value{error}})));
+        }
+        if (callback) {
+            std::vector<Value> args;
+            if (!error.empty()) args.push_back(Value{error});
+            enqueue_callback_global(static_cast<void*>(new CallbackPayload(callback, args)));
+        }
+    }
+};
+
+static void udp_send_batch(uv_udp_t* handle, std::shared_ptr<UdpSendBatch> batch) {
+    size_t count = batch->payloads.size();
+    std::vector<uv_buf_t*> buf_ptrs(count);
+    std::vector<unsigned int> nbufs(count, 1);
+    std::vector<struct sockaddr*> addr_ptrs(count);
+    for (size_t i = 0; i < count; i++) {
+        batch->bufs[i] = uv_buf_init(reinterpret_cast<char*>(batch->payloads[i].data()),
+            static_cast<unsigned int>(batch->payloads[i].size()));
+        buf_ptrs[i] = &batch->bufs[i];
+        addr_ptrs[i] = reinterpret_cast<struct sockaddr*>(&batch->addrs[i]);
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+        int r = uv_udp_try_send2(handle, static_cast<unsigned int>(count - sent),
+            buf_ptrs.data() + sent, nbufs.data() + sent, addr_ptrs.data() + sent, 0);
+        if (r > 0) {
+            sent += static_cast<size_t>(r);
+            continue;
+        }
+        if (r != UV_EAGAIN && r != UV_ENOSYS) {
+            batch->error = std::string("Send failed: ") + uv_strerror(r);
+            batch->finish();
+            return;
+        }
+        break;
+    }
+    if (sent == count) {
+        batch->finish();
+        return;
+    }
+
+    // Socket buffer full (or packets already queued ahead of us): queue the
+    // remainder in order; the batch owns the payloads until the last one is out.
+    for (size_t i = sent; i < count; i++) {
+        auto* req = new uv_udp_send_t;
+        req->data = new std::shared_ptr<UdpSendBatch>(batch);
+        int r = uv_udp_send(req, handle, &batch->bufs[i], 1, addr_ptrs[i], [](uv_udp_send_t* req, int status) {
+            auto* holder = static_cast<std::shared_ptr<UdpSendBatch>*>(req->data);
+            auto batch = *holder;
+            delete holder;
+            delete req;
+            if (status != 0 && batch->error.empty()) {
+                batch->error = std::string("Send failed: ") + uv_strerror(status);
+            }
+            if (--batch->queued == 0) batch->finish();
+        });
+        if (r != 0) {
+            delete static_cast<std::shared_ptr<UdpSendBatch>*>(req->data);
+            delete req;
+            batch->error = std::string("Send initiation failed: ") + uv_strerror(r);
+            break;
+        }
+        batch->queued++;
+    }
+    if (batch->queued == 0) batch->finish();
 }
 
 std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator) {
@@ -134,9 +320,12 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
     tok.loc = TokenLocation("<udp>", 0, 0, 0);
 
     // udp.createSocket(type, callback?)
-    // type: 'udp4' or 'udp6'
+    // type: 'udp4' or 'udp6', or an options object {type, recvBatch}.
+    // recvBatch: datagrams read per recvmmsg call (1-20, default 16); 1 reads
+    // one at a time into a 64 KiB buffer.
     auto createSocket_impl = [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
         std::string type = "udp4";
+        size_t recv_batch = 16;
         FunctionPtr cb = nullptr;
 
         if (!args.empty()) {
@@ -149,6 +338,14 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
                 if (type_prop != opts->properties.end()) {
                     type = NetHelpers::value_to_string(type_prop->second.value);
                 }
+                auto batch_prop = opts->properties.find("recvBatch");
+                if (batch_prop != opts->properties.end()) {
+                    double n = NetHelpers::value_to_number(batch_prop->second.value);
+                    if (n < 1 || n > UDP_MAX_RECV_BATCH) {
+                        throw SwaziError("RangeError", "recvBatch must be between 1 and 20", token.loc);
+                    }
+                    recv_batch = static_cast<size_t>(n);
+                }
             }
         }
 
@@ -162,6 +359,7 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
 
         auto inst = std::make_shared<UdpSocketInstance>();
         inst->socket_type = type;
+        inst->recv_batch = recv_batch;
         long long sock_id = g_next_udp_socket_id.fetch_add(1);
 
         // Increment work counter and mark it
@@ -197,6 +395,7 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
             inst->udp_handle->data = inst.get();
 
             unsigned int flags = (type == "udp6") ? AF_INET6 : AF_INET;
+            if (inst->recv_batch > 1) flags |= UV_UDP_RECVMMSG;
             int r = uv_udp_init_ex(loop, inst->udp_handle, flags);
 
             if (r == 0) {
@@ -301,57 +500,30 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
                 }
 
                 // Not an IP literal — resolve via DNS (bind happens once, acceptable cost)
-                struct BindResolveCtx {
-                    std::shared_ptr<UdpSocketInstance> inst;
-                    int port;
-                    FunctionPtr cb;
-                };
-                auto* rctx = new BindResolveCtx{inst, port, cb};
-                auto* resolve_req = new uv_getaddrinfo_t;
-                resolve_req->data = rctx;
-
-                struct addrinfo hints{};
-                hints.ai_family = (inst->socket_type == "udp6") ? AF_INET6 : AF_INET;
-                hints.ai_socktype = SOCK_DGRAM;
-
-                int gr = uv_getaddrinfo(loop, resolve_req, [](uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
-                        auto* rctx = static_cast<BindResolveCtx*>(req->data);
-                        delete req;
+                int family = (inst->socket_type == "udp6") ? AF_INET6 : AF_INET;
+                dns_resolve(loop, address, family, [inst, port, cb](int status, const std::vector<sockaddr_storage>& addrs) {
+                    if (status != 0) {
+                        if (cb)
+                            enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb,
+                                {Value{std::string("DNS resolution failed: ") + uv_strerror(status)}})));
+                        return;
+                    }
 
-                        if (status < 0 || !res) {
-                            if (rctx->cb)
-                                enqueue_callback_global(static_cast<void*>(new CallbackPayload(rctx->cb,
-                                    {Value{std::string("DNS resolution failed: ") + uv_strerror(status)}})));
-                            delete rctx;
-                            if (res) uv_freeaddrinfo(res);
-                            return;
-                        }
+                    struct sockaddr_storage addr = addrs[0];
+                    if (addr.ss_family == AF_INET)
+                        reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port = htons(port);
+                    else
+                        reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port = htons(port);
 
-                        struct sockaddr_storage addr{};
-                        memcpy(&addr, res->ai_addr, res->ai_addrlen);
-                        if (addr.ss_family == AF_INET)
-                            reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port = htons(rctx->port);
+                    int r = uv_udp_bind(inst->udp_handle, (const struct sockaddr*)&addr, UV_UDP_REUSEADDR);
+                    if (cb) {
+                        if (r == 0)
+                            enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb, {})));
                         else
-                            reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port = htons(rctx->port);
-                        uv_freeaddrinfo(res);
-
-                        int r = uv_udp_bind(rctx->inst->udp_handle, (const struct sockaddr*)&addr, UV_UDP_REUSEADDR);
-                        if (rctx->cb) {
-                            if (r == 0)
-                                enqueue_callback_global(static_cast<void*>(new CallbackPayload(rctx->cb, {})));
-                            else
-                                enqueue_callback_global(static_cast<void*>(new CallbackPayload(rctx->cb,
-                                    {Value{std::string("Bind failed: ") + uv_strerror(r)}})));
-                        }
-                        delete rctx; }, address.c_str(), nullptr, &hints);
-
-                if (gr != 0) {
-                    if (cb)
-                        enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb,
-                            {Value{std::string("DNS resolve failed: ") + uv_strerror(gr)}})));
-                    delete static_cast<BindResolveCtx*>(resolve_req->data);
-                    delete resolve_req;
-                }
+                            enqueue_callback_global(static_cast<void*>(new CallbackPayload(cb,
+                                {Value{std::string("Bind failed: ") + uv_strerror(r)}})));
+                    }
+                });
             });
             return std::monostate{};
         };
@@ -516,6 +688,79 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
         auto send_fn = std::make_shared<FunctionValue>("socket.send", send_impl, nullptr, stok);
         socket_obj->properties["send"] = {Value{send_fn}, false, false, true, stok};
 
+        // socket.sendBatch(messages, port?, address?, callback?)
+        // Each message is a buffer or string sent to (port, address), or an
+        // object {msg, port, address}.  callback(err?) runs once for the batch.
+        auto sendBatch_impl = [inst](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.empty() || !std::holds_alternative<ArrayPtr>(args[0])) {
+                throw SwaziError("TypeError", "sendBatch requires an array of messages", token.loc);
+            }
+            ArrayPtr messages = std::get<ArrayPtr>(args[0]);
+
+            int default_port = -1;
+            std::string default_address;
+            FunctionPtr cb = nullptr;
+            for (size_t i = 1; i < args.size(); i++) {
+                if (std::holds_alternative<FunctionPtr>(args[i])) {
+                    cb = std::get<FunctionPtr>(args[i]);
+                } else if (std::holds_alternative<double>(args[i])) {
+                    default_port = static_cast<int>(std::get<double>(args[i]));
+                } else if (std::holds_alternative<std::string>(args[i])) {
+                    default_address = std::get<std::string>(args[i]);
+                }
+            }
+
+            const size_t MAX_UDP_PAYLOAD = 65507;
+            auto batch = std::make_shared<UdpSendBatch>();
+            batch->callback = cb;
+            batch->error_handler = inst->on_error_handler;
+            for (const Value& msg : messages->elements) {
+                Value data = msg;
+                int port = default_port;
+                std::string address = default_address;
+                if (std::holds_alternative<ObjectPtr>(msg)) {
+                    ObjectPtr o = std::get<ObjectPtr>(msg);
+                    auto d = o->properties.find("msg");
+                    data = d != o->properties.end() ? d->second.value : Value{};
+                    auto p = o->properties.find("port");
+                    if (p != o->properties.end()) port = static_cast<int>(NetHelpers::value_to_number(p->second.value));
+                    auto a = o->properties.find("address");
+                    if (a != o->properties.end()) address = NetHelpers::value_to_string(a->second.value);
+                }
+                if (port < 0 || port > 65535 || address.empty()) {
+                    throw SwaziError("TypeError", "sendBatch: every message needs a port and an address", token.loc);
+                }
+
+                std::vector<uint8_t> payload = NetHelpers::get_buffer_data(data);
+                if (payload.empty()) continue;
+                if (payload.size() > MAX_UDP_PAYLOAD) {
+                    throw SwaziError("RangeError", "sendBatch: UDP payload size (" + std::to_string(payload.size()) +
+                        " bytes) exceeds maximum of " + std::to_string(MAX_UDP_PAYLOAD) + " bytes", token.loc);
+                }
+
+                struct sockaddr_storage addr;
+                std::string err;
+                if (!udp_dest_addr(inst->socket_type, address, port, addr, err)) {
+                    throw SwaziError("TypeError", "sendBatch: " + err, token.loc);
+                }
+                batch->payloads.push_back(std::move(payload));
+                batch->addrs.push_back(addr);
+            }
+            batch->bufs.resize(batch->payloads.size());
+
+            scheduler_run_on_loop([inst, batch]() {
+                if (!inst->udp_handle) {
+                    batch->error = "Send failed: socket not initialized";
+                    batch->finish();
+                    return;
+                }
+                udp_send_batch(inst->udp_handle, batch);
+            });
+            return std::monostate{};
+        };
+        auto sendBatch_fn = std::make_shared<FunctionValue>("socket.sendBatch", sendBatch_impl, nullptr, stok);
+        socket_obj->properties["sendBatch"] = {Value{sendBatch_fn}, false, false, true, stok};
+
         // socket.on(event, handler)
         auto socket_weak = std::weak_ptr<ObjectValue>(socket_obj);
         auto on_impl = [inst, socket_weak](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
@@ -533,8 +778,14 @@ std::shared_ptr<ObjectValue> make_udp_exports(EnvPtr env, Evaluator* evaluator)
 
             FunctionPtr handler = std::get<FunctionPtr>(args[1]);
 
-            if (event == "message") {
-                inst->on_message_handler = handler;
+            if (event == "message" || event == "messages") {
+                // "messages" receives an array of {msg, address, port} per
+                // loop tick instead of one callback per datagram.
+                if (event == "message") {
+                    inst->on_message_handler = handler;
+                } else {
+                    inst->on_messages_handler = handler;
+                }
 
                 // Start receiving
                 scheduler_run_on_loop([inst]() {
@@ -9,15 +9,13 @@
 #include "../streams/streams.h"
 #include "AsyncBridge.hpp"
 #include "Scheduler.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
 
-#ifndef _WIN32
-#include <unistd.h>
-#endif
-
 static std::string value_to_string_simple_iostream(const Value& v) {
     if (std::holds_alternative<std::string>(v)) return std::get<std::string>(v);
     if (std::holds_alternative<double>(v)) {
@@ -33,33 +31,30 @@ static std::string value_to_string_simple_iostream(const Value& v) {
 // STDOUT/STDERR STREAM STATE
 // ============================================================================
 
+// process.stdout / process.stderr write into the same per-fd buffer as
+// chapisha (StdOutput.cpp), so the two never reorder; queued chunks leave
+// in one writev per flush.  write() returns false once STD_HIGH_WATER_MARK
+// bytes are waiting for the kernel, and "drain" follows when they are gone.
+static constexpr size_t STD_HIGH_WATER_MARK = 64 * 1024;
+
 struct StdStreamState : public std::enable_shared_from_this<StdStreamState> {
     long long id;
     int fd;            // 1 for stdout, 2 for stderr
     std::string name;  // "stdout" or "stderr"
-
-    uv_tty_t* tty_handle = nullptr;
-    uv_pipe_t* pipe_handle = nullptr;  // For non-TTY (piped) output
     bool is_tty = false;
 
-    std::atomic<bool> writing{false};
     std::atomic<bool> destroyed{false};
     std::atomic<bool> ended{false};
 
-    struct WriteChunk {
-        std::vector<char> data;
-        FunctionPtr callback;
-    };
-
-    std::deque<WriteChunk> write_queue;
-    size_t buffered_size = 0;
-    size_t high_water_mark = 16384;  // 16KB for terminal output
-    size_t bytes_written = 0;
-
-    std::atomic<bool> draining{false};
-    std::atomic<bool> corked{false};
+    // Held back between cork() and the matching uncork().
+    std::deque<std::string> corked_chunks;
+    size_t corked_bytes = 0;
+    std::vector<FunctionPtr> corked_callbacks;
     int cork_count = 0;
 
+    bool needs_drain = false;    // a write returned false
+    bool drain_pending = false;  // "drain" waits on a flush
+
     std::vector<FunctionPtr> drain_listeners;
     std::vector<FunctionPtr> finish_listeners;
     std::vector<FunctionPtr> error_listeners;
@@ -67,46 +62,10 @@ struct StdStreamState : public std::enable_shared_from_this<StdStreamState> {
 
     EnvPtr env;
     Evaluator* evaluator = nullptr;
-
-    // Keepalive
-    uv_async_t* keepalive = nullptr;
-
-    void keep_alive() {
-        if (!keepalive) {
-            keepalive = new uv_async_t;
-            uv_async_init(scheduler_get_loop(), keepalive, [](uv_async_t*) {});
-        }
-    }
-
-    void release_keepalive() {
-        if (keepalive) {
-            uv_close((uv_handle_t*)keepalive, [](uv_handle_t* h) {
-                delete (uv_async_t*)h;
-            });
-            keepalive = nullptr;
-        }
-    }
-
-    ~StdStreamState() {
-        if (tty_handle) {
-            uv_close((uv_handle_t*)tty_handle, [](uv_handle_t* h) {
-                delete (uv_tty_t*)h;
-            });
-        }
-        if (pipe_handle) {
-            uv_close((uv_handle_t*)pipe_handle, [](uv_handle_t* h) {
-                delete (uv_pipe_t*)h;
-            });
-        }
-        release_keepalive();
-    }
 };
 
 using StdStreamStatePtr = std::shared_ptr<StdStreamState>;
 
-static std::mutex g_std_streams_mutex;
-static std::unordered_map<long long, StdStreamStatePtr> g_std_streams;
-
 // ============================================================================
 // EVENT EMISSION
 // ============================================================================
@@ -141,118 +100,47 @@ static void emit_std_stream_event(StdStreamStatePtr state,
 // WRITE OPERATIONS
 // ============================================================================
 
-struct StdWriteContext {
-    StdStreamState* state;
-    StdStreamState::WriteChunk chunk;
-};
-
-static void on_std_write_complete(uv_write_t* req, int status);
-
-static void schedule_next_std_write(StdStreamStatePtr state) {
-    if (!state || state->destroyed || state->writing || state->write_queue.empty() || state->corked) {
-        return;
-    }
-
-    if (!state->tty_handle && !state->pipe_handle) {
-        emit_std_stream_event(state, state->error_listeners,
-            {Value{std::string("Stream not initialized")}});
+static void std_stream_put(StdStreamStatePtr state, std::string&& bytes) {
+    if (state->cork_count > 0) {
+        state->corked_bytes += bytes.size();
+        state->corked_chunks.push_back(std::move(bytes));
         return;
     }
-
-    state->writing = true;
-    state->keep_alive();
-    g_active_stream_operations.fetch_add(1);
-
-    StdStreamState::WriteChunk chunk = std::move(state->write_queue.front());
-    state->write_queue.pop_front();
-    state->buffered_size -= chunk.data.size();
-
-    StdWriteContext* ctx = new StdWriteContext{state.get(), std::move(chunk)};
-    uv_buf_t buf = uv_buf_init(ctx->chunk.data.data(), static_cast<unsigned int>(ctx->chunk.data.size()));
-
-    uv_write_t* req = new uv_write_t;
-    req->data = ctx;
-
-    uv_stream_t* stream = state->is_tty ? (uv_stream_t*)state->tty_handle : (uv_stream_t*)state->pipe_handle;
-
-    int result = uv_write(req, stream, &buf, 1, on_std_write_complete);
-
-    if (result < 0) {
-        delete ctx;
-        delete req;
-        state->writing = false;
-        g_active_stream_operations.fetch_sub(1);
-        emit_std_stream_event(state, state->error_listeners,
-            {Value{std::string("Write failed: ") + uv_strerror(result)}});
-        state->release_keepalive();
-    }
+    std_output_write(state->fd, std::move(bytes));
 }
 
-static void on_std_write_complete(uv_write_t* req, int status) {
-    g_active_stream_operations.fetch_sub(1);
-
-    StdWriteContext* ctx = static_cast<StdWriteContext*>(req->data);
-    if (!ctx) {
-        delete req;
-        return;
-    }
-
-    StdStreamState* raw_state = ctx->state;
-    FunctionPtr callback = ctx->chunk.callback;
-
-    StdStreamStatePtr state;
-    {
-        std::lock_guard<std::mutex> lock(g_std_streams_mutex);
-        auto it = g_std_streams.find(raw_state->id);
-        if (it != g_std_streams.end()) {
-            state = it->second;
-        }
-    }
-
-    delete ctx;
-    delete req;
-
-    if (!state || state->destroyed) {
-        return;
-    }
-
-    state->writing = false;
-
-    if (status < 0) {
-        std::string error_msg = std::string("Write error: ") + uv_strerror(status);
-        emit_std_stream_event(state, state->error_listeners, {Value{error_msg}});
-
-        if (callback) {
-            emit_std_stream_event(state, {callback}, {Value{error_msg}});
-        }
-
-        state->release_keepalive();
-        return;
-    }
+// Callbacks run once what they follow has reached the kernel.
+static void std_stream_after_flush(StdStreamStatePtr state, std::vector<FunctionPtr> callbacks) {
+    std_output_flush_async(state->fd, [state, callbacks = std::move(callbacks)]() {
+        emit_std_stream_event(state, callbacks, {});
+    });
+}
 
-    state->bytes_written += static_cast<size_t>(status);
+static size_t std_stream_length(const StdStreamStatePtr& state) {
+    return state->corked_bytes + std_output_buffered(state->fd);
+}
 
-    if (callback) {
-        emit_std_stream_event(state, {callback}, {});
-    }
+// "drain" after a write returned false, once the backlog is written.
+static void std_stream_check_drain(StdStreamStatePtr state) {
+    if (!state->needs_drain || state->drain_pending || state->cork_count > 0) return;
+    state->drain_pending = true;
+    std_output_flush_async(state->fd, [state]() {
+        state->drain_pending = false;
+        state->needs_drain = false;
+        if (!state->destroyed) emit_std_stream_event(state, state->drain_listeners, {});
+    });
+}
 
-    if (state->ended && state->write_queue.empty()) {
-        emit_std_stream_event(state, state->finish_listeners, {});
-        state->release_keepalive();
-        return;
+static void std_stream_release_cork(StdStreamStatePtr state) {
+    state->cork_count = 0;
+    while (!state->corked_chunks.empty()) {
+        std_output_write(state->fd, std::move(state->corked_chunks.front()));
+        state->corked_chunks.pop_front();
     }
-
-    if (!state->write_queue.empty() && !state->corked) {
-        schedule_next_std_write(state);
-    } else {
-        bool should_drain = state->draining;
-        state->draining = false;
-
-        if (should_drain && !state->drain_listeners.empty()) {
-            emit_std_stream_event(state, state->drain_listeners, {});
-        }
-
-        state->release_keepalive();
+    state->corked_bytes = 0;
+    if (!state->corked_callbacks.empty()) {
+        std_stream_after_flush(state, std::move(state->corked_callbacks));
+        state->corked_callbacks.clear();
     }
 }
 
@@ -260,19 +148,17 @@ static void on_std_write_complete(uv_write_t* req, int status) {
 // CONVERT VALUE TO BYTES
 // ============================================================================
 
-static std::vector<char> std_value_to_bytes(const Value& val, const std::string& encoding) {
+static std::string std_value_to_bytes(const Value& val, const std::string& encoding) {
     if (std::holds_alternative<BufferPtr>(val)) {
         auto buf = std::get<BufferPtr>(val);
-        return std::vector<char>(buf->data.begin(), buf->data.end());
+        return std::string(buf->data.begin(), buf->data.end());
     }
 
     if (std::holds_alternative<std::string>(val)) {
-        std::string str = std::get<std::string>(val);
-        return std::vector<char>(str.begin(), str.end());
+        return std::get<std::string>(val);
     }
 
-    std::string str = value_to_string_simple_iostream(val);
-    return std::vector<char>(str.begin(), str.end());
+    return value_to_string_simple_iostream(val);
 }
 
 // ============================================================================
@@ -314,33 +200,19 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
             callback = std::get<FunctionPtr>(args[2]);
         }
 
-        std::vector<char> bytes = std_value_to_bytes(data, encoding);
-
-        if (bytes.empty()) {
-            if (callback) {
-                emit_std_stream_event(state, {callback}, {});
-            }
-            return Value{true};
-        }
-
-        StdStreamState::WriteChunk chunk;
-        chunk.data = std::move(bytes);
-        chunk.callback = callback;
-
-        state->buffered_size += chunk.data.size();
-        state->write_queue.push_back(std::move(chunk));
-
-        bool needs_drain = (state->buffered_size >= state->high_water_mark);
-
-        if (needs_drain) {
-            state->draining = true;
-        }
-
-        if (!state->writing && !state->corked && !state->write_queue.empty()) {
-            schedule_next_std_write(state);
+        std::string bytes = std_value_to_bytes(data, encoding);
+        if (!bytes.empty()) std_stream_put(state, std::move(bytes));
+        if (callback) {
+            if (state->cork_count > 0)
+                state->corked_callbacks.push_back(callback);
+            else
+                std_stream_after_flush(state, {callback});
         }
 
-        return Value{!needs_drain};
+        if (std_stream_length(state) < STD_HIGH_WATER_MARK) return Value{true};
+        state->needs_drain = true;
+        std_stream_check_drain(state);
+        return Value{false};
     };
     obj->properties["write"] = {
         Value{std::make_shared<FunctionValue>("stream.write", write_impl, nullptr, tok)},
@@ -364,12 +236,8 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
             if (std::holds_alternative<FunctionPtr>(args[0])) {
                 callback = std::get<FunctionPtr>(args[0]);
             } else {
-                std::vector<char> bytes = std_value_to_bytes(args[0], "utf8");
-                if (!bytes.empty()) {
-                    StdStreamState::WriteChunk chunk;
-                    chunk.data = std::move(bytes);
-                    state->write_queue.push_back(std::move(chunk));
-                }
+                std::string bytes = std_value_to_bytes(args[0], "utf8");
+                if (!bytes.empty()) std_stream_put(state, std::move(bytes));
             }
         }
 
@@ -381,11 +249,12 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
             state->finish_listeners.push_back(callback);
         }
 
-        if (state->write_queue.empty() && !state->writing) {
+        // Corked chunks go out with the end, as uncork() would send them;
+        // "finish" follows once everything has been written.
+        std_stream_release_cork(state);
+        std_output_flush_async(state->fd, [state]() {
             emit_std_stream_event(state, state->finish_listeners, {});
-        } else if (!state->writing && !state->corked) {
-            schedule_next_std_write(state);
-        }
+        });
 
         return std::monostate{};
     };
@@ -428,7 +297,6 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
 
     // cork()
     auto cork_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        state->corked = true;
         state->cork_count++;
         return std::monostate{};
     };
@@ -443,11 +311,8 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
         }
 
         if (state->cork_count == 0) {
-            state->corked = false;
-
-            if (!state->write_queue.empty() && !state->writing) {
-                schedule_next_std_write(state);
-            }
+            std_stream_release_cork(state);
+            std_stream_check_drain(state);
         }
 
         return std::monostate{};
@@ -456,6 +321,43 @@ static ObjectPtr create_std_stream_object(StdStreamStatePtr state) {
         Value{std::make_shared<FunctionValue>("stream.uncork", uncork_impl, nullptr, tok)},
         false, false, false, tok};
 
+    // setBuffering(mode): "auto" | "line" | "full" | "none"
+    auto setBuffering_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        StdBuffering mode;
+        if (args.empty() || !std::holds_alternative<std::string>(args[0]) ||
+            !std_output_parse_buffering(std::get<std::string>(args[0]), mode)) {
+            throw SwaziError("TypeError",
+                state->name + ".setBuffering expects \"auto\", \"line\", \"full\" or \"none\"", token.loc);
+        }
+        std_output_set_buffering(state->fd, mode);
+        return std::monostate{};
+    };
+    obj->properties["setBuffering"] = {
+        Value{std::make_shared<FunctionValue>("stream.setBuffering", setBuffering_impl, nullptr, tok)},
+        false, false, false, tok};
+
+    // getBuffering() -> the mode in effect ("line", "full" or "none")
+    auto getBuffering_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        return Value{std::string(std_output_buffering_name(std_output_buffering(state->fd)))};
+    };
+    obj->properties["getBuffering"] = {
+        Value{std::make_shared<FunctionValue>("stream.getBuffering", getBuffering_impl, nullptr, tok)},
+        false, false, false, tok};
+
+    // flush([callback]): start writing everything buffered; the callback
+    // runs once it has all been written
+    auto flush_impl = [state](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        if (!args.empty() && std::holds_alternative<FunctionPtr>(args[0])) {
+            std_stream_after_flush(state, {std::get<FunctionPtr>(args[0])});
+        } else {
+            std_output_flush_async(state->fd);
+        }
+        return std::monostate{};
+    };
+    obj->properties["flush"] = {
+        Value{std::make_shared<FunctionValue>("stream.flush", flush_impl, nullptr, tok)},
+        false, false, false, tok};
+
     // isTTY property
     obj->properties["isTTY"] = {Value{state->is_tty}, false, false, true, tok};
 
@@ -484,59 +386,7 @@ static StdStreamStatePtr create_std_stream(int fd, const std::string& name, EnvP
     state->name = name;
     state->env = env;
     state->evaluator = evaluator;
-
-    uv_loop_t* loop = scheduler_get_loop();
-    if (!loop) {
-        return state;
-    }
-
-    // Check if fd is a TTY
-    uv_handle_type type = uv_guess_handle(fd);
-    state->is_tty = (type == UV_TTY);
-
-    if (state->is_tty) {
-        int duped = dup(fd);
-        if (duped >= 0) {
-            state->tty_handle = new uv_tty_t;
-            int r = uv_tty_init(loop, state->tty_handle, duped, 0);
-            if (r != 0) {
-                delete state->tty_handle;
-                state->tty_handle = nullptr;
-                close(duped);
-                state->is_tty = false;
-            } else {
-                uv_tty_set_mode(state->tty_handle, UV_TTY_MODE_NORMAL);
-            }
-        } else {
-            state->is_tty = false;
-        }
-    }
-
-    if (!state->is_tty) {
-        int duped = dup(fd);
-        if (duped >= 0) {
-            state->pipe_handle = new uv_pipe_t;
-            int r = uv_pipe_init(loop, state->pipe_handle, 0);
-            if (r != 0) {
-                delete state->pipe_handle;
-                state->pipe_handle = nullptr;
-                close(duped);
-            } else {
-                r = uv_pipe_open(state->pipe_handle, duped);
-                if (r != 0) {
-                    delete state->pipe_handle;
-                    state->pipe_handle = nullptr;
-                    close(duped);
-                }
-            }
-        }
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(g_std_streams_mutex);
-        g_std_streams[state->id] = state;
-    }
-
+    state->is_tty = uv_guess_handle(fd) == UV_TTY;
     return state;
 }
 
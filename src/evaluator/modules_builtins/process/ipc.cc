@@ -11,6 +11,7 @@
 #include "AsyncBridge.hpp"
 #include "Scheduler.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -66,9 +67,8 @@ static void schedule_pipe_callback(FunctionPtr cb, const std::vector<Value>& arg
 }
 
 // Allocate buffer for reading
-static void alloc_ipc_cb(uv_handle_t* /*handle*/, size_t suggested, uv_buf_t* buf) {
-    buf->base = (char*)malloc(suggested);
-    buf->len = static_cast<unsigned int>(suggested);
+static void alloc_ipc_cb(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+    read_pool_alloc(handle, suggested, buf);
 }
 
 // Read callback
@@ -115,62 +115,51 @@ static void pipe_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf
         }
     }
 
-    if (buf && buf->base) free(buf->base);
+    read_pool_release(buf);
 }
 
-// Helper to execute a pending write
-static void execute_write(PipeHandle* handle, const std::vector<uint8_t>& data_bytes, FunctionPtr callback) {
-    uv_buf_t buf = uv_buf_init((char*)malloc(data_bytes.size()),
-        static_cast<unsigned int>(data_bytes.size()));
-    memcpy(buf.base, data_bytes.data(), data_bytes.size());
-
-    struct WriteCtx {
-        FunctionPtr cb;
-        void* buffer;
-        PipeHandle* handle;
-    };
-
-    uv_write_t* req = new uv_write_t;
-    req->data = new WriteCtx{callback, buf.base, handle};
-
-    uv_write(req, (uv_stream_t*)handle->pipe, &buf, 1,
-        [](uv_write_t* req, int status) {
-            WriteCtx* ctx = static_cast<WriteCtx*>(req->data);
-            if (ctx->buffer) free(ctx->buffer);
-
-            if (ctx->cb) {
-                if (status < 0) {
-                    schedule_pipe_callback(ctx->cb,
-                        {Value{std::string("Write error: ") + uv_strerror(status)}});
-                } else {
-                    schedule_pipe_callback(ctx->cb, {});
-                }
-            }
+// Completion of a pipe write: user callback, then drain listeners once the
+// queue is empty.
+static void finish_write(PipeHandle* handle, FunctionPtr cb, int status) {
+    if (cb) {
+        if (status < 0) {
+            schedule_pipe_callback(cb,
+                {Value{std::string("Write error: ") + uv_strerror(status)}});
+        } else {
+            schedule_pipe_callback(cb, {});
+        }
+    }
 
-            // fire drain callbacks synchronously when queue empty
-            PipeHandle* handle = ctx->handle;
-            if (handle->pipe && handle->pipe->write_queue_size == 0 && handle->evaluator) {
-                std::vector<FunctionPtr> cbs;
-                {
-                    std::lock_guard<std::mutex> lk(handle->drain_mutex);
-                    std::swap(cbs, handle->drain_callbacks);
-                }
-                if (!cbs.empty()) {
-                    Token dtok;
-                    dtok.loc = TokenLocation("<ipc>", 0, 0, 0);
-                    for (auto& cb : cbs) {
-                        try {
-                            handle->evaluator->invoke_function(cb, {}, nullptr, dtok);
-                        } catch (const SwaziError& e) {
-                            std::cerr << "Unhandled Exception: " << e.what() << std::endl;
-                        } catch (...) {}
-                    }
-                }
+    // fire drain callbacks synchronously when queue empty
+    if (handle->pipe && handle->pipe->write_queue_size == 0 && handle->evaluator) {
+        std::vector<FunctionPtr> cbs;
+        {
+            std::lock_guard<std::mutex> lk(handle->drain_mutex);
+            std::swap(cbs, handle->drain_callbacks);
+        }
+        if (!cbs.empty()) {
+            Token dtok;
+            dtok.loc = TokenLocation("<ipc>", 0, 0, 0);
+            for (auto& cb : cbs) {
+                try {
+                    handle->evaluator->invoke_function(cb, {}, nullptr, dtok);
+                } catch (const SwaziError& e) {
+                    std::cerr << "Unhandled Exception: " << e.what() << std::endl;
+                } catch (...) {}
             }
+        }
+    }
+}
 
-            delete ctx;
-            delete req;
-        });
+// Helper to execute a pending write
+static void execute_write(PipeHandle* handle, std::vector<uint8_t> data_bytes, FunctionPtr callback) {
+    auto owned = std::make_shared<std::vector<uint8_t>>(std::move(data_bytes));
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(owned->data()),
+        static_cast<unsigned int>(owned->size()));
+
+    bool done_now = stream_write_gather((uv_stream_t*)handle->pipe, &buf, 1, owned,
+        [handle, callback](int status) { finish_write(handle, callback, status); });
+    if (done_now) finish_write(handle, callback, 0);
 }
 
 // Helper: create native function
@@ -308,7 +297,7 @@ std::shared_ptr<ObjectValue> make_ipc_exports(EnvPtr env, Evaluator* evaluator)
                     }
 
                     for (auto& pending : writes_to_execute) {
-                        execute_write(handle.get(), pending.data, pending.callback);
+                        execute_write(handle.get(), std::move(pending.data), pending.callback);
                     }
                 }
             });
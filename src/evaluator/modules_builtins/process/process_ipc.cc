@@ -1,13 +1,18 @@
 #include <atomic>
 #include <cstring>
+#include <deque>
+#include <iostream>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "../net_module/net.hpp"
 #include "AsyncBridge.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -131,8 +136,21 @@ static struct IPCState {
     std::vector<FunctionPtr> message_listeners;
 
     std::string read_buffer;  // Accumulates incoming JSON messages
+
+    // serialization: "advanced" — parent set SWAZI_IPC_SERIALIZATION=advanced.
+    // Messages are length-prefixed structured-clone frames instead of raw bytes.
+    bool advanced = false;
+    std::vector<uint8_t> frame_buffer;  // partial frame carried across reads
+    Evaluator* evaluator = nullptr;     // re-links Set / HashMap on decode
+    std::shared_ptr<StreamCork> cork;   // frames sent this tick, one write per tick
+    std::deque<uv_tcp_t*> received_handles;  // passed handles waiting for their frame
 } g_ipc_state;
 
+void process_ipc_bind_evaluator(Evaluator* evaluator) {
+    // The IPC pipes live on the main loop, so the first (main) evaluator wins.
+    if (!g_ipc_state.evaluator) g_ipc_state.evaluator = evaluator;
+}
+
 // Helper to schedule JS callback on runtime thread
 static void schedule_message_listener(FunctionPtr cb, const std::vector<Value>& args) {
     if (!cb) return;
@@ -171,14 +189,34 @@ static bool detect_forked_child() {
 }
 
 // Allocate buffer for reading
-static void alloc_ipc_cb(uv_handle_t* /*handle*/, size_t suggested, uv_buf_t* buf) {
-    buf->base = (char*)malloc(suggested);
-    buf->len = static_cast<unsigned int>(suggested);
+static void alloc_ipc_cb(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+    read_pool_alloc(handle, suggested, buf);
 }
 
 // Read callback for fd 3 (parent sends messages)
 static void ipc_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
-    if (nread > 0) {
+    if (nread > 0 && g_ipc_state.advanced) {
+        ipc_accept_handles((uv_pipe_t*)stream, g_ipc_state.received_handles);
+        std::vector<std::string> errors;
+        std::vector<Value> messages = structured_clone_unframe(g_ipc_state.frame_buffer,
+            reinterpret_cast<const uint8_t*>(buf->base), static_cast<size_t>(nread),
+            g_ipc_state.evaluator, &errors);
+        for (const std::string& err : errors) {
+            std::cerr << "[process] dropping malformed IPC frame: " << err << "\n";
+        }
+
+        std::vector<FunctionPtr> listeners;
+        {
+            std::lock_guard<std::mutex> lk(g_ipc_state.listeners_mutex);
+            listeners = g_ipc_state.message_listeners;
+        }
+        for (auto& msg : messages) {
+            std::vector<Value> cb_args = ipc_message_args(msg, g_ipc_state.received_handles);
+            for (auto& cb : listeners) {
+                if (cb) schedule_message_listener(cb, cb_args);
+            }
+        }
+    } else if (nread > 0) {
         // Create buffer from raw bytes
         auto buffer = std::make_shared<BufferValue>();
         buffer->data.assign(buf->base, buf->base + nread);
@@ -198,7 +236,7 @@ static void ipc_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
         uv_read_stop(stream);
     }
 
-    if (buf && buf->base) free(buf->base);
+    read_pool_release(buf);
 }
 
 // Initialize IPC in child process
@@ -214,6 +252,9 @@ static void initialize_child_ipc() {
 
     g_ipc_state.is_forked_child = true;
 
+    const char* ser_env = std::getenv("SWAZI_IPC_SERIALIZATION");
+    g_ipc_state.advanced = ser_env && std::strcmp(ser_env, "advanced") == 0;
+
     uv_loop_t* loop = scheduler_get_loop();
     if (!loop) {
         g_ipc_state.initialized = true;
@@ -221,8 +262,11 @@ static void initialize_child_ipc() {
     }
 
     // Open fd 3 (read from parent) as a pipe
+    // With "advanced" serialization both are IPC pipes, which can carry
+    // socket handles.
+    const int ipc_flag = g_ipc_state.advanced ? 1 : 0;
     g_ipc_state.read_pipe = new uv_pipe_t;
-    uv_pipe_init(loop, g_ipc_state.read_pipe, 0);
+    uv_pipe_init(loop, g_ipc_state.read_pipe, ipc_flag);
 
 #ifndef _WIN32
     // Unix: open existing fd 3
@@ -242,7 +286,7 @@ static void initialize_child_ipc() {
 
     // Open fd 4 (write to parent) as a pipe
     g_ipc_state.write_pipe = new uv_pipe_t;
-    uv_pipe_init(loop, g_ipc_state.write_pipe, 0);
+    uv_pipe_init(loop, g_ipc_state.write_pipe, ipc_flag);
 
 #ifndef _WIN32
     // Unix: open existing fd 4
@@ -250,6 +294,8 @@ static void initialize_child_ipc() {
     if (r != 0) {
         delete g_ipc_state.write_pipe;
         g_ipc_state.write_pipe = nullptr;
+    } else if (g_ipc_state.advanced) {
+        g_ipc_state.cork = std::make_shared<StreamCork>((uv_stream_t*)g_ipc_state.write_pipe);
     }
 #else
     // Windows: would need handle passing (TODO)
@@ -260,7 +306,7 @@ static void initialize_child_ipc() {
     g_ipc_state.initialized = true;
 }
 
-// process.send(message) - child sends message to parent
+// process.send(message, handle?) - child sends message (and a tcp socket or server) to parent
 static Value process_send(const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) {
     // Initialize IPC if not already done
     if (!g_ipc_state.initialized) {
@@ -281,6 +327,23 @@ static Value process_send(const std::vector<Value>& args, EnvPtr /*env*/, const
         return std::monostate{};
     }
 
+    // A second argument is a handle to pass along with the message.
+    if (args.size() >= 2 && !std::holds_alternative<std::monostate>(args[1])) {
+        if (!g_ipc_state.advanced) {
+            throw SwaziError("TypeError", "process.send: passing a handle requires serialization: \"advanced\"", token.loc);
+        }
+        ipc_send_handle(g_ipc_state.write_pipe, g_ipc_state.cork.get(), args[0], args[1], token);
+        return std::monostate{};
+    }
+
+    // Frames are encoded straight into the cork and leave with the rest of
+    // this tick's messages.
+    if (g_ipc_state.cork) {
+        structured_clone_frame_append(g_ipc_state.cork->pending, args[0], token);
+        g_ipc_state.cork->commit();
+        return std::monostate{};
+    }
+
     // Convert value to bytes
     std::vector<uint8_t> data_bytes;
 
@@ -306,19 +369,11 @@ static Value process_send(const std::vector<Value>& args, EnvPtr /*env*/, const
         return std::monostate{};
     }
 
-    // Send raw bytes
-    uv_buf_t buf = uv_buf_init((char*)malloc(data_bytes.size()),
-        static_cast<unsigned int>(data_bytes.size()));
-    memcpy(buf.base, data_bytes.data(), data_bytes.size());
-
-    uv_write_t* req = new uv_write_t;
-    req->data = buf.base;
-
-    uv_write(req, (uv_stream_t*)g_ipc_state.write_pipe, &buf, 1,
-        [](uv_write_t* req, int status) {
-            if (req->data) free(req->data);
-            delete req;
-        });
+    // Send raw bytes; whatever the pipe does not take now is queued in place.
+    auto owned = std::make_shared<std::vector<uint8_t>>(std::move(data_bytes));
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(owned->data()),
+        static_cast<unsigned int>(owned->size()));
+    stream_write_gather((uv_stream_t*)g_ipc_state.write_pipe, &buf, 1, owned, nullptr);
 
     return std::monostate{};
 }
@@ -692,7 +747,8 @@ static Value process_listeners(const std::vector<Value>& args, EnvPtr /*env*/, c
 // process.detach() - detach from parent terminal (daemonize)
 static Value process_detach(const std::vector<Value>& /*args*/, EnvPtr /*env*/, const Token& token) {
 #ifndef _WIN32
-    // Fork and exit parent
+    // Fork and exit parent; buffered output must not be written by both
+    std_output_flush();
     pid_t pid = fork();
     if (pid < 0) {
         throw SwaziError("RuntimeError", "Fork failed during detach", token.loc);
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <cstring>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -12,11 +14,21 @@
 
 #include "AsyncBridge.hpp"
 #include "Scheduler.hpp"
+#include "StdOutput.hpp"
+#include "StdinLines.hpp"
 #include "SwaziError.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
+#include "streams/streams.h"
 #include "uv.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 struct ListenerEntry {
     size_t id;
     FunctionPtr callback;
@@ -55,13 +67,17 @@ static void stdin_alloc_cb(uv_handle_t*, size_t suggested, uv_buf_t* buf) {
     buf->len = static_cast<unsigned int>(suggested);
 }
 
+// Helper: write terminal output at once, behind anything chapisha still
+// holds in the stdout buffer
+static void term_write(const std::string& text) {
+    std_output_write(1, text.data(), text.size());
+    std_output_flush(1);
+}
+
 // Helper: write prompt to stdout
 static void write_prompt(const std::string& prompt) {
     if (prompt.empty()) return;
-
-    // Write directly to stdout (fd 1)
-    // In production, you might want to use uv_write for async, but for prompts sync is fine
-    std::cout << prompt << std::flush;
+    term_write(prompt);
 }
 
 // Helper: enqueue data callbacks
@@ -379,13 +395,276 @@ static void cleanup_on_signal(int signum) {
     raise(signum);
 }
 
+// ============================================================================
+// BULK READING (stdin.lines / stdin.readAll)
+// ============================================================================
+//
+// For piped or redirected input, where the TTY machinery above is all
+// overhead.  stdin.lines() reads fd 0 in large blocks (a pipe once poll
+// reports it readable, a file on the threadpool) and splits them with
+// memchr; the consumer drives the reads, one block ahead, so `kwa kila`
+// over a 10 GB pipe holds about two blocks.  stdin.readAll()
+// is synchronous and maps a redirected regular file instead of reading it.
+// Both own fd 0: they cannot be mixed with on("data") / pipe().
+
+static const size_t STDIN_BLOCK_SIZE = 256 * 1024;
+
+// 0: unused, 1: interactive (on/pipe), 2: bulk (lines/readAll)
+static std::atomic<int> g_stdin_mode(0);
+
+struct StdinLineReader : public std::enable_shared_from_this<StdinLineReader> {
+    size_t block_size = STDIN_BLOCK_SIZE;
+    std::vector<char> block;  // reused: one read in flight at a time
+    LineSplitter lines;
+
+    bool reading = false;
+    bool eof = false;
+    std::string error;
+    PromisePtr waiting;
+    size_t waiting_batch = 0;
+    uv_fs_t req{};
+
+    // Pipes, sockets and terminals are read on the loop once poll reports
+    // them readable; regular files go through the threadpool.
+    bool probed = false;
+    uv_poll_t* poll = nullptr;
+
+    // A line, or with `batch` an array of up to that many lines.
+    Value take(size_t batch) {
+        if (batch == 0) return Value{lines.take()};
+        auto arr = std::make_shared<ArrayValue>();
+        size_t n = std::min(batch, lines.ready.size());
+        arr->elements.reserve(n);
+        for (size_t i = 0; i < n; ++i) arr->elements.emplace_back(lines.take());
+        return Value{arr};
+    }
+
+    Value next(size_t batch);
+    void read_ahead();
+    void read_polled(int status);
+    void on_read(ssize_t result);
+    void hold_loop();
+};
+
+// Shared by every stdin.lines() iterator, so a second loop picks up where a
+// broken-off first one stopped.
+static std::shared_ptr<StdinLineReader> g_line_reader;
+
+Value StdinLineReader::next(size_t batch) {
+    if (!lines.ready.empty()) {
+        Value v = take(batch);
+        read_ahead();
+        return v;
+    }
+    if (!error.empty()) {
+        auto p = std::make_shared<PromiseValue>();
+        p->state = PromiseValue::State::REJECTED;
+        p->result = Value{error};
+        return Value{p};
+    }
+    if (eof) return std::monostate{};
+
+    read_ahead();
+    if (eof && !lines.ready.empty()) return take(batch);
+    if (eof) return std::monostate{};
+    waiting = std::make_shared<PromiseValue>();
+    waiting->state = PromiseValue::State::PENDING;
+    waiting_batch = batch;
+    hold_loop();
+    return Value{waiting};
+}
+
+// Only a loop waiting for its next line keeps the process alive.  Reading
+// ahead for one that was broken off must not: on a pipe that never ends
+// (tail -f) the script could otherwise never exit.
+void StdinLineReader::hold_loop() {
+    if (!poll) return;
+    if (waiting)
+        uv_ref(reinterpret_cast<uv_handle_t*>(poll));
+    else
+        uv_unref(reinterpret_cast<uv_handle_t*>(poll));
+}
+
+void StdinLineReader::read_ahead() {
+    if (reading || eof || !error.empty() || lines.buffered >= block_size) return;
+    block.resize(block_size);
+
+#ifndef _WIN32
+    if (!probed) {
+        probed = true;
+        uv_handle_type type = uv_guess_handle(0);
+        if (type == UV_NAMED_PIPE || type == UV_TCP || type == UV_TTY) {
+            // uv_poll_init makes fd 0 non-blocking, which other processes
+            // sharing it would see; a read after POLLIN does not block, so
+            // the flags go back as they were.
+            int flags = fcntl(0, F_GETFL);
+            poll = new uv_poll_t;
+            if (uv_poll_init(scheduler_get_loop(), poll, 0) == 0) {
+                poll->data = this;
+                hold_loop();
+            } else {
+                delete poll;
+                poll = nullptr;
+            }
+            if (flags != -1) fcntl(0, F_SETFL, flags);
+        }
+    }
+    if (poll) {
+        reading = true;
+        uv_poll_start(poll, UV_READABLE, [](uv_poll_t* handle, int status, int) {
+            static_cast<StdinLineReader*>(handle->data)->read_polled(status);
+        });
+        return;
+    }
+#endif
+
+    uv_buf_t buf = uv_buf_init(block.data(), static_cast<unsigned int>(block.size()));
+    req.data = new std::shared_ptr<StdinLineReader>(shared_from_this());
+    reading = true;
+    g_active_stream_operations.fetch_add(1);
+    int r = uv_fs_read(scheduler_get_loop(), &req, 0, &buf, 1, -1, [](uv_fs_t* req) {
+        auto* self = static_cast<std::shared_ptr<StdinLineReader>*>(req->data);
+        std::shared_ptr<StdinLineReader> reader = std::move(*self);
+        delete self;
+        ssize_t result = req->result;
+        uv_fs_req_cleanup(req);
+        g_active_stream_operations.fetch_sub(1);
+        reader->reading = false;
+        reader->on_read(result);
+    });
+    if (r < 0) {
+        delete static_cast<std::shared_ptr<StdinLineReader>*>(req.data);
+        reading = false;
+        g_active_stream_operations.fetch_sub(1);
+        on_read(r);
+    }
+}
+
+void StdinLineReader::read_polled(int status) {
+#ifndef _WIN32
+    uv_poll_stop(poll);
+    reading = false;
+    if (status < 0) {
+        on_read(status);
+        return;
+    }
+    ssize_t n = ::read(0, block.data(), block.size());
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        read_ahead();
+        return;
+    }
+    on_read(n < 0 ? uv_translate_sys_error(errno) : n);
+#else
+    (void)status;
+#endif
+}
+
+void StdinLineReader::on_read(ssize_t result) {
+    if (result < 0) {
+        error = std::string("stdin read error: ") + uv_strerror(static_cast<int>(result));
+        if (waiting) settle_stream_promise(std::move(waiting), false, Value{error});
+        hold_loop();
+        return;
+    }
+    if (result == 0) {
+        eof = true;
+        lines.finish();
+    } else {
+        lines.push(block.data(), static_cast<size_t>(result));
+    }
+
+    if (waiting) {
+        if (!lines.ready.empty()) {
+            settle_stream_promise(std::move(waiting), true, take(waiting_batch));
+        } else if (eof) {
+            settle_stream_promise(std::move(waiting), true, std::monostate{});
+        }
+    }
+    hold_loop();
+    // A block with no newline in it leaves nothing to hand out yet, so keep
+    // reading until a line completes.
+    read_ahead();
+}
+
+void stdin_loop_shutdown(uv_loop_t* loop) {
+    if (!g_line_reader || !g_line_reader->poll || g_line_reader->poll->loop != loop) return;
+    uv_close(reinterpret_cast<uv_handle_t*>(g_line_reader->poll), [](uv_handle_t* h) {
+        delete reinterpret_cast<uv_poll_t*>(h);
+    });
+    g_line_reader->poll = nullptr;
+    g_line_reader->reading = false;
+}
+
+// Everything left on fd 0.  A regular file is mapped from the current offset
+// and the offset moved to its end; pipes and terminals are read in blocks.
+template <typename Out>
+static void slurp_stdin(Out& out, const Token& token) {
+    out.clear();
+    uv_fs_t req;
+    size_t hint = 0;
+    if (uv_fs_fstat(nullptr, &req, 0, nullptr) == 0) {
+        uv_stat_t st = req.statbuf;
+        uv_fs_req_cleanup(&req);
+#ifndef _WIN32
+        if (S_ISREG(st.st_mode)) {
+            off_t offset = lseek(0, 0, SEEK_CUR);
+            if (offset < 0) offset = 0;
+            size_t len = st.st_size > static_cast<uint64_t>(offset) ? st.st_size - offset : 0;
+            if (len == 0) return;
+            off_t base = offset & ~static_cast<off_t>(sysconf(_SC_PAGESIZE) - 1);
+            size_t skip = static_cast<size_t>(offset - base);
+            void* map = mmap(nullptr, len + skip, PROT_READ, MAP_PRIVATE, 0, base);
+            if (map != MAP_FAILED) {
+                madvise(map, len + skip, MADV_SEQUENTIAL);
+                const char* p = static_cast<const char*>(map) + skip;
+                out.assign(p, p + len);
+                munmap(map, len + skip);
+                lseek(0, offset + static_cast<off_t>(len), SEEK_SET);
+                return;
+            }
+            hint = len;
+        }
+#endif
+    } else {
+        uv_fs_req_cleanup(&req);
+    }
+
+    out.reserve(hint + 1);
+    size_t used = 0;
+    while (true) {
+        if (out.size() - used < STDIN_BLOCK_SIZE) out.resize(used + STDIN_BLOCK_SIZE);
+        uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(&out[0]) + used, static_cast<unsigned int>(out.size() - used));
+        int r = uv_fs_read(nullptr, &req, 0, &buf, 1, -1, nullptr);
+        uv_fs_req_cleanup(&req);
+        if (r == UV_EAGAIN) {
+            // fd 0 left non-blocking by a libuv handle: wait for it
+#ifndef _WIN32
+            struct pollfd pfd{0, POLLIN, 0};
+            poll(&pfd, 1, -1);
+#endif
+            continue;
+        }
+        if (r < 0) {
+            out.resize(used);
+            throw SwaziError("IOError", std::string("stdin.readAll failed: ") + uv_strerror(r), token.loc);
+        }
+        if (r == 0) break;
+        used += static_cast<size_t>(r);
+    }
+    out.resize(used);
+}
+
 std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
     auto obj = std::make_shared<ObjectValue>();
     Token tok{};
     tok.loc = TokenLocation("<stdin>", 0, 0, 0);
 
-    auto ensure_init = [&tok]() -> void {
+    auto ensure_init = [tok]() -> void {
         if (g_stdin_initialized.load()) return;
+        if (g_stdin_mode.load() == 2) {
+            throw SwaziError("RuntimeError", "stdin is being read by stdin.lines() / stdin.readAll()", tok.loc);
+        }
+        g_stdin_mode.store(1);
 
         uv_loop_t* loop = scheduler_get_loop();
         if (!loop) {
@@ -402,9 +681,8 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
 #endif
 
             std::atexit([]() {
-                std::cout << "\x1b[?25h" << std::flush;
-                std::cout << "\n"
-                          << std::flush;
+                term_write("\x1b[?25h");
+                term_write("\n");
                 if (g_stdin_handle) {
                     uv_tty_set_mode(g_stdin_handle, UV_TTY_MODE_NORMAL);
                 }
@@ -507,6 +785,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         }
 
         ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+        dest_obj->materialize();
 
         // Get the write function from destination
         auto write_it = dest_obj->properties.find("write");
@@ -1098,7 +1377,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
             throw SwaziError("TypeError", "stdin.echo requires string or buffer", token.loc);
         }
 
-        std::cout << text << std::flush;
+        term_write(text);
         return std::monostate{};
     };
     obj->properties["echo"] = {
@@ -1175,7 +1454,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         int y = static_cast<int>(std::get<double>(args[1]));
 
         std::string seq = "\x1b[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
-        std::cout << seq << std::flush;
+        term_write(seq);
 
         return std::monostate{};
     };
@@ -1211,7 +1490,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         }
 
         if (!seq.empty()) {
-            std::cout << seq << std::flush;
+            term_write(seq);
         }
 
         return std::monostate{};
@@ -1222,7 +1501,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         false, false, true, tok};
 
     auto saveCursor_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x1b[s" << std::flush;
+        term_write("\x1b[s");
         return std::monostate{};
     };
 
@@ -1231,7 +1510,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         false, false, true, tok};
 
     auto restoreCursor_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x1b[u" << std::flush;
+        term_write("\x1b[u");
         return std::monostate{};
     };
 
@@ -1240,7 +1519,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         false, false, true, tok};
 
     auto hideCursor_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x1b[?25l" << std::flush;
+        term_write("\x1b[?25l");
         return std::monostate{};
     };
 
@@ -1249,7 +1528,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         false, false, true, tok};
 
     auto showCursor_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x1b[?25h" << std::flush;
+        term_write("\x1b[?25h");
         return std::monostate{};
     };
 
@@ -1269,7 +1548,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         }
 
         std::string seq = "\x1b[" + std::to_string(mode) + "K";
-        std::cout << seq << std::flush;
+        term_write(seq);
 
         return std::monostate{};
     };
@@ -1286,7 +1565,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         }
 
         std::string seq = "\x1b[" + std::to_string(mode) + "J";
-        std::cout << seq << std::flush;
+        term_write(seq);
 
         return std::monostate{};
     };
@@ -1296,7 +1575,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         false, false, true, tok};
 
     auto clearScreenDown_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x1b[J" << std::flush;
+        term_write("\x1b[J");
         return std::monostate{};
     };
 
@@ -1317,7 +1596,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
 
         if (lines > 0) {
             std::string seq = "\x1b[" + std::to_string(lines) + "S";
-            std::cout << seq << std::flush;
+            term_write(seq);
         }
 
         return std::monostate{};
@@ -1336,7 +1615,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
 
         if (lines > 0) {
             std::string seq = "\x1b[" + std::to_string(lines) + "T";
-            std::cout << seq << std::flush;
+            term_write(seq);
         }
 
         return std::monostate{};
@@ -1351,7 +1630,7 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
     // ============================================================================
 
     auto beep_impl = [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
-        std::cout << "\x07" << std::flush;
+        term_write("\x07");
         return std::monostate{};
     };
 
@@ -1370,5 +1649,89 @@ std::shared_ptr<ObjectValue> make_stdin_exports(EnvPtr env) {
         Value{std::make_shared<FunctionValue>("stdin.isTTY", isTTY_impl, env, tok)},
         false, false, true, tok};
 
+    // ============================================================================
+    // BULK READING
+    // ============================================================================
+
+    auto claim_bulk = [](const char* name, const Token& token) {
+        if (g_stdin_mode.load() == 1) {
+            throw SwaziError("RuntimeError",
+                std::string(name) + " cannot be used once stdin is read through on()/pipe()", token.loc);
+        }
+        g_stdin_mode.store(2);
+    };
+
+    // stdin.lines(opts?) -> iterable for `kwa kila line katika stdin.lines()`
+    // opts: { batch: n } yields arrays of up to n lines instead of single
+    // lines; { blockSize: bytes } sets the read size (first call only).
+    auto lines_impl = [claim_bulk](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        size_t batch = 0;
+        size_t block_size = STDIN_BLOCK_SIZE;
+        if (!args.empty() && std::holds_alternative<ObjectPtr>(args[0])) {
+            ObjectPtr opts = std::get<ObjectPtr>(args[0]);
+            auto read_size = [&](const char* key, size_t& out) {
+                auto it = opts->properties.find(key);
+                if (it == opts->properties.end() || std::holds_alternative<std::monostate>(it->second.value)) return;
+                if (!std::holds_alternative<double>(it->second.value) || std::get<double>(it->second.value) < 1) {
+                    throw SwaziError("TypeError", std::string("stdin.lines: ") + key + " must be a positive number", token.loc);
+                }
+                out = static_cast<size_t>(std::get<double>(it->second.value));
+            };
+            read_size("batch", batch);
+            read_size("blockSize", block_size);
+        } else if (!args.empty() && !std::holds_alternative<std::monostate>(args[0])) {
+            throw SwaziError("TypeError", "stdin.lines(opts?) expects an options object", token.loc);
+        }
+        claim_bulk("stdin.lines()", token);
+
+        if (!g_line_reader) {
+            g_line_reader = std::make_shared<StdinLineReader>();
+            g_line_reader->block_size = block_size;
+        }
+        std::shared_ptr<StdinLineReader> reader = g_line_reader;
+        auto next_impl = [reader, batch](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            return reader->next(batch);
+        };
+        auto it = std::make_shared<ObjectValue>();
+        it->properties["__async_iterator__"] = {
+            Value{std::make_shared<FunctionValue>("stdin.lines.next", next_impl, nullptr, token)},
+            false, false, true, token};
+        return Value{it};
+    };
+    obj->properties["lines"] = {
+        Value{std::make_shared<FunctionValue>("stdin.lines", lines_impl, env, tok)},
+        false, false, true, tok};
+
+    // stdin.readAll(encoding?) -> string, or a Buffer for "binary" / null.
+    // Blocks until EOF; a redirected file is mapped rather than read.
+    auto readAll_impl = [claim_bulk](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        bool binary = false;
+        if (!args.empty()) {
+            if (std::holds_alternative<std::monostate>(args[0])) {
+                binary = true;
+            } else if (std::holds_alternative<std::string>(args[0])) {
+                const std::string& enc = std::get<std::string>(args[0]);
+                binary = enc == "binary" || enc == "null";
+            }
+        }
+        claim_bulk("stdin.readAll()", token);
+        if (g_line_reader) {
+            throw SwaziError("RuntimeError", "stdin.readAll() cannot be used after stdin.lines()", token.loc);
+        }
+
+        if (binary) {
+            auto buf = std::make_shared<BufferValue>();
+            slurp_stdin(buf->data, token);
+            buf->encoding = "binary";
+            return Value{buf};
+        }
+        std::string out;
+        slurp_stdin(out, token);
+        return Value{std::move(out)};
+    };
+    obj->properties["readAll"] = {
+        Value{std::make_shared<FunctionValue>("stdin.readAll", readAll_impl, env, tok)},
+        false, false, true, tok};
+
     return obj;
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include <cstring>
+
+#include "StdinLines.hpp"
+
+void LineSplitter::push(const char* p, size_t len) {
+    const char* end = p + len;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) {
+            carry.append(p, end);
+            return;
+        }
+        if (carry.empty()) {
+            // The common case: the whole line is inside this block.
+            const char* stop = (nl > p && nl[-1] == '\r') ? nl - 1 : nl;
+            ready.emplace_back(p, stop);
+        } else {
+            carry.append(p, nl);
+            if (carry.back() == '\r') carry.pop_back();
+            ready.push_back(std::move(carry));
+            carry.clear();
+        }
+        buffered += ready.back().size() + 1;
+        p = nl + 1;
+    }
+}
+
+void LineSplitter::finish() {
+    if (carry.empty()) return;
+    buffered += carry.size() + 1;
+    ready.push_back(std::move(carry));
+    carry.clear();
+}
+
+std::string LineSplitter::take() {
+    std::string line = std::move(ready.front());
+    ready.pop_front();
+    buffered -= line.size() + 1;
+    return line;
+}
@@ -795,6 +795,7 @@ static ObjectPtr create_duplex_stream_object(DuplexStreamStatePtr state) {
         }
 
         ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+        dest_obj->materialize();
 
         // Extract destination stream ID
         auto id_it = dest_obj->properties.find("_id");
@@ -0,0 +1,226 @@
+// iterator.cc - pull-based iteration over readable file streams
+//
+//   kwa kila chunk katika stream: ...
+//   kwa kila line katika stream.lines(): ...
+//
+// The loop calls the stream's `__async_iterator__` for each item (see the
+// for-in handling in StatementEval.cpp).  Reads are driven by the consumer: at
+// most one chunk is read ahead, so a loop over a multi-GB file holds about two
+// chunks however slow its body is.  An item that is already buffered is
+// returned directly and costs no suspension; lines mode serves every line of
+// a chunk that way, so the frame is only parked once per read.
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./streams.h"
+
+// ============================================================================
+// PROMISES
+// ============================================================================
+
+void settle_stream_promise(PromisePtr p, bool ok, const Value& v) {
+    if (!p || p->state != PromiseValue::State::PENDING) return;
+    p->state = ok ? PromiseValue::State::FULFILLED : PromiseValue::State::REJECTED;
+    p->result = v;
+    scheduler_enqueue_microtask([p]() {
+        auto cbs = p->state == PromiseValue::State::FULFILLED ? p->then_callbacks : p->catch_callbacks;
+        for (auto& cb : cbs) {
+            try {
+                cb(p->result);
+            } catch (...) {}
+        }
+    });
+}
+
+// ============================================================================
+// READABLE PULLER
+// ============================================================================
+
+struct ReadablePuller : public std::enable_shared_from_this<ReadablePuller> {
+    ReadableStreamStatePtr stream;
+    bool lines = false;
+
+    std::deque<BufferPtr> chunks;  // chunk mode
+    std::deque<std::string> ready;  // lines mode: complete lines
+    std::string carry;              // lines mode: the unterminated tail
+    size_t buffered = 0;
+
+    bool reading = false;
+    bool eof = false;
+    std::string error;
+    PromisePtr waiting;
+
+    uv_fs_t req{};
+
+    bool has_item() const { return lines ? !ready.empty() : !chunks.empty(); }
+
+    Value take() {
+        if (lines) {
+            std::string line = std::move(ready.front());
+            ready.pop_front();
+            buffered -= line.size();
+            return Value{std::move(line)};
+        }
+        BufferPtr buf = std::move(chunks.front());
+        chunks.pop_front();
+        buffered -= buf->data.size();
+        return encode_buffer_for_emission(buf, stream->encoding);
+    }
+
+    Value next();
+    void read_ahead();
+    void on_read(ssize_t result, std::vector<uint8_t>&& data);
+    void split_lines(const uint8_t* data, size_t len);
+    void finish_input();
+};
+
+Value ReadablePuller::next() {
+    if (has_item()) {
+        Value v = take();
+        read_ahead();
+        return v;
+    }
+    if (!error.empty()) {
+        auto p = std::make_shared<PromiseValue>();
+        p->state = PromiseValue::State::REJECTED;
+        p->result = Value{error};
+        return Value{p};
+    }
+    if (eof) return std::monostate{};
+
+    read_ahead();
+    if (has_item()) return take();  // read_ahead may have hit the end of a range
+    if (eof) return std::monostate{};
+    waiting = std::make_shared<PromiseValue>();
+    waiting->state = PromiseValue::State::PENDING;
+    return Value{waiting};
+}
+
+void ReadablePuller::read_ahead() {
+    if (reading || eof || !error.empty() || buffered >= stream->high_water_mark) return;
+    if (stream->fd < 0 || stream->destroyed || stream->current_position >= stream->stream_end) {
+        finish_input();
+        return;
+    }
+
+    size_t want = std::min(stream->high_water_mark, stream->stream_end - stream->current_position);
+    auto data = std::make_shared<std::vector<uint8_t>>(want);
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(data->data()), static_cast<unsigned int>(want));
+
+    struct ReadCtx {
+        std::shared_ptr<ReadablePuller> puller;
+        std::shared_ptr<std::vector<uint8_t>> data;
+    };
+    auto* ctx = new ReadCtx{shared_from_this(), data};
+    req.data = ctx;
+    reading = true;
+    g_active_stream_operations.fetch_add(1);
+    int r = uv_fs_read(scheduler_get_loop(), &req, stream->fd, &buf, 1,
+        static_cast<int64_t>(stream->current_position), [](uv_fs_t* req) {
+            auto* ctx = static_cast<ReadCtx*>(req->data);
+            ssize_t result = req->result;
+            uv_fs_req_cleanup(req);
+            g_active_stream_operations.fetch_sub(1);
+            std::shared_ptr<ReadablePuller> puller = std::move(ctx->puller);
+            std::vector<uint8_t> data = std::move(*ctx->data);
+            delete ctx;
+            puller->reading = false;
+            puller->on_read(result, std::move(data));
+        });
+    if (r < 0) {
+        delete ctx;
+        reading = false;
+        g_active_stream_operations.fetch_sub(1);
+        on_read(r, {});
+    }
+}
+
+void ReadablePuller::on_read(ssize_t result, std::vector<uint8_t>&& data) {
+    if (result < 0) {
+        error = std::string("Read error: ") + uv_strerror(static_cast<int>(result));
+        stream->ended = true;
+        if (stream->auto_close) stream->close_file();
+        if (waiting) settle_stream_promise(std::move(waiting), false, Value{error});
+        return;
+    }
+    if (result == 0) {
+        finish_input();
+    } else {
+        data.resize(static_cast<size_t>(result));
+        stream->current_position += static_cast<size_t>(result);
+        if (lines) {
+            split_lines(data.data(), data.size());
+        } else {
+            auto buf = std::make_shared<BufferValue>();
+            buf->data = std::move(data);
+            buf->encoding = stream->encoding;
+            buffered += buf->data.size();
+            chunks.push_back(std::move(buf));
+        }
+        if (stream->current_position >= stream->stream_end) finish_input();
+    }
+
+    if (waiting) {
+        if (has_item()) {
+            settle_stream_promise(std::move(waiting), true, take());
+        } else if (eof) {
+            settle_stream_promise(std::move(waiting), true, std::monostate{});
+            return;
+        }
+    }
+    // One chunk ahead of the consumer; a chunk with no newline in it leaves
+    // nothing to hand out yet, so keep reading until a line completes.
+    read_ahead();
+}
+
+void ReadablePuller::split_lines(const uint8_t* data, size_t len) {
+    const char* p = reinterpret_cast<const char*>(data);
+    const char* end = p + len;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) {
+            carry.append(p, end);
+            return;
+        }
+        carry.append(p, nl);
+        if (!carry.empty() && carry.back() == '\r') carry.pop_back();
+        buffered += carry.size();
+        ready.push_back(std::move(carry));
+        carry.clear();
+        p = nl + 1;
+    }
+}
+
+void ReadablePuller::finish_input() {
+    if (eof) return;
+    eof = true;
+    if (lines && !carry.empty()) {
+        buffered += carry.size();
+        ready.push_back(std::move(carry));
+        carry.clear();
+    }
+    stream->ended = true;
+    if (stream->auto_close) stream->close_file();
+}
+
+// ============================================================================
+// EXPORTS
+// ============================================================================
+
+Value make_readable_iterator(ReadableStreamStatePtr state, bool lines, const Token& token) {
+    auto puller = std::make_shared<ReadablePuller>();
+    puller->stream = state;
+    puller->lines = lines;
+
+    auto next_impl = [puller](const std::vector<Value>&, EnvPtr, const Token& token) -> Value {
+        ReadableStreamStatePtr st = puller->stream;
+        if (st->flowing) {
+            throw SwaziError("Error", "stream is already flowing through on('data') or pipe()", token.loc);
+        }
+        st->paused = true;  // keeps on('data') / pipe() reads from starting under the loop
+        return puller->next();
+    };
+    return Value{std::make_shared<FunctionValue>(lines ? "stream.lines.next" : "stream.next", next_impl, nullptr, token)};
+}
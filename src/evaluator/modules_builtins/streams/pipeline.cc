@@ -0,0 +1,641 @@
+// pipeline.cc - streams.pipeline: file and socket copies that stay native
+//
+// streams.pipeline(source, ...stages, sink[, options]) -> Promise<result>
+//
+// `readable.pipe()` hands every chunk to the interpreter as a Buffer and
+// back again through write().  A pipeline does the whole copy on the loop:
+// chunks are read with uv_fs_read (or taken from a child process's stdout
+// pipe as it arrives), run through the native stages (StreamPipeline.hpp) and
+// written with uv_fs_write or straight onto a tcp socket or a child's stdin.  Reading stops while more than `highWaterMark` bytes are waiting
+// for the sink, so memory stays bounded however slow the sink is, and the
+// script hears about it once: when the promise settles.
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#include "../net_module/net.hpp"
+#include "./streams.h"
+#include "StreamPipeline.hpp"
+#include "UvBuffers.hpp"
+
+using Bytes = std::vector<uint8_t>;
+using BytesPtr = std::shared_ptr<Bytes>;
+
+// ============================================================================
+// RUN STATE
+// ============================================================================
+
+struct PipelineRun : public std::enable_shared_from_this<PipelineRun> {
+    uv_loop_t* loop = nullptr;
+    PromisePtr promise;
+    std::shared_ptr<PipelineRun> self;  // held from start() to settle()
+
+    // Source: a file range, or a child process's stdout.
+    uv_file in_fd = -1;
+    bool own_in = false;
+    size_t position = 0;
+    size_t end = 0;
+    size_t chunk_size = 65536;
+    ReadableStreamStatePtr readable;
+    long long child_stdout = 0;
+
+    // Sink: a file, a tcp socket or a child's stdin.
+    uv_file out_fd = -1;
+    bool own_out = false;
+    WritableStreamStatePtr writable;
+    bool end_writable = true;
+    long long socket_id = 0;
+    long long child_stdin = 0;
+
+    std::vector<PipeStagePtr> stages;
+    size_t high_water_mark = 1024 * 1024;
+
+    // Output waiting for, or being written to, the sink.
+    std::deque<BytesPtr> queue;
+    size_t queued_bytes = 0;
+    size_t writes_in_flight = 0;
+
+    bool reading = false;
+    bool eof = false;
+    bool settled = false;
+    std::string error;
+
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t started_ns = 0;
+
+    uv_fs_t read_req{};
+    uv_fs_t write_req{};
+    BytesPtr read_buf;
+
+    void start();
+    void pump();
+    void on_read(ssize_t result);
+    void on_child_end(int status);
+    void consume(const uint8_t* data, size_t n, bool last);
+    void push_output(BytesPtr chunk);
+    void flush();
+    void on_written(int status, size_t len);
+    bool stream_sink() const { return socket_id || child_stdin; }
+    void fail(const std::string& why);
+    void check_done();
+    void settle();
+    Value result_value();
+};
+
+void PipelineRun::start() {
+    self = shared_from_this();
+    started_ns = uv_hrtime();
+    g_active_stream_operations.fetch_add(1);
+    if (child_stdout) {
+        std::weak_ptr<PipelineRun> weak = weak_from_this();
+        bool tapped = child_stdout_tap(
+            child_stdout,
+            [weak](const char* data, size_t len) {
+                auto run = weak.lock();
+                if (!run || run->settled || !run->error.empty()) return;
+                run->bytes_read += len;
+                run->consume(reinterpret_cast<const uint8_t*>(data), len, false);
+            },
+            [weak](int status) {
+                if (auto run = weak.lock()) run->on_child_end(status);
+            });
+        if (!tapped) {
+            fail("child stdout is already being read");
+            return;
+        }
+    }
+    pump();
+}
+
+// Issue the next read unless one is running, the input is done or the sink is
+// behind.
+void PipelineRun::pump() {
+    if (settled || !error.empty() || reading || eof) return;
+    if (child_stdout) {
+        // The child's chunks arrive as it writes them; while the sink is
+        // behind the pipe is not read and the child blocks.
+        child_stdout_flow(child_stdout, queued_bytes < high_water_mark);
+        return;
+    }
+    if (queued_bytes >= high_water_mark) return;  // flush() calls back in as the queue drains
+
+    size_t want = chunk_size;
+    if (end) want = std::min(want, end - position);
+    if (want == 0) {
+        on_read(0);
+        return;
+    }
+    read_buf = std::make_shared<Bytes>(want);
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(read_buf->data()), static_cast<unsigned int>(want));
+    read_req.data = this;
+    reading = true;
+    int r = uv_fs_read(loop, &read_req, in_fd, &buf, 1, static_cast<int64_t>(position), [](uv_fs_t* req) {
+        auto* run = static_cast<PipelineRun*>(req->data);
+        ssize_t result = req->result;
+        uv_fs_req_cleanup(req);
+        run->reading = false;
+        run->on_read(result);
+    });
+    if (r < 0) {
+        reading = false;
+        fail(std::string("read failed: ") + uv_strerror(r));
+    }
+}
+
+void PipelineRun::on_read(ssize_t result) {
+    if (!error.empty()) {
+        check_done();
+        return;
+    }
+    if (result < 0) {
+        fail(std::string("read failed: ") + uv_strerror(static_cast<int>(result)));
+        return;
+    }
+
+    size_t n = static_cast<size_t>(result);
+    position += n;
+    bytes_read += n;
+    bool last = n == 0 || (end && position >= end);
+
+    if (last && readable) {
+        readable->current_position = position;
+        readable->ended = true;
+    }
+    // consume() may issue the next read into a new read_buf
+    BytesPtr chunk = std::move(read_buf);
+    if (stages.empty() && n) {
+        // the read buffer is queued as it is
+        chunk->resize(n);
+        push_output(std::move(chunk));
+        n = 0;
+    }
+    consume(chunk ? chunk->data() : nullptr, n, last);
+}
+
+void PipelineRun::on_child_end(int status) {
+    if (settled) return;
+    if (status < 0) {
+        fail(std::string("read failed: ") + uv_strerror(status));
+        return;
+    }
+    consume(nullptr, 0, true);
+}
+
+// Runs `n` input bytes through the stages and queues what comes out; `last`
+// finishes the stages and marks the input done.
+void PipelineRun::consume(const uint8_t* data, size_t n, bool last) {
+    if (!error.empty()) {
+        check_done();
+        return;
+    }
+    if (stages.empty()) {
+        if (n) push_output(std::make_shared<Bytes>(data, data + n));
+    } else {
+        // Each stage's output is the next one's input; at the end every stage
+        // is finished in order, so what one flushes still goes through the rest.
+        Bytes a, b;
+        const uint8_t* in = data;
+        size_t in_len = n;
+        for (auto& stage : stages) {
+            b.clear();
+            bool ok = stage->write(in, in_len, b);
+            if (ok && last) ok = stage->finish(b);
+            if (!ok) {
+                fail(std::string(stage->name()) + ": " + stage->error());
+                return;
+            }
+            a.swap(b);
+            in = a.data();
+            in_len = a.size();
+        }
+        if (in_len) push_output(std::make_shared<Bytes>(std::move(a)));
+    }
+
+    if (last) eof = true;
+    flush();
+    pump();
+    check_done();
+}
+
+void PipelineRun::push_output(BytesPtr chunk) {
+    queued_bytes += chunk->size();
+    queue.push_back(std::move(chunk));
+}
+
+// Hand queued output to the sink: one uv_fs_write at a time for files, which
+// keeps the bytes in order; everything at once for a socket, which orders its
+// own write queue.
+void PipelineRun::flush() {
+    if (!error.empty()) return;
+
+    if (stream_sink()) {
+        while (!queue.empty()) {
+            uv_stream_t* stream = socket_id ? tcp_socket_stream(socket_id) : child_stdin_stream(child_stdin);
+            if (!stream || !uv_is_writable(stream)) {
+                fail(socket_id ? "socket closed" : "child stdin closed");
+                return;
+            }
+            BytesPtr chunk = std::move(queue.front());
+            queue.pop_front();
+            size_t len = chunk->size();
+            uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(chunk->data()), static_cast<unsigned int>(len));
+            writes_in_flight++;
+            std::weak_ptr<PipelineRun> weak = weak_from_this();
+            bool now = stream_write_gather(stream, &buf, 1, chunk, [weak, len](int status) {
+                if (auto run = weak.lock()) run->on_written(status, len);
+            });
+            if (now) {
+                writes_in_flight--;
+                queued_bytes -= len;
+                bytes_written += len;
+            }
+        }
+        return;
+    }
+
+    if (writes_in_flight || queue.empty()) return;
+    BytesPtr chunk = queue.front();
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(chunk->data()), static_cast<unsigned int>(chunk->size()));
+    write_req.data = this;
+    writes_in_flight++;
+    int r = uv_fs_write(loop, &write_req, out_fd, &buf, 1, -1, [](uv_fs_t* req) {
+        auto* run = static_cast<PipelineRun*>(req->data);
+        ssize_t result = req->result;
+        uv_fs_req_cleanup(req);
+        BytesPtr done = std::move(run->queue.front());
+        run->queue.pop_front();
+        if (result >= 0 && static_cast<size_t>(result) < done->size()) {
+            // Short write: put the rest back at the front.
+            auto rest = std::make_shared<Bytes>(done->begin() + result, done->end());
+            run->queue.push_front(rest);
+            run->queued_bytes -= static_cast<size_t>(result);
+            run->bytes_written += static_cast<uint64_t>(result);
+            run->writes_in_flight--;
+            run->flush();
+            return;
+        }
+        run->on_written(result < 0 ? static_cast<int>(result) : 0, done->size());
+    });
+    if (r < 0) {
+        writes_in_flight--;
+        fail(std::string("write failed: ") + uv_strerror(r));
+    }
+}
+
+void PipelineRun::on_written(int status, size_t len) {
+    writes_in_flight--;
+    queued_bytes -= len;
+    if (status < 0) {
+        fail(std::string("write failed: ") + uv_strerror(status));
+        return;
+    }
+    bytes_written += len;
+    flush();
+    pump();
+    check_done();
+}
+
+void PipelineRun::fail(const std::string& why) {
+    if (error.empty()) error = why;
+    // Output not yet handed to the sink is dropped; a file write in flight
+    // still owns the front of the queue.
+    size_t keep = !stream_sink() && writes_in_flight ? 1 : 0;
+    while (queue.size() > keep) queue.pop_back();
+    check_done();
+}
+
+// Settles once the input is done (or failed) and nothing is left to write;
+// the fds are only closed when no request still uses them.
+void PipelineRun::check_done() {
+    if (settled || reading || writes_in_flight) return;
+    if (error.empty() && (!eof || !queue.empty())) return;
+    settle();
+}
+
+static void close_fd(uv_loop_t* loop, uv_file fd) {
+    uv_fs_t req;
+    uv_fs_close(loop, &req, fd, NULL);
+    uv_fs_req_cleanup(&req);
+}
+
+void PipelineRun::settle() {
+    settled = true;
+    g_active_stream_operations.fetch_sub(1);
+    std::shared_ptr<PipelineRun> hold = std::move(self);  // released on return
+
+    if (own_in) close_fd(loop, in_fd);
+    if (own_out) close_fd(loop, out_fd);
+    // A failed run lets whatever the child still writes drain (unread) rather
+    // than leave it blocked on a full pipe.
+    if (child_stdout) child_stdout_flow(child_stdout, true);
+    if (child_stdin && end_writable && error.empty()) child_stdin_end(child_stdin);
+
+    if (readable) {
+        readable->ended = true;
+        if (readable->auto_close) readable->close_file();
+        readable->release_keepalive();
+    }
+    if (writable) {
+        writable->bytes_written += static_cast<size_t>(bytes_written);
+        if (end_writable && error.empty()) {
+            writable->ended = true;
+            writable->finished = true;
+            emit_writable_event_sync(writable, writable->finish_listeners, {});
+            if (writable->auto_destroy) {
+                writable->close_file();
+                emit_writable_event_sync(writable, writable->close_listeners, {});
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        promise->state = PromiseValue::State::REJECTED;
+        promise->result = Value{"streams.pipeline: " + error};
+    } else {
+        promise->state = PromiseValue::State::FULFILLED;
+        promise->result = result_value();
+    }
+    PromisePtr p = promise;
+    scheduler_enqueue_microtask([p]() {
+        auto cbs = p->state == PromiseValue::State::FULFILLED ? p->then_callbacks : p->catch_callbacks;
+        for (auto& cb : cbs) {
+            try {
+                cb(p->result);
+            } catch (...) {}
+        }
+    });
+}
+
+static void set_field(const ObjectPtr& o, const std::string& key, Value v) {
+    o->properties[key] = {std::move(v), false, false, true, Token{}};
+}
+
+Value PipelineRun::result_value() {
+    PipeStats stats;
+    for (auto& stage : stages) stage->report(stats);
+
+    auto out = std::make_shared<ObjectValue>();
+    set_field(out, "bytesRead", Value{static_cast<double>(bytes_read)});
+    set_field(out, "bytesWritten", Value{static_cast<double>(bytes_written)});
+    set_field(out, "durationMs", Value{static_cast<double>(uv_hrtime() - started_ns) / 1e6});
+    if (stats.counted_lines) set_field(out, "lines", Value{static_cast<double>(stats.lines)});
+    if (!stats.digests.empty()) {
+        set_field(out, "digest", Value{stats.digests.back()});
+        if (stats.digests.size() > 1) {
+            auto all = std::make_shared<ArrayValue>();
+            for (auto& d : stats.digests) all->elements.push_back(Value{d});
+            set_field(out, "digests", Value{all});
+        }
+    }
+    return Value{out};
+}
+
+// ============================================================================
+// ARGUMENTS
+// ============================================================================
+
+static const PropertyDescriptor* find_prop(const ObjectPtr& o, const std::string& key) {
+    auto it = o->properties.find(key);
+    return it == o->properties.end() ? nullptr : &it->second;
+}
+
+static bool is_stage(const Value& v) {
+    return std::holds_alternative<ObjectPtr>(v) && find_prop(std::get<ObjectPtr>(v), "_pipeStage");
+}
+
+static bool is_options(const Value& v) {
+    if (!std::holds_alternative<ObjectPtr>(v)) return false;
+    const ObjectPtr& o = std::get<ObjectPtr>(v);
+    return !find_prop(o, "_pipeStage") && !find_prop(o, "_id") && !find_prop(o, "_socketId") &&
+           !find_prop(o, "_childStdout") && !find_prop(o, "_childStdin");
+}
+
+static double number_field(const ObjectPtr& o, const std::string& key, double fallback) {
+    auto* p = find_prop(o, key);
+    return p && std::holds_alternative<double>(p->value) ? std::get<double>(p->value) : fallback;
+}
+
+static PipeStagePtr build_stage(const ObjectPtr& o, const Token& token) {
+    auto* kind_p = find_prop(o, "kind");
+    std::string kind = kind_p && std::holds_alternative<std::string>(kind_p->value) ? std::get<std::string>(kind_p->value) : "";
+    PipeStagePtr stage;
+    if (kind == "gzip" || kind == "deflate") {
+        auto format = kind == "gzip" ? ZlibStream::Format::Gzip : ZlibStream::Format::Deflate;
+        stage = make_compress_stage(format, static_cast<int>(number_field(o, "level", 6)));
+        if (!stage) throw SwaziError("Error", "streams.pipeline: built without zlib", token.loc);
+    } else if (kind == "gunzip") {
+        stage = make_decompress_stage();
+        if (!stage) throw SwaziError("Error", "streams.pipeline: built without zlib", token.loc);
+    } else if (kind == "hash") {
+        auto* a = find_prop(o, "algorithm");
+        stage = make_hash_stage(a && std::holds_alternative<std::string>(a->value) ? std::get<std::string>(a->value) : "");
+    } else if (kind == "lines") {
+        stage = make_lines_stage(static_cast<size_t>(number_field(o, "maxLine", 1024 * 1024)));
+    } else if (kind == "encrypt" || kind == "decrypt") {
+        auto* k = find_prop(o, "key");
+        Bytes key;
+        if (k && std::holds_alternative<BufferPtr>(k->value)) key = std::get<BufferPtr>(k->value)->data;
+        size_t record = static_cast<size_t>(number_field(o, "recordSize", PIPE_CIPHER_RECORD_SIZE));
+        stage = kind == "encrypt" ? make_encrypt_stage(key, record) : make_decrypt_stage(key, record);
+    }
+    if (!stage) throw SwaziError("TypeError", "streams.pipeline: invalid '" + kind + "' stage", token.loc);
+    return stage;
+}
+
+static uv_file open_path(const std::string& path, int flags, const Token& token) {
+    uv_fs_t req;
+    int fd = uv_fs_open(scheduler_get_loop(), &req, path.c_str(), flags, 0644, NULL);
+    uv_fs_req_cleanup(&req);
+    if (fd < 0) {
+        throw SwaziError("IOError", "Failed to open file '" + path + "': " + uv_strerror(fd), token.loc);
+    }
+    return fd;
+}
+
+static long long object_id(const ObjectPtr& o, const char* key) {
+    auto* p = find_prop(o, key);
+    return p && std::holds_alternative<double>(p->value) ? static_cast<long long>(std::get<double>(p->value)) : 0;
+}
+
+static void bind_source(PipelineRun& run, const Value& v, const Token& token) {
+    if (std::holds_alternative<std::string>(v)) {
+        run.in_fd = open_path(std::get<std::string>(v), O_RDONLY, token);
+        run.own_in = true;
+        return;
+    }
+    if (std::holds_alternative<ObjectPtr>(v)) {
+        if (long long cid = object_id(std::get<ObjectPtr>(v), "_childStdout")) {
+            // paused until start() takes the pipe over
+            if (!child_stdout_flow(cid, false)) {
+                throw SwaziError("Error", "streams.pipeline: child stdout has ended", token.loc);
+            }
+            run.child_stdout = cid;
+            return;
+        }
+        long long id = object_id(std::get<ObjectPtr>(v), "_id");
+        ReadableStreamStatePtr state;
+        {
+            std::lock_guard<std::mutex> lock(g_readable_streams_mutex);
+            auto it = g_readable_streams.find(id);
+            if (it != g_readable_streams.end()) state = it->second;
+        }
+        if (state) {
+            if (state->destroyed || state->ended || state->fd < 0) {
+                throw SwaziError("Error", "streams.pipeline: source stream has ended", token.loc);
+            }
+            if (state->flowing || state->reading) {
+                throw SwaziError("Error", "streams.pipeline: source stream is already flowing", token.loc);
+            }
+            state->paused = true;  // its own reads stay off; the pipeline reads the fd
+            state->keep_alive();
+            run.readable = state;
+            run.in_fd = state->fd;
+            run.position = state->current_position;
+            run.end = state->stream_end;
+            run.chunk_size = state->high_water_mark;
+            return;
+        }
+    }
+    throw SwaziError("TypeError", "streams.pipeline: source must be a path, a readable file stream or a child's stdout", token.loc);
+}
+
+static void bind_sink(PipelineRun& run, const Value& v, const Token& token) {
+    if (std::holds_alternative<std::string>(v)) {
+        run.out_fd = open_path(std::get<std::string>(v), O_WRONLY | O_CREAT | O_TRUNC, token);
+        run.own_out = true;
+        return;
+    }
+    if (std::holds_alternative<ObjectPtr>(v)) {
+        const ObjectPtr& o = std::get<ObjectPtr>(v);
+        if (long long sid = object_id(o, "_socketId")) {
+            if (!tcp_socket_stream(sid)) {
+                throw SwaziError("Error", "streams.pipeline: socket is not connected", token.loc);
+            }
+            run.socket_id = sid;
+            return;
+        }
+        if (long long cid = object_id(o, "_childStdin")) {
+            if (!child_stdin_stream(cid)) {
+                throw SwaziError("Error", "streams.pipeline: child stdin has ended", token.loc);
+            }
+            run.child_stdin = cid;
+            return;
+        }
+        WritableStreamStatePtr state;
+        {
+            std::lock_guard<std::mutex> lock(g_writable_streams_mutex);
+            auto it = g_writable_streams.find(object_id(o, "_id"));
+            if (it != g_writable_streams.end()) state = it->second;
+        }
+        if (state) {
+            if (state->destroyed || state->ended || state->fd < 0) {
+                throw SwaziError("Error", "streams.pipeline: sink stream has ended", token.loc);
+            }
+            if (state->writing || !state->write_queue.empty()) {
+                throw SwaziError("Error", "streams.pipeline: sink stream has writes pending", token.loc);
+            }
+            run.writable = state;
+            run.out_fd = state->fd;
+            return;
+        }
+    }
+    throw SwaziError("TypeError", "streams.pipeline: sink must be a path, a writable file stream, a tcp socket or a child's stdin", token.loc);
+}
+
+// streams.pipeline(source, ...stages, sink[, { highWaterMark, chunkSize, end }])
+Value native_streamsPipeline(const std::vector<Value>& args, EnvPtr, Evaluator*, const Token& token) {
+    std::vector<Value> parts = args;
+    ObjectPtr opts;
+    if (parts.size() >= 3 && is_options(parts.back())) {
+        opts = std::get<ObjectPtr>(parts.back());
+        parts.pop_back();
+    }
+    if (parts.size() < 2) {
+        throw SwaziError("TypeError", "streams.pipeline requires a source and a sink", token.loc);
+    }
+
+    auto run = std::make_shared<PipelineRun>();
+    for (size_t i = 1; i + 1 < parts.size(); i++) {
+        if (!is_stage(parts[i])) {
+            throw SwaziError("TypeError", "streams.pipeline: argument " + std::to_string(i + 1) +
+                                              " is not a pipeline stage (streams.gzip(), streams.hash(), ...)",
+                token.loc);
+        }
+        run->stages.push_back(build_stage(std::get<ObjectPtr>(parts[i]), token));
+    }
+    if (opts) {
+        double hwm = number_field(opts, "highWaterMark", 0);
+        if (hwm > 0) run->high_water_mark = static_cast<size_t>(hwm);
+        double chunk = number_field(opts, "chunkSize", 0);
+        if (chunk > 0) run->chunk_size = static_cast<size_t>(std::min(chunk, 16.0 * 1024 * 1024));
+        auto* e = find_prop(opts, "end");
+        if (e && std::holds_alternative<bool>(e->value)) run->end_writable = std::get<bool>(e->value);
+    }
+
+    run->loop = scheduler_get_loop();
+    if (!run->loop) throw SwaziError("RuntimeError", "No event loop available", token.loc);
+
+    bind_source(*run, parts.front(), token);
+    try {
+        bind_sink(*run, parts.back(), token);
+    } catch (...) {
+        if (run->own_in) close_fd(run->loop, run->in_fd);
+        if (run->readable) run->readable->release_keepalive();
+        if (run->child_stdout) child_stdout_flow(run->child_stdout, true);
+        throw;
+    }
+
+    run->promise = std::make_shared<PromiseValue>();
+    run->promise->state = PromiseValue::State::PENDING;
+    PromisePtr promise = run->promise;
+    scheduler_run_on_loop([run]() { run->start(); });
+    return Value{promise};
+}
+
+// ============================================================================
+// STAGE FACTORIES
+// ============================================================================
+
+// Stages are plain descriptions; every pipeline builds its own codec state
+// from them, so one stage value can be used in several pipelines.
+static ObjectPtr stage_object(const std::string& kind) {
+    auto o = std::make_shared<ObjectValue>();
+    set_field(o, "_pipeStage", Value{true});
+    set_field(o, "kind", Value{kind});
+    return o;
+}
+
+static void copy_number_option(const std::vector<Value>& args, size_t at, const ObjectPtr& stage, const std::string& key) {
+    if (args.size() <= at || !std::holds_alternative<ObjectPtr>(args[at])) return;
+    auto* p = find_prop(std::get<ObjectPtr>(args[at]), key);
+    if (p && std::holds_alternative<double>(p->value)) set_field(stage, key, p->value);
+}
+
+Value native_streamsStage(const std::string& kind, const std::vector<Value>& args, const Token& token) {
+    ObjectPtr stage = stage_object(kind);
+    if (kind == "gzip" || kind == "deflate") {
+        copy_number_option(args, 0, stage, "level");
+    } else if (kind == "lines") {
+        copy_number_option(args, 0, stage, "maxLine");
+    } else if (kind == "hash") {
+        std::string algorithm = !args.empty() && std::holds_alternative<std::string>(args[0]) ? std::get<std::string>(args[0]) : "sha256";
+        if (!make_hash_stage(algorithm)) {
+            throw SwaziError("TypeError", "streams.hash: unsupported algorithm '" + algorithm + "' (sha256, sha512, blake2b)", token.loc);
+        }
+        set_field(stage, "algorithm", Value{algorithm});
+    } else if (kind == "encrypt" || kind == "decrypt") {
+        if (args.empty() || !std::holds_alternative<BufferPtr>(args[0]) || std::get<BufferPtr>(args[0])->data.size() != 32) {
+            throw SwaziError("TypeError", "streams." + kind + " requires a 32-byte key Buffer", token.loc);
+        }
+        set_field(stage, "key", args[0]);
+        copy_number_option(args, 1, stage, "recordSize");
+    }
+    return Value{stage};
+}
@@ -0,0 +1,319 @@
+// pipeline_stages.cc - native transforms behind StreamPipeline.hpp
+#include "StreamPipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(HAVE_LIBSODIUM)
+#include <sodium.h>
+#else
+#error "stream pipeline stages require libsodium"
+#endif
+
+// ── compression ──────────────────────────────────────────────────────────────
+
+class ZlibStage : public PipeStage {
+   public:
+    ZlibStage(std::unique_ptr<ZlibStream> z, bool decoding) : z_(std::move(z)), decoding_(decoding) {}
+
+    const char* name() const override { return decoding_ ? "gunzip" : "gzip"; }
+
+    bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        if (z_->write(data, len, out)) return true;
+        error_ = z_->error();
+        return false;
+    }
+
+    bool finish(std::vector<uint8_t>& out) override {
+        if (!z_->finish(out)) {
+            error_ = z_->error();
+            return false;
+        }
+        if (decoding_ && !z_->done()) {
+            error_ = "unexpected end of compressed data";
+            return false;
+        }
+        return true;
+    }
+
+   private:
+    std::unique_ptr<ZlibStream> z_;
+    bool decoding_;
+};
+
+PipeStagePtr make_compress_stage(ZlibStream::Format format, int level) {
+    auto z = ZlibStream::encoder(format, level);
+    if (!z) return nullptr;
+    return std::make_unique<ZlibStage>(std::move(z), false);
+}
+
+PipeStagePtr make_decompress_stage() {
+    auto z = ZlibStream::decoder();
+    if (!z) return nullptr;
+    return std::make_unique<ZlibStage>(std::move(z), true);
+}
+
+// ── hashing ──────────────────────────────────────────────────────────────────
+
+class HashStage : public PipeStage {
+   public:
+    explicit HashStage(std::string algorithm) : algorithm_(std::move(algorithm)) {
+        if (algorithm_ == "sha256") {
+            crypto_hash_sha256_init(&sha256_);
+        } else if (algorithm_ == "sha512") {
+            crypto_hash_sha512_init(&sha512_);
+        } else {
+            crypto_generichash_init(&blake2b_, nullptr, 0, crypto_generichash_BYTES);
+        }
+    }
+
+    const char* name() const override { return "hash"; }
+
+    bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        if (algorithm_ == "sha256") {
+            crypto_hash_sha256_update(&sha256_, data, len);
+        } else if (algorithm_ == "sha512") {
+            crypto_hash_sha512_update(&sha512_, data, len);
+        } else {
+            crypto_generichash_update(&blake2b_, data, len);
+        }
+        out.insert(out.end(), data, data + len);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t>&) override {
+        std::vector<uint8_t> digest;
+        if (algorithm_ == "sha256") {
+            digest.resize(crypto_hash_sha256_BYTES);
+            crypto_hash_sha256_final(&sha256_, digest.data());
+        } else if (algorithm_ == "sha512") {
+            digest.resize(crypto_hash_sha512_BYTES);
+            crypto_hash_sha512_final(&sha512_, digest.data());
+        } else {
+            digest.resize(crypto_generichash_BYTES);
+            crypto_generichash_final(&blake2b_, digest.data(), digest.size());
+        }
+        std::string hex(digest.size() * 2 + 1, '\0');
+        sodium_bin2hex(hex.data(), hex.size(), digest.data(), digest.size());
+        hex.pop_back();
+        hex_ = std::move(hex);
+        return true;
+    }
+
+    void report(PipeStats& stats) const override { stats.digests.push_back(hex_); }
+
+   private:
+    std::string algorithm_;
+    std::string hex_;
+    crypto_hash_sha256_state sha256_;
+    crypto_hash_sha512_state sha512_;
+    crypto_generichash_state blake2b_;
+};
+
+PipeStagePtr make_hash_stage(const std::string& algorithm) {
+    if (algorithm != "sha256" && algorithm != "sha512" && algorithm != "blake2b") return nullptr;
+    if (sodium_init() < 0) return nullptr;
+    return std::make_unique<HashStage>(algorithm);
+}
+
+// ── line splitting ───────────────────────────────────────────────────────────
+
+class LinesStage : public PipeStage {
+   public:
+    explicit LinesStage(size_t max_line) : max_line_(std::max<size_t>(max_line, 1)) {}
+
+    const char* name() const override { return "lines"; }
+
+    bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        const uint8_t* end = data + len;
+        const uint8_t* last_nl = nullptr;
+        for (const uint8_t* p = data; p < end; p++) {
+            p = static_cast<const uint8_t*>(std::memchr(p, '\n', end - p));
+            if (!p) break;
+            lines_++;
+            last_nl = p;
+        }
+        if (!last_nl) {
+            tail_.insert(tail_.end(), data, end);
+            if (tail_.size() >= max_line_) {
+                out.insert(out.end(), tail_.begin(), tail_.end());
+                tail_.clear();
+            }
+            return true;
+        }
+        out.insert(out.end(), tail_.begin(), tail_.end());
+        tail_.clear();
+        out.insert(out.end(), data, last_nl + 1);
+        tail_.assign(last_nl + 1, end);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t>& out) override {
+        if (!tail_.empty()) {
+            lines_++;  // an unterminated last line still counts
+            out.insert(out.end(), tail_.begin(), tail_.end());
+            tail_.clear();
+        }
+        return true;
+    }
+
+    void report(PipeStats& stats) const override {
+        stats.counted_lines = true;
+        stats.lines = lines_;
+    }
+
+   private:
+    size_t max_line_;
+    uint64_t lines_ = 0;
+    std::vector<uint8_t> tail_;
+};
+
+PipeStagePtr make_lines_stage(size_t max_line) {
+    return std::make_unique<LinesStage>(max_line);
+}
+
+// ── encryption ───────────────────────────────────────────────────────────────
+
+static constexpr size_t HEADER_BYTES = crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+static constexpr size_t A_BYTES = crypto_secretstream_xchacha20poly1305_ABYTES;
+
+class EncryptStage : public PipeStage {
+   public:
+    EncryptStage(const std::vector<uint8_t>& key, size_t record_size) : record_size_(record_size) {
+        std::memcpy(key_, key.data(), sizeof(key_));
+        pending_.reserve(record_size_);
+    }
+    ~EncryptStage() override { sodium_memzero(key_, sizeof(key_)); }
+
+    const char* name() const override { return "encrypt"; }
+
+    bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        start(out);
+        while (len > 0) {
+            // A full record is only sealed once more input shows it is not the last.
+            if (pending_.size() == record_size_) seal(out, crypto_secretstream_xchacha20poly1305_TAG_MESSAGE);
+            size_t take = std::min(len, record_size_ - pending_.size());
+            pending_.insert(pending_.end(), data, data + take);
+            data += take;
+            len -= take;
+        }
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t>& out) override {
+        start(out);
+        seal(out, crypto_secretstream_xchacha20poly1305_TAG_FINAL);
+        return true;
+    }
+
+   private:
+    void start(std::vector<uint8_t>& out) {
+        if (started_) return;
+        started_ = true;
+        size_t old = out.size();
+        out.resize(old + HEADER_BYTES);
+        crypto_secretstream_xchacha20poly1305_init_push(&state_, out.data() + old, key_);
+    }
+
+    void seal(std::vector<uint8_t>& out, unsigned char tag) {
+        size_t old = out.size();
+        out.resize(old + pending_.size() + A_BYTES);
+        unsigned long long written = 0;
+        crypto_secretstream_xchacha20poly1305_push(&state_, out.data() + old, &written,
+            pending_.data(), pending_.size(), nullptr, 0, tag);
+        out.resize(old + static_cast<size_t>(written));
+        pending_.clear();
+    }
+
+    unsigned char key_[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+    size_t record_size_;
+    bool started_ = false;
+    std::vector<uint8_t> pending_;
+    crypto_secretstream_xchacha20poly1305_state state_;
+};
+
+class DecryptStage : public PipeStage {
+   public:
+    DecryptStage(const std::vector<uint8_t>& key, size_t record_size) : record_bytes_(record_size + A_BYTES) {
+        std::memcpy(key_, key.data(), sizeof(key_));
+    }
+    ~DecryptStage() override { sodium_memzero(key_, sizeof(key_)); }
+
+    const char* name() const override { return "decrypt"; }
+
+    bool write(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        pending_.insert(pending_.end(), data, data + len);
+        size_t pos = 0;
+        if (!started_) {
+            if (pending_.size() < HEADER_BYTES) return true;
+            if (crypto_secretstream_xchacha20poly1305_init_pull(&state_, pending_.data(), key_) != 0) {
+                error_ = "invalid encryption header";
+                return false;
+            }
+            started_ = true;
+            pos = HEADER_BYTES;
+        }
+        // Keep the last full record back: only finish() knows it is the final one.
+        while (pending_.size() - pos > record_bytes_) {
+            if (!open(pending_.data() + pos, record_bytes_, out)) return false;
+            pos += record_bytes_;
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + pos);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t>& out) override {
+        if (finished_) return true;
+        if (!started_ || pending_.size() < A_BYTES) {
+            error_ = "encrypted data is truncated";
+            return false;
+        }
+        if (!open(pending_.data(), pending_.size(), out)) return false;
+        pending_.clear();
+        if (!finished_) {
+            error_ = "encrypted data is truncated";
+            return false;
+        }
+        return true;
+    }
+
+   private:
+    bool open(const uint8_t* record, size_t len, std::vector<uint8_t>& out) {
+        if (finished_) {
+            error_ = "data after the final encrypted record";
+            return false;
+        }
+        size_t old = out.size();
+        out.resize(old + len - A_BYTES);
+        unsigned long long plain = 0;
+        unsigned char tag = 0;
+        if (crypto_secretstream_xchacha20poly1305_pull(&state_, out.data() + old, &plain, &tag,
+                record, len, nullptr, 0) != 0) {
+            out.resize(old);
+            error_ = "decryption failed: wrong key or corrupted data";
+            return false;
+        }
+        out.resize(old + static_cast<size_t>(plain));
+        if (tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL) finished_ = true;
+        return true;
+    }
+
+    unsigned char key_[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+    size_t record_bytes_;
+    bool started_ = false;
+    bool finished_ = false;
+    std::vector<uint8_t> pending_;
+    crypto_secretstream_xchacha20poly1305_state state_;
+};
+
+PipeStagePtr make_encrypt_stage(const std::vector<uint8_t>& key, size_t record_size) {
+    if (key.size() != crypto_secretstream_xchacha20poly1305_KEYBYTES || record_size == 0) return nullptr;
+    if (sodium_init() < 0) return nullptr;
+    return std::make_unique<EncryptStage>(key, record_size);
+}
+
+PipeStagePtr make_decrypt_stage(const std::vector<uint8_t>& key, size_t record_size) {
+    if (key.size() != crypto_secretstream_xchacha20poly1305_KEYBYTES || record_size == 0) return nullptr;
+    if (sodium_init() < 0) return nullptr;
+    return std::make_unique<DecryptStage>(key, record_size);
+}
@@ -533,6 +533,7 @@ ObjectPtr create_readable_stream_object(ReadableStreamStatePtr state) {
         }
 
         ObjectPtr dest_obj = std::get<ObjectPtr>(args[0]);
+        dest_obj->materialize();  // e.g. an http res, whose methods are bound lazily
 
         // Extract destination stream ID
         auto id_it = dest_obj->properties.find("_id");
@@ -697,6 +698,16 @@ ObjectPtr create_readable_stream_object(ReadableStreamStatePtr state) {
         Value(std::make_shared<FunctionValue>("stream.pipe", pipe_impl, nullptr, tok)),
         false, false, true, tok};
 
+    // kwa kila chunk katika stream / kwa kila line katika stream.lines()
+    obj->properties["__async_iterator__"] = {make_readable_iterator(state, false, tok), false, false, true, tok};
+
+    auto lines_impl = [state](const std::vector<Value>&, EnvPtr, const Token& token) -> Value {
+        auto it = std::make_shared<ObjectValue>();
+        it->properties["__async_iterator__"] = {make_readable_iterator(state, true, token), false, false, true, token};
+        return Value{it};
+    };
+    obj->properties["lines"] = {Value{std::make_shared<FunctionValue>("stream.lines", lines_impl, nullptr, tok)}, false, false, true, tok};
+
     return obj;
 }
 
@@ -110,6 +110,30 @@ std::shared_ptr<ObjectValue> make_streams_exports(EnvPtr env, Evaluator* evaluat
         Value{std::make_shared<FunctionValue>("streams.createDuplex", createDuplex, env, tok)},
         false, false, true, tok};
 
+    auto createTransform = [evaluator](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+        return native_createTransform(args, env, evaluator, token);
+    };
+    obj->properties["createTransform"] = {
+        Value{std::make_shared<FunctionValue>("streams.createTransform", createTransform, env, tok)},
+        false, false, true, tok};
+
+    auto pipeline = [evaluator](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+        return native_streamsPipeline(args, env, evaluator, token);
+    };
+    obj->properties["pipeline"] = {
+        Value{std::make_shared<FunctionValue>("streams.pipeline", pipeline, env, tok)},
+        false, false, true, tok};
+
+    for (const char* kind : {"gzip", "deflate", "gunzip", "hash", "lines", "encrypt", "decrypt"}) {
+        std::string name = kind;
+        auto factory = [name](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            return native_streamsStage(name, args, token);
+        };
+        obj->properties[name] = {
+            Value{std::make_shared<FunctionValue>("streams." + name, factory, env, tok)},
+            false, false, true, tok};
+    }
+
     return obj;
 }
 
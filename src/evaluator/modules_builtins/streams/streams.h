@@ -213,6 +213,29 @@ Value implement_pipe(ReadableStreamStatePtr readable_state,
 
 Value native_createDuplexStream(const std::vector<Value>& args, EnvPtr env, Evaluator* evaluator, const Token& token);
 
+// ============================================================================
+// ITERATION AND TRANSFORMS (iterator.cc, transform.cc)
+// ============================================================================
+
+// Settles `p` and runs its continuations from the microtask queue.
+void settle_stream_promise(PromisePtr p, bool ok, const Value& v);
+
+// The `__async_iterator__` pull function of a readable stream: each call
+// returns the next chunk (or line), a Promise of it, or null at the end.
+Value make_readable_iterator(ReadableStreamStatePtr state, bool lines, const Token& token);
+
+Value native_createTransform(const std::vector<Value>& args, EnvPtr env, Evaluator* evaluator, const Token& token);
+
+// ============================================================================
+// NATIVE PIPELINE (pipeline.cc)
+// ============================================================================
+
+Value native_streamsPipeline(const std::vector<Value>& args, EnvPtr env, Evaluator* evaluator, const Token& token);
+
+// A stage description for streams.pipeline: "gzip", "deflate", "gunzip",
+// "hash", "lines", "encrypt" or "decrypt".
+Value native_streamsStage(const std::string& kind, const std::vector<Value>& args, const Token& token);
+
 void emit_writable_event_sync(WritableStreamStatePtr state,
     const std::vector<FunctionPtr>& listeners,
     const std::vector<Value>& args);
@@ -0,0 +1,501 @@
+// transform.cc - streams.createTransform(fn, [options])
+//
+//   data t = streams.createTransform((chunks) => chunks.map((c) => c.juu()), { maxBatch: 256 })
+//   r.pipe(t).pipe(w)
+//
+// Written chunks queue on the input side, and `fn` receives them as an array:
+// everything queued since its last call, up to `maxBatch` chunks and
+// `highWaterMark` bytes.  A producer that writes faster than the transform
+// runs therefore costs one interpreter call per batch rather than one per
+// chunk.  `fn` returns an array of output chunks, a single chunk, null for
+// nothing, or a Promise of any of those.
+//
+// Output goes to 'data' listeners, to a `kwa kila` loop pulling the stream,
+// or into a queue.  When nobody consumes and the queue holds `highWaterMark`
+// bytes, batches stop running; the input then fills and write() returns false
+// until 'drain'.
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./streams.h"
+
+// ============================================================================
+// TRANSFORM STREAM STATE
+// ============================================================================
+
+struct TransformStreamState : public std::enable_shared_from_this<TransformStreamState> {
+    long long id;
+
+    FunctionPtr transform_fn;
+    FunctionPtr flush_fn;
+
+    size_t high_water_mark = 65536;
+    size_t max_batch = 64;
+
+    std::deque<Value> input;
+    size_t input_bytes = 0;
+    std::deque<Value> output;
+    size_t output_bytes = 0;
+
+    bool scheduled = false;   // a batch worker is queued
+    bool processing = false;  // fn (or flush) is running or its Promise is pending
+    bool paused = false;      // a pipe destination asked us to wait
+    bool need_drain = false;  // write() returned false
+    bool ending = false;      // end() called; input closes after the queue empties
+    bool finished = false;    // every batch and flush ran
+    bool ended = false;       // 'end' emitted
+    bool destroyed = false;
+    std::string error;
+
+    PromisePtr waiting;  // a `kwa kila` pull with nothing to hand out yet
+
+    EnvPtr env;
+    Evaluator* evaluator = nullptr;
+
+    std::vector<FunctionPtr> data_listeners;
+    std::vector<FunctionPtr> end_listeners;
+    std::vector<FunctionPtr> drain_listeners;
+    std::vector<FunctionPtr> finish_listeners;
+    std::vector<FunctionPtr> error_listeners;
+    std::vector<FunctionPtr> close_listeners;
+};
+
+using TransformStreamStatePtr = std::shared_ptr<TransformStreamState>;
+
+static void schedule_batch(TransformStreamStatePtr state);
+
+static size_t chunk_bytes(const Value& v) {
+    if (std::holds_alternative<std::string>(v)) return std::get<std::string>(v).size();
+    if (std::holds_alternative<BufferPtr>(v)) {
+        auto buf = std::get<BufferPtr>(v);
+        return buf ? buf->data.size() : 0;
+    }
+    return 1;
+}
+
+static void emit_transform_event_sync(TransformStreamStatePtr state,
+    const std::vector<FunctionPtr>& listeners,
+    const std::vector<Value>& args) {
+    Token tok{};
+    tok.loc = TokenLocation("<transform-event>", 0, 0, 0);
+    auto snapshot = listeners;  // a listener may register another
+    for (const auto& cb : snapshot) {
+        if (!cb) continue;
+        try {
+            state->evaluator->invoke_function(cb, args, state->env, tok);
+        } catch (const std::exception& e) {
+            std::cerr << "Unhandled error in stream listener: " << e.what() << std::endl;
+        }
+    }
+}
+
+static void fail(TransformStreamStatePtr state, const std::string& message) {
+    if (!state->error.empty() || state->destroyed) return;
+    state->error = message;
+    state->processing = false;
+    state->input.clear();
+    state->input_bytes = 0;
+    if (state->waiting) settle_stream_promise(std::move(state->waiting), false, Value{message});
+    if (state->error_listeners.empty()) {
+        std::cerr << "Unhandled error in stream listener: " << message << std::endl;
+    } else {
+        emit_transform_event_sync(state, state->error_listeners, {Value{message}});
+    }
+}
+
+static bool has_consumer(const TransformStreamStatePtr& state) {
+    return !state->data_listeners.empty() && !state->paused;
+}
+
+static void emit_end(TransformStreamStatePtr state) {
+    if (state->ended) return;
+    state->ended = true;
+    if (state->waiting) settle_stream_promise(std::move(state->waiting), true, std::monostate{});
+    emit_transform_event_sync(state, state->end_listeners, {});
+    emit_transform_event_sync(state, state->close_listeners, {});
+}
+
+// Hands queued output to 'data' listeners while they keep accepting it.
+static void flush_output(TransformStreamStatePtr state) {
+    while (!state->output.empty() && has_consumer(state)) {
+        Value v = std::move(state->output.front());
+        state->output.pop_front();
+        state->output_bytes -= chunk_bytes(v);
+        emit_transform_event_sync(state, state->data_listeners, {v});
+    }
+    if (state->output.empty() && state->finished) emit_end(state);
+}
+
+static void push_output(TransformStreamStatePtr state, const Value& v) {
+    if (std::holds_alternative<std::monostate>(v)) return;
+    if (state->output.empty() && has_consumer(state)) {
+        emit_transform_event_sync(state, state->data_listeners, {v});
+    } else if (state->output.empty() && state->waiting) {
+        settle_stream_promise(std::move(state->waiting), true, v);
+    } else {
+        state->output_bytes += chunk_bytes(v);
+        state->output.push_back(v);
+    }
+}
+
+static void deliver(TransformStreamStatePtr state, const Value& result) {
+    if (!state->error.empty()) return;
+    if (std::holds_alternative<ArrayPtr>(result)) {
+        auto arr = std::get<ArrayPtr>(result);
+        if (arr) {
+            for (const auto& v : arr->elements) push_output(state, v);
+        }
+    } else {
+        push_output(state, result);
+    }
+}
+
+static void finish(TransformStreamStatePtr state) {
+    state->finished = true;
+    emit_transform_event_sync(state, state->finish_listeners, {});
+    flush_output(state);
+    if (state->output.empty()) emit_end(state);
+}
+
+// Runs `fn` (or the flush function) and delivers what it returns, now or
+// once its Promise settles.
+static void run_user_fn(TransformStreamStatePtr state, FunctionPtr fn, const std::vector<Value>& args, bool is_flush) {
+    Token tok{};
+    tok.loc = TokenLocation("<transform>", 0, 0, 0);
+    state->processing = true;
+
+    auto done = [state, is_flush](const Value& result) {
+        state->processing = false;
+        deliver(state, result);
+        if (!state->error.empty()) return;
+        if (is_flush) {
+            finish(state);
+        } else {
+            schedule_batch(state);
+        }
+    };
+
+    Value result;
+    try {
+        result = state->evaluator->invoke_function(fn, args, state->env, tok);
+    } catch (const std::exception& e) {
+        fail(state, e.what());
+        return;
+    }
+
+    if (!std::holds_alternative<PromisePtr>(result)) {
+        done(result);
+        return;
+    }
+    PromisePtr p = std::get<PromisePtr>(result);
+    p->handled = true;
+    auto on_error = [state](Value reason) {
+        fail(state, value_to_string_simple(reason).empty() ? "transform rejected" : value_to_string_simple(reason));
+    };
+    if (p->state == PromiseValue::State::FULFILLED) {
+        done(p->result);
+    } else if (p->state == PromiseValue::State::REJECTED) {
+        on_error(p->result);
+    } else {
+        p->then_callbacks.push_back([done](Value v) { done(v); });
+        p->catch_callbacks.push_back(on_error);
+    }
+}
+
+static void process_batch(TransformStreamStatePtr state) {
+    state->scheduled = false;
+    if (state->processing || state->destroyed || !state->error.empty() || state->finished) return;
+    // Nobody is reading and the output queue is full: leave the input queued.
+    if (state->output_bytes >= state->high_water_mark) return;
+
+    if (state->input.empty()) {
+        if (!state->ending) return;
+        if (state->flush_fn) {
+            run_user_fn(state, state->flush_fn, {}, true);
+        } else {
+            finish(state);
+        }
+        return;
+    }
+
+    auto batch = std::make_shared<ArrayValue>();
+    size_t bytes = 0;
+    while (!state->input.empty() && batch->elements.size() < state->max_batch &&
+           (batch->elements.empty() || bytes + chunk_bytes(state->input.front()) <= state->high_water_mark)) {
+        bytes += chunk_bytes(state->input.front());
+        batch->elements.push_back(std::move(state->input.front()));
+        state->input.pop_front();
+    }
+    state->input_bytes -= bytes;
+
+    if (state->need_drain && state->input_bytes < state->high_water_mark) {
+        state->need_drain = false;
+        emit_transform_event_sync(state, state->drain_listeners, {});
+    }
+
+    run_user_fn(state, state->transform_fn, {Value{batch}}, false);
+}
+
+// Batches run from the callback queue, so chunks written in one tick share a call.
+static void schedule_batch(TransformStreamStatePtr state) {
+    if (state->scheduled || state->processing || state->destroyed || state->finished) return;
+    if (state->input.empty() && !state->ending) return;
+    state->scheduled = true;
+    auto worker = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        process_batch(state);
+        return std::monostate{};
+    };
+    schedule_listener_call(std::make_shared<FunctionValue>("transform_worker", worker, nullptr, Token()), {});
+}
+
+// ============================================================================
+// STREAM OBJECT
+// ============================================================================
+
+static ObjectPtr create_transform_stream_object(TransformStreamStatePtr state) {
+    auto obj = std::make_shared<ObjectValue>();
+    Token tok{};
+    tok.loc = TokenLocation("<transform>", 0, 0, 0);
+
+    auto write_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (state->destroyed) {
+            throw SwaziError("Error", "Cannot write to destroyed stream", token.loc);
+        }
+        if (state->ending) {
+            throw SwaziError("Error", "Cannot write after end", token.loc);
+        }
+        if (args.empty()) {
+            throw SwaziError("TypeError", "write() requires data argument", token.loc);
+        }
+        if (!state->error.empty()) return Value{false};
+
+        state->input_bytes += chunk_bytes(args[0]);
+        state->input.push_back(args[0]);
+        schedule_batch(state);
+
+        if (state->input_bytes >= state->high_water_mark) {
+            state->need_drain = true;
+            return Value{false};
+        }
+        return Value{true};
+    };
+    obj->properties["write"] = {Value{std::make_shared<FunctionValue>("transform.write", write_impl, nullptr, tok)}, false, false, true, tok};
+
+    auto end_impl = [state](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        if (state->ending || state->destroyed) return std::monostate{};
+        if (!args.empty() && !std::holds_alternative<std::monostate>(args[0])) {
+            state->input_bytes += chunk_bytes(args[0]);
+            state->input.push_back(args[0]);
+        }
+        state->ending = true;
+        schedule_batch(state);
+        return std::monostate{};
+    };
+    obj->properties["end"] = {Value{std::make_shared<FunctionValue>("transform.end", end_impl, nullptr, tok)}, false, false, true, tok};
+
+    auto on_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.size() < 2 || !std::holds_alternative<std::string>(args[0]) ||
+            !std::holds_alternative<FunctionPtr>(args[1])) {
+            throw SwaziError("TypeError", "on(event, callback) requires an event name and a function", token.loc);
+        }
+        const std::string& event = std::get<std::string>(args[0]);
+        FunctionPtr cb = std::get<FunctionPtr>(args[1]);
+
+        if (event == "data") {
+            state->data_listeners.push_back(cb);
+            // Output queued before the first listener goes out on the next tick.
+            auto kick = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+                flush_output(state);
+                schedule_batch(state);
+                return std::monostate{};
+            };
+            schedule_listener_call(std::make_shared<FunctionValue>("transform_flow", kick, nullptr, Token()), {});
+        } else if (event == "end") {
+            state->end_listeners.push_back(cb);
+        } else if (event == "drain") {
+            state->drain_listeners.push_back(cb);
+        } else if (event == "finish") {
+            state->finish_listeners.push_back(cb);
+        } else if (event == "error") {
+            state->error_listeners.push_back(cb);
+        } else if (event == "close") {
+            state->close_listeners.push_back(cb);
+        }
+        return std::monostate{};
+    };
+    obj->properties["on"] = {Value{std::make_shared<FunctionValue>("transform.on", on_impl, nullptr, tok)}, false, false, true, tok};
+
+    auto destroy_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        if (state->destroyed) return std::monostate{};
+        state->destroyed = true;
+        state->input.clear();
+        state->output.clear();
+        state->input_bytes = state->output_bytes = 0;
+        if (state->waiting) settle_stream_promise(std::move(state->waiting), true, std::monostate{});
+        emit_transform_event_sync(state, state->close_listeners, {});
+        return std::monostate{};
+    };
+    obj->properties["destroy"] = {Value{std::make_shared<FunctionValue>("transform.destroy", destroy_impl, nullptr, tok)}, false, false, true, tok};
+
+    // pipe(dest, [{end}]): output goes to dest.write(); a false return holds
+    // further output until dest emits 'drain'.
+    auto pipe_impl = [state](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+        if (args.empty() || !std::holds_alternative<ObjectPtr>(args[0])) {
+            throw SwaziError("TypeError", "transform.pipe(dest) requires a writable stream as destination", token.loc);
+        }
+        ObjectPtr dest = std::get<ObjectPtr>(args[0]);
+        dest->materialize();
+
+        bool end_on_finish = true;
+        if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+            auto opts = std::get<ObjectPtr>(args[1]);
+            auto end_it = opts->properties.find("end");
+            if (end_it != opts->properties.end() && std::holds_alternative<bool>(end_it->second.value)) {
+                end_on_finish = std::get<bool>(end_it->second.value);
+            }
+        }
+
+        auto method = [dest](const char* name) -> FunctionPtr {
+            auto it = dest->properties.find(name);
+            if (it == dest->properties.end() || !std::holds_alternative<FunctionPtr>(it->second.value)) return nullptr;
+            return std::get<FunctionPtr>(it->second.value);
+        };
+        FunctionPtr write_fn = method("write");
+        if (!write_fn) {
+            throw SwaziError("TypeError", "pipe destination has no write() method", token.loc);
+        }
+        FunctionPtr end_fn = method("end");
+        FunctionPtr on_fn = method("on");
+
+        Token evt_tok{};
+        evt_tok.loc = TokenLocation("<transform-pipe>", 0, 0, 0);
+
+        auto data_handler = [state, dest, write_fn](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+            if (args.empty()) return std::monostate{};
+            Value r = state->evaluator->call_function_with_receiver_public(write_fn, dest, {args[0]}, env, token);
+            if (std::holds_alternative<bool>(r) && !std::get<bool>(r)) state->paused = true;
+            return std::monostate{};
+        };
+        state->data_listeners.push_back(std::make_shared<FunctionValue>("transform.pipe.data", data_handler, nullptr, evt_tok));
+
+        if (on_fn) {
+            auto drain_handler = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+                if (!state->paused) return std::monostate{};
+                state->paused = false;
+                flush_output(state);
+                schedule_batch(state);
+                return std::monostate{};
+            };
+            auto drain = std::make_shared<FunctionValue>("transform.pipe.drain", drain_handler, nullptr, evt_tok);
+            state->evaluator->call_function_with_receiver_public(on_fn, dest, {Value{std::string("drain")}, Value{drain}}, env, evt_tok);
+        }
+
+        if (end_on_finish && end_fn) {
+            auto end_handler = [state, dest, end_fn](const std::vector<Value>&, EnvPtr env, const Token& token) -> Value {
+                return state->evaluator->call_function_with_receiver_public(end_fn, dest, {}, env, token);
+            };
+            state->end_listeners.push_back(std::make_shared<FunctionValue>("transform.pipe.end", end_handler, nullptr, evt_tok));
+        }
+
+        auto kick = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            flush_output(state);
+            schedule_batch(state);
+            return std::monostate{};
+        };
+        schedule_listener_call(std::make_shared<FunctionValue>("transform_flow", kick, nullptr, Token()), {});
+        return Value{dest};
+    };
+    obj->properties["pipe"] = {Value{std::make_shared<FunctionValue>("transform.pipe", pipe_impl, nullptr, tok)}, false, false, true, tok};
+
+    // kwa kila chunk katika transform: pulls one output chunk at a time.
+    auto next_impl = [state](const std::vector<Value>&, EnvPtr, const Token& token) -> Value {
+        if (!state->data_listeners.empty()) {
+            throw SwaziError("Error", "stream is already flowing through on('data') or pipe()", token.loc);
+        }
+        if (!state->output.empty()) {
+            Value v = std::move(state->output.front());
+            state->output.pop_front();
+            state->output_bytes -= chunk_bytes(v);
+            schedule_batch(state);
+            return v;
+        }
+        if (!state->error.empty()) {
+            auto p = std::make_shared<PromiseValue>();
+            p->state = PromiseValue::State::REJECTED;
+            p->result = Value{state->error};
+            return Value{p};
+        }
+        if (state->finished || state->destroyed) {
+            emit_end(state);
+            return std::monostate{};
+        }
+        state->waiting = std::make_shared<PromiseValue>();
+        state->waiting->state = PromiseValue::State::PENDING;
+        schedule_batch(state);
+        return Value{state->waiting};
+    };
+    obj->properties["__async_iterator__"] = {Value{std::make_shared<FunctionValue>("transform.next", next_impl, nullptr, tok)}, false, false, true, tok};
+
+    auto is_ended_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        return Value{state->ended};
+    };
+    obj->properties["isEnded"] = {Value{std::make_shared<FunctionValue>("transform.isEnded", is_ended_impl, nullptr, tok)}, false, true, true, tok};
+
+    auto is_finished_impl = [state](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+        return Value{state->finished};
+    };
+    obj->properties["isFinished"] = {Value{std::make_shared<FunctionValue>("transform.isFinished", is_finished_impl, nullptr, tok)}, false, true, true, tok};
+
+    obj->properties["highWaterMark"] = {Value{static_cast<double>(state->high_water_mark)}, false, false, true, tok};
+    obj->properties["maxBatch"] = {Value{static_cast<double>(state->max_batch)}, false, false, true, tok};
+    obj->properties["_id"] = {Value{static_cast<double>(state->id)}, false, false, true, tok};
+
+    auto events_arr = std::make_shared<ArrayValue>();
+    for (const char* e : {"data", "end", "drain", "finish", "error", "close"}) {
+        events_arr->elements.push_back(Value(std::string(e)));
+    }
+    obj->properties["_events"] = {events_arr, false, false, true, tok};
+
+    return obj;
+}
+
+// ============================================================================
+// FACTORY
+// ============================================================================
+
+Value native_createTransform(const std::vector<Value>& args, EnvPtr env, Evaluator* evaluator, const Token& token) {
+    if (args.empty() || !std::holds_alternative<FunctionPtr>(args[0])) {
+        throw SwaziError("TypeError", "streams.createTransform requires a transform function", token.loc);
+    }
+
+    auto state = std::make_shared<TransformStreamState>();
+    state->id = g_next_stream_id.fetch_add(1);
+    state->transform_fn = std::get<FunctionPtr>(args[0]);
+    state->env = env;
+    state->evaluator = evaluator;
+
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) {
+        ObjectPtr opts = std::get<ObjectPtr>(args[1]);
+        auto hwm_it = opts->properties.find("highWaterMark");
+        if (hwm_it != opts->properties.end() && std::holds_alternative<double>(hwm_it->second.value)) {
+            double v = std::get<double>(hwm_it->second.value);
+            if (v < 1) throw SwaziError("RangeError", "highWaterMark must be at least 1", token.loc);
+            state->high_water_mark = static_cast<size_t>(v);
+        }
+        auto batch_it = opts->properties.find("maxBatch");
+        if (batch_it != opts->properties.end() && std::holds_alternative<double>(batch_it->second.value)) {
+            double v = std::get<double>(batch_it->second.value);
+            if (v < 1) throw SwaziError("RangeError", "maxBatch must be at least 1", token.loc);
+            state->max_batch = static_cast<size_t>(v);
+        }
+        auto flush_it = opts->properties.find("flush");
+        if (flush_it != opts->properties.end() && std::holds_alternative<FunctionPtr>(flush_it->second.value)) {
+            state->flush_fn = std::get<FunctionPtr>(flush_it->second.value);
+        }
+    }
+
+    return Value{create_transform_stream_object(state)};
+}
@@ -1,8 +1,14 @@
 // Place this file at: src/evaluator/modules_builtins/subprocess.cpp
 // Build with -luv (project already links libuv)
 // Implements a minimal subprocess builtin with exec, spawn, fork.
-// - exec(cmd[, cb]) -> Promise resolving { stdout, stderr, code } OR if cb provided calls cb(err, result).
-// - spawn(cmd, ...args) -> returns a child object with .stdout/.stderr objects that have .on(event, cb)
+// - exec(cmd[, options][, cb]) -> Promise resolving { stdout, stderr, code } OR if cb provided calls cb(err, result).
+//   Output is collected natively and capped at options.maxBuffer bytes (default 64 MiB, 0 = no cap);
+//   past the cap the child is killed and the promise rejects.  It settles when the shell exits and
+//   its output has drained, or EXEC_DRAIN_MS after the exit if a background job still holds the pipes.
+// - spawn(cmd, ...args) -> returns a child object with .stdout/.stderr objects that have .on(event, cb),
+//   pause() and resume(); stdin.write() returns false past its high-water mark and emits "drain".
+// - pipeline([[cmd, ...args], ...][, options]) -> children joined stdout-to-stdin by OS pipes, so
+//   `a | b | c` runs without the data passing through the interpreter.
 // - fork(script, [...args]) -> spawn the same interpreter with provided script and return child with .send(msg) and 'message' listener
 //
 // This implementation uses libuv (uv_spawn + pipes) and the AsyncBridge bridge functions:
@@ -12,7 +18,9 @@
 
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -27,7 +35,9 @@
 #endif
 
 #include "AsyncBridge.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -74,14 +84,13 @@ static std::string value_to_string_simple_local(const Value& v) {
 static std::mutex g_children_mutex;
 static std::atomic<long long> g_next_child_id{1};
 
-struct WriteCallbackData {
-    FunctionPtr cb;
-    void* buffer;
-};
-struct EndWriteData {
-    void* buffer;
-    uv_pipe_t* pipe;
-};
+// exec/execSync output cap unless options.maxBuffer says otherwise.
+static constexpr size_t DEFAULT_MAX_BUFFER = 64 * 1024 * 1024;
+// After the shell exits, exec waits this long for EOF before closing the
+// pipes itself (`exec("server &")` leaves them open in the background job).
+static constexpr uint64_t EXEC_DRAIN_MS = 100;
+// stdin.write() returns false once this much is queued for the child.
+static constexpr size_t STDIN_HIGH_WATER_MARK = 64 * 1024;
 
 struct ChildEntry {
     long long id;
@@ -93,9 +102,30 @@ struct ChildEntry {
     std::mutex listeners_mutex;
     std::vector<FunctionPtr> stdout_data_listeners;
     std::vector<FunctionPtr> stderr_data_listeners;
+    std::vector<FunctionPtr> stdout_end_listeners;
+    std::vector<FunctionPtr> stderr_end_listeners;
+    std::vector<FunctionPtr> stdin_drain_listeners;
     std::vector<FunctionPtr> exit_listeners;
+    std::vector<FunctionPtr> close_listeners;
     std::vector<FunctionPtr> message_listeners;  // for fork IPC
 
+    // Native consumers (exec, streams.pipeline) take output here instead of
+    // through the "data" listeners, so it never becomes a script value.
+    std::function<void(const char*, size_t)> stdout_sink;
+    std::function<void(const char*, size_t)> stderr_sink;
+    std::function<void(int)> stdout_end_hook;
+    // Run once the child has exited and its output pipes have hit EOF.
+    std::vector<std::function<void(int64_t, int)>> close_hooks;
+    // Run when the child exits, whether or not its pipes are done.
+    std::vector<std::function<void()>> exit_hooks;
+
+    bool stdout_paused = false;
+    bool stderr_paused = false;
+    bool stdin_needs_drain = false;
+
+    bool exited = false;
+    int64_t exit_status = 0;
+    int term_signal = 0;
     bool closed = false;
 };
 static std::unordered_map<long long, std::shared_ptr<ChildEntry>> g_children;
@@ -107,15 +137,213 @@ static void schedule_listener_call(FunctionPtr cb, const std::vector<Value>& arg
     enqueue_callback_global(static_cast<void*>(p));
 }
 
+static void emit_child_event(ChildEntry* entry, const std::vector<FunctionPtr>& list, const std::vector<Value>& args) {
+    std::vector<FunctionPtr> listeners;
+    {
+        std::lock_guard<std::mutex> lk(entry->listeners_mutex);
+        listeners = list;
+    }
+    for (auto& cb : listeners) schedule_listener_call(cb, args);
+}
+
+static std::shared_ptr<ChildEntry> find_child(long long id) {
+    std::lock_guard<std::mutex> lk(g_children_mutex);
+    auto it = g_children.find(id);
+    return it == g_children.end() ? nullptr : it->second;
+}
+
+// ---------- output pipes ----------
+
+static void stdout_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+static void stderr_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+
+static void start_output_reads(ChildEntry* entry, bool is_stdout) {
+    uv_pipe_t* pipe = is_stdout ? entry->stdout_pipe : entry->stderr_pipe;
+    if (!pipe) return;
+    uv_read_start((uv_stream_t*)pipe, read_pool_alloc, is_stdout ? stdout_read_cb : stderr_read_cb);
+}
+
+// pause()/resume(): while paused nothing is read, the OS pipe fills and the
+// child blocks in write() until the reader catches up.
+static void set_output_flowing(ChildEntry* entry, bool is_stdout, bool flowing) {
+    bool& paused = is_stdout ? entry->stdout_paused : entry->stderr_paused;
+    if (paused == !flowing) return;
+    paused = !flowing;
+    uv_pipe_t* pipe = is_stdout ? entry->stdout_pipe : entry->stderr_pipe;
+    if (!pipe) return;
+    if (flowing) {
+        start_output_reads(entry, is_stdout);
+    } else {
+        uv_read_stop((uv_stream_t*)pipe);
+    }
+}
+
+// "close" comes after "exit": the child is gone and everything it wrote has
+// been delivered.  Only then is the entry dropped from g_children.
+static void maybe_close(ChildEntry* entry) {
+    if (!entry->exited || entry->closed || entry->stdout_pipe || entry->stderr_pipe) return;
+    entry->closed = true;
+
+    auto hooks = std::move(entry->close_hooks);
+    entry->close_hooks.clear();
+    for (auto& hook : hooks) hook(entry->exit_status, entry->term_signal);
+    emit_child_event(entry, entry->close_listeners,
+        {Value{static_cast<double>(entry->exit_status)}, Value{static_cast<double>(entry->term_signal)}});
+
+    std::shared_ptr<ChildEntry> hold;  // released on return
+    std::lock_guard<std::mutex> lk(g_children_mutex);
+    auto it = g_children.find(entry->id);
+    if (it != g_children.end()) {
+        hold = it->second;
+        g_children.erase(it);
+    }
+}
+
+static void close_output(ChildEntry* entry, bool is_stdout, int status) {
+    uv_pipe_t*& pipe = is_stdout ? entry->stdout_pipe : entry->stderr_pipe;
+    if (!pipe) return;
+    uv_read_stop((uv_stream_t*)pipe);
+    uv_close((uv_handle_t*)pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
+    pipe = nullptr;
+
+    if (is_stdout && entry->stdout_end_hook) {
+        auto hook = std::move(entry->stdout_end_hook);
+        entry->stdout_end_hook = nullptr;
+        entry->stdout_sink = nullptr;
+        hook(status == UV_EOF ? 0 : status);
+    } else {
+        emit_child_event(entry, is_stdout ? entry->stdout_end_listeners : entry->stderr_end_listeners, {});
+    }
+    maybe_close(entry);
+}
+
+// Stop reading both outputs as if they had ended.
+static void close_outputs(ChildEntry* entry) {
+    close_output(entry, true, UV_EOF);
+    close_output(entry, false, UV_EOF);
+}
+
+// Read callback for pipe: a native sink takes the bytes as they are, otherwise
+// each "data" listener gets them as a Buffer.
+static void on_output(uv_stream_t* stream, bool is_stdout, ssize_t nread, const uv_buf_t* buf) {
+    ChildEntry* entry = static_cast<ChildEntry*>(stream->data);
+    if (nread > 0) {
+        auto& sink = is_stdout ? entry->stdout_sink : entry->stderr_sink;
+        if (sink) {
+            sink(buf->base, static_cast<size_t>(nread));
+        } else {
+            std::vector<FunctionPtr> listeners;
+            {
+                std::lock_guard<std::mutex> lk(entry->listeners_mutex);
+                listeners = is_stdout ? entry->stdout_data_listeners : entry->stderr_data_listeners;
+            }
+            if (!listeners.empty()) {
+                auto buffer = std::make_shared<BufferValue>();
+                buffer->data.assign(buf->base, buf->base + nread);
+                buffer->encoding = "binary";
+                for (auto& cb : listeners) schedule_listener_call(cb, {Value{buffer}});
+            }
+        }
+    } else if (nread < 0) {
+        close_output(entry, is_stdout, static_cast<int>(nread));
+    }
+    read_pool_release(buf);
+}
+
+static void stdout_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    on_output(stream, true, nread, buf);
+}
+
+static void stderr_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    on_output(stream, false, nread, buf);
+}
+
+// ---------- stdin ----------
+
+// Bytes for stdin.write()/end(): strings, numbers and booleans as text,
+// Buffers as they are.  `owner` keeps them alive until the write is done.
+static bool stdin_payload(const Value& v, std::shared_ptr<void>& owner, const char*& data, size_t& len) {
+    if (std::holds_alternative<BufferPtr>(v)) {
+        BufferPtr buf = std::get<BufferPtr>(v);
+        data = reinterpret_cast<const char*>(buf->data.data());
+        len = buf->data.size();
+        owner = buf;
+        return true;
+    }
+    std::string text;
+    if (std::holds_alternative<std::string>(v)) {
+        text = std::get<std::string>(v);
+    } else if (std::holds_alternative<double>(v)) {
+        std::ostringstream ss;
+        ss << std::get<double>(v);
+        text = ss.str();
+    } else if (std::holds_alternative<bool>(v)) {
+        text = std::get<bool>(v) ? "true" : "false";
+    } else {
+        return false;
+    }
+    auto s = std::make_shared<std::string>(std::move(text));
+    data = s->data();
+    len = s->size();
+    owner = s;
+    return true;
+}
+
+static void stdin_written(const std::shared_ptr<ChildEntry>& entry) {
+    if (!entry->stdin_needs_drain || !entry->stdin_pipe) return;
+    if (uv_stream_get_write_queue_size((uv_stream_t*)entry->stdin_pipe) > 0) return;
+    entry->stdin_needs_drain = false;
+    emit_child_event(entry.get(), entry->stdin_drain_listeners, {});
+}
+
+// Returns false once more than STDIN_HIGH_WATER_MARK bytes are queued for the
+// child; "drain" follows when the queue has emptied.
+static bool write_stdin(const std::shared_ptr<ChildEntry>& entry, const char* data, size_t len,
+    std::shared_ptr<void> owner, FunctionPtr cb) {
+    uv_stream_t* stream = (uv_stream_t*)entry->stdin_pipe;
+    uv_buf_t buf = uv_buf_init(const_cast<char*>(data), static_cast<unsigned int>(len));
+    bool now = stream_write_gather(stream, &buf, 1, std::move(owner), [entry, cb](int status) {
+        if (cb) {
+            if (status < 0) {
+                schedule_listener_call(cb, {Value{std::string("Write error")}});
+            } else {
+                schedule_listener_call(cb, {});
+            }
+        }
+        stdin_written(entry);
+    });
+    if (now && cb) schedule_listener_call(cb, {});
+    if (uv_stream_get_write_queue_size(stream) < STDIN_HIGH_WATER_MARK) return true;
+    entry->stdin_needs_drain = true;
+    return false;
+}
+
+// EOF for the child: queued writes go out first, then the pipe is closed.
+static void end_stdin(ChildEntry* entry) {
+    uv_pipe_t* pipe = entry->stdin_pipe;
+    if (!pipe) return;
+    entry->stdin_pipe = nullptr;
+
+    uv_shutdown_t* req = new uv_shutdown_t;
+    int r = uv_shutdown(req, (uv_stream_t*)pipe, [](uv_shutdown_t* req, int) {
+        uv_close((uv_handle_t*)req->handle, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
+        delete req;
+    });
+    if (r < 0) {
+        delete req;
+        uv_close((uv_handle_t*)pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
+    }
+}
+
 // Helper to create ObjectPtr child wrapper with JS API
 static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
     auto child_obj = std::make_shared<ObjectValue>();
 
-    // Helper to expose .stdout and .stderr as objects with .on(event, cb)
+    // Helper to expose .stdout and .stderr as objects with .on(event, cb), pause() and resume()
     auto make_stream_obj = [&](bool is_stdout) {
         auto stream = std::make_shared<ObjectValue>();
 
-        // stream.on(event, cb)
+        // stream.on("data" | "end", cb)
         auto on_impl = [entry, is_stdout](const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) -> Value {
             if (args.size() < 2) throw SwaziError("TypeError", "stream.on requires (event, cb)", token.loc);
             if (!std::holds_alternative<std::string>(args[0])) throw SwaziError("TypeError", "event name must be string", token.loc);
@@ -124,10 +352,10 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
             FunctionPtr cb = std::get<FunctionPtr>(args[1]);
 
             std::lock_guard<std::mutex> lk(entry->listeners_mutex);
-            if (is_stdout) {
-                if (ev == "data") entry->stdout_data_listeners.push_back(cb);
-            } else {
-                if (ev == "data") entry->stderr_data_listeners.push_back(cb);
+            if (ev == "data") {
+                (is_stdout ? entry->stdout_data_listeners : entry->stderr_data_listeners).push_back(cb);
+            } else if (ev == "end") {
+                (is_stdout ? entry->stdout_end_listeners : entry->stderr_end_listeners).push_back(cb);
             }
             return std::monostate{};
         };
@@ -135,6 +363,27 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
         auto fn_on = std::make_shared<FunctionValue>("native:child_stream.on", on_impl, nullptr, tok);
         stream->properties["on"] = PropertyDescriptor{fn_on, false, false, false, tok};
 
+        auto pause_impl = [entry, is_stdout](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            set_output_flowing(entry.get(), is_stdout, false);
+            return std::monostate{};
+        };
+        Token tok_pause = make_native_token("child_stream.pause");
+        auto fn_pause = std::make_shared<FunctionValue>("native:child_stream.pause", pause_impl, nullptr, tok_pause);
+        stream->properties["pause"] = PropertyDescriptor{fn_pause, false, false, false, tok_pause};
+
+        auto resume_impl = [entry, is_stdout](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            set_output_flowing(entry.get(), is_stdout, true);
+            return std::monostate{};
+        };
+        Token tok_resume = make_native_token("child_stream.resume");
+        auto fn_resume = std::make_shared<FunctionValue>("native:child_stream.resume", resume_impl, nullptr, tok_resume);
+        stream->properties["resume"] = PropertyDescriptor{fn_resume, false, false, false, tok_resume};
+
+        // lets streams.pipeline() read the pipe natively
+        if (is_stdout) {
+            stream->properties["_childStdout"] = {Value{static_cast<double>(entry->id)}, false, false, true, Token{}};
+        }
+
         return stream;
     };
     child_obj->properties["stdout"] = {Value{make_stream_obj(true)}, false, false, true, Token{}};
@@ -144,7 +393,7 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
     auto make_stdin_obj = [entry]() {
         auto stream = std::make_shared<ObjectValue>();
 
-        // stdin.write(data, [callback])
+        // stdin.write(data, [callback]) -> false when the caller should wait for "drain"
         auto write_impl = [entry](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
             if (!entry->stdin_pipe) {
                 throw SwaziError("Error", "stdin pipe not available", token.loc);
@@ -159,74 +408,14 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
                 callback = std::get<FunctionPtr>(args[1]);
             }
 
-            // Convert data to bytes
-            std::vector<uint8_t> data_bytes;
-
-            if (std::holds_alternative<std::string>(args[0])) {
-                std::string str = std::get<std::string>(args[0]);
-                data_bytes.assign(str.begin(), str.end());
-            } else if (std::holds_alternative<double>(args[0])) {
-                std::ostringstream ss;
-                ss << std::get<double>(args[0]);
-                std::string str = ss.str();
-                data_bytes.assign(str.begin(), str.end());
-            } else if (std::holds_alternative<bool>(args[0])) {
-                std::string str = std::get<bool>(args[0]) ? "true" : "false";
-                data_bytes.assign(str.begin(), str.end());
-            } else if (std::holds_alternative<BufferPtr>(args[0])) {
-                BufferPtr buf = std::get<BufferPtr>(args[0]);
-                data_bytes = buf->data;
-            } else {
+            std::shared_ptr<void> owner;
+            const char* data = nullptr;
+            size_t len = 0;
+            if (!stdin_payload(args[0], owner, data, len)) {
                 throw SwaziError("TypeError", "stdin.write() requires string, number, boolean, or buffer", token.loc);
             }
 
-            if (data_bytes.empty()) {
-                if (callback) schedule_listener_call(callback, {});
-                return Value{true};
-            }
-
-            // Allocate and write
-            uv_buf_t buf = uv_buf_init((char*)malloc(data_bytes.size()),
-                static_cast<unsigned int>(data_bytes.size()));
-            memcpy(buf.base, data_bytes.data(), data_bytes.size());
-
-            uv_write_t* req = new uv_write_t;
-
-            // Store callback in request data
-            struct WriteCallbackData {
-                FunctionPtr cb;
-                void* buffer;
-            };
-
-            WriteCallbackData* cb_data = new WriteCallbackData{callback, buf.base};
-            req->data = cb_data;
-
-            int result = uv_write(req, (uv_stream_t*)entry->stdin_pipe, &buf, 1,
-                [](uv_write_t* req, int status) {
-                    WriteCallbackData* data = static_cast<WriteCallbackData*>(req->data);
-
-                    if (data->buffer) free(data->buffer);
-
-                    if (data->cb) {
-                        if (status < 0) {
-                            schedule_listener_call(data->cb, {Value{std::string("Write error")}});
-                        } else {
-                            schedule_listener_call(data->cb, {});
-                        }
-                    }
-
-                    delete data;
-                    delete req;
-                });
-
-            if (result < 0) {
-                free(buf.base);
-                delete cb_data;
-                delete req;
-                throw SwaziError("IOError", std::string("stdin.write() failed: ") + uv_strerror(result), token.loc);
-            }
-
-            return Value{true};
+            return Value{write_stdin(entry, data, len, std::move(owner), callback)};
         };
 
         Token tok = make_native_token("stdin.write");
@@ -241,64 +430,15 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
 
             // If final data provided, write it first
             if (!args.empty() && !std::holds_alternative<std::monostate>(args[0])) {
-                std::vector<uint8_t> data_bytes;
-
-                if (std::holds_alternative<std::string>(args[0])) {
-                    std::string str = std::get<std::string>(args[0]);
-                    data_bytes.assign(str.begin(), str.end());
-                } else if (std::holds_alternative<BufferPtr>(args[0])) {
-                    BufferPtr buf = std::get<BufferPtr>(args[0]);
-                    data_bytes = buf->data;
-                }
-
-                if (!data_bytes.empty()) {
-                    uv_buf_t buf = uv_buf_init((char*)malloc(data_bytes.size()),
-                        static_cast<unsigned int>(data_bytes.size()));
-                    memcpy(buf.base, data_bytes.data(), data_bytes.size());
-
-                    uv_write_t* req = new uv_write_t;
-
-                    // Store both buffer and pipe pointer
-                    struct EndWriteData {
-                        void* buffer;
-                        uv_pipe_t* pipe;
-                    };
-
-                    EndWriteData* end_data = new EndWriteData{buf.base, entry->stdin_pipe};
-                    req->data = end_data;
-
-                    // Write then close - use static callback
-                    uv_write(req, (uv_stream_t*)entry->stdin_pipe, &buf, 1,
-                        [](uv_write_t* req, int) {
-                            EndWriteData* data = static_cast<EndWriteData*>(req->data);
-                            if (data->buffer) free(data->buffer);
-
-                            // Now close stdin pipe
-                            if (data->pipe) {
-                                uv_close((uv_handle_t*)data->pipe,
-                                    [](uv_handle_t*) {
-                                        // Don't delete - exit_cb will handle cleanup
-                                    });
-                            }
-
-                            delete data;
-                            delete req;
-                        });
-
-                    return std::monostate{};
+                std::shared_ptr<void> owner;
+                const char* data = nullptr;
+                size_t len = 0;
+                if (stdin_payload(args[0], owner, data, len) && len) {
+                    write_stdin(entry, data, len, std::move(owner), nullptr);
                 }
             }
 
-            // No data, just close stdin pipe (send EOF)
-            scheduler_run_on_loop([entry]() {
-                if (entry->stdin_pipe) {
-                    uv_close((uv_handle_t*)entry->stdin_pipe,
-                        [](uv_handle_t*) {
-                            // Don't delete - exit_cb will handle cleanup
-                        });
-                }
-            });
-
+            end_stdin(entry.get());
             return std::monostate{};
         };
 
@@ -306,11 +446,27 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
         auto fn_end = std::make_shared<FunctionValue>("native:stdin.end", end_impl, nullptr, tok_end);
         stream->properties["end"] = PropertyDescriptor{fn_end, false, false, false, tok_end};
 
+        // stdin.on("drain", cb)
+        auto on_impl = [entry](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            if (args.size() < 2) throw SwaziError("TypeError", "stdin.on requires (event, cb)", token.loc);
+            if (!std::holds_alternative<std::string>(args[0])) throw SwaziError("TypeError", "event name must be string", token.loc);
+            if (!std::holds_alternative<FunctionPtr>(args[1])) throw SwaziError("TypeError", "callback must be function", token.loc);
+            std::lock_guard<std::mutex> lk(entry->listeners_mutex);
+            if (std::get<std::string>(args[0]) == "drain") entry->stdin_drain_listeners.push_back(std::get<FunctionPtr>(args[1]));
+            return std::monostate{};
+        };
+        Token tok_on = make_native_token("stdin.on");
+        auto fn_on = std::make_shared<FunctionValue>("native:stdin.on", on_impl, nullptr, tok_on);
+        stream->properties["on"] = PropertyDescriptor{fn_on, false, false, false, tok_on};
+
+        // lets streams.pipeline() write the pipe natively
+        stream->properties["_childStdin"] = {Value{static_cast<double>(entry->id)}, false, false, true, Token{}};
+
         return stream;
     };
     child_obj->properties["stdin"] = {Value{make_stdin_obj()}, false, false, true, Token{}};
 
-    // child.on(event, cb) for 'exit' and 'message'
+    // child.on(event, cb) for 'exit', 'close' and 'message'
     auto on_impl = [entry](const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) -> Value {
         if (args.size() < 2) throw SwaziError("TypeError", "child.on requires (event, cb)", token.loc);
         if (!std::holds_alternative<std::string>(args[0])) throw SwaziError("TypeError", "event must be string", token.loc);
@@ -321,6 +477,8 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
         std::lock_guard<std::mutex> lk(entry->listeners_mutex);
         if (ev == "exit") {
             entry->exit_listeners.push_back(cb);
+        } else if (ev == "close") {
+            entry->close_listeners.push_back(cb);
         } else if (ev == "message") {
             entry->message_listeners.push_back(cb);
         } else {
@@ -351,131 +509,69 @@ static ObjectPtr make_child_object(std::shared_ptr<ChildEntry> entry) {
     return child_obj;
 }
 
-// Read callback for pipe: deliver data to listeners
-static void alloc_pipe_cb(uv_handle_t* /*handle*/, size_t suggested, uv_buf_t* buf) {
-    buf->base = (char*)malloc(suggested);
-    buf->len = static_cast<unsigned int>(suggested);
-}
-static void stdout_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
-    ChildEntry* entry_ptr = static_cast<ChildEntry*>(stream->data);
-    if (nread > 0) {
-        // Create buffer instead of string
-        auto buffer = std::make_shared<BufferValue>();
-        buffer->data.assign(buf->base, buf->base + nread);
-        buffer->encoding = "binary";
-
-        if (entry_ptr) {
-            std::vector<FunctionPtr> listeners;
-            {
-                std::lock_guard<std::mutex> lk(entry_ptr->listeners_mutex);
-                listeners = entry_ptr->stdout_data_listeners;
-            }
-            for (auto& cb : listeners) {
-                if (!cb) continue;
-                schedule_listener_call(cb, {Value{buffer}});
-            }
-        }
-    } else if (nread < 0) {
-        uv_read_stop(stream);
+// Process exit callback.  Output may still be in the pipes; "close" waits for it.
+static void exit_cb(uv_process_t* req, int64_t exit_status, int term_signal) {
+    ChildEntry* entry = static_cast<ChildEntry*>(req->data);
+    uv_close((uv_handle_t*)req, [](uv_handle_t* h) { delete reinterpret_cast<uv_process_t*>(h); });
+    if (!entry) return;
+
+    entry->proc = nullptr;
+    entry->exited = true;
+    entry->exit_status = exit_status;
+    entry->term_signal = term_signal;
+    emit_child_event(entry, entry->exit_listeners,
+        {Value{static_cast<double>(exit_status)}, Value{static_cast<double>(term_signal)}});
+    auto hooks = std::move(entry->exit_hooks);
+    entry->exit_hooks.clear();
+    for (auto& hook : hooks) hook();
+
+    // nobody is left to read stdin
+    if (entry->stdin_pipe) {
+        uv_close((uv_handle_t*)entry->stdin_pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
+        entry->stdin_pipe = nullptr;
     }
-
-    if (buf && buf->base) free(buf->base);
+    maybe_close(entry);
 }
 
-static void stderr_read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
-    ChildEntry* entry_ptr = static_cast<ChildEntry*>(stream->data);
-    if (nread > 0) {
-        // Create buffer instead of string
-        auto buffer = std::make_shared<BufferValue>();
-        buffer->data.assign(buf->base, buf->base + nread);
-        buffer->encoding = "binary";
-
-        if (entry_ptr) {
-            std::vector<FunctionPtr> listeners;
-            {
-                std::lock_guard<std::mutex> lk(entry_ptr->listeners_mutex);
-                listeners = entry_ptr->stderr_data_listeners;
-            }
-            for (auto& cb : listeners) schedule_listener_call(cb, {Value{buffer}});
-        }
-    } else if (nread < 0) {
-        uv_read_stop(stream);
-    }
+// ---------- native access (builtins.hpp) ----------
 
-    if (buf && buf->base) free(buf->base);
+bool child_stdout_tap(long long child_id, std::function<void(const char*, size_t)> data, std::function<void(int)> end) {
+    auto entry = find_child(child_id);
+    if (!entry || !entry->stdout_pipe || entry->stdout_sink) return false;
+    entry->stdout_sink = std::move(data);
+    entry->stdout_end_hook = std::move(end);
+    return true;
 }
 
-// Process exit callback
-static void exit_cb(uv_process_t* req, int64_t exit_status, int term_signal) {
-    ChildEntry* entry_ptr = static_cast<ChildEntry*>(req->data);
-    std::shared_ptr<ChildEntry> entry;
-    long long id = 0;
-    if (entry_ptr) {
-        // find shared_ptr
-        std::lock_guard<std::mutex> lk(g_children_mutex);
-        for (auto& kv : g_children) {
-            if (kv.second.get() == entry_ptr) {
-                entry = kv.second;
-                id = kv.first;
-                break;
-            }
-        }
-    }
-    // notify listeners
-    if (entry) {
-        std::vector<FunctionPtr> listeners;
-        {
-            std::lock_guard<std::mutex> lk(entry->listeners_mutex);
-            listeners = entry->exit_listeners;
-        }
-        for (auto& cb : listeners) {
-            // pass (code, signal)
-            schedule_listener_call(cb, {Value{static_cast<double>(exit_status)}, Value{static_cast<double>(term_signal)}});
-        }
-    }
+bool child_stdout_flow(long long child_id, bool flowing) {
+    auto entry = find_child(child_id);
+    if (!entry || !entry->stdout_pipe) return false;
+    set_output_flowing(entry.get(), true, flowing);
+    return true;
+}
 
-    // cleanup: close handles on loop thread
-    uv_loop_t* loop = nullptr;
-    if (req && req->loop) loop = req->loop;
-    if (loop) {
-        // schedule close on loop
-        scheduler_run_on_loop([req, entry_ptr]() {
-            if (entry_ptr->stdout_pipe) {
-                uv_close((uv_handle_t*)entry_ptr->stdout_pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
-                entry_ptr->stdout_pipe = nullptr;
-            }
-            if (entry_ptr->stderr_pipe) {
-                uv_close((uv_handle_t*)entry_ptr->stderr_pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
-                entry_ptr->stderr_pipe = nullptr;
-            }
-            if (entry_ptr->stdin_pipe) {
-                uv_close((uv_handle_t*)entry_ptr->stdin_pipe, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
-                entry_ptr->stdin_pipe = nullptr;
-            }
-            if (req) {
-                uv_close((uv_handle_t*)req, [](uv_handle_t* h) { /* uv will free uv_process_t memory only if allocated on heap, we allocated on heap below */ delete reinterpret_cast<uv_process_t*>(h); });
-            }
-        });
-    }
+uv_stream_t* child_stdin_stream(long long child_id) {
+    auto entry = find_child(child_id);
+    return entry && entry->stdin_pipe ? (uv_stream_t*)entry->stdin_pipe : nullptr;
+}
 
-    // erase from map
-    if (id) {
-        std::lock_guard<std::mutex> lk(g_children_mutex);
-        g_children.erase(id);
-    }
+void child_stdin_end(long long child_id) {
+    if (auto entry = find_child(child_id)) end_stdin(entry.get());
 }
 
 struct SpawnOptions {
     std::string cwd;
     std::vector<std::string> env_vec;  // "KEY=VAL"
     std::vector<std::string> stdio;    // entries for fd0,1,2 -> "pipe"|"inherit"|"ignore"
+    int fds[3] = {-1, -1, -1};         // fds the child inherits instead (numbers in stdio, pipeline stages)
 };
 // spawn implementation (low-level)
 static ObjectPtr do_spawn(const std::string& file,
     const std::vector<std::string>& args,
     int& out_pid,
     const Token& token,
-    const SpawnOptions& opts) {
+    const SpawnOptions& opts,
+    std::shared_ptr<ChildEntry>* out_entry = nullptr) {
     uv_loop_t* loop = scheduler_get_loop();
     if (!loop) throw SwaziError("RuntimeError", "No event loop available to spawn process", token.loc);
 
@@ -498,6 +594,9 @@ static ObjectPtr do_spawn(const std::string& file,
         use_pipe_stdout = (pick(1) == "pipe");
         use_pipe_stderr = (pick(2) == "pipe");
     }
+    use_pipe_stdin = use_pipe_stdin && opts.fds[0] < 0;
+    use_pipe_stdout = use_pipe_stdout && opts.fds[1] < 0;
+    use_pipe_stderr = use_pipe_stderr && opts.fds[2] < 0;
 
     uv_pipe_t* stdout_pipe = nullptr;
     uv_pipe_t* stderr_pipe = nullptr;
@@ -645,6 +744,13 @@ static ObjectPtr do_spawn(const std::string& file,
         }
     }
 
+    for (int i = 0; i < 3; ++i) {
+        if (opts.fds[i] >= 0) {
+            stdio[i].flags = UV_INHERIT_FD;
+            stdio[i].data.fd = opts.fds[i];
+        }
+    }
+
     uv_process_options_t options;
     memset(&options, 0, sizeof(options));
     options.exit_cb = exit_cb;
@@ -655,6 +761,7 @@ static ObjectPtr do_spawn(const std::string& file,
     options.cwd = opts.cwd.empty() ? nullptr : opts.cwd.c_str();
     options.env = envp.empty() ? nullptr : envp.data();
 
+    std_output_flush();  // the child may write to the same stdout
     int r = uv_spawn(loop, proc, &options);
 
     // free our duplicated C strings
@@ -662,11 +769,15 @@ static ObjectPtr do_spawn(const std::string& file,
     for (char* s : env_allocated) free(s);
 
     if (r != 0) {
-        // cleanup allocated handles on loop thread
-        if (stdout_pipe) delete stdout_pipe;
-        if (stderr_pipe) delete stderr_pipe;
-        if (stdin_pipe) delete stdin_pipe;
-        delete proc;
+        // the handles are initialised even when the spawn fails, so they are closed, not just deleted
+        auto close_pipe = [](uv_pipe_t* p) {
+            if (p) uv_close((uv_handle_t*)p, [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
+        };
+        close_pipe(stdout_pipe);
+        close_pipe(stderr_pipe);
+        close_pipe(stdin_pipe);
+        proc->data = nullptr;
+        uv_close((uv_handle_t*)proc, [](uv_handle_t* h) { delete reinterpret_cast<uv_process_t*>(h); });
         throw SwaziError("IOError", std::string("uv_spawn failed: ") + uv_strerror(r), token.loc);
     }
 
@@ -678,11 +789,12 @@ static ObjectPtr do_spawn(const std::string& file,
         g_children[entry->id] = entry;
     }
 
-    // start reading stdout/stderr on the loop thread (only when pipe)
+    // start reading stdout/stderr on the loop thread (only when pipe, and unless paused before then)
     scheduler_run_on_loop([entry]() {
-        if (entry->stdout_pipe) uv_read_start((uv_stream_t*)entry->stdout_pipe, alloc_pipe_cb, stdout_read_cb);
-        if (entry->stderr_pipe) uv_read_start((uv_stream_t*)entry->stderr_pipe, alloc_pipe_cb, stderr_read_cb);
+        if (!entry->stdout_paused) start_output_reads(entry.get(), true);
+        if (!entry->stderr_paused) start_output_reads(entry.get(), false);
     });
+    if (out_entry) *out_entry = entry;
 
     // create JS wrapper
     auto child_obj = make_child_object(entry);
@@ -693,6 +805,55 @@ static ObjectPtr do_spawn(const std::string& file,
     return child_obj;
 }
 
+// { cwd, env, stdio } as taken by spawn, exec and pipeline
+static void parse_spawn_options(const ObjectPtr& o, SpawnOptions& opts) {
+    // cwd
+    auto itcwd = o->properties.find("cwd");
+    if (itcwd != o->properties.end()) opts.cwd = value_to_string_simple_local(itcwd->second.value);
+
+    // env object -> build KEY=VALUE strings
+    auto itenv = o->properties.find("env");
+    if (itenv != o->properties.end() && std::holds_alternative<ObjectPtr>(itenv->second.value)) {
+        ObjectPtr eobj = std::get<ObjectPtr>(itenv->second.value);
+        for (auto& kv : eobj->properties) {
+            std::string key = kv.first;
+            std::string val = value_to_string_simple_local(kv.second.value);
+            opts.env_vec.push_back(key + "=" + val);
+        }
+    }
+
+    // stdio: can be string or array; a number in the array is an fd the child inherits
+    auto itstd = o->properties.find("stdio");
+    if (itstd != o->properties.end()) {
+        if (std::holds_alternative<std::string>(itstd->second.value)) {
+            std::string s = std::get<std::string>(itstd->second.value);
+            // if single string like "inherit" apply to all fd
+            opts.stdio = {s, s, s};
+        } else if (std::holds_alternative<ArrayPtr>(itstd->second.value)) {
+            ArrayPtr sarr = std::get<ArrayPtr>(itstd->second.value);
+            for (size_t i = 0; i < sarr->elements.size() && i < 3; ++i) {
+                const Value& el = sarr->elements[i];
+                if (std::holds_alternative<double>(el) && std::get<double>(el) >= 0) {
+                    opts.fds[i] = static_cast<int>(std::get<double>(el));
+                    opts.stdio.push_back("inherit");
+                } else {
+                    opts.stdio.push_back(value_to_string_simple_local(el));
+                }
+            }
+        }
+    }
+}
+
+// options.maxBuffer for exec/execSync; 0 (or Infinity) lifts the cap
+static size_t parse_max_buffer(const ObjectPtr& o) {
+    if (!o) return DEFAULT_MAX_BUFFER;
+    auto it = o->properties.find("maxBuffer");
+    if (it == o->properties.end() || !std::holds_alternative<double>(it->second.value)) return DEFAULT_MAX_BUFFER;
+    double v = std::get<double>(it->second.value);
+    if (!(v > 0) || std::isinf(v)) return 0;
+    return static_cast<size_t>(v);
+}
+
 // Builtin: spawn(cmd, ...args)
 static Value native_spawn(const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) {
     if (args.empty()) throw SwaziError("TypeError", "spawn requires command", token.loc);
@@ -735,42 +896,155 @@ static Value native_spawn(const std::vector<Value>& args, EnvPtr /*env*/, const
         optVal = args[1];
     }
 
-    if (std::holds_alternative<ObjectPtr>(optVal)) {
-        ObjectPtr o = std::get<ObjectPtr>(optVal);
-        // cwd
-        auto itcwd = o->properties.find("cwd");
-        if (itcwd != o->properties.end()) opts.cwd = value_to_string_simple_local(itcwd->second.value);
-
-        // env object -> build KEY=VALUE strings
-        auto itenv = o->properties.find("env");
-        if (itenv != o->properties.end() && std::holds_alternative<ObjectPtr>(itenv->second.value)) {
-            ObjectPtr eobj = std::get<ObjectPtr>(itenv->second.value);
-            for (auto& kv : eobj->properties) {
-                std::string key = kv.first;
-                std::string val = value_to_string_simple_local(kv.second.value);
-                opts.env_vec.push_back(key + "=" + val);
-            }
+    if (std::holds_alternative<ObjectPtr>(optVal)) parse_spawn_options(std::get<ObjectPtr>(optVal), opts);
+
+    int pid = 0;
+    auto child_obj = do_spawn(cmd, argv, pid, token, opts);
+    return Value{child_obj};
+}
+
+static void close_fd(uv_file fd) {
+    if (fd < 0) return;
+    uv_fs_t req;
+    uv_fs_close(scheduler_get_loop(), &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+}
+
+// Builtin: pipeline([[cmd, ...args], ...], options?)
+//
+// Stage i's stdout and stage i+1's stdin are the two ends of one OS pipe, so
+// the bytes go from child to child through the kernel.  options.stdio applies
+// to the ends of the chain: [0] is the first stage's stdin, [1] the last
+// stage's stdout, [2] every stage's stderr.  The result has the first stage's
+// stdin, the last stage's stdout/stderr, `children`, `pids`, kill(signal?) and
+// on("exit", cb(codes)) once every stage has exited and its output is in.
+static Value native_pipeline(const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) {
+    if (args.empty() || !std::holds_alternative<ArrayPtr>(args[0]) || std::get<ArrayPtr>(args[0])->elements.empty()) {
+        throw SwaziError("TypeError", "pipeline requires a non-empty array of commands", token.loc);
+    }
+
+    std::vector<std::vector<std::string>> commands;
+    for (auto& el : std::get<ArrayPtr>(args[0])->elements) {
+        std::vector<std::string> cmd;
+        if (std::holds_alternative<std::string>(el)) {
+            cmd.push_back(std::get<std::string>(el));
+        } else if (std::holds_alternative<ArrayPtr>(el)) {
+            for (auto& part : std::get<ArrayPtr>(el)->elements) cmd.push_back(value_to_string_simple_local(part));
         }
+        if (cmd.empty() || cmd[0].empty()) {
+            throw SwaziError("TypeError", "pipeline: each command must be a string or a [cmd, ...args] array", token.loc);
+        }
+        commands.push_back(std::move(cmd));
+    }
 
-        // stdio: can be string or array
-        auto itstd = o->properties.find("stdio");
-        if (itstd != o->properties.end()) {
-            if (std::holds_alternative<std::string>(itstd->second.value)) {
-                std::string s = std::get<std::string>(itstd->second.value);
-                // if single string like "inherit" apply to all fd
-                opts.stdio = {s, s, s};
-            } else if (std::holds_alternative<ArrayPtr>(itstd->second.value)) {
-                ArrayPtr sarr = std::get<ArrayPtr>(itstd->second.value);
-                for (size_t i = 0; i < sarr->elements.size() && i < 3; ++i) {
-                    opts.stdio.push_back(value_to_string_simple_local(sarr->elements[i]));
-                }
+    SpawnOptions base;
+    if (args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1])) parse_spawn_options(std::get<ObjectPtr>(args[1]), base);
+    base.stdio.resize(3, "pipe");
+
+    struct PipelineState {
+        size_t running = 0;
+        bool done = false;
+        ArrayPtr codes = std::make_shared<ArrayValue>();
+        std::vector<FunctionPtr> exit_listeners;
+    };
+    auto state = std::make_shared<PipelineState>();
+    std::vector<std::shared_ptr<ChildEntry>> entries;
+    std::vector<ObjectPtr> children;
+    auto pids = std::make_shared<ArrayValue>();
+
+    uv_file upstream = -1;  // read end of the pipe feeding the next stage
+    try {
+        for (size_t i = 0; i < commands.size(); ++i) {
+            SpawnOptions opts = base;
+            if (i > 0) opts.fds[0] = upstream;
+            uv_file fds[2] = {-1, -1};
+            if (i + 1 < commands.size()) {
+                int r = uv_pipe(fds, 0, 0);
+                if (r < 0) throw SwaziError("IOError", std::string("pipeline: pipe failed: ") + uv_strerror(r), token.loc);
+                opts.fds[1] = fds[1];
             }
+
+            int pid = 0;
+            std::shared_ptr<ChildEntry> entry;
+            ObjectPtr child;
+            try {
+                child = do_spawn(commands[i][0], std::vector<std::string>(commands[i].begin() + 1, commands[i].end()),
+                    pid, token, opts, &entry);
+            } catch (...) {
+                close_fd(fds[0]);
+                close_fd(fds[1]);
+                throw;
+            }
+
+            // the children have their own copies now; ours would hold EOF back
+            close_fd(upstream);
+            close_fd(fds[1]);
+            upstream = fds[0];
+
+            entries.push_back(entry);
+            children.push_back(child);
+            pids->elements.push_back(Value{static_cast<double>(pid)});
         }
+    } catch (...) {
+        close_fd(upstream);
+        for (auto& e : entries) {
+            if (e->proc) uv_process_kill(e->proc, SIGTERM);
+        }
+        throw;
     }
 
-    int pid = 0;
-    auto child_obj = do_spawn(cmd, argv, pid, token, opts);
-    return Value{child_obj};
+    state->running = entries.size();
+    state->codes->elements.assign(entries.size(), Value{std::monostate{}});
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i]->close_hooks.push_back([state, i](int64_t code, int) {
+            state->codes->elements[i] = Value{static_cast<double>(code)};
+            if (--state->running) return;
+            state->done = true;
+            for (auto& cb : state->exit_listeners) schedule_listener_call(cb, {Value{state->codes}});
+        });
+    }
+
+    auto obj = std::make_shared<ObjectValue>();
+    obj->properties["stdin"] = {children.front()->properties["stdin"].value, false, false, true, Token{}};
+    obj->properties["stdout"] = {children.back()->properties["stdout"].value, false, false, true, Token{}};
+    obj->properties["stderr"] = {children.back()->properties["stderr"].value, false, false, true, Token{}};
+    auto child_arr = std::make_shared<ArrayValue>();
+    for (auto& c : children) child_arr->elements.push_back(Value{c});
+    obj->properties["children"] = {Value{child_arr}, false, false, true, Token{}};
+    obj->properties["pids"] = {Value{pids}, false, false, true, Token{}};
+
+    // pipeline.on("exit", cb(codes))
+    auto on_impl = [state](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+        if (args.size() < 2) throw SwaziError("TypeError", "pipeline.on requires (event, cb)", token.loc);
+        if (!std::holds_alternative<std::string>(args[0])) throw SwaziError("TypeError", "event must be string", token.loc);
+        if (!std::holds_alternative<FunctionPtr>(args[1])) throw SwaziError("TypeError", "cb must be function", token.loc);
+        if (std::get<std::string>(args[0]) != "exit") return std::monostate{};
+        FunctionPtr cb = std::get<FunctionPtr>(args[1]);
+        if (state->done) {
+            schedule_listener_call(cb, {Value{state->codes}});
+        } else {
+            state->exit_listeners.push_back(cb);
+        }
+        return std::monostate{};
+    };
+    Token tok_on = make_native_token("pipeline.on");
+    auto fn_on = std::make_shared<FunctionValue>("native:pipeline.on", on_impl, nullptr, tok_on);
+    obj->properties["on"] = PropertyDescriptor{fn_on, false, false, false, tok_on};
+
+    // pipeline.kill(signal?) signals every stage still running
+    auto kill_impl = [entries](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+        int sig = SIGTERM;
+        if (!args.empty() && std::holds_alternative<double>(args[0])) sig = static_cast<int>(std::get<double>(args[0]));
+        for (auto& e : entries) {
+            if (e->proc && e->proc->pid) uv_process_kill(e->proc, sig);
+        }
+        return std::monostate{};
+    };
+    Token tok_kill = make_native_token("pipeline.kill");
+    auto fn_kill = std::make_shared<FunctionValue>("native:pipeline.kill", kill_impl, nullptr, tok_kill);
+    obj->properties["kill"] = PropertyDescriptor{fn_kill, false, false, false, tok_kill};
+
+    return Value{obj};
 }
 
 static Value native_exec_sync(const std::vector<Value>& args, EnvPtr, const Token& token) {
@@ -778,6 +1052,7 @@ static Value native_exec_sync(const std::vector<Value>& args, EnvPtr, const Toke
         throw SwaziError("TypeError", "execSync requires a string command", token.loc);
 
     std::string cmd = std::get<std::string>(args[0]);
+    size_t max_buffer = parse_max_buffer(args.size() >= 2 && std::holds_alternative<ObjectPtr>(args[1]) ? std::get<ObjectPtr>(args[1]) : nullptr);
 
 #ifdef _WIN32
     char tmp_err_buf[L_tmpnam];
@@ -802,9 +1077,22 @@ static Value native_exec_sync(const std::vector<Value>& args, EnvPtr, const Toke
     FILE* fp = SWAZI_POPEN(full_cmd.c_str(), "r");
     if (!fp) throw SwaziError("Error", "execSync: popen failed", token.loc);
 
-    char chunk[4096];
-    while (fgets(chunk, sizeof(chunk), fp))
-        out_buf += chunk;
+    // Past maxBuffer we stop reading; pclose() then closes the pipe and the
+    // child gets SIGPIPE on its next write instead of filling our memory.
+    const char* overflow = nullptr;
+    auto read_capped = [&](FILE* f, std::string& into, const char* name) {
+        char chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+            if (max_buffer && into.size() + n > max_buffer) {
+                into.append(chunk, max_buffer - into.size());
+                overflow = name;
+                return;
+            }
+            into.append(chunk, n);
+        }
+    };
+    read_capped(fp, out_buf, "stdout");
 
     int status = SWAZI_PCLOSE(fp);
 #ifndef _WIN32
@@ -813,12 +1101,15 @@ static Value native_exec_sync(const std::vector<Value>& args, EnvPtr, const Toke
     exit_code = status;
 #endif
 
-    FILE* ef = fopen(tmp_err.c_str(), "r");
+    FILE* ef = fopen(tmp_err.c_str(), "rb");
     if (ef) {
-        while (fgets(chunk, sizeof(chunk), ef))
-            err_buf += chunk;
+        if (!overflow) read_capped(ef, err_buf, "stderr");
         fclose(ef);
-        std::remove(tmp_err.c_str());
+    }
+    std::remove(tmp_err.c_str());
+
+    if (overflow) {
+        throw SwaziError("Error", std::string("execSync: ") + overflow + " maxBuffer of " + std::to_string(max_buffer) + " bytes exceeded", token.loc);
     }
 
     auto res = std::make_shared<ObjectValue>();
@@ -839,9 +1130,20 @@ std::shared_ptr<ObjectValue> make_subprocess_exports(EnvPtr env, Evaluator* eval
             throw SwaziError("TypeError", "exec requires a string command", token.loc);
         }
         std::string cmd = std::get<std::string>(args[0]);
+        // exec(cmd[, options][, cb])
+        ObjectPtr options;
         FunctionPtr cb = nullptr;
-        if (args.size() >= 2 && std::holds_alternative<FunctionPtr>(args[1]))
-            cb = std::get<FunctionPtr>(args[1]);
+        for (size_t i = 1; i < args.size() && i < 3; ++i) {
+            if (std::holds_alternative<ObjectPtr>(args[i])) options = std::get<ObjectPtr>(args[i]);
+            if (std::holds_alternative<FunctionPtr>(args[i])) cb = std::get<FunctionPtr>(args[i]);
+        }
+
+        SpawnOptions spawn_opts;
+        if (options) {
+            parse_spawn_options(options, spawn_opts);
+            spawn_opts.stdio.clear();  // exec always collects both outputs
+            spawn_opts.fds[0] = spawn_opts.fds[1] = spawn_opts.fds[2] = -1;
+        }
 
         std::string shell = "/bin/sh";
         std::vector<std::string> argv = {shell, "-c", cmd};
@@ -852,102 +1154,87 @@ std::shared_ptr<ObjectValue> make_subprocess_exports(EnvPtr env, Evaluator* eval
         struct ExecCtx {
             std::string out;
             std::string err;
+            size_t max_buffer = 0;
+            const char* overflow = nullptr;  // "stdout" / "stderr" once past max_buffer
             std::shared_ptr<PromiseValue> promise;
             FunctionPtr cb;
-            Evaluator* eval;  // ADD THIS
+            Evaluator* eval;
+            uv_timer_t* drain = nullptr;  // bounds the wait for EOF after exit
         };
         auto ctx = std::make_shared<ExecCtx>();
+        ctx->max_buffer = parse_max_buffer(options);
         ctx->promise = promise;
         ctx->cb = cb;
-        ctx->eval = evaluator;  // ADD THIS
+        ctx->eval = evaluator;
 
-        scheduler_run_on_loop([argv = std::move(argv), ctx, token]() {
+        scheduler_run_on_loop([argv = std::move(argv), spawn_opts, ctx, token]() {
             int pid = 0;
             Token t = token;
             try {
-                auto child_obj = do_spawn(argv[0],
-                    std::vector<std::string>(argv.begin() + 1, argv.end()), pid, t, SpawnOptions{});
-
                 std::shared_ptr<ChildEntry> entry;
-                {
-                    std::lock_guard<std::mutex> lk(g_children_mutex);
-                    for (auto& kv : g_children) {
-                        if (kv.second->proc && kv.second->proc->pid == pid) {
-                            entry = kv.second;
-                            break;
-                        }
+                do_spawn(argv[0], std::vector<std::string>(argv.begin() + 1, argv.end()), pid, t, spawn_opts, &entry);
+
+                // Output is appended as it is read, without a Buffer or an
+                // interpreter callback per chunk.  Past maxBuffer the child is
+                // killed and both pipes closed, so nothing more is read.
+                ChildEntry* raw = entry.get();
+                auto collect = [ctx, raw](bool is_stdout, const char* data, size_t len) {
+                    if (ctx->overflow) return;
+                    std::string& into = is_stdout ? ctx->out : ctx->err;
+                    if (ctx->max_buffer && into.size() + len > ctx->max_buffer) {
+                        into.append(data, ctx->max_buffer - into.size());
+                        ctx->overflow = is_stdout ? "stdout" : "stderr";
+                        if (raw->proc) uv_process_kill(raw->proc, SIGTERM);
+                        close_outputs(raw);
+                        return;
                     }
-                }
+                    into.append(data, len);
+                };
+                entry->stdout_sink = [collect](const char* data, size_t len) { collect(true, data, len); };
+                entry->stderr_sink = [collect](const char* data, size_t len) { collect(false, data, len); };
+
+                // The shell is done; whatever still holds its pipes gets
+                // EXEC_DRAIN_MS to finish writing.
+                long long id = entry->id;
+                entry->exit_hooks.push_back([ctx, id]() {
+                    ctx->drain = new uv_timer_t;
+                    uv_timer_init(scheduler_get_loop(), ctx->drain);
+                    ctx->drain->data = new long long(id);
+                    uv_timer_start(ctx->drain, [](uv_timer_t* timer) {
+                        if (auto child = find_child(*static_cast<long long*>(timer->data))) close_outputs(child.get());
+                    }, EXEC_DRAIN_MS, 0);
+                });
 
-                if (!entry) {
-                    // CRITICAL FIX: Use evaluator helper
-                    if (ctx->eval && ctx->promise) {
-                        ctx->eval->reject_promise(ctx->promise,
-                            Value{std::string("spawn failed")});
+                entry->close_hooks.push_back([ctx](int64_t code, int) {
+                    if (ctx->drain) {
+                        uv_timer_stop(ctx->drain);
+                        uv_close((uv_handle_t*)ctx->drain, [](uv_handle_t* h) {
+                            delete static_cast<long long*>(h->data);
+                            delete reinterpret_cast<uv_timer_t*>(h);
+                        });
+                        ctx->drain = nullptr;
                     }
-                    return;
-                }
 
-                {
-                    std::lock_guard<std::mutex> lk(entry->listeners_mutex);
-
-                    entry->stdout_data_listeners.push_back(
-                        std::make_shared<FunctionValue>(
-                            "internal:exec_stdout_collector",
-                            [entry, ctx](const std::vector<Value>& a, EnvPtr, const Token&) -> Value {
-                                if (!a.empty() && std::holds_alternative<BufferPtr>(a[0])) {
-                                    BufferPtr buf = std::get<BufferPtr>(a[0]);
-                                    ctx->out.append(buf->data.begin(), buf->data.end());
-                                }
-                                return std::monostate{};
-                            },
-                            nullptr, Token{}));
-
-                    entry->stderr_data_listeners.push_back(
-                        std::make_shared<FunctionValue>(
-                            "internal:exec_stderr_collector",
-                            [entry, ctx](const std::vector<Value>& a, EnvPtr, const Token&) -> Value {
-                                if (!a.empty() && std::holds_alternative<BufferPtr>(a[0])) {
-                                    BufferPtr buf = std::get<BufferPtr>(a[0]);
-                                    ctx->err.append(buf->data.begin(), buf->data.end());
-                                }
-                                return std::monostate{};
-                            },
-                            nullptr, Token{}));
-
-                    entry->exit_listeners.push_back(
-                        std::make_shared<FunctionValue>(
-                            "internal:exec_exit_handler",
-                            [entry, ctx](const std::vector<Value>& a, EnvPtr, const Token&) -> Value {
-                                int code = 0;
-                                if (!a.empty() && std::holds_alternative<double>(a[0]))
-                                    code = static_cast<int>(std::get<double>(a[0]));
-
-                                // Build result object
-                                auto res = std::make_shared<ObjectValue>();
-                                res->properties["stdout"] = {Value{ctx->out}, false, false, true, Token{}};
-                                res->properties["stderr"] = {Value{ctx->err}, false, false, true, Token{}};
-                                res->properties["code"] = {Value{static_cast<double>(code)}, false, false, true, Token{}};
-
-                                // Invoke callback if provided
-                                if (ctx->cb) {
-                                    schedule_listener_call(ctx->cb,
-                                        {Value{std::monostate{}}, Value{res}});
-                                }
-
-                                // CRITICAL FIX: Use evaluator helper instead of direct mutation
-                                if (ctx->eval && ctx->promise) {
-                                    ctx->eval->fulfill_promise(ctx->promise, Value{res});
-                                } else if (ctx->promise) {
-                                    // Fallback (shouldn't happen)
-                                    ctx->promise->state = PromiseValue::State::FULFILLED;
-                                    ctx->promise->result = res;
-                                }
-
-                                return std::monostate{};
-                            },
-                            nullptr, Token{}));
-                }
+                    // Build result object
+                    auto res = std::make_shared<ObjectValue>();
+                    res->properties["stdout"] = {Value{ctx->out}, false, false, true, Token{}};
+                    res->properties["stderr"] = {Value{ctx->err}, false, false, true, Token{}};
+                    res->properties["code"] = {Value{static_cast<double>(code)}, false, false, true, Token{}};
+
+                    if (ctx->overflow) {
+                        std::string msg = std::string("exec: ") + ctx->overflow + " maxBuffer of " +
+                                          std::to_string(ctx->max_buffer) + " bytes exceeded";
+                        if (ctx->cb) schedule_listener_call(ctx->cb, {Value{msg}, Value{res}});
+                        if (ctx->eval && ctx->promise) ctx->eval->reject_promise(ctx->promise, Value{msg});
+                        return;
+                    }
+
+                    // Invoke callback if provided
+                    if (ctx->cb) {
+                        schedule_listener_call(ctx->cb, {Value{std::monostate{}}, Value{res}});
+                    }
+                    if (ctx->eval && ctx->promise) ctx->eval->fulfill_promise(ctx->promise, Value{res});
+                });
             } catch (...) {
                 if (ctx->cb) {
                     schedule_listener_call(ctx->cb,
@@ -977,7 +1264,15 @@ std::shared_ptr<ObjectValue> make_subprocess_exports(EnvPtr env, Evaluator* eval
     auto fn_spawn = std::make_shared<FunctionValue>("native:subprocess.spawn", native_spawn, nullptr, t);
     obj->properties["spawn"] = PropertyDescriptor{Value{fn_spawn}, false, false, false, t};
 
-    auto fn_fork = std::make_shared<FunctionValue>("native:subprocess.fork", native_fork, nullptr, t);
+    auto fn_pipeline = std::make_shared<FunctionValue>("native:subprocess.pipeline", native_pipeline, nullptr, t);
+    obj->properties["pipeline"] = PropertyDescriptor{Value{fn_pipeline}, false, false, false, t};
+
+    auto fn_fork = std::make_shared<FunctionValue>(
+        "native:subprocess.fork",
+        [evaluator](const std::vector<Value>& args, EnvPtr env, const Token& token) -> Value {
+            return native_fork(args, env, token, evaluator);
+        },
+        nullptr, t);
     obj->properties["fork"] = PropertyDescriptor{Value{fn_fork}, false, false, false, t};
 
     return obj;
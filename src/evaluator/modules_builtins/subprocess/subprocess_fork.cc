@@ -3,6 +3,8 @@
 
 #include <atomic>
 #include <cstring>
+#include <deque>
+#include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -10,8 +12,11 @@
 #include <string>
 #include <vector>
 
+#include "../net_module/net.hpp"
 #include "AsyncBridge.hpp"
+#include "StdOutput.hpp"
 #include "SwaziError.hpp"
+#include "UvBuffers.hpp"
 #include "builtins.hpp"
 #include "evaluator.hpp"
 #include "uv.h"
@@ -51,6 +56,13 @@ struct ForkChildEntry {
     std::vector<FunctionPtr> exit_listeners;
 
     bool closed = false;
+
+    // serialization: "advanced" — IPC carries structured-clone frames
+    bool advanced = false;
+    std::vector<uint8_t> frame_buffer;  // partial frame carried across reads
+    Evaluator* evaluator = nullptr;
+    std::shared_ptr<StreamCork> cork;  // frames sent this tick, one write per tick
+    std::deque<uv_tcp_t*> received_handles;  // passed handles waiting for their frame
 };
 
 // Global registry
@@ -91,11 +103,37 @@ static void alloc_pipe_cb(uv_handle_t* /*handle*/, size_t suggested, uv_buf_t* b
     buf->len = static_cast<unsigned int>(suggested);
 }
 
+// IPC reads come from the shared slab pool; ipc_message_cb hands them back.
+static void alloc_ipc_cb(uv_handle_t* handle, size_t suggested, uv_buf_t* buf) {
+    read_pool_alloc(handle, suggested, buf);
+}
+
 // IPC message callback - child sent message on fd 4, parent receives
 static void ipc_message_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
     ForkChildEntry* entry_ptr = static_cast<ForkChildEntry*>(stream->data);
 
-    if (nread > 0 && entry_ptr) {
+    if (nread > 0 && entry_ptr && entry_ptr->advanced) {
+        ipc_accept_handles((uv_pipe_t*)stream, entry_ptr->received_handles);
+        std::vector<std::string> errors;
+        std::vector<Value> messages = structured_clone_unframe(entry_ptr->frame_buffer,
+            reinterpret_cast<const uint8_t*>(buf->base), static_cast<size_t>(nread),
+            entry_ptr->evaluator, &errors);
+        for (const std::string& err : errors) {
+            std::cerr << "[fork] dropping malformed IPC frame: " << err << "\n";
+        }
+
+        std::vector<FunctionPtr> listeners;
+        {
+            std::lock_guard<std::mutex> lk(entry_ptr->listeners_mutex);
+            listeners = entry_ptr->message_listeners;
+        }
+        for (auto& msg : messages) {
+            std::vector<Value> cb_args = ipc_message_args(msg, entry_ptr->received_handles);
+            for (auto& cb : listeners) {
+                if (cb) schedule_listener_call(cb, cb_args);
+            }
+        }
+    } else if (nread > 0 && entry_ptr) {
         // Create buffer directly from received bytes (no JSON parsing)
         auto buffer = std::make_shared<BufferValue>();
         buffer->data.assign(buf->base, buf->base + nread);
@@ -115,7 +153,7 @@ static void ipc_message_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* b
         uv_read_stop(stream);
     }
 
-    if (buf && buf->base) free(buf->base);
+    read_pool_release(buf);
 }
 
 // Standard output callback - now returns buffers
@@ -221,6 +259,8 @@ static void fork_exit_cb(uv_process_t* req, int64_t exit_status, int term_signal
                     [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
                 entry_ptr->ipc_read_pipe = nullptr;
             }
+            if (entry_ptr->cork) entry_ptr->cork->detach();
+            ipc_close_handles(entry_ptr->received_handles);
             if (entry_ptr->ipc_write_pipe) {
                 uv_close((uv_handle_t*)entry_ptr->ipc_write_pipe,
                     [](uv_handle_t* h) { delete reinterpret_cast<uv_pipe_t*>(h); });
@@ -297,10 +337,32 @@ static ObjectPtr make_fork_child_object(std::shared_ptr<ForkChildEntry> entry) {
     auto fn_on = std::make_shared<FunctionValue>("native:child.on", on_impl, nullptr, tok_on);
     child_obj->properties["on"] = PropertyDescriptor{fn_on, false, false, false, tok_on};
 
-    // child.send(msg) - sends JSON message to child via IPC
+    // child.send(msg, handle?) - sends a message (and a tcp socket or server) to the child via IPC
     auto send_impl = [entry](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
         if (args.empty()) throw SwaziError("TypeError", "send requires a message", token.loc);
 
+        if (!entry->ipc_write_pipe) {
+            throw SwaziError("IOError", "IPC pipe not available", token.loc);
+        }
+
+        // A second argument is a handle to pass along with the message.
+        if (args.size() >= 2 && !std::holds_alternative<std::monostate>(args[1])) {
+            if (!entry->advanced) {
+                throw SwaziError("TypeError", "send: passing a handle requires serialization: \"advanced\"", token.loc);
+            }
+            ipc_send_handle(entry->ipc_write_pipe, entry->cork.get(), args[0], args[1], token);
+            return std::monostate{};
+        }
+
+        // Frames are encoded straight into the cork and leave with the rest
+        // of this tick's messages.
+        if (entry->advanced) {
+            if (!entry->cork) entry->cork = std::make_shared<StreamCork>((uv_stream_t*)entry->ipc_write_pipe);
+            structured_clone_frame_append(entry->cork->pending, args[0], token);
+            entry->cork->commit();
+            return std::monostate{};
+        }
+
         std::vector<uint8_t> data_bytes;
 
         // Convert value to bytes
@@ -328,23 +390,11 @@ static ObjectPtr make_fork_child_object(std::shared_ptr<ForkChildEntry> entry) {
             return std::monostate{};
         }
 
-        if (!entry->ipc_write_pipe) {
-            throw SwaziError("IOError", "IPC pipe not available", token.loc);
-        }
-
-        // Allocate and send raw bytes
-        uv_buf_t buf = uv_buf_init((char*)malloc(data_bytes.size()),
-            static_cast<unsigned int>(data_bytes.size()));
-        memcpy(buf.base, data_bytes.data(), data_bytes.size());
-
-        uv_write_t* req = new uv_write_t;
-        req->data = buf.base;
-
-        uv_write(req, (uv_stream_t*)entry->ipc_write_pipe, &buf, 1,
-            [](uv_write_t* req, int) {
-                if (req->data) free(req->data);
-                delete req;
-            });
+        // Send raw bytes; whatever the pipe does not take now is queued in place.
+        auto owned = std::make_shared<std::vector<uint8_t>>(std::move(data_bytes));
+        uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(owned->data()),
+            static_cast<unsigned int>(owned->size()));
+        stream_write_gather((uv_stream_t*)entry->ipc_write_pipe, &buf, 1, owned, nullptr);
 
         return std::monostate{};
     };
@@ -380,6 +430,7 @@ struct ForkOptions {
     std::string cwd;
     std::vector<std::string> env_vec;  // "KEY=VAL"
     std::vector<std::string> stdio;    // ["pipe"|"inherit"|"ignore", ...]
+    bool advanced_serialization = false;  // serialization: "advanced"
 };
 
 // Main fork implementation
@@ -388,7 +439,8 @@ static ObjectPtr do_fork(
     const std::vector<std::string>& args,
     const ForkOptions& opts,
     int& out_pid,
-    const Token& token) {
+    const Token& token,
+    Evaluator* evaluator) {
     uv_loop_t* loop = scheduler_get_loop();
     if (!loop) {
         throw SwaziError("RuntimeError", "No event loop available for fork", token.loc);
@@ -396,6 +448,8 @@ static ObjectPtr do_fork(
 
     auto entry = std::make_shared<ForkChildEntry>();
     entry->id = g_next_fork_id.fetch_add(1);
+    entry->advanced = opts.advanced_serialization;
+    entry->evaluator = evaluator;
 
     // Allocate process handle
     uv_process_t* proc = new uv_process_t;
@@ -451,12 +505,19 @@ static ObjectPtr do_fork(
     }
 
     // Create IPC pipes (always for fork)
+    // With "advanced" serialization these are IPC pipes, which can carry
+    // socket handles (child.send(msg, handle)).
+#ifndef _WIN32
+    const int ipc_flag = opts.advanced_serialization ? 1 : 0;
+#else
+    const int ipc_flag = 0;
+#endif
     entry->ipc_read_pipe = new uv_pipe_t;
-    uv_pipe_init(loop, entry->ipc_read_pipe, 0);
+    uv_pipe_init(loop, entry->ipc_read_pipe, ipc_flag);
     entry->ipc_read_pipe->data = entry.get();
 
     entry->ipc_write_pipe = new uv_pipe_t;
-    uv_pipe_init(loop, entry->ipc_write_pipe, 0);
+    uv_pipe_init(loop, entry->ipc_write_pipe, ipc_flag);
     entry->ipc_write_pipe->data = entry.get();
 
     // Build argv: [interpreter, script_path, ...args]
@@ -504,6 +565,11 @@ static ObjectPtr do_fork(
 
     // Add SWAZI_IPC=1 marker
     env_map["SWAZI_IPC"] = "1";
+    if (opts.advanced_serialization) {
+        env_map["SWAZI_IPC_SERIALIZATION"] = "advanced";
+    } else {
+        env_map.erase("SWAZI_IPC_SERIALIZATION");
+    }
 
     // Convert to char* array
     std::vector<char*> envp;
@@ -572,7 +638,8 @@ static ObjectPtr do_fork(
     options.cwd = opts.cwd.empty() ? nullptr : opts.cwd.c_str();
     options.env = envp.data();
 
-    // Spawn the process
+    // Spawn the process; the child may write to the same stdout
+    std_output_flush();
     int r = uv_spawn(loop, proc, &options);
 
     // Cleanup allocated strings
@@ -612,7 +679,7 @@ static ObjectPtr do_fork(
         }
         if (entry->ipc_read_pipe) {
             uv_read_start((uv_stream_t*)entry->ipc_read_pipe,
-                alloc_pipe_cb, ipc_message_cb);
+                alloc_ipc_cb, ipc_message_cb);
         }
     });
 
@@ -626,7 +693,7 @@ static ObjectPtr do_fork(
 }
 
 // Public API: native_fork(script_path, args?, options?)
-Value native_fork(const std::vector<Value>& args, EnvPtr /*env*/, const Token& token) {
+Value native_fork(const std::vector<Value>& args, EnvPtr /*env*/, const Token& token, Evaluator* evaluator) {
     if (args.empty() || !std::holds_alternative<std::string>(args[0])) {
         throw SwaziError("TypeError", "fork requires script path as first argument", token.loc);
     }
@@ -680,9 +747,21 @@ Value native_fork(const std::vector<Value>& args, EnvPtr /*env*/, const Token& t
                 }
             }
         }
+
+        // serialization: "raw" (default) | "advanced"
+        auto itser = o->properties.find("serialization");
+        if (itser != o->properties.end()) {
+            std::string mode = value_to_string_simple_local(itser->second.value);
+            if (mode == "advanced") {
+                opts.advanced_serialization = true;
+            } else if (mode != "raw") {
+                throw SwaziError("TypeError",
+                    "fork: serialization must be \"raw\" or \"advanced\"", token.loc);
+            }
+        }
     }
 
     int pid = 0;
-    auto child_obj = do_fork(script_path, script_args, opts, pid, token);
+    auto child_obj = do_fork(script_path, script_args, opts, pid, token, evaluator);
     return Value{child_obj};
 }
\ No newline at end of file
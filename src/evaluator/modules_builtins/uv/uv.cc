@@ -7,6 +7,7 @@
 
 #include "AsyncBridge.hpp"
 #include "ClassRuntime.hpp"
+#include "LoopTrace.hpp"
 #include "Scheduler.hpp"
 #include "SwaziError.hpp"
 #include "evaluator.hpp"
@@ -299,6 +300,8 @@ std::shared_ptr<ObjectValue> make_uv_exports(EnvPtr env) {
             obj->properties["datetimes"] = PropertyDescriptor{ Value{ static_cast<double>(dtCount) }, false, false, true, tok };
             obj->properties["ranges"] = PropertyDescriptor{ Value{ static_cast<double>(rangeCount) }, false, false, true, tok };
             obj->properties["maps"] = PropertyDescriptor{ Value{ static_cast<double>(mapCount) }, false, false, true, tok };
+            obj->properties["objectsAllocated"] = PropertyDescriptor{ Value{ static_cast<double>(MemoryTracking::g_objects_allocated.load()) }, false, false, true, tok };
+            obj->properties["functionsAllocated"] = PropertyDescriptor{ Value{ static_cast<double>(MemoryTracking::g_functions_allocated.load()) }, false, false, true, tok };
         
             obj->properties["bufferBytes"] = PropertyDescriptor{ Value{ static_cast<double>(bufferBytes) }, false, false, true, tok };
             obj->properties["stringBytes"] = PropertyDescriptor{ Value{ static_cast<double>(stringBytes) }, false, false, true, tok };
@@ -358,6 +361,99 @@ std::shared_ptr<ObjectValue> make_uv_exports(EnvPtr env) {
         obj->properties["residentSetMemory"] = PropertyDescriptor{fn, false, false, true, Token()};
     }
 
+    // uv.loopStats({ reset? }) -> event-loop statistics for this thread
+    // The first call also starts the 10 ms lag sampler, so `lag` covers the
+    // period since then.  Times are milliseconds; histograms are log2 buckets
+    // over microseconds ({ le: upper bound in ms, count }).
+    {
+        auto fn = make_native_fn("uv.loopStats", [](const std::vector<Value>& args, EnvPtr, const Token&) -> Value {
+            scheduler_start_lag_monitor(10);
+            LoopStats& st = loop_stats();
+            Token tok;
+
+            auto num = [&](ObjectPtr o, const char* key, double v) {
+                o->properties[key] = PropertyDescriptor{Value{v}, false, false, true, tok};
+            };
+            auto summarize = [&](const LoopHistogram& h) {
+                auto o = std::make_shared<ObjectValue>();
+                num(o, "count", static_cast<double>(h.total));
+                num(o, "mean", h.mean() / 1000.0);
+                num(o, "p50", h.percentile(0.50) / 1000.0);
+                num(o, "p90", h.percentile(0.90) / 1000.0);
+                num(o, "p99", h.percentile(0.99) / 1000.0);
+                num(o, "max", h.max_us / 1000.0);
+                auto buckets = std::make_shared<ArrayValue>();
+                for (int b = 0; b < LoopHistogram::BUCKETS; ++b) {
+                    if (!h.counts[b]) continue;
+                    auto e = std::make_shared<ObjectValue>();
+                    num(e, "le", static_cast<double>(1ULL << b) / 1000.0);
+                    num(e, "count", static_cast<double>(h.counts[b]));
+                    buckets->elements.push_back(Value{e});
+                }
+                o->properties["histogram"] = PropertyDescriptor{Value{buckets}, false, false, true, tok};
+                return Value{o};
+            };
+
+            auto out = std::make_shared<ObjectValue>();
+            out->properties["lag"] = PropertyDescriptor{summarize(st.lag), false, false, true, tok};
+            out->properties["wait"] = PropertyDescriptor{summarize(st.wait), false, false, true, tok};
+            out->properties["run"] = PropertyDescriptor{summarize(st.run), false, false, true, tok};
+
+            auto tasks = std::make_shared<ObjectValue>();
+            auto pending = std::make_shared<ObjectValue>();
+            const char* lanes[] = {"io", "timer", "user", "background"};
+            for (int i = 0; i < 4; ++i) {
+                num(tasks, lanes[i], static_cast<double>(st.tasks[i]));
+                num(pending, lanes[i], static_cast<double>(scheduler_pending_macrotasks(static_cast<TaskPriority>(i))));
+            }
+            num(tasks, "microtasks", static_cast<double>(st.microtasks));
+            out->properties["tasks"] = PropertyDescriptor{Value{tasks}, false, false, true, tok};
+            out->properties["pending"] = PropertyDescriptor{Value{pending}, false, false, true, tok};
+            num(out, "promises", static_cast<double>(MemoryTracking::g_promise_count.load()));
+
+            if (!args.empty() && std::holds_alternative<ObjectPtr>(args[0])) {
+                auto o = std::get<ObjectPtr>(args[0]);
+                auto it = o->properties.find("reset");
+                if (it != o->properties.end() && std::holds_alternative<bool>(it->second.value) && std::get<bool>(it->second.value)) {
+                    loop_stats_reset();
+                }
+            }
+            return Value{out}; }, env);
+        obj->properties["loopStats"] = PropertyDescriptor{fn, false, false, true, Token()};
+    }
+
+    // uv.trace — Chrome trace-event recording of every loop task
+    //   uv.trace.start()       begin (clears any previous recording)
+    //   uv.trace.stop(path?)   stop; writes JSON to path -> bool, else returns the JSON string
+    //   uv.trace.enabled()     -> bool
+    // SWAZI_TRACE=<file.json> does the same for the whole run of the main thread.
+    {
+        auto trace = std::make_shared<ObjectValue>();
+
+        auto start = make_native_fn("uv.trace.start", [](const std::vector<Value>&, EnvPtr, const Token&) -> Value {
+            loop_trace_start();
+            scheduler_start_lag_monitor(10);
+            return std::monostate{}; }, env);
+        trace->properties["start"] = PropertyDescriptor{start, false, false, true, Token()};
+
+        auto stop = make_native_fn("uv.trace.stop", [](const std::vector<Value>& args, EnvPtr, const Token& token) -> Value {
+            loop_trace_stop();
+            if (!args.empty() && std::holds_alternative<std::string>(args[0])) {
+                const std::string& path = std::get<std::string>(args[0]);
+                if (!loop_trace_write(path)) {
+                    throw SwaziError("IOError", "uv.trace.stop: cannot write " + path, token.loc);
+                }
+                return Value{true};
+            }
+            return Value{loop_trace_json()}; }, env);
+        trace->properties["stop"] = PropertyDescriptor{stop, false, false, true, Token()};
+
+        auto enabled = make_native_fn("uv.trace.enabled", [](const std::vector<Value>&, EnvPtr, const Token&) -> Value { return Value{loop_trace_enabled()}; }, env);
+        trace->properties["enabled"] = PropertyDescriptor{enabled, false, false, true, Token()};
+
+        obj->properties["trace"] = PropertyDescriptor{Value{trace}, false, false, true, Token()};
+    }
+
     // uv.getTotalMemory() -> number (bytes)
     {
         auto fn = make_native_fn("uv.getTotalMemory", [](const std::vector<Value>&, EnvPtr, const Token&) -> Value { return Value{static_cast<double>(uv_get_total_memory())}; }, env);
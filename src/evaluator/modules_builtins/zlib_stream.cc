@@ -0,0 +1,244 @@
+// zlib_stream.cc - incremental gzip/deflate behind ZlibStream.hpp
+#include "ZlibStream.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static const size_t ZLIB_OUT_CHUNK = 16 * 1024;
+
+#ifdef HAVE_ZLIB
+
+struct ZlibStream::Impl {
+    z_stream strm{};
+    bool deflating = false;
+    bool ready = false;
+    bool done = false;
+    bool failed = false;
+    std::string error;
+    uint64_t in_total = 0;
+    uint64_t out_total = 0;
+
+    // Decoders: the input seen before the first output byte, replayed as raw
+    // deflate if it turns out to carry neither a gzip nor a zlib header.
+    bool raw_fallback = false;
+    std::string head;
+    static const size_t HEAD_LIMIT = 64 * 1024;
+
+    ~Impl() {
+        if (!ready) return;
+        if (deflating) {
+            deflateEnd(&strm);
+        } else {
+            inflateEnd(&strm);
+        }
+    }
+
+    bool fail(const char* why) {
+        failed = true;
+        error = strm.msg ? strm.msg : why;
+        return false;
+    }
+
+    bool deflate_into(const uint8_t* data, size_t len, std::vector<uint8_t>& out, int flush) {
+        strm.next_in = const_cast<Bytef*>(data);
+        strm.avail_in = static_cast<uInt>(len);
+        size_t chunk = std::max(ZLIB_OUT_CHUNK, len / 2);
+        do {
+            size_t old = out.size();
+            out.resize(old + chunk);
+            strm.next_out = out.data() + old;
+            strm.avail_out = static_cast<uInt>(chunk);
+            int rc = deflate(&strm, flush);
+            out.resize(old + chunk - strm.avail_out);
+            if (rc == Z_STREAM_ERROR) return fail("deflate failed");
+            if (rc == Z_STREAM_END) done = true;
+        } while (strm.avail_out == 0);
+        return true;
+    }
+
+    bool inflate_into(const uint8_t* data, size_t len, std::vector<uint8_t>& out) {
+        strm.next_in = const_cast<Bytef*>(data);
+        strm.avail_in = static_cast<uInt>(len);
+        size_t chunk = std::max(ZLIB_OUT_CHUNK, len * 4);
+        size_t start = out.size();
+        while (!done) {
+            size_t old = out.size();
+            out.resize(old + chunk);
+            strm.next_out = out.data() + old;
+            strm.avail_out = static_cast<uInt>(chunk);
+            int rc = inflate(&strm, Z_NO_FLUSH);
+            out.resize(old + chunk - strm.avail_out);
+
+            if (rc == Z_STREAM_END) {
+                // Concatenated gzip members decode as one body; anything
+                // else after the end is ignored.
+                if (strm.avail_in >= 2 && strm.next_in[0] == 0x1f && strm.next_in[1] == 0x8b) {
+                    inflateReset(&strm);
+                    continue;
+                }
+                done = true;
+                break;
+            }
+            if (rc == Z_DATA_ERROR && !raw_fallback && out_total == 0 && out.size() == start) {
+                raw_fallback = true;
+                inflateReset2(&strm, -MAX_WBITS);
+                std::string replay;
+                replay.swap(head);
+                replay.append(reinterpret_cast<const char*>(data), len);
+                return inflate_into(reinterpret_cast<const uint8_t*>(replay.data()), replay.size(), out);
+            }
+            if (rc == Z_NEED_DICT || rc == Z_DATA_ERROR || rc == Z_MEM_ERROR || rc == Z_STREAM_ERROR) {
+                return fail("invalid compressed data");
+            }
+            // Z_OK / Z_BUF_ERROR: go on while there is input left to take or
+            // the output buffer came back full.
+            if (strm.avail_in == 0 && strm.avail_out != 0) break;
+        }
+        if (!raw_fallback && out_total == 0 && out.size() == start && head.size() + len <= HEAD_LIMIT) {
+            head.append(reinterpret_cast<const char*>(data), len);
+        } else {
+            raw_fallback = true;
+            head.clear();
+        }
+        return true;
+    }
+};
+
+ZlibStream::ZlibStream(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+ZlibStream::~ZlibStream() = default;
+
+bool ZlibStream::available() { return true; }
+
+std::unique_ptr<ZlibStream> ZlibStream::encoder(Format format, int level) {
+    if (format == Format::None) return nullptr;
+    auto impl = std::make_unique<Impl>();
+    impl->deflating = true;
+    int bits = format == Format::Gzip ? MAX_WBITS + 16 : MAX_WBITS;
+    if (deflateInit2(&impl->strm, std::clamp(level, 0, 9), Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nullptr;
+    }
+    impl->ready = true;
+    return std::unique_ptr<ZlibStream>(new ZlibStream(std::move(impl)));
+}
+
+std::unique_ptr<ZlibStream> ZlibStream::decoder() {
+    auto impl = std::make_unique<Impl>();
+    // +32: detect a gzip or zlib header.
+    if (inflateInit2(&impl->strm, MAX_WBITS + 32) != Z_OK) return nullptr;
+    impl->ready = true;
+    return std::unique_ptr<ZlibStream>(new ZlibStream(std::move(impl)));
+}
+
+bool ZlibStream::write(const void* data, size_t len, std::vector<uint8_t>& out, Flush flush) {
+    Impl& s = *impl_;
+    if (s.failed) return false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    if (s.deflating) {
+        if (s.done) return true;
+        int zf = Z_NO_FLUSH;
+        if (flush == Flush::Sync) zf = Z_SYNC_FLUSH;
+        if (flush == Flush::Finish) zf = Z_FINISH;
+        size_t before = out.size();
+        bool ok = s.deflate_into(bytes, len, out, zf);
+        s.in_total += len;
+        s.out_total += out.size() - before;
+        return ok;
+    }
+    if (len == 0 || s.done) return true;
+    size_t before = out.size();
+    bool ok = s.inflate_into(bytes, len, out);
+    s.in_total += len;
+    s.out_total += out.size() - before;
+    return ok;
+}
+
+bool ZlibStream::done() const { return impl_->done; }
+const std::string& ZlibStream::error() const { return impl_->error; }
+uint64_t ZlibStream::total_in() const { return impl_->in_total; }
+uint64_t ZlibStream::total_out() const { return impl_->out_total; }
+
+#else  // !HAVE_ZLIB
+
+struct ZlibStream::Impl {
+    std::string error;
+};
+
+ZlibStream::ZlibStream(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+ZlibStream::~ZlibStream() = default;
+
+bool ZlibStream::available() { return false; }
+std::unique_ptr<ZlibStream> ZlibStream::encoder(Format, int) { return nullptr; }
+std::unique_ptr<ZlibStream> ZlibStream::decoder() { return nullptr; }
+bool ZlibStream::write(const void*, size_t, std::vector<uint8_t>&, Flush) { return false; }
+bool ZlibStream::done() const { return false; }
+const std::string& ZlibStream::error() const { return impl_->error; }
+uint64_t ZlibStream::total_in() const { return 0; }
+uint64_t ZlibStream::total_out() const { return 0; }
+
+#endif
+
+// ---- http content codings ----
+
+static bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+ZlibStream::Format http_content_coding(std::string_view value) {
+    value = trim(value);
+    if (iequals(value, "gzip") || iequals(value, "x-gzip")) return ZlibStream::Format::Gzip;
+    if (iequals(value, "deflate")) return ZlibStream::Format::Deflate;
+    return ZlibStream::Format::None;
+}
+
+ZlibStream::Format http_negotiate_coding(std::string_view accept_encoding) {
+    // -1: not listed.
+    double gzip_q = -1, deflate_q = -1, any_q = -1;
+
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        std::string_view name = trim(item.substr(0, semi));
+        double q = 1;
+        while (semi != std::string_view::npos) {
+            item = item.substr(semi + 1);
+            semi = item.find(';');
+            std::string_view param = trim(item.substr(0, semi));
+            if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                std::string num(trim(param.substr(2)));
+                q = std::strtod(num.c_str(), nullptr);
+            }
+        }
+
+        if (iequals(name, "gzip") || iequals(name, "x-gzip")) {
+            gzip_q = std::max(gzip_q, q);
+        } else if (iequals(name, "deflate")) {
+            deflate_q = q;
+        } else if (name == "*") {
+            any_q = q;
+        }
+    }
+
+    if (gzip_q < 0) gzip_q = any_q;
+    if (deflate_q < 0) deflate_q = any_q;
+    if (gzip_q <= 0 && deflate_q <= 0) return ZlibStream::Format::None;
+    return gzip_q >= deflate_q ? ZlibStream::Format::Gzip : ZlibStream::Format::Deflate;
+}
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "StdOutput.hpp"
 #include "cli_commands.hpp"
 #include "evaluator.hpp"
 #include "lexer.hpp"
@@ -110,9 +111,12 @@ static void run_file_mode(const std::string& filename, const std::vector<std::st
         evaluator.set_cli_args(cli_args);
         evaluator.set_entry_point(filename);
         evaluator.evaluate(ast.get());
+        std_output_flush();
     } catch (const std::exception& e) {
+        std_output_flush();
         std::cerr << "Error: " << e.what() << std::endl;
     } catch (...) {
+        std_output_flush();
         std::cerr << "Unknown fatal error\n";
     }
 }
@@ -145,6 +149,7 @@ int main(int argc, char* argv[]) {
                   << "  -v, --version    Print version and exit\n"
                   << "  -i               Start REPL (interactive)\n"
                   << "  -h, --help       Show this help message\n"
+                  << "  --stdout=MODE    Buffer stdout: auto (default), line, full or none\n"
                   << "\n"
                   << "Commands:\n"
                   << "  init             Initialize a new Swazi project\n"
@@ -219,6 +224,16 @@ int main(int argc, char* argv[]) {
             } else if (arg == "-h" || arg == "--help") {
                 print_usage();
                 return 0;
+            } else if (arg.rfind("--stdout=", 0) == 0) {
+                StdBuffering mode;
+                if (!std_output_parse_buffering(arg.substr(9), mode)) {
+                    std::cerr << "swazi: --stdout expects auto, line, full or none\n";
+                    return 1;
+                }
+                std_output_set_buffering(1, mode);
+                // Scripts see argv as if the option had not been given.
+                cli_args.erase(std::find(cli_args.begin(), cli_args.end(), arg));
+                continue;
             } else {
                 std::cerr << "swazi: unknown option '" << arg << "'\n";
                 std::cerr << "Try 'swazi --help' for more information.\n";
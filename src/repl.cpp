@@ -1,5 +1,6 @@
 #include "repl.hpp"
 
+#include "StdOutput.hpp"
 #include "colors.hpp"
 
 // Improved REPL indentation/block handling
@@ -265,6 +266,7 @@ void run_repl_mode() {
         // Pass the prompt (may include ANSI) directly to linenoise. linenoise now
         // computes printable width ignoring ANSI, so cursor math stays correct
         // while the visible colored prompt is drawn and preserved across edits.
+        std_output_flush();
         char* raw = linenoise(prompt.c_str());
         if (!raw) {  // EOF (Ctrl-D) or error
             std::cout << "\n";
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "DnsResolver.hpp"
+
+namespace {
+
+struct Answer {
+    bool called = false;
+    int status = 1;
+    std::vector<std::string> ips;
+};
+
+std::string ip_of(const sockaddr_storage& addr) {
+    char ip[INET6_ADDRSTRLEN] = {0};
+    if (addr.ss_family == AF_INET)
+        uv_ip4_name(reinterpret_cast<const sockaddr_in*>(&addr), ip, sizeof(ip));
+    else
+        uv_ip6_name(reinterpret_cast<const sockaddr_in6*>(&addr), ip, sizeof(ip));
+    return ip;
+}
+
+// Hosts-only answers arrive before dns_resolve returns, so no loop run is needed.
+Answer resolve(uv_loop_t* loop, const std::string& host, int family) {
+    Answer a;
+    dns_resolve(loop, host, family, [&a](int status, const std::vector<sockaddr_storage>& addrs) {
+        a.called = true;
+        a.status = status;
+        for (const auto& addr : addrs) a.ips.push_back(ip_of(addr));
+    });
+    return a;
+}
+
+class DnsResolverTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        uv_loop_init(&loop);
+        path = ::testing::TempDir() + "swazi_dns_hosts";
+        std::ofstream out(path);
+        out << "# test hosts\n"
+            << "127.0.0.1   crawler.test  alias.test\n"
+            << "10.0.0.2    crawler.test  # second address\n"
+            << "::1         v6.test\n";
+    }
+
+    void TearDown() override {
+        dns_configure(DnsOptions{});
+        uv_loop_close(&loop);
+        std::remove(path.c_str());
+    }
+
+    uv_loop_t loop;
+    std::string path;
+};
+
+}  // namespace
+
+TEST_F(DnsResolverTest, HostsOnlyAnswersFromTheFileAlone) {
+    DnsOptions o;
+    o.hosts_only = true;
+    o.hosts_file = path;
+    ASSERT_TRUE(dns_configure(o));
+    uint64_t lookups = dns_stats().lookups;
+
+    Answer a = resolve(&loop, "Crawler.Test", AF_UNSPEC);
+    ASSERT_TRUE(a.called);
+    EXPECT_EQ(a.status, 0);
+    EXPECT_EQ(a.ips, (std::vector<std::string>{"127.0.0.1", "10.0.0.2"}));
+
+    EXPECT_EQ(resolve(&loop, "alias.test", AF_INET).ips, std::vector<std::string>{"127.0.0.1"});
+    EXPECT_EQ(resolve(&loop, "v6.test", AF_INET6).ips, std::vector<std::string>{"::1"});
+    EXPECT_EQ(resolve(&loop, "v6.test", AF_INET).status, UV_EAI_NONAME);
+
+    Answer missing = resolve(&loop, "example.com", AF_UNSPEC);
+    ASSERT_TRUE(missing.called);
+    EXPECT_EQ(missing.status, UV_EAI_NONAME);
+    EXPECT_TRUE(missing.ips.empty());
+    EXPECT_EQ(dns_stats().lookups, lookups);
+}
+
+TEST_F(DnsResolverTest, LiteralsSkipTheCache) {
+    uint64_t lookups = dns_stats().lookups;
+    Answer a = resolve(&loop, "[::1]", AF_UNSPEC);
+    ASSERT_TRUE(a.called);
+    EXPECT_EQ(a.ips, std::vector<std::string>{"::1"});
+    EXPECT_EQ(resolve(&loop, "192.0.2.7", AF_INET6).status, UV_EAI_ADDRFAMILY);
+    EXPECT_EQ(dns_stats().lookups, lookups);
+    EXPECT_EQ(dns_stats().entries, 0u);
+}
+
+TEST_F(DnsResolverTest, RememberedAddressesAreServedUntilCleared) {
+    sockaddr_storage addr{};
+    uv_ip4_addr("192.0.2.10", 0, reinterpret_cast<sockaddr_in*>(&addr));
+    dns_remember("fetch.test", addr);
+
+    std::vector<sockaddr_storage> out;
+    ASSERT_TRUE(dns_lookup_cached("fetch.test", AF_UNSPEC, out));
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(ip_of(out[0]), "192.0.2.10");
+    EXPECT_FALSE(dns_lookup_cached("fetch.test", AF_INET6, out));
+
+    Answer a = resolve(&loop, "fetch.test", AF_INET);
+    ASSERT_TRUE(a.called);
+    EXPECT_EQ(a.ips, std::vector<std::string>{"192.0.2.10"});
+
+    dns_clear();
+    EXPECT_FALSE(dns_lookup_cached("fetch.test", AF_UNSPEC, out));
+
+    DnsOptions o;
+    o.ttl_ms = 0;
+    ASSERT_TRUE(dns_configure(o));
+    dns_remember("fetch.test", addr);
+    EXPECT_FALSE(dns_lookup_cached("fetch.test", AF_UNSPEC, out));
+}
+
+TEST_F(DnsResolverTest, UnreadableHostsFileKeepsTheOldSettings) {
+    DnsOptions o;
+    o.hosts_only = true;
+    o.hosts_file = path;
+    ASSERT_TRUE(dns_configure(o));
+
+    o.hosts_file = path + ".missing";
+    EXPECT_FALSE(dns_configure(o));
+    EXPECT_EQ(dns_options().hosts_file, path);
+    EXPECT_EQ(resolve(&loop, "crawler.test", AF_INET).status, 0);
+}
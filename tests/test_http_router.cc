@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "HttpRouter.hpp"
+#include "evaluator.hpp"
+
+// A native handler that appends `tag` to `log` and, when given next(), calls it.
+static FunctionPtr recorder(std::vector<std::string>& log, const std::string& tag, bool call_next = true) {
+    return std::make_shared<FunctionValue>(
+        tag,
+        [&log, tag, call_next](const std::vector<Value>& args, EnvPtr env, const Token&) -> Value {
+            log.push_back(tag);
+            if (call_next && args.size() >= 3 && std::holds_alternative<FunctionPtr>(args[2])) {
+                std::get<FunctionPtr>(args[2])->native_impl({}, env, Token{});
+            }
+            return std::monostate{};
+        },
+        nullptr, Token{});
+}
+
+static std::string param(const ObjectPtr& req, const std::string& name) {
+    auto params = std::get<ObjectPtr>(req->properties.at("params").value);
+    auto it = params->properties.find(name);
+    return it == params->properties.end() ? std::string("<none>") : std::get<std::string>(it->second.value);
+}
+
+TEST(HttpRouterTest, PrefersLiteralThenParamThenWildcard) {
+    Evaluator ev;
+    std::vector<std::string> log;
+    HttpRouter router;
+    router.add("GET", "/users/me", {recorder(log, "me")});
+    router.add("GET", "/users/:id", {recorder(log, "user")});
+    router.add("GET", "/users/:id/posts/*", {recorder(log, "posts")});
+    router.add("GET", "/files/*path", {recorder(log, "files")});
+
+    auto req = std::make_shared<ObjectValue>();
+    auto res = std::make_shared<ObjectValue>();
+
+    EXPECT_EQ(router.dispatch("GET", "/users/me", req, res, &ev, nullptr), HttpRouter::Result::Handled);
+    EXPECT_EQ(router.dispatch("GET", "/users/mel", req, res, &ev, nullptr), HttpRouter::Result::Handled);
+    EXPECT_EQ(param(req, "id"), "mel");
+
+    EXPECT_EQ(router.dispatch("GET", "/users/7/posts/2024/intro", req, res, &ev, nullptr), HttpRouter::Result::Handled);
+    EXPECT_EQ(param(req, "id"), "7");
+    EXPECT_EQ(param(req, "*"), "2024/intro");
+
+    EXPECT_EQ(router.dispatch("GET", "/files/a/b.txt", req, res, &ev, nullptr), HttpRouter::Result::Handled);
+    EXPECT_EQ(param(req, "path"), "a/b.txt");
+
+    EXPECT_EQ(log, (std::vector<std::string>{"me", "user", "posts", "files"}));
+    EXPECT_EQ(router.route_count(), 4u);
+}
+
+TEST(HttpRouterTest, ReportsNotFoundAndAllowedMethods) {
+    Evaluator ev;
+    std::vector<std::string> log;
+    HttpRouter router;
+    router.add("GET", "/items/:id", {recorder(log, "get")});
+    router.add("PUT", "/items/:id", {recorder(log, "put")});
+
+    auto req = std::make_shared<ObjectValue>();
+    auto res = std::make_shared<ObjectValue>();
+    std::string allow;
+
+    EXPECT_EQ(router.dispatch("GET", "/items", req, res, &ev, nullptr), HttpRouter::Result::NotFound);
+    EXPECT_EQ(router.dispatch("GET", "/items/", req, res, &ev, nullptr), HttpRouter::Result::NotFound);
+    EXPECT_EQ(router.dispatch("POST", "/items/3", req, res, &ev, nullptr, &allow), HttpRouter::Result::MethodNotAllowed);
+    EXPECT_EQ(allow, "GET, PUT");
+
+    // HEAD is answered by the GET route.
+    EXPECT_EQ(router.dispatch("HEAD", "/items/3", req, res, &ev, nullptr), HttpRouter::Result::Handled);
+    EXPECT_EQ(log, (std::vector<std::string>{"get"}));
+}
+
+TEST(HttpRouterTest, RunsMiddlewareOnlyForMatchedRoutesUnderPrefix) {
+    Evaluator ev;
+    std::vector<std::string> log;
+    HttpRouter router;
+    router.use("/", {recorder(log, "all")});
+    router.use("/api/", {recorder(log, "api")});
+    router.add("GET", "/api/ping", {recorder(log, "auth"), recorder(log, "ping")});
+    router.add("GET", "/apiary", {recorder(log, "bees")});
+
+    auto req = std::make_shared<ObjectValue>();
+    auto res = std::make_shared<ObjectValue>();
+
+    router.dispatch("GET", "/api/ping", req, res, &ev, nullptr);
+    EXPECT_EQ(log, (std::vector<std::string>{"all", "api", "auth", "ping"}));
+
+    log.clear();
+    router.dispatch("GET", "/apiary", req, res, &ev, nullptr);
+    EXPECT_EQ(log, (std::vector<std::string>{"all", "bees"}));
+
+    log.clear();
+    router.dispatch("GET", "/nowhere", req, res, &ev, nullptr);
+    EXPECT_TRUE(log.empty());
+}
+
+TEST(HttpRouterTest, StopsWhenMiddlewareDoesNotCallNext) {
+    Evaluator ev;
+    std::vector<std::string> log;
+    HttpRouter router;
+    router.use("/", {recorder(log, "gate", false)});
+    router.add("GET", "/", {recorder(log, "home")});
+
+    auto req = std::make_shared<ObjectValue>();
+    auto res = std::make_shared<ObjectValue>();
+    router.dispatch("GET", "/", req, res, &ev, nullptr);
+    EXPECT_EQ(log, (std::vector<std::string>{"gate"}));
+}
+
+TEST(HttpRouterTest, RejectsMalformedPatterns) {
+    HttpRouter router;
+    router.add("GET", "/a/:id", {});
+    EXPECT_THROW(router.add("GET", "a", {}), std::invalid_argument);
+    EXPECT_THROW(router.add("GET", "/a/:", {}), std::invalid_argument);
+    EXPECT_THROW(router.add("GET", "/a/x:id", {}), std::invalid_argument);
+    EXPECT_THROW(router.add("GET", "/a/*/b", {}), std::invalid_argument);
+    EXPECT_THROW(router.add("GET", "/a/:name/edit", {}), std::invalid_argument);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "HttpFileCache.hpp"
+
+TEST(HttpStaticTest, ParsesSingleByteRanges) {
+    uint64_t first = 0, last = 0;
+
+    EXPECT_EQ(http_parse_range("bytes=0-99", 1000, &first, &last), 1);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(last, 99u);
+
+    EXPECT_EQ(http_parse_range("bytes=900-", 1000, &first, &last), 1);
+    EXPECT_EQ(first, 900u);
+    EXPECT_EQ(last, 999u);
+
+    EXPECT_EQ(http_parse_range("bytes=-100", 1000, &first, &last), 1);
+    EXPECT_EQ(first, 900u);
+    EXPECT_EQ(last, 999u);
+
+    // The end is clamped; a suffix longer than the file takes all of it.
+    EXPECT_EQ(http_parse_range("bytes=500-5000", 1000, &first, &last), 1);
+    EXPECT_EQ(last, 999u);
+    EXPECT_EQ(http_parse_range("bytes=-5000", 1000, &first, &last), 1);
+    EXPECT_EQ(first, 0u);
+
+    EXPECT_EQ(http_parse_range("bytes=1000-", 1000, &first, &last), -1);
+    EXPECT_EQ(http_parse_range("bytes=-0", 1000, &first, &last), -1);
+
+    // Ignored: other units, several ranges, malformed.
+    EXPECT_EQ(http_parse_range("items=0-1", 1000, &first, &last), 0);
+    EXPECT_EQ(http_parse_range("bytes=0-1,5-6", 1000, &first, &last), 0);
+    EXPECT_EQ(http_parse_range("bytes=9-1", 1000, &first, &last), 0);
+    EXPECT_EQ(http_parse_range("bytes=x-1", 1000, &first, &last), 0);
+}
+
+TEST(HttpStaticTest, FormatsAndParsesHttpDates) {
+    EXPECT_EQ(http_format_date(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+
+    int64_t t = 0;
+    ASSERT_TRUE(http_parse_date("Sun, 06 Nov 1994 08:49:37 GMT", &t));
+    EXPECT_EQ(t, 784111777);
+    ASSERT_TRUE(http_parse_date("Sunday, 06-Nov-94 08:49:37 GMT", &t));
+    EXPECT_EQ(t, 784111777);
+    ASSERT_TRUE(http_parse_date("Sun Nov  6 08:49:37 1994", &t));
+    EXPECT_EQ(t, 784111777);
+    EXPECT_FALSE(http_parse_date("yesterday", &t));
+}
+
+TEST(HttpStaticTest, MatchesEtagsWeakly) {
+    EXPECT_TRUE(http_etag_matches("W/\"10-5\"", "W/\"10-5\""));
+    EXPECT_TRUE(http_etag_matches("\"10-5\"", "W/\"10-5\""));
+    EXPECT_TRUE(http_etag_matches("\"a\", W/\"10-5\"", "W/\"10-5\""));
+    EXPECT_TRUE(http_etag_matches("*", "W/\"10-5\""));
+    EXPECT_FALSE(http_etag_matches("W/\"10-6\"", "W/\"10-5\""));
+}
+
+TEST(HttpStaticTest, PicksContentTypeByExtension) {
+    EXPECT_STREQ(http_mime_type("/srv/www/index.HTML"), "text/html; charset=utf-8");
+    EXPECT_STREQ(http_mime_type("app.js"), "text/javascript; charset=utf-8");
+    EXPECT_STREQ(http_mime_type("/img/logo.png"), "image/png");
+    EXPECT_STREQ(http_mime_type("/v1.2/README"), "application/octet-stream");
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "HttpTls.hpp"
+
+#ifdef HAVE_OPENSSL
+#include <openssl/bio.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+// A throwaway self-signed P-256 certificate and its key, as PEM.
+static void make_cert(std::string& cert_pem, std::string& key_pem) {
+    EVP_PKEY* pkey = EVP_EC_gen("P-256");
+    X509* x = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(x), 1);
+    X509_gmtime_adj(X509_getm_notBefore(x), 0);
+    X509_gmtime_adj(X509_getm_notAfter(x), 3600);
+    X509_set_pubkey(x, pkey);
+    X509_NAME* name = X509_get_subject_name(x);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(x, name);
+    X509_sign(x, pkey, EVP_sha256());
+
+    BIO* b = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(b, x);
+    char* p = nullptr;
+    long n = BIO_get_mem_data(b, &p);
+    cert_pem.assign(p, static_cast<size_t>(n));
+    BIO_free(b);
+
+    b = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(b, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    n = BIO_get_mem_data(b, &p);
+    key_pem.assign(p, static_cast<size_t>(n));
+    BIO_free(b);
+
+    X509_free(x);
+    EVP_PKEY_free(pkey);
+}
+
+// A client over memory BIOs, pumped against an HttpTlsSession.
+struct TestClient {
+    SSL_CTX* ctx;
+    SSL* ssl;
+    BIO* in;
+    BIO* out;
+
+    explicit TestClient(SSL_CTX* c, SSL_SESSION* resume = nullptr) : ctx(c) {
+        ssl = SSL_new(ctx);
+        in = BIO_new(BIO_s_mem());
+        out = BIO_new(BIO_s_mem());
+        BIO_set_mem_eof_return(in, -1);
+        SSL_set_bio(ssl, in, out);
+        SSL_set_connect_state(ssl);
+        if (resume) SSL_set_session(ssl, resume);
+    }
+    ~TestClient() {
+        SSL_shutdown(ssl);  // an unclosed session is not offered for resumption
+        SSL_free(ssl);
+    }
+
+    std::string take() {
+        std::string s(BIO_ctrl_pending(out), '\0');
+        if (!s.empty()) BIO_read(out, s.data(), static_cast<int>(s.size()));
+        return s;
+    }
+
+    // Run the handshake to completion; the server's output is fed back in.
+    bool handshake(HttpTlsSession& server) {
+        for (int i = 0; i < 10; i++) {
+            SSL_do_handshake(ssl);
+            std::string wire = take(), plain, reply;
+            if (!server.read(wire.data(), wire.size(), plain, reply)) return false;
+            BIO_write(in, reply.data(), static_cast<int>(reply.size()));
+            if (SSL_is_init_finished(ssl) && server.established()) {
+                char sink[64];
+                SSL_read(ssl, sink, sizeof(sink));  // take any session tickets
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+static SSL_CTX* client_ctx() {
+    SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(c, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_CLIENT);
+    static const unsigned char protos[] = "\x02h2\x08http/1.1";
+    SSL_CTX_set_alpn_protos(c, protos, sizeof(protos) - 1);
+    return c;
+}
+
+TEST(HttpTlsTest, HandshakesAndCarriesRecordsBothWays) {
+    HttpTlsOptions opts;
+    make_cert(opts.cert, opts.key);
+    HttpTlsContextPtr ctx = http_tls_context_create(opts);
+
+    SSL_CTX* cctx = client_ctx();
+    {
+        TestClient client(cctx);
+        HttpTlsSession server(ctx);
+        ASSERT_TRUE(client.handshake(server)) << server.error();
+        EXPECT_EQ(server.alpn(), "http/1.1");
+        EXPECT_FALSE(server.protocol().empty());
+
+        const char request[] = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+        SSL_write(client.ssl, request, sizeof(request) - 1);
+        std::string wire = client.take(), plain, reply;
+        ASSERT_TRUE(server.read(wire.data(), wire.size(), plain, reply));
+        EXPECT_EQ(plain, request);
+
+        std::string response(40000, 'r');
+        std::string sealed;
+        ASSERT_TRUE(server.write(response.data(), response.size(), sealed));
+        BIO_write(client.in, sealed.data(), static_cast<int>(sealed.size()));
+        std::string got(response.size(), '\0');
+        size_t have = 0;
+        while (have < got.size()) {
+            int r = SSL_read(client.ssl, &got[have], static_cast<int>(got.size() - have));
+            ASSERT_GT(r, 0);
+            have += static_cast<size_t>(r);
+        }
+        EXPECT_EQ(got, response);
+
+        std::string notify;
+        server.shutdown(notify);
+        EXPECT_FALSE(notify.empty());
+    }
+    SSL_CTX_free(cctx);
+}
+
+TEST(HttpTlsTest, ResumesSessionsFromTheSharedContext) {
+    HttpTlsOptions opts;
+    make_cert(opts.cert, opts.key);
+    HttpTlsContextPtr ctx = http_tls_context_create(opts);
+    SSL_CTX* cctx = client_ctx();
+
+    SSL_SESSION* saved = nullptr;
+    {
+        TestClient first(cctx);
+        HttpTlsSession server(ctx);
+        ASSERT_TRUE(first.handshake(server));
+        EXPECT_FALSE(server.resumed());
+        saved = SSL_get1_session(first.ssl);
+    }
+    ASSERT_NE(saved, nullptr);
+    {
+        TestClient second(cctx, saved);
+        HttpTlsSession server(ctx);
+        ASSERT_TRUE(second.handshake(server));
+        EXPECT_TRUE(server.resumed());
+    }
+    SSL_SESSION_free(saved);
+    SSL_CTX_free(cctx);
+
+    HttpTlsStats stats = http_tls_stats(ctx);
+    EXPECT_EQ(stats.handshakes, 2u);
+    EXPECT_EQ(stats.resumed, 1u);
+}
+
+TEST(HttpTlsTest, RejectsMismatchedKeyAndGarbage) {
+    HttpTlsOptions a, b;
+    make_cert(a.cert, a.key);
+    make_cert(b.cert, b.key);
+
+    HttpTlsOptions mixed;
+    mixed.cert = a.cert;
+    mixed.key = b.key;
+    EXPECT_THROW(http_tls_context_create(mixed), std::runtime_error);
+
+    // Plain HTTP sent to the TLS port.
+    HttpTlsContextPtr ctx = http_tls_context_create(a);
+    HttpTlsSession server(ctx);
+    std::string plain, out;
+    const char junk[] = "GET / HTTP/1.1\r\n\r\n";
+    EXPECT_FALSE(server.read(junk, sizeof(junk) - 1, plain, out));
+    EXPECT_FALSE(server.established());
+    EXPECT_FALSE(server.error().empty());
+    EXPECT_EQ(http_tls_stats(ctx).failed, 1u);
+}
+
+#else
+
+TEST(HttpTlsTest, UnavailableWithoutOpenSSL) {
+    EXPECT_THROW(http_tls_context_create(HttpTlsOptions{}), std::runtime_error);
+}
+
+#endif
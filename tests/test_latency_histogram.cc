@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "LatencyHistogram.hpp"
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 50; v++) h.record(v);
+    EXPECT_EQ(h.count(), 50u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 50u);
+    EXPECT_DOUBLE_EQ(h.mean(), 25.5);
+    EXPECT_EQ(h.percentile(0.5), 25u);
+    EXPECT_EQ(h.percentile(0.9), 45u);
+    EXPECT_EQ(h.percentile(1.0), 50u);
+    EXPECT_EQ(h.percentile(0.0), 1u);
+}
+
+TEST(LatencyHistogramTest, LargeValuesStayWithinBucketError) {
+    LatencyHistogram h;
+    // 1ms .. 1s in 1ms steps: p50 = 500ms, p99 = 990ms, p999 = 999ms.
+    for (uint64_t ms = 1; ms <= 1000; ms++) h.record(ms * 1000);
+    auto near = [](uint64_t got, uint64_t want) {
+        return got >= want && got <= want + want / 60;
+    };
+    EXPECT_TRUE(near(h.percentile(0.5), 500000)) << h.percentile(0.5);
+    EXPECT_TRUE(near(h.percentile(0.99), 990000)) << h.percentile(0.99);
+    EXPECT_TRUE(near(h.percentile(0.999), 999000)) << h.percentile(0.999);
+    EXPECT_EQ(h.percentile(1.0), 1000000u);  // clamped to the real maximum
+}
+
+TEST(LatencyHistogramTest, OutlierOnlyMovesTheTail) {
+    LatencyHistogram h;
+    for (int i = 0; i < 9990; i++) h.record(200);
+    for (int i = 0; i < 10; i++) h.record(2000000);
+    // 200us shares a two-wide bucket; the upper edge is reported.
+    EXPECT_EQ(h.percentile(0.5), 201u);
+    EXPECT_EQ(h.percentile(0.99), 201u);
+    EXPECT_GE(h.percentile(0.9995), 2000000u);
+
+    uint64_t total = 0;
+    for (const auto& b : h.buckets()) total += b.count;
+    EXPECT_EQ(total, h.count());
+    EXPECT_EQ(h.buckets().size(), 2u);
+}
+
+TEST(LatencyHistogramTest, MergeAndReset) {
+    LatencyHistogram a, b;
+    a.record(10);
+    b.record(1000);
+    b.record(3000);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 3u);
+    EXPECT_EQ(a.min(), 10u);
+    EXPECT_EQ(a.max(), 3000u);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0u);
+    EXPECT_EQ(a.percentile(0.99), 0u);
+    EXPECT_TRUE(a.buckets().empty());
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "LoopTrace.hpp"
+
+TEST(LoopTraceTest, HistogramPercentilesUseBucketUpperBounds) {
+    LoopHistogram h;
+    for (int i = 0; i < 98; ++i) h.record(3);  // bucket [2, 4)
+    h.record(1500);                            // bucket [1024, 2048)
+    h.record(5000);
+
+    EXPECT_EQ(h.total, 100u);
+    EXPECT_EQ(h.max_us, 5000u);
+    EXPECT_EQ(h.percentile(0.50), 4u);
+    EXPECT_EQ(h.percentile(0.99), 2048u);
+    EXPECT_EQ(h.percentile(1.0), 5000u);  // clamped to the observed max
+}
+
+TEST(LoopTraceTest, RecordsTasksOnlyWhileEnabled) {
+    loop_trace_task("io", "before-start", 1000, 1000, 0);
+    loop_trace_start();
+    loop_trace_task("timer", "tick @ main.sl:3:1", 2000000, 500000, 250000);
+    loop_trace_lag(3000000, 1200);
+    loop_trace_stop();
+    loop_trace_task("io", "after-stop", 4000000, 1000, 0);
+
+    std::string json = loop_trace_json();
+    EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"timer\""), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":2000,\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"wait_us\":250"), std::string::npos);
+    EXPECT_NE(json.find("tick @ main.sl:3:1"), std::string::npos);
+    EXPECT_NE(json.find("\"lag_ms\":1.2"), std::string::npos);
+    EXPECT_EQ(json.find("before-start"), std::string::npos);
+    EXPECT_EQ(json.find("after-stop"), std::string::npos);
+}
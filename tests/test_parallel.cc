@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "SwaziError.hpp"
+#include "evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+static void evalProgram(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    ev.evaluate(prog.get());
+}
+
+static Value evalExpr(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test-expr>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    if (!prog || prog->body.size() < 1u) {
+        throw std::runtime_error("parse produced empty program for expression helper");
+    }
+    auto* es = dynamic_cast<ExpressionStatementNode*>(prog->body[0].get());
+    if (!es) {
+        throw std::runtime_error("expected an ExpressionStatement in helper");
+    }
+    return ev.evaluate_expression(es->expression.get());
+}
+
+class ParallelArrayTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        ev.set_entry_point("<test>");
+        evalProgram(ev,
+            "data items = []\n"
+            "kwa (i = 0; i < 1000; i++):\n"
+            "  items.push(i)\n");
+    }
+    Evaluator ev;
+};
+
+TEST_F(ParallelArrayTest, ResultsMatchSerialInInputOrder) {
+    evalProgram(ev,
+        "data sq = items.pmap((x) => x * x, {chunk: 7, workers: 4})\n"
+        "data ev = items.pfilter((x) => x % 3 == 0, {chunk: 50})\n"
+        "data sum = items.preduce((a, b) => a + b, 0, {chunk: 33})\n");
+
+    Value sq = evalExpr(ev, "sq\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(sq));
+    auto& sq_items = std::get<ArrayPtr>(sq)->elements;
+    ASSERT_EQ(sq_items.size(), 1000u);
+    for (size_t i = 0; i < sq_items.size(); ++i) EXPECT_EQ(std::get<double>(sq_items[i]), double(i * i));
+
+    Value ev3 = evalExpr(ev, "ev\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(ev3));
+    auto& ev_items = std::get<ArrayPtr>(ev3)->elements;
+    ASSERT_EQ(ev_items.size(), 334u);
+    for (size_t i = 0; i < ev_items.size(); ++i) EXPECT_EQ(std::get<double>(ev_items[i]), double(i * 3));
+
+    EXPECT_EQ(std::get<double>(evalExpr(ev, "sum\n")), 999.0 * 1000.0 / 2.0);
+}
+
+TEST_F(ParallelArrayTest, CallbackErrorsReachTheCaller) {
+    // Every chunk fails at once; the first error is reported, not a torn one.
+    try {
+        evalProgram(ev, "items.pmap((x) => { tupa \"bad \" + x }, {chunk: 1, workers: 8})\n");
+        FAIL() << "pmap should have thrown";
+    } catch (const SwaziError& e) {
+        EXPECT_NE(std::string(e.what()).find("pmap() worker failed"), std::string::npos) << e.what();
+        EXPECT_NE(std::string(e.what()).find("bad"), std::string::npos) << e.what();
+    }
+    EXPECT_THROW(evalProgram(ev, "items.pfilter((x) => { tupa \"bad\" }, {chunk: 10})\n"), SwaziError);
+    EXPECT_THROW(evalProgram(ev, "items.preduce((a, b) => { tupa \"bad\" })\n"), SwaziError);
+
+    // A non-function callback is rejected before any thread starts.
+    EXPECT_THROW(evalProgram(ev, "items.pmap(5)\n"), SwaziError);
+}
+
+TEST_F(ParallelArrayTest, EmptyArray) {
+    Value m = evalExpr(ev, "[].pmap((x) => x)\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(m));
+    EXPECT_TRUE(std::get<ArrayPtr>(m)->elements.empty());
+
+    Value f = evalExpr(ev, "[].pfilter((x) => kweli)\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(f));
+    EXPECT_TRUE(std::get<ArrayPtr>(f)->elements.empty());
+
+    EXPECT_EQ(std::get<double>(evalExpr(ev, "[].preduce((a, b) => a + b, 42)\n")), 42.0);
+    EXPECT_THROW(evalExpr(ev, "[].preduce((a, b) => a + b)\n"), SwaziError);
+}
+
+TEST_F(ParallelArrayTest, ParallelNamespaceFunctions) {
+    evalProgram(ev,
+        "data tripled = parallel.map(items, (x) => x * 3, {chunk: 64})\n"
+        "data odd = parallel.filter(items, (x) => x % 2 == 1)\n"
+        "data total = parallel.reduce(items, (a, b) => a + b, 10, {chunk: 100})\n");
+
+    Value m = evalExpr(ev, "tripled\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(m));
+    auto& m_items = std::get<ArrayPtr>(m)->elements;
+    ASSERT_EQ(m_items.size(), 1000u);
+    for (size_t i = 0; i < m_items.size(); ++i) EXPECT_EQ(std::get<double>(m_items[i]), double(i * 3));
+
+    Value f = evalExpr(ev, "odd\n");
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(f));
+    EXPECT_EQ(std::get<ArrayPtr>(f)->elements.size(), 500u);
+
+    EXPECT_EQ(std::get<double>(evalExpr(ev, "total\n")), 999.0 * 1000.0 / 2.0 + 10.0);
+    EXPECT_THROW(evalProgram(ev, "parallel.map(5, (x) => x)\n"), SwaziError);
+}
+
+TEST_F(ParallelArrayTest, ReduceFoldsPartialsInIsolation) {
+    // Captured variables are out of reach in every pass, the final fold included.
+    evalProgram(ev, "data k = 2\n");
+    EXPECT_THROW(evalProgram(ev, "items.preduce((a, b) => a + b * k, 0, {chunk: 100})\n"), SwaziError);
+    EXPECT_THROW(evalProgram(ev, "parallel.reduce([1, 2], (a, b) => a + b * k, 0)\n"), SwaziError);
+
+    // The final fold sees each partial with the index of its chunk's first element.
+    Value idx = evalExpr(ev, "[5, 6, 7, 8].preduce((a, b, i) => a + \",\" + i, \"s\", {chunk: 2, workers: 1})\n");
+    EXPECT_EQ(std::get<std::string>(idx), "s,0,2");
+}
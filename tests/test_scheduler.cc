@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Scheduler.hpp"
+#include "SwaziError.hpp"
+#include "evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "uv.h"
+
+static void evalProgram(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    ev.evaluate(prog.get());
+}
+
+static Value evalExpr(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test-expr>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    auto* es = dynamic_cast<ExpressionStatementNode*>(prog->body.at(0).get());
+    if (!es) throw std::runtime_error("expected an ExpressionStatement in helper");
+    return ev.evaluate_expression(es->expression.get());
+}
+
+static std::vector<std::string> stringArray(const Value& v) {
+    std::vector<std::string> out;
+    if (!std::holds_alternative<ArrayPtr>(v)) return out;
+    for (auto& e : std::get<ArrayPtr>(v)->elements) out.push_back(std::get<std::string>(e));
+    return out;
+}
+
+static void busyWaitMs(double ms) {
+    uint64_t until = uv_hrtime() + static_cast<uint64_t>(ms * 1e6);
+    while (uv_hrtime() < until) {
+    }
+}
+
+TEST(SchedulerTest, LanesRunHighestFirstAndFifoWithin) {
+    Scheduler s;
+    std::string order;
+    s.enqueue_macrotask([&] { order += "b"; }, TaskPriority::Background);
+    s.enqueue_macrotask([&] { order += "u1"; }, TaskPriority::User);
+    s.enqueue_macrotask([&] { order += "t"; }, TaskPriority::Timer);
+    s.enqueue_macrotask([&] { order += "u2"; }, TaskPriority::User);
+    s.enqueue_macrotask([&] { order += "i"; });  // I/O is the default lane
+
+    EXPECT_EQ(s.pending_macrotasks(TaskPriority::User), 2u);
+    while (s.run_one()) {
+    }
+    EXPECT_EQ(order, "itu1u2b");
+}
+
+TEST(SchedulerTest, AgingGivesAPassedOverLaneATurn) {
+    Scheduler s;
+    int ran = 0;
+    int background_at = -1;
+    s.enqueue_macrotask([&] { background_at = ran++; }, TaskPriority::Background);
+    for (int i = 0; i < 3 * SCHEDULER_AGING_LIMIT; i++) s.enqueue_macrotask([&] { ran++; });
+
+    while (s.run_one()) {
+    }
+    EXPECT_EQ(ran, 3 * SCHEDULER_AGING_LIMIT + 1);
+    EXPECT_EQ(background_at, SCHEDULER_AGING_LIMIT);
+}
+
+// Fifty queued user tasks of 1 ms each; the first starts a 0 ms timer whose
+// callback queues an I/O task.  Returns how many user tasks ran before it.
+struct SliceProbe {
+    Scheduler* s;
+    int ran = 0;
+    int io_at = -1;
+};
+
+static int ioTaskPosition(double budget_ms) {
+    uv_timer_t timer;
+    Scheduler s;
+    s.set_budget_ms(budget_ms);
+    SliceProbe probe{&s};
+    timer.data = &probe;
+    for (int i = 0; i < 50; i++) {
+        s.enqueue_macrotask([&, i] {
+            if (i == 0) {
+                uv_timer_init(s.get_uv_loop(), &timer);
+                uv_timer_start(&timer, [](uv_timer_t* t) {
+                    auto* probe = static_cast<SliceProbe*>(t->data);
+                    probe->s->enqueue_macrotask([probe] { probe->io_at = probe->ran; });
+                }, 0, 0);
+            }
+            busyWaitMs(1);
+            probe.ran++;
+        },
+            TaskPriority::User);
+    }
+    s.run_until_idle();
+    EXPECT_EQ(probe.ran, 50);
+    uv_close(reinterpret_cast<uv_handle_t*>(&timer), nullptr);
+    return probe.io_at;
+}
+
+TEST(SchedulerTest, BudgetLetsIoOvertakeQueuedWork) {
+    {
+        Scheduler s;
+        EXPECT_DOUBLE_EQ(s.budget_ms(), SCHEDULER_DEFAULT_BUDGET_MS);
+        s.set_budget_ms(2.5);
+        EXPECT_DOUBLE_EQ(s.budget_ms(), 2.5);
+    }
+
+    // Sliced: the loop is polled after about 5 ms, not after all 50 tasks.
+    int sliced = ioTaskPosition(5);
+    EXPECT_GE(sliced, 1);
+    EXPECT_LT(sliced, 25);
+
+    // Budget 0: queued work drains before I/O is polled.
+    EXPECT_EQ(ioTaskPosition(0), 50);
+}
+
+TEST(SchedulerTest, PostTaskPrioritiesMapToLanes) {
+    Evaluator ev;
+    ev.set_entry_point("<test>");
+    evalProgram(ev,
+        "tumia events\n"
+        "data order = []\n"
+        "data e = events.create()\n"
+        "e.on(\"x\", () => order.push(\"emit\"))\n"
+        "scheduler.postTask(() => order.push(\"background\"), {priority: \"background\"})\n"
+        "scheduler.postTask(() => order.push(\"default\"))\n"
+        "scheduler.postTask(() => order.push(\"visible\"), {priority: \"user-visible\"})\n"
+        "scheduler.postTask(() => order.push(\"blocking\"), {priority: \"user-blocking\"})\n"
+        "e.emit(\"x\")\n");
+
+    // Emits share the I/O lane, so completions queued after them stay behind.
+    EXPECT_EQ(stringArray(evalExpr(ev, "order\n")),
+        (std::vector<std::string>{"emit", "blocking", "default", "visible", "background"}));
+
+    EXPECT_THROW(evalProgram(ev, "scheduler.postTask(() => 1, {priority: \"urgent\"})\n"), SwaziError);
+    EXPECT_THROW(evalProgram(ev, "scheduler.postTask(5)\n"), SwaziError);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "StdOutput.hpp"
+#include "evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void evalProgram(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    ev.evaluate(prog.get());
+}
+
+// Runs in a forked copy of the test process with stdout on a pipe: print,
+// spawn a child sharing that stdout, and report what the child saw.
+static std::string runWithPipedStdout(const std::string& src) {
+    int fds[2];
+    if (pipe(fds) != 0) return "pipe failed";
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], 1);
+        close(fds[1]);
+        {
+            Evaluator ev;
+            ev.set_entry_point("<test>");
+            evalProgram(ev, src);
+        }
+        std_output_flush();
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof buf)) > 0) out.append(buf, static_cast<size_t>(n));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return out;
+}
+
+TEST(StdOutputTest, SpawnedChildInheritsBlockingStdout) {
+    std::string out = runWithPipedStdout(
+        "tumia subprocess\n"
+        "chapisha \"parent\"\n"
+        "subprocess.spawn(\"sh\", [\"-c\", \"grep ^flags: /proc/self/fdinfo/1\"], {stdio: \"inherit\"})\n");
+
+    ASSERT_EQ(out.rfind("parent\n", 0), 0u) << out;
+    size_t at = out.find("flags:");
+    ASSERT_NE(at, std::string::npos) << out;
+    long flags = std::stol(out.substr(at + 6), nullptr, 8);
+    EXPECT_EQ(flags & O_NONBLOCK, 0) << out;
+}
+
+TEST(StdOutputTest, QueuedOutputIsWrittenBeforeTheChild) {
+    std::string out = runWithPipedStdout(
+        "data line = \"x\".rudia(1000)\n"
+        "kwa (i = 0; i < 500; i++):\n"
+        "  chapisha line\n"
+        "tumia subprocess\n"
+        "subprocess.spawn(\"sh\", [\"-c\", \"grep ^flags: /proc/self/fdinfo/1\"], {stdio: \"inherit\"})\n");
+
+    EXPECT_EQ(out.find("flags:"), 500u * 1001u) << out.substr(0, 200);
+    size_t at = out.find("flags:");
+    ASSERT_NE(at, std::string::npos);
+    EXPECT_EQ(std::stol(out.substr(at + 6), nullptr, 8) & O_NONBLOCK, 0);
+}
+#endif
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "StdinLines.hpp"
+
+static void push(LineSplitter& s, const std::string& block) { s.push(block.data(), block.size()); }
+
+static std::vector<std::string> drain(LineSplitter& s) {
+    std::vector<std::string> out;
+    while (!s.ready.empty()) out.push_back(s.take());
+    return out;
+}
+
+TEST(StdinLinesTest, SplitsOnNewlineAndCrlf) {
+    LineSplitter s;
+    push(s, "one\ntwo\r\n\r\nthree\n");
+    EXPECT_EQ(drain(s), (std::vector<std::string>{"one", "two", "", "three"}));
+    EXPECT_TRUE(s.carry.empty());
+    EXPECT_EQ(s.buffered, 0u);
+}
+
+TEST(StdinLinesTest, LineSpanningSeveralBlocks) {
+    LineSplitter s;
+    push(s, "first\nthe sec");
+    push(s, "ond li");
+    push(s, "ne\r");
+    EXPECT_EQ(drain(s), (std::vector<std::string>{"first"}));
+    EXPECT_EQ(s.carry, "the second line\r");
+
+    // The "\n" of a "\r\n" split across two blocks still drops the "\r".
+    push(s, "\nlast");
+    EXPECT_EQ(drain(s), (std::vector<std::string>{"the second line"}));
+
+    s.finish();
+    EXPECT_EQ(drain(s), (std::vector<std::string>{"last"}));
+    s.finish();
+    EXPECT_TRUE(s.ready.empty());
+}
+
+TEST(StdinLinesTest, BufferedCountsTerminators) {
+    // Empty lines still use up the read-ahead limit.
+    LineSplitter s;
+    push(s, std::string(1000, '\n'));
+    EXPECT_EQ(s.ready.size(), 1000u);
+    EXPECT_EQ(s.buffered, 1000u);
+
+    push(s, "abc\r\nxy");
+    EXPECT_EQ(s.buffered, 1004u);
+    s.finish();
+    EXPECT_EQ(s.buffered, 1007u);
+
+    while (s.ready.size() > 2) s.take();
+    EXPECT_EQ(s.buffered, 7u);
+    EXPECT_EQ(drain(s), (std::vector<std::string>{"abc", "xy"}));
+    EXPECT_EQ(s.buffered, 0u);
+}
+
+TEST(StdinLinesTest, BatchKeepsOrderAcrossBlocks) {
+    LineSplitter s;
+    std::string input;
+    for (int i = 0; i < 5000; i++) input += std::to_string(i) + "\n";
+    for (size_t off = 0; off < input.size(); off += 4096) push(s, input.substr(off, 4096));
+    s.finish();
+
+    ASSERT_EQ(s.ready.size(), 5000u);
+    for (int i = 0; i < 5000; i++) EXPECT_EQ(s.take(), std::to_string(i));
+    EXPECT_EQ(s.buffered, 0u);
+}
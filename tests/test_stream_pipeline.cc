@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "StreamPipeline.hpp"
+
+// Runs `input` through `stage` `step` bytes at a time, then finishes it.
+static std::string run(PipeStage& stage, const std::string& input, size_t step, bool* ok = nullptr) {
+    std::vector<uint8_t> out;
+    bool good = true;
+    for (size_t off = 0; off < input.size() && good; off += step) {
+        size_t n = std::min(step, input.size() - off);
+        good = stage.write(reinterpret_cast<const uint8_t*>(input.data()) + off, n, out);
+    }
+    if (good) good = stage.finish(out);
+    if (ok) {
+        *ok = good;
+    } else {
+        EXPECT_TRUE(good) << stage.error();
+    }
+    return std::string(out.begin(), out.end());
+}
+
+TEST(StreamPipelineTest, LinesStageEmitsWholeLinesAndCounts) {
+    auto stage = make_lines_stage(1024);
+    std::vector<uint8_t> out;
+    const std::string a = "one\ntw", b = "o\nthr", c = "ee";
+
+    ASSERT_TRUE(stage->write(reinterpret_cast<const uint8_t*>(a.data()), a.size(), out));
+    EXPECT_EQ(std::string(out.begin(), out.end()), "one\n");
+    out.clear();
+    ASSERT_TRUE(stage->write(reinterpret_cast<const uint8_t*>(b.data()), b.size(), out));
+    EXPECT_EQ(std::string(out.begin(), out.end()), "two\n");
+    out.clear();
+    ASSERT_TRUE(stage->write(reinterpret_cast<const uint8_t*>(c.data()), c.size(), out));
+    EXPECT_TRUE(out.empty());
+    ASSERT_TRUE(stage->finish(out));
+    EXPECT_EQ(std::string(out.begin(), out.end()), "three");
+
+    PipeStats stats;
+    stage->report(stats);
+    EXPECT_TRUE(stats.counted_lines);
+    EXPECT_EQ(stats.lines, 3u);
+
+    // An overlong line is passed on rather than held.
+    auto small = make_lines_stage(4);
+    EXPECT_EQ(run(*small, "abcdefgh\nij", 3), "abcdefgh\nij");
+}
+
+TEST(StreamPipelineTest, GzipStagesRoundTrip) {
+    if (!ZlibStream::available()) GTEST_SKIP() << "built without zlib";
+    std::string text;
+    for (int i = 0; i < 5000; i++) text += "level=info msg=\"request " + std::to_string(i) + "\"\n";
+
+    auto gz = make_compress_stage(ZlibStream::Format::Gzip, 6);
+    std::string packed = run(*gz, text, 4096);
+    EXPECT_LT(packed.size() * 5, text.size());
+
+    auto gunzip = make_decompress_stage();
+    EXPECT_EQ(run(*gunzip, packed, 333), text);
+
+    bool ok = true;
+    auto cut = make_decompress_stage();
+    run(*cut, packed.substr(0, packed.size() / 2), 1000, &ok);
+    EXPECT_FALSE(ok);
+    EXPECT_FALSE(cut->error().empty());
+}
+
+TEST(StreamPipelineTest, HashStagePassesThroughAndDigests) {
+    auto hash = make_hash_stage("sha256");
+    ASSERT_TRUE(hash);
+    EXPECT_EQ(run(*hash, "abc", 1), "abc");
+    PipeStats stats;
+    hash->report(stats);
+    ASSERT_EQ(stats.digests.size(), 1u);
+    EXPECT_EQ(stats.digests[0], "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    EXPECT_FALSE(make_hash_stage("md5"));
+}
+
+TEST(StreamPipelineTest, EncryptStagesRoundTripAndRejectTampering) {
+    std::vector<uint8_t> key(32, 7);
+    std::string plain(10000, 'x');
+    for (size_t i = 0; i < plain.size(); i++) plain[i] = static_cast<char>('a' + i % 26);
+
+    // 10000 bytes in 4096-byte records: header + 3 records of 17 bytes overhead each.
+    auto enc = make_encrypt_stage(key, 4096);
+    std::string sealed = run(*enc, plain, 1500);
+    EXPECT_EQ(sealed.size(), 24 + plain.size() + 3 * 17);
+
+    auto dec = make_decrypt_stage(key, 4096);
+    EXPECT_EQ(run(*dec, sealed, 777), plain);
+
+    // An exact multiple of the record size still ends in a final record.
+    auto enc2 = make_encrypt_stage(key, 100);
+    auto dec2 = make_decrypt_stage(key, 100);
+    EXPECT_EQ(run(*dec2, run(*enc2, std::string(300, 'z'), 100), 50), std::string(300, 'z'));
+
+    bool ok = true;
+    std::string tampered = sealed;
+    tampered[100] ^= 1;
+    auto bad = make_decrypt_stage(key, 4096);
+    run(*bad, tampered, 4096, &ok);
+    EXPECT_FALSE(ok);
+
+    auto truncated = make_decrypt_stage(key, 4096);
+    run(*truncated, sealed.substr(0, 24 + 4096 + 17), 4096, &ok);
+    EXPECT_FALSE(ok);
+
+    EXPECT_FALSE(make_encrypt_stage(std::vector<uint8_t>(16, 1), 4096));
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "swazi.hpp"
+
+static void evalProgram(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    ev.evaluate(prog.get());
+}
+
+static Value evalExpr(Evaluator& ev, const std::string& src) {
+    Lexer lx(src, "<test-expr>");
+    auto toks = lx.tokenize();
+    Parser p(toks);
+    auto prog = p.parse();
+    if (!prog || prog->body.size() < 1u) {
+        throw std::runtime_error("parse produced empty program for expression helper");
+    }
+    auto* es = dynamic_cast<ExpressionStatementNode*>(prog->body[0].get());
+    if (!es) {
+        throw std::runtime_error("expected an ExpressionStatement in helper");
+    }
+    return ev.evaluate_expression(es->expression.get());
+}
+
+static Value roundTrip(const Value& v) {
+    std::vector<uint8_t> bytes = structured_clone_encode(v);
+    return structured_clone_decode(bytes.data(), bytes.size(), nullptr);
+}
+
+TEST(StructuredCloneTest, PreservesSharedReferencesAndCycles) {
+    auto shared = std::make_shared<ObjectValue>();
+    shared->properties["n"] = PropertyDescriptor{42.0, false, false, false, Token{}};
+
+    auto arr = std::make_shared<ArrayValue>();
+    arr->elements.push_back(shared);
+    arr->elements.push_back(shared);
+    arr->elements.push_back(arr);  // cycle
+
+    Value out = roundTrip(arr);
+    ASSERT_TRUE(std::holds_alternative<ArrayPtr>(out));
+    ArrayPtr copy = std::get<ArrayPtr>(out);
+    ASSERT_EQ(copy->elements.size(), 3u);
+    EXPECT_NE(copy.get(), arr.get());
+
+    auto a = std::get<ObjectPtr>(copy->elements[0]);
+    auto b = std::get<ObjectPtr>(copy->elements[1]);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_NE(a.get(), shared.get());
+    EXPECT_EQ(std::get<double>(a->properties["n"].value), 42.0);
+    EXPECT_EQ(std::get<ArrayPtr>(copy->elements[2]).get(), copy.get());
+}
+
+TEST(StructuredCloneTest, NumbersRoundTripExactly) {
+    for (double d : {0.0, -0.0, 1.0, -1.0, 2147483647.0, -2147483648.0, 1e300, 0.1, 4294967296.0}) {
+        Value out = roundTrip(d);
+        ASSERT_TRUE(std::holds_alternative<double>(out));
+        EXPECT_EQ(std::get<double>(out), d);
+        EXPECT_EQ(std::signbit(std::get<double>(out)), std::signbit(d));
+    }
+}
+
+TEST(StructuredCloneTest, RejectsNonTransferableValuesAndBadInput) {
+    Evaluator ev;
+    ev.set_entry_point("<test>");
+    evalProgram(ev, "kazi f:\n  rudisha 1\n");
+    Value fn = evalExpr(ev, "f\n");
+    EXPECT_THROW(structured_clone_encode(fn), std::exception);
+
+    std::vector<uint8_t> truncated = structured_clone_encode(std::string("hello"));
+    truncated.pop_back();
+    EXPECT_THROW(structured_clone_decode(truncated.data(), truncated.size(), nullptr), std::exception);
+}
+
+TEST(StructuredCloneTest, SetRelinksToReceivingInterpreter) {
+    Evaluator ev;
+    ev.set_entry_point("<test>");
+    evalProgram(ev, "data s = swazi.structuredClone(unda Set([1, 2, 3]))\n");
+
+    Value has = evalExpr(ev, "s.has(2)\n");
+    ASSERT_TRUE(std::holds_alternative<bool>(has));
+    EXPECT_TRUE(std::get<bool>(has));
+
+    Value missing = evalExpr(ev, "s.has(4)\n");
+    ASSERT_TRUE(std::holds_alternative<bool>(missing));
+    EXPECT_FALSE(std::get<bool>(missing));
+}
+
+TEST(StructuredCloneTest, FramesSurviveArbitraryReadSplits) {
+    auto payload = std::make_shared<BufferValue>();
+    for (int i = 0; i < 5000; ++i) payload->data.push_back(static_cast<uint8_t>(i * 7));
+    payload->encoding = "binary";
+
+    std::vector<uint8_t> wire;
+    structured_clone_frame_append(wire, std::string("first"));
+    structured_clone_frame_append(wire, payload);
+    structured_clone_frame_append(wire, 3.5);
+
+    // A failed encode leaves what is already queued untouched.
+    Evaluator ev;
+    ev.set_entry_point("<test>");
+    evalProgram(ev, "kazi f:\n  rudisha 1\n");
+    size_t before = wire.size();
+    EXPECT_THROW(structured_clone_frame_append(wire, evalExpr(ev, "f\n")), std::exception);
+    EXPECT_EQ(wire.size(), before);
+
+    for (size_t step : {size_t(1), size_t(3), size_t(4096), wire.size()}) {
+        std::vector<uint8_t> pending;
+        std::vector<Value> got;
+        for (size_t pos = 0; pos < wire.size(); pos += step) {
+            size_t n = std::min(step, wire.size() - pos);
+            for (auto& v : structured_clone_unframe(pending, wire.data() + pos, n, nullptr)) got.push_back(v);
+        }
+        EXPECT_TRUE(pending.empty());
+        ASSERT_EQ(got.size(), 3u);
+        EXPECT_EQ(std::get<std::string>(got[0]), "first");
+        ASSERT_TRUE(std::holds_alternative<BufferPtr>(got[1]));
+        EXPECT_EQ(std::get<BufferPtr>(got[1])->data, payload->data);
+        EXPECT_EQ(std::get<double>(got[2]), 3.5);
+    }
+}
+
+TEST(StructuredCloneTest, UndecodableFrameIsSkipped) {
+    std::vector<uint8_t> wire;
+    structured_clone_frame_append(wire, std::string("before"));
+    // A well-formed length around a payload that is not a clone.
+    const uint8_t junk[] = {5, 0, 0, 0, 0xff, 0xff, 0xff, 0xff, 0xff};
+    wire.insert(wire.end(), std::begin(junk), std::end(junk));
+    structured_clone_frame_append(wire, std::string("after"));
+
+    for (size_t step : {size_t(1), size_t(7), wire.size()}) {
+        std::vector<uint8_t> pending;
+        std::vector<Value> got;
+        std::vector<std::string> errors;
+        for (size_t pos = 0; pos < wire.size(); pos += step) {
+            size_t n = std::min(step, wire.size() - pos);
+            for (auto& v : structured_clone_unframe(pending, wire.data() + pos, n, nullptr, &errors)) got.push_back(v);
+        }
+        EXPECT_TRUE(pending.empty());
+        EXPECT_EQ(errors.size(), 1u);
+        ASSERT_EQ(got.size(), 2u);
+        EXPECT_EQ(std::get<std::string>(got[0]), "before");
+        EXPECT_EQ(std::get<std::string>(got[1]), "after");
+    }
+
+    // An impossible length cannot be waited out: the read is dropped, not kept.
+    std::vector<uint8_t> pending;
+    std::vector<std::string> errors;
+    const uint8_t huge[] = {0xff, 0xff, 0xff, 0xff, 1, 2, 3};
+    EXPECT_TRUE(structured_clone_unframe(pending, huge, sizeof(huge), nullptr, &errors).empty());
+    EXPECT_TRUE(pending.empty());
+    EXPECT_EQ(errors.size(), 1u);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ZlibStream.hpp"
+
+static std::vector<uint8_t> bytes_of(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// Decodes `data` fed to a fresh decoder `step` bytes at a time.
+static std::string decode(const std::vector<uint8_t>& data, size_t step) {
+    auto dec = ZlibStream::decoder();
+    std::vector<uint8_t> out;
+    for (size_t off = 0; off < data.size(); off += step) {
+        size_t n = std::min(step, data.size() - off);
+        EXPECT_TRUE(dec->write(data.data() + off, n, out)) << dec->error();
+    }
+    EXPECT_TRUE(dec->done());
+    return std::string(out.begin(), out.end());
+}
+
+static std::string json_rows(int n) {
+    std::string s = "[";
+    for (int i = 0; i < n; i++) {
+        s += "{\"id\":" + std::to_string(i) + ",\"name\":\"row " + std::to_string(i) + "\",\"active\":true},";
+    }
+    s.back() = ']';
+    return s;
+}
+
+TEST(ZlibStreamTest, RoundTripsGzipAndDeflateInPieces) {
+    if (!ZlibStream::available()) GTEST_SKIP() << "built without zlib";
+    std::string body = json_rows(2000);
+
+    for (auto format : {ZlibStream::Format::Gzip, ZlibStream::Format::Deflate}) {
+        auto enc = ZlibStream::encoder(format, 6);
+        std::vector<uint8_t> packed;
+        for (size_t off = 0; off < body.size(); off += 1000) {
+            ASSERT_TRUE(enc->write(body.data() + off, std::min<size_t>(1000, body.size() - off), packed));
+        }
+        ASSERT_TRUE(enc->finish(packed));
+        EXPECT_TRUE(enc->done());
+        EXPECT_LT(packed.size() * 5, body.size());
+        EXPECT_EQ(enc->total_in(), body.size());
+
+        EXPECT_EQ(decode(packed, packed.size()), body);
+        EXPECT_EQ(decode(packed, 7), body);
+    }
+}
+
+TEST(ZlibStreamTest, SyncFlushMakesEverythingWrittenDecodable) {
+    if (!ZlibStream::available()) GTEST_SKIP() << "built without zlib";
+    auto enc = ZlibStream::encoder(ZlibStream::Format::Gzip);
+    auto dec = ZlibStream::decoder();
+
+    std::vector<uint8_t> packed, plain;
+    ASSERT_TRUE(enc->write("data: one\n\n", 11, packed, ZlibStream::Flush::Sync));
+    ASSERT_TRUE(dec->write(packed.data(), packed.size(), plain));
+    EXPECT_EQ(std::string(plain.begin(), plain.end()), "data: one\n\n");
+    EXPECT_FALSE(dec->done());
+}
+
+TEST(ZlibStreamTest, AcceptsHeaderlessDeflateAndRejectsGarbage) {
+    if (!ZlibStream::available()) GTEST_SKIP() << "built without zlib";
+    std::string body = json_rows(50);
+    auto enc = ZlibStream::encoder(ZlibStream::Format::Deflate);
+    std::vector<uint8_t> zlib_wrapped;
+    ASSERT_TRUE(enc->write(body.data(), body.size(), zlib_wrapped, ZlibStream::Flush::Finish));
+
+    // Strip the 2-byte zlib header and the 4-byte Adler-32 trailer.
+    std::vector<uint8_t> raw(zlib_wrapped.begin() + 2, zlib_wrapped.end() - 4);
+    EXPECT_EQ(decode(raw, raw.size()), body);
+    EXPECT_EQ(decode(raw, 1), body);
+
+    auto dec = ZlibStream::decoder();
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> junk = bytes_of("this is not compressed at all, not even close");
+    EXPECT_FALSE(dec->write(junk.data(), junk.size(), out));
+    EXPECT_FALSE(dec->error().empty());
+}
+
+TEST(ZlibStreamTest, NegotiatesCodingFromAcceptEncoding) {
+    using F = ZlibStream::Format;
+    EXPECT_EQ(http_negotiate_coding("gzip, deflate, br"), F::Gzip);
+    EXPECT_EQ(http_negotiate_coding("deflate"), F::Deflate);
+    EXPECT_EQ(http_negotiate_coding("gzip;q=0.5, deflate"), F::Deflate);
+    EXPECT_EQ(http_negotiate_coding("gzip;q=0, *"), F::Deflate);
+    EXPECT_EQ(http_negotiate_coding("*;q=0.1"), F::Gzip);
+    EXPECT_EQ(http_negotiate_coding("br, identity"), F::None);
+    EXPECT_EQ(http_negotiate_coding("*;q=0"), F::None);
+    EXPECT_EQ(http_negotiate_coding(""), F::None);
+
+    EXPECT_EQ(http_content_coding(" X-GZIP "), F::Gzip);
+    EXPECT_EQ(http_content_coding("deflate"), F::Deflate);
+    EXPECT_EQ(http_content_coding("br"), F::None);
+}